@@ -0,0 +1,640 @@
+/*
+ * rp-cache-filter.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_cache_filter_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_cache_filter_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rproxy.h"
+#include "rp-cluster-manager.h"
+#include "rp-filter-factory.h"
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "rp-http-utility.h"
+#include "rp-router.h"
+#include "cache/rp-cache-headers-utils.h"
+#include "cache/rp-cache-refresh.h"
+#include "cache/rp-http-cache.h"
+#include "cache/rp-cache-filter.h"
+
+#define RP_CACHE_FILTER_CB(s) (RpCacheFilterCb*)(s)
+
+#define DECODER_CALLBACKS(s) \
+    rp_pass_through_filter_decoder_callbacks_(RP_PASS_THROUGH_FILTER(s))
+#define ENCODER_CALLBACKS(s) \
+    rp_pass_through_filter_encoder_callbacks_(RP_PASS_THROUGH_FILTER(s))
+#define STREAM_FILTER_CALLBACKS(s) \
+    RP_STREAM_FILTER_CALLBACKS(DECODER_CALLBACKS(s))
+#define STREAM_INFO(s) \
+    rp_stream_filter_callbacks_stream_info(STREAM_FILTER_CALLBACKS(s))
+#define PARENT_STREAM_DECODER_FILTER_IFACE(s) \
+    ((RpStreamDecoderFilterInterface*)g_type_interface_peek_parent(RP_STREAM_DECODER_FILTER_GET_IFACE(s)))
+#define PARENT_STREAM_ENCODER_FILTER_IFACE(s) \
+    ((RpStreamEncoderFilterInterface*)g_type_interface_peek_parent(RP_STREAM_ENCODER_FILTER_GET_IFACE(s)))
+
+#define RESPONSE_FROM_CACHE_FILTER "cache.response_from_cache_filter"
+
+typedef struct _RpCacheFilterCb RpCacheFilterCb;
+struct _RpCacheFilterCb {
+    RpFilterFactoryCb parent_instance;
+    RpCacheCfg m_config;
+    RpHttpCache* m_cache;
+    RpClusterManager* m_cluster_manager;
+    // The larger of the memory and disk tier limits.
+    guint64 m_max_entry_size;
+};
+
+typedef enum {
+    // The response may be stored once it arrives.
+    RpCacheFilterState_Initial,
+    RpCacheFilterState_NotServingFromCache,
+    RpCacheFilterState_ServingFromCache,
+    // The origin failed and the stale response replaces its body.
+    RpCacheFilterState_ServingStaleOnError
+} RpCacheFilterState_e;
+
+typedef enum {
+    RpCacheEntryUsability_Usable,
+    // Stale, but may be served while a background request refreshes it.
+    RpCacheEntryUsability_StaleWhileRevalidate,
+    RpCacheEntryUsability_Unusable
+} RpCacheEntryUsability_e;
+
+struct _RpCacheFilter {
+    RpPassThroughFilter parent_instance;
+
+    RpCacheCfg* m_config;
+    RpHttpCache* m_cache;
+    RpClusterManager* m_cluster_manager;
+    guint64 m_max_entry_size;
+
+    char* m_key;
+    evhtp_headers_t* m_request_headers;
+    RpHttpCacheEntry* m_insert_entry;
+    // Held while going to the origin in case it fails within stale-if-error.
+    RpHttpCacheEntry* m_stale_entry;
+    gint64 m_request_time;
+
+    RpCacheFilterState_e m_state;
+    bool m_invalidate : 1;
+};
+
+static void stream_decoder_filter_iface_init(RpStreamDecoderFilterInterface* iface);
+static void stream_encoder_filter_iface_init(RpStreamEncoderFilterInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpCacheFilter, rp_cache_filter, RP_TYPE_PASS_THROUGH_FILTER,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_DECODER_FILTER, stream_decoder_filter_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_ENCODER_FILTER, stream_encoder_filter_iface_init)
+)
+
+static inline gint64
+now_seconds(void)
+{
+    return g_get_real_time() / G_USEC_PER_SEC;
+}
+
+static inline char*
+cache_key(evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p)", request_headers);
+    const char* authority = rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy);
+    const char* path = rp_header_map_get_inline(request_headers, RpInlineHeader_Path);
+    return g_strdup_printf("%s\n%s", authority ? authority : "", path);
+}
+
+// A successful unsafe request invalidates what is stored for its URI
+// (RFC 9111 section 4.4).
+static inline bool
+is_unsafe_method(const char* method)
+{
+    return g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Post) == 0 ||
+            g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Put) == 0 ||
+            g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Delete) == 0 ||
+            g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Patch) == 0;
+}
+
+static inline gint64
+stale_while_revalidate(RpCacheFilter* self, RpHttpCacheEntry* entry)
+{
+    gint64 window = rp_http_cache_entry_stale_while_revalidate(entry);
+    return window >= 0 ? window : (gint64)MIN(self->m_config->stale_while_revalidate_s, G_MAXINT64);
+}
+
+static inline gint64
+stale_if_error(RpCacheFilter* self, RpHttpCacheEntry* entry)
+{
+    gint64 window = rp_http_cache_entry_stale_if_error(entry);
+    return window >= 0 ? window : (gint64)MIN(self->m_config->stale_if_error_s, G_MAXINT64);
+}
+
+// RFC 9111 sections 4.2 and 5.2.1, and RFC 5861 section 3.
+static RpCacheEntryUsability_e
+entry_usability(RpCacheFilter* self, RpHttpCacheEntry* entry, const RpRequestCacheControl* request_cache_control, gint64 now)
+{
+    NOISY_MSG_("(%p, %p, %p, %" G_GINT64_FORMAT ")", self, entry, request_cache_control, now);
+
+    gint64 age = rp_http_cache_entry_age(entry, now);
+    gint64 freshness_lifetime = rp_http_cache_entry_freshness_lifetime(entry);
+    NOISY_MSG_("age %" G_GINT64_FORMAT ", freshness lifetime %" G_GINT64_FORMAT, age, freshness_lifetime);
+
+    if (request_cache_control->max_age >= 0 && age > request_cache_control->max_age)
+    {
+        NOISY_MSG_("older than max-age");
+        return RpCacheEntryUsability_Unusable;
+    }
+    if (request_cache_control->min_fresh >= 0 && freshness_lifetime - age < request_cache_control->min_fresh)
+    {
+        NOISY_MSG_("not fresh for min-fresh");
+        return RpCacheEntryUsability_Unusable;
+    }
+    if (age < freshness_lifetime)
+    {
+        return RpCacheEntryUsability_Usable;
+    }
+    if (rp_http_cache_entry_no_stale(entry))
+    {
+        NOISY_MSG_("must revalidate");
+        return RpCacheEntryUsability_Unusable;
+    }
+    gint64 staleness = age - freshness_lifetime;
+    if (staleness < stale_while_revalidate(self, entry))
+    {
+        NOISY_MSG_("stale while revalidate");
+        return RpCacheEntryUsability_StaleWhileRevalidate;
+    }
+    return request_cache_control->max_stale >= 0 && staleness <= request_cache_control->max_stale ?
+            RpCacheEntryUsability_Usable : RpCacheEntryUsability_Unusable;
+}
+
+static inline bool
+is_within_stale_if_error(RpCacheFilter* self, RpHttpCacheEntry* entry, gint64 now)
+{
+    NOISY_MSG_("(%p, %p, %" G_GINT64_FORMAT ")", self, entry, now);
+    gint64 staleness = rp_http_cache_entry_age(entry, now) - rp_http_cache_entry_freshness_lifetime(entry);
+    return !rp_http_cache_entry_no_stale(entry) && staleness <= stale_if_error(self, entry);
+}
+
+// The errors stale-if-error applies to (RFC 5861 section 4).
+static inline bool
+is_origin_error(evhtp_res status)
+{
+    return status == 500 || status == 502 || status == 503 || status == 504;
+}
+
+// RFC 9110 section 13.2.2; If-Modified-Since is ignored when If-None-Match is
+// present.
+static bool
+is_not_modified(RpHttpCacheEntry* entry, evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p, %p)", entry, request_headers);
+
+    const char* if_none_match = rp_header_map_find(request_headers, RpCustomHeaderValues.IfNoneMatch);
+    if (if_none_match)
+    {
+        return rp_cache_headers_utils_etag_matches(if_none_match, rp_http_cache_entry_etag(entry));
+    }
+    const char* if_modified_since = rp_header_map_find(request_headers, RpCustomHeaderValues.IfModifiedSince);
+    if (if_modified_since)
+    {
+        gint64 since = rp_cache_headers_utils_http_time(if_modified_since);
+        gint64 last_modified = rp_http_cache_entry_last_modified(entry);
+        return since >= 0 && last_modified >= 0 && last_modified <= since;
+    }
+    return false;
+}
+
+static void
+serve_from_cache(RpCacheFilter* self, RpHttpCacheEntry* entry, evhtp_headers_t* request_headers, gint64 now)
+{
+    NOISY_MSG_("(%p, %p, %p, %" G_GINT64_FORMAT ")", self, entry, request_headers, now);
+
+    self->m_state = RpCacheFilterState_ServingFromCache;
+
+    RpStreamDecoderFilterCallbacks* callbacks = DECODER_CALLBACKS(self);
+    if (is_not_modified(entry, request_headers))
+    {
+        NOISY_MSG_("not modified");
+        rp_stream_info_set_response_code(STREAM_INFO(self), EVHTP_RES_NOTMOD);
+        rp_stream_decoder_filter_callbacks_encode_headers(callbacks,
+                                                            rp_http_cache_entry_not_modified_headers(entry, now),
+                                                            true,
+                                                            RESPONSE_FROM_CACHE_FILTER);
+        return;
+    }
+
+    evhtp_headers_t* response_headers = rp_http_cache_entry_response_headers(entry, now);
+    const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+    evbuf_t* body = g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Head) != 0 ?
+                        rp_http_cache_entry_body(entry) : NULL;
+    bool end_stream = !body || !evbuffer_get_length(body);
+    rp_stream_info_set_response_code(STREAM_INFO(self), http_utility_get_response_status(response_headers));
+    rp_stream_decoder_filter_callbacks_encode_headers(callbacks, response_headers, end_stream, RESPONSE_FROM_CACHE_FILTER);
+    if (!end_stream)
+    {
+        rp_stream_decoder_filter_callbacks_encode_data(callbacks, body, true);
+    }
+    g_clear_pointer(&body, evbuffer_free);
+}
+
+static void
+start_refresh(RpCacheFilter* self, evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p, %p)", self, request_headers);
+
+    RpStreamFilterCallbacks* callbacks = STREAM_FILTER_CALLBACKS(self);
+    RpRouteConstSharedPtr route = rp_stream_filter_callbacks_route(callbacks);
+    RpRouteEntry* route_entry;
+    if (!route || !(route_entry = rp_route_route_entry(route)))
+    {
+        NOISY_MSG_("no route");
+        return;
+    }
+    RpThreadLocalCluster* cluster = rp_cluster_manager_get_thread_local_cluster(self->m_cluster_manager,
+                                                                                rp_route_entry_cluster_name(route_entry));
+    if (!cluster)
+    {
+        NOISY_MSG_("no cluster for \"%s\"", rp_route_entry_cluster_name(route_entry));
+        return;
+    }
+    rp_cache_refresh_start(self->m_cache,
+                            self->m_key,
+                            request_headers,
+                            route_entry,
+                            STREAM_INFO(self),
+                            cluster,
+                            rp_stream_filter_callbacks_dispatcher(callbacks),
+                            self->m_max_entry_size);
+}
+
+static void
+abandon_insert(RpCacheFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    g_clear_pointer(&self->m_insert_entry, rp_http_cache_entry_unref);
+    self->m_state = RpCacheFilterState_NotServingFromCache;
+}
+
+static void
+finish_insert(RpCacheFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    rp_http_cache_insert(self->m_cache, self->m_key, self->m_request_headers, self->m_insert_entry);
+    abandon_insert(self);
+}
+
+static RpFilterHeadersStatus_e
+decode_headers_i(RpStreamDecoderFilter* self, evhtp_headers_t* request_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, request_headers, end_stream);
+
+    RpCacheFilter* me = RP_CACHE_FILTER(self);
+    me->m_request_headers = request_headers;
+
+    if (!rp_cache_headers_utils_can_serve_request_from_cache(request_headers))
+    {
+        const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+        if (method && is_unsafe_method(method) && rp_header_map_get_inline(request_headers, RpInlineHeader_Path))
+        {
+            me->m_key = cache_key(request_headers);
+            me->m_invalidate = true;
+        }
+        me->m_state = RpCacheFilterState_NotServingFromCache;
+        return RpFilterHeadersStatus_Continue;
+    }
+
+    RpRequestCacheControl request_cache_control = rp_request_cache_control_parse(request_headers);
+    me->m_key = cache_key(request_headers);
+    gint64 now = now_seconds();
+
+    if (!request_cache_control.must_validate)
+    {
+        g_autoptr(RpHttpCacheEntry) entry = rp_http_cache_lookup(me->m_cache, me->m_key, request_headers);
+        switch (entry ? entry_usability(me, entry, &request_cache_control, now) : RpCacheEntryUsability_Unusable)
+        {
+            case RpCacheEntryUsability_StaleWhileRevalidate:
+                start_refresh(me, request_headers);
+                /* fall through */
+            case RpCacheEntryUsability_Usable:
+                NOISY_MSG_("hit");
+                serve_from_cache(me, entry, request_headers, now);
+                return RpFilterHeadersStatus_StopIteration;
+            case RpCacheEntryUsability_Unusable:
+                if (entry && is_within_stale_if_error(me, entry, now))
+                {
+                    me->m_stale_entry = g_steal_pointer(&entry);
+                }
+                break;
+        }
+    }
+
+    if (request_cache_control.only_if_cached)
+    {
+        NOISY_MSG_("only-if-cached miss");
+        me->m_state = RpCacheFilterState_NotServingFromCache;
+        rp_stream_decoder_filter_callbacks_send_local_reply(DECODER_CALLBACKS(self),
+                                                            EVHTP_RES_GWTIMEOUT,
+                                                            NULL,
+                                                            NULL,
+                                                            "cache.only_if_cached",
+                                                            NULL);
+        return RpFilterHeadersStatus_StopIteration;
+    }
+
+    // Only complete responses to GET are stored; HEAD has no body to capture.
+    const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+    if (request_cache_control.no_store ||
+        g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Get) != 0)
+    {
+        me->m_state = RpCacheFilterState_NotServingFromCache;
+        return RpFilterHeadersStatus_Continue;
+    }
+
+    me->m_request_time = now;
+    return RpFilterHeadersStatus_Continue;
+}
+
+static RpFilterDataStatus_e
+decode_data_i(RpStreamDecoderFilter* self, evbuf_t* data, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, data, end_stream);
+    return PARENT_STREAM_DECODER_FILTER_IFACE(self)->decode_data(self, data, end_stream);
+}
+
+static RpFilterTrailerStatus_e
+decode_trailers_i(RpStreamDecoderFilter* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    return PARENT_STREAM_DECODER_FILTER_IFACE(self)->decode_trailers(self, trailers);
+}
+
+static void
+decode_complete_i(RpStreamDecoderFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    PARENT_STREAM_DECODER_FILTER_IFACE(self)->decode_complete(self);
+}
+
+static void
+set_decoder_filter_callbacks_i(RpStreamDecoderFilter* self, RpStreamDecoderFilterCallbacks* callbacks)
+{
+    NOISY_MSG_("(%p, %p)", self, callbacks);
+    PARENT_STREAM_DECODER_FILTER_IFACE(self)->set_decoder_filter_callbacks(self, callbacks);
+}
+
+static void
+stream_decoder_filter_iface_init(RpStreamDecoderFilterInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->decode_headers = decode_headers_i;
+    iface->decode_data = decode_data_i;
+    iface->decode_trailers = decode_trailers_i;
+    iface->decode_complete = decode_complete_i;
+    iface->set_decoder_filter_callbacks = set_decoder_filter_callbacks_i;
+}
+
+static RpFilterHeadersStatus_e
+encode_headers_i(RpStreamEncoderFilter* self, evhtp_headers_t* response_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, response_headers, end_stream);
+
+    RpCacheFilter* me = RP_CACHE_FILTER(self);
+    if (me->m_invalidate)
+    {
+        evhtp_res status = http_utility_get_response_status(response_headers);
+        if (status >= 200 && status < 400)
+        {
+            NOISY_MSG_("invalidating \"%s\"", me->m_key);
+            rp_http_cache_invalidate(me->m_cache, me->m_key);
+        }
+        return RpFilterHeadersStatus_Continue;
+    }
+    if (me->m_stale_entry)
+    {
+        // A header-only error leaves no data frame to carry the stale body,
+        // so it is passed through.
+        if (!end_stream && is_origin_error(http_utility_get_response_status(response_headers)))
+        {
+            NOISY_MSG_("serving stale on error");
+            me->m_state = RpCacheFilterState_ServingStaleOnError;
+            rp_http_cache_entry_replace_response_headers(me->m_stale_entry, response_headers, now_seconds());
+            rp_stream_info_set_response_code(STREAM_INFO(self), http_utility_get_response_status(response_headers));
+            return RpFilterHeadersStatus_Continue;
+        }
+        g_clear_pointer(&me->m_stale_entry, rp_http_cache_entry_unref);
+    }
+    if (me->m_state != RpCacheFilterState_Initial)
+    {
+        return RpFilterHeadersStatus_Continue;
+    }
+
+    me->m_insert_entry = rp_http_cache_entry_new_for_response(response_headers,
+                                                                me->m_request_time,
+                                                                now_seconds(),
+                                                                me->m_max_entry_size);
+    if (!me->m_insert_entry)
+    {
+        me->m_state = RpCacheFilterState_NotServingFromCache;
+        return RpFilterHeadersStatus_Continue;
+    }
+    if (end_stream)
+    {
+        finish_insert(me);
+    }
+    return RpFilterHeadersStatus_Continue;
+}
+
+static RpFilterDataStatus_e
+encode_data_i(RpStreamEncoderFilter* self, evbuf_t* data, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, data, end_stream);
+
+    RpCacheFilter* me = RP_CACHE_FILTER(self);
+    if (me->m_state == RpCacheFilterState_ServingStaleOnError)
+    {
+        evbuffer_drain(data, evbuffer_get_length(data));
+        if (end_stream)
+        {
+            evbuf_t* body = rp_http_cache_entry_body(me->m_stale_entry);
+            evbuffer_add_buffer(data, body);
+            evbuffer_free(body);
+        }
+        return RpFilterDataStatus_Continue;
+    }
+    if (me->m_insert_entry)
+    {
+        size_t len = data ? evbuffer_get_length(data) : 0;
+        if (rp_http_cache_entry_body_length(me->m_insert_entry) + len > me->m_max_entry_size)
+        {
+            NOISY_MSG_("too large");
+            abandon_insert(me);
+        }
+        else
+        {
+            rp_http_cache_entry_append_body(me->m_insert_entry, data);
+            if (end_stream)
+            {
+                finish_insert(me);
+            }
+        }
+    }
+    return RpFilterDataStatus_Continue;
+}
+
+static RpFilterTrailerStatus_e
+encode_trailers_i(RpStreamEncoderFilter* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    RpCacheFilter* me = RP_CACHE_FILTER(self);
+    if (me->m_state == RpCacheFilterState_ServingStaleOnError)
+    {
+        // The error's trailers end the stream; they give way to the stale body.
+        evhtp_header_t* header;
+        while ((header = TAILQ_FIRST(trailers)))
+        {
+            rp_header_map_remove(trailers, header);
+        }
+        evbuf_t* body = rp_http_cache_entry_body(me->m_stale_entry);
+        rp_stream_encoder_filter_callbacks_add_decoded_data(ENCODER_CALLBACKS(self), body, false);
+        evbuffer_free(body);
+        return PARENT_STREAM_ENCODER_FILTER_IFACE(self)->encode_trailers(self, trailers);
+    }
+    // Trailers are not stored, so neither is a response that carries them.
+    abandon_insert(me);
+    return PARENT_STREAM_ENCODER_FILTER_IFACE(self)->encode_trailers(self, trailers);
+}
+
+static void
+encode_complete_i(RpStreamEncoderFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    PARENT_STREAM_ENCODER_FILTER_IFACE(self)->encode_complete(self);
+}
+
+static void
+set_encoder_filter_callbacks_i(RpStreamEncoderFilter* self, RpStreamEncoderFilterCallbacks* callbacks)
+{
+    NOISY_MSG_("(%p, %p)", self, callbacks);
+    PARENT_STREAM_ENCODER_FILTER_IFACE(self)->set_encoder_filter_callbacks(self, callbacks);
+}
+
+static void
+stream_encoder_filter_iface_init(RpStreamEncoderFilterInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->encode_headers = encode_headers_i;
+    iface->encode_data = encode_data_i;
+    iface->encode_trailers = encode_trailers_i;
+    iface->encode_complete = encode_complete_i;
+    iface->set_encoder_filter_callbacks = set_encoder_filter_callbacks_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpCacheFilter* self = RP_CACHE_FILTER(obj);
+    g_clear_pointer(&self->m_insert_entry, rp_http_cache_entry_unref);
+    g_clear_pointer(&self->m_stale_entry, rp_http_cache_entry_unref);
+    g_clear_pointer(&self->m_key, g_free);
+
+    G_OBJECT_CLASS(rp_cache_filter_parent_class)->dispose(obj);
+}
+
+static void
+rp_cache_filter_class_init(RpCacheFilterClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_cache_filter_init(RpCacheFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_state = RpCacheFilterState_Initial;
+}
+
+static inline RpCacheFilter*
+cache_filter_new(RpCacheFilterCb* cb)
+{
+    NOISY_MSG_("(%p)", cb);
+    RpCacheFilter* self = g_object_new(RP_TYPE_CACHE_FILTER, NULL);
+    self->m_config = &cb->m_config;
+    self->m_cache = cb->m_cache;
+    self->m_cluster_manager = cb->m_cluster_manager;
+    self->m_max_entry_size = cb->m_max_entry_size;
+    return self;
+}
+
+static void
+filter_factory_cb(RpFilterFactoryCb* self, RpFilterChainFactoryCallbacks* callbacks)
+{
+    NOISY_MSG_("(%p, %p)", self, callbacks);
+
+    RpCacheFilterCb* me = RP_CACHE_FILTER_CB(self);
+    RpCacheFilter* filter = cache_filter_new(me);
+    rp_filter_chain_factory_callbacks_add_stream_decoder_filter(callbacks, RP_STREAM_DECODER_FILTER(filter));
+    rp_filter_chain_factory_callbacks_add_stream_encoder_filter(callbacks, RP_STREAM_ENCODER_FILTER(filter));
+}
+
+static inline RpCommonFactoryContext*
+common_factory_context(RpFactoryContext* context)
+{
+    return RP_COMMON_FACTORY_CONTEXT(
+        rp_generic_factory_context_server_factory_context(RP_GENERIC_FACTORY_CONTEXT(context)));
+}
+
+static inline RpCacheFilterCb
+cache_filter_cb_ctor(RpCacheCfg* proto_config, RpHttpCache* cache, RpClusterManager* cluster_manager)
+{
+    NOISY_MSG_("(%p, %p, %p)", proto_config, cache, cluster_manager);
+    RpCacheFilterCb self = {
+        .parent_instance = rp_filter_factory_cb_ctor(filter_factory_cb, g_free),
+        .m_config = *proto_config,
+        .m_cache = cache,
+        .m_cluster_manager = cluster_manager,
+        .m_max_entry_size = proto_config->max_entry_size_bytes
+    };
+    return self;
+}
+
+static inline RpCacheFilterCb*
+cache_filter_cb_new(RpCacheCfg* proto_config, RpFactoryContext* context)
+{
+    NOISY_MSG_("(%p, %p)", proto_config, context);
+    RpCommonFactoryContext* common_context = common_factory_context(context);
+    RpHttpCache* cache = rp_http_cache_singleton_get(rp_common_factory_context_singleton_manager(common_context));
+    rp_http_cache_set_max_size(cache, proto_config->max_size_bytes);
+    rp_http_cache_set_max_entry_size(cache, proto_config->max_entry_size_bytes);
+    RpCacheFilterCb* self = g_new0(RpCacheFilterCb, 1);
+    *self = cache_filter_cb_ctor(proto_config, cache, rp_common_factory_context_cluster_manager(common_context));
+    if (proto_config->disk_path[0] &&
+        rp_http_cache_enable_disk_tier(cache,
+                                        proto_config->disk_path,
+                                        proto_config->disk_size_bytes,
+                                        proto_config->disk_max_entry_size_bytes))
+    {
+        self->m_max_entry_size = MAX(proto_config->max_entry_size_bytes, proto_config->disk_max_entry_size_bytes);
+    }
+    return self;
+}
+
+RpFilterFactoryCb*
+rp_cache_filter_create_filter_factory(RpCacheCfg* proto_config, RpFactoryContext* context)
+{
+    LOGD("(%p, %p)", proto_config, context);
+    g_return_val_if_fail(proto_config != NULL, NULL);
+    g_return_val_if_fail(RP_IS_FACTORY_CONTEXT(context), NULL);
+    return (RpFilterFactoryCb*)cache_filter_cb_new(proto_config, context);
+}
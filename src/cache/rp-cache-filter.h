@@ -0,0 +1,69 @@
+/*
+ * rp-cache-filter.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-factory-context.h"
+#include "rp-pass-through-filter.h"
+#include "rp-server-filter-config.h"
+
+G_BEGIN_DECLS
+
+typedef struct _RpCacheCfg RpCacheCfg;
+struct _RpCacheCfg {
+    RpFilterConfigBase config;
+    // Bound on the memory held by the process-wide store.
+    guint64 max_size_bytes;
+    // Responses with larger bodies are not kept in memory; they go to the
+    // disk tier, if configured, or are passed through without being stored.
+    guint64 max_entry_size_bytes;
+    // Windows, in seconds, for serving stale responses whose origin did not
+    // give stale-while-revalidate or stale-if-error itself (RFC 5861).
+    guint64 stale_while_revalidate_s;
+    guint64 stale_if_error_s;
+    // File backing the disk tier; empty to keep the cache in memory only.
+    char disk_path[512];
+    guint64 disk_size_bytes;
+    guint64 disk_max_entry_size_bytes;
+};
+
+static inline RpCacheCfg
+rp_cache_cfg_ctor(RpFactoryContext* context)
+{
+    RpCacheCfg self = {
+        .config = rp_filter_config_base_ctor("cache-filter", context),
+        .max_size_bytes = 64 * 1024 * 1024,
+        .max_entry_size_bytes = 1024 * 1024,
+        .stale_while_revalidate_s = 0,
+        .stale_if_error_s = 0,
+        .disk_path = "",
+        .disk_size_bytes = 1024 * 1024 * 1024,
+        .disk_max_entry_size_bytes = 64 * 1024 * 1024
+    };
+    return self;
+}
+
+/**
+ * A filter that serves GET and HEAD requests from an in-memory response cache
+ * shared by all workers, and stores cacheable responses as they stream back.
+ * It honours Cache-Control, Pragma, Expires, Age and Vary, and answers
+ * If-None-Match and If-Modified-Since locally with 304 when the cached
+ * response matches. Stale responses are served within their
+ * stale-while-revalidate window while a single background request refreshes
+ * them, and within stale-if-error when the origin answers with a server
+ * error. Must be installed ahead of the router filter.
+ * https://github.com/envoyproxy/envoy/blob/main/source/extensions/filters/http/cache/cache_filter.h
+ */
+#define RP_TYPE_CACHE_FILTER (rp_cache_filter_get_type())
+G_DECLARE_FINAL_TYPE(RpCacheFilter, rp_cache_filter, RP, CACHE_FILTER, RpPassThroughFilter)
+
+RpFilterFactoryCb* rp_cache_filter_create_filter_factory(RpCacheCfg* config,
+                                                            RpFactoryContext* context);
+
+G_END_DECLS
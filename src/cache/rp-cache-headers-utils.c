@@ -0,0 +1,385 @@
+/*
+ * rp-cache-headers-utils.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_cache_headers_utils_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_cache_headers_utils_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <time.h>
+#include "utils/header_value_parser.h"
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "rp-http-utility.h"
+#include "cache/rp-cache-headers-utils.h"
+
+typedef void (*directive_cb)(const char* name, const char* value, gpointer arg);
+
+static void
+for_each_directive(const char* value, directive_cb cb, gpointer arg)
+{
+    NOISY_MSG_("(%p(%s), %p, %p)", value, value, cb, arg);
+    struct header_value_parser_s parser = header_value_parser_ctor();
+    struct tokenizer_cursor_s cursor = tokenizer_cursor_ctor(0, strlen(value));
+    while (!tokenizer_cursor_at_end(&cursor))
+    {
+        struct header_element_s element = header_value_parser_parse_header_element(&parser, value, &cursor);
+        const char* name = header_element_get_name(&element);
+        if (name && name[0])
+        {
+            cb(name, header_element_get_value(&element), arg);
+        }
+        header_element_dtor(&element);
+    }
+}
+
+static inline bool
+directive_is(const char* name, const char* directive)
+{
+    return g_ascii_strcasecmp(name, directive) == 0;
+}
+
+// Delta-seconds; -1 if missing or malformed, saturating on overflow.
+static gint64
+parse_delta_seconds(const char* value)
+{
+    NOISY_MSG_("(%p(%s))", value, value);
+    if (!value || !g_ascii_isdigit(value[0]))
+    {
+        return -1;
+    }
+    char* end;
+    guint64 seconds = g_ascii_strtoull(value, &end, 10);
+    if (*end)
+    {
+        return -1;
+    }
+    return seconds > G_MAXINT64 ? G_MAXINT64 : (gint64)seconds;
+}
+
+static void
+request_directive_cb(const char* name, const char* value, gpointer arg)
+{
+    NOISY_MSG_("(%p(%s), %p(%s), %p)", name, name, value, value, arg);
+    RpRequestCacheControl* self = arg;
+    if (directive_is(name, RpCustomHeaderValues.CacheControlValues.NoCache))
+    {
+        self->must_validate = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.NoStore))
+    {
+        self->no_store = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.OnlyIfCached))
+    {
+        self->only_if_cached = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.MaxAge))
+    {
+        self->max_age = parse_delta_seconds(value);
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.MinFresh))
+    {
+        self->min_fresh = parse_delta_seconds(value);
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.MaxStale))
+    {
+        self->max_stale = value ? parse_delta_seconds(value) : G_MAXINT64;
+    }
+}
+
+RpRequestCacheControl
+rp_request_cache_control_parse(evhtp_headers_t* request_headers)
+{
+    LOGD("(%p)", request_headers);
+
+    RpRequestCacheControl self = {
+        .max_age = -1,
+        .min_fresh = -1,
+        .max_stale = -1
+    };
+    const char* cache_control = rp_header_map_find(request_headers, RpCustomHeaderValues.CacheControl);
+    if (cache_control)
+    {
+        for_each_directive(cache_control, request_directive_cb, &self);
+    }
+    else
+    {
+        // Pragma is only honoured for HTTP/1.0 clients that send no
+        // Cache-Control.
+        const char* pragma = rp_header_map_find(request_headers, RpCustomHeaderValues.Pragma);
+        self.must_validate = pragma && g_ascii_strcasecmp(pragma, RpCustomHeaderValues.PragmaValues.NoCache) == 0;
+    }
+    return self;
+}
+
+struct response_directives_s {
+    RpResponseCacheControl* cache_control;
+    gint64 s_maxage;
+};
+
+static void
+response_directive_cb(const char* name, const char* value, gpointer arg)
+{
+    NOISY_MSG_("(%p(%s), %p(%s), %p)", name, name, value, value, arg);
+    struct response_directives_s* directives = arg;
+    RpResponseCacheControl* self = directives->cache_control;
+    if (directive_is(name, RpCustomHeaderValues.CacheControlValues.NoCache))
+    {
+        self->must_validate = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.NoStore) ||
+             directive_is(name, RpCustomHeaderValues.CacheControlValues.Private))
+    {
+        self->no_store = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.MustRevalidate) ||
+             directive_is(name, RpCustomHeaderValues.CacheControlValues.ProxyRevalidate))
+    {
+        self->no_stale = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.Public))
+    {
+        self->is_public = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.SMaxAge))
+    {
+        directives->s_maxage = parse_delta_seconds(value);
+        // s-maxage also implies proxy-revalidate.
+        self->no_stale = true;
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.MaxAge))
+    {
+        self->max_age = parse_delta_seconds(value);
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.StaleWhileRevalidate))
+    {
+        self->stale_while_revalidate = parse_delta_seconds(value);
+    }
+    else if (directive_is(name, RpCustomHeaderValues.CacheControlValues.StaleIfError))
+    {
+        self->stale_if_error = parse_delta_seconds(value);
+    }
+}
+
+RpResponseCacheControl
+rp_response_cache_control_parse(evhtp_headers_t* response_headers)
+{
+    LOGD("(%p)", response_headers);
+
+    RpResponseCacheControl self = {
+        .max_age = -1,
+        .stale_while_revalidate = -1,
+        .stale_if_error = -1
+    };
+    const char* cache_control = rp_header_map_find(response_headers, RpCustomHeaderValues.CacheControl);
+    if (cache_control)
+    {
+        struct response_directives_s directives = {
+            .cache_control = &self,
+            .s_maxage = -1
+        };
+        for_each_directive(cache_control, response_directive_cb, &directives);
+        if (directives.s_maxage >= 0)
+        {
+            self.max_age = directives.s_maxage;
+        }
+    }
+    return self;
+}
+
+gint64
+rp_cache_headers_utils_http_time(const char* value)
+{
+    static const char* formats[] = {
+        "%a, %d %b %Y %H:%M:%S GMT", // IMF-fixdate
+        "%A, %d-%b-%y %H:%M:%S GMT", // obsolete RFC 850 format
+        "%a %b %e %H:%M:%S %Y"       // ANSI C's asctime() format
+    };
+
+    NOISY_MSG_("(%p(%s))", value, value);
+    if (!value)
+    {
+        return -1;
+    }
+    for (guint i = 0; i < G_N_ELEMENTS(formats); ++i)
+    {
+        struct tm tm = {0};
+        const char* end = strptime(value, formats[i], &tm);
+        if (end && !*end)
+        {
+            return (gint64)timegm(&tm);
+        }
+    }
+    NOISY_MSG_("unparseable date");
+    return -1;
+}
+
+gint64
+rp_cache_headers_utils_freshness_lifetime(evhtp_headers_t* response_headers, const RpResponseCacheControl* cache_control, gint64 response_time)
+{
+    LOGD("(%p, %p, %" G_GINT64_FORMAT ")", response_headers, cache_control, response_time);
+
+    g_return_val_if_fail(cache_control != NULL, 0);
+
+    if (cache_control->max_age >= 0)
+    {
+        return cache_control->max_age;
+    }
+
+    const char* expires_value = rp_header_map_find(response_headers, RpCustomHeaderValues.Expires);
+    if (!expires_value)
+    {
+        return 0;
+    }
+    // An invalid Expires, e.g. "0", means already expired.
+    gint64 expires = rp_cache_headers_utils_http_time(expires_value);
+    gint64 date = rp_cache_headers_utils_http_time(rp_header_map_find(response_headers, RpHeaderValues.Date));
+    if (date < 0)
+    {
+        date = response_time;
+    }
+    return expires > date ? expires - date : 0;
+}
+
+bool
+rp_cache_headers_utils_can_serve_request_from_cache(evhtp_headers_t* request_headers)
+{
+    LOGD("(%p)", request_headers);
+
+    const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+    if (!method ||
+        (g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Get) != 0 &&
+         g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Head) != 0))
+    {
+        return false;
+    }
+    if (!rp_header_map_get_inline(request_headers, RpInlineHeader_Path))
+    {
+        return false;
+    }
+    // Responses to credentialed requests are private unless the origin says
+    // otherwise, and partial content is not cached.
+    return !rp_header_map_find(request_headers, RpCustomHeaderValues.Authorization) &&
+            !rp_header_map_find(request_headers, RpHeaderValues.Range);
+}
+
+static inline bool
+is_cacheable_status(evhtp_res status)
+{
+    // The status codes that are cacheable by default (RFC 9110 section 15.1);
+    // an explicit freshness lifetime is still required.
+    switch (status)
+    {
+        case 200: case 203: case 204:
+        case 300: case 301: case 308:
+        case 404: case 405: case 410: case 414:
+        case 501:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool
+rp_cache_headers_utils_is_cacheable_response(evhtp_headers_t* response_headers, const RpResponseCacheControl* cache_control)
+{
+    LOGD("(%p, %p)", response_headers, cache_control);
+
+    g_return_val_if_fail(cache_control != NULL, false);
+
+    if (!is_cacheable_status(http_utility_get_response_status(response_headers)))
+    {
+        NOISY_MSG_("status not cacheable");
+        return false;
+    }
+    // Validation with the origin is not supported, so a response that must
+    // be validated before every use is not worth storing.
+    if (cache_control->no_store || cache_control->must_validate)
+    {
+        NOISY_MSG_("cache-control forbids storing");
+        return false;
+    }
+    if (rp_header_map_find(response_headers, RpHeaderValues.SetCookie))
+    {
+        NOISY_MSG_("set-cookie");
+        return false;
+    }
+    const char* vary = rp_header_map_find(response_headers, RpCustomHeaderValues.Vary);
+    return !vary || !strchr(vary, '*');
+}
+
+static inline const char*
+strip_weak_prefix(const char* etag, gsize* len)
+{
+    if (*len >= 2 && etag[0] == 'W' && etag[1] == '/')
+    {
+        *len -= 2;
+        return etag + 2;
+    }
+    return etag;
+}
+
+bool
+rp_cache_headers_utils_etag_matches(const char* value, const char* etag)
+{
+    LOGD("(%p(%s), %p(%s))", value, value, etag, etag);
+
+    if (!value || !etag)
+    {
+        return false;
+    }
+
+    gsize etag_len = strlen(etag);
+    const char* opaque_etag = strip_weak_prefix(etag, &etag_len);
+
+    g_auto(GStrv) candidates = g_strsplit(value, ",", -1);
+    for (GStrv itr = candidates; *itr; ++itr)
+    {
+        const char* candidate = g_strstrip(*itr);
+        if (g_strcmp0(candidate, "*") == 0)
+        {
+            return true;
+        }
+        gsize candidate_len = strlen(candidate);
+        candidate = strip_weak_prefix(candidate, &candidate_len);
+        if (candidate_len == etag_len && memcmp(candidate, opaque_etag, etag_len) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Appends the value of each request header named by |vary| to the base key.
+char*
+rp_cache_headers_utils_variant_key(const char* base_key, const char* vary, evhtp_headers_t* request_headers)
+{
+    LOGD("(%p(%s), %p(%s), %p)", base_key, base_key, vary, vary, request_headers);
+
+    g_return_val_if_fail(base_key != NULL, NULL);
+
+    if (!vary)
+    {
+        return g_strdup(base_key);
+    }
+    GString* key = g_string_new(base_key);
+    g_auto(GStrv) names = g_strsplit(vary, ",", -1);
+    for (GStrv itr = names; *itr; ++itr)
+    {
+        const char* name = g_strstrip(*itr);
+        if (name[0])
+        {
+            const char* value = rp_header_map_find(request_headers, name);
+            g_string_append_printf(key, "\n%s=%s", name, value ? value : "");
+        }
+    }
+    return g_string_free_and_steal(key);
+}
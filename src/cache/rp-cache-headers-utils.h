@@ -0,0 +1,98 @@
+/*
+ * rp-cache-headers-utils.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <evhtp.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Cache-Control directives of a request that a shared cache acts on.
+ * Durations are in seconds and -1 when the directive is absent.
+ * https://github.com/envoyproxy/envoy/blob/main/source/extensions/filters/http/cache/cache_headers_utils.h
+ */
+typedef struct _RpRequestCacheControl RpRequestCacheControl;
+struct _RpRequestCacheControl {
+    // no-cache (or "Pragma: no-cache"); a cached response must not be used
+    // without validating it with the origin.
+    bool must_validate;
+    // no-store; the response must not be stored.
+    bool no_store;
+    // only-if-cached; answer with 504 rather than going to the origin.
+    bool only_if_cached;
+    gint64 max_age;
+    gint64 min_fresh;
+    // G_MAXINT64 if max-stale is present without a value.
+    gint64 max_stale;
+};
+
+/**
+ * Cache-Control directives of a response that a shared cache acts on.
+ */
+typedef struct _RpResponseCacheControl RpResponseCacheControl;
+struct _RpResponseCacheControl {
+    // no-cache; the response may only be reused after validation.
+    bool must_validate;
+    // no-store or private; a shared cache must not store the response.
+    bool no_store;
+    // must-revalidate or proxy-revalidate; never serve the response stale.
+    bool no_stale;
+    bool is_public;
+    // s-maxage if present, else max-age.
+    gint64 max_age;
+    // How long the response may be served stale while it is refreshed, or
+    // when the origin fails (RFC 5861).
+    gint64 stale_while_revalidate;
+    gint64 stale_if_error;
+};
+
+RpRequestCacheControl rp_request_cache_control_parse(evhtp_headers_t* request_headers);
+RpResponseCacheControl rp_response_cache_control_parse(evhtp_headers_t* response_headers);
+
+/**
+ * Parses an HTTP-date in any of the three formats of RFC 9110 section 5.6.7.
+ * @return seconds since the epoch, or -1 if the value cannot be parsed.
+ */
+gint64 rp_cache_headers_utils_http_time(const char* value);
+
+/**
+ * @return the freshness lifetime in seconds given by the response's s-maxage,
+ *         max-age or Expires, or 0 if it has none.
+ */
+gint64 rp_cache_headers_utils_freshness_lifetime(evhtp_headers_t* response_headers,
+                                                    const RpResponseCacheControl* cache_control,
+                                                    gint64 response_time);
+
+/**
+ * @return true if the request may be answered from, and its response stored
+ *         in, a shared cache.
+ */
+bool rp_cache_headers_utils_can_serve_request_from_cache(evhtp_headers_t* request_headers);
+
+/**
+ * @return true if a shared cache may store the response.
+ */
+bool rp_cache_headers_utils_is_cacheable_response(evhtp_headers_t* response_headers,
+                                                    const RpResponseCacheControl* cache_control);
+
+/**
+ * @return true if any entity tag in the If-None-Match list |value| matches
+ *         |etag| using the weak comparison function.
+ */
+bool rp_cache_headers_utils_etag_matches(const char* value, const char* etag);
+/**
+ * @return a new key for the variant of |base_key| that |request_headers|
+ *         select, given the stored response's |vary|, which may be NULL.
+ */
+char* rp_cache_headers_utils_variant_key(const char* base_key,
+                                            const char* vary,
+                                            evhtp_headers_t* request_headers);
+
+G_END_DECLS
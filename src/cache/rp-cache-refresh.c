@@ -0,0 +1,436 @@
+/*
+ * rp-cache-refresh.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_cache_refresh_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_cache_refresh_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rproxy.h"
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "rp-http-pool-data.h"
+#include "rp-http-utility.h"
+#include "rp-upstream.h"
+#include "cache/rp-cache-refresh.h"
+
+// Bound on how long a refresh may hold the single-flight claim for its key.
+#define REFRESH_TIMEOUT_MS 30000
+
+struct _RpCacheRefresh {
+    GObject parent_instance;
+
+    // Borrowed; the cache is a pinned singleton and the dispatcher belongs to
+    // the worker, both outlive the refresh.
+    RpHttpCache* m_cache;
+    RpDispatcher* m_dispatcher;
+
+    char* m_key;
+    evhtp_headers_t* m_request_headers;
+    RpHttpPoolData* m_pool_data;
+    RpCancellable* m_conn_pool_stream_handle;
+    // Borrowed; the stream belongs to the pooled connection's codec.
+    RpRequestEncoder* m_request_encoder;
+    RpTimer* m_timeout_timer;
+
+    evhtp_headers_t* m_response_headers;
+    RpHttpCacheEntry* m_entry;
+    guint64 m_max_entry_size;
+    gint64 m_request_time;
+
+    bool m_done : 1;
+};
+
+static void http_conn_pool_callbacks_iface_init(RpHttpConnPoolCallbacksInterface* iface);
+static void stream_callbacks_iface_init(RpStreamCallbacksInterface* iface);
+static void stream_decoder_iface_init(RpStreamDecoderInterface* iface);
+static void response_decoder_iface_init(RpResponseDecoderInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpCacheRefresh, rp_cache_refresh, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_CONN_POOL_CALLBACKS, http_conn_pool_callbacks_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_CALLBACKS, stream_callbacks_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_DECODER, stream_decoder_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_RESPONSE_DECODER, response_decoder_iface_init)
+)
+
+static inline gint64
+now_seconds(void)
+{
+    return g_get_real_time() / G_USEC_PER_SEC;
+}
+
+// The refresh must fetch a full response for the cache, not a 304 for
+// whatever the client that triggered it happens to hold.
+static inline bool
+is_uncopied_header(const char* key)
+{
+    return g_ascii_strcasecmp(key, RpHeaderValues.Connection) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.KeepAlive) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.ProxyConnection) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.TransferEncoding) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.TE) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.Upgrade) == 0 ||
+            g_ascii_strcasecmp(key, RpCustomHeaderValues.IfNoneMatch) == 0 ||
+            g_ascii_strcasecmp(key, RpCustomHeaderValues.IfModifiedSince) == 0;
+}
+
+static evhtp_headers_t*
+copy_request_headers(evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p)", request_headers);
+    evhtp_headers_t* headers = rp_header_map_new();
+    evhtp_header_t* header;
+    TAILQ_FOREACH(header, request_headers, next)
+    {
+        if (!is_uncopied_header(header->key))
+        {
+            rp_header_map_add_copy(headers, header->key, header->klen, header->val, header->vlen);
+        }
+    }
+    return headers;
+}
+
+static void
+finish(RpCacheRefresh* self, const char* reason, bool complete)
+{
+    NOISY_MSG_("(%p, %p(%s), %u)", self, reason, reason, complete);
+
+    if (self->m_done)
+    {
+        NOISY_MSG_("already done");
+        return;
+    }
+    self->m_done = true;
+
+    LOGD("refresh of \"%s\" %s", self->m_key, reason);
+
+    // The pooled connection outlives the refresh, so the stream is told to
+    // stop calling back and, if still in flight, reset. The dispatcher frees
+    // this refresh once the current callback has unwound.
+    rp_timer_disable_timer(self->m_timeout_timer);
+    if (self->m_conn_pool_stream_handle)
+    {
+        rp_cancellable_cancel(self->m_conn_pool_stream_handle, RpCancelPolicy_Default);
+        g_clear_object(&self->m_conn_pool_stream_handle);
+    }
+    if (self->m_request_encoder)
+    {
+        RpStream* stream = rp_stream_encoder_get_stream(RP_STREAM_ENCODER(g_steal_pointer(&self->m_request_encoder)));
+        rp_stream_remove_callbacks(stream, RP_STREAM_CALLBACKS(self));
+        if (!complete)
+        {
+            rp_stream_reset_handler_reset_stream(RP_STREAM_RESET_HANDLER(stream), RpStreamResetReason_LocalReset);
+        }
+    }
+    g_clear_pointer(&self->m_entry, rp_http_cache_entry_unref);
+    rp_http_cache_end_refresh(self->m_cache, self->m_key);
+    rp_dispatcher_deferred_delete_take(self->m_dispatcher, G_OBJECT(self));
+}
+
+static void
+on_pool_failure_i(RpHttpConnPoolCallbacks* self, RpPoolFailureReason_e reason,
+                    const char* transport_failure_reason, RpHostDescriptionConstSharedPtr host)
+{
+    NOISY_MSG_("(%p, %d, %p(%s), %p)",
+        self, reason, transport_failure_reason, transport_failure_reason, host);
+    RpCacheRefresh* me = RP_CACHE_REFRESH(self);
+    g_clear_object(&me->m_conn_pool_stream_handle);
+    finish(me, "found no connection", false);
+}
+
+static void
+on_pool_ready_i(RpHttpConnPoolCallbacks* self, RpRequestEncoder* request_encoder,
+                    RpHostDescriptionConstSharedPtr host, RpStreamInfo* info, evhtp_proto protocol)
+{
+    NOISY_MSG_("(%p, %p, %p, %p, %d)", self, request_encoder, host, info, protocol);
+
+    RpCacheRefresh* me = RP_CACHE_REFRESH(self);
+    g_clear_object(&me->m_conn_pool_stream_handle);
+    me->m_request_encoder = request_encoder;
+    rp_stream_add_callbacks(rp_stream_encoder_get_stream(RP_STREAM_ENCODER(request_encoder)), RP_STREAM_CALLBACKS(self));
+    me->m_request_time = now_seconds();
+    if (rp_request_encoder_encode_headers(request_encoder, me->m_request_headers, true) != RpStatusCode_Ok)
+    {
+        finish(me, "failed to encode request", false);
+    }
+}
+
+static void
+http_conn_pool_callbacks_iface_init(RpHttpConnPoolCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_pool_failure = on_pool_failure_i;
+    iface->on_pool_ready = on_pool_ready_i;
+}
+
+static void
+on_reset_stream_i(RpStreamCallbacks* self, RpStreamResetReason_e reason, const char* transport_failure_reason)
+{
+    NOISY_MSG_("(%p, %d, %p(%s))", self, reason, transport_failure_reason, transport_failure_reason);
+
+    RpCacheRefresh* me = RP_CACHE_REFRESH(self);
+    // The stream is going away on its own.
+    me->m_request_encoder = NULL;
+    finish(me, "reset", false);
+}
+
+static void
+on_above_write_buffer_high_watermark_i(RpStreamCallbacks* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static void
+on_below_write_buffer_low_watermark_i(RpStreamCallbacks* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static void
+stream_callbacks_iface_init(RpStreamCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_reset_stream = on_reset_stream_i;
+    iface->on_above_write_buffer_high_watermark = on_above_write_buffer_high_watermark_i;
+    iface->on_below_write_buffer_low_watermark = on_below_write_buffer_low_watermark_i;
+}
+
+static void
+on_response_complete(RpCacheRefresh* self)
+{
+    NOISY_MSG_("(%p)", self);
+    rp_http_cache_insert(self->m_cache, self->m_key, self->m_request_headers, self->m_entry);
+    finish(self, "stored", true);
+}
+
+static void
+decode_data_i(RpStreamDecoder* self, evbuf_t* data, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p(%zu), %u)", self, data, data ? evbuffer_get_length(data) : 0, end_stream);
+
+    RpCacheRefresh* me = RP_CACHE_REFRESH(self);
+    if (me->m_done)
+    {
+        NOISY_MSG_("done");
+        return;
+    }
+
+    size_t len = data ? evbuffer_get_length(data) : 0;
+    // The same body-only limit the filter applies when it first fills the
+    // entry.
+    if (rp_http_cache_entry_body_length(me->m_entry) + len > me->m_max_entry_size)
+    {
+        // The stored response no longer reflects what the origin serves.
+        rp_http_cache_invalidate(me->m_cache, me->m_key);
+        finish(me, "too large", end_stream);
+        return;
+    }
+    rp_http_cache_entry_append_body(me->m_entry, data);
+    if (data)
+    {
+        evbuffer_drain(data, len);
+    }
+    if (end_stream)
+    {
+        on_response_complete(me);
+    }
+}
+
+static void
+stream_decoder_iface_init(RpStreamDecoderInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->decode_data = decode_data_i;
+}
+
+static void
+decode_1xx_headers_i(RpResponseDecoder* self G_GNUC_UNUSED, evhtp_headers_t* response_headers G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %p)", self, response_headers);
+}
+
+static void
+decode_headers_i(RpResponseDecoder* self, evhtp_headers_t* response_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, response_headers, end_stream);
+
+    RpCacheRefresh* me = RP_CACHE_REFRESH(self);
+    // The codec hands over ownership; hold on to the map until the refresh
+    // is torn down since the parser may still reference it.
+    g_clear_pointer(&me->m_response_headers, rp_header_map_free);
+    me->m_response_headers = response_headers;
+    if (me->m_done)
+    {
+        NOISY_MSG_("done");
+        return;
+    }
+
+    // A failing origin leaves the stale response in place for stale-if-error.
+    evhtp_res status = http_utility_get_response_status(response_headers);
+    if (status >= 500)
+    {
+        finish(me, "failed upstream", end_stream);
+        return;
+    }
+
+    me->m_entry = rp_http_cache_entry_new_for_response(response_headers,
+                                                        me->m_request_time,
+                                                        now_seconds(),
+                                                        me->m_max_entry_size);
+    if (!me->m_entry)
+    {
+        rp_http_cache_invalidate(me->m_cache, me->m_key);
+        finish(me, "not cacheable", end_stream);
+        return;
+    }
+    if (end_stream)
+    {
+        on_response_complete(me);
+    }
+}
+
+static void
+decode_trailers_i(RpResponseDecoder* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    rp_header_map_free(trailers);
+    // Trailers are not stored, so neither is a response that carries them.
+    RpCacheRefresh* me = RP_CACHE_REFRESH(self);
+    if (!me->m_done)
+    {
+        rp_http_cache_invalidate(me->m_cache, me->m_key);
+        finish(me, "has trailers", true);
+    }
+}
+
+static void
+response_decoder_iface_init(RpResponseDecoderInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->decode_1xx_headers = decode_1xx_headers_i;
+    iface->decode_headers = decode_headers_i;
+    iface->decode_trailers = decode_trailers_i;
+}
+
+static void
+on_timeout_timer(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+    finish(RP_CACHE_REFRESH(arg), "timed out", false);
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpCacheRefresh* self = RP_CACHE_REFRESH(obj);
+    g_clear_object(&self->m_timeout_timer);
+    g_clear_object(&self->m_conn_pool_stream_handle);
+    g_clear_object(&self->m_pool_data);
+    g_clear_pointer(&self->m_entry, rp_http_cache_entry_unref);
+    g_clear_pointer(&self->m_response_headers, rp_header_map_free);
+    g_clear_pointer(&self->m_request_headers, rp_header_map_free);
+    g_clear_pointer(&self->m_key, g_free);
+
+    G_OBJECT_CLASS(rp_cache_refresh_parent_class)->dispose(obj);
+}
+
+static void
+rp_cache_refresh_class_init(RpCacheRefreshClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_cache_refresh_init(RpCacheRefresh* self)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static inline RpCacheRefresh*
+cache_refresh_new(RpHttpCache* cache, const char* key, evhtp_headers_t* request_headers, RpDispatcher* dispatcher, guint64 max_entry_size_bytes)
+{
+    NOISY_MSG_("(%p, %p(%s), %p, %p, %" G_GUINT64_FORMAT ")",
+        cache, key, key, request_headers, dispatcher, max_entry_size_bytes);
+    RpCacheRefresh* self = g_object_new(RP_TYPE_CACHE_REFRESH, NULL);
+    self->m_cache = cache;
+    self->m_dispatcher = dispatcher;
+    self->m_key = g_strdup(key);
+    self->m_request_headers = copy_request_headers(request_headers);
+    self->m_max_entry_size = max_entry_size_bytes;
+    self->m_timeout_timer = rp_dispatcher_create_timer(dispatcher, on_timeout_timer, self);
+    return self;
+}
+
+bool
+rp_cache_refresh_start(RpHttpCache* cache, const char* key, evhtp_headers_t* request_headers, RpRouteEntry* route_entry,
+                        RpStreamInfo* stream_info, RpThreadLocalCluster* cluster, RpDispatcher* dispatcher, guint64 max_entry_size_bytes)
+{
+    LOGD("(%p, %p(%s), %p, %p, %p, %p, %p, %" G_GUINT64_FORMAT ")",
+        cache, key, key, request_headers, route_entry, stream_info, cluster, dispatcher, max_entry_size_bytes);
+
+    g_return_val_if_fail(RP_IS_HTTP_CACHE(cache), false);
+    g_return_val_if_fail(key != NULL, false);
+    g_return_val_if_fail(request_headers != NULL, false);
+    g_return_val_if_fail(RP_IS_ROUTE_ENTRY(route_entry), false);
+    g_return_val_if_fail(RP_IS_STREAM_INFO(stream_info), false);
+    g_return_val_if_fail(RP_IS_THREAD_LOCAL_CLUSTER(cluster), false);
+    g_return_val_if_fail(RP_IS_DISPATCHER(dispatcher), false);
+
+    if (!rp_http_cache_begin_refresh(cache, key))
+    {
+        NOISY_MSG_("already refreshing");
+        return false;
+    }
+
+    // Asynchronous host selection is not supported; the stale response is
+    // served until a later request finds a host.
+    RpHostSelectionResponse host_selection = rp_thread_local_cluster_choose_host(cluster, NULL);
+    if (!host_selection.m_host || host_selection.m_cancelable)
+    {
+        LOGD("no host to refresh \"%s\"", key);
+        rp_http_cache_end_refresh(cache, key);
+        return false;
+    }
+    // The same pools, and so the same upstream protocol and connections, as
+    // the router would use for a miss.
+    RpHttpPoolData* pool_data = rp_thread_local_cluster_http_conn_pool(cluster,
+                                                                        host_selection.m_host,
+                                                                        rp_route_entry_priority(route_entry),
+                                                                        rp_stream_info_protocol(stream_info),
+                                                                        NULL);
+    if (!pool_data)
+    {
+        LOGD("no connection pool to refresh \"%s\"", key);
+        rp_http_cache_end_refresh(cache, key);
+        return false;
+    }
+
+    // The refresh holds its own reference until finish() hands it to the
+    // dispatcher. The request goes out once the pool has a stream for it; see
+    // on_pool_ready_i().
+    RpCacheRefresh* self = cache_refresh_new(cache, key, request_headers, dispatcher, max_entry_size_bytes);
+    self->m_pool_data = pool_data;
+    rp_route_entry_finalize_request_headers(route_entry, self->m_request_headers, stream_info, false);
+    rp_timer_enable_timer(self->m_timeout_timer, REFRESH_TIMEOUT_MS);
+
+    RpHttpConnPoolInstStreamOptions options = rp_http_conn_pool_inst_stream_options_ctor(false, false);
+    RpCancellable* handle = rp_http_pool_data_new_stream(pool_data,
+                                                            RP_RESPONSE_DECODER(self),
+                                                            RP_HTTP_CONN_POOL_CALLBACKS(self),
+                                                            &options);
+    // Set only while the stream is pending; an immediate answer returns none.
+    self->m_conn_pool_stream_handle = handle;
+    return true;
+}
@@ -0,0 +1,47 @@
+/*
+ * rp-cache-refresh.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <evhtp.h>
+#include "cache/rp-http-cache.h"
+#include "rp-dispatcher.h"
+#include "rp-router.h"
+#include "rp-stream-info.h"
+#include "rp-thread-local-cluster.h"
+
+G_BEGIN_DECLS
+
+/**
+ * A background refetch of a stale cached response. It is not tied to any
+ * downstream stream; the refresh owns itself and goes away once the response
+ * has been stored, the origin has failed or the timeout has fired. The
+ * request is finalized by the route and sent over the cluster's connection
+ * pools, the same way the router sends a miss.
+ */
+#define RP_TYPE_CACHE_REFRESH rp_cache_refresh_get_type()
+G_DECLARE_FINAL_TYPE(RpCacheRefresh, rp_cache_refresh, RP, CACHE_REFRESH, GObject)
+
+/**
+ * Starts refreshing |key| unless a refresh of it is already in flight. The
+ * request headers are copied, less any conditional and hop-by-hop headers.
+ * |route_entry| and |stream_info| belong to the stream that found the entry
+ * stale and are only used before this returns.
+ * @return true if a refresh was started.
+ */
+bool rp_cache_refresh_start(RpHttpCache* cache,
+                            const char* key,
+                            evhtp_headers_t* request_headers,
+                            RpRouteEntry* route_entry,
+                            RpStreamInfo* stream_info,
+                            RpThreadLocalCluster* cluster,
+                            RpDispatcher* dispatcher,
+                            guint64 max_entry_size_bytes);
+
+G_END_DECLS
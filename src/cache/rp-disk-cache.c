@@ -0,0 +1,746 @@
+/*
+ * rp-disk-cache.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_disk_cache_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_disk_cache_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "rproxy.h"
+#include "cache/rp-cache-headers-utils.h"
+#include "cache/rp-disk-cache.h"
+
+// Records start on block boundaries so that recovery only has to probe one
+// offset per block.
+#define RP_DISK_CACHE_BLOCK_SIZE 4096
+#define RP_DISK_CACHE_MIN_BLOCKS 16
+#define RP_DISK_CACHE_MAGIC 0x32435052u // "RPC2"
+// Bounds the evicted entries kept alive while they wait for the writer, in
+// multiples of the largest entry the tier takes.
+#define RP_DISK_CACHE_MAX_PENDING_ENTRIES 8
+
+// On-disk record layout: this header, then the base key, Vary, variant key,
+// entry metadata and body, padded to a whole number of blocks.
+typedef struct _RpDiskRecordHeader RpDiskRecordHeader;
+struct _RpDiskRecordHeader {
+    guint32 magic;    // written last; cleared when the record is dropped
+    guint32 checksum; // of the fields below
+    guint32 payload_checksum; // of the keys, metadata and body
+    guint32 reserved;
+    guint64 sequence;
+    guint64 length;
+    guint64 body_length;
+    guint32 key_length;
+    guint32 vary_length;
+    guint32 variant_key_length;
+    guint32 metadata_length;
+};
+
+typedef struct _RpDiskCacheRecord RpDiskCacheRecord;
+struct _RpDiskCacheRecord {
+    // One reference is held by the log and one by each file segment or
+    // writer using the record's extent; the log never drops a record that
+    // is still referenced elsewhere.
+    gatomicrefcount ref_count;
+
+    char* m_key;
+    char* m_base_key;
+    guint64 m_offset;
+    guint64 m_length;
+    guint64 m_metadata_offset;
+    guint64 m_metadata_length;
+    guint64 m_body_offset;
+    guint64 m_body_length;
+    bool m_indexed;
+};
+
+// An insert waiting for the writer thread.
+typedef struct _RpDiskCacheWrite RpDiskCacheWrite;
+struct _RpDiskCacheWrite {
+    char* m_key;
+    char* m_vary;
+    char* m_variant_key;
+    RpHttpCacheEntry* m_entry;
+    guint64 m_generation; // invalidation generation when queued
+};
+
+typedef struct _RpDiskCacheVariants RpDiskCacheVariants;
+struct _RpDiskCacheVariants {
+    char* m_vary; // Vary of the stored variants; NULL if none.
+    GSList* m_records;
+};
+
+struct _RpDiskCache {
+    GObject parent_instance;
+
+    GMutex m_lock;
+    // Records are copied into the file here rather than on the worker loops,
+    // one at a time and in the order they were queued.
+    GThreadPool* m_writer;
+    guint64 m_pending; // body bytes queued for the writer; under m_lock
+    guint m_queued;    // writes queued for the writer; under m_lock
+    // Base key -> generation of its last invalidation, kept while writes
+    // queued before it may still come in; under m_lock.
+    GHashTable* m_invalidations;
+    guint64 m_generation;
+    int m_fd;
+    guint8* m_map;
+    guint64 m_size;
+    guint64 m_max_entry_size;
+
+    GHashTable* m_records;  // variant key -> RpDiskCacheRecord*, borrowed from m_log
+    GHashTable* m_variants; // base key -> RpDiskCacheVariants*
+    GQueue m_log;           // RpDiskCacheRecord*, oldest first, in file order from m_cursor
+    guint64 m_cursor;
+    guint64 m_sequence;
+};
+
+G_DEFINE_FINAL_TYPE(RpDiskCache, rp_disk_cache, G_TYPE_OBJECT)
+
+static inline guint64
+align_to_block(guint64 length)
+{
+    return (length + RP_DISK_CACHE_BLOCK_SIZE - 1) & ~(guint64)(RP_DISK_CACHE_BLOCK_SIZE - 1);
+}
+
+static inline RpDiskRecordHeader*
+record_header_at(RpDiskCache* self, guint64 offset)
+{
+    return (RpDiskRecordHeader*)(self->m_map + offset);
+}
+
+#define FNV1A_INIT 2166136261u
+
+static guint32
+fnv1a(guint32 hash, const guint8* data, gsize len)
+{
+    for (const guint8* end = data + len; data < end; ++data)
+    {
+        hash = (hash ^ *data) * 16777619u;
+    }
+    return hash;
+}
+
+// FNV-1a over everything after the magic and checksum, the payload checksum
+// included.
+static guint32
+header_checksum(const RpDiskRecordHeader* header)
+{
+    const guint8* start = (const guint8*)&header->payload_checksum;
+    return fnv1a(FNV1A_INIT, start, (const guint8*)header + sizeof(*header) - start);
+}
+
+static inline guint64
+payload_length(const RpDiskRecordHeader* header)
+{
+    return (guint64)header->key_length + header->vary_length + header->variant_key_length +
+            header->metadata_length + header->body_length;
+}
+
+static void
+record_unref(RpDiskCacheRecord* record)
+{
+    NOISY_MSG_("(%p)", record);
+    if (g_atomic_ref_count_dec(&record->ref_count))
+    {
+        NOISY_MSG_("freeing %p", record);
+        g_free(record->m_key);
+        g_free(record->m_base_key);
+        g_free(record);
+    }
+}
+
+static inline bool
+record_is_pinned(RpDiskCacheRecord* record)
+{
+    return !g_atomic_ref_count_compare(&record->ref_count, 1);
+}
+
+static RpDiskCacheRecord*
+record_new(const char* key, const char* base_key, guint64 offset, const RpDiskRecordHeader* header)
+{
+    NOISY_MSG_("(%p(%s), %p(%s), %" G_GUINT64_FORMAT ", %p)", key, key, base_key, base_key, offset, header);
+    RpDiskCacheRecord* record = g_new0(RpDiskCacheRecord, 1);
+    g_atomic_ref_count_init(&record->ref_count);
+    record->m_key = g_strdup(key);
+    record->m_base_key = g_strdup(base_key);
+    record->m_offset = offset;
+    record->m_length = header->length;
+    record->m_metadata_offset = offset + sizeof(*header) +
+                                header->key_length + header->vary_length + header->variant_key_length;
+    record->m_metadata_length = header->metadata_length;
+    record->m_body_offset = record->m_metadata_offset + header->metadata_length;
+    record->m_body_length = header->body_length;
+    return record;
+}
+
+static void
+variants_free(gpointer arg)
+{
+    NOISY_MSG_("(%p)", arg);
+    RpDiskCacheVariants* variants = arg;
+    g_free(variants->m_vary);
+    g_slist_free(variants->m_records);
+    g_free(variants);
+}
+
+static void
+unindex_record(RpDiskCache* self, RpDiskCacheRecord* record)
+{
+    NOISY_MSG_("(%p, %p)", self, record);
+    if (!record->m_indexed)
+    {
+        return;
+    }
+    record->m_indexed = false;
+    // Keep the record from coming back after a restart. Its extent stays in
+    // the log, and so is not reused, until the log reaches it.
+    record_header_at(self, record->m_offset)->magic = 0;
+    RpDiskCacheVariants* variants = g_hash_table_lookup(self->m_variants, record->m_base_key);
+    if (variants)
+    {
+        variants->m_records = g_slist_remove(variants->m_records, record);
+        if (!variants->m_records)
+        {
+            g_hash_table_remove(self->m_variants, record->m_base_key);
+        }
+    }
+    g_hash_table_remove(self->m_records, record->m_key);
+}
+
+static void
+unindex_variants(RpDiskCache* self, const char* base_key)
+{
+    NOISY_MSG_("(%p, %p(%s))", self, base_key, base_key);
+    RpDiskCacheVariants* variants;
+    while ((variants = g_hash_table_lookup(self->m_variants, base_key)))
+    {
+        unindex_record(self, variants->m_records->data);
+    }
+}
+
+// Makes |record| the one found under its variant key, replacing what was
+// stored for it and, if the origin changed Vary, for its other variants.
+static void
+index_record(RpDiskCache* self, RpDiskCacheRecord* record, const char* vary)
+{
+    NOISY_MSG_("(%p, %p, %p(%s))", self, record, vary, vary);
+    RpDiskCacheVariants* variants = g_hash_table_lookup(self->m_variants, record->m_base_key);
+    if (variants && g_strcmp0(variants->m_vary, vary) != 0)
+    {
+        unindex_variants(self, record->m_base_key);
+        variants = NULL;
+    }
+    RpDiskCacheRecord* existing = g_hash_table_lookup(self->m_records, record->m_key);
+    if (existing)
+    {
+        unindex_record(self, existing);
+        variants = g_hash_table_lookup(self->m_variants, record->m_base_key);
+    }
+    if (!variants)
+    {
+        variants = g_new0(RpDiskCacheVariants, 1);
+        variants->m_vary = g_strdup(vary);
+        g_hash_table_insert(self->m_variants, g_strdup(record->m_base_key), variants);
+    }
+    variants->m_records = g_slist_prepend(variants->m_records, record);
+    g_hash_table_insert(self->m_records, record->m_key, record);
+    record->m_indexed = true;
+}
+
+static bool
+log_drop_head(RpDiskCache* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpDiskCacheRecord* record = g_queue_peek_head(&self->m_log);
+    if (record_is_pinned(record))
+    {
+        NOISY_MSG_("record %p still in use", record);
+        return false;
+    }
+    g_queue_pop_head(&self->m_log);
+    unindex_record(self, record);
+    record_header_at(self, record->m_offset)->magic = 0;
+    record_unref(record);
+    return true;
+}
+
+// Claims |length| bytes at the write cursor, dropping the oldest records in
+// the way. Records are written in order, so those are always at the head of
+// the log.
+static bool
+log_reserve(RpDiskCache* self, guint64 length, guint64* offset)
+{
+    NOISY_MSG_("(%p, %" G_GUINT64_FORMAT ", %p)", self, length, offset);
+
+    RpDiskCacheRecord* head;
+    if (self->m_cursor + length > self->m_size)
+    {
+        // Too little room is left before the end of the file; wrap around.
+        while ((head = g_queue_peek_head(&self->m_log)) && head->m_offset >= self->m_cursor)
+        {
+            if (!log_drop_head(self))
+            {
+                return false;
+            }
+        }
+        self->m_cursor = 0;
+    }
+    while ((head = g_queue_peek_head(&self->m_log)) &&
+            head->m_offset >= self->m_cursor &&
+            head->m_offset < self->m_cursor + length)
+    {
+        if (!log_drop_head(self))
+        {
+            return false;
+        }
+    }
+    *offset = self->m_cursor;
+    self->m_cursor += length;
+    return true;
+}
+
+static bool
+header_is_valid(RpDiskCache* self, const RpDiskRecordHeader* header, guint64 offset)
+{
+    if (header->magic != RP_DISK_CACHE_MAGIC || header->checksum != header_checksum(header))
+    {
+        return false;
+    }
+    guint64 payload = payload_length(header);
+    if (header->length % RP_DISK_CACHE_BLOCK_SIZE != 0 ||
+        header->length > self->m_size - offset ||
+        sizeof(*header) + payload > header->length ||
+        header->key_length == 0 ||
+        header->variant_key_length == 0)
+    {
+        return false;
+    }
+    // The header is written last, but the payload pages may not all have
+    // reached the file before a crash.
+    return fnv1a(FNV1A_INIT, (const guint8*)(header + 1), payload) == header->payload_checksum;
+}
+
+typedef struct _RpDiskCacheRecovered RpDiskCacheRecovered;
+struct _RpDiskCacheRecovered {
+    guint64 offset;
+    guint64 sequence;
+};
+
+static gint
+compare_recovered(gconstpointer a, gconstpointer b)
+{
+    const RpDiskCacheRecovered* ra = a;
+    const RpDiskCacheRecovered* rb = b;
+    return ra->sequence < rb->sequence ? -1 : ra->sequence > rb->sequence;
+}
+
+// Rebuilds the log and index from the records left in the file by a previous
+// run. Records are dropped (and their magic cleared) before their extent is
+// rewritten, so stepping over each valid record never hides a newer one.
+static void
+log_recover(RpDiskCache* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    GArray* recovered = g_array_new(FALSE, FALSE, sizeof(RpDiskCacheRecovered));
+    guint64 offset = 0;
+    while (offset + sizeof(RpDiskRecordHeader) <= self->m_size)
+    {
+        RpDiskRecordHeader* header = record_header_at(self, offset);
+        if (header_is_valid(self, header, offset))
+        {
+            RpDiskCacheRecovered found = { .offset = offset, .sequence = header->sequence };
+            g_array_append_val(recovered, found);
+            offset += header->length;
+        }
+        else
+        {
+            offset += RP_DISK_CACHE_BLOCK_SIZE;
+        }
+    }
+    g_array_sort(recovered, compare_recovered);
+
+    for (guint i = 0; i < recovered->len; ++i)
+    {
+        RpDiskCacheRecovered* found = &g_array_index(recovered, RpDiskCacheRecovered, i);
+        RpDiskRecordHeader* header = record_header_at(self, found->offset);
+        const char* itr = (const char*)(header + 1);
+        g_autofree char* base_key = g_strndup(itr, header->key_length);
+        itr += header->key_length;
+        g_autofree char* vary = header->vary_length ? g_strndup(itr, header->vary_length) : NULL;
+        itr += header->vary_length;
+        g_autofree char* key = g_strndup(itr, header->variant_key_length);
+
+        RpDiskCacheRecord* record = record_new(key, base_key, found->offset, header);
+        g_queue_push_tail(&self->m_log, record);
+        index_record(self, record, vary);
+
+        self->m_cursor = found->offset + header->length;
+        self->m_sequence = header->sequence + 1;
+    }
+    LOGD("recovered %u records", recovered->len);
+    g_array_free(recovered, TRUE);
+}
+
+static void
+write_free(RpDiskCacheWrite* write)
+{
+    NOISY_MSG_("(%p)", write);
+    g_free(write->m_key);
+    g_free(write->m_vary);
+    g_free(write->m_variant_key);
+    rp_http_cache_entry_unref(write->m_entry);
+    g_free(write);
+}
+
+// Whether |key| was invalidated after a write queued at |generation|. Called
+// with m_lock held.
+static inline bool
+invalidated_since(RpDiskCache* self, const char* key, guint64 generation)
+{
+    gpointer invalidated;
+    return g_hash_table_lookup_extended(self->m_invalidations, key, NULL, &invalidated) &&
+            GPOINTER_TO_SIZE(invalidated) > generation;
+}
+
+static void
+write_record(RpDiskCache* self, const char* key, const char* vary, const char* variant_key, RpHttpCacheEntry* entry,
+                guint64 generation)
+{
+    NOISY_MSG_("(%p, %p(%s), %p(%s), %p(%s), %p, %" G_GUINT64_FORMAT ")",
+        self, key, key, vary, vary, variant_key, variant_key, entry, generation);
+
+    gsize body_length = rp_http_cache_entry_body_length(entry);
+    g_autoptr(GBytes) metadata = rp_http_cache_entry_serialize(entry);
+    RpDiskRecordHeader header = {
+        .body_length = body_length,
+        .key_length = strlen(key),
+        .vary_length = vary ? strlen(vary) : 0,
+        .variant_key_length = strlen(variant_key),
+        .metadata_length = g_bytes_get_size(metadata)
+    };
+    header.length = align_to_block(sizeof(header) + payload_length(&header));
+    if (header.length > self->m_size)
+    {
+        NOISY_MSG_("record of %" G_GUINT64_FORMAT " bytes too large", header.length);
+        return;
+    }
+
+    guint64 offset;
+    g_mutex_lock(&self->m_lock);
+    if (invalidated_since(self, key, generation))
+    {
+        g_mutex_unlock(&self->m_lock);
+        NOISY_MSG_("invalidated while queued");
+        return;
+    }
+    if (!log_reserve(self, header.length, &offset))
+    {
+        g_mutex_unlock(&self->m_lock);
+        NOISY_MSG_("no room");
+        return;
+    }
+    header.sequence = self->m_sequence++;
+    RpDiskCacheRecord* record = record_new(variant_key, key, offset, &header);
+    g_queue_push_tail(&self->m_log, record);
+    // The extent is reserved; pin it so it is not handed out again while the
+    // record is copied in without the lock held.
+    g_atomic_ref_count_inc(&record->ref_count);
+    g_mutex_unlock(&self->m_lock);
+
+    guint8* payload = self->m_map + offset + sizeof(header);
+    guint8* itr = payload;
+    memcpy(itr, key, header.key_length);
+    itr += header.key_length;
+    if (vary)
+    {
+        memcpy(itr, vary, header.vary_length);
+        itr += header.vary_length;
+    }
+    memcpy(itr, variant_key, header.variant_key_length);
+    itr += header.variant_key_length;
+    memcpy(itr, g_bytes_get_data(metadata, NULL), header.metadata_length);
+    itr += header.metadata_length;
+    evbuf_t* body = rp_http_cache_entry_body(entry);
+    evbuffer_copyout(body, itr, body_length);
+    evbuffer_free(body);
+
+    // The header goes last so a record is only ever found complete.
+    header.payload_checksum = fnv1a(FNV1A_INIT, payload, payload_length(&header));
+    header.checksum = header_checksum(&header);
+    header.magic = RP_DISK_CACHE_MAGIC;
+    *record_header_at(self, offset) = header;
+
+    g_mutex_lock(&self->m_lock);
+    if (invalidated_since(self, key, generation))
+    {
+        // Stale before it was ever found; drop it like an unindexed record
+        // so it does not come back after a restart either.
+        NOISY_MSG_("invalidated while written");
+        record_header_at(self, offset)->magic = 0;
+    }
+    else
+    {
+        index_record(self, record, vary);
+    }
+    g_mutex_unlock(&self->m_lock);
+    record_unref(record);
+}
+
+static void
+writer_func(gpointer data, gpointer user_data)
+{
+    NOISY_MSG_("(%p, %p)", data, user_data);
+
+    RpDiskCache* self = user_data;
+    RpDiskCacheWrite* write = data;
+    write_record(self, write->m_key, write->m_vary, write->m_variant_key, write->m_entry, write->m_generation);
+
+    g_mutex_lock(&self->m_lock);
+    self->m_pending -= rp_http_cache_entry_body_length(write->m_entry);
+    if (--self->m_queued == 0)
+    {
+        // Nothing queued could predate them any more.
+        g_hash_table_remove_all(self->m_invalidations);
+    }
+    g_mutex_unlock(&self->m_lock);
+    write_free(write);
+}
+
+static void
+segment_cleanup_cb(struct evbuffer_file_segment const* segment G_GNUC_UNUSED, int flags G_GNUC_UNUSED, void* arg)
+{
+    NOISY_MSG_("(%p, %d, %p)", segment, flags, arg);
+    record_unref(arg);
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpDiskCache* self = RP_DISK_CACHE(obj);
+    if (self->m_writer)
+    {
+        // Lets queued records finish; they are still worth keeping.
+        g_thread_pool_free(g_steal_pointer(&self->m_writer), FALSE, TRUE);
+    }
+    g_clear_pointer(&self->m_invalidations, g_hash_table_unref);
+    g_clear_pointer(&self->m_variants, g_hash_table_unref);
+    g_clear_pointer(&self->m_records, g_hash_table_unref);
+    RpDiskCacheRecord* record;
+    while ((record = g_queue_pop_head(&self->m_log)))
+    {
+        record_unref(record);
+    }
+    if (self->m_map)
+    {
+        msync(self->m_map, self->m_size, MS_ASYNC);
+        munmap(self->m_map, self->m_size);
+        self->m_map = NULL;
+    }
+    if (self->m_fd >= 0)
+    {
+        close(self->m_fd);
+        self->m_fd = -1;
+    }
+
+    G_OBJECT_CLASS(rp_disk_cache_parent_class)->dispose(obj);
+}
+
+OVERRIDE void
+finalize(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+    g_mutex_clear(&RP_DISK_CACHE(obj)->m_lock);
+    G_OBJECT_CLASS(rp_disk_cache_parent_class)->finalize(obj);
+}
+
+static void
+rp_disk_cache_class_init(RpDiskCacheClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+    object_class->finalize = finalize;
+}
+
+static void
+rp_disk_cache_init(RpDiskCache* self)
+{
+    NOISY_MSG_("(%p)", self);
+    g_mutex_init(&self->m_lock);
+    self->m_fd = -1;
+    self->m_records = g_hash_table_new(g_str_hash, g_str_equal);
+    self->m_variants = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, variants_free);
+    self->m_invalidations = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    g_queue_init(&self->m_log);
+}
+
+RpDiskCache*
+rp_disk_cache_new(const char* path, guint64 size_bytes, guint64 max_entry_size_bytes)
+{
+    LOGD("(%p(%s), %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ")", path, path, size_bytes, max_entry_size_bytes);
+
+    g_return_val_if_fail(path != NULL, NULL);
+
+    guint64 size = MAX(size_bytes, RP_DISK_CACHE_MIN_BLOCKS * RP_DISK_CACHE_BLOCK_SIZE) &
+                    ~(guint64)(RP_DISK_CACHE_BLOCK_SIZE - 1);
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        LOGE("open \"%s\" failed (%s)", path, g_strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || ((guint64)st.st_size != size && ftruncate(fd, size) < 0))
+    {
+        LOGE("sizing \"%s\" failed (%s)", path, g_strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    guint8* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        LOGE("mmap \"%s\" failed (%s)", path, g_strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    RpDiskCache* self = g_object_new(RP_TYPE_DISK_CACHE, NULL);
+    self->m_fd = fd;
+    self->m_map = map;
+    self->m_size = size;
+    GError* err = NULL;
+    self->m_writer = g_thread_pool_new(writer_func, self, 1, FALSE, &err);
+    if (!self->m_writer)
+    {
+        LOGE("g_thread_pool_new() failed: %s", err ? err->message : "?");
+        g_clear_error(&err);
+        g_object_unref(self);
+        return NULL;
+    }
+    // A single record may not take more than a fraction of the log, or a few
+    // large objects would flush everything else out.
+    self->m_max_entry_size = MIN(max_entry_size_bytes, size / 8);
+    log_recover(self);
+    return self;
+}
+
+RpHttpCacheEntry*
+rp_disk_cache_lookup(RpDiskCache* self, const char* key, evhtp_headers_t* request_headers)
+{
+    LOGD("(%p, %p(%s), %p)", self, key, key, request_headers);
+
+    g_return_val_if_fail(RP_IS_DISK_CACHE(self), NULL);
+    g_return_val_if_fail(key != NULL, NULL);
+
+    RpDiskCacheRecord* record = NULL;
+    g_mutex_lock(&self->m_lock);
+    RpDiskCacheVariants* variants = g_hash_table_lookup(self->m_variants, key);
+    if (variants)
+    {
+        g_autofree char* variant = rp_cache_headers_utils_variant_key(key, variants->m_vary, request_headers);
+        record = g_hash_table_lookup(self->m_records, variant);
+        if (record)
+        {
+            // Pinned until the entry and every buffer sending its body are
+            // gone.
+            g_atomic_ref_count_inc(&record->ref_count);
+        }
+    }
+    g_mutex_unlock(&self->m_lock);
+    if (!record)
+    {
+        NOISY_MSG_("miss");
+        return NULL;
+    }
+
+    RpHttpCacheEntry* entry = rp_http_cache_entry_deserialize(self->m_map + record->m_metadata_offset,
+                                                                record->m_metadata_length);
+    struct evbuffer_file_segment* segment = entry ?
+        evbuffer_file_segment_new(self->m_fd, record->m_body_offset, record->m_body_length, 0) : NULL;
+    if (!segment)
+    {
+        LOGE("unreadable record for \"%s\"", record->m_key);
+        g_clear_pointer(&entry, rp_http_cache_entry_unref);
+        record_unref(record);
+        return NULL;
+    }
+    evbuffer_file_segment_add_cleanup_cb(segment, segment_cleanup_cb, record);
+    rp_http_cache_entry_set_body_file(entry, segment, record->m_body_length);
+    NOISY_MSG_("entry %p", entry);
+    return entry;
+}
+
+bool
+rp_disk_cache_insert(RpDiskCache* self, const char* key, const char* vary, const char* variant_key, RpHttpCacheEntry* entry)
+{
+    LOGD("(%p, %p(%s), %p(%s), %p(%s), %p)", self, key, key, vary, vary, variant_key, variant_key, entry);
+
+    g_return_val_if_fail(RP_IS_DISK_CACHE(self), false);
+    g_return_val_if_fail(key != NULL, false);
+    g_return_val_if_fail(variant_key != NULL, false);
+    g_return_val_if_fail(entry != NULL, false);
+
+    gsize body_length = rp_http_cache_entry_body_length(entry);
+    if (body_length > self->m_max_entry_size)
+    {
+        NOISY_MSG_("entry with %zu byte body too large", body_length);
+        return false;
+    }
+
+    g_mutex_lock(&self->m_lock);
+    if (self->m_pending + body_length > self->m_max_entry_size * RP_DISK_CACHE_MAX_PENDING_ENTRIES)
+    {
+        g_mutex_unlock(&self->m_lock);
+        NOISY_MSG_("writer backlog full");
+        return false;
+    }
+    self->m_pending += body_length;
+    ++self->m_queued;
+    guint64 generation = self->m_generation;
+    g_mutex_unlock(&self->m_lock);
+
+    // The entry is immutable, so the writer can copy it out as is.
+    RpDiskCacheWrite* write = g_new(RpDiskCacheWrite, 1);
+    write->m_key = g_strdup(key);
+    write->m_vary = g_strdup(vary);
+    write->m_variant_key = g_strdup(variant_key);
+    write->m_entry = rp_http_cache_entry_ref(entry);
+    write->m_generation = generation;
+    g_thread_pool_push(self->m_writer, write, NULL);
+    return true;
+}
+
+void
+rp_disk_cache_invalidate(RpDiskCache* self, const char* key)
+{
+    LOGD("(%p, %p(%s))", self, key, key);
+
+    g_return_if_fail(RP_IS_DISK_CACHE(self));
+    g_return_if_fail(key != NULL);
+
+    g_mutex_lock(&self->m_lock);
+    unindex_variants(self, key);
+    if (self->m_queued > 0)
+    {
+        // Writes queued before now must not bring the key back.
+        g_hash_table_insert(self->m_invalidations, g_strdup(key), GSIZE_TO_POINTER(++self->m_generation));
+    }
+    g_mutex_unlock(&self->m_lock);
+}
@@ -0,0 +1,61 @@
+/*
+ * rp-disk-cache.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <evhtp.h>
+#include "cache/rp-http-cache.h"
+
+G_BEGIN_DECLS
+
+/**
+ * The second, file-backed tier of the response cache. Responses are written
+ * to a fixed-size, memory-mapped file used as a circular log, with the index
+ * kept in memory; the oldest records are overwritten as the log wraps. Each
+ * record carries its own keys, so the index is rebuilt from the file when the
+ * process restarts; records whose payload checksum does not match are
+ * skipped. Bodies are served as evbuffer file segments, so they are
+ * sent with sendfile() where the transport allows, and a record is never
+ * overwritten while a response is still being sent from it.
+ */
+#define RP_TYPE_DISK_CACHE rp_disk_cache_get_type()
+G_DECLARE_FINAL_TYPE(RpDiskCache, rp_disk_cache, RP, DISK_CACHE, GObject)
+
+/**
+ * Opens, creating if needed, the cache file at |path| and sizes it to
+ * |size_bytes|.
+ * @return the disk tier, or NULL if the file could not be opened or mapped.
+ */
+RpDiskCache* rp_disk_cache_new(const char* path,
+                                guint64 size_bytes,
+                                guint64 max_entry_size_bytes);
+/**
+ * @return a new entry, with its body backed by the file, for the variant of
+ *         |key| that the request's Vary headers select, or NULL.
+ */
+RpHttpCacheEntry* rp_disk_cache_lookup(RpDiskCache* self,
+                                        const char* key,
+                                        evhtp_headers_t* request_headers);
+/**
+ * Queues |entry| to be stored as |variant_key|, the variant of |key| that
+ * |vary| selects. The copy into the file happens on the tier's writer thread;
+ * the entry becomes visible to lookups once it is complete.
+ * @return false if the entry is too large or the writer is too far behind.
+ */
+bool rp_disk_cache_insert(RpDiskCache* self,
+                            const char* key,
+                            const char* vary,
+                            const char* variant_key,
+                            RpHttpCacheEntry* entry);
+/**
+ * Removes every variant stored for |key|.
+ */
+void rp_disk_cache_invalidate(RpDiskCache* self, const char* key);
+
+G_END_DECLS
@@ -0,0 +1,914 @@
+/*
+ * rp-http-cache.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http_cache_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http_cache_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "rp-http-utility.h"
+#include "rp-singleton-instance.h"
+#include "cache/rp-cache-headers-utils.h"
+#include "cache/rp-disk-cache.h"
+#include "cache/rp-http-cache.h"
+
+#define RP_HTTP_CACHE_DEFAULT_MAX_SIZE (64 * 1024 * 1024)
+
+SINGLETON_MANAGER_REGISTRATION(http_cache);
+
+// The singleton manager itself is not thread safe and filter factories are
+// created on every worker.
+G_LOCK_DEFINE_STATIC(http_cache);
+
+struct _RpHttpCacheEntry {
+    gatomicrefcount ref_count;
+
+    evhtp_headers_t* m_headers;
+    GByteArray* m_body;
+    // Set instead of m_body for entries whose body lives in the disk tier.
+    struct evbuffer_file_segment* m_body_file;
+    gsize m_body_file_length;
+    char* m_etag;
+    gint64 m_response_time;
+    gint64 m_corrected_initial_age;
+    gint64 m_freshness_lifetime;
+    gint64 m_last_modified;
+    gint64 m_stale_while_revalidate;
+    gint64 m_stale_if_error;
+    gsize m_headers_size;
+    bool m_no_stale;
+};
+
+// Headers that describe the connection or the framing of the original response
+// rather than the stored representation.
+static inline bool
+is_unstored_header(const char* key)
+{
+    return g_ascii_strcasecmp(key, RpHeaderValues.Connection) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.KeepAlive) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.ProxyConnection) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.TransferEncoding) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.TE) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.Upgrade) == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.ContentLength) == 0 ||
+            g_ascii_strcasecmp(key, RpCustomHeaderValues.Age) == 0;
+}
+
+RpHttpCacheEntry*
+rp_http_cache_entry_new(evhtp_headers_t* response_headers, gint64 request_time, gint64 response_time)
+{
+    LOGD("(%p, %" G_GINT64_FORMAT ", %" G_GINT64_FORMAT ")", response_headers, request_time, response_time);
+
+    g_return_val_if_fail(response_headers != NULL, NULL);
+
+    RpHttpCacheEntry* self = g_new0(RpHttpCacheEntry, 1);
+    self->m_headers = rp_header_map_new();
+    evhtp_header_t* header;
+    TAILQ_FOREACH(header, response_headers, next)
+    {
+        if (!is_unstored_header(header->key))
+        {
+            rp_header_map_add_copy(self->m_headers, header->key, header->klen, header->val, header->vlen);
+            self->m_headers_size += header->klen + header->vlen;
+        }
+    }
+    self->m_body = g_byte_array_new();
+
+    RpResponseCacheControl cache_control = rp_response_cache_control_parse(response_headers);
+    self->m_freshness_lifetime = rp_cache_headers_utils_freshness_lifetime(response_headers, &cache_control, response_time);
+    self->m_no_stale = cache_control.no_stale;
+    self->m_stale_while_revalidate = cache_control.stale_while_revalidate;
+    self->m_stale_if_error = cache_control.stale_if_error;
+    self->m_etag = g_strdup(rp_header_map_find(response_headers, RpCustomHeaderValues.Etag));
+    self->m_last_modified = rp_cache_headers_utils_http_time(
+                                rp_header_map_find(response_headers, RpCustomHeaderValues.LastModified));
+
+    // RFC 9111 section 4.2.3.
+    gint64 date = rp_cache_headers_utils_http_time(rp_header_map_find(response_headers, RpHeaderValues.Date));
+    const char* age_value = rp_header_map_find(response_headers, RpCustomHeaderValues.Age);
+    gint64 age = age_value ? MAX(g_ascii_strtoll(age_value, NULL, 10), 0) : 0;
+    gint64 apparent_age = date >= 0 ? MAX(response_time - date, 0) : 0;
+    gint64 corrected_age = age + MAX(response_time - request_time, 0);
+    self->m_corrected_initial_age = MAX(apparent_age, corrected_age);
+    self->m_response_time = response_time;
+
+    g_atomic_ref_count_init(&self->ref_count);
+    return self;
+}
+
+RpHttpCacheEntry*
+rp_http_cache_entry_new_for_response(evhtp_headers_t* response_headers, gint64 request_time, gint64 response_time, guint64 max_body_size)
+{
+    LOGD("(%p, %" G_GINT64_FORMAT ", %" G_GINT64_FORMAT ", %" G_GUINT64_FORMAT ")", response_headers, request_time, response_time, max_body_size);
+
+    g_return_val_if_fail(response_headers != NULL, NULL);
+
+    RpResponseCacheControl cache_control = rp_response_cache_control_parse(response_headers);
+    if (!rp_cache_headers_utils_is_cacheable_response(response_headers, &cache_control))
+    {
+        NOISY_MSG_("not cacheable");
+        return NULL;
+    }
+    const char* content_length = rp_header_map_get_inline(response_headers, RpInlineHeader_ContentLength);
+    if (content_length && g_ascii_strtoull(content_length, NULL, 10) > max_body_size)
+    {
+        NOISY_MSG_("too large");
+        return NULL;
+    }
+
+    RpHttpCacheEntry* self = rp_http_cache_entry_new(response_headers, request_time, response_time);
+    // No heuristic freshness; a response without an explicit lifetime would
+    // be stale as soon as it was stored.
+    if (self->m_freshness_lifetime <= 0)
+    {
+        NOISY_MSG_("no freshness lifetime");
+        g_clear_pointer(&self, rp_http_cache_entry_unref);
+    }
+    return self;
+}
+
+static inline void
+rp_http_cache_entry_free(RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_if_fail(self != NULL);
+    g_clear_pointer(&self->m_headers, rp_header_map_free);
+    g_clear_pointer(&self->m_body, g_byte_array_unref);
+    g_clear_pointer(&self->m_body_file, evbuffer_file_segment_free);
+    g_clear_pointer(&self->m_etag, g_free);
+    g_free(self);
+}
+
+RpHttpCacheEntry*
+rp_http_cache_entry_ref(RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, NULL);
+    g_atomic_ref_count_inc(&self->ref_count);
+    return self;
+}
+
+void
+rp_http_cache_entry_unref(RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_if_fail(self != NULL);
+    if (g_atomic_ref_count_dec(&self->ref_count))
+    {
+        NOISY_MSG_("freeing %p", self);
+        rp_http_cache_entry_free(self);
+    }
+}
+
+void
+rp_http_cache_entry_append_body(RpHttpCacheEntry* self, evbuf_t* data)
+{
+    LOGD("(%p, %p)", self, data);
+    g_return_if_fail(self != NULL);
+    size_t len = data ? evbuffer_get_length(data) : 0;
+    if (len)
+    {
+        guint offset = self->m_body->len;
+        g_byte_array_set_size(self->m_body, offset + len);
+        evbuffer_copyout(data, self->m_body->data + offset, len);
+    }
+}
+
+static inline gsize
+body_length(const RpHttpCacheEntry* self)
+{
+    return self->m_body_file ? self->m_body_file_length : self->m_body->len;
+}
+
+gsize
+rp_http_cache_entry_body_length(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, 0);
+    return body_length(self);
+}
+
+void
+rp_http_cache_entry_set_body_file(RpHttpCacheEntry* self, struct evbuffer_file_segment* segment, gsize length)
+{
+    LOGD("(%p, %p, %zu)", self, segment, length);
+
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(segment != NULL);
+
+    g_byte_array_set_size(self->m_body, 0);
+    g_clear_pointer(&self->m_body_file, evbuffer_file_segment_free);
+    self->m_body_file = segment;
+    self->m_body_file_length = length;
+}
+
+gsize
+rp_http_cache_entry_size(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, 0);
+    return sizeof(*self) + self->m_headers_size + self->m_body->len;
+}
+
+gint64
+rp_http_cache_entry_age(const RpHttpCacheEntry* self, gint64 now)
+{
+    LOGD("(%p, %" G_GINT64_FORMAT ")", self, now);
+    g_return_val_if_fail(self != NULL, G_MAXINT64);
+    return self->m_corrected_initial_age + MAX(now - self->m_response_time, 0);
+}
+
+gint64
+rp_http_cache_entry_freshness_lifetime(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, 0);
+    return self->m_freshness_lifetime;
+}
+
+bool
+rp_http_cache_entry_no_stale(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, true);
+    return self->m_no_stale;
+}
+
+gint64
+rp_http_cache_entry_stale_while_revalidate(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, -1);
+    return self->m_stale_while_revalidate;
+}
+
+gint64
+rp_http_cache_entry_stale_if_error(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, -1);
+    return self->m_stale_if_error;
+}
+
+const char*
+rp_http_cache_entry_etag(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, NULL);
+    return self->m_etag;
+}
+
+gint64
+rp_http_cache_entry_last_modified(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(self != NULL, -1);
+    return self->m_last_modified;
+}
+
+static inline void
+add_age(evhtp_headers_t* headers, const RpHttpCacheEntry* self, gint64 now)
+{
+    char age[32];
+    int len = g_snprintf(age, sizeof(age), "%" G_GINT64_FORMAT, rp_http_cache_entry_age(self, now));
+    rp_header_map_add_copy(headers, RpCustomHeaderValues.Age, strlen(RpCustomHeaderValues.Age), age, len);
+}
+
+static void
+add_response_headers(const RpHttpCacheEntry* self, evhtp_headers_t* headers, gint64 now)
+{
+    NOISY_MSG_("(%p, %p, %" G_GINT64_FORMAT ")", self, headers, now);
+    evhtp_header_t* header;
+    TAILQ_FOREACH(header, self->m_headers, next)
+    {
+        rp_header_map_add_copy(headers, header->key, header->klen, header->val, header->vlen);
+    }
+    add_age(headers, self, now);
+    if (http_utility_get_response_status(headers) != EVHTP_RES_NOCONTENT)
+    {
+        char content_length[32];
+        int len = g_snprintf(content_length, sizeof(content_length), "%zu", body_length(self));
+        rp_header_map_add_copy(headers,
+                                RpHeaderValues.ContentLength,
+                                strlen(RpHeaderValues.ContentLength),
+                                content_length,
+                                len);
+    }
+}
+
+evhtp_headers_t*
+rp_http_cache_entry_response_headers(const RpHttpCacheEntry* self, gint64 now)
+{
+    LOGD("(%p, %" G_GINT64_FORMAT ")", self, now);
+
+    g_return_val_if_fail(self != NULL, NULL);
+
+    evhtp_headers_t* headers = rp_header_map_new();
+    add_response_headers(self, headers, now);
+    return headers;
+}
+
+void
+rp_http_cache_entry_replace_response_headers(const RpHttpCacheEntry* self, evhtp_headers_t* headers, gint64 now)
+{
+    LOGD("(%p, %p, %" G_GINT64_FORMAT ")", self, headers, now);
+
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(headers != NULL);
+
+    evhtp_header_t* header;
+    while ((header = TAILQ_FIRST(headers)))
+    {
+        rp_header_map_remove(headers, header);
+    }
+    add_response_headers(self, headers, now);
+}
+
+// The headers a 304 must carry if they would have been sent in a 200.
+static inline bool
+is_not_modified_header(const char* key)
+{
+    return g_ascii_strcasecmp(key, RpCustomHeaderValues.CacheControl) == 0 ||
+            g_ascii_strcasecmp(key, "content-location") == 0 ||
+            g_ascii_strcasecmp(key, RpHeaderValues.Date) == 0 ||
+            g_ascii_strcasecmp(key, RpCustomHeaderValues.Etag) == 0 ||
+            g_ascii_strcasecmp(key, RpCustomHeaderValues.Expires) == 0 ||
+            g_ascii_strcasecmp(key, RpCustomHeaderValues.Vary) == 0;
+}
+
+evhtp_headers_t*
+rp_http_cache_entry_not_modified_headers(const RpHttpCacheEntry* self, gint64 now)
+{
+    LOGD("(%p, %" G_GINT64_FORMAT ")", self, now);
+
+    g_return_val_if_fail(self != NULL, NULL);
+
+    evhtp_headers_t* headers = rp_header_map_new();
+    rp_header_map_add_copy(headers, RpHeaderValues.Status, strlen(RpHeaderValues.Status), "304", 3);
+    evhtp_header_t* header;
+    TAILQ_FOREACH(header, self->m_headers, next)
+    {
+        if (is_not_modified_header(header->key))
+        {
+            rp_header_map_add_copy(headers, header->key, header->klen, header->val, header->vlen);
+        }
+    }
+    add_age(headers, self, now);
+    return headers;
+}
+
+static void
+body_cleanup_cb(const void* data G_GNUC_UNUSED, size_t len G_GNUC_UNUSED, void* arg)
+{
+    NOISY_MSG_("(%p, %zu, %p)", data, len, arg);
+    rp_http_cache_entry_unref(arg);
+}
+
+evbuf_t*
+rp_http_cache_entry_body(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+
+    g_return_val_if_fail(self != NULL, NULL);
+
+    evbuf_t* body = evbuffer_new();
+    if (self->m_body_file)
+    {
+        // Written to the socket with sendfile() where the transport allows.
+        if (self->m_body_file_length)
+        {
+            evbuffer_add_file_segment(body, self->m_body_file, 0, self->m_body_file_length);
+        }
+    }
+    else if (self->m_body->len)
+    {
+        // Stored entries are immutable, so the body is referenced rather than
+        // copied for every hit.
+        RpHttpCacheEntry* entry = rp_http_cache_entry_ref((RpHttpCacheEntry*)self);
+        evbuffer_add_reference(body, self->m_body->data, self->m_body->len, body_cleanup_cb, entry);
+    }
+    return body;
+}
+
+// Metadata layout: response time and corrected initial age, each a native
+// gint64, followed by NUL terminated name and value pairs.
+GBytes*
+rp_http_cache_entry_serialize(const RpHttpCacheEntry* self)
+{
+    LOGD("(%p)", self);
+
+    g_return_val_if_fail(self != NULL, NULL);
+
+    GByteArray* data = g_byte_array_sized_new(2 * sizeof(gint64) + self->m_headers_size);
+    g_byte_array_append(data, (const guint8*)&self->m_response_time, sizeof(gint64));
+    g_byte_array_append(data, (const guint8*)&self->m_corrected_initial_age, sizeof(gint64));
+    evhtp_header_t* header;
+    TAILQ_FOREACH(header, self->m_headers, next)
+    {
+        g_byte_array_append(data, (const guint8*)header->key, header->klen + 1);
+        g_byte_array_append(data, (const guint8*)header->val, header->vlen + 1);
+    }
+    return g_byte_array_free_to_bytes(data);
+}
+
+RpHttpCacheEntry*
+rp_http_cache_entry_deserialize(const guint8* data, gsize len)
+{
+    LOGD("(%p, %zu)", data, len);
+
+    g_return_val_if_fail(data != NULL, NULL);
+
+    if (len < 2 * sizeof(gint64))
+    {
+        NOISY_MSG_("truncated");
+        return NULL;
+    }
+    gint64 response_time;
+    gint64 corrected_initial_age;
+    memcpy(&response_time, data, sizeof(gint64));
+    memcpy(&corrected_initial_age, data + sizeof(gint64), sizeof(gint64));
+
+    evhtp_headers_t* headers = rp_header_map_new();
+    const char* itr = (const char*)data + 2 * sizeof(gint64);
+    const char* end = (const char*)data + len;
+    while (itr < end)
+    {
+        const char* key = itr;
+        const char* key_end = memchr(key, '\0', end - key);
+        const char* val = key_end ? key_end + 1 : end;
+        const char* val_end = val < end ? memchr(val, '\0', end - val) : NULL;
+        if (!val_end)
+        {
+            NOISY_MSG_("malformed header");
+            rp_header_map_free(headers);
+            return NULL;
+        }
+        rp_header_map_add_copy(headers, key, key_end - key, val, val_end - val);
+        itr = val_end + 1;
+    }
+
+    RpHttpCacheEntry* self = rp_http_cache_entry_new(headers, response_time, response_time);
+    self->m_corrected_initial_age = corrected_initial_age;
+    rp_header_map_free(headers);
+    return self;
+}
+
+typedef struct _RpHttpCacheVariants RpHttpCacheVariants;
+struct _RpHttpCacheVariants {
+    char* m_vary; // Vary of the stored variants; NULL if none.
+    GSList* m_items;
+};
+
+typedef struct _RpHttpCacheItem RpHttpCacheItem;
+struct _RpHttpCacheItem {
+    char* m_key;
+    char* m_base_key;
+    RpHttpCacheEntry* m_entry;
+};
+
+typedef struct _RpHttpCacheShard RpHttpCacheShard;
+struct _RpHttpCacheShard {
+    GMutex m_lock;
+    GHashTable* m_entries;  // variant key -> GList* in m_lru
+    GHashTable* m_variants; // base key -> RpHttpCacheVariants*
+    GHashTable* m_refreshing; // base keys with a background refresh in flight
+    GQueue m_lru;           // RpHttpCacheItem*, most recently used first
+    guint64 m_size;
+    guint64 m_max_size;
+    // Entries with larger bodies go to the disk tier.
+    guint64 m_max_entry_size;
+};
+
+struct _RpHttpCache {
+    GObject parent_instance;
+
+    RpHttpCacheShard m_shards[RP_HTTP_CACHE_SHARDS];
+    // Set once, under the http_cache lock; read without it.
+    RpDiskCache* m_disk;
+};
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpHttpCache, rp_http_cache, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_SINGLETON_INSTANCE, NULL)
+)
+
+static void
+variants_free(gpointer arg)
+{
+    NOISY_MSG_("(%p)", arg);
+    RpHttpCacheVariants* variants = arg;
+    g_free(variants->m_vary);
+    g_slist_free(variants->m_items);
+    g_free(variants);
+}
+
+static void
+item_free(RpHttpCacheItem* item)
+{
+    NOISY_MSG_("(%p)", item);
+    g_free(item->m_key);
+    g_free(item->m_base_key);
+    rp_http_cache_entry_unref(item->m_entry);
+    g_free(item);
+}
+
+static inline RpHttpCacheShard*
+shard_for(RpHttpCache* self, const char* base_key)
+{
+    // Every variant of a key lives in the same shard.
+    return &self->m_shards[g_str_hash(base_key) % RP_HTTP_CACHE_SHARDS];
+}
+
+static RpHttpCacheItem*
+shard_unlink_node(RpHttpCacheShard* shard, GList* node)
+{
+    NOISY_MSG_("(%p, %p)", shard, node);
+    RpHttpCacheItem* item = node->data;
+    RpHttpCacheVariants* variants = g_hash_table_lookup(shard->m_variants, item->m_base_key);
+    if (variants)
+    {
+        variants->m_items = g_slist_remove(variants->m_items, item);
+        if (!variants->m_items)
+        {
+            g_hash_table_remove(shard->m_variants, item->m_base_key);
+        }
+    }
+    g_hash_table_remove(shard->m_entries, item->m_key);
+    g_queue_delete_link(&shard->m_lru, node);
+    shard->m_size -= rp_http_cache_entry_size(item->m_entry);
+    return item;
+}
+
+static inline void
+shard_remove_node(RpHttpCacheShard* shard, GList* node)
+{
+    item_free(shard_unlink_node(shard, node));
+}
+
+static void
+shard_remove_variants(RpHttpCacheShard* shard, const char* base_key)
+{
+    NOISY_MSG_("(%p, %p(%s))", shard, base_key, base_key);
+    RpHttpCacheVariants* variants;
+    while ((variants = g_hash_table_lookup(shard->m_variants, base_key)))
+    {
+        RpHttpCacheItem* item = variants->m_items->data;
+        shard_remove_node(shard, g_hash_table_lookup(shard->m_entries, item->m_key));
+    }
+}
+
+// Evicted items are handed back in |evicted| so they can be demoted to the
+// disk tier once the shard lock is released.
+static void
+shard_evict(RpHttpCacheShard* shard, GSList** evicted)
+{
+    NOISY_MSG_("(%p, %p)", shard, evicted);
+    while (shard->m_size > shard->m_max_size && !g_queue_is_empty(&shard->m_lru))
+    {
+        NOISY_MSG_("evicting, size %lu, max size %lu", shard->m_size, shard->m_max_size);
+        *evicted = g_slist_prepend(*evicted, shard_unlink_node(shard, g_queue_peek_tail_link(&shard->m_lru)));
+    }
+}
+
+static void
+shard_init(RpHttpCacheShard* shard, guint64 max_size)
+{
+    NOISY_MSG_("(%p, %lu)", shard, max_size);
+    g_mutex_init(&shard->m_lock);
+    shard->m_entries = g_hash_table_new(g_str_hash, g_str_equal);
+    shard->m_variants = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, variants_free);
+    shard->m_refreshing = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    g_queue_init(&shard->m_lru);
+    shard->m_max_size = max_size;
+    shard->m_max_entry_size = G_MAXUINT64;
+}
+
+static void
+shard_clear(RpHttpCacheShard* shard)
+{
+    NOISY_MSG_("(%p)", shard);
+    g_clear_pointer(&shard->m_variants, g_hash_table_unref);
+    g_clear_pointer(&shard->m_refreshing, g_hash_table_unref);
+    g_clear_pointer(&shard->m_entries, g_hash_table_unref);
+    RpHttpCacheItem* item;
+    while ((item = g_queue_pop_head(&shard->m_lru)))
+    {
+        item_free(item);
+    }
+    shard->m_size = 0;
+    g_mutex_clear(&shard->m_lock);
+}
+
+static inline RpDiskCache*
+disk_tier(RpHttpCache* self)
+{
+    return g_atomic_pointer_get(&self->m_disk);
+}
+
+static void
+demote(RpHttpCache* self, GSList* items)
+{
+    NOISY_MSG_("(%p, %p)", self, items);
+    RpDiskCache* disk = disk_tier(self);
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    for (GSList* itr = items; itr; itr = itr->next)
+    {
+        RpHttpCacheItem* item = itr->data;
+        RpHttpCacheEntry* entry = item->m_entry;
+        // Stale entries would only be served within a stale window; they are
+        // not worth the disk write.
+        if (disk && rp_http_cache_entry_age(entry, now) < entry->m_freshness_lifetime)
+        {
+            rp_disk_cache_insert(disk,
+                                    item->m_base_key,
+                                    rp_header_map_find(entry->m_headers, RpCustomHeaderValues.Vary),
+                                    item->m_key,
+                                    entry);
+        }
+        item_free(item);
+    }
+    g_slist_free(items);
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpHttpCache* self = RP_HTTP_CACHE(obj);
+    for (guint i = 0; i < RP_HTTP_CACHE_SHARDS; ++i)
+    {
+        if (self->m_shards[i].m_entries)
+        {
+            shard_clear(&self->m_shards[i]);
+        }
+    }
+    g_clear_object(&self->m_disk);
+
+    G_OBJECT_CLASS(rp_http_cache_parent_class)->dispose(obj);
+}
+
+static void
+rp_http_cache_class_init(RpHttpCacheClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_http_cache_init(RpHttpCache* self)
+{
+    NOISY_MSG_("(%p)", self);
+    for (guint i = 0; i < RP_HTTP_CACHE_SHARDS; ++i)
+    {
+        shard_init(&self->m_shards[i], RP_HTTP_CACHE_DEFAULT_MAX_SIZE / RP_HTTP_CACHE_SHARDS);
+    }
+}
+
+RpHttpCache*
+rp_http_cache_new(void)
+{
+    LOGD("()");
+    return g_object_new(RP_TYPE_HTTP_CACHE, NULL);
+}
+
+static RpSingletonInstanceSharedPtr
+singleton_factory_cb(void)
+{
+    NOISY_MSG_("()");
+    return RP_SINGLETON_INSTANCE(rp_http_cache_new());
+}
+
+RpHttpCache*
+rp_http_cache_singleton_get(RpSingletonManager* singleton_manager)
+{
+    LOGD("(%p)", singleton_manager);
+
+    g_return_val_if_fail(RP_IS_SINGLETON_MANAGER(singleton_manager), NULL);
+
+    G_LOCK(http_cache);
+    RpHttpCache* self = RP_HTTP_CACHE(
+        rp_singleton_manager_get(singleton_manager,
+                                    SINGLETON_MANAGER_REGISTERED_NAME(http_cache),
+                                    singleton_factory_cb,
+                                    true));
+    G_UNLOCK(http_cache);
+    return self;
+}
+
+void
+rp_http_cache_set_max_size(RpHttpCache* self, guint64 max_size_bytes)
+{
+    LOGD("(%p, %lu)", self, max_size_bytes);
+
+    g_return_if_fail(RP_IS_HTTP_CACHE(self));
+
+    for (guint i = 0; i < RP_HTTP_CACHE_SHARDS; ++i)
+    {
+        GSList* evicted = NULL;
+        RpHttpCacheShard* shard = &self->m_shards[i];
+        g_mutex_lock(&shard->m_lock);
+        shard->m_max_size = max_size_bytes / RP_HTTP_CACHE_SHARDS;
+        shard_evict(shard, &evicted);
+        g_mutex_unlock(&shard->m_lock);
+        demote(self, evicted);
+    }
+}
+
+void
+rp_http_cache_set_max_entry_size(RpHttpCache* self, guint64 max_entry_size_bytes)
+{
+    LOGD("(%p, %" G_GUINT64_FORMAT ")", self, max_entry_size_bytes);
+
+    g_return_if_fail(RP_IS_HTTP_CACHE(self));
+
+    for (guint i = 0; i < RP_HTTP_CACHE_SHARDS; ++i)
+    {
+        RpHttpCacheShard* shard = &self->m_shards[i];
+        g_mutex_lock(&shard->m_lock);
+        shard->m_max_entry_size = max_entry_size_bytes;
+        g_mutex_unlock(&shard->m_lock);
+    }
+}
+
+bool
+rp_http_cache_enable_disk_tier(RpHttpCache* self, const char* path, guint64 size_bytes, guint64 max_entry_size_bytes)
+{
+    LOGD("(%p, %p(%s), %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ")",
+        self, path, path, size_bytes, max_entry_size_bytes);
+
+    g_return_val_if_fail(RP_IS_HTTP_CACHE(self), false);
+    g_return_val_if_fail(path != NULL, false);
+
+    // Every worker's filter factory gets here; only the first opens the file.
+    G_LOCK(http_cache);
+    if (!self->m_disk)
+    {
+        g_atomic_pointer_set(&self->m_disk, rp_disk_cache_new(path, size_bytes, max_entry_size_bytes));
+    }
+    bool enabled = self->m_disk != NULL;
+    G_UNLOCK(http_cache);
+    return enabled;
+}
+
+RpHttpCacheEntry*
+rp_http_cache_lookup(RpHttpCache* self, const char* key, evhtp_headers_t* request_headers)
+{
+    LOGD("(%p, %p(%s), %p)", self, key, key, request_headers);
+
+    g_return_val_if_fail(RP_IS_HTTP_CACHE(self), NULL);
+    g_return_val_if_fail(key != NULL, NULL);
+
+    RpHttpCacheEntry* entry = NULL;
+    RpHttpCacheShard* shard = shard_for(self, key);
+    g_mutex_lock(&shard->m_lock);
+    RpHttpCacheVariants* variants = g_hash_table_lookup(shard->m_variants, key);
+    if (variants)
+    {
+        g_autofree char* variant = rp_cache_headers_utils_variant_key(key, variants->m_vary, request_headers);
+        GList* node = g_hash_table_lookup(shard->m_entries, variant);
+        if (node)
+        {
+            g_queue_unlink(&shard->m_lru, node);
+            g_queue_push_head_link(&shard->m_lru, node);
+            entry = rp_http_cache_entry_ref(((RpHttpCacheItem*)node->data)->m_entry);
+        }
+    }
+    g_mutex_unlock(&shard->m_lock);
+
+    RpDiskCache* disk = disk_tier(self);
+    if (!entry && disk)
+    {
+        // Not promoted; what is read back from the disk tier stays in the
+        // page cache while it is hot.
+        entry = rp_disk_cache_lookup(disk, key, request_headers);
+    }
+    NOISY_MSG_("entry %p", entry);
+    return entry;
+}
+
+void
+rp_http_cache_insert(RpHttpCache* self, const char* key, evhtp_headers_t* request_headers, RpHttpCacheEntry* entry)
+{
+    LOGD("(%p, %p(%s), %p, %p)", self, key, key, request_headers, entry);
+
+    g_return_if_fail(RP_IS_HTTP_CACHE(self));
+    g_return_if_fail(key != NULL);
+    g_return_if_fail(entry != NULL);
+
+    const char* vary = rp_header_map_find(entry->m_headers, RpCustomHeaderValues.Vary);
+    g_autofree char* variant = rp_cache_headers_utils_variant_key(key, vary, request_headers);
+    gsize size = rp_http_cache_entry_size(entry);
+    RpHttpCacheShard* shard = shard_for(self, key);
+    g_mutex_lock(&shard->m_lock);
+
+    if (size > shard->m_max_size || body_length(entry) > shard->m_max_entry_size)
+    {
+        NOISY_MSG_("entry of %zu bytes too large", size);
+        shard_remove_variants(shard, key);
+        g_mutex_unlock(&shard->m_lock);
+        RpDiskCache* disk = disk_tier(self);
+        if (disk)
+        {
+            rp_disk_cache_insert(disk, key, vary, variant, entry);
+        }
+        return;
+    }
+
+    // Variant keys are built from the stored Vary; when the origin changes it
+    // the existing variants can no longer be selected.
+    RpHttpCacheVariants* variants = g_hash_table_lookup(shard->m_variants, key);
+    if (variants && g_strcmp0(variants->m_vary, vary) != 0)
+    {
+        shard_remove_variants(shard, key);
+        variants = NULL;
+    }
+
+    RpHttpCacheItem* item = g_new0(RpHttpCacheItem, 1);
+    item->m_key = g_steal_pointer(&variant);
+    item->m_base_key = g_strdup(key);
+    item->m_entry = rp_http_cache_entry_ref(entry);
+
+    GList* existing = g_hash_table_lookup(shard->m_entries, item->m_key);
+    if (existing)
+    {
+        shard_remove_node(shard, existing);
+        variants = g_hash_table_lookup(shard->m_variants, key);
+    }
+    if (!variants)
+    {
+        variants = g_new0(RpHttpCacheVariants, 1);
+        variants->m_vary = g_strdup(vary);
+        g_hash_table_insert(shard->m_variants, g_strdup(key), variants);
+    }
+    variants->m_items = g_slist_prepend(variants->m_items, item);
+
+    g_queue_push_head(&shard->m_lru, item);
+    g_hash_table_insert(shard->m_entries, item->m_key, g_queue_peek_head_link(&shard->m_lru));
+    shard->m_size += size;
+    GSList* evicted = NULL;
+    shard_evict(shard, &evicted);
+
+    g_mutex_unlock(&shard->m_lock);
+    demote(self, evicted);
+}
+
+void
+rp_http_cache_invalidate(RpHttpCache* self, const char* key)
+{
+    LOGD("(%p, %p(%s))", self, key, key);
+
+    g_return_if_fail(RP_IS_HTTP_CACHE(self));
+    g_return_if_fail(key != NULL);
+
+    RpHttpCacheShard* shard = shard_for(self, key);
+    g_mutex_lock(&shard->m_lock);
+    shard_remove_variants(shard, key);
+    g_mutex_unlock(&shard->m_lock);
+
+    RpDiskCache* disk = disk_tier(self);
+    if (disk)
+    {
+        rp_disk_cache_invalidate(disk, key);
+    }
+}
+
+bool
+rp_http_cache_begin_refresh(RpHttpCache* self, const char* key)
+{
+    LOGD("(%p, %p(%s))", self, key, key);
+
+    g_return_val_if_fail(RP_IS_HTTP_CACHE(self), false);
+    g_return_val_if_fail(key != NULL, false);
+
+    RpHttpCacheShard* shard = shard_for(self, key);
+    g_mutex_lock(&shard->m_lock);
+    bool begun = g_hash_table_add(shard->m_refreshing, g_strdup(key));
+    g_mutex_unlock(&shard->m_lock);
+    NOISY_MSG_("begun %u", begun);
+    return begun;
+}
+
+void
+rp_http_cache_end_refresh(RpHttpCache* self, const char* key)
+{
+    LOGD("(%p, %p(%s))", self, key, key);
+
+    g_return_if_fail(RP_IS_HTTP_CACHE(self));
+    g_return_if_fail(key != NULL);
+
+    RpHttpCacheShard* shard = shard_for(self, key);
+    g_mutex_lock(&shard->m_lock);
+    g_hash_table_remove(shard->m_refreshing, key);
+    g_mutex_unlock(&shard->m_lock);
+}
@@ -0,0 +1,152 @@
+/*
+ * rp-http-cache.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <evhtp.h>
+#include "rp-singleton-manager.h"
+
+G_BEGIN_DECLS
+
+/**
+ * A stored response. Entries are immutable once inserted into the cache and
+ * are shared, by reference, between the cache and the streams serving them.
+ */
+typedef struct _RpHttpCacheEntry RpHttpCacheEntry;
+
+RpHttpCacheEntry* rp_http_cache_entry_new(evhtp_headers_t* response_headers,
+                                            gint64 request_time,
+                                            gint64 response_time);
+/**
+ * @return a new entry for a response the cache may store, or NULL if it is
+ *         not cacheable, has no explicit freshness lifetime or announces a
+ *         body larger than |max_body_size|.
+ */
+RpHttpCacheEntry* rp_http_cache_entry_new_for_response(evhtp_headers_t* response_headers,
+                                                        gint64 request_time,
+                                                        gint64 response_time,
+                                                        guint64 max_body_size);
+RpHttpCacheEntry* rp_http_cache_entry_ref(RpHttpCacheEntry* self);
+void rp_http_cache_entry_unref(RpHttpCacheEntry* self);
+void rp_http_cache_entry_append_body(RpHttpCacheEntry* self, evbuf_t* data);
+/**
+ * @return the memory held by the entry; a body in the disk tier is not counted.
+ */
+gsize rp_http_cache_entry_size(const RpHttpCacheEntry* self);
+gsize rp_http_cache_entry_body_length(const RpHttpCacheEntry* self);
+/**
+ * Backs the body by |segment|, a range of the disk tier's file, instead of
+ * memory; the entry takes ownership of the segment.
+ */
+void rp_http_cache_entry_set_body_file(RpHttpCacheEntry* self,
+                                        struct evbuffer_file_segment* segment,
+                                        gsize length);
+/**
+ * @return the current age of the entry in seconds (RFC 9111 section 4.2.3).
+ */
+gint64 rp_http_cache_entry_age(const RpHttpCacheEntry* self, gint64 now);
+gint64 rp_http_cache_entry_freshness_lifetime(const RpHttpCacheEntry* self);
+bool rp_http_cache_entry_no_stale(const RpHttpCacheEntry* self);
+/**
+ * @return the stale-while-revalidate and stale-if-error windows given by the
+ *         origin, or -1 if it gave none.
+ */
+gint64 rp_http_cache_entry_stale_while_revalidate(const RpHttpCacheEntry* self);
+gint64 rp_http_cache_entry_stale_if_error(const RpHttpCacheEntry* self);
+const char* rp_http_cache_entry_etag(const RpHttpCacheEntry* self);
+gint64 rp_http_cache_entry_last_modified(const RpHttpCacheEntry* self);
+/**
+ * @return a new header map for serving the entry, with Age and Content-Length
+ *         set; ownership is transferred to the caller.
+ */
+evhtp_headers_t* rp_http_cache_entry_response_headers(const RpHttpCacheEntry* self, gint64 now);
+/**
+ * Replaces the contents of |headers| with those for serving the entry.
+ */
+void rp_http_cache_entry_replace_response_headers(const RpHttpCacheEntry* self,
+                                                    evhtp_headers_t* headers,
+                                                    gint64 now);
+/**
+ * @return a new 304 header map for answering a conditional request that
+ *         matched the entry (RFC 9110 section 15.4.5).
+ */
+evhtp_headers_t* rp_http_cache_entry_not_modified_headers(const RpHttpCacheEntry* self, gint64 now);
+/**
+ * @return a new buffer holding a copy of the body; ownership is transferred to
+ *         the caller.
+ */
+evbuf_t* rp_http_cache_entry_body(const RpHttpCacheEntry* self);
+/**
+ * Everything but the body, in a form the disk tier can store and read back
+ * after a restart.
+ */
+GBytes* rp_http_cache_entry_serialize(const RpHttpCacheEntry* self);
+RpHttpCacheEntry* rp_http_cache_entry_deserialize(const guint8* data, gsize len);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(RpHttpCacheEntry, rp_http_cache_entry_unref)
+
+// The cache's size limits are split evenly between its shards.
+#define RP_HTTP_CACHE_SHARDS 16
+
+/**
+ * A process-wide, memory-bounded response store shared by every worker. Keys
+ * are spread over a fixed number of shards, each with its own lock and LRU
+ * list, so that workers rarely contend. Responses carrying Vary are stored
+ * under a secondary key built from the named request headers. An optional
+ * disk tier holds large entries and those evicted from memory.
+ */
+#define RP_TYPE_HTTP_CACHE rp_http_cache_get_type()
+G_DECLARE_FINAL_TYPE(RpHttpCache, rp_http_cache, RP, HTTP_CACHE, GObject)
+
+RpHttpCache* rp_http_cache_new(void);
+/**
+ * @return the process-wide cache, created on first use; the singleton manager
+ *         retains ownership.
+ */
+RpHttpCache* rp_http_cache_singleton_get(RpSingletonManager* singleton_manager);
+void rp_http_cache_set_max_size(RpHttpCache* self, guint64 max_size_bytes);
+/**
+ * Entries with bodies larger than |max_entry_size_bytes| skip the memory tier
+ * and go straight to the disk tier, if there is one.
+ */
+void rp_http_cache_set_max_entry_size(RpHttpCache* self, guint64 max_entry_size_bytes);
+/**
+ * Adds a disk tier backed by the file at |path|. Entries evicted from memory
+ * while still fresh are demoted to it, and lookups that miss in memory fall
+ * through to it. Only the first call has any effect.
+ * @return true if the disk tier is in place.
+ */
+bool rp_http_cache_enable_disk_tier(RpHttpCache* self,
+                                    const char* path,
+                                    guint64 size_bytes,
+                                    guint64 max_entry_size_bytes);
+/**
+ * @return a new reference to the entry stored for |key| that the request's
+ *         Vary headers select, or NULL.
+ */
+RpHttpCacheEntry* rp_http_cache_lookup(RpHttpCache* self,
+                                        const char* key,
+                                        evhtp_headers_t* request_headers);
+void rp_http_cache_insert(RpHttpCache* self,
+                            const char* key,
+                            evhtp_headers_t* request_headers,
+                            RpHttpCacheEntry* entry);
+/**
+ * Removes every variant stored for |key|.
+ */
+void rp_http_cache_invalidate(RpHttpCache* self, const char* key);
+/**
+ * Claims the background refresh of |key| so that only one is in flight
+ * across all workers.
+ * @return false if another refresh of |key| is already in flight.
+ */
+bool rp_http_cache_begin_refresh(RpHttpCache* self, const char* key);
+void rp_http_cache_end_refresh(RpHttpCache* self, const char* key);
+
+G_END_DECLS
@@ -56,6 +56,7 @@ static cfg_opt_t       ssl_opts[] = {
     CFG_BOOL("cache-enabled",     cfg_true,        CFGF_NONE),
     CFG_INT("cache-timeout",      1024,            CFGF_NONE),
     CFG_INT("cache-size",         65535,           CFGF_NONE),
+    CFG_BOOL("ktls",              cfg_false,       CFGF_NONE),
     CFG_SEC("crl",                ssl_crl_opts,    CFGF_NODEFAULT|CFGF_IGNORE_UNKNOWN),
     CFG_END()
 };
@@ -85,6 +86,7 @@ static cfg_opt_t       upstream_opts[] = {
     CFG_INT_LIST("read-timeout",  "{ 0, 0 }",     CFGF_NONE),
     CFG_INT_LIST("write-timeout", "{ 0, 0 }",     CFGF_NONE),
     CFG_INT_LIST("retry",         "{ 0, 50000 }", CFGF_NONE),
+    CFG_STR("io-handle",          "bufferevent",  CFGF_NONE),
     CFG_END()
 };
 
@@ -153,6 +155,32 @@ static cfg_opt_t       cluster_type_opts[] = {
     CFG_END()
 };
 
+static cfg_opt_t       outlier_detection_opts[] = {
+    CFG_INT("consecutive-5xx",                  5,            CFGF_NONE),
+    CFG_INT("consecutive-gateway-failure",      5,            CFGF_NONE),
+    CFG_INT("consecutive-local-origin-failure", 5,            CFGF_NONE),
+    CFG_INT_LIST("interval",                    "{ 10, 0 }",  CFGF_NONE),
+    CFG_INT_LIST("base-ejection-time",          "{ 30, 0 }",  CFGF_NONE),
+    CFG_INT_LIST("max-ejection-time",           "{ 300, 0 }", CFGF_NONE),
+    CFG_INT("max-ejection-percent",             10,           CFGF_NONE),
+    CFG_INT("success-rate-minimum-hosts",       5,            CFGF_NONE),
+    CFG_INT("success-rate-request-volume",      100,          CFGF_NONE),
+    CFG_FLOAT("success-rate-stdev-factor",      1.9,          CFGF_NONE),
+    CFG_FLOAT("latency-threshold-factor",       3.0,          CFGF_NONE),
+    CFG_END()
+};
+
+static cfg_opt_t       health_check_opts[] = {
+    CFG_STR("type",                             "http",       CFGF_NONE),
+    CFG_STR("path",                             "/",          CFGF_NONE),
+    CFG_INT_LIST("interval",                    "{ 5, 0 }",   CFGF_NONE),
+    CFG_INT_LIST("interval-jitter",             "{ 1, 0 }",   CFGF_NONE),
+    CFG_INT_LIST("timeout",                     "{ 1, 0 }",   CFGF_NONE),
+    CFG_INT("unhealthy-threshold",              3,            CFGF_NONE),
+    CFG_INT("healthy-threshold",                2,            CFGF_NONE),
+    CFG_END()
+};
+
 static cfg_opt_t       rule_opts[] = {
     CFG_STR("uri-match",                   NULL,              CFGF_NODEFAULT),
     CFG_STR("uri-gmatch",                  NULL,              CFGF_NODEFAULT),
@@ -168,6 +196,19 @@ static cfg_opt_t       rule_opts[] = {
     CFG_BOOL("passthrough",                cfg_false,         CFGF_NONE),
     CFG_BOOL("allow-redirect",             cfg_false,         CFGF_NONE),
     CFG_STR_LIST("redirect-filter",        NULL,              CFGF_NODEFAULT),
+    CFG_BOOL("upstream-http2",             cfg_false,         CFGF_NONE),
+    CFG_INT("max-concurrent-streams",      100,               CFGF_NONE),
+    CFG_BOOL("happy-eyeballs",             cfg_false,         CFGF_NONE),
+    CFG_INT_LIST("hedge-delay",            "{ 0, 0 }",        CFGF_NONE),
+    CFG_BOOL("collapsed-forwarding",       cfg_false,         CFGF_NONE),
+    CFG_INT("num-retries",                 0,                 CFGF_NONE),
+    CFG_STR_LIST("retry-on",               "{ connect-failure, reset, 5xx }", CFGF_NONE),
+    CFG_INT_LIST("per-try-timeout",        "{ 0, 0 }",        CFGF_NONE),
+    CFG_INT_LIST("retry-backoff",          "{ 0, 25000 }",    CFGF_NONE),
+    CFG_FLOAT("retry-budget",              0.0,               CFGF_NONE),
+    CFG_INT("retry-budget-min-concurrency", 3,                CFGF_NONE),
+    CFG_SEC("outlier-detection",           outlier_detection_opts, CFGF_NODEFAULT),
+    CFG_SEC("health-check",                health_check_opts, CFGF_NODEFAULT),
     CFG_END()
 };
 
@@ -192,6 +233,7 @@ static cfg_opt_t       server_opts[] = {
     CFG_INT("high-watermark",            0,               CFGF_NONE),
     CFG_INT("max-pending",               0,               CFGF_NONE),
     CFG_INT("backlog",                   1024,            CFGF_NONE),
+    CFG_INT("ssl-handshake-threads",     0,               CFGF_NONE),
     CFG_SEC("upstream",                  upstream_opts,   CFGF_MULTI | CFGF_TITLE | CFGF_NO_TITLE_DUPES),
     CFG_SEC("vhost",                     vhost_opts,      CFGF_MULTI | CFGF_TITLE | CFGF_NO_TITLE_DUPES),
     CFG_SEC("ssl",                       ssl_opts,        CFGF_NODEFAULT|CFGF_IGNORE_UNKNOWN),
@@ -200,6 +242,12 @@ static cfg_opt_t       server_opts[] = {
     CFG_BOOL("disable-client-nagle",     cfg_false,       CFGF_NONE),
     CFG_BOOL("disable-upstream-nagle",   cfg_false,       CFGF_NONE),
     CFG_BOOL("enable-workers-listen",    cfg_false,       CFGF_NONE),
+    CFG_BOOL("enable-fast-http-parser",  cfg_false,       CFGF_NONE),
+    CFG_BOOL("enable-http2",             cfg_false,       CFGF_NONE),
+    CFG_BOOL("coalesce-writes",          cfg_false,       CFGF_NONE),
+    CFG_BOOL("cork-writes",              cfg_false,       CFGF_NONE),
+    CFG_BOOL("ssl-dynamic-records",      cfg_false,       CFGF_NONE),
+    CFG_STR("io-handle",                 "bufferevent",   CFGF_NONE),
     CFG_SEC("rule",                      rule_opts,       CFGF_TITLE | CFGF_MULTI | CFGF_NO_TITLE_DUPES),
     CFG_END()
 };
@@ -247,6 +295,8 @@ static void x509_ext_cfg_free(gpointer arg);
 static void rule_cfg_free(gpointer arg);
 static void server_cfg_free(gpointer arg);
 static void cluster_type_cfg_free(cluster_type_cfg_t* self);
+static void outlier_detection_cfg_free(outlier_detection_cfg_t* self);
+static void health_check_cfg_free(health_check_cfg_t* self);
 static void upstream_cfg_free(gpointer arg);
 
 /**
@@ -346,6 +396,38 @@ discovery_type_str_to_discovery_type(const char* str)
     return discovery_type_static;
 }
 
+static int
+retry_on_str_to_retry_on(const char* str)
+{
+    LOGD("(%p(%s))", str, str);
+
+    if (!str)
+    {
+        LOGD("str is null");
+        return 0;
+    }
+
+    if (g_ascii_strcasecmp(str, "connect-failure") == 0)
+    {
+        LOGD("connect-failure");
+        return retry_on_connect_failure;
+    }
+
+    if (g_ascii_strcasecmp(str, "reset") == 0)
+    {
+        LOGD("reset");
+        return retry_on_reset;
+    }
+
+    if (g_ascii_strcasecmp(str, "5xx") == 0)
+    {
+        LOGD("5xx");
+        return retry_on_5xx;
+    }
+
+    return 0;
+}
+
 logger_cfg_t*
 logger_cfg_new(void)
 {
@@ -549,6 +631,8 @@ rule_cfg_free(gpointer arg)
     g_slist_free_full(g_steal_pointer(&cfg->redirect_filter), g_free);
     g_clear_pointer(&cfg->name, g_free);
     g_clear_pointer(&cfg->cluster_type, cluster_type_cfg_free);
+    g_clear_pointer(&cfg->outlier_detection, outlier_detection_cfg_free);
+    g_clear_pointer(&cfg->health_check, health_check_cfg_free);
     g_free(cfg);
 }
 
@@ -919,6 +1003,20 @@ ssl_cfg_parse(cfg_t* cfg)
         }
     }
 
+    if (cfg_getbool(cfg, "ktls") == cfg_true)
+    {
+#ifdef SSL_OP_ENABLE_KTLS
+        /* OpenSSL hands record encryption to the kernel after the handshake,
+         * per direction, whenever the negotiated cipher is one the kernel
+         * supports; anything else stays in user space.
+         */
+        LOGD("ktls enabled");
+        ssl_opts |= SSL_OP_ENABLE_KTLS;
+#else
+        LOGI("ktls requested but OpenSSL was built without ktls support");
+#endif
+    }
+
     scfg->ssl_ctx_timeout = cfg_getint(cfg, "context-timeout");
     scfg->ssl_opts        = ssl_opts;
 
@@ -1240,6 +1338,141 @@ cluster_type_cfg_parse(cfg_t* cfg)
     return self;
 }
 
+outlier_detection_cfg_t*
+outlier_detection_cfg_new(void)
+{
+    LOGD("()");
+    outlier_detection_cfg_t* self = g_new0(outlier_detection_cfg_t, 1);
+    return self;
+}
+
+void
+outlier_detection_cfg_free(outlier_detection_cfg_t* self)
+{
+    LOGD("(%p)", self);
+    g_free(self);
+}
+
+outlier_detection_cfg_t*
+outlier_detection_cfg_parse(cfg_t* cfg)
+{
+    LOGD("(%p)", cfg);
+
+    g_return_val_if_fail(cfg != NULL, NULL);
+
+    outlier_detection_cfg_t* self = outlier_detection_cfg_new();
+    self->consecutive_5xx = cfg_getint(cfg, "consecutive-5xx");
+    self->consecutive_gateway_failure = cfg_getint(cfg, "consecutive-gateway-failure");
+    self->consecutive_local_origin_failure = cfg_getint(cfg, "consecutive-local-origin-failure");
+    self->interval.tv_sec = cfg_getnint(cfg, "interval", 0);
+    self->interval.tv_usec = cfg_getnint(cfg, "interval", 1);
+    self->base_ejection_time.tv_sec = cfg_getnint(cfg, "base-ejection-time", 0);
+    self->base_ejection_time.tv_usec = cfg_getnint(cfg, "base-ejection-time", 1);
+    self->max_ejection_time.tv_sec = cfg_getnint(cfg, "max-ejection-time", 0);
+    self->max_ejection_time.tv_usec = cfg_getnint(cfg, "max-ejection-time", 1);
+    self->max_ejection_percent = cfg_getint(cfg, "max-ejection-percent");
+    self->success_rate_minimum_hosts = cfg_getint(cfg, "success-rate-minimum-hosts");
+    self->success_rate_request_volume = cfg_getint(cfg, "success-rate-request-volume");
+    self->success_rate_stdev_factor = cfg_getfloat(cfg, "success-rate-stdev-factor");
+    self->latency_threshold_factor = cfg_getfloat(cfg, "latency-threshold-factor");
+
+    if (self->consecutive_5xx < 0 ||
+        self->consecutive_gateway_failure < 0 ||
+        self->consecutive_local_origin_failure < 0 ||
+        self->max_ejection_percent < 0 || self->max_ejection_percent > 100 ||
+        self->success_rate_stdev_factor < 0.0 ||
+        self->latency_threshold_factor < 0.0)
+    {
+        LOGE("outlier-detection thresholds must not be negative and max-ejection-percent must be a percentage");
+        outlier_detection_cfg_free(self);
+        return NULL;
+    }
+
+    if (self->interval.tv_sec <= 0 && self->interval.tv_usec <= 0)
+    {
+        LOGE("outlier-detection interval must be greater than zero");
+        outlier_detection_cfg_free(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+health_check_cfg_t*
+health_check_cfg_new(void)
+{
+    LOGD("()");
+    health_check_cfg_t* self = g_new0(health_check_cfg_t, 1);
+    return self;
+}
+
+void
+health_check_cfg_free(health_check_cfg_t* self)
+{
+    LOGD("(%p)", self);
+    g_clear_pointer(&self->path, g_free);
+    g_free(self);
+}
+
+health_check_cfg_t*
+health_check_cfg_parse(cfg_t* cfg)
+{
+    LOGD("(%p)", cfg);
+
+    g_return_val_if_fail(cfg != NULL, NULL);
+
+    health_check_cfg_t* self = health_check_cfg_new();
+    const char* type = cfg_getstr(cfg, "type");
+    if (g_ascii_strcasecmp(type, "tcp") == 0)
+    {
+        self->type = health_check_type_tcp;
+    }
+    else if (g_ascii_strcasecmp(type, "http") == 0)
+    {
+        self->type = health_check_type_http;
+    }
+    else
+    {
+        LOGE("unknown health-check type \"%s\"", type);
+        health_check_cfg_free(self);
+        return NULL;
+    }
+    self->path = g_strdup(cfg_getstr(cfg, "path"));
+    self->interval.tv_sec = cfg_getnint(cfg, "interval", 0);
+    self->interval.tv_usec = cfg_getnint(cfg, "interval", 1);
+    self->interval_jitter.tv_sec = cfg_getnint(cfg, "interval-jitter", 0);
+    self->interval_jitter.tv_usec = cfg_getnint(cfg, "interval-jitter", 1);
+    self->timeout.tv_sec = cfg_getnint(cfg, "timeout", 0);
+    self->timeout.tv_usec = cfg_getnint(cfg, "timeout", 1);
+    self->unhealthy_threshold = cfg_getint(cfg, "unhealthy-threshold");
+    self->healthy_threshold = cfg_getint(cfg, "healthy-threshold");
+
+    if (self->unhealthy_threshold <= 0 || self->healthy_threshold <= 0)
+    {
+        LOGE("health-check thresholds must be greater than zero");
+        health_check_cfg_free(self);
+        return NULL;
+    }
+
+    if ((self->interval.tv_sec <= 0 && self->interval.tv_usec <= 0) ||
+        (self->timeout.tv_sec <= 0 && self->timeout.tv_usec <= 0) ||
+        self->interval_jitter.tv_sec < 0 || self->interval_jitter.tv_usec < 0)
+    {
+        LOGE("health-check interval and timeout must be greater than zero");
+        health_check_cfg_free(self);
+        return NULL;
+    }
+
+    if (self->type == health_check_type_http && (!self->path || self->path[0] != '/'))
+    {
+        LOGE("health-check path must start with '/'");
+        health_check_cfg_free(self);
+        return NULL;
+    }
+
+    return self;
+}
+
 /**
  * @brief parses a single rule from a server { vhost { rules { } } } config
  *
@@ -1300,6 +1533,55 @@ rule_cfg_parse(cfg_t* cfg)
     }
     rcfg->connect_timeout.tv_sec = cfg_getnint(cfg, "connect-timeout", 0);
     rcfg->connect_timeout.tv_usec = cfg_getnint(cfg, "connect-timeout", 1);
+    rcfg->hedge_delay.tv_sec = cfg_getnint(cfg, "hedge-delay", 0);
+    rcfg->hedge_delay.tv_usec = cfg_getnint(cfg, "hedge-delay", 1);
+    rcfg->collapsed_forwarding = cfg_getbool(cfg, "collapsed-forwarding");
+    rcfg->num_retries = cfg_getint(cfg, "num-retries");
+    rcfg->per_try_timeout.tv_sec = cfg_getnint(cfg, "per-try-timeout", 0);
+    rcfg->per_try_timeout.tv_usec = cfg_getnint(cfg, "per-try-timeout", 1);
+    rcfg->retry_backoff.tv_sec = cfg_getnint(cfg, "retry-backoff", 0);
+    rcfg->retry_backoff.tv_usec = cfg_getnint(cfg, "retry-backoff", 1);
+    rcfg->retry_budget = cfg_getfloat(cfg, "retry-budget");
+    rcfg->retry_budget_min_concurrency = cfg_getint(cfg, "retry-budget-min-concurrency");
+    for (unsigned int i = 0; i < cfg_size(cfg, "retry-on"); i++)
+    {
+        int retry_on = retry_on_str_to_retry_on(cfg_getnstr(cfg, "retry-on", i));
+        if (!retry_on)
+        {
+            LOGE("unknown retry-on condition \"%s\"", cfg_getnstr(cfg, "retry-on", i));
+            rule_cfg_free(rcfg);
+            return NULL;
+        }
+        rcfg->retry_on |= retry_on;
+    }
+    cfg_t* odcfg;
+    if (section_exists(cfg, "outlier-detection", &odcfg))
+    {
+        rcfg->outlier_detection = outlier_detection_cfg_parse(odcfg);
+        if (!rcfg->outlier_detection)
+        {
+            LOGE("outlier-detection section failed");
+            rule_cfg_free(rcfg);
+            return NULL;
+        }
+    }
+    cfg_t* hccfg;
+    if (section_exists(cfg, "health-check", &hccfg))
+    {
+        rcfg->health_check = health_check_cfg_parse(hccfg);
+        if (!rcfg->health_check)
+        {
+            LOGE("health-check section failed");
+            rule_cfg_free(rcfg);
+            return NULL;
+        }
+    }
+    if (rcfg->num_retries < 0 || rcfg->retry_budget < 0.0 || rcfg->retry_budget > 100.0)
+    {
+        LOGE("num-retries must not be negative and retry-budget must be a percentage");
+        rule_cfg_free(rcfg);
+        return NULL;
+    }
     if (!do_headers_section(cfg, &rcfg->headers))
     {
         LOGE("header section failed");
@@ -1308,6 +1590,15 @@ rule_cfg_parse(cfg_t* cfg)
     }
     rcfg->passthrough    = cfg_getbool(cfg, "passthrough");
     rcfg->allow_redirect = cfg_getbool(cfg, "allow-redirect");
+    rcfg->upstream_http2 = cfg_getbool(cfg, "upstream-http2");
+    rcfg->happy_eyeballs = cfg_getbool(cfg, "happy-eyeballs");
+    rcfg->max_concurrent_streams = cfg_getint(cfg, "max-concurrent-streams");
+    if (rcfg->max_concurrent_streams <= 0)
+    {
+        LOGE("max-concurrent-streams must be greater than zero");
+        rule_cfg_free(rcfg);
+        return NULL;
+    }
 
     if (cfg_getopt(cfg, "upstream-read-timeout"))
     {
@@ -1398,6 +1689,32 @@ do_ssl_section(cfg_t* cfg, evhtp_ssl_cfg_t** ssl_cfg)
     return true;
 }
 
+static bool
+do_io_handle(cfg_t* cfg, io_handle_type* io_handle)
+{
+    LOGD("(%p, %p)", cfg, io_handle);
+
+    const char* type = cfg_getstr(cfg, "io-handle");
+    if (g_ascii_strcasecmp(type, "bufferevent") == 0)
+    {
+        *io_handle = io_handle_type_bufferevent;
+    }
+    else if (g_ascii_strcasecmp(type, "native") == 0)
+    {
+        *io_handle = io_handle_type_native;
+    }
+    else if (g_ascii_strcasecmp(type, "io_uring") == 0)
+    {
+        *io_handle = io_handle_type_io_uring;
+    }
+    else
+    {
+        LOGE("unknown io-handle \"%s\"", type);
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief parses a upstream {} config entry from a server { } config.
  *
@@ -1433,6 +1750,12 @@ upstream_cfg_parse(cfg_t* cfg)
     dscfg->retry_ival.tv_sec     = cfg_getnint(cfg, "retry", 0);
     dscfg->retry_ival.tv_usec    = cfg_getnint(cfg, "retry", 1);
 
+    if (!do_io_handle(cfg, &dscfg->io_handle))
+    {
+        upstream_cfg_free(dscfg);
+        return NULL;
+    }
+
     if (!do_ssl_section(cfg, &dscfg->ssl_cfg))
     {
         LOGE("ssl section failed");
@@ -1620,6 +1943,13 @@ server_cfg_parse(cfg_t* cfg)
     scfg->pending_timeout.tv_sec  = cfg_getnint(cfg, "pending-timeout", 0);
     scfg->pending_timeout.tv_usec = cfg_getnint(cfg, "pending-timeout", 1);
     scfg->high_watermark          = cfg_getint(cfg, "high-watermark");
+    scfg->ssl_handshake_threads   = cfg_getint(cfg, "ssl-handshake-threads");
+
+    if (!do_io_handle(cfg, &scfg->io_handle))
+    {
+        server_cfg_free(scfg);
+        return NULL;
+    }
 
     if (cfg_getbool(cfg, "disable-server-nagle") == cfg_true)
     {
@@ -1645,6 +1975,36 @@ server_cfg_parse(cfg_t* cfg)
         scfg->enable_workers_listen = true;
     }
 
+    if (cfg_getbool(cfg, "enable-fast-http-parser") == cfg_true)
+    {
+        LOGD("enable fast http parser");
+        scfg->enable_fast_http_parser = true;
+    }
+
+    if (cfg_getbool(cfg, "enable-http2") == cfg_true)
+    {
+        LOGD("enable http2");
+        scfg->enable_http2 = true;
+    }
+
+    if (cfg_getbool(cfg, "coalesce-writes") == cfg_true)
+    {
+        LOGD("coalesce writes");
+        scfg->coalesce_writes = true;
+    }
+
+    if (cfg_getbool(cfg, "cork-writes") == cfg_true)
+    {
+        LOGD("cork writes");
+        scfg->cork_writes = true;
+    }
+
+    if (cfg_getbool(cfg, "ssl-dynamic-records") == cfg_true)
+    {
+        LOGD("ssl dynamic records");
+        scfg->ssl_dynamic_records = true;
+    }
+
     cfg_t* log_cfg;
     if (section_exists(cfg, "logging", &log_cfg))
     {
@@ -76,6 +76,26 @@ cluster_iface_init(RpClusterInterface* iface)
     iface->priority_set = priority_set_i;
 }
 
+static RpHost*
+next_healthy_host(RpStaticClusterImpl* self, rule_t* rule, upstream_t* upstream)
+{
+    NOISY_MSG_("(%p, %p, %p)", self, rule, upstream);
+
+    // Walk the rule's upstreams from the ejected pick onwards.
+    GSList* itr = g_slist_find(rule->upstreams, upstream);
+    for (guint i = g_slist_length(rule->upstreams); i > 0; --i)
+    {
+        itr = itr && itr->next ? itr->next : rule->upstreams;
+        RpHost* host = g_hash_table_lookup(self->m_host_map, itr->data);
+        if (host && rp_host_coarse_health(host) != RpHostHealth_UNHEALTHY)
+        {
+            NOISY_MSG_("skipping unhealthy host, chose %p", host);
+            return host;
+        }
+    }
+    return NULL;
+}
+
 static RpHostSelectionResponse
 choose_host_i(RpLoadBalancer* self, RpLoadBalancerContext* context)
 {
@@ -83,8 +103,15 @@ choose_host_i(RpLoadBalancer* self, RpLoadBalancerContext* context)
 
     RpStaticClusterImpl* me = RP_STATIC_CLUSTER_IMPL(self);
     const RpClusterCfg* config = rp_cluster_impl_base_config_(RP_CLUSTER_IMPL_BASE(self));
-    upstream_t* upstream = upstream_get(rp_cluster_cfg_rule(config));
+    rule_t* rule = rp_cluster_cfg_rule(config);
+    upstream_t* upstream = upstream_get(rule);
     RpHost* host = g_hash_table_lookup(me->m_host_map, upstream);
+    if (host && rp_host_coarse_health(host) == RpHostHealth_UNHEALTHY)
+    {
+        RpHost* healthy = next_healthy_host(me, rule, upstream);
+        // With every host out, keep the original pick rather than fail (panic).
+        host = healthy ? healthy : host;
+    }
     return rp_host_selection_response_ctor(host, NULL, NULL);
 }
 
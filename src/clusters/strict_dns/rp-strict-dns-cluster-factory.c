@@ -34,6 +34,9 @@ OVERRIDE PairClusterSharedPtrThreadAwareLoadBalancerPtr
 create_cluster_impl(RpClusterFactoryImplBase* self, const RpClusterCfg* cluster, RpClusterFactoryContext* context)
 {
     NOISY_MSG_("(%p, %p, %p)", self, cluster, context);
+    // Resolving both families means racing them (happy eyeballs) from a
+    // single host per name.
+    bool all_families = rp_cluster_cfg_dns_lookup_family(cluster) == RpDnsLookupFamily_ALL;
     RpDnsClusterCfg proto_config = {
         .dns_failure_refresh_rate = {
             .base_interval = 60,
@@ -42,8 +45,8 @@ create_cluster_impl(RpClusterFactoryImplBase* self, const RpClusterCfg* cluster,
         .dns_refresh_rate = 60,
         .respect_dns_ttl = false,
         .dns_jitter = 0,
-        .dns_lookup_family = RpDnsLookupFamily_V4_PREFERRED,//REVISIT - config-driven!
-        .all_addresses_in_single_endpoint = true
+        .dns_lookup_family = all_families ? RpDnsLookupFamily_ALL : RpDnsLookupFamily_V4_PREFERRED,//REVISIT - config-driven!
+        .all_addresses_in_single_endpoint = all_families
     };
     RpNetworkDnsResolverSharedPtr dns_resolver = rp_cluster_factory_impl_base_select_dns_resolver(self, cluster, context);
     return rp_strict_dns_cluster_impl_create(cluster, &proto_config, context, RP_NETWORK_DNS_RESOLVER(dns_resolver));
@@ -17,6 +17,7 @@
 #include "rp-cluster-configuration.h"
 #include "rp-host-set-ptr-vector.h"
 #include "network/rp-address-impl.h"
+#include "network/rp-happy-eyeballs.h"
 #include "thread_local/rp-thread-local-impl.h"
 #include "upstream/rp-delegate-load-balancer-factory.h"
 #include "clusters/strict_dns/rp-strict-dns-cluster.h"
@@ -38,6 +39,7 @@ struct _RpStrictDnsClusterImpl {
     guint32 m_last_used_element;
     bool m_respect_dns_ttl : 1;
     bool m_weighted_priority_health : 1;
+    bool m_all_addresses_in_single_endpoint : 1;
 };
 
 static void update_all_hosts(RpStrictDnsClusterImpl* self, const RpHostVector* hosts_added, const RpHostVector* hosts_removed, guint32 priority);
@@ -239,6 +241,7 @@ network_dns_resolve_cb(RpDnsResolutionStatus_e status, char *details, GList* res
         RpHostVector* new_hosts = rp_host_vector_new();
         guint64 ttl_refresh_rate = G_MAXUINT64;
         g_autoptr(GHashTable) all_new_hosts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        g_autoptr(GPtrArray) address_list = g_ptr_array_new_with_free_func(g_object_unref);
         for (GList* itr = response; itr; itr = itr->next)
         {
             RpNetworkDnsResponse* resp = itr->data;
@@ -250,6 +253,15 @@ network_dns_resolve_cb(RpDnsResolutionStatus_e status, char *details, GList* res
                 NOISY_MSG_("exists");
                 continue;
             }
+            if (parent_->m_all_addresses_in_single_endpoint)
+            {
+                // One host for the name, created below, that races them all.
+                g_ptr_array_add(address_list, (gpointer)address);
+                g_hash_table_add(all_new_hosts,
+                    g_strdup(rp_network_address_instance_as_string(address)));
+                ttl_refresh_rate = MIN(ttl_refresh_rate, addrinfo->m_ttl);
+                continue;
+            }
             upstream_t* upstream = add_upstream(parent_upstream_cfg, count++, address, rule, dispatcher);
             RpHostImpl* host = rp_host_impl_create(rp_cluster_info(RP_CLUSTER(parent_)),
                                                     self->m_dns_address,
@@ -263,6 +275,25 @@ network_dns_resolve_cb(RpDnsResolutionStatus_e status, char *details, GList* res
                 g_strdup(rp_network_address_instance_as_string(address)));
             ttl_refresh_rate = MIN(ttl_refresh_rate, addrinfo->m_ttl);
         }
+        if (address_list->len > 0)
+        {
+            g_autoptr(GPtrArray) sorted = rp_happy_eyeballs_sort_addresses(address_list);
+            RpNetworkAddressInstanceConstSharedPtr address = g_ptr_array_index(sorted, 0);
+            NOISY_MSG_("single host for %u addresses, first %s", sorted->len, rp_network_address_instance_as_string(address));
+            upstream_t* upstream = add_upstream(parent_upstream_cfg, count++, address, rule, dispatcher);
+            RpHostImpl* host = rp_host_impl_create(rp_cluster_info(RP_CLUSTER(parent_)),
+                                                    self->m_dns_address,
+                                                    address,
+                                                    upstream,
+                                                    rp_lb_endpoint_cfg_load_balancing_weight_value(&self->m_lb_endpoint),
+                                                    rp_locality_lb_endpoints_cfg_priority(&self->m_locality_lb_endpoints),
+                                                    rp_cluster_impl_base_time_source_(RP_CLUSTER_IMPL_BASE(parent_)));
+            if (sorted->len > 1)
+            {
+                rp_host_impl_set_address_list(host, sorted);
+            }
+            rp_host_vector_add_take(new_hosts, (RpHost*)g_steal_pointer(&host));
+        }
 
         RpHostVector* hosts_added = NULL;
         RpHostVector* hosts_removed = NULL;
@@ -396,32 +427,47 @@ get_round_robin(RpLoadBalancer* self)
     RpPrioritySet* priority_set = rp_cluster_priority_set(RP_CLUSTER(self));
     // REVISIT to use cross priority host map.
     const RpHostSetPtrVector* host_set = rp_priority_set_host_sets_per_priority(priority_set);
-    const RpHostVector* hosts = rp_host_set_get_healthy_hosts(rp_host_set_ptr_vector_get(host_set, 0));
+    // Walk all hosts and skip ejected ones here rather than reading the
+    // healthy vector, which the main thread swaps whenever health changes.
+    const RpHostVector* hosts = rp_host_set_get_hosts(rp_host_set_ptr_vector_get(host_set, 0));
+    guint len = rp_host_vector_len(hosts);
 
-    NOISY_MSG_("choosing from %u hosts, last used element %u", rp_host_vector_len(hosts), me->m_last_used_element);
+    NOISY_MSG_("choosing from %u hosts, last used element %u", len, me->m_last_used_element);
 
-    if (rp_host_vector_len(hosts) < 2)
+    if (len < 2)
     {
         NOISY_MSG_("only 1 host");
         return rp_host_vector_get(hosts, 0);
     }
 
     guint32 last_used_element = me->m_last_used_element;
+    guint32 first_choice = G_MAXUINT32;
 
-    RpHost* host;
-    if (last_used_element == G_MAXUINT32)
+    RpHost* host = NULL;
+    for (guint i = 0; i < len; ++i)
     {
-        host = rp_host_vector_get(hosts, 0);
-        last_used_element = 0;
-    }
-    else
-    {
-        ++last_used_element;
-        if (last_used_element >= rp_host_vector_len(hosts))
+        if (last_used_element == G_MAXUINT32 || ++last_used_element >= len)
         {
             NOISY_MSG_("wrapping");
             last_used_element = 0;
         }
+        if (first_choice == G_MAXUINT32)
+        {
+            first_choice = last_used_element;
+        }
+        host = rp_host_vector_get(hosts, last_used_element);
+        if (rp_host_coarse_health(host) != RpHostHealth_UNHEALTHY)
+        {
+            break;
+        }
+        host = NULL;
+    }
+
+    if (!host)
+    {
+        // With every host out, keep round robin going rather than fail (panic).
+        NOISY_MSG_("no healthy hosts");
+        last_used_element = first_choice;
         host = rp_host_vector_get(hosts, last_used_element);
     }
 
@@ -590,6 +636,7 @@ rp_strict_dns_cluster_impl_new(const RpClusterCfg* cluster, const RpDnsClusterCf
     if (!self->m_dns_refresh_rate_ms) self->m_dns_refresh_rate_ms = 5000;
     self->m_respect_dns_ttl = rp_dns_cluster_cfg_respect_dns_ttl(dns_cluster);
     self->m_dns_lookup_family = rp_dns_cluster_cfg_dns_lookup_family(dns_cluster);
+    self->m_all_addresses_in_single_endpoint = rp_dns_cluster_cfg_all_addresses_in_single_endpoint(dns_cluster);
     // Create a new rule - based on the parent rule (the dfp cluster), primarily
     // to keep the upstream(s) associated with this sub-cluster contained
     // within this sub-cluster.
@@ -44,6 +44,11 @@ rp_dns_cluster_cfg_dns_lookup_family(const RpDnsClusterCfg* self)
 {
     return self->dns_lookup_family;
 }
+static inline bool
+rp_dns_cluster_cfg_all_addresses_in_single_endpoint(const RpDnsClusterCfg* self)
+{
+    return self->all_addresses_in_single_endpoint;
+}
 
 
 /**
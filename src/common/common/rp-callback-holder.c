@@ -86,3 +86,11 @@ rp_callback_holder_new(RpCallbackManager* parent, RpCallback cb, gpointer arg)
     self->m_arg = arg;
     return self;
 }
+
+void
+rp_callback_holder_remove(RpCallbackHolder* self)
+{
+    LOGD("(%p)", self);
+    g_return_if_fail(RP_IS_CALLBACK_HOLDER(self));
+    rp_callback_manager_remove(self->m_parent, RP_CALLBACK_HANDLE(self));
+}
@@ -74,3 +74,14 @@ rp_callback_manager_callbacks(RpCallbackManager* self)
     g_return_val_if_fail(RP_IS_CALLBACK_MANAGER(self), NULL);
     return self->m_callbacks;
 }
+
+void
+rp_callback_manager_remove(RpCallbackManager* self, RpCallbackHandle* handle)
+{
+    LOGD("(%p, %p)", self, handle);
+    g_return_if_fail(RP_IS_CALLBACK_MANAGER(self));
+    GList* link = g_list_find(self->m_callbacks, handle);
+    g_return_if_fail(link != NULL);
+    self->m_callbacks = g_list_delete_link(self->m_callbacks, link);
+    g_object_unref(handle);
+}
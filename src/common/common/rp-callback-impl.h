@@ -24,10 +24,16 @@ G_DECLARE_FINAL_TYPE(RpCallbackManager, rp_callback_manager, RP, CALLBACK_MANAGE
 RpCallbackManager* rp_callback_manager_new(void);
 RpCallbackHandlePtr rp_callback_manager_add(RpCallbackManager* self, RpCallback cb, gpointer arg);
 GList* rp_callback_manager_callbacks(RpCallbackManager* self);
+void rp_callback_manager_remove(RpCallbackManager* self, RpCallbackHandle* handle);
 
 #define RP_TYPE_CALLBACK_HOLDER rp_callback_holder_get_type()
 G_DECLARE_FINAL_TYPE(RpCallbackHolder, rp_callback_holder, RP, CALLBACK_HOLDER, GObject)
 
 RpCallbackHolder* rp_callback_holder_new(RpCallbackManager* parent, RpCallback cb, gpointer arg);
+/**
+ * Removes the callback from its manager and releases |self|. A callback may
+ * remove itself while it runs.
+ */
+void rp_callback_holder_remove(RpCallbackHolder* self);
 
 G_END_DECLS
@@ -412,6 +412,22 @@ rp_connection_pool_active_client_set_remaining_streams(RpConnectionPoolActiveCli
     PRIV(self)->m_remaining_streams = count;
 }
 
+guint32
+rp_connection_pool_active_client_configured_stream_limit(RpConnectionPoolActiveClient* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(RP_IS_CONNECTION_POOL_ACTIVE_CLIENT(self), 0);
+    return PRIV(self)->m_configured_stream_limit;
+}
+
+void
+rp_connection_pool_active_client_set_concurrent_stream_limit(RpConnectionPoolActiveClient* self, guint32 limit)
+{
+    LOGD("(%p, %u)", self, limit);
+    g_return_if_fail(RP_IS_CONNECTION_POOL_ACTIVE_CLIENT(self));
+    PRIV(self)->m_concurrent_stream_limit = limit;
+}
+
 void
 rp_connection_pool_active_client_set_has_handshake_completed(RpConnectionPoolActiveClient* self, bool v)
 {
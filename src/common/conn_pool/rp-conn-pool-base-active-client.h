@@ -162,6 +162,9 @@ void rp_connection_pool_active_client_set_real_host_description(RpConnectionPool
 guint32 rp_connection_pool_active_client_decr_remaining_streams(RpConnectionPoolActiveClient* self);
 void rp_connection_pool_active_client_set_remaining_streams(RpConnectionPoolActiveClient* self,
                                                             guint32 count);
+guint32 rp_connection_pool_active_client_configured_stream_limit(RpConnectionPoolActiveClient* self);
+void rp_connection_pool_active_client_set_concurrent_stream_limit(RpConnectionPoolActiveClient* self,
+                                                                    guint32 limit);
 void rp_connection_pool_active_client_set_has_handshake_completed(RpConnectionPoolActiveClient* self,
                                                                     bool v);
 RpConnPoolImplBase* rp_connection_pool_active_client_parent_(RpConnectionPoolActiveClient* self);
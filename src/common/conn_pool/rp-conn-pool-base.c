@@ -370,9 +370,17 @@ static bool
 should_create_new_connection(RpConnPoolImplBase* self, float global_preconnect_ratio)
 {
     NOISY_MSG_("(%p, %.1f)", self, global_preconnect_ratio);
-    //TODO...health check
 
     RpConnPoolImplBasePrivate* me = PRIV(self);
+    // If the host is not healthy, don't make it do extra work, especially as
+    // upstream selection logic may result in bypassing this upstream entirely.
+    // Probing it is left to the cluster's dedicated health checker.
+    if (rp_host_coarse_health(me->m_host) != RpHostHealth_HEALTHY)
+    {
+        NOISY_MSG_("host %p not healthy", me->m_host);
+        return g_list_length(me->m_pending_streams) > me->m_connecting_stream_capacity;
+    }
+
     if (global_preconnect_ratio != 0)
     {
         bool result = should_connect(g_list_length(me->m_pending_streams), me->m_num_active_streams,
@@ -19,6 +19,8 @@
 typedef struct _RpPendingStreamPrivate RpPendingStreamPrivate;
 struct _RpPendingStreamPrivate {
     RpConnPoolImplBase* m_parent;
+    // Owned by the cluster's resource manager.
+    RpResourceLimit* m_pending_requests;
     bool m_can_send_early_data;
 };
 
@@ -108,12 +110,20 @@ constructed(GObject* obj)
     RpResourceLimit* pending_requests = rp_resource_manager_pending_requests(resource_manager);
 
     rp_resource_limit_inc(pending_requests);
+    me->m_pending_requests = pending_requests;
 }
 
 OVERRIDE void
 dispose(GObject* obj)
 {
     NOISY_MSG_("(%p)", obj);
+
+    RpPendingStreamPrivate* me = PRIV(obj);
+    if (me->m_pending_requests)
+    {
+        rp_resource_limit_dec(g_steal_pointer(&me->m_pending_requests));
+    }
+
     G_OBJECT_CLASS(rp_pending_stream_parent_class)->dispose(obj);
 }
 
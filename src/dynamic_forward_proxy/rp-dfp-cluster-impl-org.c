@@ -15,6 +15,7 @@
 #include "rule.h"
 #include "event/rp-dispatcher-impl.h"
 #include "rp-dfp-cluster-store.h"
+#include "rp-header-map.h"
 #include "rp-header-utility.h"
 #include "rp-http-utility.h"
 #include "rp-state-filter.h"
@@ -149,9 +150,9 @@ choose_host_i(RpThreadLocalCluster* self, RpLoadBalancerContext* context)
     if (filter_state)
     {
         NOISY_MSG_("getting host from filter state");
-        raw_host = rp_filter_state_get_data(filter_state, dynamic_host_key);
+        raw_host = rp_filter_state_get_slot_data(filter_state, dynamic_host_slot);
 
-        gpointer dynamic_port_filter_state = rp_filter_state_get_data(filter_state, dynamic_port_key);
+        gpointer dynamic_port_filter_state = rp_filter_state_get_slot_data(filter_state, dynamic_port_slot);
         if (dynamic_port_filter_state)
         {
             port = *((guint32*)dynamic_port_filter_state);
@@ -160,7 +161,7 @@ choose_host_i(RpThreadLocalCluster* self, RpLoadBalancerContext* context)
     else if (rp_load_balancer_context_downstream_headers(context))
     {
         NOISY_MSG_("getting host from downstream headers");
-        raw_host = evhtp_header_find(rp_load_balancer_context_downstream_headers(context), RpHeaderValues.HostLegacy);
+        raw_host = rp_header_map_get_inline(rp_load_balancer_context_downstream_headers(context), RpInlineHeader_HostLegacy);
     }
     else if (rp_load_balancer_context_downstream_connection(context))
     {
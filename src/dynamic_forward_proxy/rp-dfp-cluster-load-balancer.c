@@ -13,6 +13,7 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-header-utility.h"
 #include "rp-state-filter.h"
@@ -60,9 +61,9 @@ choose_host_i(RpLoadBalancer* self, RpLoadBalancerContext* context)
     if (filter_state)
     {
         NOISY_MSG_("getting host from filter state");
-        raw_host = rp_filter_state_get_data(filter_state, dynamic_host_key);
+        raw_host = rp_filter_state_get_slot_data(filter_state, dynamic_host_slot);
 
-        gpointer dynamic_port_filter_state = rp_filter_state_get_data(filter_state, dynamic_port_key);
+        gpointer dynamic_port_filter_state = rp_filter_state_get_slot_data(filter_state, dynamic_port_slot);
         if (dynamic_port_filter_state)
         {
             port = *((guint16*)dynamic_port_filter_state);
@@ -71,7 +72,7 @@ choose_host_i(RpLoadBalancer* self, RpLoadBalancerContext* context)
     else if (rp_load_balancer_context_downstream_headers(context))
     {
         NOISY_MSG_("getting host from downstream headers");
-        raw_host = evhtp_header_find(rp_load_balancer_context_downstream_headers(context), RpHeaderValues.HostLegacy);
+        raw_host = rp_header_map_get_inline(rp_load_balancer_context_downstream_headers(context), RpInlineHeader_HostLegacy);
     }
     else if (rp_load_balancer_context_downstream_connection(context))
     {
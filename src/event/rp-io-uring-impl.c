@@ -0,0 +1,282 @@
+/*
+ * rp-io-uring-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_io_uring_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_io_uring_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#ifdef HAVE_LIBURING
+#include <string.h>
+#include <sys/eventfd.h>
+#endif
+#include "event/rp-io-uring-impl.h"
+
+#define RING_ENTRIES 256
+#define BUFFER_GROUP 0
+#define BUFFER_COUNT 256    /* power of 2 */
+#define BUFFER_SIZE (16 * 1024)
+
+struct _RpIoUring {
+    GObject parent_instance;
+
+#ifdef HAVE_LIBURING
+    struct io_uring m_ring;
+    struct io_uring_buf_ring* m_buf_ring;
+    guint8* m_buffers;
+
+    int m_event_fd;
+    struct event* m_completion_event;
+    struct event* m_submit_event;
+
+    bool m_ring_initialized : 1;
+    bool m_submit_scheduled : 1;
+#endif//HAVE_LIBURING
+};
+
+G_DEFINE_FINAL_TYPE(RpIoUring, rp_io_uring, G_TYPE_OBJECT)
+
+static __thread RpIoUring* io_uring_ = NULL;
+static __thread bool io_uring_unavailable_ = false;
+
+#ifdef HAVE_LIBURING
+
+static void
+submit_cb(evutil_socket_t fd G_GNUC_UNUSED, short what G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpIoUring* self = arg;
+    self->m_submit_scheduled = false;
+    int rc = io_uring_submit(&self->m_ring);
+    if (rc < 0)
+    {
+        LOGE("io_uring_submit() failed %d(%s)", -rc, g_strerror(-rc));
+    }
+    else
+    {
+        NOISY_MSG_("submitted %d entries", rc);
+    }
+}
+
+static void
+completion_cb(evutil_socket_t fd, short what G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpIoUring* self = arg;
+    eventfd_t value;
+    eventfd_read(fd, &value);
+
+    // Callbacks may queue submissions of their own; those go out with the
+    // end of iteration submit.
+    struct io_uring_cqe* cqe;
+    while (io_uring_peek_cqe(&self->m_ring, &cqe) == 0)
+    {
+        RpIoUringOp* op = io_uring_cqe_get_data(cqe);
+        int res = cqe->res;
+        guint32 flags = cqe->flags;
+        io_uring_cqe_seen(&self->m_ring, cqe);
+        if (op)
+        {
+            op->m_cb(op->m_arg, res, flags);
+        }
+    }
+}
+
+static bool
+setup(RpIoUring* self, evbase_t* evbase)
+{
+    NOISY_MSG_("(%p, %p)", self, evbase);
+
+    // IORING_SETUP_SINGLE_ISSUER doubles as the kernel version check; it came
+    // with the same release (6.0) as multishot receive.
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SINGLE_ISSUER;
+    int rc = io_uring_queue_init_params(RING_ENTRIES, &self->m_ring, &params);
+    if (rc < 0)
+    {
+        LOGI("io_uring unavailable %d(%s)", -rc, g_strerror(-rc));
+        return false;
+    }
+    self->m_ring_initialized = true;
+
+    self->m_buf_ring = io_uring_setup_buf_ring(&self->m_ring, BUFFER_COUNT, BUFFER_GROUP, 0, &rc);
+    if (!self->m_buf_ring)
+    {
+        LOGI("provided buffer ring unavailable %d(%s)", -rc, g_strerror(-rc));
+        return false;
+    }
+    self->m_buffers = g_malloc(BUFFER_COUNT * BUFFER_SIZE);
+    for (guint16 bid = 0; bid < BUFFER_COUNT; ++bid)
+    {
+        io_uring_buf_ring_add(self->m_buf_ring,
+                                self->m_buffers + bid * BUFFER_SIZE,
+                                BUFFER_SIZE,
+                                bid,
+                                io_uring_buf_ring_mask(BUFFER_COUNT),
+                                bid);
+    }
+    io_uring_buf_ring_advance(self->m_buf_ring, BUFFER_COUNT);
+
+    self->m_event_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if (self->m_event_fd < 0)
+    {
+        int err = errno;
+        LOGE("eventfd() failed %d(%s)", err, g_strerror(err));
+        return false;
+    }
+    rc = io_uring_register_eventfd(&self->m_ring, self->m_event_fd);
+    if (rc < 0)
+    {
+        LOGE("io_uring_register_eventfd() failed %d(%s)", -rc, g_strerror(-rc));
+        return false;
+    }
+
+    self->m_completion_event = event_new(evbase, self->m_event_fd, EV_READ|EV_PERSIST, completion_cb, self);
+    event_add(self->m_completion_event, NULL);
+    self->m_submit_event = event_new(evbase, -1, 0, submit_cb, self);
+    return true;
+}
+
+struct io_uring_sqe*
+rp_io_uring_get_sqe(RpIoUring* self, RpIoUringOp* op)
+{
+    NOISY_MSG_("(%p, %p)", self, op);
+
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&self->m_ring);
+    if (!sqe)
+    {
+        NOISY_MSG_("submission queue full");
+        io_uring_submit(&self->m_ring);
+        sqe = io_uring_get_sqe(&self->m_ring);
+        g_assert(sqe != NULL);
+    }
+    io_uring_sqe_set_data(sqe, op);
+
+    if (!self->m_submit_scheduled)
+    {
+        self->m_submit_scheduled = true;
+        event_active(self->m_submit_event, EV_TIMEOUT, 0);
+    }
+    return sqe;
+}
+
+guint16
+rp_io_uring_buffer_group(RpIoUring* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+    return BUFFER_GROUP;
+}
+
+const guint8*
+rp_io_uring_buffer(RpIoUring* self, guint32 flags)
+{
+    NOISY_MSG_("(%p, %x)", self, flags);
+    guint16 bid = flags >> IORING_CQE_BUFFER_SHIFT;
+    return self->m_buffers + bid * BUFFER_SIZE;
+}
+
+void
+rp_io_uring_recycle_buffer(RpIoUring* self, guint32 flags)
+{
+    NOISY_MSG_("(%p, %x)", self, flags);
+    guint16 bid = flags >> IORING_CQE_BUFFER_SHIFT;
+    io_uring_buf_ring_add(self->m_buf_ring,
+                            self->m_buffers + bid * BUFFER_SIZE,
+                            BUFFER_SIZE,
+                            bid,
+                            io_uring_buf_ring_mask(BUFFER_COUNT),
+                            0);
+    io_uring_buf_ring_advance(self->m_buf_ring, 1);
+}
+
+#endif//HAVE_LIBURING
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+#ifdef HAVE_LIBURING
+    RpIoUring* self = RP_IO_URING(obj);
+    g_clear_pointer(&self->m_completion_event, event_free);
+    g_clear_pointer(&self->m_submit_event, event_free);
+    if (self->m_ring_initialized)
+    {
+        if (self->m_buf_ring)
+        {
+            io_uring_free_buf_ring(&self->m_ring, self->m_buf_ring, BUFFER_COUNT, BUFFER_GROUP);
+            self->m_buf_ring = NULL;
+        }
+        io_uring_queue_exit(&self->m_ring);
+        self->m_ring_initialized = false;
+    }
+    g_clear_pointer(&self->m_buffers, g_free);
+    if (self->m_event_fd >= 0)
+    {
+        close(self->m_event_fd);
+        self->m_event_fd = -1;
+    }
+#endif//HAVE_LIBURING
+
+    G_OBJECT_CLASS(rp_io_uring_parent_class)->dispose(obj);
+}
+
+static void
+rp_io_uring_class_init(RpIoUringClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_io_uring_init(RpIoUring* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+#ifdef HAVE_LIBURING
+    self->m_event_fd = -1;
+#endif//HAVE_LIBURING
+}
+
+RpIoUring*
+rp_io_uring_get(evbase_t* evbase)
+{
+    LOGD("(%p)", evbase);
+
+    g_return_val_if_fail(evbase != NULL, NULL);
+
+    if (io_uring_ || io_uring_unavailable_)
+    {
+        NOISY_MSG_("returning %p", io_uring_);
+        return io_uring_;
+    }
+
+#ifdef HAVE_LIBURING
+    RpIoUring* self = g_object_new(RP_TYPE_IO_URING, NULL);
+    if (!setup(self, evbase))
+    {
+        LOGI("falling back to the socket io handle");
+        g_object_unref(self);
+        io_uring_unavailable_ = true;
+        return NULL;
+    }
+    // Lives as long as the thread's event loop.
+    io_uring_ = self;
+    return io_uring_;
+#else
+    LOGI("built without liburing; falling back to the socket io handle");
+    io_uring_unavailable_ = true;
+    return NULL;
+#endif//HAVE_LIBURING
+}
@@ -0,0 +1,76 @@
+/*
+ * rp-io-uring-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rproxy.h"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+G_BEGIN_DECLS
+
+typedef struct event_base evbase_t;
+
+/**
+ * Completion callback of a ring operation. |res| and |flags| are those of the
+ * completion queue entry.
+ */
+typedef void (*RpIoUringCb)(gpointer arg, int res, guint32 flags);
+
+/**
+ * Ring operation; the address of one is the user data of its submission, so
+ * it has to outlive every completion the submission produces.
+ */
+typedef struct _RpIoUringOp RpIoUringOp;
+struct _RpIoUringOp {
+    RpIoUringCb m_cb;
+    gpointer m_arg;
+};
+
+/**
+ * Per-thread io_uring instance polled from the thread's event loop. The ring
+ * signals completions through an eventfd watched by a plain event, and all
+ * the submissions queued during a loop iteration go to the kernel with a
+ * single io_uring_enter() at its end. Receives pick their buffers out of a
+ * provided buffer ring that belongs to the instance.
+ */
+#define RP_TYPE_IO_URING rp_io_uring_get_type()
+G_DECLARE_FINAL_TYPE(RpIoUring, rp_io_uring, RP, IO_URING, GObject)
+
+/**
+ * Returns the ring of the calling thread, setting it up on |evbase| on first
+ * use. NULL if built without liburing or the kernel lacks what the ring
+ * needs (Linux 6.0 or later), in which case callers use the plain socket
+ * handle instead.
+ */
+RpIoUring* rp_io_uring_get(evbase_t* evbase);
+
+#ifdef HAVE_LIBURING
+/**
+ * Returns a cleared submission queue entry carrying |op| (or no callback if
+ * |op| is NULL) and schedules the end of iteration submit.
+ */
+struct io_uring_sqe* rp_io_uring_get_sqe(RpIoUring* self,
+                                            RpIoUringOp* op);
+guint16 rp_io_uring_buffer_group(RpIoUring* self);
+/**
+ * Returns the provided buffer named by a receive's completion |flags|.
+ */
+const guint8* rp_io_uring_buffer(RpIoUring* self,
+                                    guint32 flags);
+/**
+ * Hands the buffer named by |flags| back to the kernel.
+ */
+void rp_io_uring_recycle_buffer(RpIoUring* self,
+                                guint32 flags);
+#endif//HAVE_LIBURING
+
+G_END_DECLS
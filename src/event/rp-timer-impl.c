@@ -70,7 +70,7 @@ duration_to_timeval(GTimeSpan span, struct timeval* tv)
         return;
     }
 
-    guint64 usecs = span - secs;
+    guint64 usecs = span - secs * G_USEC_PER_SEC;
     tv->tv_sec = secs;
     tv->tv_usec = usecs;
 }
@@ -0,0 +1,926 @@
+/*
+ * rp-fast-http-parser-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_fast_http_parser_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_fast_http_parser_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <string.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define RP_HAVE_X86_SIMD 1
+#   include <immintrin.h>
+#endif
+#include "rproxy.h"
+#include "rp-headers.h"
+#include "rp-fast-http-parser-impl.h"
+
+// Same ceiling Envoy applies to a request header block.
+#define RP_FAST_HTTP_PARSER_MAX_HEAD_SIZE (96*1024)
+
+typedef enum {
+    State_Head,
+    State_BodyIdentity,
+    State_BodyEof,
+    State_ChunkSize,
+    State_ChunkData,
+    State_ChunkDataCr,
+    State_ChunkDataLf,
+    State_Trailers,
+    State_MessageDone
+} State_e;
+
+typedef enum {
+    Error_None,
+    Error_Method,
+    Error_Url,
+    Error_Version,
+    Error_Status,
+    Error_Folding,
+    Error_HeaderName,
+    Error_HeaderValue,
+    Error_ContentLength,
+    Error_ChunkSize,
+    Error_ChunkData,
+    Error_HeaderOverflow,
+    Error_Callback
+} Error_e;
+
+static const char* const error_messages[] = {
+    [Error_None] = "none",
+    [Error_Method] = "invalid method",
+    [Error_Url] = "invalid url",
+    [Error_Version] = "invalid http version",
+    [Error_Status] = "invalid status line",
+    [Error_Folding] = "obsolete line folding",
+    [Error_HeaderName] = "invalid header name",
+    [Error_HeaderValue] = "invalid header value",
+    [Error_ContentLength] = "invalid content-length",
+    [Error_ChunkSize] = "invalid chunk size",
+    [Error_ChunkData] = "missing chunk terminator",
+    [Error_HeaderOverflow] = "header block too large",
+    [Error_Callback] = "callback error"
+};
+
+/*
+ * A delimiter set is up to eight inclusive [lo, hi] byte ranges. The layout is
+ * what pcmpestri expects in _SIDD_CMP_RANGES mode; the AVX2 and scalar scans
+ * interpret the same pairs.
+ */
+typedef struct {
+    _Alignas(16) char ranges[16];
+    int ranges_len;
+} scan_set_t;
+
+// Request-target ends at SP; CTLs and DEL are never valid in it.
+static const scan_set_t url_delims = { "\x00\x20\x7f\x7f", 4 };
+// Field-name ends at ':'; SP, CTLs and DEL are invalid before it.
+static const scan_set_t name_delims = { "\x00\x20\x3a\x3a\x7f\x7f", 6 };
+// Field-value ends at CR/LF; HTAB is the only CTL allowed within it.
+static const scan_set_t value_delims = { "\x00\x08\x0a\x1f\x7f\x7f", 6 };
+
+typedef const char* (*scan_fn)(const char*, const char*, const scan_set_t*);
+
+struct _RpFastHttpParserImpl {
+    GObject parent_instance;
+
+    RpMessageType_e m_type;
+    RpParserCallbacks* m_callbacks;
+
+    // Partial header (or trailer) block carried over between execute() calls.
+    GString* m_head;
+    char m_chunk_line[128];
+    guint m_chunk_line_len;
+
+    char m_method[32];
+    guint64 m_content_length;
+    guint64 m_remaining;
+    evhtp_res m_status;
+    State_e m_state;
+    Error_e m_error;
+    guint8 m_major;
+    guint8 m_minor;
+
+    bool m_paused : 1;
+    bool m_has_content_length : 1;
+    bool m_has_transfer_encoding : 1;
+    bool m_chunked : 1;
+    bool m_conn_close : 1;
+    bool m_conn_keep_alive : 1;
+};
+
+static void parser_iface_init(RpParserInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpFastHttpParserImpl, rp_fast_http_parser_impl, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_PARSER, parser_iface_init)
+)
+
+static inline bool
+in_set(const scan_set_t* set, guint8 c)
+{
+    for (int i = 0; i < set->ranges_len; i += 2)
+    {
+        if (c >= (guint8)set->ranges[i] && c <= (guint8)set->ranges[i + 1])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char*
+scan_scalar(const char* p, const char* end, const scan_set_t* set)
+{
+    for (; p < end; ++p)
+    {
+        if (in_set(set, *p))
+        {
+            return p;
+        }
+    }
+    return end;
+}
+
+#ifdef RP_HAVE_X86_SIMD
+__attribute__((target("sse4.2")))
+static const char*
+scan_sse42(const char* p, const char* end, const scan_set_t* set)
+{
+    __m128i ranges = _mm_load_si128((const __m128i*)set->ranges);
+    while (end - p >= 16)
+    {
+        __m128i b = _mm_loadu_si128((const __m128i*)p);
+        int i = _mm_cmpestri(ranges, set->ranges_len, b, 16,
+                                _SIDD_UBYTE_OPS|_SIDD_CMP_RANGES|_SIDD_LEAST_SIGNIFICANT);
+        if (i != 16)
+        {
+            return p + i;
+        }
+        p += 16;
+    }
+    return scan_scalar(p, end, set);
+}
+
+__attribute__((target("avx2,sse4.2")))
+static const char*
+scan_avx2(const char* p, const char* end, const scan_set_t* set)
+{
+    __m256i lo[8];
+    __m256i hi[8];
+    int n = set->ranges_len / 2;
+    for (int i = 0; i < n; ++i)
+    {
+        lo[i] = _mm256_set1_epi8(set->ranges[i * 2]);
+        hi[i] = _mm256_set1_epi8(set->ranges[i * 2 + 1]);
+    }
+    while (end - p >= 32)
+    {
+        __m256i b = _mm256_loadu_si256((const __m256i*)p);
+        __m256i hit = _mm256_setzero_si256();
+        for (int i = 0; i < n; ++i)
+        {
+            // Unsigned lo <= b <= hi via min/max, there being no unsigned compare.
+            __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(b, lo[i]), b);
+            __m256i le = _mm256_cmpeq_epi8(_mm256_min_epu8(b, hi[i]), b);
+            hit = _mm256_or_si256(hit, _mm256_and_si256(ge, le));
+        }
+        guint32 mask = (guint32)_mm256_movemask_epi8(hit);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return scan_sse42(p, end, set);
+}
+#endif
+
+// Selected once in class_init() based on what the CPU supports.
+static scan_fn scan = scan_scalar;
+
+static inline bool
+stopped(RpFastHttpParserImpl* self)
+{
+    return self->m_paused || self->m_error != Error_None;
+}
+
+static inline bool
+set_error(RpFastHttpParserImpl* self, Error_e error)
+{
+    NOISY_MSG_("(%p, %d(%s))", self, error, error_messages[error]);
+    self->m_error = error;
+    return false;
+}
+
+static inline bool
+check_result(RpFastHttpParserImpl* self, RpCallbackResult_e result)
+{
+    return result != RpCallbackResult_Error ? true : set_error(self, Error_Callback);
+}
+
+static inline const char*
+line_content_end(const char* line, const char* nl)
+{
+    return nl > line && nl[-1] == '\r' ? nl - 1 : nl;
+}
+
+static inline bool
+header_is(const char* name, size_t nlen, const char* known)
+{
+    return g_ascii_strncasecmp(name, known, nlen) == 0 && known[nlen] == '\0';
+}
+
+static inline bool
+token_is(const char* token, size_t len, const char* known)
+{
+    while (len > 0 && (*token == ' ' || *token == '\t'))
+    {
+        ++token;
+        --len;
+    }
+    while (len > 0 && (token[len - 1] == ' ' || token[len - 1] == '\t'))
+    {
+        --len;
+    }
+    return header_is(token, len, known);
+}
+
+/*
+ * Returns the offset just past the empty line that terminates a header block,
+ * or -1 if the block is not complete yet. |from| lets a caller resume a scan
+ * over a block it is accumulating without rescanning what it has seen.
+ */
+static gssize
+find_block_end(const char* buf, size_t len, size_t from)
+{
+    const char* end = buf + len;
+    const char* p = buf + from;
+
+    if (from == 0)
+    {
+        if (len >= 1 && buf[0] == '\n') return 1;
+        if (len >= 2 && buf[0] == '\r' && buf[1] == '\n') return 2;
+    }
+
+    const char* nl;
+    while ((nl = memchr(p, '\n', end - p)))
+    {
+        const char* q = nl + 1;
+        if (q < end && q[0] == '\n') return q + 1 - buf;
+        if (q + 1 < end && q[0] == '\r' && q[1] == '\n') return q + 2 - buf;
+        p = q;
+    }
+    return -1;
+}
+
+static void
+reset_message(RpFastHttpParserImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_method[0] = '\0';
+    self->m_content_length = 0;
+    self->m_remaining = 0;
+    self->m_status = 0;
+    self->m_major = 0;
+    self->m_minor = 0;
+    self->m_has_content_length = false;
+    self->m_has_transfer_encoding = false;
+    self->m_chunked = false;
+    self->m_conn_close = false;
+    self->m_conn_keep_alive = false;
+}
+
+static bool
+parse_version(RpFastHttpParserImpl* self, const char* v, const char* end)
+{
+    NOISY_MSG_("(%p, %p, %p)", self, v, end);
+    if (end - v != 8 ||
+        memcmp(v, "HTTP/", 5) != 0 ||
+        !g_ascii_isdigit(v[5]) || v[6] != '.' || !g_ascii_isdigit(v[7]))
+    {
+        return set_error(self, Error_Version);
+    }
+    self->m_major = v[5] - '0';
+    self->m_minor = v[7] - '0';
+    return true;
+}
+
+static bool
+parse_request_line(RpFastHttpParserImpl* self, const char* p, const char* end)
+{
+    NOISY_MSG_("(%p, %p(%.*s))", self, p, (int)(end - p), p);
+
+    const char* sp = memchr(p, ' ', end - p);
+    if (!sp || sp == p || (size_t)(sp - p) >= sizeof(self->m_method))
+    {
+        return set_error(self, Error_Method);
+    }
+    memcpy(self->m_method, p, sp - p);
+    self->m_method[sp - p] = '\0';
+
+    const char* target = sp + 1;
+    const char* target_end = scan(target, end, &url_delims);
+    if (target_end == target || target_end == end || *target_end != ' ')
+    {
+        return set_error(self, Error_Url);
+    }
+
+    if (!parse_version(self, target_end + 1, end))
+    {
+        return false;
+    }
+
+    return check_result(self, rp_parser_callbacks_on_message_begin(self->m_callbacks)) &&
+            check_result(self, rp_parser_callbacks_on_url(self->m_callbacks, target, target_end - target));
+}
+
+static bool
+parse_status_line(RpFastHttpParserImpl* self, const char* p, const char* end)
+{
+    NOISY_MSG_("(%p, %p(%.*s))", self, p, (int)(end - p), p);
+
+    // HTTP/x.y SP 3DIGIT [SP reason-phrase]
+    if (end - p < 12 || !parse_version(self, p, p + 8))
+    {
+        return self->m_error != Error_None ? false : set_error(self, Error_Status);
+    }
+    const char* code = p + 9;
+    if (p[8] != ' ' ||
+        !g_ascii_isdigit(code[0]) || !g_ascii_isdigit(code[1]) || !g_ascii_isdigit(code[2]) ||
+        (end - code > 3 && code[3] != ' '))
+    {
+        return set_error(self, Error_Status);
+    }
+    self->m_status = (code[0] - '0') * 100 + (code[1] - '0') * 10 + (code[2] - '0');
+
+    return check_result(self, rp_parser_callbacks_on_message_begin(self->m_callbacks));
+}
+
+static bool
+inspect_header(RpFastHttpParserImpl* self, const char* name, size_t nlen, const char* value, size_t vlen)
+{
+    if (header_is(name, nlen, RpHeaderValues.ContentLength))
+    {
+        guint64 content_length = 0;
+        if (vlen == 0)
+        {
+            return set_error(self, Error_ContentLength);
+        }
+        for (size_t i = 0; i < vlen; ++i)
+        {
+            if (!g_ascii_isdigit(value[i]) || content_length > (G_MAXUINT64 - 9) / 10)
+            {
+                return set_error(self, Error_ContentLength);
+            }
+            content_length = content_length * 10 + (value[i] - '0');
+        }
+        if (self->m_has_content_length && content_length != self->m_content_length)
+        {
+            return set_error(self, Error_ContentLength);
+        }
+        self->m_has_content_length = true;
+        self->m_content_length = content_length;
+    }
+    else if (header_is(name, nlen, RpHeaderValues.TransferEncoding))
+    {
+        // Only the final coding decides whether the body is chunked.
+        const char* last = value;
+        for (const char* c; (c = memchr(last, ',', vlen - (last - value))); last = c + 1);
+        self->m_has_transfer_encoding = true;
+        self->m_chunked = token_is(last, vlen - (last - value), RpHeaderValues.TransferCodingValues.Chunked);
+    }
+    else if (header_is(name, nlen, RpHeaderValues.Connection))
+    {
+        const char* token = value;
+        const char* vend = value + vlen;
+        while (token < vend)
+        {
+            const char* c = memchr(token, ',', vend - token);
+            const char* tend = c ? c : vend;
+            if (token_is(token, tend - token, RpHeaderValues.ConnectionValues.Close))
+            {
+                self->m_conn_close = true;
+            }
+            else if (token_is(token, tend - token, RpHeaderValues.ConnectionValues.KeepAlive))
+            {
+                self->m_conn_keep_alive = true;
+            }
+            token = tend + 1;
+        }
+    }
+    return true;
+}
+
+static bool
+parse_fields(RpFastHttpParserImpl* self, const char* p, const char* end, bool trailers)
+{
+    NOISY_MSG_("(%p, %p, %p, %u)", self, p, end, trailers);
+
+    while (p < end)
+    {
+        const char* nl = memchr(p, '\n', end - p);
+        if (!nl)
+        {
+            return set_error(self, Error_HeaderName);
+        }
+        const char* line_end = line_content_end(p, nl);
+        if (line_end == p)
+        {
+            return true;
+        }
+        if (*p == ' ' || *p == '\t')
+        {
+            return set_error(self, Error_Folding);
+        }
+
+        const char* name_end = scan(p, line_end, &name_delims);
+        if (name_end == p || name_end == line_end || *name_end != ':')
+        {
+            return set_error(self, Error_HeaderName);
+        }
+
+        const char* value = name_end + 1;
+        while (value < line_end && (*value == ' ' || *value == '\t'))
+        {
+            ++value;
+        }
+        const char* value_end = scan(value, line_end, &value_delims);
+        if (value_end != line_end)
+        {
+            return set_error(self, Error_HeaderValue);
+        }
+        while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+        {
+            --value_end;
+        }
+
+        if (!trailers && !inspect_header(self, p, name_end - p, value, value_end - value))
+        {
+            return false;
+        }
+
+        // The value callback is made even when empty so that the codec
+        // completes the field before the next one starts.
+        if (!check_result(self, rp_parser_callbacks_on_header_field(self->m_callbacks, p, name_end - p)) ||
+            !check_result(self, rp_parser_callbacks_on_header_value(self->m_callbacks, value, value_end - value)))
+        {
+            return false;
+        }
+
+        p = nl + 1;
+    }
+    return true;
+}
+
+static inline bool
+response_has_no_body(RpFastHttpParserImpl* self)
+{
+    return self->m_type == RpMessageType_Response &&
+            ((self->m_status >= 100 && self->m_status < 200) ||
+                self->m_status == EVHTP_RES_NOCONTENT ||
+                self->m_status == EVHTP_RES_NOTMOD);
+}
+
+static void
+headers_complete(RpFastHttpParserImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpCallbackResult_e result = rp_parser_callbacks_on_headers_complete(self->m_callbacks);
+    if (!check_result(self, result))
+    {
+        return;
+    }
+
+    if (result != RpCallbackResult_Success || response_has_no_body(self))
+    {
+        self->m_state = State_MessageDone;
+    }
+    else if (self->m_chunked)
+    {
+        self->m_chunk_line_len = 0;
+        self->m_state = State_ChunkSize;
+    }
+    else if (self->m_has_content_length)
+    {
+        self->m_remaining = self->m_content_length;
+        self->m_state = self->m_remaining > 0 ? State_BodyIdentity : State_MessageDone;
+    }
+    else if (self->m_type == RpMessageType_Request)
+    {
+        self->m_state = State_MessageDone;
+    }
+    else
+    {
+        // Response delimited by the connection closing.
+        self->m_conn_close = true;
+        self->m_state = State_BodyEof;
+    }
+    NOISY_MSG_("state %d", self->m_state);
+}
+
+static void
+parse_head(RpFastHttpParserImpl* self, const char* buf, const char* end)
+{
+    NOISY_MSG_("(%p, %p, %zu)", self, buf, (size_t)(end - buf));
+
+    reset_message(self);
+
+    const char* nl = memchr(buf, '\n', end - buf);
+    const char* line_end = line_content_end(buf, nl);
+    bool ok = self->m_type == RpMessageType_Request ?
+                parse_request_line(self, buf, line_end) :
+                parse_status_line(self, buf, line_end);
+    if (ok && parse_fields(self, nl + 1, end, false))
+    {
+        headers_complete(self);
+    }
+}
+
+static void
+parse_block(RpFastHttpParserImpl* self, const char* buf, const char* end)
+{
+    NOISY_MSG_("(%p, %p, %zu)", self, buf, (size_t)(end - buf));
+
+    if (end - buf > RP_FAST_HTTP_PARSER_MAX_HEAD_SIZE)
+    {
+        set_error(self, Error_HeaderOverflow);
+    }
+    else if (self->m_state == State_Head)
+    {
+        parse_head(self, buf, end);
+    }
+    else if (parse_fields(self, buf, end, true))
+    {
+        self->m_state = State_MessageDone;
+    }
+}
+
+static const char*
+on_block(RpFastHttpParserImpl* self, const char* p, const char* end)
+{
+    NOISY_MSG_("(%p, %p, %p)", self, p, end);
+
+    GString* head = self->m_head;
+    if (head->len == 0)
+    {
+        if (self->m_state == State_Head)
+        {
+            // Tolerate stray CRLFs between pipelined messages.
+            while (p < end && (*p == '\r' || *p == '\n')) ++p;
+            if (p == end)
+            {
+                return p;
+            }
+        }
+
+        // Common case; the whole block is in this slice so parse it in place.
+        gssize off = find_block_end(p, end - p, 0);
+        if (off >= 0)
+        {
+            parse_block(self, p, p + off);
+            return p + off;
+        }
+    }
+
+    gsize old_len = head->len;
+    g_string_append_len(head, p, end - p);
+
+    gssize off = find_block_end(head->str, head->len, old_len > 3 ? old_len - 3 : 0);
+    if (off < 0)
+    {
+        if (head->len > RP_FAST_HTTP_PARSER_MAX_HEAD_SIZE)
+        {
+            set_error(self, Error_HeaderOverflow);
+        }
+        return end;
+    }
+
+    // Only consume up to the end of the block; the rest belongs to the body
+    // or to the next message and is left with the caller.
+    g_string_truncate(head, off);
+    parse_block(self, head->str, head->str + off);
+    g_string_truncate(head, 0);
+    return p + (off - old_len);
+}
+
+static const char*
+on_chunk_size(RpFastHttpParserImpl* self, const char* p, const char* end)
+{
+    NOISY_MSG_("(%p, %p, %p)", self, p, end);
+
+    const char* nl = memchr(p, '\n', end - p);
+    const char* next = nl ? nl + 1 : end;
+    const char* line = p;
+    size_t len = (nl ? nl : end) - p;
+
+    if (self->m_chunk_line_len || !nl)
+    {
+        if (self->m_chunk_line_len + len > sizeof(self->m_chunk_line))
+        {
+            set_error(self, Error_ChunkSize);
+            return end;
+        }
+        memcpy(self->m_chunk_line + self->m_chunk_line_len, p, len);
+        self->m_chunk_line_len += len;
+        if (!nl)
+        {
+            return end;
+        }
+        line = self->m_chunk_line;
+        len = self->m_chunk_line_len;
+    }
+    self->m_chunk_line_len = 0;
+
+    if (len > 0 && line[len - 1] == '\r') --len;
+
+    guint64 size = 0;
+    size_t i = 0;
+    for (; i < len && g_ascii_isxdigit(line[i]); ++i)
+    {
+        if (size > (G_MAXUINT64 >> 4))
+        {
+            set_error(self, Error_ChunkSize);
+            return next;
+        }
+        size = (size << 4) | g_ascii_xdigit_value(line[i]);
+    }
+    // Chunk extensions are ignored.
+    if (i == 0 || (i < len && line[i] != ';' && line[i] != ' ' && line[i] != '\t'))
+    {
+        set_error(self, Error_ChunkSize);
+        return next;
+    }
+
+    NOISY_MSG_("chunk size %" G_GUINT64_FORMAT, size);
+    if (size == 0)
+    {
+        rp_parser_callbacks_on_chunk_header(self->m_callbacks, true);
+        self->m_state = State_Trailers;
+    }
+    else
+    {
+        rp_parser_callbacks_on_chunk_header(self->m_callbacks, false);
+        self->m_remaining = size;
+        self->m_state = State_ChunkData;
+    }
+    return next;
+}
+
+static inline const char*
+on_body(RpFastHttpParserImpl* self, const char* p, const char* end)
+{
+    size_t n = MIN(self->m_remaining, (guint64)(end - p));
+    rp_parser_callbacks_buffer_body(self->m_callbacks, p, n);
+    self->m_remaining -= n;
+    if (self->m_remaining == 0)
+    {
+        self->m_state = self->m_state == State_ChunkData ? State_ChunkDataCr : State_MessageDone;
+    }
+    return p + n;
+}
+
+static void
+message_complete(RpFastHttpParserImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_state = State_Head;
+    check_result(self, rp_parser_callbacks_on_message_complete(self->m_callbacks));
+}
+
+static size_t
+execute_i(RpParser* self, const char* data, int length)
+{
+    NOISY_MSG_("(%p, %p, %d)", self, data, length);
+
+    RpFastHttpParserImpl* me = RP_FAST_HTTP_PARSER_IMPL(self);
+    if (stopped(me))
+    {
+        NOISY_MSG_("stopped; paused %u, error %d", me->m_paused, me->m_error);
+        return 0;
+    }
+
+    if (length == 0 && me->m_state == State_BodyEof)
+    {
+        message_complete(me);
+        return 0;
+    }
+
+    const char* p = data;
+    const char* end = data + length;
+    while (!stopped(me) && (p < end || me->m_state == State_MessageDone))
+    {
+        switch (me->m_state)
+        {
+            case State_Head:
+            case State_Trailers:
+                p = on_block(me, p, end);
+                break;
+            case State_BodyIdentity:
+            case State_ChunkData:
+                p = on_body(me, p, end);
+                break;
+            case State_BodyEof:
+                rp_parser_callbacks_buffer_body(me->m_callbacks, p, end - p);
+                p = end;
+                break;
+            case State_ChunkSize:
+                p = on_chunk_size(me, p, end);
+                break;
+            case State_ChunkDataCr:
+                if (*p == '\r')
+                {
+                    me->m_state = State_ChunkDataLf;
+                    ++p;
+                    break;
+                }
+                /* fall through */
+            case State_ChunkDataLf:
+                if (*p++ != '\n')
+                {
+                    set_error(me, Error_ChunkData);
+                    break;
+                }
+                me->m_state = State_ChunkSize;
+                break;
+            case State_MessageDone:
+                message_complete(me);
+                break;
+        }
+    }
+
+    NOISY_MSG_("consumed %zu of %d", (size_t)(p - data), length);
+    return p - data;
+}
+
+static guint64
+content_length_i(RpParser* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_FAST_HTTP_PARSER_IMPL(self)->m_content_length;
+}
+
+static const char*
+error_message_i(RpParser* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return error_messages[RP_FAST_HTTP_PARSER_IMPL(self)->m_error];
+}
+
+static RpParserStatus_e
+get_status_i(RpParser* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpFastHttpParserImpl* me = RP_FAST_HTTP_PARSER_IMPL(self);
+    return me->m_paused ? RpParserStatus_Paused :
+            me->m_error != Error_None ? RpParserStatus_Error : RpParserStatus_Ok;
+}
+
+static int
+has_transfer_encoding_i(RpParser* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_FAST_HTTP_PARSER_IMPL(self)->m_has_transfer_encoding;
+}
+
+static bool
+is_chunked_i(RpParser* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_FAST_HTTP_PARSER_IMPL(self)->m_chunked;
+}
+
+static bool
+is_http_11_i(RpParser* self)
+{
+    RpFastHttpParserImpl* me = RP_FAST_HTTP_PARSER_IMPL(self);
+    return me->m_major == 1 && me->m_minor == 1;
+}
+
+static const char*
+method_name_i(RpParser* self)
+{
+    RpFastHttpParserImpl* me = RP_FAST_HTTP_PARSER_IMPL(self);
+    return me->m_method[0] ? me->m_method : NULL;
+}
+
+static RpCallbackResult_e
+pause_i(RpParser* self)
+{
+    RP_FAST_HTTP_PARSER_IMPL(self)->m_paused = true;
+    return RpCallbackResult_Success;
+}
+
+static void
+resume_i(RpParser* self)
+{
+    RP_FAST_HTTP_PARSER_IMPL(self)->m_paused = false;
+}
+
+static evhtp_res
+status_code_i(RpParser* self)
+{
+    return RP_FAST_HTTP_PARSER_IMPL(self)->m_status;
+}
+
+static bool
+should_keep_alive_i(RpParser* self)
+{
+    RpFastHttpParserImpl* me = RP_FAST_HTTP_PARSER_IMPL(self);
+    if (me->m_major == 1 && me->m_minor == 1)
+    {
+        return !me->m_conn_close;
+    }
+    return me->m_conn_keep_alive && !me->m_conn_close;
+}
+
+static void
+parser_iface_init(RpParserInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->content_length = content_length_i;
+    iface->error_message = error_message_i;
+    iface->execute = execute_i;
+    iface->get_status = get_status_i;
+    iface->has_transfer_encoding = has_transfer_encoding_i;
+    iface->is_chunked = is_chunked_i;
+    iface->is_http_11 = is_http_11_i;
+    iface->method_name = method_name_i;
+    iface->pause = pause_i;
+    iface->resume = resume_i;
+    iface->status_code = status_code_i;
+    iface->should_keep_alive = should_keep_alive_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpFastHttpParserImpl* self = RP_FAST_HTTP_PARSER_IMPL(obj);
+    if (self->m_head)
+    {
+        g_string_free(self->m_head, TRUE);
+        self->m_head = NULL;
+    }
+    self->m_callbacks = NULL;
+
+    G_OBJECT_CLASS(rp_fast_http_parser_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_fast_http_parser_impl_class_init(RpFastHttpParserImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+
+#ifdef RP_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        LOGD("using avx2 delimiter scan");
+        scan = scan_avx2;
+    }
+    else if (__builtin_cpu_supports("sse4.2"))
+    {
+        LOGD("using sse4.2 delimiter scan");
+        scan = scan_sse42;
+    }
+#endif
+}
+
+static void
+rp_fast_http_parser_impl_init(RpFastHttpParserImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_state = State_Head;
+    self->m_error = Error_None;
+}
+
+static inline RpFastHttpParserImpl*
+constructed(RpFastHttpParserImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    self->m_head = g_string_sized_new(256/*REVISIT-arbitrary*/);
+    return self;
+}
+
+RpFastHttpParserImpl*
+rp_fast_http_parser_impl_new(RpMessageType_e type, RpParserCallbacks* callbacks)
+{
+    LOGD("(%d, %p)", type, callbacks);
+    RpFastHttpParserImpl* self = g_object_new(RP_TYPE_FAST_HTTP_PARSER_IMPL, NULL);
+    self->m_type = type;
+    self->m_callbacks = callbacks;
+    return constructed(self);
+}
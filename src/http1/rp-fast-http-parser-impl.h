@@ -0,0 +1,28 @@
+/*
+ * rp-fast-http-parser-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-parser.h"
+
+G_BEGIN_DECLS
+
+/*
+ * HTTP/1 parser that frames the request/status line and header block in one
+ * pass using vectorized delimiter scans (AVX2 or SSE4.2 when the CPU has
+ * them, scalar otherwise). Drives the same RpParserCallbacks sequence as
+ * RpLegacyHttpParserImpl so the two are interchangeable.
+ */
+#define RP_TYPE_FAST_HTTP_PARSER_IMPL rp_fast_http_parser_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpFastHttpParserImpl, rp_fast_http_parser_impl, RP, FAST_HTTP_PARSER_IMPL, GObject)
+
+RpFastHttpParserImpl* rp_fast_http_parser_impl_new(RpMessageType_e type,
+                                                    RpParserCallbacks* callbacks);
+
+G_END_DECLS
@@ -14,6 +14,7 @@
 #endif
 
 #include "rp-header-utility.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-request-encoder-impl.h"
 #include "rp-http1-client-connection-impl.h"
@@ -105,7 +106,7 @@ OVERRIDE void
 alloc_headers(RpHttp1ConnectionImpl* self)
 {
     NOISY_MSG_("(%p)", self);
-    RP_HTTP1_CLIENT_CONNECTION_IMPL(self)->m_headers_or_trailers = evhtp_headers_new();
+    RP_HTTP1_CLIENT_CONNECTION_IMPL(self)->m_headers_or_trailers = rp_header_map_new();
 }
 
 OVERRIDE RpStatusCode_e
@@ -135,8 +136,8 @@ headers_set_status(evhtp_headers_t* headers, evhtp_res status_code)
     NOISY_MSG_("(%p, %d)", headers, status_code);
     char buf[1278];
     sprintf(buf, "%d", status_code);
-    evhtp_headers_add_header(headers,
-        evhtp_header_new(RpHeaderValues.Status, buf, false, true));
+    rp_header_map_add_header(headers,
+        RpHeaderValues.Status, buf, false, true);
 }
 
 OVERRIDE RpStatusOrCallbackResult
@@ -169,14 +170,14 @@ g_assert(!me->m_pending_response_done);
 
         if (status_code < EVHTP_RES_OK || status_code == EVHTP_RES_NOCONTENT)
         {
-            if (evhtp_header_find(headers, RpHeaderValues.TransferEncoding))
+            if (rp_header_map_get_inline(headers, RpInlineHeader_TransferEncoding))
             {
                 RETURN_IF_ERROR_2(
                     rp_http1_connection_impl_send_protocol_error(self, "transfer_encoding_not_allowed"));
                 return rp_status_or_callback_result_ctor(RpStatusCode_CodecProtocolError, 0);
             }
 
-            evhtp_header_t* content_length = evhtp_headers_find_header(headers, RpHeaderValues.ContentLength);
+            evhtp_header_t* content_length = rp_header_map_get_inline_header(headers, RpInlineHeader_ContentLength);
             if (content_length)
             {
                 if (content_length->vlen != 1 || content_length->val[0] != '0')
@@ -186,7 +187,7 @@ g_assert(!me->m_pending_response_done);
                     return rp_status_or_callback_result_ctor(RpStatusCode_CodecProtocolError, 0);
                 }
 
-                evhtp_header_rm_and_free(headers, content_length);
+                rp_header_map_remove(headers, content_length);
             }
         }
 
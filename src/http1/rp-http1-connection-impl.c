@@ -14,9 +14,11 @@
 #endif
 
 #include "rp-codec.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-http-utility.h"
 #include "rp-parser.h"
+#include "rp-fast-http-parser-impl.h"
 #include "rp-legacy-http-parser-impl.h"
 #include "rp-http1-connection-impl.h"
 
@@ -38,6 +40,12 @@ struct _RpHttp1ConnectionImplPrivate {
     evbuf_t* m_current_dispatching_buffer;
     evbuf_t* m_output_buffer; // Not owned.
 
+    // First chain of |m_current_dispatching_buffer| being parsed, and how much
+    // of it buffer_body_i() has already moved out of that buffer.
+    const char* m_dispatching_slice;
+    gsize m_dispatching_slice_len;
+    gsize m_dispatching_slice_drained;
+
     GString* m_current_header_field;
     GString* m_current_header_value;
 
@@ -58,7 +66,6 @@ struct _RpHttp1ConnectionImplPrivate {
     bool m_reset_stream_called : 1;
     bool m_deferred_end_stream_headers : 1;
     bool m_dispatching : 1;
-    bool m_dispatching_slice_already_drained : 1;
 };
 
 enum
@@ -209,20 +216,22 @@ dispatch(RpHttp1ConnectionImpl* self, evbuf_t* data)
                 LOGD("peek() returned %d", n);
             }
 
-            me->m_dispatching_slice_already_drained = false;
+            me->m_dispatching_slice = v[0].iov_base;
+            me->m_dispatching_slice_len = v[0].iov_len;
+            me->m_dispatching_slice_drained = 0;
 
             RpStatusOrSize statusor_parsed = dispatch_slice(self, v[0].iov_base, v[0].iov_len);
+            me->m_dispatching_slice = NULL;
             if (!rp_status_or_size_ok(&statusor_parsed))
             {
                 NOISY_MSG_("returning %d", rp_status_or_size_status(&statusor_parsed));
                 return rp_status_or_size_status(&statusor_parsed);
             }
-            if (!me->m_dispatching_slice_already_drained)
-            {
-                g_assert(rp_status_or_size_value(&statusor_parsed) <= v[0].iov_len);
-                NOISY_MSG_("draining %zu bytes", rp_status_or_size_value(&statusor_parsed));
-                evbuffer_drain(data, rp_status_or_size_value(&statusor_parsed));
-            }
+
+            g_assert(rp_status_or_size_value(&statusor_parsed) <= v[0].iov_len);
+            g_assert(rp_status_or_size_value(&statusor_parsed) >= me->m_dispatching_slice_drained);
+            NOISY_MSG_("draining %zu bytes", rp_status_or_size_value(&statusor_parsed) - me->m_dispatching_slice_drained);
+            evbuffer_drain(data, rp_status_or_size_value(&statusor_parsed) - me->m_dispatching_slice_drained);
 
             total_parsed += rp_status_or_size_value(&statusor_parsed);
             if (rp_parser_get_status(parser) != RpParserStatus_Ok)
@@ -352,18 +361,23 @@ buffer_body_i(RpParserCallbacks* self, const char * data, size_t length)
     NOISY_MSG_("(%p, %p, %zu)", self, data, length);
 
     RpHttp1ConnectionImplPrivate* me = PRIV(self);
-
-    struct evbuffer_iovec v[1];
-    int n = evbuffer_peek(me->m_current_dispatching_buffer, -1, NULL, v, 1);
-    if (n != 1)
-    {
-        LOGD("peek() returned %d", n);
-    }
-    if ((void*)data == v[0].iov_base && length == v[0].iov_len)
+    const char* slice = me->m_dispatching_slice;
+
+    // When the body bytes are still in the dispatching buffer, hand them over
+    // by chain transfer instead of copying. Anything in front of them in the
+    // slice has already been consumed by the parser, so it is drained first.
+    if (slice &&
+        data >= slice + me->m_dispatching_slice_drained &&
+        data + length <= slice + me->m_dispatching_slice_len)
     {
-        evbuffer_add(me->m_buffered_body, v[0].iov_base, length);
-        evbuffer_drain(me->m_current_dispatching_buffer, length);
-        me->m_dispatching_slice_already_drained = true;
+        gsize skip = data - (slice + me->m_dispatching_slice_drained);
+        if (skip > 0)
+        {
+            evbuffer_drain(me->m_current_dispatching_buffer, skip);
+        }
+        evbuffer_remove_buffer(me->m_current_dispatching_buffer, me->m_buffered_body, length);
+        me->m_dispatching_slice_drained = (data - slice) + length;
+        NOISY_MSG_("moved %zu bytes, %zu of slice drained", length, me->m_dispatching_slice_drained);
     }
     else
     {
@@ -413,8 +427,8 @@ complete_current_header(RpHttp1ConnectionImpl* self)
         GString* field = g_string_ascii_down(me->m_current_header_field);
         gchar* value = g_strchomp(me->m_current_header_value->str);
 
-        evhtp_headers_add_header(headers_or_trailers,
-                                    evhtp_header_new(field->str, value, 1, 1));
+        rp_header_map_add_copy(headers_or_trailers,
+                                field->str, field->len, value, strlen(value));
         g_string_truncate(field, 0);
         g_string_truncate(me->m_current_header_value, 0);
     }
@@ -528,13 +542,13 @@ on_headers_complete_impl(RpHttp1ConnectionImpl* self)
     if (g_ascii_strcasecmp(method_name, RpHeaderValues.MethodValues.Connect) == 0)
     {
         NOISY_MSG_("CONNECT");
-        evhtp_header_t* h = evhtp_headers_find_header(request_or_response_headers, RpHeaderValues.ContentLength);
+        evhtp_header_t* h = rp_header_map_get_inline_header(request_or_response_headers, RpInlineHeader_ContentLength);
         if (h)
         {
             if (h->vlen == 1 && h->val[0] == '0')
             {
                 NOISY_MSG_("removing content-length header");
-                evhtp_header_rm_and_free(request_or_response_headers, h);
+                rp_header_map_remove(request_or_response_headers, h);
             }
             else
             {
@@ -546,13 +560,13 @@ on_headers_complete_impl(RpHttp1ConnectionImpl* self)
         me->m_handling_upgrade = true;
     }
 
-    if (rp_parser_has_transfer_encoding(parser) != 0 && evhtp_header_find(request_or_response_headers, RpHeaderValues.ContentLength))
+    if (rp_parser_has_transfer_encoding(parser) != 0 && rp_header_map_get_inline(request_or_response_headers, RpInlineHeader_ContentLength))
     {
         if (rp_parser_is_chunked(parser) && me->m_codec_settings->m_allow_chunked_length)
         {
             NOISY_MSG_("removing content-length header");
-            evhtp_header_rm_and_free(request_or_response_headers,
-                evhtp_headers_find_header(request_or_response_headers, RpHeaderValues.ContentLength));
+            rp_header_map_remove(request_or_response_headers,
+                rp_header_map_get_inline_header(request_or_response_headers, RpInlineHeader_ContentLength));
         }
         else
         {
@@ -562,7 +576,7 @@ on_headers_complete_impl(RpHttp1ConnectionImpl* self)
         }
     }
 
-    const char* encoding = evhtp_header_find(request_or_response_headers, RpHeaderValues.TransferEncoding);
+    const char* encoding = rp_header_map_get_inline(request_or_response_headers, RpInlineHeader_TransferEncoding);
     if (encoding)
     {
         if ((g_ascii_strcasecmp(encoding, RpHeaderValues.TransferCodingValues.Chunked) != 0) ||
@@ -738,7 +752,13 @@ static RpParser*
 create_parser(RpHttp1ConnectionImpl* self)
 {
     NOISY_MSG_("(%p)", self);
-    return RP_PARSER(rp_legacy_http_parser_impl_new(PRIV(self)->m_message_type,
+    RpHttp1ConnectionImplPrivate* me = PRIV(self);
+    if (me->m_codec_settings && me->m_codec_settings->m_use_fast_parser)
+    {
+        return RP_PARSER(rp_fast_http_parser_impl_new(me->m_message_type,
+                                                        RP_PARSER_CALLBACKS(self)));
+    }
+    return RP_PARSER(rp_legacy_http_parser_impl_new(me->m_message_type,
                                                     RP_PARSER_CALLBACKS(self)));
 }
 
@@ -16,6 +16,7 @@
 #include "rproxy.h"
 #include "rp-net-conn-impl.h"
 #include "rp-dispatcher.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-parser.h"
 #include "rp-response-encoder-impl.h"
@@ -279,7 +280,7 @@ alloc_headers(RpHttp1ConnectionImpl* self)
 {
     NOISY_MSG_("(%p)", self);
     RpHttp1ServerConnectionImpl* me = RP_HTTP1_SERVER_CONNECTION_IMPL(self);
-    me->m_headers_or_trailers = evhtp_headers_new();
+    me->m_headers_or_trailers = rp_header_map_new();
 }
 
 OVERRIDE void
@@ -287,7 +288,7 @@ alloc_trailers(RpHttp1ConnectionImpl* self)
 {
     NOISY_MSG_("(%p)", self);
     RpHttp1ServerConnectionImpl* me = RP_HTTP1_SERVER_CONNECTION_IMPL(self);
-    me->m_headers_or_trailers = evhtp_headers_new();
+    me->m_headers_or_trailers = rp_header_map_new();
 }
 
 OVERRIDE evhtp_headers_t*
@@ -388,8 +389,8 @@ handle_path(RpHttp1ServerConnectionImpl* self, evhtp_headers_t* request_headers,
                 active_request->m_request_url->str[0] == '*')))
     {
         NOISY_MSG_("here");
-        evhtp_headers_add_header(request_headers,
-            evhtp_header_new(path, active_request->m_request_url->str, 0, 1));
+        rp_header_map_add_header(request_headers,
+            path, active_request->m_request_url->str, 0, 1);
         g_string_free_and_clear(&active_request->m_request_url);
         return RpStatusCode_Ok;
     }
@@ -397,8 +398,8 @@ handle_path(RpHttp1ServerConnectionImpl* self, evhtp_headers_t* request_headers,
     if (!self->m_settings.m_allow_absolute_url && !is_connect)
     {
         NOISY_MSG_("here");
-        evhtp_headers_add_header(request_headers,
-            evhtp_header_new(path, active_request->m_request_url->str, 0, 0));
+        rp_header_map_add_header(request_headers,
+            path, active_request->m_request_url->str, 0, 1);
         g_string_free_and_clear(&active_request->m_request_url);
         return RpStatusCode_Ok;
     }
@@ -414,8 +415,8 @@ handle_path(RpHttp1ServerConnectionImpl* self, evhtp_headers_t* request_headers,
     }
 
     gchar* host_and_port = url_host_and_port(absolute_url);
-    evhtp_headers_add_header(request_headers,
-                    evhtp_header_new(RpHeaderValues.Host, host_and_port, 0, 1));
+    rp_header_map_add_header(request_headers,
+                    RpHeaderValues.Host, host_and_port, 0, 1);
     // Set the requested server name for use by other modules throughout the
     // request lifecycle.
     rp_connection_info_setter_set_requested_server_name(
@@ -425,8 +426,8 @@ handle_path(RpHttp1ServerConnectionImpl* self, evhtp_headers_t* request_headers,
     if (!is_connect)
     {
         NOISY_MSG_("here");
-        evhtp_headers_add_header(request_headers,
-            evhtp_header_new(RpHeaderValues.Scheme, g_uri_get_scheme(absolute_url), 0, 1));
+        rp_header_map_add_header(request_headers,
+            RpHeaderValues.Scheme, g_uri_get_scheme(absolute_url), 0, 1);
         //TODO...
     }
 
@@ -434,8 +435,8 @@ handle_path(RpHttp1ServerConnectionImpl* self, evhtp_headers_t* request_headers,
     if (path_and_query_params && path_and_query_params[0])
     {
         NOISY_MSG_("here");
-        evhtp_headers_add_header(request_headers,
-                        evhtp_header_new(path, path_and_query_params, 0, 1));
+        rp_header_map_add_header(request_headers,
+                        path, path_and_query_params, 0, 1);
     }
     g_string_free_and_clear(&active_request->m_request_url);
     return RpStatusCode_Ok;
@@ -465,8 +466,8 @@ on_headers_complete_base(RpHttp1ConnectionImpl* self)
 
         RETURN_IF_ERROR_2(handle_path(me, headers, method_name));
 
-        evhtp_headers_add_header(headers,
-                    evhtp_header_new(RpHeaderValues.Method, method_name, 0, 1));
+        rp_header_map_add_header(headers,
+                    RpHeaderValues.Method, method_name, 0, 1);
         RETURN_IF_ERROR_2(check_protocol_version(me, headers));
 
         //TODO...requestHeadersValue(...)
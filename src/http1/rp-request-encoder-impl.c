@@ -16,6 +16,7 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-header-utility.h"
 #include "rp-http-utility.h"
@@ -42,9 +43,9 @@ encode_headers_i(RpRequestEncoder* self, evhtp_headers_t* request_headers, bool
     NOISY_MSG_("(%p, %p, %u)", self, request_headers, end_stream);
 
     RpRequestEncoderImpl* me = RP_REQUEST_ENCODER_IMPL(self);
-    const char* method = evhtp_header_find(request_headers, RpHeaderValues.Method);
-    const char* path = evhtp_header_find(request_headers, RpHeaderValues.Path);
-    const char* host = evhtp_header_find(request_headers, RpHeaderValues.Host);
+    const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+    const char* path = rp_header_map_get_inline(request_headers, RpInlineHeader_Path);
+    const char* host = rp_header_map_get_inline(request_headers, RpInlineHeader_Authority);
     bool is_connect = rp_header_utility_is_connect(request_headers);
 
     if (g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Head) == 0)
@@ -65,14 +66,18 @@ encode_headers_i(RpRequestEncoder* self, evhtp_headers_t* request_headers, bool
 
     //TODO:...
 
-    evbuf_t* output = rp_http1_connection_impl_buffer(me->m_connection);
-    evbuffer_add(output, method, strlen(method));
-    evbuffer_add(output, " ", 1);
-    is_connect ? evbuffer_add(output, host, strlen(host)) : evbuffer_add(output, path, strlen(path));
-    evbuffer_add(output, " HTTP/1.1\r\n", 11);
+    const char* target = is_connect ? host : path;
+    struct string_view_s request_line[] = {
+        string_view_ctor(method, strlen(method)),
+        string_view_ctor(" ", 1),
+        string_view_ctor(target, strlen(target)),
+        string_view_ctor(" HTTP/1.1\r\n", 11)
+    };
 
-NOISY_MSG_("calling rp_stream_encoder_impl_encode_headers_base(%p, %p, 0, %u, 1)", self, request_headers, end_stream);
+NOISY_MSG_("calling rp_stream_encoder_impl_encode_headers_base(%p, %p, %u, %p, 0, %u, 1)", self, request_line, G_N_ELEMENTS(request_line), request_headers, end_stream);
     rp_stream_encoder_impl_encode_headers_base(RP_STREAM_ENCODER_IMPL(self),
+                                                request_line,
+                                                G_N_ELEMENTS(request_line),
                                                 request_headers,
                                                 0,
                                                 end_stream,
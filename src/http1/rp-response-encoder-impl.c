@@ -73,12 +73,13 @@ encode_headers_i(RpResponseEncoder* self, evhtp_headers_t* response_headers, boo
     int status_code_len = snprintf(status_code, sizeof(status_code), "%d", numeric_status);
     const char* reason_phrase = evhtp_get_status_code_str(numeric_status);
 
-    evbuf_t* output = rp_http1_connection_impl_buffer(me->m_connection);
-    evbuffer_add(output, response_prefix, strlen(response_prefix));
-    evbuffer_add(output, status_code, status_code_len);
-    evbuffer_add(output, " ", 1);
-    evbuffer_add(output, reason_phrase, strlen(reason_phrase));
-    evbuffer_add(output, "\r\n", 2);
+    struct string_view_s status_line[] = {
+        string_view_ctor(response_prefix, strlen(response_prefix)),
+        string_view_ctor(status_code, status_code_len),
+        string_view_ctor(" ", 1),
+        string_view_ctor(reason_phrase, strlen(reason_phrase)),
+        string_view_ctor("\r\n", 2)
+    };
 
     if (numeric_status >= 300)
     {
@@ -87,6 +88,8 @@ encode_headers_i(RpResponseEncoder* self, evhtp_headers_t* response_headers, boo
     }
 
     rp_stream_encoder_impl_encode_headers_base(RP_STREAM_ENCODER_IMPL(self),
+                                                status_line,
+                                                G_N_ELEMENTS(status_line),
                                                 response_headers,
                                                 numeric_status,
                                                 end_stream,
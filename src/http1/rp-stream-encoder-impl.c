@@ -13,6 +13,7 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-http-utility.h"
 #include "rp-stream-encoder-impl.h"
@@ -214,7 +215,9 @@ encode_data_i(RpStreamEncoder* self, evbuf_t* data, bool end_stream)
         evbuf_t* output = rp_http1_connection_impl_buffer(me->m_connection);
         if (me->m_chunk_encoding)
         {
-            evbuffer_add_printf(output, "%x\r\n", (unsigned)length);
+            char chunk_header[sizeof(size_t) * 2 + 3];
+            int chunk_header_len = snprintf(chunk_header, sizeof(chunk_header), "%zx\r\n", length);
+            evbuffer_add(output, chunk_header, chunk_header_len);
         }
 
         evbuffer_add_buffer(output, data);
@@ -340,33 +343,60 @@ rp_stream_encoder_impl_init(RpStreamEncoderImpl* self)
     me->m_is_response_to_connect_request = false;
 }
 
+static inline const char*
+header_key_to_use(evhtp_header_t* header, bool translate_authority, size_t* key_size)
+{
+    const char* key_to_use = header->key;
+    *key_size = header->klen;
+    // Translate :authority -> host so that upper layers to not need to deal
+    // with this.
+    if (translate_authority && *key_size > 1 && key_to_use[0] == ':' && key_to_use[1] == 'a')
+    {
+        key_to_use = RpHeaderValues.HostLegacy;
+        *key_size = strlen(key_to_use);
+    }
+    // Skip all headers starting with ':' that make it here.
+    return key_to_use[0] == ':' ? NULL : key_to_use;
+}
+
+static inline char*
+copy_to(char* dst, const char* src, size_t len)
+{
+    memcpy(dst, src, len);
+    return dst + len;
+}
+
 void
-rp_stream_encoder_impl_encode_headers_base(RpStreamEncoderImpl* self, evhtp_headers_t* headers, evhtp_res status, bool end_stream, bool bodiless_request)
+rp_stream_encoder_impl_encode_headers_base(RpStreamEncoderImpl* self, const struct string_view_s* start_line, guint start_line_count,
+                                            evhtp_headers_t* headers, evhtp_res status, bool end_stream, bool bodiless_request)
 {
-    LOGD("(%p, %p, %d, %u, %u)", self, headers, status, end_stream, bodiless_request);
+    LOGD("(%p, %p, %u, %p, %d, %u, %u)", self, start_line, start_line_count, headers, status, end_stream, bodiless_request);
 
     g_return_if_fail(RP_IS_STREAM_ENCODER_IMPL(self));
     g_return_if_fail(headers != NULL);
 
     RpStreamEncoderImplPrivate* me = PRIV(self);
     size_t content_length_len = strlen(RpHeaderValues.ContentLength);
+    size_t transfer_encoding_len = strlen(RpHeaderValues.TransferEncoding);
+    size_t chunked_len = strlen(RpHeaderValues.TransferCodingValues.Chunked);
+    //TODO: not part of the envoy code; don't know how they avoid dup host: headers(?)
+    bool translate_authority = !rp_header_map_get_inline(headers, RpInlineHeader_HostLegacy);
     bool saw_content_length = false;
-    evbuf_t* output = rp_http1_connection_impl_buffer(me->m_connection);
+    bool add_zero_content_length = false;
+    bool add_chunked = false;
+    size_t size = 0;
+
+    // Size everything up front so the whole header block can be written into
+    // one contiguous region of the output buffer.
+    for (guint i = 0; i < start_line_count; ++i)
+    {
+        size += start_line[i].m_length;
+    }
     for (evhtp_header_t* header=TAILQ_FIRST(headers); header; header = TAILQ_NEXT(header, next))
     {
-        const char* key_to_use = header->key;
-        size_t key_size_to_use = header->klen;
-        // Translate :authority -> host so that upper layers to not need to deal
-        // with this.
-        if (key_size_to_use > 1 && key_to_use[0] == ':' && key_to_use[1] == 'a' &&
-            !evhtp_header_find(headers, RpHeaderValues.HostLegacy)/*TODO: not part of the envoy code; don't know how they avoid dup host: headers(?)*/)
-        {
-            key_to_use = RpHeaderValues.HostLegacy;
-            key_size_to_use = strlen(key_to_use);
-        }
-
-        // Skip all headers starting with ':' that make it here.
-        if (key_to_use[0] == ':')
+        size_t key_size_to_use;
+        const char* key_to_use = header_key_to_use(header, translate_authority, &key_size_to_use);
+        if (!key_to_use)
         {
             continue;
         }
@@ -378,10 +408,7 @@ rp_stream_encoder_impl_encode_headers_base(RpStreamEncoderImpl* self, evhtp_head
             saw_content_length = true;
         }
 
-        evbuffer_add(output, key_to_use, key_size_to_use);
-        evbuffer_add(output, ": ", 2);
-        evbuffer_add(output, header->val, header->vlen);
-        evbuffer_add(output, "\r\n", 2);
+        size += key_size_to_use + 2 + header->vlen + 2;
     }
 
     if (saw_content_length || me->m_disable_chunk_encoding)
@@ -402,11 +429,7 @@ rp_stream_encoder_impl_encode_headers_base(RpStreamEncoderImpl* self, evhtp_head
         {
             if (!status || (status >= 200 && status != 204))
             {
-                if (!bodiless_request)
-                {
-                    evbuffer_add(output, RpHeaderValues.ContentLength, content_length_len);
-                    evbuffer_add(output, ": 0\r\n", 5);
-                }
+                add_zero_content_length = !bodiless_request;
             }
             me->m_chunk_encoding = false;
         }
@@ -416,20 +439,67 @@ rp_stream_encoder_impl_encode_headers_base(RpStreamEncoderImpl* self, evhtp_head
         }
         else
         {
-            if (!me->m_is_response_to_connect_request)
-            {
-                evbuffer_add(output, RpHeaderValues.TransferEncoding, strlen(RpHeaderValues.TransferEncoding));
-                evbuffer_add(output, ": ", 2);
-                evbuffer_add(output, RpHeaderValues.TransferCodingValues.Chunked, strlen(RpHeaderValues.TransferCodingValues.Chunked));
-                evbuffer_add(output, "\r\n", 2);
-            }
+            add_chunked = !me->m_is_response_to_connect_request;
             me->m_chunk_encoding = !http_utility_is_upgrade(headers) &&
                                     !me->m_is_response_to_head_request &&
                                     !me->m_is_response_to_connect_request;
         }
     }
 
-    evbuffer_add(output, "\r\n", 2);
+    if (add_zero_content_length)
+    {
+        size += content_length_len + 5;
+    }
+    if (add_chunked)
+    {
+        size += transfer_encoding_len + 2 + chunked_len + 2;
+    }
+    size += 2;
+
+    evbuf_t* output = rp_http1_connection_impl_buffer(me->m_connection);
+    struct evbuffer_iovec iov;
+    if (evbuffer_reserve_space(output, size, &iov, 1) != 1)
+    {
+        LOGE("failed to reserve %zu bytes", size);
+        return;
+    }
+
+    char* p = iov.iov_base;
+    for (guint i = 0; i < start_line_count; ++i)
+    {
+        p = copy_to(p, start_line[i].m_data, start_line[i].m_length);
+    }
+    for (evhtp_header_t* header=TAILQ_FIRST(headers); header; header = TAILQ_NEXT(header, next))
+    {
+        size_t key_size_to_use;
+        const char* key_to_use = header_key_to_use(header, translate_authority, &key_size_to_use);
+        if (!key_to_use)
+        {
+            continue;
+        }
+
+        p = copy_to(p, key_to_use, key_size_to_use);
+        p = copy_to(p, ": ", 2);
+        p = copy_to(p, header->val, header->vlen);
+        p = copy_to(p, "\r\n", 2);
+    }
+    if (add_zero_content_length)
+    {
+        p = copy_to(p, RpHeaderValues.ContentLength, content_length_len);
+        p = copy_to(p, ": 0\r\n", 5);
+    }
+    if (add_chunked)
+    {
+        p = copy_to(p, RpHeaderValues.TransferEncoding, transfer_encoding_len);
+        p = copy_to(p, ": ", 2);
+        p = copy_to(p, RpHeaderValues.TransferCodingValues.Chunked, chunked_len);
+        p = copy_to(p, "\r\n", 2);
+    }
+    p = copy_to(p, "\r\n", 2);
+
+    g_assert((size_t)(p - (char*)iov.iov_base) == size);
+    iov.iov_len = size;
+    evbuffer_commit_space(output, &iov, 1);
 
     if (end_stream)
     {
@@ -11,6 +11,7 @@
 #include <glib-object.h>
 #include "rp-http1-connection-impl.h"
 #include "rp-codec-helper.h"
+#include "rp-http-utility.h"
 
 G_BEGIN_DECLS
 
@@ -25,7 +26,10 @@ struct _RpStreamEncoderImplClass {
 
 };
 
+/* Writes |start_line| followed by the encoded |headers| in a single pass. */
 void rp_stream_encoder_impl_encode_headers_base(RpStreamEncoderImpl* self,
+                                                const struct string_view_s* start_line,
+                                                guint start_line_count,
                                                 evhtp_headers_t* headers,
                                                 evhtp_res status,
                                                 bool end_stream,
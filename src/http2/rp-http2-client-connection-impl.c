@@ -0,0 +1,101 @@
+/*
+ * rp-http2-client-connection-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http2_client_connection_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http2_client_connection_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "http2/rp-http2-request-encoder-impl.h"
+#include "http2/rp-http2-client-connection-impl.h"
+
+struct _RpHttp2ClientConnectionImpl {
+    RpHttp2ConnectionImpl parent_instance;
+};
+
+static void http_client_connection_iface_init(RpHttpClientConnectionInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpHttp2ClientConnectionImpl, rp_http2_client_connection_impl, RP_TYPE_HTTP2_CONNECTION_IMPL,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_CLIENT_CONNECTION, http_client_connection_iface_init)
+)
+
+static RpRequestEncoder*
+new_stream_i(RpHttpClientConnection* self, RpResponseDecoder* response_decoder)
+{
+    NOISY_MSG_("(%p, %p)", self, response_decoder);
+    RpHttp2ConnectionImpl* connection = RP_HTTP2_CONNECTION_IMPL(self);
+    RpHttp2RequestEncoderImpl* stream = rp_http2_request_encoder_impl_new(connection, response_decoder);
+    // The connection owns the stream from here on.
+    rp_http2_connection_impl_add_stream(connection, RP_HTTP2_STREAM_IMPL(stream));
+    return RP_REQUEST_ENCODER(stream);
+}
+
+static void
+http_client_connection_iface_init(RpHttpClientConnectionInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->new_stream = new_stream_i;
+}
+
+OVERRIDE int
+session_new(RpHttp2ConnectionImpl* self, nghttp2_session** session, const nghttp2_session_callbacks* callbacks, const nghttp2_option* option)
+{
+    NOISY_MSG_("(%p, %p, %p, %p)", self, session, callbacks, option);
+    return nghttp2_session_client_new2(session, callbacks, self, option);
+}
+
+OVERRIDE int
+on_begin_headers(RpHttp2ConnectionImpl* self, const nghttp2_frame* frame)
+{
+    NOISY_MSG_("(%p, %p)", self, frame);
+
+    // Push is disabled, so only responses (and their trailers) show up here.
+    if (frame->hd.type != NGHTTP2_HEADERS)
+    {
+        return 0;
+    }
+    RpHttp2StreamImpl* stream = rp_http2_connection_impl_get_stream(self, frame->hd.stream_id);
+    if (stream)
+    {
+        rp_http2_stream_impl_on_begin_headers(stream);
+    }
+    return 0;
+}
+
+static void
+rp_http2_client_connection_impl_class_init(RpHttp2ClientConnectionImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    RpHttp2ConnectionImplClass* connection_class = RP_HTTP2_CONNECTION_IMPL_CLASS(klass);
+    connection_class->session_new = session_new;
+    connection_class->on_begin_headers = on_begin_headers;
+}
+
+static void
+rp_http2_client_connection_impl_init(RpHttp2ClientConnectionImpl* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+RpHttp2ClientConnectionImpl*
+rp_http2_client_connection_impl_new(RpNetworkConnection* connection,
+                                    RpHttpConnectionCallbacks* callbacks,
+                                    const struct RpHttp2Settings_s* settings)
+{
+    LOGD("(%p, %p, %p)", connection, callbacks, settings);
+    g_return_val_if_fail(RP_IS_NETWORK_CONNECTION(connection), NULL);
+    g_return_val_if_fail(settings != NULL, NULL);
+    return g_object_new(RP_TYPE_HTTP2_CLIENT_CONNECTION_IMPL,
+                        "connection", connection,
+                        "callbacks", callbacks,
+                        "codec-settings", settings,
+                        NULL);
+}
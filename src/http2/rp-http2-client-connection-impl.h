@@ -0,0 +1,29 @@
+/*
+ * rp-http2-client-connection-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-codec.h"
+#include "http2/rp-http2-connection-impl.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Implementation of Http::ClientConnection for HTTP/2. Speaks prior-knowledge
+ * HTTP/2 (h2c, or h2 over an already negotiated TLS transport).
+ */
+// https://github.com/envoyproxy/envoy/blob/main/source/common/http/http2/codec_impl.h#L727
+#define RP_TYPE_HTTP2_CLIENT_CONNECTION_IMPL rp_http2_client_connection_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpHttp2ClientConnectionImpl, rp_http2_client_connection_impl, RP, HTTP2_CLIENT_CONNECTION_IMPL, RpHttp2ConnectionImpl)
+
+RpHttp2ClientConnectionImpl* rp_http2_client_connection_impl_new(RpNetworkConnection* connection,
+                                                                    RpHttpConnectionCallbacks* callbacks,
+                                                                    const struct RpHttp2Settings_s* settings);
+
+G_END_DECLS
@@ -0,0 +1,331 @@
+/*
+ * rp-http2-conn-pool.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http2_conn_pool_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http2_conn_pool_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rp-codec-client-prod.h"
+#include "rp-fixed-http-conn-pool-impl.h"
+#include "rp-upstream.h"
+#include "http2/rp-http2-conn-pool.h"
+
+// Used when the cluster does not say otherwise.
+#define DEFAULT_MAX_CONCURRENT_STREAMS 100
+
+#define PARENT_NETWORK_CONNECTION_CALLBACKS_IFACE(s) \
+    ((RpNetworkConnectionCallbacksInterface*)g_type_interface_peek_parent(RP_NETWORK_CONNECTION_CALLBACKS_GET_IFACE(s)))
+
+struct _RpHttp2CpActiveClient {
+    RpHttpConnPoolBaseActiveClient parent_instance;
+
+    RpHttpConnPoolImplBase* m_parent;
+
+    // Capacity handed back to the cluster when the peer lowered its limit;
+    // repaid one stream close at a time.
+    guint32 m_negative_capacity;
+
+    bool m_closed_with_active_rq : 1;
+};
+
+static void network_connection_callbacks_iface_init(RpNetworkConnectionCallbacksInterface* iface);
+static void codec_client_callbacks_iface_init(RpCodecClientCallbacksInterface* iface);
+static void http_connection_callbacks_iface_init(RpHttpConnectionCallbacksInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpHttp2CpActiveClient, rp_http2_cp_active_client, RP_TYPE_HTTP_CONN_POOL_BASE_ACTIVE_CLIENT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_NETWORK_CONNECTION_CALLBACKS, network_connection_callbacks_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_CODEC_CLIENT_CALLBACKS, codec_client_callbacks_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_CONNECTION_CALLBACKS, http_connection_callbacks_iface_init)
+)
+
+static inline RpConnPoolImplBase*
+parent_(RpHttp2CpActiveClient* self)
+{
+    return RP_CONN_POOL_IMPL_BASE(self->m_parent);
+}
+
+static inline RpCodecClient*
+codec_client_(RpHttp2CpActiveClient* self)
+{
+    return rp_http_conn_pool_base_active_client_codec_client_(RP_HTTP_CONN_POOL_BASE_ACTIVE_CLIENT(self));
+}
+
+static void
+on_event_i(RpNetworkConnectionCallbacks* self, RpNetworkConnectionEvent_e event)
+{
+    NOISY_MSG_("(%p, %d)", self, event);
+
+    RpHttp2CpActiveClient* me = RP_HTTP2_CP_ACTIVE_CLIENT(self);
+    if (event == RpNetworkConnectionEvent_RemoteClose ||
+        event == RpNetworkConnectionEvent_LocalClose)
+    {
+        me->m_closed_with_active_rq = rp_codec_client_num_active_requests(codec_client_(me)) > 0;
+    }
+    PARENT_NETWORK_CONNECTION_CALLBACKS_IFACE(self)->on_event(self, event);
+}
+
+static void
+on_above_write_buffer_high_water_mark_i(RpNetworkConnectionCallbacks* self)
+{
+    NOISY_MSG_("(%p)", self);
+    PARENT_NETWORK_CONNECTION_CALLBACKS_IFACE(self)->on_above_write_buffer_high_water_mark(self);
+}
+
+static void
+on_below_write_buffer_low_watermark_i(RpNetworkConnectionCallbacks* self)
+{
+    NOISY_MSG_("(%p)", self);
+    PARENT_NETWORK_CONNECTION_CALLBACKS_IFACE(self)->on_below_write_buffer_low_watermark(self);
+}
+
+static void
+network_connection_callbacks_iface_init(RpNetworkConnectionCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_event = on_event_i;
+    iface->on_above_write_buffer_high_water_mark = on_above_write_buffer_high_water_mark_i;
+    iface->on_below_write_buffer_low_watermark = on_below_write_buffer_low_watermark_i;
+}
+
+static void
+on_stream_pre_decode_complete_i(RpCodecClientCallbacks* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static void
+on_stream_destroy_i(RpCodecClientCallbacks* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHttp2CpActiveClient* me = RP_HTTP2_CP_ACTIVE_CLIENT(self);
+    rp_conn_pool_impl_base_on_stream_closed(parent_(me), RP_CONNECTION_POOL_ACTIVE_CLIENT(self), false);
+    // On disconnect the pool is checked once the connection event lands.
+    if (!me->m_closed_with_active_rq)
+    {
+        rp_conn_pool_impl_base_check_for_idle_and_close_idle_conns_if_draining(parent_(me));
+    }
+}
+
+static void
+on_stream_reset_i(RpCodecClientCallbacks* self G_GNUC_UNUSED, RpStreamResetReason_e reason G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %d)", self, reason);
+}
+
+static void
+codec_client_callbacks_iface_init(RpCodecClientCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_stream_pre_decode_complete = on_stream_pre_decode_complete_i;
+    iface->on_stream_destory = on_stream_destroy_i;
+    iface->on_stream_reset = on_stream_reset_i;
+}
+
+static void
+on_go_away_i(RpHttpConnectionCallbacks* self, RpGoAwayErrorCode_e error_code G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %d)", self, error_code);
+
+    RpHttp2CpActiveClient* me = RP_HTTP2_CP_ACTIVE_CLIENT(self);
+    LOGD("remote goaway");
+    if (rp_codec_client_num_active_requests(codec_client_(me)) == 0)
+    {
+        rp_codec_client_close_(codec_client_(me));
+    }
+    else
+    {
+        rp_conn_pool_impl_base_transition_active_client_state(parent_(me),
+                                                                RP_CONNECTION_POOL_ACTIVE_CLIENT(self),
+                                                                RpConnectionPoolActiveClientState_Draining);
+    }
+}
+
+static void
+on_settings_i(RpHttpConnectionCallbacks* self, RpReceivedSettings* settings)
+{
+    NOISY_MSG_("(%p, %p)", self, settings);
+
+    RpHttp2CpActiveClient* me = RP_HTTP2_CP_ACTIVE_CLIENT(self);
+    RpConnectionPoolActiveClient* client = RP_CONNECTION_POOL_ACTIVE_CLIENT(self);
+    gint64 old_unused_capacity = rp_connection_pool_active_client_current_unused_capacity(client);
+
+    rp_connection_pool_active_client_set_concurrent_stream_limit(client,
+        MIN(rp_received_settings_max_concurrent_streams(settings),
+            rp_connection_pool_active_client_configured_stream_limit(client)));
+
+    gint64 unused_capacity = rp_connection_pool_active_client_current_unused_capacity(client);
+    gint64 delta = old_unused_capacity - unused_capacity;
+    RpConnectionPoolActiveClientState_e state = rp_connection_pool_active_client_state(client);
+    if (state == RpConnectionPoolActiveClientState_Ready && unused_capacity <= 0)
+    {
+        rp_conn_pool_impl_base_transition_active_client_state(parent_(me), client, RpConnectionPoolActiveClientState_Busy);
+    }
+    else if (state == RpConnectionPoolActiveClientState_Busy && unused_capacity > 0)
+    {
+        rp_conn_pool_impl_base_transition_active_client_state(parent_(me), client, RpConnectionPoolActiveClientState_Ready);
+    }
+
+    if (delta > 0)
+    {
+        NOISY_MSG_("decreasing stream capacity by %" G_GINT64_FORMAT, delta);
+        rp_conn_pool_impl_base_decr_cluster_stream_capacity(parent_(me), delta);
+        me->m_negative_capacity += delta;
+    }
+    // Raised limits are not handed out until streams close; see
+    // had_negative_delta_on_stream_closed().
+}
+
+static void
+on_max_streams_changed_i(RpHttpConnectionCallbacks* self G_GNUC_UNUSED, guint32 num_streams G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %u)", self, num_streams);
+}
+
+static void
+http_connection_callbacks_iface_init(RpHttpConnectionCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_go_away = on_go_away_i;
+    iface->on_settings = on_settings_i;
+    iface->on_max_streams_changed = on_max_streams_changed_i;
+}
+
+OVERRIDE bool
+closing_with_incomplete_stream(RpConnectionPoolActiveClient* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_HTTP2_CP_ACTIVE_CLIENT(self)->m_closed_with_active_rq;
+}
+
+OVERRIDE bool
+had_negative_delta_on_stream_closed(RpConnectionPoolActiveClient* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpHttp2CpActiveClient* me = RP_HTTP2_CP_ACTIVE_CLIENT(self);
+    if (me->m_negative_capacity > 0)
+    {
+        --me->m_negative_capacity;
+        return true;
+    }
+    return false;
+}
+
+static inline void
+connection_pool_active_client_class_init(RpConnectionPoolActiveClientClass* klass)
+{
+    LOGD("(%p)", klass);
+    klass->closing_with_incomplete_stream = closing_with_incomplete_stream;
+    klass->had_negative_delta_on_stream_closed = had_negative_delta_on_stream_closed;
+}
+
+OVERRIDE RpRequestEncoder*
+new_stream_encoder(RpHttpConnPoolBaseActiveClient* self, RpResponseDecoder* response_decoder)
+{
+    NOISY_MSG_("(%p, %p)", self, response_decoder);
+    return rp_codec_client_new_stream(codec_client_(RP_HTTP2_CP_ACTIVE_CLIENT(self)), response_decoder);
+}
+
+static inline void
+http_conn_pool_base_active_client_class_init(RpHttpConnPoolBaseActiveClientClass* klass)
+{
+    LOGD("(%p)", klass);
+    connection_pool_active_client_class_init(RP_CONNECTION_POOL_ACTIVE_CLIENT_CLASS(klass));
+    klass->new_stream_encoder = new_stream_encoder;
+}
+
+static void
+rp_http2_cp_active_client_class_init(RpHttp2CpActiveClientClass* klass)
+{
+    LOGD("(%p)", klass);
+    http_conn_pool_base_active_client_class_init(RP_HTTP_CONN_POOL_BASE_ACTIVE_CLIENT_CLASS(klass));
+}
+
+static void
+rp_http2_cp_active_client_init(RpHttp2CpActiveClient* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_negative_capacity = 0;
+    self->m_closed_with_active_rq = false;
+}
+
+static inline RpClusterInfoConstSharedPtr
+cluster_(RpHttpConnPoolImplBase* parent)
+{
+    return rp_host_description_cluster(
+            rp_connection_pool_instance_host(RP_CONNECTION_POOL_INSTANCE(parent)));
+}
+
+static inline guint32
+max_concurrent_streams(RpHttpConnPoolImplBase* parent)
+{
+    NOISY_MSG_("(%p)", parent);
+    const RpHttp2ProtocolOptionsCfg* options = rp_cluster_info_http2_options(cluster_(parent));
+    return options && options->max_concurrent_streams > 0 ?
+            options->max_concurrent_streams : DEFAULT_MAX_CONCURRENT_STREAMS;
+}
+
+RpHttp2CpActiveClient*
+rp_http2_cp_active_client_new(RpHttpConnPoolImplBase* parent, RpCreateConnectionDataPtr data)
+{
+    LOGD("(%p, %p)", parent, data);
+    g_return_val_if_fail(RP_IS_HTTP_CONN_POOL_IMPL_BASE(parent), NULL);
+    guint32 stream_limit = max_concurrent_streams(parent);
+    RpHttp2CpActiveClient* self = g_object_new(RP_TYPE_HTTP2_CP_ACTIVE_CLIENT,
+                                                "parent", parent,
+                                                "lifetime-stream-limit", rp_cluster_info_max_requests_per_connection(cluster_(parent)),
+                                                "effective-concurrent-streams", stream_limit,
+                                                "concurrent-stream-limit", stream_limit,
+                                                "opt-data", data,
+                                                NULL);
+    self->m_parent = parent;
+
+    RpCodecClient* codec_client = codec_client_(self);
+    rp_codec_client_set_codec_client_callbacks(codec_client, RP_CODEC_CLIENT_CALLBACKS(self));
+    rp_codec_client_set_codec_connection_callbacks(codec_client, RP_HTTP_CONNECTION_CALLBACKS(self));
+    return self;
+}
+
+static RpConnectionPoolActiveClientPtr
+client_fn(RpHttpConnPoolImplBase* pool)
+{
+    NOISY_MSG_("(%p)", pool);
+    return RP_CONNECTION_POOL_ACTIVE_CLIENT(rp_http2_cp_active_client_new(pool, NULL));
+}
+
+static RpCodecClientPtr
+codec_fn(RpCreateConnectionDataPtr data, RpHttpConnPoolImplBase* pool)
+{
+    NOISY_MSG_("(%p, %p)", data, pool);
+    RpDispatcher* dispatcher = rp_conn_pool_impl_base_dispatcher(RP_CONN_POOL_IMPL_BASE(pool));
+    RpCodecClientProd* codec = rp_codec_client_prod_new(RpCodecType_HTTP2,
+                                                        RP_NETWORK_CLIENT_CONNECTION(data->m_connection),
+                                                        data->m_host_description,
+                                                        dispatcher,
+                                                        false);
+    return RP_CODEC_CLIENT(codec);
+}
+
+RpHttpConnectionPoolInstancePtr
+http2_allocate_conn_pool(RpDispatcher* dispatcher, RpHost* host, RpResourcePriority_e priority)
+{
+    LOGD("(%p, %p, %d)", dispatcher, host, priority);
+    // The pool keeps the pointer.
+    static evhtp_proto protocols[] = {EVHTP_PROTO_2, EVHTP_PROTO_INVALID};
+    RpFixedHttpConnPoolImpl* pool = rp_fixed_http_conn_pool_impl_new(host,
+                                                                        priority,
+                                                                        dispatcher,
+                                                                        client_fn,
+                                                                        codec_fn,
+                                                                        protocols,
+                                                                        NULL);
+    return RP_HTTP_CONNECTION_POOL_INSTANCE(pool);
+}
@@ -0,0 +1,33 @@
+/*
+ * rp-http2-conn-pool.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-dispatcher.h"
+#include "rp-http-conn-pool-base.h"
+#include "rp-http-conn-pool-base-active-client.h"
+
+G_BEGIN_DECLS
+
+/**
+ * An active client for HTTP/2 connections. Multiplexes up to the lower of the
+ * configured and the peer advertised SETTINGS_MAX_CONCURRENT_STREAMS.
+ */
+// https://github.com/envoyproxy/envoy/blob/main/source/common/http/http2/conn_pool.h
+#define RP_TYPE_HTTP2_CP_ACTIVE_CLIENT rp_http2_cp_active_client_get_type()
+G_DECLARE_FINAL_TYPE(RpHttp2CpActiveClient, rp_http2_cp_active_client, RP, HTTP2_CP_ACTIVE_CLIENT, RpHttpConnPoolBaseActiveClient)
+
+RpHttp2CpActiveClient* rp_http2_cp_active_client_new(RpHttpConnPoolImplBase* parent,
+                                                        RpCreateConnectionDataPtr data);
+
+RpHttpConnectionPoolInstancePtr http2_allocate_conn_pool(RpDispatcher* dispatcher,
+                                                            RpHost* host,
+                                                            RpResourcePriority_e priority);
+
+G_END_DECLS
@@ -0,0 +1,662 @@
+/*
+ * rp-http2-connection-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http2_connection_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http2_connection_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rp-dispatcher.h"
+#include "http2/rp-http2-stream-impl.h"
+#include "http2/rp-http2-connection-impl.h"
+
+typedef struct _RpHttp2ConnectionImplPrivate RpHttp2ConnectionImplPrivate;
+struct _RpHttp2ConnectionImplPrivate {
+
+    RpNetworkConnection* m_connection;
+    RpHttpConnectionCallbacks* m_callbacks;
+    const struct RpHttp2Settings_s* m_settings;
+
+    nghttp2_session* m_session;
+    evbuf_t* m_output_buffer;
+
+    // Owned; released through deferred delete when nghttp2 closes the stream.
+    GList* m_active_streams;
+
+    guint32 m_received_max_concurrent_streams;
+
+    bool m_dispatching : 1;
+    bool m_goaway_sent : 1;
+    bool m_goaway_received : 1;
+};
+
+enum
+{
+    PROP_0, // Reserved.
+    PROP_CONNECTION,
+    PROP_CALLBACKS,
+    PROP_CODEC_SETTINGS,
+    N_PROPERTIES
+};
+
+static GParamSpec* obj_properties[N_PROPERTIES] = { NULL, };
+
+static void http_connection_interface_init(RpHttpConnectionInterface* iface);
+static void received_settings_interface_init(RpReceivedSettingsInterface* iface);
+
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE(RpHttp2ConnectionImpl, rp_http2_connection_impl, G_TYPE_OBJECT,
+    G_ADD_PRIVATE(RpHttp2ConnectionImpl)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_CONNECTION, http_connection_interface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_RECEIVED_SETTINGS, received_settings_interface_init)
+)
+
+#define PRIV(obj) \
+    ((RpHttp2ConnectionImplPrivate*)rp_http2_connection_impl_get_instance_private(RP_HTTP2_CONNECTION_IMPL(obj)))
+
+static RpStatusCode_e
+dispatch_i(RpHttpConnection* self, evbuf_t* data)
+{
+    NOISY_MSG_("(%p, %p(%zu))", self, data, data ? evbuffer_get_length(data) : 0);
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    RpStatusCode_e status = RpStatusCode_Ok;
+
+    // Stream callbacks may drop the last outside reference to the codec.
+    g_object_ref(self);
+    me->m_dispatching = true;
+
+    while (evbuffer_get_length(data) > 0)
+    {
+        size_t len = evbuffer_get_contiguous_space(data);
+        const guint8* p = evbuffer_pullup(data, len);
+        ssize_t rv = nghttp2_session_mem_recv(me->m_session, p, len);
+        if (rv < 0)
+        {
+            LOGE("nghttp2 recv error: %s", nghttp2_strerror((int)rv));
+            status = RpStatusCode_CodecProtocolError;
+            break;
+        }
+        evbuffer_drain(data, rv);
+    }
+    evbuffer_drain(data, evbuffer_get_length(data));
+
+    me->m_dispatching = false;
+    // Everything produced while dispatching (SETTINGS ACKs, WINDOW_UPDATEs and
+    // whatever the streams encoded) leaves in a single write.
+    rp_http2_connection_impl_send_pending_frames(RP_HTTP2_CONNECTION_IMPL(self));
+
+    g_object_unref(self);
+    return status;
+}
+
+static void
+go_away_i(RpHttpConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    if (me->m_goaway_sent)
+    {
+        return;
+    }
+    me->m_goaway_sent = true;
+    nghttp2_submit_goaway(me->m_session,
+                            NGHTTP2_FLAG_NONE,
+                            nghttp2_session_get_last_proc_stream_id(me->m_session),
+                            NGHTTP2_NO_ERROR,
+                            NULL,
+                            0);
+    rp_http2_connection_impl_send_pending_frames(RP_HTTP2_CONNECTION_IMPL(self));
+}
+
+static evhtp_proto
+protocol_i(RpHttpConnection* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+    return EVHTP_PROTO_2;
+}
+
+static void
+shutdown_notice_i(RpHttpConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    // Only meaningful (and only accepted by nghttp2) on the server side.
+    if (nghttp2_submit_shutdown_notice(me->m_session) == 0)
+    {
+        rp_http2_connection_impl_send_pending_frames(RP_HTTP2_CONNECTION_IMPL(self));
+    }
+}
+
+static bool
+wants_to_write_i(RpHttpConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return nghttp2_session_want_write(PRIV(self)->m_session);
+}
+
+static void
+on_underlying_connection_above_write_buffer_high_watermark_i(RpHttpConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+    for (GList* itr = PRIV(self)->m_active_streams; itr; itr = itr->next)
+    {
+        rp_stream_callback_helper_run_high_watermark_callbacks(RP_STREAM_CALLBACK_HELPER(itr->data));
+    }
+}
+
+static void
+on_underlying_connection_below_write_buffer_lo_watermark_i(RpHttpConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+    for (GList* itr = PRIV(self)->m_active_streams; itr; itr = itr->next)
+    {
+        rp_stream_callback_helper_run_low_watermark_callbacks(RP_STREAM_CALLBACK_HELPER(itr->data));
+    }
+}
+
+static bool
+should_keep_alive_i(RpHttpConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    return !me->m_goaway_sent && !me->m_goaway_received;
+}
+
+static void
+http_connection_interface_init(RpHttpConnectionInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->dispatch = dispatch_i;
+    iface->go_away = go_away_i;
+    iface->protocol = protocol_i;
+    iface->shutdown_notice = shutdown_notice_i;
+    iface->wants_to_write = wants_to_write_i;
+    iface->on_underlying_connection_above_write_buffer_high_watermark = on_underlying_connection_above_write_buffer_high_watermark_i;
+    iface->on_underlying_connection_below_write_buffer_lo_watermark = on_underlying_connection_below_write_buffer_lo_watermark_i;
+    iface->should_keep_alive = should_keep_alive_i;
+}
+
+static guint32
+max_concurrent_streams_i(RpReceivedSettings* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return PRIV(self)->m_received_max_concurrent_streams;
+}
+
+static void
+received_settings_interface_init(RpReceivedSettingsInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->max_concurrent_streams = max_concurrent_streams_i;
+}
+
+static ssize_t
+send_callback(nghttp2_session* session G_GNUC_UNUSED, const guint8* data, size_t length, int flags G_GNUC_UNUSED, void* user_data)
+{
+    NOISY_MSG_("(%p, %p, %zu, %d, %p)", session, data, length, flags, user_data);
+    evbuffer_add(PRIV(user_data)->m_output_buffer, data, length);
+    return length;
+}
+
+static int
+send_data_callback(nghttp2_session* session G_GNUC_UNUSED, nghttp2_frame* frame, const guint8* framehd,
+                    size_t length, nghttp2_data_source* source, void* user_data)
+{
+    NOISY_MSG_("(%p, %p, %p, %zu, %p, %p)", session, frame, framehd, length, source, user_data);
+    rp_http2_stream_impl_on_send_data(RP_HTTP2_STREAM_IMPL(source->ptr),
+                                        PRIV(user_data)->m_output_buffer,
+                                        framehd,
+                                        length,
+                                        frame->data.padlen);
+    return 0;
+}
+
+static int
+on_begin_headers_callback(nghttp2_session* session G_GNUC_UNUSED, const nghttp2_frame* frame, void* user_data)
+{
+    NOISY_MSG_("(%p, %p, %p)", session, frame, user_data);
+    RpHttp2ConnectionImpl* self = RP_HTTP2_CONNECTION_IMPL(user_data);
+    return RP_HTTP2_CONNECTION_IMPL_GET_CLASS(self)->on_begin_headers(self, frame);
+}
+
+static int
+on_header_callback(nghttp2_session* session G_GNUC_UNUSED, const nghttp2_frame* frame, const guint8* name, size_t namelen,
+                    const guint8* value, size_t valuelen, guint8 flags G_GNUC_UNUSED, void* user_data)
+{
+    NOISY_MSG_("(%p, %p, %p, %zu, %p, %zu, %u, %p)", session, frame, name, namelen, value, valuelen, flags, user_data);
+    RpHttp2StreamImpl* stream = rp_http2_connection_impl_get_stream(RP_HTTP2_CONNECTION_IMPL(user_data),
+                                                                    frame->hd.stream_id);
+    if (stream)
+    {
+        rp_http2_stream_impl_save_header(stream, name, namelen, value, valuelen);
+    }
+    return 0;
+}
+
+static void
+on_settings(RpHttp2ConnectionImpl* self, const nghttp2_settings* settings)
+{
+    NOISY_MSG_("(%p, %p)", self, settings);
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    bool max_concurrent_streams_changed = false;
+    for (size_t i = 0; i < settings->niv; ++i)
+    {
+        if (settings->iv[i].settings_id == NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)
+        {
+            me->m_received_max_concurrent_streams = settings->iv[i].value;
+            max_concurrent_streams_changed = true;
+        }
+    }
+    if (max_concurrent_streams_changed && me->m_callbacks)
+    {
+        rp_http_connection_callbacks_on_settings(me->m_callbacks, RP_RECEIVED_SETTINGS(self));
+    }
+}
+
+static int
+on_frame_recv_callback(nghttp2_session* session G_GNUC_UNUSED, const nghttp2_frame* frame, void* user_data)
+{
+    NOISY_MSG_("(%p, %p(%u), %p)", session, frame, frame->hd.type, user_data);
+
+    RpHttp2ConnectionImpl* self = RP_HTTP2_CONNECTION_IMPL(user_data);
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    bool end_stream = (frame->hd.flags & NGHTTP2_FLAG_END_STREAM) != 0;
+    RpHttp2StreamImpl* stream;
+
+    switch (frame->hd.type)
+    {
+        case NGHTTP2_HEADERS:
+            stream = rp_http2_connection_impl_get_stream(self, frame->hd.stream_id);
+            if (stream)
+            {
+                rp_http2_stream_impl_on_headers_complete(stream, end_stream);
+            }
+            break;
+        case NGHTTP2_DATA:
+            stream = rp_http2_connection_impl_get_stream(self, frame->hd.stream_id);
+            if (stream)
+            {
+                rp_http2_stream_impl_on_data_complete(stream, end_stream);
+            }
+            break;
+        case NGHTTP2_SETTINGS:
+            if (!(frame->hd.flags & NGHTTP2_FLAG_ACK))
+            {
+                on_settings(self, &frame->settings);
+            }
+            break;
+        case NGHTTP2_GOAWAY:
+            me->m_goaway_received = true;
+            if (me->m_callbacks)
+            {
+                rp_http_connection_callbacks_on_go_away(me->m_callbacks,
+                    frame->goaway.error_code == NGHTTP2_NO_ERROR ?
+                        RpGoAwayErrorCode_NoError : RpGoAwayErrorCode_Other);
+            }
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static int
+on_frame_send_callback(nghttp2_session* session G_GNUC_UNUSED, const nghttp2_frame* frame, void* user_data)
+{
+    NOISY_MSG_("(%p, %p(%u), %p)", session, frame, frame->hd.type, user_data);
+
+    if ((frame->hd.type == NGHTTP2_HEADERS || frame->hd.type == NGHTTP2_DATA) &&
+        (frame->hd.flags & NGHTTP2_FLAG_END_STREAM))
+    {
+        RpHttp2StreamImpl* stream = rp_http2_connection_impl_get_stream(RP_HTTP2_CONNECTION_IMPL(user_data),
+                                                                        frame->hd.stream_id);
+        if (stream)
+        {
+            rp_http2_stream_impl_on_end_stream_sent(stream);
+        }
+    }
+    return 0;
+}
+
+static int
+on_data_chunk_recv_callback(nghttp2_session* session, guint8 flags G_GNUC_UNUSED, gint32 stream_id,
+                            const guint8* data, size_t len, void* user_data)
+{
+    NOISY_MSG_("(%p, %u, %d, %p, %zu, %p)", session, flags, stream_id, data, len, user_data);
+    RpHttp2StreamImpl* stream = rp_http2_connection_impl_get_stream(RP_HTTP2_CONNECTION_IMPL(user_data), stream_id);
+    if (stream)
+    {
+        rp_http2_stream_impl_on_data(stream, data, len);
+    }
+    else
+    {
+        // Nobody will consume it; keep the connection window open.
+        nghttp2_session_consume_connection(session, len);
+    }
+    return 0;
+}
+
+static int
+on_stream_close_callback(nghttp2_session* session, gint32 stream_id, guint32 error_code, void* user_data)
+{
+    NOISY_MSG_("(%p, %d, %u, %p)", session, stream_id, error_code, user_data);
+
+    RpHttp2ConnectionImpl* self = RP_HTTP2_CONNECTION_IMPL(user_data);
+    RpHttp2StreamImpl* stream = rp_http2_connection_impl_get_stream(self, stream_id);
+    if (stream)
+    {
+        nghttp2_session_set_stream_user_data(session, stream_id, NULL);
+        if (!rp_http2_stream_impl_on_close(stream, error_code))
+        {
+            rp_http2_connection_impl_remove_stream(self, stream);
+        }
+    }
+    return 0;
+}
+
+static int
+on_invalid_frame_recv_callback(nghttp2_session* session G_GNUC_UNUSED, const nghttp2_frame* frame, int error_code, void* user_data G_GNUC_UNUSED)
+{
+    LOGD("invalid frame type %u on stream %d: %s", frame->hd.type, frame->hd.stream_id, nghttp2_strerror(error_code));
+    return 0;
+}
+
+static void
+send_settings(RpHttp2ConnectionImplPrivate* me)
+{
+    NOISY_MSG_("(%p)", me);
+
+    const struct RpHttp2Settings_s* settings = me->m_settings;
+    nghttp2_settings_entry iv[4];
+    size_t niv = 0;
+    iv[niv++] = (nghttp2_settings_entry){ NGHTTP2_SETTINGS_HEADER_TABLE_SIZE, settings->m_hpack_table_size };
+    iv[niv++] = (nghttp2_settings_entry){ NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, settings->m_max_concurrent_streams };
+    iv[niv++] = (nghttp2_settings_entry){ NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, settings->m_initial_stream_window_size };
+    if (!nghttp2_session_check_server_session(me->m_session))
+    {
+        iv[niv++] = (nghttp2_settings_entry){ NGHTTP2_SETTINGS_ENABLE_PUSH, 0 };
+    }
+
+    int rv = nghttp2_submit_settings(me->m_session, NGHTTP2_FLAG_NONE, iv, niv);
+    if (rv != 0)
+    {
+        LOGE("submit settings failed: %s", nghttp2_strerror(rv));
+    }
+
+    // The connection window can only be raised by WINDOW_UPDATE.
+    if (settings->m_initial_connection_window_size > NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE)
+    {
+        rv = nghttp2_session_set_local_window_size(me->m_session,
+                                                    NGHTTP2_FLAG_NONE,
+                                                    0,
+                                                    settings->m_initial_connection_window_size);
+        if (rv != 0)
+        {
+            LOGE("set local window size failed: %s", nghttp2_strerror(rv));
+        }
+    }
+}
+
+OVERRIDE void
+get_property(GObject* obj, guint prop_id, GValue* value, GParamSpec* pspec)
+{
+    NOISY_MSG_("(%p, %u, %p, %p(%s))", obj, prop_id, value, pspec, pspec->name);
+    switch (prop_id)
+    {
+        case PROP_CONNECTION:
+            g_value_set_object(value, PRIV(obj)->m_connection);
+            break;
+        case PROP_CALLBACKS:
+            g_value_set_object(value, PRIV(obj)->m_callbacks);
+            break;
+        case PROP_CODEC_SETTINGS:
+            g_value_set_pointer(value, (gpointer)PRIV(obj)->m_settings);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, prop_id, pspec);
+            break;
+    }
+}
+
+OVERRIDE void
+set_property(GObject* obj, guint prop_id, const GValue* value, GParamSpec* pspec)
+{
+    NOISY_MSG_("(%p, %u, %p, %p(%s))", obj, prop_id, value, pspec, pspec->name);
+    switch (prop_id)
+    {
+        case PROP_CONNECTION:
+            PRIV(obj)->m_connection = g_value_get_object(value);
+            break;
+        case PROP_CALLBACKS:
+            PRIV(obj)->m_callbacks = g_value_get_object(value);
+            break;
+        case PROP_CODEC_SETTINGS:
+            PRIV(obj)->m_settings = g_value_get_pointer(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, prop_id, pspec);
+            break;
+    }
+}
+
+OVERRIDE void
+constructed(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    G_OBJECT_CLASS(rp_http2_connection_impl_parent_class)->constructed(obj);
+
+    RpHttp2ConnectionImpl* self = RP_HTTP2_CONNECTION_IMPL(obj);
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    if (!me->m_settings)
+    {
+        me->m_settings = &RpHttp2Settings;
+    }
+    me->m_output_buffer = evbuffer_new();
+
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_send_callback(callbacks, send_callback);
+    nghttp2_session_callbacks_set_send_data_callback(callbacks, send_data_callback);
+    nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, on_begin_headers_callback);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, on_header_callback);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, on_frame_recv_callback);
+    nghttp2_session_callbacks_set_on_frame_send_callback(callbacks, on_frame_send_callback);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, on_data_chunk_recv_callback);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, on_stream_close_callback);
+    nghttp2_session_callbacks_set_on_invalid_frame_recv_callback(callbacks, on_invalid_frame_recv_callback);
+
+    nghttp2_option* option;
+    nghttp2_option_new(&option);
+    // Window updates are sent as the decoders actually consume body bytes.
+    nghttp2_option_set_no_auto_window_update(option, 1);
+
+    int rv = RP_HTTP2_CONNECTION_IMPL_GET_CLASS(self)->session_new(self, &me->m_session, callbacks, option);
+    nghttp2_option_del(option);
+    nghttp2_session_callbacks_del(callbacks);
+    if (rv != 0)
+    {
+        LOGE("session create failed: %s", nghttp2_strerror(rv));
+        return;
+    }
+
+    send_settings(me);
+    // The network connection buffers this until the transport is up.
+    rp_http2_connection_impl_send_pending_frames(self);
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(obj);
+    g_list_free_full(g_steal_pointer(&me->m_active_streams), g_object_unref);
+    g_clear_pointer(&me->m_session, nghttp2_session_del);
+    g_clear_pointer(&me->m_output_buffer, evbuffer_free);
+
+    G_OBJECT_CLASS(rp_http2_connection_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_http2_connection_impl_class_init(RpHttp2ConnectionImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->get_property = get_property;
+    object_class->set_property = set_property;
+    object_class->constructed = constructed;
+    object_class->dispose = dispose;
+
+    obj_properties[PROP_CONNECTION] = g_param_spec_object("connection",
+                                                    "Connection",
+                                                    "Network Connection Instance",
+                                                    RP_TYPE_NETWORK_CONNECTION,
+                                                    G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
+    obj_properties[PROP_CALLBACKS] = g_param_spec_object("callbacks",
+                                                    "Callbacks",
+                                                    "Http Connection Callbacks Instance",
+                                                    RP_TYPE_HTTP_CONNECTION_CALLBACKS,
+                                                    G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
+    obj_properties[PROP_CODEC_SETTINGS] = g_param_spec_pointer("codec-settings",
+                                                    "Codec settings",
+                                                    "Codec Settings",
+                                                    G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties(object_class, N_PROPERTIES, obj_properties);
+}
+
+static void
+rp_http2_connection_impl_init(RpHttp2ConnectionImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    // Until the peer says otherwise (RFC 9113 6.5.2).
+    me->m_received_max_concurrent_streams = G_MAXUINT32;
+    me->m_dispatching = false;
+    me->m_goaway_sent = false;
+    me->m_goaway_received = false;
+}
+
+void
+rp_http2_connection_impl_send_pending_frames(RpHttp2ConnectionImpl* self)
+{
+    LOGD("(%p)", self);
+
+    g_return_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self));
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    if (me->m_dispatching || !me->m_session)
+    {
+        // Flushed once dispatch() unwinds.
+        return;
+    }
+
+    int rv = nghttp2_session_send(me->m_session);
+    if (rv != 0)
+    {
+        LOGE("nghttp2 send error: %s", nghttp2_strerror(rv));
+    }
+    if (evbuffer_get_length(me->m_output_buffer) > 0)
+    {
+        rp_network_connection_write(me->m_connection, me->m_output_buffer, false);
+    }
+}
+
+void
+rp_http2_connection_impl_add_stream(RpHttp2ConnectionImpl* self, RpHttp2StreamImpl* stream)
+{
+    LOGD("(%p, %p)", self, stream);
+    g_return_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self));
+    g_return_if_fail(RP_IS_HTTP2_STREAM_IMPL(stream));
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    me->m_active_streams = g_list_prepend(me->m_active_streams, stream);
+}
+
+void
+rp_http2_connection_impl_remove_stream(RpHttp2ConnectionImpl* self, RpHttp2StreamImpl* stream)
+{
+    LOGD("(%p, %p)", self, stream);
+
+    g_return_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self));
+    g_return_if_fail(RP_IS_HTTP2_STREAM_IMPL(stream));
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    GList* link = g_list_find(me->m_active_streams, stream);
+    if (!link)
+    {
+        return;
+    }
+    me->m_active_streams = g_list_delete_link(me->m_active_streams, link);
+    // The stream may still be on the call stack.
+    rp_dispatcher_deferred_delete_take(rp_network_connection_dispatcher(me->m_connection), G_OBJECT(stream));
+}
+
+void
+rp_http2_connection_impl_consume(RpHttp2ConnectionImpl* self, gint32 stream_id, size_t length)
+{
+    LOGD("(%p, %d, %zu)", self, stream_id, length);
+
+    g_return_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self));
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    if (nghttp2_session_consume(me->m_session, stream_id, length) != 0)
+    {
+        nghttp2_session_consume_connection(me->m_session, length);
+    }
+    rp_http2_connection_impl_send_pending_frames(self);
+}
+
+nghttp2_session*
+rp_http2_connection_impl_session_(RpHttp2ConnectionImpl* self)
+{
+    g_return_val_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self), NULL);
+    return PRIV(self)->m_session;
+}
+
+RpNetworkConnection*
+rp_http2_connection_impl_connection_(RpHttp2ConnectionImpl* self)
+{
+    g_return_val_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self), NULL);
+    return PRIV(self)->m_connection;
+}
+
+RpHttpConnectionCallbacks*
+rp_http2_connection_impl_callbacks_(RpHttp2ConnectionImpl* self)
+{
+    g_return_val_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self), NULL);
+    return PRIV(self)->m_callbacks;
+}
+
+const struct RpHttp2Settings_s*
+rp_http2_connection_impl_settings_(RpHttp2ConnectionImpl* self)
+{
+    g_return_val_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self), NULL);
+    return PRIV(self)->m_settings;
+}
+
+RpHttp2StreamImpl*
+rp_http2_connection_impl_get_stream(RpHttp2ConnectionImpl* self, gint32 stream_id)
+{
+    NOISY_MSG_("(%p, %d)", self, stream_id);
+    g_return_val_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(self), NULL);
+    RpHttp2ConnectionImplPrivate* me = PRIV(self);
+    return me->m_session ? nghttp2_session_get_stream_user_data(me->m_session, stream_id) : NULL;
+}
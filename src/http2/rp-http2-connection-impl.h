@@ -0,0 +1,55 @@
+/*
+ * rp-http2-connection-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <nghttp2/nghttp2.h>
+#include "rp-codec.h"
+#include "rp-net-connection.h"
+
+G_BEGIN_DECLS
+
+typedef struct _RpHttp2StreamImpl RpHttp2StreamImpl;
+
+/**
+ * Base class for HTTP/2 client and server connections. Owns the nghttp2
+ * session, feeds it from dispatch() and writes whatever it produces to the
+ * network connection. Frame callbacks are routed to the owning
+ * RpHttp2StreamImpl; the subclasses only decide how streams come into being.
+ */
+// https://github.com/envoyproxy/envoy/blob/main/source/common/http/http2/codec_impl.h#L145
+#define RP_TYPE_HTTP2_CONNECTION_IMPL rp_http2_connection_impl_get_type()
+G_DECLARE_DERIVABLE_TYPE(RpHttp2ConnectionImpl, rp_http2_connection_impl, RP, HTTP2_CONNECTION_IMPL, GObject)
+
+struct _RpHttp2ConnectionImplClass {
+    GObjectClass parent_class;
+
+    int (*session_new)(RpHttp2ConnectionImpl*,
+                        nghttp2_session**,
+                        const nghttp2_session_callbacks*,
+                        const nghttp2_option*);
+    int (*on_begin_headers)(RpHttp2ConnectionImpl*, const nghttp2_frame*);
+};
+
+void rp_http2_connection_impl_send_pending_frames(RpHttp2ConnectionImpl* self);
+void rp_http2_connection_impl_add_stream(RpHttp2ConnectionImpl* self,
+                                            RpHttp2StreamImpl* stream);
+void rp_http2_connection_impl_remove_stream(RpHttp2ConnectionImpl* self,
+                                            RpHttp2StreamImpl* stream);
+void rp_http2_connection_impl_consume(RpHttp2ConnectionImpl* self,
+                                        gint32 stream_id,
+                                        size_t length);
+nghttp2_session* rp_http2_connection_impl_session_(RpHttp2ConnectionImpl* self);
+RpNetworkConnection* rp_http2_connection_impl_connection_(RpHttp2ConnectionImpl* self);
+RpHttpConnectionCallbacks* rp_http2_connection_impl_callbacks_(RpHttp2ConnectionImpl* self);
+const struct RpHttp2Settings_s* rp_http2_connection_impl_settings_(RpHttp2ConnectionImpl* self);
+RpHttp2StreamImpl* rp_http2_connection_impl_get_stream(RpHttp2ConnectionImpl* self,
+                                                        gint32 stream_id);
+
+G_END_DECLS
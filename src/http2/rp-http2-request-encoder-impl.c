@@ -0,0 +1,216 @@
+/*
+ * rp-http2-request-encoder-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http2_request_encoder_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http2_request_encoder_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <string.h>
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "rp-header-utility.h"
+#include "rp-http-utility.h"
+#include "http2/rp-http2-request-encoder-impl.h"
+
+struct _RpHttp2RequestEncoderImpl {
+    RpHttp2StreamImpl parent_instance;
+
+    RpResponseDecoder* m_response_decoder;
+};
+
+static void request_encoder_iface_init(RpRequestEncoderInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpHttp2RequestEncoderImpl, rp_http2_request_encoder_impl, RP_TYPE_HTTP2_STREAM_IMPL,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_REQUEST_ENCODER, request_encoder_iface_init)
+)
+
+static inline void
+add_pseudo_header(RpHttp2HeaderBlock* block, const char* name, const char* value)
+{
+    rp_http2_header_block_add(block, name, value, strlen(value), false);
+}
+
+static RpStatusCode_e
+encode_headers_i(RpRequestEncoder* self, evhtp_headers_t* request_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, request_headers, end_stream);
+
+    RpHttp2StreamImpl* stream = RP_HTTP2_STREAM_IMPL(self);
+    RpHttp2ConnectionImpl* connection = rp_http2_stream_impl_connection_(stream);
+    const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+    const char* path = rp_header_map_get_inline(request_headers, RpInlineHeader_Path);
+    const char* authority = rp_header_map_get_inline(request_headers, RpInlineHeader_Authority);
+    const char* scheme = rp_header_map_get_inline(request_headers, RpInlineHeader_Scheme);
+    bool is_connect = rp_header_utility_is_connect(request_headers);
+
+    if (!authority)
+    {
+        // Requests decoded from HTTP/1 only carry host.
+        authority = rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy);
+    }
+    if (!method || (!is_connect && !path) || (is_connect && !authority))
+    {
+        LOGE("missing required request pseudo header");
+        return RpStatusCode_CodecClientError;
+    }
+    if (!scheme)
+    {
+        RpNetworkConnection* network_connection = rp_http2_connection_impl_connection_(connection);
+        scheme = rp_network_connection_ssl(network_connection) ?
+                    RpHeaderValues.SchemeValues.Https : RpHeaderValues.SchemeValues.Http;
+    }
+
+    RpHttp2HeaderBlock block;
+    rp_http2_header_block_init(&block);
+    add_pseudo_header(&block, RpHeaderValues.Method, method);
+    if (!is_connect)
+    {
+        add_pseudo_header(&block, RpHeaderValues.Scheme, scheme);
+    }
+    if (authority)
+    {
+        add_pseudo_header(&block, RpHeaderValues.Host, authority);
+    }
+    if (!is_connect)
+    {
+        add_pseudo_header(&block, RpHeaderValues.Path, path);
+    }
+    rp_http2_header_block_add_headers(&block, request_headers, false);
+
+    nghttp2_data_provider provider;
+    rp_http2_stream_impl_data_provider(stream, &provider);
+    if (end_stream)
+    {
+        rp_http2_stream_impl_set_local_end_stream(stream);
+    }
+
+    gint32 stream_id = nghttp2_submit_request(rp_http2_connection_impl_session_(connection),
+                                                NULL,
+                                                rp_http2_header_block_nva(&block),
+                                                rp_http2_header_block_nvlen(&block),
+                                                end_stream ? NULL : &provider,
+                                                stream);
+    rp_http2_header_block_clear(&block);
+    if (stream_id < 0)
+    {
+        LOGE("submit request failed: %s", nghttp2_strerror(stream_id));
+        return RpStatusCode_CodecClientError;
+    }
+
+    rp_http2_stream_impl_set_stream_id(stream, stream_id);
+    rp_http2_connection_impl_send_pending_frames(connection);
+    return RpStatusCode_Ok;
+}
+
+static void
+encode_trailers_i(RpRequestEncoder* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    rp_http2_stream_impl_encode_trailers_base(RP_HTTP2_STREAM_IMPL(self), trailers);
+}
+
+static void
+enable_tcp_tunneling_i(RpRequestEncoder* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+    // A CONNECT stream already behaves as a tunnel over HTTP/2.
+}
+
+static void
+request_encoder_iface_init(RpRequestEncoderInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->encode_headers = encode_headers_i;
+    iface->encode_trailers = encode_trailers_i;
+    iface->enable_tcp_tunneling = enable_tcp_tunneling_i;
+}
+
+OVERRIDE bool
+decode_headers(RpHttp2StreamImpl* self, evhtp_headers_t* response_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, response_headers, end_stream);
+
+    RpHttp2RequestEncoderImpl* me = RP_HTTP2_REQUEST_ENCODER_IMPL(self);
+    evhtp_res status = http_utility_get_response_status(response_headers);
+    if (status >= 100 && status < 200 && status != 101)
+    {
+        if (rp_header_utility_is_special_1xx(response_headers))
+        {
+            rp_response_decoder_decode_1xx_headers(me->m_response_decoder, response_headers);
+        }
+        else
+        {
+            rp_header_map_free(response_headers);
+        }
+        return false;
+    }
+
+    rp_response_decoder_decode_headers(me->m_response_decoder, response_headers, end_stream);
+    return true;
+}
+
+OVERRIDE void
+decode_trailers(RpHttp2StreamImpl* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    rp_response_decoder_decode_trailers(RP_HTTP2_REQUEST_ENCODER_IMPL(self)->m_response_decoder, trailers);
+}
+
+OVERRIDE RpStreamDecoder*
+decoder(RpHttp2StreamImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_STREAM_DECODER(RP_HTTP2_REQUEST_ENCODER_IMPL(self)->m_response_decoder);
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpHttp2RequestEncoderImpl* self = RP_HTTP2_REQUEST_ENCODER_IMPL(obj);
+    g_clear_object(&self->m_response_decoder);
+
+    G_OBJECT_CLASS(rp_http2_request_encoder_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_http2_request_encoder_impl_class_init(RpHttp2RequestEncoderImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+
+    RpHttp2StreamImplClass* stream_class = RP_HTTP2_STREAM_IMPL_CLASS(klass);
+    stream_class->decode_headers = decode_headers;
+    stream_class->decode_trailers = decode_trailers;
+    stream_class->decoder = decoder;
+}
+
+static void
+rp_http2_request_encoder_impl_init(RpHttp2RequestEncoderImpl* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+RpHttp2RequestEncoderImpl*
+rp_http2_request_encoder_impl_new(RpHttp2ConnectionImpl* connection, RpResponseDecoder* response_decoder)
+{
+    LOGD("(%p, %p)", connection, response_decoder);
+    g_return_val_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(connection), NULL);
+    g_return_val_if_fail(RP_IS_RESPONSE_DECODER(response_decoder), NULL);
+    RpHttp2RequestEncoderImpl* self = g_object_new(RP_TYPE_HTTP2_REQUEST_ENCODER_IMPL,
+                                                    "connection", connection,
+                                                    NULL);
+    self->m_response_decoder = g_object_ref(response_decoder);
+    return self;
+}
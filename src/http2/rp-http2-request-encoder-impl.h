@@ -0,0 +1,27 @@
+/*
+ * rp-http2-request-encoder-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-codec.h"
+#include "http2/rp-http2-stream-impl.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Client side HTTP/2 stream: encodes the request and decodes the response.
+ */
+// https://github.com/envoyproxy/envoy/blob/main/source/common/http/http2/codec_impl.h#L496
+#define RP_TYPE_HTTP2_REQUEST_ENCODER_IMPL rp_http2_request_encoder_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpHttp2RequestEncoderImpl, rp_http2_request_encoder_impl, RP, HTTP2_REQUEST_ENCODER_IMPL, RpHttp2StreamImpl)
+
+RpHttp2RequestEncoderImpl* rp_http2_request_encoder_impl_new(RpHttp2ConnectionImpl* connection,
+                                                                RpResponseDecoder* response_decoder);
+
+G_END_DECLS
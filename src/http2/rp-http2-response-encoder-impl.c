@@ -0,0 +1,214 @@
+/*
+ * rp-http2-response-encoder-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http2_response_encoder_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http2_response_encoder_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <stdio.h>
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "rp-http-utility.h"
+#include "http2/rp-http2-response-encoder-impl.h"
+
+struct _RpHttp2ResponseEncoderImpl {
+    RpHttp2StreamImpl parent_instance;
+
+    // Owned by the connection manager, as with HTTP/1.
+    RpRequestDecoder* m_request_decoder;
+};
+
+static void response_encoder_iface_init(RpResponseEncoderInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpHttp2ResponseEncoderImpl, rp_http2_response_encoder_impl, RP_TYPE_HTTP2_STREAM_IMPL,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_RESPONSE_ENCODER, response_encoder_iface_init)
+)
+
+static inline void
+build_header_block(RpHttp2HeaderBlock* block, evhtp_headers_t* response_headers)
+{
+    NOISY_MSG_("(%p, %p)", block, response_headers);
+    char status[4];
+    int status_len = snprintf(status, sizeof(status), "%d", http_utility_get_response_status(response_headers));
+    rp_http2_header_block_init(block);
+    rp_http2_header_block_add(block, RpHeaderValues.Status, status, status_len, true);
+    rp_http2_header_block_add_headers(block, response_headers, false);
+}
+
+static void
+encode_1xx_headers_i(RpResponseEncoder* self, evhtp_headers_t* response_headers)
+{
+    NOISY_MSG_("(%p, %p)", self, response_headers);
+
+    RpHttp2StreamImpl* stream = RP_HTTP2_STREAM_IMPL(self);
+    RpHttp2ConnectionImpl* connection = rp_http2_stream_impl_connection_(stream);
+
+    RpHttp2HeaderBlock block;
+    build_header_block(&block, response_headers);
+    int rv = nghttp2_submit_headers(rp_http2_connection_impl_session_(connection),
+                                    NGHTTP2_FLAG_NONE,
+                                    rp_http2_stream_impl_stream_id_(stream),
+                                    NULL,
+                                    rp_http2_header_block_nva(&block),
+                                    rp_http2_header_block_nvlen(&block),
+                                    NULL);
+    rp_http2_header_block_clear(&block);
+    if (rv != 0)
+    {
+        LOGE("submit 1xx headers failed: %s", nghttp2_strerror(rv));
+        return;
+    }
+    rp_http2_connection_impl_send_pending_frames(connection);
+}
+
+static void
+encode_headers_i(RpResponseEncoder* self, evhtp_headers_t* response_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, response_headers, end_stream);
+
+    RpHttp2StreamImpl* stream = RP_HTTP2_STREAM_IMPL(self);
+    RpHttp2ConnectionImpl* connection = rp_http2_stream_impl_connection_(stream);
+
+    RpHttp2HeaderBlock block;
+    build_header_block(&block, response_headers);
+
+    nghttp2_data_provider provider;
+    rp_http2_stream_impl_data_provider(stream, &provider);
+    if (end_stream)
+    {
+        rp_http2_stream_impl_set_local_end_stream(stream);
+    }
+
+    int rv = nghttp2_submit_response(rp_http2_connection_impl_session_(connection),
+                                        rp_http2_stream_impl_stream_id_(stream),
+                                        rp_http2_header_block_nva(&block),
+                                        rp_http2_header_block_nvlen(&block),
+                                        end_stream ? NULL : &provider);
+    rp_http2_header_block_clear(&block);
+    if (rv != 0)
+    {
+        LOGE("submit response failed: %s", nghttp2_strerror(rv));
+        return;
+    }
+
+    rp_http2_connection_impl_send_pending_frames(connection);
+}
+
+static void
+encode_trailers_i(RpResponseEncoder* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    rp_http2_stream_impl_encode_trailers_base(RP_HTTP2_STREAM_IMPL(self), trailers);
+}
+
+static void
+response_encoder_iface_init(RpResponseEncoderInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->encode_1xx_headers = encode_1xx_headers_i;
+    iface->encode_headers = encode_headers_i;
+    iface->encode_trailers = encode_trailers_i;
+}
+
+OVERRIDE bool
+decode_headers(RpHttp2StreamImpl* self, evhtp_headers_t* request_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, request_headers, end_stream);
+
+    RpHttp2ResponseEncoderImpl* me = RP_HTTP2_RESPONSE_ENCODER_IMPL(self);
+    if (!me->m_request_decoder)
+    {
+        rp_header_map_free(request_headers);
+        return true;
+    }
+
+    // Routing keys off host, which HTTP/2 clients normally leave out.
+    const char* authority = rp_header_map_get_inline(request_headers, RpInlineHeader_Authority);
+    if (authority && !rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy))
+    {
+        rp_header_map_add_header(request_headers, RpHeaderValues.HostLegacy, authority, 0, 1);
+    }
+    rp_request_decoder_decode_headers(me->m_request_decoder, request_headers, end_stream);
+    return true;
+}
+
+OVERRIDE void
+decode_trailers(RpHttp2StreamImpl* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+
+    RpHttp2ResponseEncoderImpl* me = RP_HTTP2_RESPONSE_ENCODER_IMPL(self);
+    if (!me->m_request_decoder)
+    {
+        rp_header_map_free(trailers);
+        return;
+    }
+    rp_request_decoder_decode_trailers(me->m_request_decoder, trailers);
+}
+
+OVERRIDE RpStreamDecoder*
+decoder(RpHttp2StreamImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_STREAM_DECODER(RP_HTTP2_RESPONSE_ENCODER_IMPL(self)->m_request_decoder);
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpHttp2ResponseEncoderImpl* self = RP_HTTP2_RESPONSE_ENCODER_IMPL(obj);
+    self->m_request_decoder = NULL;
+
+    G_OBJECT_CLASS(rp_http2_response_encoder_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_http2_response_encoder_impl_class_init(RpHttp2ResponseEncoderImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+
+    RpHttp2StreamImplClass* stream_class = RP_HTTP2_STREAM_IMPL_CLASS(klass);
+    stream_class->decode_headers = decode_headers;
+    stream_class->decode_trailers = decode_trailers;
+    stream_class->decoder = decoder;
+}
+
+static void
+rp_http2_response_encoder_impl_init(RpHttp2ResponseEncoderImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_request_decoder = NULL;
+}
+
+RpHttp2ResponseEncoderImpl*
+rp_http2_response_encoder_impl_new(RpHttp2ConnectionImpl* connection, gint32 stream_id)
+{
+    LOGD("(%p, %d)", connection, stream_id);
+    g_return_val_if_fail(RP_IS_HTTP2_CONNECTION_IMPL(connection), NULL);
+    RpHttp2ResponseEncoderImpl* self = g_object_new(RP_TYPE_HTTP2_RESPONSE_ENCODER_IMPL,
+                                                    "connection", connection,
+                                                    NULL);
+    rp_http2_stream_impl_set_stream_id(RP_HTTP2_STREAM_IMPL(self), stream_id);
+    return self;
+}
+
+void
+rp_http2_response_encoder_impl_set_request_decoder(RpHttp2ResponseEncoderImpl* self, RpRequestDecoder* request_decoder)
+{
+    LOGD("(%p, %p)", self, request_decoder);
+    g_return_if_fail(RP_IS_HTTP2_RESPONSE_ENCODER_IMPL(self));
+    self->m_request_decoder = request_decoder;
+}
@@ -0,0 +1,29 @@
+/*
+ * rp-http2-response-encoder-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-codec.h"
+#include "http2/rp-http2-stream-impl.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Server side HTTP/2 stream: decodes the request and encodes the response.
+ */
+// https://github.com/envoyproxy/envoy/blob/main/source/common/http/http2/codec_impl.h#L535
+#define RP_TYPE_HTTP2_RESPONSE_ENCODER_IMPL rp_http2_response_encoder_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpHttp2ResponseEncoderImpl, rp_http2_response_encoder_impl, RP, HTTP2_RESPONSE_ENCODER_IMPL, RpHttp2StreamImpl)
+
+RpHttp2ResponseEncoderImpl* rp_http2_response_encoder_impl_new(RpHttp2ConnectionImpl* connection,
+                                                                gint32 stream_id);
+void rp_http2_response_encoder_impl_set_request_decoder(RpHttp2ResponseEncoderImpl* self,
+                                                        RpRequestDecoder* request_decoder);
+
+G_END_DECLS
@@ -0,0 +1,124 @@
+/*
+ * rp-http2-server-connection-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http2_server_connection_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http2_server_connection_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <string.h>
+#include "http2/rp-http2-response-encoder-impl.h"
+#include "http2/rp-http2-server-connection-impl.h"
+
+struct _RpHttp2ServerConnectionImpl {
+    RpHttp2ConnectionImpl parent_instance;
+};
+
+static void http_server_connection_iface_init(RpHttpServerConnectionInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpHttp2ServerConnectionImpl, rp_http2_server_connection_impl, RP_TYPE_HTTP2_CONNECTION_IMPL,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_SERVER_CONNECTION, http_server_connection_iface_init)
+)
+
+static void
+http_server_connection_iface_init(RpHttpServerConnectionInterface* iface)
+{
+    LOGD("(%p)", iface);
+}
+
+OVERRIDE int
+session_new(RpHttp2ConnectionImpl* self, nghttp2_session** session, const nghttp2_session_callbacks* callbacks, const nghttp2_option* option)
+{
+    NOISY_MSG_("(%p, %p, %p, %p)", self, session, callbacks, option);
+    return nghttp2_session_server_new2(session, callbacks, self, option);
+}
+
+OVERRIDE int
+on_begin_headers(RpHttp2ConnectionImpl* self, const nghttp2_frame* frame)
+{
+    NOISY_MSG_("(%p, %p)", self, frame);
+
+    if (frame->hd.type != NGHTTP2_HEADERS)
+    {
+        return 0;
+    }
+
+    // Trailers on a stream that is already up.
+    if (frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+    {
+        RpHttp2StreamImpl* stream = rp_http2_connection_impl_get_stream(self, frame->hd.stream_id);
+        if (stream)
+        {
+            rp_http2_stream_impl_on_begin_headers(stream);
+        }
+        return 0;
+    }
+
+    RpHttp2ResponseEncoderImpl* stream = rp_http2_response_encoder_impl_new(self, frame->hd.stream_id);
+    nghttp2_session_set_stream_user_data(rp_http2_connection_impl_session_(self), frame->hd.stream_id, stream);
+    // The connection owns the stream from here on.
+    rp_http2_connection_impl_add_stream(self, RP_HTTP2_STREAM_IMPL(stream));
+
+    RpHttpServerConnectionCallbacks* callbacks =
+        RP_HTTP_SERVER_CONNECTION_CALLBACKS(rp_http2_connection_impl_callbacks_(self));
+    RpRequestDecoder* request_decoder = rp_http_server_connection_callbacks_new_stream(callbacks,
+                                                                                        RP_RESPONSE_ENCODER(stream),
+                                                                                        false);
+    rp_http2_response_encoder_impl_set_request_decoder(stream, request_decoder);
+    rp_http2_stream_impl_on_begin_headers(RP_HTTP2_STREAM_IMPL(stream));
+    return 0;
+}
+
+static void
+rp_http2_server_connection_impl_class_init(RpHttp2ServerConnectionImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    RpHttp2ConnectionImplClass* connection_class = RP_HTTP2_CONNECTION_IMPL_CLASS(klass);
+    connection_class->session_new = session_new;
+    connection_class->on_begin_headers = on_begin_headers;
+}
+
+static void
+rp_http2_server_connection_impl_init(RpHttp2ServerConnectionImpl* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+RpHttp2ServerConnectionImpl*
+rp_http2_server_connection_impl_new(RpNetworkConnection* connection,
+                                    RpHttpServerConnectionCallbacks* callbacks,
+                                    const struct RpHttp2Settings_s* settings)
+{
+    LOGD("(%p, %p, %p)", connection, callbacks, settings);
+    g_return_val_if_fail(RP_IS_NETWORK_CONNECTION(connection), NULL);
+    g_return_val_if_fail(RP_IS_HTTP_SERVER_CONNECTION_CALLBACKS(callbacks), NULL);
+    g_return_val_if_fail(settings != NULL, NULL);
+    return g_object_new(RP_TYPE_HTTP2_SERVER_CONNECTION_IMPL,
+                        "connection", connection,
+                        "callbacks", callbacks,
+                        "codec-settings", settings,
+                        NULL);
+}
+
+bool
+rp_http2_is_connection_preface(evbuf_t* data)
+{
+    LOGD("(%p)", data);
+
+    static const char preface[] = NGHTTP2_CLIENT_MAGIC;
+    size_t len = MIN(evbuffer_get_length(data), sizeof(preface) - 1);
+    // "PRI " is not a valid HTTP/1 method, so a short prefix is enough.
+    if (len < 4)
+    {
+        return false;
+    }
+    return memcmp(evbuffer_pullup(data, len), preface, len) == 0;
+}
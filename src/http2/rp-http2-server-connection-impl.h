@@ -0,0 +1,32 @@
+/*
+ * rp-http2-server-connection-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-codec.h"
+#include "http2/rp-http2-connection-impl.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Implementation of Http::ServerConnection for HTTP/2. Used for connections
+ * that negotiated "h2" through ALPN and for h2c prior knowledge.
+ */
+// https://github.com/envoyproxy/envoy/blob/main/source/common/http/http2/codec_impl.h#L770
+#define RP_TYPE_HTTP2_SERVER_CONNECTION_IMPL rp_http2_server_connection_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpHttp2ServerConnectionImpl, rp_http2_server_connection_impl, RP, HTTP2_SERVER_CONNECTION_IMPL, RpHttp2ConnectionImpl)
+
+RpHttp2ServerConnectionImpl* rp_http2_server_connection_impl_new(RpNetworkConnection* connection,
+                                                                    RpHttpServerConnectionCallbacks* callbacks,
+                                                                    const struct RpHttp2Settings_s* settings);
+
+/* True if @data starts like the HTTP/2 client connection preface. */
+bool rp_http2_is_connection_preface(evbuf_t* data);
+
+G_END_DECLS
@@ -0,0 +1,778 @@
+/*
+ * rp-http2-stream-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_http2_stream_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_http2_stream_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <string.h>
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "http2/rp-http2-stream-impl.h"
+
+typedef struct _RpHttp2StreamImplPrivate RpHttp2StreamImplPrivate;
+struct _RpHttp2StreamImplPrivate {
+
+    RpHttp2ConnectionImpl* m_connection;
+
+    RpCodecEventCallbacks* m_codec_callbacks;
+
+    // Header block currently being received.
+    evhtp_headers_t* m_headers;
+    // Trailers that arrived while reads were disabled and body was pending.
+    evhtp_headers_t* m_pending_recv_trailers;
+
+    evbuf_t* m_pending_recv_data;
+    evbuf_t* m_pending_send_data;
+
+    RpHttp2HeaderBlock m_pending_trailers;
+
+    const char* m_details;
+
+    gint32 m_stream_id;
+    guint32 m_read_disable_count;
+
+    bool m_local_end_stream : 1;
+    bool m_remote_end_stream : 1;
+    bool m_end_stream_decoded : 1;
+    bool m_remote_headers_received : 1;
+    bool m_data_deferred : 1;
+    bool m_pending_trailers_to_encode : 1;
+    bool m_pending_send_buffer_high_watermark_called : 1;
+    bool m_closed : 1;
+};
+
+enum
+{
+    PROP_0, // Reserved.
+    PROP_CONNECTION,
+    N_PROPERTIES
+};
+
+static GParamSpec* obj_properties[N_PROPERTIES] = { NULL, };
+
+static void stream_reset_handler_iface_init(RpStreamResetHandlerInterface* iface);
+static void stream_iface_init(RpStreamInterface* iface);
+static void stream_encoder_iface_init(RpStreamEncoderInterface* iface);
+
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE(RpHttp2StreamImpl, rp_http2_stream_impl, RP_TYPE_STREAM_CALLBACK_HELPER,
+    G_ADD_PRIVATE(RpHttp2StreamImpl)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_RESET_HANDLER, stream_reset_handler_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM, stream_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_ENCODER, stream_encoder_iface_init)
+)
+
+#define PRIV(obj) \
+    ((RpHttp2StreamImplPrivate*)rp_http2_stream_impl_get_instance_private(RP_HTTP2_STREAM_IMPL(obj)))
+
+static const char* const connection_specific_headers[] = {
+    "connection",
+    "host",
+    "keep-alive",
+    "proxy-connection",
+    "transfer-encoding",
+    "upgrade"
+};
+
+void
+rp_http2_header_block_init(RpHttp2HeaderBlock* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_nva = g_array_sized_new(FALSE, FALSE, sizeof(nghttp2_nv), 16);
+    self->m_strings = NULL;
+}
+
+void
+rp_http2_header_block_clear(RpHttp2HeaderBlock* self)
+{
+    NOISY_MSG_("(%p)", self);
+    g_clear_pointer(&self->m_nva, g_array_unref);
+    g_clear_pointer(&self->m_strings, g_string_chunk_free);
+}
+
+static inline char*
+block_strndup(RpHttp2HeaderBlock* self, const char* str, size_t len)
+{
+    if (!self->m_strings)
+    {
+        self->m_strings = g_string_chunk_new(512);
+    }
+    return g_string_chunk_insert_len(self->m_strings, str, len);
+}
+
+void
+rp_http2_header_block_add(RpHttp2HeaderBlock* self, const char* name, const char* value, size_t vlen, bool copy_value)
+{
+    NOISY_MSG_("(%p, %p(%s), %p, %zu, %u)", self, name, name, value, vlen, copy_value);
+
+    // The block may be submitted long after the caller's headers are gone
+    // (trailers wait for the body), so the name always lives in the block.
+    size_t namelen = strlen(name);
+    char* lower = block_strndup(self, name, namelen);
+    for (char* q = lower; *q; ++q)
+    {
+        *q = g_ascii_tolower(*q);
+    }
+    name = lower;
+    if (copy_value)
+    {
+        value = block_strndup(self, value ? value : "", vlen);
+    }
+
+    nghttp2_nv nv = {
+        .name = (guint8*)name,
+        .value = (guint8*)(value ? value : ""),
+        .namelen = namelen,
+        .valuelen = vlen,
+        .flags = NGHTTP2_NV_FLAG_NONE
+    };
+    g_array_append_val(self->m_nva, nv);
+}
+
+static inline bool
+is_connection_specific_header(const char* key, size_t klen)
+{
+    for (guint i = 0; i < G_N_ELEMENTS(connection_specific_headers); ++i)
+    {
+        const char* name = connection_specific_headers[i];
+        if (g_ascii_strncasecmp(name, key, klen) == 0 && name[klen] == '\0')
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+rp_http2_header_block_add_headers(RpHttp2HeaderBlock* self, evhtp_headers_t* headers, bool copy_values)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, headers, copy_values);
+
+    evhtp_header_t* header;
+    TAILQ_FOREACH(header, headers, next)
+    {
+        if (header->klen == 0 || header->key[0] == ':')
+        {
+            continue;
+        }
+        if (is_connection_specific_header(header->key, header->klen))
+        {
+            NOISY_MSG_("dropping connection-specific header %s", header->key);
+            continue;
+        }
+        // The only TE value allowed over HTTP/2 is "trailers".
+        if (g_ascii_strcasecmp(header->key, RpHeaderValues.TE) == 0 &&
+            g_ascii_strcasecmp(header->val, "trailers") != 0)
+        {
+            continue;
+        }
+        rp_http2_header_block_add(self, header->key, header->val, header->vlen, copy_values);
+    }
+}
+
+static inline nghttp2_session*
+session_(RpHttp2StreamImplPrivate* me)
+{
+    return rp_http2_connection_impl_session_(me->m_connection);
+}
+
+static void
+resume_data_if_deferred(RpHttp2StreamImplPrivate* me)
+{
+    NOISY_MSG_("(%p)", me);
+    if (me->m_data_deferred && me->m_stream_id > 0)
+    {
+        me->m_data_deferred = false;
+        int rv = nghttp2_session_resume_data(session_(me), me->m_stream_id);
+        if (rv != 0)
+        {
+            LOGD("resume data failed on stream %d: %s", me->m_stream_id, nghttp2_strerror(rv));
+        }
+    }
+}
+
+static void
+notify_encode_complete(RpHttp2StreamImplPrivate* me)
+{
+    NOISY_MSG_("(%p)", me);
+    if (me->m_codec_callbacks)
+    {
+        rp_codec_event_callbacks_on_codec_encode_complete(me->m_codec_callbacks);
+    }
+}
+
+static void
+reset_stream_i(RpStreamResetHandler* self, RpStreamResetReason_e reason)
+{
+    NOISY_MSG_("(%p, %d)", self, reason);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    g_object_ref(self);
+
+    if (me->m_stream_id > 0 && !me->m_closed)
+    {
+        guint32 error_code = reason == RpStreamResetReason_LocalRefusedStreamReset ?
+                                NGHTTP2_REFUSED_STREAM : NGHTTP2_NO_ERROR;
+        nghttp2_submit_rst_stream(session_(me), NGHTTP2_FLAG_NONE, me->m_stream_id, error_code);
+    }
+
+    rp_stream_callback_helper_run_reset_callbacks(RP_STREAM_CALLBACK_HELPER(self), reason, "");
+
+    if (me->m_stream_id > 0)
+    {
+        // The stream is released from on_stream_close once RST_STREAM is out.
+        rp_http2_connection_impl_send_pending_frames(me->m_connection);
+    }
+    else
+    {
+        // Never made it onto the wire; nghttp2 knows nothing about it.
+        rp_http2_connection_impl_remove_stream(me->m_connection, RP_HTTP2_STREAM_IMPL(self));
+    }
+
+    g_object_unref(self);
+}
+
+static void
+stream_reset_handler_iface_init(RpStreamResetHandlerInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->reset_stream = reset_stream_i;
+}
+
+static guint32
+buffer_limit_i(RpStream* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return rp_http2_connection_impl_settings_(PRIV(self)->m_connection)->m_initial_stream_window_size;
+}
+
+static void
+flush_pending_recv_data(RpHttp2StreamImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    RpHttp2StreamImplClass* klass = RP_HTTP2_STREAM_IMPL_GET_CLASS(self);
+    size_t length = evbuffer_get_length(me->m_pending_recv_data);
+    bool end_stream = me->m_remote_end_stream &&
+                        !me->m_pending_recv_trailers &&
+                        !me->m_end_stream_decoded;
+
+    if (length > 0 || end_stream)
+    {
+        if (end_stream)
+        {
+            me->m_end_stream_decoded = true;
+        }
+        rp_stream_decoder_decode_data(klass->decoder(self), me->m_pending_recv_data, end_stream);
+        evbuffer_drain(me->m_pending_recv_data, evbuffer_get_length(me->m_pending_recv_data));
+        // Only now does the peer get its window back; a stalled consumer
+        // therefore back-pressures the sender instead of growing our buffers.
+        // Once closed, on_close() has already handed the window back.
+        if (!me->m_closed)
+        {
+            rp_http2_connection_impl_consume(me->m_connection, me->m_stream_id, length);
+        }
+    }
+    if (me->m_pending_recv_trailers)
+    {
+        me->m_end_stream_decoded = true;
+        klass->decode_trailers(self, g_steal_pointer(&me->m_pending_recv_trailers));
+    }
+}
+
+static void
+read_disable_i(RpStream* self, bool disable)
+{
+    NOISY_MSG_("(%p, %u)", self, disable);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    if (disable)
+    {
+        ++me->m_read_disable_count;
+    }
+    else if (me->m_read_disable_count == 0)
+    {
+        LOGD("read enable without matching disable");
+    }
+    else if (--me->m_read_disable_count == 0)
+    {
+        // A stream that closed while disabled still owes its decoder the
+        // buffered body and end of stream.
+        flush_pending_recv_data(RP_HTTP2_STREAM_IMPL(self));
+        if (me->m_closed)
+        {
+            // Held back by on_close() for just this.
+            rp_http2_connection_impl_remove_stream(me->m_connection, RP_HTTP2_STREAM_IMPL(self));
+        }
+        else
+        {
+            rp_http2_connection_impl_send_pending_frames(me->m_connection);
+        }
+    }
+}
+
+static RpCodecEventCallbacks*
+register_codec_event_callbacks_i(RpStream* self, RpCodecEventCallbacks* codec_callbacks)
+{
+    NOISY_MSG_("(%p, %p)", self, codec_callbacks);
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    RpCodecEventCallbacks* codec_callbacks_ = me->m_codec_callbacks;
+    me->m_codec_callbacks = codec_callbacks;
+    return codec_callbacks_;
+}
+
+static void
+add_callbacks_i(RpStream* self, RpStreamCallbacks* callbacks)
+{
+    NOISY_MSG_("(%p, %p)", self, callbacks);
+    rp_stream_callback_helper_add_callbacks_helper(RP_STREAM_CALLBACK_HELPER(self), callbacks);
+}
+
+static void
+remove_callbacks_i(RpStream* self, RpStreamCallbacks* callbacks)
+{
+    NOISY_MSG_("(%p, %p)", self, callbacks);
+    rp_stream_callback_helper_remove_callbacks_helper(RP_STREAM_CALLBACK_HELPER(self), callbacks);
+}
+
+static const char*
+response_details_i(RpStream* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return PRIV(self)->m_details;
+}
+
+static void
+set_flush_timeout_i(RpStream* self G_GNUC_UNUSED, guint32 timeout_ms G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %u)", self, timeout_ms);
+}
+
+static RpConnectionInfoProviderSharedPtr
+connection_info_provider_i(RpStream* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return rp_network_connection_connection_info_provider(
+                rp_http2_connection_impl_connection_(PRIV(self)->m_connection));
+}
+
+static void
+stream_iface_init(RpStreamInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->add_callbacks = add_callbacks_i;
+    iface->buffer_limit = buffer_limit_i;
+    iface->read_disable = read_disable_i;
+    iface->register_codec_event_callbacks = register_codec_event_callbacks_i;
+    iface->remove_callbacks = remove_callbacks_i;
+    iface->response_details = response_details_i;
+    iface->set_flush_timeout = set_flush_timeout_i;
+    iface->connection_info_provider = connection_info_provider_i;
+}
+
+static void
+encode_data_i(RpStreamEncoder* self, evbuf_t* data, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p(%zu), %u)", self, data, evbuffer_get_length(data), end_stream);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    if (me->m_closed)
+    {
+        NOISY_MSG_("stream %d already closed", me->m_stream_id);
+        evbuffer_drain(data, evbuffer_get_length(data));
+        return;
+    }
+
+    evbuffer_add_buffer(me->m_pending_send_data, data);
+    if (end_stream)
+    {
+        rp_http2_stream_impl_set_local_end_stream(RP_HTTP2_STREAM_IMPL(self));
+    }
+
+    resume_data_if_deferred(me);
+    rp_http2_connection_impl_send_pending_frames(me->m_connection);
+
+    if (!me->m_pending_send_buffer_high_watermark_called &&
+        evbuffer_get_length(me->m_pending_send_data) > buffer_limit_i(RP_STREAM(self)))
+    {
+        me->m_pending_send_buffer_high_watermark_called = true;
+        rp_stream_callback_helper_run_high_watermark_callbacks(RP_STREAM_CALLBACK_HELPER(self));
+    }
+}
+
+static RpStream*
+get_stream_i(RpStreamEncoder* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_STREAM(self);
+}
+
+static void
+stream_encoder_iface_init(RpStreamEncoderInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->encode_data = encode_data_i;
+    iface->get_stream = get_stream_i;
+}
+
+OVERRIDE void
+get_property(GObject* obj, guint prop_id, GValue* value, GParamSpec* pspec)
+{
+    NOISY_MSG_("(%p, %u, %p, %p(%s))", obj, prop_id, value, pspec, pspec->name);
+    switch (prop_id)
+    {
+        case PROP_CONNECTION:
+            g_value_set_object(value, PRIV(obj)->m_connection);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, prop_id, pspec);
+            break;
+    }
+}
+
+OVERRIDE void
+set_property(GObject* obj, guint prop_id, const GValue* value, GParamSpec* pspec)
+{
+    NOISY_MSG_("(%p, %u, %p, %p(%s))", obj, prop_id, value, pspec, pspec->name);
+    switch (prop_id)
+    {
+        case PROP_CONNECTION:
+            PRIV(obj)->m_connection = g_value_get_object(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, prop_id, pspec);
+            break;
+    }
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpHttp2StreamImplPrivate* me = PRIV(obj);
+    g_clear_pointer(&me->m_headers, rp_header_map_free);
+    g_clear_pointer(&me->m_pending_recv_trailers, rp_header_map_free);
+    g_clear_pointer(&me->m_pending_recv_data, evbuffer_free);
+    g_clear_pointer(&me->m_pending_send_data, evbuffer_free);
+    rp_http2_header_block_clear(&me->m_pending_trailers);
+
+    G_OBJECT_CLASS(rp_http2_stream_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_http2_stream_impl_class_init(RpHttp2StreamImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->get_property = get_property;
+    object_class->set_property = set_property;
+    object_class->dispose = dispose;
+
+    obj_properties[PROP_CONNECTION] = g_param_spec_object("connection",
+                                                    "Connection",
+                                                    "Http2ConnectionImpl Instance",
+                                                    RP_TYPE_HTTP2_CONNECTION_IMPL,
+                                                    G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties(object_class, N_PROPERTIES, obj_properties);
+}
+
+static void
+rp_http2_stream_impl_init(RpHttp2StreamImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    me->m_pending_recv_data = evbuffer_new();
+    me->m_pending_send_data = evbuffer_new();
+    me->m_stream_id = -1;
+    rp_http2_header_block_init(&me->m_pending_trailers);
+}
+
+gint32
+rp_http2_stream_impl_stream_id_(RpHttp2StreamImpl* self)
+{
+    g_return_val_if_fail(RP_IS_HTTP2_STREAM_IMPL(self), -1);
+    return PRIV(self)->m_stream_id;
+}
+
+void
+rp_http2_stream_impl_set_stream_id(RpHttp2StreamImpl* self, gint32 stream_id)
+{
+    LOGD("(%p, %d)", self, stream_id);
+    g_return_if_fail(RP_IS_HTTP2_STREAM_IMPL(self));
+    PRIV(self)->m_stream_id = stream_id;
+}
+
+RpHttp2ConnectionImpl*
+rp_http2_stream_impl_connection_(RpHttp2StreamImpl* self)
+{
+    g_return_val_if_fail(RP_IS_HTTP2_STREAM_IMPL(self), NULL);
+    return PRIV(self)->m_connection;
+}
+
+bool
+rp_http2_stream_impl_remote_headers_received(RpHttp2StreamImpl* self)
+{
+    g_return_val_if_fail(RP_IS_HTTP2_STREAM_IMPL(self), false);
+    return PRIV(self)->m_remote_headers_received;
+}
+
+void
+rp_http2_stream_impl_set_local_end_stream(RpHttp2StreamImpl* self)
+{
+    LOGD("(%p)", self);
+    g_return_if_fail(RP_IS_HTTP2_STREAM_IMPL(self));
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    me->m_local_end_stream = true;
+}
+
+void
+rp_http2_stream_impl_on_end_stream_sent(RpHttp2StreamImpl* self)
+{
+    LOGD("(%p)", self);
+    g_return_if_fail(RP_IS_HTTP2_STREAM_IMPL(self));
+    // Only complete once END_STREAM is on the wire, not when it is queued
+    // behind the body.
+    notify_encode_complete(PRIV(self));
+}
+
+static ssize_t
+on_data_source_read(nghttp2_session* session, gint32 stream_id, guint8* buf G_GNUC_UNUSED,
+                    size_t length, guint32* data_flags, nghttp2_data_source* source,
+                    void* user_data G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %d, %p, %zu, %p, %p, %p)", session, stream_id, buf, length, data_flags, source, user_data);
+
+    RpHttp2StreamImplPrivate* me = PRIV(source->ptr);
+    size_t pending = evbuffer_get_length(me->m_pending_send_data);
+    if (pending == 0 && !me->m_local_end_stream)
+    {
+        me->m_data_deferred = true;
+        return NGHTTP2_ERR_DEFERRED;
+    }
+
+    // Bytes are handed over in on_send_data() straight from the send buffer.
+    *data_flags |= NGHTTP2_DATA_FLAG_NO_COPY;
+    if (me->m_local_end_stream && pending <= length)
+    {
+        *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+        if (me->m_pending_trailers_to_encode)
+        {
+            *data_flags |= NGHTTP2_DATA_FLAG_NO_END_STREAM;
+            int rv = nghttp2_submit_trailer(session,
+                                            stream_id,
+                                            rp_http2_header_block_nva(&me->m_pending_trailers),
+                                            rp_http2_header_block_nvlen(&me->m_pending_trailers));
+            if (rv != 0)
+            {
+                LOGE("submit trailer failed on stream %d: %s", stream_id, nghttp2_strerror(rv));
+            }
+            me->m_pending_trailers_to_encode = false;
+        }
+    }
+    return MIN(pending, length);
+}
+
+void
+rp_http2_stream_impl_data_provider(RpHttp2StreamImpl* self, nghttp2_data_provider* provider)
+{
+    NOISY_MSG_("(%p, %p)", self, provider);
+    g_return_if_fail(RP_IS_HTTP2_STREAM_IMPL(self));
+    g_return_if_fail(provider != NULL);
+    provider->source.ptr = self;
+    provider->read_callback = on_data_source_read;
+}
+
+void
+rp_http2_stream_impl_encode_trailers_base(RpHttp2StreamImpl* self, evhtp_headers_t* trailers)
+{
+    LOGD("(%p, %p)", self, trailers);
+
+    g_return_if_fail(RP_IS_HTTP2_STREAM_IMPL(self));
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    if (me->m_closed)
+    {
+        return;
+    }
+
+    // Submitted from the data source once the body has drained, so the
+    // values have to outlive the caller's map.
+    rp_http2_header_block_add_headers(&me->m_pending_trailers, trailers, true);
+    me->m_pending_trailers_to_encode = rp_http2_header_block_nvlen(&me->m_pending_trailers) > 0;
+    rp_http2_stream_impl_set_local_end_stream(self);
+
+    resume_data_if_deferred(me);
+    rp_http2_connection_impl_send_pending_frames(me->m_connection);
+}
+
+void
+rp_http2_stream_impl_on_begin_headers(RpHttp2StreamImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    if (!me->m_headers)
+    {
+        me->m_headers = rp_header_map_new();
+    }
+}
+
+void
+rp_http2_stream_impl_save_header(RpHttp2StreamImpl* self, const guint8* name, size_t namelen, const guint8* value, size_t valuelen)
+{
+    NOISY_MSG_("(%p, %p, %zu, %p, %zu)", self, name, namelen, value, valuelen);
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    if (!me->m_headers)
+    {
+        me->m_headers = rp_header_map_new();
+    }
+    rp_header_map_add_copy(me->m_headers, (const char*)name, namelen, (const char*)value, valuelen);
+}
+
+void
+rp_http2_stream_impl_on_headers_complete(RpHttp2StreamImpl* self, bool end_stream)
+{
+    NOISY_MSG_("(%p, %u)", self, end_stream);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    RpHttp2StreamImplClass* klass = RP_HTTP2_STREAM_IMPL_GET_CLASS(self);
+    evhtp_headers_t* headers = g_steal_pointer(&me->m_headers);
+    if (!headers)
+    {
+        headers = rp_header_map_new();
+    }
+
+    if (end_stream)
+    {
+        me->m_remote_end_stream = true;
+    }
+
+    if (!me->m_remote_headers_received)
+    {
+        if (end_stream)
+        {
+            me->m_end_stream_decoded = true;
+        }
+        me->m_remote_headers_received = klass->decode_headers(self, headers, end_stream);
+    }
+    else if (me->m_read_disable_count > 0 && evbuffer_get_length(me->m_pending_recv_data) > 0)
+    {
+        // Keep trailers behind the body they follow.
+        me->m_pending_recv_trailers = headers;
+    }
+    else
+    {
+        me->m_end_stream_decoded = true;
+        klass->decode_trailers(self, headers);
+    }
+}
+
+void
+rp_http2_stream_impl_on_data(RpHttp2StreamImpl* self, const guint8* data, size_t len)
+{
+    NOISY_MSG_("(%p, %p, %zu)", self, data, len);
+    evbuffer_add(PRIV(self)->m_pending_recv_data, data, len);
+}
+
+void
+rp_http2_stream_impl_on_data_complete(RpHttp2StreamImpl* self, bool end_stream)
+{
+    NOISY_MSG_("(%p, %u)", self, end_stream);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    if (end_stream)
+    {
+        me->m_remote_end_stream = true;
+    }
+    if (me->m_read_disable_count == 0)
+    {
+        flush_pending_recv_data(self);
+    }
+}
+
+void
+rp_http2_stream_impl_on_send_data(RpHttp2StreamImpl* self, evbuf_t* output, const guint8* framehd, size_t length, size_t padlen)
+{
+    NOISY_MSG_("(%p, %p, %p, %zu, %zu)", self, output, framehd, length, padlen);
+
+    static const guint8 padding[256] = { 0 };
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+
+    evbuffer_add(output, framehd, 9);
+    if (padlen > 0)
+    {
+        guint8 padlen_field = padlen - 1;
+        evbuffer_add(output, &padlen_field, 1);
+    }
+    evbuffer_remove_buffer(me->m_pending_send_data, output, length);
+    if (padlen > 1)
+    {
+        evbuffer_add(output, padding, padlen - 1);
+    }
+
+    if (me->m_pending_send_buffer_high_watermark_called &&
+        evbuffer_get_length(me->m_pending_send_data) < buffer_limit_i(RP_STREAM(self)) / 2)
+    {
+        me->m_pending_send_buffer_high_watermark_called = false;
+        rp_stream_callback_helper_run_low_watermark_callbacks(RP_STREAM_CALLBACK_HELPER(self));
+    }
+}
+
+bool
+rp_http2_stream_impl_on_close(RpHttp2StreamImpl* self, guint32 error_code)
+{
+    LOGD("(%p, %u)", self, error_code);
+
+    g_return_val_if_fail(RP_IS_HTTP2_STREAM_IMPL(self), false);
+
+    RpHttp2StreamImplPrivate* me = PRIV(self);
+    me->m_closed = true;
+
+    // Body held back for a read-disabled decoder was never consumed. Give the
+    // connection window back now, delivered or not; with automatic window
+    // updates off it would otherwise be lost to the connection for good.
+    size_t undelivered = evbuffer_get_length(me->m_pending_recv_data);
+    if (undelivered > 0)
+    {
+        NOISY_MSG_("releasing %zu undelivered bytes on stream %d", undelivered, me->m_stream_id);
+        rp_http2_connection_impl_consume(me->m_connection, me->m_stream_id, undelivered);
+    }
+
+    if (!me->m_remote_end_stream || !me->m_local_end_stream)
+    {
+        evbuffer_drain(me->m_pending_recv_data, undelivered);
+        g_clear_pointer(&me->m_pending_recv_trailers, rp_header_map_free);
+
+        RpStreamResetReason_e reason;
+        if (error_code == NGHTTP2_REFUSED_STREAM)
+        {
+            reason = RpStreamResetReason_RemoteRefusedStreamReset;
+        }
+        else if (error_code == NGHTTP2_CONNECT_ERROR)
+        {
+            reason = RpStreamResetReason_ConnectError;
+        }
+        else
+        {
+            reason = RpStreamResetReason_RemoteReset;
+        }
+        rp_stream_callback_helper_run_reset_callbacks(RP_STREAM_CALLBACK_HELPER(self), reason, "");
+        return false;
+    }
+
+    // A complete response still waiting on read_disable(false) keeps the
+    // stream around until it has been delivered.
+    return me->m_read_disable_count > 0 && !me->m_end_stream_decoded;
+}
@@ -0,0 +1,108 @@
+/*
+ * rp-http2-stream-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <evhtp.h>
+#include <nghttp2/nghttp2.h>
+#include "rp-codec.h"
+#include "rp-codec-helper.h"
+#include "http2/rp-http2-connection-impl.h"
+
+G_BEGIN_DECLS
+
+/**
+ * A header block ready to be handed to nghttp2. Names are lower-cased into the
+ * block's own storage since HTTP/2 forbids upper case field names.
+ */
+typedef struct _RpHttp2HeaderBlock RpHttp2HeaderBlock;
+struct _RpHttp2HeaderBlock {
+    GArray* m_nva;
+    GStringChunk* m_strings;
+};
+
+void rp_http2_header_block_init(RpHttp2HeaderBlock* self);
+void rp_http2_header_block_clear(RpHttp2HeaderBlock* self);
+void rp_http2_header_block_add(RpHttp2HeaderBlock* self,
+                                const char* name,
+                                const char* value,
+                                size_t vlen,
+                                bool copy_value);
+/* Adds every regular header, dropping pseudo and connection-specific ones.
+ * Names are always copied; values are referenced in place unless @copy_values
+ * is set, so the block must then be submitted before @headers goes away. */
+void rp_http2_header_block_add_headers(RpHttp2HeaderBlock* self,
+                                        evhtp_headers_t* headers,
+                                        bool copy_values);
+
+static inline const nghttp2_nv*
+rp_http2_header_block_nva(RpHttp2HeaderBlock* self)
+{
+    return (const nghttp2_nv*)self->m_nva->data;
+}
+static inline size_t
+rp_http2_header_block_nvlen(RpHttp2HeaderBlock* self)
+{
+    return self->m_nva->len;
+}
+
+/**
+ * Base class for client and server side HTTP/2 streams.
+ */
+// https://github.com/envoyproxy/envoy/blob/main/source/common/http/http2/codec_impl.h#L237
+#define RP_TYPE_HTTP2_STREAM_IMPL rp_http2_stream_impl_get_type()
+G_DECLARE_DERIVABLE_TYPE(RpHttp2StreamImpl, rp_http2_stream_impl, RP, HTTP2_STREAM_IMPL, RpStreamCallbackHelper)
+
+struct _RpHttp2StreamImplClass {
+    RpStreamCallbackHelperClass parent_class;
+
+    /* Ownership of the header map passes to the callee. Returns false for
+     * informational (1xx) headers so that the next block is not mistaken
+     * for trailers. */
+    bool (*decode_headers)(RpHttp2StreamImpl*, evhtp_headers_t*, bool);
+    void (*decode_trailers)(RpHttp2StreamImpl*, evhtp_headers_t*);
+    RpStreamDecoder* (*decoder)(RpHttp2StreamImpl*);
+};
+
+gint32 rp_http2_stream_impl_stream_id_(RpHttp2StreamImpl* self);
+void rp_http2_stream_impl_set_stream_id(RpHttp2StreamImpl* self, gint32 stream_id);
+RpHttp2ConnectionImpl* rp_http2_stream_impl_connection_(RpHttp2StreamImpl* self);
+bool rp_http2_stream_impl_remote_headers_received(RpHttp2StreamImpl* self);
+void rp_http2_stream_impl_set_local_end_stream(RpHttp2StreamImpl* self);
+void rp_http2_stream_impl_data_provider(RpHttp2StreamImpl* self,
+                                        nghttp2_data_provider* provider);
+void rp_http2_stream_impl_encode_trailers_base(RpHttp2StreamImpl* self,
+                                                evhtp_headers_t* trailers);
+
+/* Driven by RpHttp2ConnectionImpl from the nghttp2 session callbacks. */
+void rp_http2_stream_impl_on_begin_headers(RpHttp2StreamImpl* self);
+void rp_http2_stream_impl_save_header(RpHttp2StreamImpl* self,
+                                        const guint8* name,
+                                        size_t namelen,
+                                        const guint8* value,
+                                        size_t valuelen);
+void rp_http2_stream_impl_on_headers_complete(RpHttp2StreamImpl* self,
+                                                bool end_stream);
+void rp_http2_stream_impl_on_data(RpHttp2StreamImpl* self,
+                                    const guint8* data,
+                                    size_t len);
+void rp_http2_stream_impl_on_data_complete(RpHttp2StreamImpl* self,
+                                            bool end_stream);
+void rp_http2_stream_impl_on_send_data(RpHttp2StreamImpl* self,
+                                        evbuf_t* output,
+                                        const guint8* framehd,
+                                        size_t length,
+                                        size_t padlen);
+void rp_http2_stream_impl_on_end_stream_sent(RpHttp2StreamImpl* self);
+/* Returns true if the stream holds a complete response for a read-disabled
+ * decoder; it then removes itself from the connection once delivered. */
+bool rp_http2_stream_impl_on_close(RpHttp2StreamImpl* self,
+                                    guint32 error_code);
+
+G_END_DECLS
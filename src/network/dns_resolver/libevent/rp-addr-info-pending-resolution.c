@@ -345,9 +345,11 @@ evdns_get_addr_info_cb(int errcode, struct evutil_addrinfo *addr, gpointer arg)
         pending_response_->m_details = g_strconcat("evdns_failure:", evutil_gai_strerror(errcode), NULL);
     }
 
+    pending_response_->m_dns_error = errcode;
     if (errcode == DNS_ERR_TIMEOUT)
     {
         LOGD("DNS request timed out"); //TODO...%d times
+        pending_response_->m_timed_out = true;
     }
 
     if (rp_pending_resolution_completed_(pending_resolution))
@@ -495,9 +497,11 @@ evdns_get_addr_info_cb(int status, char type, int count, int ttl, void* addresse
         pending_response_->m_details = g_strconcat("evdns_failure:", evdns_err_to_string(status), NULL);
     }
 
+    pending_response_->m_dns_error = status;
     if (status == DNS_ERR_TIMEOUT)
     {
         LOGD("DNS request timed out"); //TODO...%d times
+        pending_response_->m_timed_out = true;
     }
 
     if (rp_pending_resolution_completed_(pending_resolution))
@@ -23,17 +23,106 @@ struct _RpDnsResolverImpl {
     evdns_base_t* m_dns_base;
 
     GHashTable* m_inflight;
+    GHashTable* m_cache;    /* <key, RpDnsCacheEntry*> */
 
     bool m_dirty_channel : 1;
     bool m_filter_unroutable_families : 1;
 };
 
+typedef struct _RpDnsCacheEntry RpDnsCacheEntry;
+struct _RpDnsCacheEntry {
+    GList* /* <DnsResponse> */ m_address_list; /* NULL for a name that does not exist */
+    gint64 m_expires_at;
+};
+
 static void network_dns_resolver_iface_init(RpNetworkDnsResolverInterface* iface);
 
 G_DEFINE_TYPE_WITH_CODE(RpDnsResolverImpl, rp_dns_resolver_impl, G_TYPE_OBJECT,
     G_IMPLEMENT_INTERFACE(RP_TYPE_NETWORK_DNS_RESOLVER, network_dns_resolver_iface_init)
 )
 
+static void
+cache_entry_free(RpDnsCacheEntry* self)
+{
+    NOISY_MSG_("(%p)", self);
+    g_list_free_full(g_steal_pointer(&self->m_address_list), g_object_unref);
+    g_free(self);
+}
+
+static GList*
+copy_responses(GList* address_list, guint64 ttl)
+{
+    NOISY_MSG_("(%p, %zu)", address_list, ttl);
+    GList* copy = NULL;
+    for (GList* itr = address_list; itr; itr = itr->next)
+    {
+        const RpAddrInfoResponse* addr_info = rp_network_dns_response_addr_info(itr->data);
+        copy = g_list_prepend(copy, rp_network_dns_response_new(addr_info->m_address, ttl));
+    }
+    return g_list_reverse(copy);
+}
+
+static gboolean
+past_stale_cb(gpointer key G_GNUC_UNUSED, gpointer value, gpointer arg)
+{
+    RpDnsCacheEntry* entry = value;
+    gint64 now = *(gint64*)arg;
+    return entry->m_expires_at + RP_DNS_CACHE_MAX_STALE * G_USEC_PER_SEC <= now;
+}
+
+static void
+cache_insert(RpDnsResolverImpl* self, const char* key, GList* address_list, guint64 ttl, gint64 now)
+{
+    NOISY_MSG_("(%p, %p(%s), %p, %zu, %zd)", self, key, key, address_list, ttl, now);
+
+    if (g_hash_table_size(self->m_cache) >= RP_DNS_CACHE_MAX_ENTRIES &&
+        !g_hash_table_contains(self->m_cache, key))
+    {
+        g_hash_table_foreach_remove(self->m_cache, past_stale_cb, &now);
+        if (g_hash_table_size(self->m_cache) >= RP_DNS_CACHE_MAX_ENTRIES)
+        {
+            LOGD("cache full; not caching \"%s\"", key);
+            g_list_free_full(address_list, g_object_unref);
+            return;
+        }
+    }
+
+    RpDnsCacheEntry* entry = g_new(RpDnsCacheEntry, 1);
+    entry->m_address_list = address_list;
+    entry->m_expires_at = now + ttl * G_USEC_PER_SEC;
+    g_hash_table_insert(self->m_cache, g_strdup(key), entry);
+}
+
+static bool
+resolve_from_cache(RpDnsResolverImpl* self, RpPendingResolution* pending_resolution)
+{
+    NOISY_MSG_("(%p, %p)", self, pending_resolution);
+
+    const char* key = rp_pending_resolution_key_(pending_resolution);
+    RpDnsCacheEntry* entry = g_hash_table_lookup(self->m_cache, key);
+    gint64 now = g_get_monotonic_time();
+    if (!entry || entry->m_expires_at <= now)
+    {
+        NOISY_MSG_("cache miss for \"%s\"", key);
+        return false;
+    }
+
+    if (!entry->m_address_list)
+    {
+        LOGD("negative cache hit for \"%s\"", key);
+        rp_pending_resolution_finish_from_cache(pending_resolution, RpDnsResolutionStatus_COMPLETED, "cache_norecords", NULL);
+        return true;
+    }
+
+    guint64 ttl = (entry->m_expires_at - now + G_USEC_PER_SEC - 1) / G_USEC_PER_SEC;
+    LOGD("cache hit for \"%s\", ttl %zu", key, ttl);
+    rp_pending_resolution_finish_from_cache(pending_resolution,
+                                            RpDnsResolutionStatus_COMPLETED,
+                                            "cache_success",
+                                            copy_responses(entry->m_address_list, ttl));
+    return true;
+}
+
 // Dispatcher post callback that runs in main thread (dns thread).
 static void
 start_resolution_cb(gpointer arg)
@@ -41,6 +130,11 @@ start_resolution_cb(gpointer arg)
     NOISY_MSG_("(%p)", arg);
     RpAddrInfoPendingResolution* self = arg;
     RpDnsResolverImpl* me = rp_pending_resolution_parent_(RP_PENDING_RESOLUTION(self));
+    if (resolve_from_cache(me, RP_PENDING_RESOLUTION(self)))
+    {
+        NOISY_MSG_("resolved from cache");
+        return;
+    }
     rp_addr_info_pending_resolution_start_resolution(self, me->m_inflight);
 }
 
@@ -109,6 +203,7 @@ dispose(GObject* obj)
     RpDnsResolverImpl* self = RP_DNS_RESOLVER_IMPL(obj);
     g_clear_pointer(&self->m_dns_base, dns_base_free);
     g_hash_table_destroy(g_steal_pointer(&self->m_inflight));
+    g_clear_pointer(&self->m_cache, g_hash_table_destroy);
 
     G_OBJECT_CLASS(rp_dns_resolver_impl_parent_class)->dispose(obj);
 }
@@ -127,6 +222,7 @@ rp_dns_resolver_impl_init(RpDnsResolverImpl* self)
     NOISY_MSG_("(%p)", self);
     self->m_filter_unroutable_families = true;//REVISIT: should come from config.
     self->m_inflight = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+    self->m_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)cache_entry_free);
 }
 
 RpDnsResolverImpl*
@@ -164,3 +260,59 @@ rp_dns_resolver_impl_inflight_(RpDnsResolverImpl* self)
     g_return_val_if_fail(RP_IS_DNS_RESOLVER_IMPL(self), NULL);
     return self->m_inflight;
 }
+
+/**
+ * Caches the outcome of a finished resolution for |key|, or, when the
+ * resolver timed out, hands back the last answer for |key| in its place.
+ * Answers that reach the waiters carry the clamped TTL. Runs in the
+ * main/dns thread.
+ */
+void
+rp_dns_resolver_impl_update_cache_(RpDnsResolverImpl* self, const char* key, RpPendingResponse* pending_response)
+{
+    LOGD("(%p, %p(%s), %p)", self, key, key, pending_response);
+
+    g_return_if_fail(RP_IS_DNS_RESOLVER_IMPL(self));
+    g_return_if_fail(key != NULL);
+    g_return_if_fail(pending_response != NULL);
+
+    gint64 now = g_get_monotonic_time();
+    if (pending_response->m_status == RpDnsResolutionStatus_COMPLETED && pending_response->m_address_list)
+    {
+        guint64 ttl = G_MAXUINT64;
+        for (GList* itr = pending_response->m_address_list; itr; itr = itr->next)
+        {
+            ttl = MIN(ttl, rp_network_dns_response_addr_info(itr->data)->m_ttl);
+        }
+        ttl = CLAMP(ttl, RP_DNS_CACHE_MIN_TTL, RP_DNS_CACHE_MAX_TTL);
+        NOISY_MSG_("caching \"%s\" for %zu seconds", key, ttl);
+
+        GList* address_list = copy_responses(pending_response->m_address_list, ttl);
+        g_list_free_full(pending_response->m_address_list, g_object_unref);
+        pending_response->m_address_list = address_list;
+        cache_insert(self, key, copy_responses(address_list, ttl), ttl, now);
+        return;
+    }
+
+    if (pending_response->m_timed_out)
+    {
+        RpDnsCacheEntry* entry = g_hash_table_lookup(self->m_cache, key);
+        if (entry && entry->m_address_list &&
+            now < entry->m_expires_at + RP_DNS_CACHE_MAX_STALE * G_USEC_PER_SEC)
+        {
+            LOGD("serving stale answer for \"%s\"", key);
+            g_list_free_full(pending_response->m_address_list, g_object_unref);
+            g_free(pending_response->m_details);
+            pending_response->m_status = RpDnsResolutionStatus_COMPLETED;
+            pending_response->m_details = g_strdup("evdns_stale:timeout");
+            pending_response->m_address_list = copy_responses(entry->m_address_list, RP_DNS_CACHE_STALE_TTL);
+        }
+        return;
+    }
+
+    if (pending_response->m_dns_error == DNS_ERR_NOTEXIST)
+    {
+        NOISY_MSG_("caching nxdomain for \"%s\"", key);
+        cache_insert(self, key, NULL, RP_DNS_CACHE_NEGATIVE_TTL, now);
+    }
+}
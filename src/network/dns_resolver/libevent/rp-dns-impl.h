@@ -16,6 +16,17 @@ G_BEGIN_DECLS
 
 #define RP_DNS_DEFAULT_TTL 60
 
+// Resolver cache. Answers are kept for their TTL clamped to [MIN, MAX];
+// names that do not exist (NXDOMAIN) for NEGATIVE_TTL. When the resolver
+// times out, an answer up to MAX_STALE past its TTL is served instead, with
+// STALE_TTL (RFC 8767).
+#define RP_DNS_CACHE_MIN_TTL 5
+#define RP_DNS_CACHE_MAX_TTL 3600
+#define RP_DNS_CACHE_NEGATIVE_TTL 30
+#define RP_DNS_CACHE_STALE_TTL 30
+#define RP_DNS_CACHE_MAX_STALE (24 * 3600)
+#define RP_DNS_CACHE_MAX_ENTRIES 4096
+
 
 /**
  * RpDnsResolverImpl
@@ -28,6 +39,11 @@ void rp_dns_resolver_impl_set_dirty_channel_(RpDnsResolverImpl* self, bool dirty
 bool rp_dns_resolver_impl_filter_unroutable_families_(RpDnsResolverImpl* self);
 GHashTable* rp_dns_resolver_impl_inflight_(RpDnsResolverImpl* self);
 
+typedef struct _RpPendingResponse RpPendingResponse;
+void rp_dns_resolver_impl_update_cache_(RpDnsResolverImpl* self,
+                                        const char* key,
+                                        RpPendingResponse* pending_response);
+
 
 /**
  * Network::ActiveDnsQuery
@@ -40,12 +56,13 @@ struct _RpPendingResolutionClass {
 
 };
 
-typedef struct _RpPendingResponse RpPendingResponse;
 struct _RpPendingResponse {
     RpDnsResolutionStatus_e m_status;
     GList* /* <DnsResponse> */ m_address_list;
     GList* /* <PendingResolution> */ m_waiters;
     char* m_details;
+    int m_dns_error;    /* of the last query */
+    bool m_timed_out;   /* any query */
 };
 static inline RpPendingResponse
 rp_pending_response_ctor(RpDnsResolutionStatus_e status, GList* address_list, GList* waiters, char* details)
@@ -74,6 +91,10 @@ RpPendingResponse* rp_pending_resolution_pending_response_(RpPendingResolution*
 const char* rp_pending_resolution_key_(RpPendingResolution* self);
 void rp_pending_resolution_add_waiter(RpPendingResolution* self, RpPendingResolution* waiter);
 void rp_pending_resolution_finish_resolve(RpPendingResolution* self);
+void rp_pending_resolution_finish_from_cache(RpPendingResolution* self,
+                                                RpDnsResolutionStatus_e status,
+                                                const char* details,
+                                                GList* address_list);
 void rp_pending_resolution_set_owned(RpPendingResolution* self, bool owned);
 
 
@@ -299,6 +299,8 @@ rp_pending_resolution_finish_resolve(RpPendingResolution* self)
     RpPendingResolutionPrivate* me = PRIV(self);
     RpDnsResolverImpl* parent_ = me->m_parent;
     char* key = g_steal_pointer(&me->m_key);
+    // May turn a timeout into a stale answer, so before anyone is told.
+    rp_dns_resolver_impl_update_cache_(parent_, key, &me->m_pending_response);
     if (!me->m_cancelled) // REVISIT: may not work post refactor.(?)
     {
         RpPendingResponse* pending_response = &me->m_pending_response;
@@ -340,6 +342,28 @@ rp_pending_resolution_finish_resolve(RpPendingResolution* self)
     g_free(key);
 }
 
+void
+rp_pending_resolution_finish_from_cache(RpPendingResolution* self, RpDnsResolutionStatus_e status, const char* details, GList* address_list)
+{
+    LOGD("(%p, %d, %p(%s), %p)", self, status, details, details, address_list);
+
+    g_return_if_fail(RP_IS_PENDING_RESOLUTION(self));
+
+    RpPendingResolutionPrivate* me = PRIV(self);
+    if (me->m_cancelled)
+    {
+        LOGD("evdns_dns_callback_cancelled");
+        g_list_free_full(address_list, g_object_unref);
+        return;
+    }
+
+    RpPendingResponse* pending_response = &me->m_pending_response;
+    pending_response->m_status = status;
+    pending_response->m_details = g_strdup(details);
+    pending_response->m_address_list = address_list;
+    rp_dispatcher_base_post(RP_DISPATCHER_BASE(me->m_dispatcher), trigger_callback_cb, self);
+}
+
 void
 rp_pending_resolution_set_owned(RpPendingResolution* self, bool owned)
 {
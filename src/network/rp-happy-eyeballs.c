@@ -0,0 +1,259 @@
+/*
+ * rp-happy-eyeballs.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_happy_eyeballs_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_happy_eyeballs_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <sys/socket.h>
+#include "network/rp-happy-eyeballs.h"
+
+typedef struct _RpConnectAttempt RpConnectAttempt;
+struct _RpConnectAttempt {
+    RpHappyEyeballs* m_parent;
+    evutil_socket_t m_fd;
+    RpNetworkAddressInstance* m_address;
+    struct event* m_event;
+};
+
+struct _RpHappyEyeballs {
+    GObject parent_instance;
+
+    GPtrArray* m_addresses;
+    guint m_next;
+    GList* m_attempts;  /* <RpConnectAttempt*> */
+    struct event* m_timer;
+    struct timeval m_delay;
+
+    RpHappyEyeballsCb m_cb;
+    gpointer m_arg;
+
+    int m_last_error;
+};
+
+G_DEFINE_FINAL_TYPE(RpHappyEyeballs, rp_happy_eyeballs, G_TYPE_OBJECT)
+
+static void start_next(RpHappyEyeballs* self);
+
+static void
+attempt_free(RpConnectAttempt* self)
+{
+    NOISY_MSG_("(%p)", self);
+    g_clear_pointer(&self->m_event, event_free);
+    if (self->m_fd != EVUTIL_INVALID_SOCKET)
+    {
+        evutil_closesocket(self->m_fd);
+    }
+    g_clear_object(&self->m_address);
+    g_free(self);
+}
+
+static void
+finish(RpHappyEyeballs* self, evutil_socket_t fd, RpNetworkAddressInstanceConstSharedPtr address, int err)
+{
+    NOISY_MSG_("(%p, %d, %p, %d)", self, fd, address, err);
+
+    g_clear_pointer(&self->m_timer, event_free);
+    g_list_free_full(g_steal_pointer(&self->m_attempts), (GDestroyNotify)attempt_free);
+    self->m_next = self->m_addresses->len;
+
+    // The callback may well drop the caller's reference.
+    g_object_ref(self);
+    self->m_cb(fd, address, err, self->m_arg);
+    g_object_unref(self);
+}
+
+static void
+attempt_cb(evutil_socket_t fd, short what G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpConnectAttempt* attempt = arg;
+    RpHappyEyeballs* self = attempt->m_parent;
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+    {
+        err = errno;
+    }
+
+    if (err == 0)
+    {
+        LOGD("fd %d connected to %s", fd, rp_network_address_instance_as_string(attempt->m_address));
+        attempt->m_fd = EVUTIL_INVALID_SOCKET;
+        g_autoptr(RpNetworkAddressInstance) address = g_object_ref(attempt->m_address);
+        finish(self, fd, address, 0);
+        return;
+    }
+
+    LOGD("connect to %s failed %d(%s)",
+        rp_network_address_instance_as_string(attempt->m_address), err, g_strerror(err));
+    self->m_last_error = err;
+    self->m_attempts = g_list_remove(self->m_attempts, attempt);
+    attempt_free(attempt);
+    // A failure doesn't wait out the attempt delay.
+    start_next(self);
+}
+
+static RpConnectAttempt*
+attempt_new(RpHappyEyeballs* self, RpNetworkAddressInstance* address)
+{
+    NOISY_MSG_("(%p, %p(%s))", self, address, rp_network_address_instance_as_string(address));
+
+    RpNetworkAddressIp* ip = rp_network_address_instance_ip(address);
+    int domain = rp_network_address_ip_version(ip) == RpIpVersion_v6 ? AF_INET6 : AF_INET;
+    evutil_socket_t fd = socket(domain, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        self->m_last_error = errno;
+        LOGE("socket() failed %d(%s)", self->m_last_error, g_strerror(self->m_last_error));
+        return NULL;
+    }
+
+    if (connect(fd, rp_network_address_instance_sock_addr(address), rp_network_address_instance_sock_addr_len(address)) != 0 &&
+        errno != EINPROGRESS)
+    {
+        self->m_last_error = errno;
+        LOGD("connect to %s failed %d(%s)",
+            rp_network_address_instance_as_string(address), self->m_last_error, g_strerror(self->m_last_error));
+        evutil_closesocket(fd);
+        return NULL;
+    }
+
+    RpConnectAttempt* attempt = g_new0(RpConnectAttempt, 1);
+    attempt->m_parent = self;
+    attempt->m_fd = fd;
+    attempt->m_address = g_object_ref(address);
+    // An immediate connect is picked up by the write event as well.
+    attempt->m_event = event_new(event_get_base(self->m_timer), fd, EV_WRITE, attempt_cb, attempt);
+    event_add(attempt->m_event, NULL);
+    return attempt;
+}
+
+static void
+start_next(RpHappyEyeballs* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    evtimer_del(self->m_timer);
+    while (self->m_next < self->m_addresses->len)
+    {
+        RpNetworkAddressInstance* address = g_ptr_array_index(self->m_addresses, self->m_next++);
+        RpConnectAttempt* attempt = attempt_new(self, address);
+        if (attempt)
+        {
+            NOISY_MSG_("attempt %u on fd %d", self->m_next, attempt->m_fd);
+            self->m_attempts = g_list_append(self->m_attempts, attempt);
+            if (self->m_next < self->m_addresses->len)
+            {
+                evtimer_add(self->m_timer, &self->m_delay);
+            }
+            return;
+        }
+    }
+
+    if (!self->m_attempts)
+    {
+        LOGD("all %u attempts failed", self->m_addresses->len);
+        finish(self, EVUTIL_INVALID_SOCKET, NULL, self->m_last_error);
+    }
+}
+
+static void
+timer_cb(evutil_socket_t fd G_GNUC_UNUSED, short what G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+    start_next(RP_HAPPY_EYEBALLS(arg));
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpHappyEyeballs* self = RP_HAPPY_EYEBALLS(obj);
+    g_clear_pointer(&self->m_timer, event_free);
+    g_list_free_full(g_steal_pointer(&self->m_attempts), (GDestroyNotify)attempt_free);
+    g_clear_pointer(&self->m_addresses, g_ptr_array_unref);
+
+    G_OBJECT_CLASS(rp_happy_eyeballs_parent_class)->dispose(obj);
+}
+
+static void
+rp_happy_eyeballs_class_init(RpHappyEyeballsClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_happy_eyeballs_init(RpHappyEyeballs* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_last_error = ECONNREFUSED;
+}
+
+RpHappyEyeballs*
+rp_happy_eyeballs_start(RpDispatcher* dispatcher, GPtrArray* addresses, guint delay_ms, RpHappyEyeballsCb cb, gpointer arg)
+{
+    LOGD("(%p, %p, %u, %p, %p)", dispatcher, addresses, delay_ms, cb, arg);
+
+    g_return_val_if_fail(RP_IS_DISPATCHER(dispatcher), NULL);
+    g_return_val_if_fail(addresses != NULL, NULL);
+    g_return_val_if_fail(addresses->len > 0, NULL);
+    g_return_val_if_fail(cb != NULL, NULL);
+
+    RpHappyEyeballs* self = g_object_new(RP_TYPE_HAPPY_EYEBALLS, NULL);
+    self->m_addresses = g_ptr_array_ref(addresses);
+    self->m_timer = evtimer_new(rp_dispatcher_base(dispatcher), timer_cb, self);
+    self->m_delay.tv_sec = delay_ms / 1000;
+    self->m_delay.tv_usec = (delay_ms % 1000) * 1000;
+    self->m_cb = cb;
+    self->m_arg = arg;
+    // The first attempt goes out from the event loop so that even an outright
+    // failure is never reported before the caller has the race in hand.
+    event_active(self->m_timer, EV_TIMEOUT, 0);
+    return self;
+}
+
+GPtrArray*
+rp_happy_eyeballs_sort_addresses(GPtrArray* addresses)
+{
+    LOGD("(%p)", addresses);
+
+    g_return_val_if_fail(addresses != NULL, NULL);
+
+    g_autoptr(GPtrArray) v6 = g_ptr_array_new();
+    g_autoptr(GPtrArray) v4 = g_ptr_array_new();
+    for (guint i = 0; i < addresses->len; ++i)
+    {
+        RpNetworkAddressInstance* address = g_ptr_array_index(addresses, i);
+        RpNetworkAddressIp* ip = rp_network_address_instance_ip(address);
+        g_ptr_array_add(rp_network_address_ip_version(ip) == RpIpVersion_v6 ? v6 : v4, address);
+    }
+
+    GPtrArray* self = g_ptr_array_new_full(addresses->len, g_object_unref);
+    for (guint i = 0; i < v6->len || i < v4->len; ++i)
+    {
+        if (i < v6->len)
+        {
+            g_ptr_array_add(self, g_object_ref(g_ptr_array_index(v6, i)));
+        }
+        if (i < v4->len)
+        {
+            g_ptr_array_add(self, g_object_ref(g_ptr_array_index(v4, i)));
+        }
+    }
+    return self;
+}
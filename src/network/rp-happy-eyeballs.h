@@ -0,0 +1,59 @@
+/*
+ * rp-happy-eyeballs.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rproxy.h"
+#include "rp-dispatcher.h"
+#include "rp-net-address.h"
+
+G_BEGIN_DECLS
+
+// RFC 8305 "Connection Attempt Delay".
+#define RP_HAPPY_EYEBALLS_DEFAULT_DELAY_MS 250
+
+/**
+ * Called on the dispatcher's thread with the first socket to connect, and the
+ * address it connected to, or with |fd| -1 and the last error once every
+ * attempt has failed. The caller owns |fd|.
+ */
+typedef void (*RpHappyEyeballsCb)(evutil_socket_t fd,
+                                    RpNetworkAddressInstanceConstSharedPtr address,
+                                    int err,
+                                    gpointer arg);
+
+/**
+ * Races non-blocking connects to a list of addresses (RFC 8305). Attempts go
+ * out in list order, a new one whenever the previous has been outstanding for
+ * the attempt delay or has failed, and the first to connect wins; the rest
+ * are closed. Dropping the last reference before the callback cancels the
+ * race.
+ */
+#define RP_TYPE_HAPPY_EYEBALLS rp_happy_eyeballs_get_type()
+G_DECLARE_FINAL_TYPE(RpHappyEyeballs, rp_happy_eyeballs, RP, HAPPY_EYEBALLS, GObject)
+
+/**
+ * @param addresses RpNetworkAddressInstance*s, in the order to try them
+ *        (see rp_happy_eyeballs_sort_addresses()).
+ */
+RpHappyEyeballs* rp_happy_eyeballs_start(RpDispatcher* dispatcher,
+                                            GPtrArray* addresses,
+                                            guint delay_ms,
+                                            RpHappyEyeballsCb cb,
+                                            gpointer arg);
+
+/**
+ * Orders |addresses| (RpNetworkAddressInstance*s) for a race: the address
+ * families alternate, starting with IPv6 if there is any, and the resolver's
+ * order is kept within each family.
+ * @return a new array holding its own references.
+ */
+GPtrArray* rp_happy_eyeballs_sort_addresses(GPtrArray* addresses);
+
+G_END_DECLS
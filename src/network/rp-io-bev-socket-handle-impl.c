@@ -318,6 +318,26 @@ connect_i(RpIoHandle* self, RpNetworkAddressInstanceConstSharedPtr address)
     return rp_sys_call_int_ctor(rc, errno);
 }
 
+static RpSysCallIntResult
+connect_socket_i(RpIoHandle* self, evutil_socket_t fd, RpNetworkAddressInstanceConstSharedPtr address)
+{
+    NOISY_MSG_("(%p(fd %d), %d, %p)", self, SOCKFD(self), fd, address);
+    RpIoBevSocketHandleImpl* me = RP_IO_BEV_SOCKET_HANDLE_IMPL(self);
+    if (bufferevent_getfd(me->m_bev) != EVUTIL_INVALID_SOCKET)
+    {
+        LOGE("fd %d already open", bufferevent_getfd(me->m_bev));
+        return rp_sys_call_int_ctor(-1, EISCONN);
+    }
+    me->m_type = RpHandleType_Connecting;
+    rp_network_address_instance_impl_set_object(&me->m_remote_address, address);
+    bufferevent_setcb(me->m_bev, NULL, NULL, eventcb, self);
+    bufferevent_setfd(me->m_bev, fd);
+    // With the fd already set and no address, libevent skips connect() and
+    // reports BEV_EVENT_CONNECTED once the socket is writable.
+    int rc = bufferevent_socket_connect(me->m_bev, NULL, 0);
+    return rp_sys_call_int_ctor(rc, errno);
+}
+
 static void
 enable_file_events_i(RpIoHandle* self, guint32 events)
 {
@@ -499,6 +519,43 @@ sockfd_i(RpIoHandle* self)
     return SOCKFD(self);
 }
 
+static gsize
+buffered_bytes_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    evbev_t* bev = RP_IO_BEV_SOCKET_HANDLE_IMPL(self)->m_bev;
+    if (!bev)
+    {
+        NOISY_MSG_("no bev");
+        return 0;
+    }
+    return evbuffer_get_length(bufferevent_get_input(bev)) +
+            evbuffer_get_length(bufferevent_get_output(bev));
+}
+
+static void
+suspend_i(RpIoHandle* self, bool suspend)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), suspend);
+    evbev_t* bev = RP_IO_BEV_SOCKET_HANDLE_IMPL(self)->m_bev;
+    if (!bev)
+    {
+        NOISY_MSG_("no bev");
+        return;
+    }
+    // Disabling, rather than just clearing the read callback, keeps the
+    // bufferevent from pulling bytes off the socket into its input buffer.
+    // Writing stays enabled so that its output buffer still drains.
+    if (suspend)
+    {
+        bufferevent_disable(bev, EV_READ);
+    }
+    else
+    {
+        bufferevent_enable(bev, EV_READ);
+    }
+}
+
 static void
 io_handle_iface_init(RpIoHandleInterface* iface)
 {
@@ -506,6 +563,7 @@ io_handle_iface_init(RpIoHandleInterface* iface)
     iface->activate_file_events = activate_file_events_i;
     iface->close = close_i;
     iface->connect = connect_i;
+    iface->connect_socket = connect_socket_i;
     iface->enable_file_events = enable_file_events_i;
     iface->initialize_file_event = initialize_file_event_i;
     iface->interface_name = interface_name_i;
@@ -518,6 +576,8 @@ io_handle_iface_init(RpIoHandleInterface* iface)
     iface->read = read_i;
     iface->write = write_i;
     iface->sockfd = sockfd_i;
+    iface->buffered_bytes = buffered_bytes_i;
+    iface->suspend = suspend_i;
 }
 
 static void
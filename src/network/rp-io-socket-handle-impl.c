@@ -0,0 +1,818 @@
+/*
+ * rp-io-socket-handle-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_io_socket_handle_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_io_socket_handle_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <sys/uio.h>
+#include "rp-dispatcher.h"
+#include "event/rp-schedulable-cb-impl.h"
+#include "network/rp-address-impl.h"
+#include "network/rp-io-socket-handle-impl.h"
+
+#define SOCKFD(s) RP_IO_SOCKET_HANDLE_IMPL(s)->m_fd
+
+// Bytes reserved in the caller's buffer for each read.
+#define READ_SIZE (64 * 1024)
+#define READ_IOVECS 2
+
+// How long output left behind by close() may take to drain.
+#define LINGER_TIMEOUT_S 30
+
+typedef struct _RpIoSocketHandleImpl RpIoSocketHandleImpl;
+struct _RpIoSocketHandleImpl {
+    GObject parent_instance;
+
+    evutil_socket_t m_fd;
+    evbuf_t* m_read_ahead;  /* owned, may be NULL */
+    evbuf_t* m_pending;     /* owned */
+
+    RpDispatcher* m_dispatcher;
+    RpSchedulableCallback* m_activation_cb;
+    struct event* m_read_event;
+    struct event* m_write_event;
+    RpNetworkAddressInstance* m_local_address;  /* owned */
+    RpNetworkAddressInstance* m_remote_address; /* owned */
+
+    RpFileReadyCb m_cb;
+    gpointer m_arg;
+
+    guint32 m_injected_activation_events;
+    guint32 m_enabled_events;
+
+    RpHandleType_e m_type;
+    int m_pending_shutdown;
+
+    bool m_connecting : 1;
+    bool m_was_connected : 1;
+    bool m_initialized : 1;
+    bool m_suspended : 1;
+};
+
+static void file_event_merge_injected_events_and_run_cb(RpIoSocketHandleImpl* self, guint32 events);
+static void io_handle_iface_init(RpIoHandleInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpIoSocketHandleImpl, rp_io_socket_handle_impl, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_IO_HANDLE, io_handle_iface_init)
+)
+
+static inline bool
+is_would_block(int err)
+{
+    return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+}
+
+// Writes as much of |buffer| as the socket takes right now; a writev() per
+// call of evbuffer_write(). Returns false on a hard error, with errno set.
+static bool
+drain_to_socket(evutil_socket_t fd, evbuf_t* buffer)
+{
+    NOISY_MSG_("(%d, %p(%zu))", fd, buffer, evbuffer_get_length(buffer));
+
+    while (evbuffer_get_length(buffer) > 0)
+    {
+        int n = evbuffer_write(buffer, fd);
+        if (n < 0)
+        {
+            if (is_would_block(errno))
+            {
+                NOISY_MSG_("fd %d would block", fd);
+                break;
+            }
+            return false;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        NOISY_MSG_("%d bytes written to fd %d", n, fd);
+    }
+    return true;
+}
+
+typedef struct _RpLinger RpLinger;
+struct _RpLinger {
+    evutil_socket_t m_fd;
+    evbuf_t* m_pending;
+    struct event* m_event;
+    int m_shutdown;
+};
+
+static void
+linger_free(RpLinger* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+    g_clear_pointer(&self->m_event, event_free);
+    g_clear_pointer(&self->m_pending, evbuffer_free);
+    evutil_closesocket(self->m_fd);
+    g_free(self);
+}
+
+static void
+linger_cb(evutil_socket_t fd, short what, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpLinger* self = arg;
+    if (what & EV_TIMEOUT)
+    {
+        LOGD("gave up on %zu bytes for fd %d", evbuffer_get_length(self->m_pending), fd);
+        linger_free(self);
+        return;
+    }
+    if (!drain_to_socket(fd, self->m_pending))
+    {
+        int err = errno;
+        LOGD("error %d(%s) on fd %d", err, g_strerror(err), fd);
+        linger_free(self);
+        return;
+    }
+    if (evbuffer_get_length(self->m_pending) == 0)
+    {
+        NOISY_MSG_("drained fd %d", fd);
+        if (self->m_shutdown)
+        {
+            shutdown(fd, self->m_shutdown - 1);
+        }
+        linger_free(self);
+    }
+}
+
+// Hands the descriptor and whatever output it still owes over to a free
+// standing event, so that the handle can go away without truncating it.
+static void
+linger(RpIoSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+
+    RpLinger* linger_ = g_new0(RpLinger, 1);
+    linger_->m_fd = self->m_fd;
+    linger_->m_pending = g_steal_pointer(&self->m_pending);
+    linger_->m_shutdown = self->m_pending_shutdown;
+    linger_->m_event = event_new(rp_dispatcher_base(self->m_dispatcher),
+                                    linger_->m_fd,
+                                    EV_WRITE|EV_PERSIST,
+                                    linger_cb,
+                                    linger_);
+    struct timeval tv = { .tv_sec = LINGER_TIMEOUT_S, .tv_usec = 0 };
+    event_add(linger_->m_event, &tv);
+    self->m_pending = evbuffer_new();
+}
+
+static bool
+flush_pending(RpIoSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+
+    if (!drain_to_socket(self->m_fd, self->m_pending))
+    {
+        return false;
+    }
+    if (evbuffer_get_length(self->m_pending) > 0)
+    {
+        NOISY_MSG_("%zu bytes pending on fd %d", evbuffer_get_length(self->m_pending), self->m_fd);
+        if (self->m_write_event)
+        {
+            event_add(self->m_write_event, NULL);
+        }
+    }
+    else if (self->m_pending_shutdown)
+    {
+        NOISY_MSG_("deferred shutdown on fd %d", self->m_fd);
+        shutdown(self->m_fd, self->m_pending_shutdown - 1);
+        self->m_pending_shutdown = 0;
+    }
+    return true;
+}
+
+static void
+read_event_cb(evutil_socket_t fd G_GNUC_UNUSED, short what, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpIoSocketHandleImpl* self = RP_IO_SOCKET_HANDLE_IMPL(arg);
+    guint32 events = 0;
+    if (what & EV_READ)
+    {
+        events |= RpFileReadyType_Read;
+    }
+    else if (what & EV_CLOSED)
+    {
+        NOISY_MSG_("EOF on fd %d", fd);
+        events |= RpFileReadyType_Closed;
+    }
+    file_event_merge_injected_events_and_run_cb(self, events);
+}
+
+// Reads are level-triggered. With reading disabled, only the peer's close is
+// watched for, if asked for.
+static void
+update_read_event(RpIoSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+
+    short what = 0;
+    if (!self->m_suspended && (self->m_enabled_events & RpFileReadyType_Read))
+    {
+        what = EV_READ;
+    }
+    else if (self->m_enabled_events & RpFileReadyType_Closed)
+    {
+        what = EV_CLOSED;
+    }
+
+    g_clear_pointer(&self->m_read_event, event_free);
+    if (what && self->m_initialized && self->m_fd >= 0 && !self->m_connecting)
+    {
+        NOISY_MSG_("watching %x on fd %d", what, self->m_fd);
+        self->m_read_event = event_new(rp_dispatcher_base(self->m_dispatcher),
+                                        self->m_fd,
+                                        what|EV_PERSIST,
+                                        read_event_cb,
+                                        self);
+        event_add(self->m_read_event, NULL);
+    }
+}
+
+static void
+write_event_cb(evutil_socket_t fd, short what G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpIoSocketHandleImpl* self = RP_IO_SOCKET_HANDLE_IMPL(arg);
+    if (self->m_connecting)
+    {
+        self->m_connecting = false;
+
+        int so_error = 0;
+        socklen_t len = sizeof(so_error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0)
+        {
+            so_error = errno;
+        }
+        if (so_error != 0)
+        {
+            if (so_error == ECONNREFUSED)
+            {
+                LOGE("Connection refused by %s", rp_network_address_instance_as_string(self->m_remote_address));
+            }
+            else
+            {
+                LOGE("Socket error %d(%s)", so_error, evutil_socket_error_to_string(so_error));
+            }
+            file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Closed);
+            return;
+        }
+
+        LOGD("connected on fd %d", fd);
+        self->m_was_connected = true;
+        update_read_event(self);
+        if (!flush_pending(self))
+        {
+            int err = errno;
+            LOGE("Socket error %d(%s)", err, evutil_socket_error_to_string(err));
+            file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Closed);
+            return;
+        }
+        if (self->m_enabled_events & RpFileReadyType_Write)
+        {
+            file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Write);
+        }
+        return;
+    }
+
+    if (!flush_pending(self))
+    {
+        int err = errno;
+        if (err == ECONNRESET || err == EPIPE)
+        {
+            LOGD("error %d(%s)", err, evutil_socket_error_to_string(err));
+        }
+        else
+        {
+            LOGE("Socket error %d(%s)", err, evutil_socket_error_to_string(err));
+        }
+        file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Closed);
+    }
+}
+
+static inline void
+file_event_activate(RpIoSocketHandleImpl* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+
+    if (self->m_injected_activation_events == 0)
+    {
+        g_assert(!rp_schedulable_callback_enabled(self->m_activation_cb));
+        rp_schedulable_callback_schedule_callback_next_iteration(self->m_activation_cb);
+    }
+    g_assert(rp_schedulable_callback_enabled(self->m_activation_cb));
+
+    self->m_injected_activation_events |= events;
+}
+
+static inline void
+file_event_set_enabled(RpIoSocketHandleImpl* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    if (self->m_injected_activation_events != 0)
+    {
+        self->m_injected_activation_events = 0;
+        rp_schedulable_callback_cancel(self->m_activation_cb);
+    }
+    if (events == self->m_enabled_events)
+    {
+        NOISY_MSG_("nothing to do");
+        return;
+    }
+    self->m_enabled_events = events;
+    update_read_event(self);
+}
+
+static void
+file_event_merge_injected_events_and_run_cb(RpIoSocketHandleImpl* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    if (self->m_injected_activation_events != 0)
+    {
+        events |= self->m_injected_activation_events;
+        self->m_injected_activation_events = 0;
+        rp_schedulable_callback_cancel(self->m_activation_cb);
+    }
+
+    self->m_cb(self->m_arg, events);
+}
+
+static void
+activate_file_events_i(RpIoHandle* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    if (me->m_initialized)
+    {
+        file_event_activate(me, events);
+    }
+    else
+    {
+        LOGI("null file_event_");
+    }
+}
+
+static void
+clear_events(RpIoSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+    g_clear_pointer(&self->m_read_event, event_free);
+    g_clear_pointer(&self->m_write_event, event_free);
+    if (self->m_activation_cb)
+    {
+        self->m_injected_activation_events = 0;
+        rp_schedulable_callback_cancel(self->m_activation_cb);
+    }
+}
+
+static void
+close_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    if (me->m_fd < 0)
+    {
+        NOISY_MSG_("already closed");
+        return;
+    }
+
+    clear_events(me);
+    if (!me->m_connecting && me->m_dispatcher && evbuffer_get_length(me->m_pending) > 0)
+    {
+        NOISY_MSG_("still writing %zu bytes to fd %d", evbuffer_get_length(me->m_pending), me->m_fd);
+        linger(me);
+    }
+    else
+    {
+        evbuffer_drain(me->m_pending, evbuffer_get_length(me->m_pending));
+        evutil_closesocket(me->m_fd);
+    }
+    me->m_fd = EVUTIL_INVALID_SOCKET;
+    me->m_pending_shutdown = 0;
+}
+
+static void
+wait_for_connect(RpIoSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+    // Completion, immediate or not, is picked up by the write event so that
+    // it is always reported from the event loop.
+    self->m_connecting = true;
+    g_clear_pointer(&self->m_read_event, event_free);
+    if (self->m_initialized)
+    {
+        g_clear_pointer(&self->m_write_event, event_free);
+        self->m_write_event = event_new(rp_dispatcher_base(self->m_dispatcher), self->m_fd, EV_WRITE, write_event_cb, self);
+        event_add(self->m_write_event, NULL);
+    }
+}
+
+static RpSysCallIntResult
+connect_i(RpIoHandle* self, RpNetworkAddressInstanceConstSharedPtr address)
+{
+    NOISY_MSG_("(%p(fd %d), %p)", self, SOCKFD(self), address);
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    me->m_type = RpHandleType_Connecting;
+    rp_network_address_instance_impl_set_object(&me->m_remote_address, address);
+
+    if (me->m_fd == EVUTIL_INVALID_SOCKET)
+    {
+        RpNetworkAddressIp* ip = rp_network_address_instance_ip(address);
+        RpIpVersion_e version = rp_network_address_ip_version(ip);
+        int domain = version == RpIpVersion_v6 ? AF_INET6 : AF_INET;
+        me->m_fd = socket(domain, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
+        if (me->m_fd < 0)
+        {
+            int err = errno;
+            LOGE("socket() failed %d(%s)", err, g_strerror(err));
+            return rp_sys_call_int_ctor(-1, err);
+        }
+        NOISY_MSG_("created sockfd %d", me->m_fd);
+    }
+
+    int rc = connect(me->m_fd,
+                        rp_network_address_instance_sock_addr(address),
+                        rp_network_address_instance_sock_addr_len(address));
+    if (rc != 0 && errno != EINPROGRESS)
+    {
+        int err = errno;
+        LOGD("connect() failed %d(%s) on fd %d", err, g_strerror(err), me->m_fd);
+        return rp_sys_call_int_ctor(-1, err);
+    }
+
+    wait_for_connect(me);
+    return rp_sys_call_int_ctor(0, 0);
+}
+
+static RpSysCallIntResult
+connect_socket_i(RpIoHandle* self, evutil_socket_t fd, RpNetworkAddressInstanceConstSharedPtr address)
+{
+    NOISY_MSG_("(%p(fd %d), %d, %p)", self, SOCKFD(self), fd, address);
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    if (me->m_fd != EVUTIL_INVALID_SOCKET)
+    {
+        LOGE("fd %d already open", me->m_fd);
+        return rp_sys_call_int_ctor(-1, EISCONN);
+    }
+    me->m_type = RpHandleType_Connecting;
+    rp_network_address_instance_impl_set_object(&me->m_remote_address, address);
+    me->m_fd = fd;
+    wait_for_connect(me);
+    return rp_sys_call_int_ctor(0, 0);
+}
+
+static void
+enable_file_events_i(RpIoHandle* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    if (me->m_initialized)
+    {
+        file_event_set_enabled(me, events);
+    }
+    else
+    {
+        LOGI("null file_event_");
+    }
+}
+
+static void
+activation_cb(RpSchedulableCallback* self G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p(fd %d))", self, arg, SOCKFD(arg));
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(arg);
+g_assert(me->m_injected_activation_events != 0);
+    file_event_merge_injected_events_and_run_cb(me, 0);
+}
+
+static void
+initialize_file_event_i(RpIoHandle* self, RpDispatcher* dispatcher, RpFileReadyCb cb, gpointer arg, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %p, %p, %p, %u)", self, SOCKFD(self), dispatcher, cb, arg, events);
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    me->m_enabled_events = events;
+    me->m_dispatcher = dispatcher;
+    me->m_cb = cb;
+    me->m_arg = arg;
+
+    g_clear_object(&me->m_activation_cb);
+    me->m_activation_cb = rp_dispatcher_create_schedulable_callback(dispatcher, activation_cb, me);
+    me->m_initialized = true;
+
+    if (me->m_fd >= 0)
+    {
+        g_clear_pointer(&me->m_write_event, event_free);
+        me->m_write_event = event_new(rp_dispatcher_base(dispatcher), me->m_fd, EV_WRITE, write_event_cb, me);
+        if (me->m_connecting || evbuffer_get_length(me->m_pending) > 0)
+        {
+            event_add(me->m_write_event, NULL);
+        }
+    }
+    update_read_event(me);
+}
+
+static const char*
+interface_name_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+//TODO...
+    return "";
+}
+
+static bool
+is_open_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    return SOCKFD(self) != EVUTIL_INVALID_SOCKET;
+}
+
+static RpNetworkAddressInstanceConstSharedPtr
+local_address_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    struct sockaddr_storage ss;
+    socklen_t ss_len = sizeof(ss);
+    memset(&ss, 0, ss_len);
+    if (me->m_fd == EVUTIL_INVALID_SOCKET)
+    {
+        LOGE("socket is closed");
+    }
+    else if (getsockname(me->m_fd, (struct sockaddr*)&ss, &ss_len) != 0)
+    {
+        int err = errno;
+        LOGE("getsockname() failed %d(%s) on fd %d", err, g_strerror(err), me->m_fd);
+    }
+    g_clear_object(&me->m_local_address);
+    me->m_local_address = rp_network_address_address_from_sock_addr(&ss, ss_len, true);
+    return me->m_local_address;
+}
+
+static RpNetworkAddressInstanceConstSharedPtr
+peer_address_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    struct sockaddr_storage ss;
+    socklen_t ss_len = sizeof(ss);
+    memset(&ss, 0, ss_len);
+    if (me->m_fd == EVUTIL_INVALID_SOCKET)
+    {
+        LOGE("socket is closed");
+    }
+    else if (getpeername(me->m_fd, (struct sockaddr*)&ss, &ss_len) != 0)
+    {
+        int err = errno;
+        LOGE("getpeername() failed %d(%s) on fd %d", err, g_strerror(err), me->m_fd);
+    }
+    return rp_network_address_address_from_sock_addr(&ss, ss_len, true);
+}
+
+static void
+reset_file_events_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    me->m_initialized = false;
+    g_clear_pointer(&me->m_read_event, event_free);
+}
+
+static void
+shutdown_i(RpIoHandle* self, int how)
+{
+    NOISY_MSG_("(%p(fd %d), %d)", self, SOCKFD(self), how);
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    if (me->m_fd < 0)
+    {
+        NOISY_MSG_("closed");
+        return;
+    }
+    // Shutting down the write side has to wait for the pending output, or the
+    // tail of the response would be cut off.
+    if (how != SHUT_RD && evbuffer_get_length(me->m_pending) > 0)
+    {
+        NOISY_MSG_("deferring shutdown of fd %d", me->m_fd);
+        me->m_pending_shutdown = how + 1;
+        if (how == SHUT_RDWR)
+        {
+            shutdown(me->m_fd, SHUT_RD);
+        }
+        return;
+    }
+    shutdown(me->m_fd, how);
+}
+
+static bool
+was_connected_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    return RP_IO_SOCKET_HANDLE_IMPL(self)->m_was_connected;
+}
+
+static RpSysCallIntResult
+write_i(RpIoHandle* self, evbuf_t* buffer)
+{
+    NOISY_MSG_("(%p(fd %d), %p(%zu))", self, SOCKFD(self), buffer, evbuf_length(buffer));
+    if (!buffer)
+    {
+        LOGI("buffer is null on fd %d", SOCKFD(self));
+        return rp_sys_call_int_ctor(0, 0);
+    }
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    if (me->m_fd < 0)
+    {
+        LOGD("socket is closed");
+        return rp_sys_call_int_ctor(-1, EBADF);
+    }
+
+    // Straight from the caller's buffer while nothing is queued ahead of it;
+    // whatever the socket does not take moves (not copies) into the pending
+    // buffer, so that the caller sees everything written as with a
+    // bufferevent.
+    if (!me->m_connecting && evbuffer_get_length(me->m_pending) == 0 &&
+        !drain_to_socket(me->m_fd, buffer))
+    {
+        int err = errno;
+        NOISY_MSG_("write error %d(%s) on fd %d", err, g_strerror(err), me->m_fd);
+        return rp_sys_call_int_ctor(-1, err);
+    }
+    if (evbuffer_get_length(buffer) > 0)
+    {
+        evbuffer_add_buffer(me->m_pending, buffer);
+        if (!me->m_connecting && me->m_write_event)
+        {
+            event_add(me->m_write_event, NULL);
+        }
+    }
+    return rp_sys_call_int_ctor(0, 0);
+}
+
+static RpSysCallIntResult
+read_i(RpIoHandle* self, evbuf_t* buffer)
+{
+    NOISY_MSG_("(%p(fd %d), %p)", self, SOCKFD(self), buffer);
+    if (!buffer)
+    {
+        LOGI("buffer is null on fd %d", SOCKFD(self));
+        return rp_sys_call_int_ctor(-1, EINVAL);
+    }
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    if (me->m_read_ahead && evbuffer_get_length(me->m_read_ahead) > 0)
+    {
+        int n = (int)evbuffer_get_length(me->m_read_ahead);
+        NOISY_MSG_("%d read ahead bytes for fd %d", n, me->m_fd);
+        evbuffer_add_buffer(buffer, me->m_read_ahead);
+        return rp_sys_call_int_ctor(n, 0);
+    }
+    if (me->m_fd < 0)
+    {
+        LOGD("socket is closed");
+        return rp_sys_call_int_ctor(-1, EBADF);
+    }
+
+    struct evbuffer_iovec vec[READ_IOVECS];
+    int n_vec = evbuffer_reserve_space(buffer, READ_SIZE, vec, READ_IOVECS);
+    if (n_vec <= 0)
+    {
+        LOGE("reserve space failed on fd %d", me->m_fd);
+        return rp_sys_call_int_ctor(-1, ENOMEM);
+    }
+
+    struct iovec iov[READ_IOVECS];
+    for (int i = 0; i < n_vec; ++i)
+    {
+        iov[i].iov_base = vec[i].iov_base;
+        iov[i].iov_len = vec[i].iov_len;
+    }
+
+    ssize_t rc = readv(me->m_fd, iov, n_vec);
+    if (rc <= 0)
+    {
+        int err = rc < 0 ? errno : 0;
+        evbuffer_commit_space(buffer, vec, 0);
+        NOISY_MSG_("readv() returned %zd, errno %d on fd %d", rc, err, me->m_fd);
+        return rp_sys_call_int_ctor(rc < 0 ? -1 : 0, err);
+    }
+
+    size_t remaining = rc;
+    int n_used = 0;
+    for (; n_used < n_vec && remaining > 0; ++n_used)
+    {
+        vec[n_used].iov_len = MIN(vec[n_used].iov_len, remaining);
+        remaining -= vec[n_used].iov_len;
+    }
+    evbuffer_commit_space(buffer, vec, n_used);
+    NOISY_MSG_("%zd bytes read from fd %d", rc, me->m_fd);
+    return rp_sys_call_int_ctor((int)rc, 0);
+}
+
+static int
+sockfd_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return SOCKFD(self);
+}
+
+static gsize
+buffered_bytes_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    return (me->m_read_ahead ? evbuffer_get_length(me->m_read_ahead) : 0) +
+            evbuffer_get_length(me->m_pending);
+}
+
+static void
+suspend_i(RpIoHandle* self, bool suspend)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), suspend);
+    RpIoSocketHandleImpl* me = RP_IO_SOCKET_HANDLE_IMPL(self);
+    me->m_suspended = suspend;
+    update_read_event(me);
+}
+
+static void
+io_handle_iface_init(RpIoHandleInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->activate_file_events = activate_file_events_i;
+    iface->close = close_i;
+    iface->connect = connect_i;
+    iface->connect_socket = connect_socket_i;
+    iface->enable_file_events = enable_file_events_i;
+    iface->initialize_file_event = initialize_file_event_i;
+    iface->interface_name = interface_name_i;
+    iface->is_open = is_open_i;
+    iface->local_address = local_address_i;
+    iface->peer_address = peer_address_i;
+    iface->reset_file_events = reset_file_events_i;
+    iface->shutdown = shutdown_i;
+    iface->was_connected = was_connected_i;
+    iface->read = read_i;
+    iface->write = write_i;
+    iface->sockfd = sockfd_i;
+    iface->buffered_bytes = buffered_bytes_i;
+    iface->suspend = suspend_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpIoSocketHandleImpl* self = RP_IO_SOCKET_HANDLE_IMPL(obj);
+    close_i(RP_IO_HANDLE(self));
+
+    g_clear_pointer(&self->m_read_ahead, evbuffer_free);
+    g_clear_pointer(&self->m_pending, evbuffer_free);
+    g_clear_object(&self->m_activation_cb);
+    g_clear_object(&self->m_local_address);
+    g_clear_object(&self->m_remote_address);
+
+    G_OBJECT_CLASS(rp_io_socket_handle_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_io_socket_handle_impl_class_init(RpIoSocketHandleImplClass* klass)
+{
+    NOISY_MSG_("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_io_socket_handle_impl_init(RpIoSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_fd = EVUTIL_INVALID_SOCKET;
+    self->m_pending = evbuffer_new();
+    self->m_was_connected = false;
+    self->m_initialized = false;
+}
+
+RpIoSocketHandleImpl*
+rp_io_socket_handle_impl_new(RpHandleType_e type, evutil_socket_t fd, evbuf_t* read_ahead)
+{
+    LOGD("(%d, %d, %p)", type, fd, read_ahead);
+    RpIoSocketHandleImpl* self = g_object_new(RP_TYPE_IO_SOCKET_HANDLE_IMPL, NULL);
+    self->m_fd = fd;
+    self->m_read_ahead = read_ahead;
+    self->m_type = type;
+    return self;
+}
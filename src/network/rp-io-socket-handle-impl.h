@@ -0,0 +1,37 @@
+/*
+ * rp-io-socket-handle-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rproxy.h"
+#include "rp-io-handle.h"
+#include "network/rp-io-bev-socket-handle-impl.h"
+
+G_BEGIN_DECLS
+
+/**
+ * IoHandle derivative for plain sockets. Reads are a readv() straight into the
+ * caller's evbuffer and writes a writev() straight out of it, driven by plain
+ * events on the descriptor rather than a bufferevent. Whatever the socket does
+ * not take is kept by the handle and flushed as the socket drains, including
+ * after close().
+ */
+#define RP_TYPE_IO_SOCKET_HANDLE_IMPL rp_io_socket_handle_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpIoSocketHandleImpl, rp_io_socket_handle_impl, RP, IO_SOCKET_HANDLE_IMPL, GObject)
+
+/**
+ * @param fd the socket, or -1 for a handle that creates its own on connect().
+ * @param read_ahead bytes already read off |fd|, handed out by the first
+ *        read(); owned by the handle, may be NULL.
+ */
+RpIoSocketHandleImpl* rp_io_socket_handle_impl_new(RpHandleType_e type,
+                                                    evutil_socket_t fd,
+                                                    evbuf_t* read_ahead);
+
+G_END_DECLS
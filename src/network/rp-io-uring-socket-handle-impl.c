@@ -0,0 +1,951 @@
+/*
+ * rp-io-uring-socket-handle-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_io_uring_socket_handle_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_io_uring_socket_handle_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "network/rp-io-uring-socket-handle-impl.h"
+
+#ifdef HAVE_LIBURING
+
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include "rp-dispatcher.h"
+#include "rp-timer.h"
+#include "event/rp-schedulable-cb-impl.h"
+#include "network/rp-address-impl.h"
+
+#define SOCKFD(s) (RP_IO_URING_SOCKET_HANDLE_IMPL(s)->m_open ? RP_IO_URING_SOCKET_HANDLE_IMPL(s)->m_fd : -1)
+
+#define SEND_IOVECS 16
+
+// How long output left behind by close() may take to drain.
+#define LINGER_TIMEOUT_MS (30 * 1000)
+
+struct _RpIoUringSocketHandleImpl {
+    GObject parent_instance;
+
+    RpIoUring* m_ring;      /* owned */
+    evutil_socket_t m_fd;
+    evbuf_t* m_read_ahead;  /* owned, may be NULL */
+    evbuf_t* m_received;    /* owned */
+    evbuf_t* m_pending;     /* owned */
+
+    RpIoUringOp m_recv_op;
+    RpIoUringOp m_poll_op;
+    RpIoUringOp m_send_op;
+    RpIoUringOp m_connect_op;
+    struct iovec m_send_iov[SEND_IOVECS];
+    struct msghdr m_send_msg;
+    struct sockaddr_storage m_connect_addr;
+
+    RpDispatcher* m_dispatcher;
+    RpSchedulableCallback* m_activation_cb;
+    RpTimer* m_linger_timer;
+    RpNetworkAddressInstance* m_local_address;  /* owned */
+    RpNetworkAddressInstance* m_remote_address; /* owned */
+
+    RpFileReadyCb m_cb;
+    gpointer m_arg;
+
+    guint32 m_injected_activation_events;
+    guint32 m_enabled_events;
+
+    RpHandleType_e m_type;
+    int m_read_error;
+    int m_write_error;
+    int m_pending_shutdown;
+
+    bool m_open : 1;
+    bool m_connecting : 1;
+    bool m_was_connected : 1;
+    bool m_initialized : 1;
+    bool m_suspended : 1;
+    bool m_eof : 1;
+    bool m_recv_armed : 1;
+    bool m_recv_cancelling : 1;
+    bool m_poll_armed : 1;
+    bool m_poll_cancelling : 1;
+    bool m_send_in_flight : 1;
+    bool m_lingering : 1;
+};
+
+static void file_event_merge_injected_events_and_run_cb(RpIoUringSocketHandleImpl* self, guint32 events);
+static void io_handle_iface_init(RpIoHandleInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpIoUringSocketHandleImpl, rp_io_uring_socket_handle_impl, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_IO_HANDLE, io_handle_iface_init)
+)
+
+static inline bool
+has_read_result(RpIoUringSocketHandleImpl* self)
+{
+    return evbuffer_get_length(self->m_received) > 0 || self->m_eof || self->m_read_error;
+}
+
+static inline bool
+reading_wanted(RpIoUringSocketHandleImpl* self)
+{
+    return self->m_open && !self->m_connecting && !self->m_suspended &&
+            !self->m_eof && !self->m_read_error &&
+            (self->m_enabled_events & RpFileReadyType_Read);
+}
+
+// With reading off, only the peer's close is watched for, if asked for.
+static inline bool
+close_watch_wanted(RpIoUringSocketHandleImpl* self)
+{
+    return self->m_open && !self->m_connecting && !reading_wanted(self) &&
+            !self->m_eof && !self->m_read_error &&
+            (self->m_enabled_events & RpFileReadyType_Closed);
+}
+
+static void
+cancel_op(RpIoUringSocketHandleImpl* self, RpIoUringOp* op)
+{
+    NOISY_MSG_("(%p(fd %d), %p)", self, self->m_fd, op);
+    struct io_uring_sqe* sqe = rp_io_uring_get_sqe(self->m_ring, NULL);
+    io_uring_prep_cancel64(sqe, (guint64)(uintptr_t)op, 0);
+}
+
+static void
+update_ops(RpIoUringSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+
+    if (reading_wanted(self))
+    {
+        if (!self->m_recv_armed)
+        {
+            NOISY_MSG_("arming receive on fd %d", self->m_fd);
+            struct io_uring_sqe* sqe = rp_io_uring_get_sqe(self->m_ring, &self->m_recv_op);
+            io_uring_prep_recv_multishot(sqe, self->m_fd, NULL, 0, 0);
+            sqe->flags |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group = rp_io_uring_buffer_group(self->m_ring);
+            self->m_recv_armed = true;
+            g_object_ref(self);
+        }
+    }
+    else if (self->m_recv_armed && !self->m_recv_cancelling)
+    {
+        NOISY_MSG_("cancelling receive on fd %d", self->m_fd);
+        cancel_op(self, &self->m_recv_op);
+        self->m_recv_cancelling = true;
+    }
+
+    if (close_watch_wanted(self))
+    {
+        if (!self->m_poll_armed)
+        {
+            NOISY_MSG_("watching for close on fd %d", self->m_fd);
+            struct io_uring_sqe* sqe = rp_io_uring_get_sqe(self->m_ring, &self->m_poll_op);
+            io_uring_prep_poll_add(sqe, self->m_fd, POLLRDHUP);
+            self->m_poll_armed = true;
+            g_object_ref(self);
+        }
+    }
+    else if (self->m_poll_armed && !self->m_poll_cancelling)
+    {
+        NOISY_MSG_("cancelling close watch on fd %d", self->m_fd);
+        cancel_op(self, &self->m_poll_op);
+        self->m_poll_cancelling = true;
+    }
+}
+
+static void
+close_fd(RpIoUringSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+    if (self->m_fd >= 0)
+    {
+        // Submissions still in flight hold on to the file, not the number.
+        close(self->m_fd);
+        self->m_fd = EVUTIL_INVALID_SOCKET;
+    }
+}
+
+static void
+finish_linger(RpIoUringSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+    self->m_lingering = false;
+    // The timer may be the caller; it goes with the handle.
+    rp_timer_disable_timer(self->m_linger_timer);
+    evbuffer_drain(self->m_pending, evbuffer_get_length(self->m_pending));
+    close_fd(self);
+}
+
+static void
+start_send(RpIoUringSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+
+    if (self->m_send_in_flight || self->m_connecting || self->m_write_error ||
+        self->m_fd < 0 || evbuffer_get_length(self->m_pending) == 0)
+    {
+        NOISY_MSG_("nothing to do");
+        return;
+    }
+
+    // The iovecs point into |m_pending|, which only ever has chains appended
+    // to it while a send is in flight, so they stay put until it completes.
+    struct evbuffer_iovec vec[SEND_IOVECS];
+    int n_vec = evbuffer_peek(self->m_pending, -1, NULL, vec, SEND_IOVECS);
+    n_vec = MIN(n_vec, SEND_IOVECS);
+    for (int i = 0; i < n_vec; ++i)
+    {
+        self->m_send_iov[i].iov_base = vec[i].iov_base;
+        self->m_send_iov[i].iov_len = vec[i].iov_len;
+    }
+    memset(&self->m_send_msg, 0, sizeof(self->m_send_msg));
+    self->m_send_msg.msg_iov = self->m_send_iov;
+    self->m_send_msg.msg_iovlen = n_vec;
+
+    struct io_uring_sqe* sqe = rp_io_uring_get_sqe(self->m_ring, &self->m_send_op);
+    io_uring_prep_sendmsg(sqe, self->m_fd, &self->m_send_msg, MSG_NOSIGNAL);
+    self->m_send_in_flight = true;
+    g_object_ref(self);
+}
+
+static void
+deliver_read_result(RpIoUringSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, self->m_fd);
+
+    if (!self->m_initialized || !has_read_result(self))
+    {
+        NOISY_MSG_("nothing to deliver");
+        return;
+    }
+    if (!self->m_suspended && (self->m_enabled_events & RpFileReadyType_Read))
+    {
+        file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Read);
+    }
+    else if ((self->m_eof || self->m_read_error) && (self->m_enabled_events & RpFileReadyType_Closed))
+    {
+        file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Closed);
+    }
+}
+
+static void
+recv_cb(gpointer arg, int res, guint32 flags)
+{
+    NOISY_MSG_("(%p, %d, %x)", arg, res, flags);
+
+    RpIoUringSocketHandleImpl* self = arg;
+    bool final = !(flags & IORING_CQE_F_MORE);
+
+    if (flags & IORING_CQE_F_BUFFER)
+    {
+        if (res > 0)
+        {
+            NOISY_MSG_("%d bytes received on fd %d", res, self->m_fd);
+            evbuffer_add(self->m_received, rp_io_uring_buffer(self->m_ring, flags), res);
+        }
+        rp_io_uring_recycle_buffer(self->m_ring, flags);
+    }
+    else if (res == 0)
+    {
+        NOISY_MSG_("EOF on fd %d", self->m_fd);
+        self->m_eof = true;
+    }
+    else if (res == -ENOBUFS)
+    {
+        // Out of provided buffers; they come back as soon as the receives
+        // holding them are copied out, so just re-arm.
+        NOISY_MSG_("no buffers for fd %d", self->m_fd);
+    }
+    else if (res < 0 && res != -ECANCELED)
+    {
+        LOGD("error %d(%s) on fd %d", -res, g_strerror(-res), self->m_fd);
+        self->m_read_error = -res;
+    }
+
+    if (final)
+    {
+        self->m_recv_armed = false;
+        self->m_recv_cancelling = false;
+    }
+
+    if (self->m_open)
+    {
+        deliver_read_result(self);
+    }
+
+    if (final)
+    {
+        update_ops(self);
+        g_object_unref(self);
+    }
+}
+
+static void
+poll_cb(gpointer arg, int res, guint32 flags G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %d, %x)", arg, res, flags);
+
+    RpIoUringSocketHandleImpl* self = arg;
+    self->m_poll_armed = false;
+    self->m_poll_cancelling = false;
+
+    if (res > 0 && (res & (POLLRDHUP|POLLHUP|POLLERR)) &&
+        self->m_initialized && close_watch_wanted(self))
+    {
+        NOISY_MSG_("peer closed fd %d", self->m_fd);
+        self->m_eof = true;
+        file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Closed);
+    }
+
+    update_ops(self);
+    g_object_unref(self);
+}
+
+static void
+send_cb(gpointer arg, int res, guint32 flags G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %d, %x)", arg, res, flags);
+
+    RpIoUringSocketHandleImpl* self = arg;
+    self->m_send_in_flight = false;
+
+    if (res > 0)
+    {
+        NOISY_MSG_("%d bytes sent on fd %d", res, self->m_fd);
+        evbuffer_drain(self->m_pending, res);
+    }
+    else if (res < 0 && res != -EAGAIN && res != -EINTR)
+    {
+        self->m_write_error = -res;
+    }
+
+    if (!self->m_write_error)
+    {
+        if (evbuffer_get_length(self->m_pending) > 0)
+        {
+            start_send(self);
+        }
+        else if (self->m_pending_shutdown && self->m_fd >= 0)
+        {
+            NOISY_MSG_("deferred shutdown on fd %d", self->m_fd);
+            shutdown(self->m_fd, self->m_pending_shutdown - 1);
+            self->m_pending_shutdown = 0;
+        }
+    }
+
+    if (self->m_lingering)
+    {
+        if (!self->m_send_in_flight)
+        {
+            NOISY_MSG_("done lingering on fd %d", self->m_fd);
+            finish_linger(self);
+        }
+    }
+    else if (self->m_write_error && self->m_open && self->m_initialized)
+    {
+        int err = self->m_write_error;
+        if (err == ECONNRESET || err == EPIPE)
+        {
+            LOGD("error %d(%s)", err, evutil_socket_error_to_string(err));
+        }
+        else
+        {
+            LOGE("Socket error %d(%s)", err, evutil_socket_error_to_string(err));
+        }
+        file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Closed);
+    }
+
+    g_object_unref(self);
+}
+
+static void
+connect_cb(gpointer arg, int res, guint32 flags G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %d, %x)", arg, res, flags);
+
+    RpIoUringSocketHandleImpl* self = arg;
+    self->m_connecting = false;
+
+    if (!self->m_open)
+    {
+        NOISY_MSG_("closed while connecting");
+    }
+    else if (res < 0)
+    {
+        if (res == -ECONNREFUSED)
+        {
+            LOGE("Connection refused by %s", rp_network_address_instance_as_string(self->m_remote_address));
+        }
+        else
+        {
+            LOGE("Socket error %d(%s)", -res, evutil_socket_error_to_string(-res));
+        }
+        if (self->m_initialized)
+        {
+            file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Closed);
+        }
+    }
+    else
+    {
+        LOGD("connected on fd %d", self->m_fd);
+        self->m_was_connected = true;
+        update_ops(self);
+        start_send(self);
+        if (self->m_initialized && (self->m_enabled_events & RpFileReadyType_Write))
+        {
+            file_event_merge_injected_events_and_run_cb(self, RpFileReadyType_Write);
+        }
+    }
+
+    g_object_unref(self);
+}
+
+static void
+connect_poll_cb(gpointer arg, int res, guint32 flags)
+{
+    NOISY_MSG_("(%p, %d, %x)", arg, res, flags);
+
+    // An adopted socket is already connected; the poll only confirms it and
+    // hands the result back through the ring like a connect would.
+    RpIoUringSocketHandleImpl* self = arg;
+    if (res > 0 && (res & (POLLERR|POLLHUP)))
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(self->m_fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        res = -(err ? err : ECONNRESET);
+    }
+    connect_cb(arg, res < 0 ? res : 0, flags);
+}
+
+static inline void
+file_event_activate(RpIoUringSocketHandleImpl* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+
+    if (self->m_injected_activation_events == 0)
+    {
+        g_assert(!rp_schedulable_callback_enabled(self->m_activation_cb));
+        rp_schedulable_callback_schedule_callback_next_iteration(self->m_activation_cb);
+    }
+    g_assert(rp_schedulable_callback_enabled(self->m_activation_cb));
+
+    self->m_injected_activation_events |= events;
+}
+
+static inline void
+file_event_set_enabled(RpIoUringSocketHandleImpl* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    if (self->m_injected_activation_events != 0)
+    {
+        self->m_injected_activation_events = 0;
+        rp_schedulable_callback_cancel(self->m_activation_cb);
+    }
+    if (events == self->m_enabled_events)
+    {
+        NOISY_MSG_("nothing to do");
+        return;
+    }
+    self->m_enabled_events = events;
+    update_ops(self);
+
+    // Completions are edges; whatever arrived while reading was off has to be
+    // handed out once it is back on.
+    if (!self->m_suspended && (events & RpFileReadyType_Read) && has_read_result(self))
+    {
+        NOISY_MSG_("activating read on fd %d", self->m_fd);
+        file_event_activate(self, RpFileReadyType_Read);
+    }
+}
+
+static void
+file_event_merge_injected_events_and_run_cb(RpIoUringSocketHandleImpl* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    if (self->m_injected_activation_events != 0)
+    {
+        events |= self->m_injected_activation_events;
+        self->m_injected_activation_events = 0;
+        rp_schedulable_callback_cancel(self->m_activation_cb);
+    }
+
+    self->m_cb(self->m_arg, events);
+}
+
+static void
+activate_file_events_i(RpIoHandle* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    if (me->m_initialized)
+    {
+        file_event_activate(me, events);
+    }
+    else
+    {
+        LOGI("null file_event_");
+    }
+}
+
+static void
+linger_timeout_cb(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+
+    RpIoUringSocketHandleImpl* self = arg;
+    LOGD("gave up on %zu bytes for fd %d", evbuffer_get_length(self->m_pending), self->m_fd);
+    if (self->m_send_in_flight)
+    {
+        cancel_op(self, &self->m_send_op);
+    }
+    finish_linger(self);
+}
+
+static void
+close_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    if (!me->m_open)
+    {
+        NOISY_MSG_("already closed");
+        return;
+    }
+
+    me->m_open = false;
+    if (me->m_activation_cb)
+    {
+        me->m_injected_activation_events = 0;
+        rp_schedulable_callback_cancel(me->m_activation_cb);
+    }
+    update_ops(me);
+    if (me->m_connecting)
+    {
+        cancel_op(me, &me->m_connect_op);
+    }
+
+    if (me->m_send_in_flight && !me->m_connecting && !me->m_write_error && me->m_dispatcher)
+    {
+        NOISY_MSG_("still writing %zu bytes to fd %d", evbuffer_get_length(me->m_pending), me->m_fd);
+        me->m_lingering = true;
+        me->m_linger_timer = rp_dispatcher_create_timer(me->m_dispatcher, linger_timeout_cb, me);
+        rp_timer_enable_timer(me->m_linger_timer, LINGER_TIMEOUT_MS);
+    }
+    else
+    {
+        evbuffer_drain(me->m_pending, evbuffer_get_length(me->m_pending));
+        me->m_pending_shutdown = 0;
+        close_fd(me);
+    }
+}
+
+static RpSysCallIntResult
+connect_i(RpIoHandle* self, RpNetworkAddressInstanceConstSharedPtr address)
+{
+    NOISY_MSG_("(%p(fd %d), %p)", self, SOCKFD(self), address);
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    me->m_type = RpHandleType_Connecting;
+    rp_network_address_instance_impl_set_object(&me->m_remote_address, address);
+
+    if (me->m_fd == EVUTIL_INVALID_SOCKET)
+    {
+        RpNetworkAddressIp* ip = rp_network_address_instance_ip(address);
+        RpIpVersion_e version = rp_network_address_ip_version(ip);
+        int domain = version == RpIpVersion_v6 ? AF_INET6 : AF_INET;
+        // Blocking, so that the ring waits for the socket rather than handing
+        // back EAGAIN.
+        me->m_fd = socket(domain, SOCK_STREAM|SOCK_CLOEXEC, 0);
+        if (me->m_fd < 0)
+        {
+            int err = errno;
+            LOGE("socket() failed %d(%s)", err, g_strerror(err));
+            return rp_sys_call_int_ctor(-1, err);
+        }
+        NOISY_MSG_("created sockfd %d", me->m_fd);
+        me->m_open = true;
+    }
+
+    socklen_t len = rp_network_address_instance_sock_addr_len(address);
+    memcpy(&me->m_connect_addr, rp_network_address_instance_sock_addr(address), len);
+    struct io_uring_sqe* sqe = rp_io_uring_get_sqe(me->m_ring, &me->m_connect_op);
+    io_uring_prep_connect(sqe, me->m_fd, (struct sockaddr*)&me->m_connect_addr, len);
+    me->m_connecting = true;
+    g_object_ref(me);
+    update_ops(me);
+    return rp_sys_call_int_ctor(0, 0);
+}
+
+static RpSysCallIntResult
+connect_socket_i(RpIoHandle* self, evutil_socket_t fd, RpNetworkAddressInstanceConstSharedPtr address)
+{
+    NOISY_MSG_("(%p(fd %d), %d, %p)", self, SOCKFD(self), fd, address);
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    if (me->m_fd != EVUTIL_INVALID_SOCKET)
+    {
+        LOGE("fd %d already open", me->m_fd);
+        return rp_sys_call_int_ctor(-1, EISCONN);
+    }
+    me->m_type = RpHandleType_Connecting;
+    rp_network_address_instance_impl_set_object(&me->m_remote_address, address);
+
+    // Same treatment as an accepted fd; see rp_io_uring_socket_handle_impl_new().
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0)
+    {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    me->m_fd = fd;
+    me->m_open = true;
+
+    me->m_connect_op.m_cb = connect_poll_cb;
+    struct io_uring_sqe* sqe = rp_io_uring_get_sqe(me->m_ring, &me->m_connect_op);
+    io_uring_prep_poll_add(sqe, me->m_fd, POLLOUT);
+    me->m_connecting = true;
+    g_object_ref(me);
+    update_ops(me);
+    return rp_sys_call_int_ctor(0, 0);
+}
+
+static void
+enable_file_events_i(RpIoHandle* self, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), events);
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    if (me->m_initialized)
+    {
+        file_event_set_enabled(me, events);
+    }
+    else
+    {
+        LOGI("null file_event_");
+    }
+}
+
+static void
+activation_cb(RpSchedulableCallback* self G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p(fd %d))", self, arg, SOCKFD(arg));
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(arg);
+g_assert(me->m_injected_activation_events != 0);
+    file_event_merge_injected_events_and_run_cb(me, 0);
+}
+
+static void
+initialize_file_event_i(RpIoHandle* self, RpDispatcher* dispatcher, RpFileReadyCb cb, gpointer arg, guint32 events)
+{
+    NOISY_MSG_("(%p(fd %d), %p, %p, %p, %u)", self, SOCKFD(self), dispatcher, cb, arg, events);
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    me->m_enabled_events = events;
+    me->m_dispatcher = dispatcher;
+    me->m_cb = cb;
+    me->m_arg = arg;
+
+    g_clear_object(&me->m_activation_cb);
+    me->m_activation_cb = rp_dispatcher_create_schedulable_callback(dispatcher, activation_cb, me);
+    me->m_initialized = true;
+    update_ops(me);
+}
+
+static const char*
+interface_name_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+//TODO...
+    return "";
+}
+
+static bool
+is_open_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    return SOCKFD(self) != EVUTIL_INVALID_SOCKET;
+}
+
+static RpNetworkAddressInstanceConstSharedPtr
+local_address_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    struct sockaddr_storage ss;
+    socklen_t ss_len = sizeof(ss);
+    memset(&ss, 0, ss_len);
+    if (!me->m_open)
+    {
+        LOGE("socket is closed");
+    }
+    else if (getsockname(me->m_fd, (struct sockaddr*)&ss, &ss_len) != 0)
+    {
+        int err = errno;
+        LOGE("getsockname() failed %d(%s) on fd %d", err, g_strerror(err), me->m_fd);
+    }
+    g_clear_object(&me->m_local_address);
+    me->m_local_address = rp_network_address_address_from_sock_addr(&ss, ss_len, true);
+    return me->m_local_address;
+}
+
+static RpNetworkAddressInstanceConstSharedPtr
+peer_address_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    struct sockaddr_storage ss;
+    socklen_t ss_len = sizeof(ss);
+    memset(&ss, 0, ss_len);
+    if (!me->m_open)
+    {
+        LOGE("socket is closed");
+    }
+    else if (getpeername(me->m_fd, (struct sockaddr*)&ss, &ss_len) != 0)
+    {
+        int err = errno;
+        LOGE("getpeername() failed %d(%s) on fd %d", err, g_strerror(err), me->m_fd);
+    }
+    return rp_network_address_address_from_sock_addr(&ss, ss_len, true);
+}
+
+static void
+reset_file_events_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RP_IO_URING_SOCKET_HANDLE_IMPL(self)->m_initialized = false;
+}
+
+static void
+shutdown_i(RpIoHandle* self, int how)
+{
+    NOISY_MSG_("(%p(fd %d), %d)", self, SOCKFD(self), how);
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    if (!me->m_open)
+    {
+        NOISY_MSG_("closed");
+        return;
+    }
+    // Shutting down the write side has to wait for the pending output, or the
+    // tail of the response would be cut off.
+    if (how != SHUT_RD && evbuffer_get_length(me->m_pending) > 0)
+    {
+        NOISY_MSG_("deferring shutdown of fd %d", me->m_fd);
+        me->m_pending_shutdown = how + 1;
+        if (how == SHUT_RDWR)
+        {
+            shutdown(me->m_fd, SHUT_RD);
+        }
+        return;
+    }
+    shutdown(me->m_fd, how);
+}
+
+static bool
+was_connected_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    return RP_IO_URING_SOCKET_HANDLE_IMPL(self)->m_was_connected;
+}
+
+static RpSysCallIntResult
+write_i(RpIoHandle* self, evbuf_t* buffer)
+{
+    NOISY_MSG_("(%p(fd %d), %p(%zu))", self, SOCKFD(self), buffer, evbuf_length(buffer));
+    if (!buffer)
+    {
+        LOGI("buffer is null on fd %d", SOCKFD(self));
+        return rp_sys_call_int_ctor(0, 0);
+    }
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    if (!me->m_open)
+    {
+        LOGD("socket is closed");
+        return rp_sys_call_int_ctor(-1, EBADF);
+    }
+    if (me->m_write_error)
+    {
+        NOISY_MSG_("write error %d on fd %d", me->m_write_error, me->m_fd);
+        return rp_sys_call_int_ctor(-1, me->m_write_error);
+    }
+
+    // Moves (not copies) the caller's bytes; the send goes out with the
+    // other submissions at the end of this loop iteration.
+    evbuffer_add_buffer(me->m_pending, buffer);
+    start_send(me);
+    return rp_sys_call_int_ctor(0, 0);
+}
+
+static RpSysCallIntResult
+read_i(RpIoHandle* self, evbuf_t* buffer)
+{
+    NOISY_MSG_("(%p(fd %d), %p)", self, SOCKFD(self), buffer);
+    if (!buffer)
+    {
+        LOGI("buffer is null on fd %d", SOCKFD(self));
+        return rp_sys_call_int_ctor(-1, EINVAL);
+    }
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    if (me->m_read_ahead && evbuffer_get_length(me->m_read_ahead) > 0)
+    {
+        int n = (int)evbuffer_get_length(me->m_read_ahead);
+        NOISY_MSG_("%d read ahead bytes for fd %d", n, me->m_fd);
+        evbuffer_add_buffer(buffer, me->m_read_ahead);
+        if (me->m_initialized && has_read_result(me))
+        {
+            file_event_activate(me, RpFileReadyType_Read);
+        }
+        return rp_sys_call_int_ctor(n, 0);
+    }
+    if (evbuffer_get_length(me->m_received) > 0)
+    {
+        int n = (int)evbuffer_get_length(me->m_received);
+        evbuffer_add_buffer(buffer, me->m_received);
+        // The end of the stream, if it came along, goes out next time.
+        if (me->m_initialized && (me->m_eof || me->m_read_error))
+        {
+            file_event_activate(me, RpFileReadyType_Read);
+        }
+        return rp_sys_call_int_ctor(n, 0);
+    }
+    if (me->m_read_error)
+    {
+        return rp_sys_call_int_ctor(-1, me->m_read_error);
+    }
+    if (me->m_eof)
+    {
+        return rp_sys_call_int_ctor(0, 0);
+    }
+    return rp_sys_call_int_ctor(-1, EAGAIN);
+}
+
+static int
+sockfd_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return SOCKFD(self);
+}
+
+static gsize
+buffered_bytes_i(RpIoHandle* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    // An armed receive may yet complete with data, so the handle isn't idle
+    // until it has been cancelled.
+    return (me->m_read_ahead ? evbuffer_get_length(me->m_read_ahead) : 0) +
+            evbuffer_get_length(me->m_received) +
+            evbuffer_get_length(me->m_pending) +
+            (me->m_recv_armed ? 1 : 0);
+}
+
+static void
+suspend_i(RpIoHandle* self, bool suspend)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), suspend);
+    RpIoUringSocketHandleImpl* me = RP_IO_URING_SOCKET_HANDLE_IMPL(self);
+    me->m_suspended = suspend;
+    update_ops(me);
+}
+
+static void
+io_handle_iface_init(RpIoHandleInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->activate_file_events = activate_file_events_i;
+    iface->close = close_i;
+    iface->connect = connect_i;
+    iface->connect_socket = connect_socket_i;
+    iface->enable_file_events = enable_file_events_i;
+    iface->initialize_file_event = initialize_file_event_i;
+    iface->interface_name = interface_name_i;
+    iface->is_open = is_open_i;
+    iface->local_address = local_address_i;
+    iface->peer_address = peer_address_i;
+    iface->reset_file_events = reset_file_events_i;
+    iface->shutdown = shutdown_i;
+    iface->was_connected = was_connected_i;
+    iface->read = read_i;
+    iface->write = write_i;
+    iface->sockfd = sockfd_i;
+    iface->buffered_bytes = buffered_bytes_i;
+    iface->suspend = suspend_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    // In-flight submissions hold a reference, so none are left by now.
+    RpIoUringSocketHandleImpl* self = RP_IO_URING_SOCKET_HANDLE_IMPL(obj);
+    self->m_open = false;
+    close_fd(self);
+
+    if (self->m_activation_cb)
+    {
+        rp_schedulable_callback_cancel(self->m_activation_cb);
+    }
+    g_clear_object(&self->m_activation_cb);
+    g_clear_object(&self->m_linger_timer);
+    g_clear_pointer(&self->m_read_ahead, evbuffer_free);
+    g_clear_pointer(&self->m_received, evbuffer_free);
+    g_clear_pointer(&self->m_pending, evbuffer_free);
+    g_clear_object(&self->m_local_address);
+    g_clear_object(&self->m_remote_address);
+    g_clear_object(&self->m_ring);
+
+    G_OBJECT_CLASS(rp_io_uring_socket_handle_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_io_uring_socket_handle_impl_class_init(RpIoUringSocketHandleImplClass* klass)
+{
+    NOISY_MSG_("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_io_uring_socket_handle_impl_init(RpIoUringSocketHandleImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_fd = EVUTIL_INVALID_SOCKET;
+    self->m_received = evbuffer_new();
+    self->m_pending = evbuffer_new();
+    self->m_recv_op = (RpIoUringOp){ .m_cb = recv_cb, .m_arg = self };
+    self->m_poll_op = (RpIoUringOp){ .m_cb = poll_cb, .m_arg = self };
+    self->m_send_op = (RpIoUringOp){ .m_cb = send_cb, .m_arg = self };
+    self->m_connect_op = (RpIoUringOp){ .m_cb = connect_cb, .m_arg = self };
+}
+
+RpIoUringSocketHandleImpl*
+rp_io_uring_socket_handle_impl_new(RpIoUring* ring, RpHandleType_e type, evutil_socket_t fd, evbuf_t* read_ahead)
+{
+    LOGD("(%p, %d, %d, %p)", ring, type, fd, read_ahead);
+    g_return_val_if_fail(RP_IS_IO_URING(ring), NULL);
+    RpIoUringSocketHandleImpl* self = g_object_new(RP_TYPE_IO_URING_SOCKET_HANDLE_IMPL, NULL);
+    self->m_ring = g_object_ref(ring);
+    self->m_fd = fd;
+    self->m_read_ahead = read_ahead;
+    self->m_type = type;
+    if (fd >= 0)
+    {
+        // Blocking, so that the ring waits for the socket rather than handing
+        // back EAGAIN.
+        int flags = fcntl(fd, F_GETFL);
+        if (flags >= 0)
+        {
+            fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+        }
+        self->m_open = true;
+    }
+    return self;
+}
+
+#endif//HAVE_LIBURING
@@ -0,0 +1,43 @@
+/*
+ * rp-io-uring-socket-handle-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rproxy.h"
+#include "rp-io-handle.h"
+#include "event/rp-io-uring-impl.h"
+#include "network/rp-io-bev-socket-handle-impl.h"
+
+#ifdef HAVE_LIBURING
+
+G_BEGIN_DECLS
+
+/**
+ * IoHandle derivative for plain sockets on the thread's io_uring. One
+ * multishot receive per socket stays armed while reading is enabled and
+ * fills the handle from the ring's provided buffers; writes go out as
+ * sendmsg() submissions, batched with everyone else's at the end of the loop
+ * iteration. In-flight submissions hold a reference on the handle.
+ */
+#define RP_TYPE_IO_URING_SOCKET_HANDLE_IMPL rp_io_uring_socket_handle_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpIoUringSocketHandleImpl, rp_io_uring_socket_handle_impl, RP, IO_URING_SOCKET_HANDLE_IMPL, GObject)
+
+/**
+ * @param fd the socket, or -1 for a handle that creates its own on connect().
+ * @param read_ahead bytes already read off |fd|, handed out by the first
+ *        read(); owned by the handle, may be NULL.
+ */
+RpIoUringSocketHandleImpl* rp_io_uring_socket_handle_impl_new(RpIoUring* ring,
+                                                                RpHandleType_e type,
+                                                                evutil_socket_t fd,
+                                                                evbuf_t* read_ahead);
+
+G_END_DECLS
+
+#endif//HAVE_LIBURING
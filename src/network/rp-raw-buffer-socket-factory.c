@@ -69,6 +69,14 @@ create_transport_socket_i(RpUpstreamTransportSocketFactory* self, RpDispatcher*
     evbase_t* evbase = rp_dispatcher_base(dispatcher);
     upstream_t* upstream = rp_host_description_metadata(host);
 
+    if (!upstream_cfg->ssl_cfg && upstream_cfg->io_handle != io_handle_type_bufferevent)
+    {
+        NOISY_MSG_("native io handle");
+        RpIoUring* ring = upstream_cfg->io_handle == io_handle_type_io_uring ? rp_io_uring_get(evbase) : NULL;
+        return RP_NETWORK_TRANSPORT_SOCKET(
+                rp_raw_buffer_socket_new_native(RpHandleType_Connecting, EVUTIL_INVALID_SOCKET, NULL, ring));
+    }
+
     SSL* ssl = NULL;
     evbev_t* bev;
     if (upstream_cfg->ssl_cfg)
@@ -103,9 +111,36 @@ static RpNetworkTransportSocketPtr
 create_downstream_transport_socket_i(RpDownstreamTransportSocketFactory* self, evhtp_connection_t* conn)
 {
     NOISY_MSG_("(%p, %p)", self, conn);
+    RpRawBufferSocketFactory* me = RP_RAW_BUFFER_SOCKET_FACTORY(self);
     evbev_t* bev = evhtp_connection_take_ownership(conn);
-    return RP_NETWORK_TRANSPORT_SOCKET(
-            rp_raw_buffer_socket_new(RpHandleType_Accepting, bev, conn->ssl));
+    if (!conn->ssl && me->m_server_cfg && me->m_server_cfg->io_handle != io_handle_type_bufferevent)
+    {
+        // Keep the descriptor, along with anything libevhtp already read off
+        // it, and let the bufferevent go.
+        evutil_socket_t fd = bufferevent_getfd(bev);
+        evbuf_t* input = bufferevent_get_input(bev);
+        evbuf_t* read_ahead = NULL;
+        RpIoUring* ring = me->m_server_cfg->io_handle == io_handle_type_io_uring ?
+                            rp_io_uring_get(bufferevent_get_base(bev)) : NULL;
+        if (evbuffer_get_length(input) > 0)
+        {
+            NOISY_MSG_("%zu bytes read ahead on fd %d", evbuffer_get_length(input), fd);
+            read_ahead = evbuffer_new();
+            evbuffer_add_buffer(read_ahead, input);
+        }
+        bufferevent_disable(bev, EV_READ|EV_WRITE);
+        bufferevent_setfd(bev, EVUTIL_INVALID_SOCKET);
+        bufferevent_free(bev);
+        return RP_NETWORK_TRANSPORT_SOCKET(
+                rp_raw_buffer_socket_new_native(RpHandleType_Accepting, fd, read_ahead, ring));
+    }
+    RpRawBufferSocket* socket = rp_raw_buffer_socket_new(RpHandleType_Accepting, bev, conn->ssl);
+    if (conn->ssl && me->m_server_cfg && me->m_server_cfg->ssl_dynamic_records)
+    {
+        NOISY_MSG_("dynamic records");
+        rp_raw_buffer_socket_enable_dynamic_records(socket);
+    }
+    return RP_NETWORK_TRANSPORT_SOCKET(socket);
 }
 
 static void
@@ -13,21 +13,46 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include <string.h>
 #include "rp-headers.h"
 #include "rp-stream-info.h"
 #include "network/rp-io-bev-socket-handle-impl.h"
+#include "network/rp-io-socket-handle-impl.h"
+#include "network/rp-io-uring-socket-handle-impl.h"
 #include "network/rp-raw-buffer-socket.h"
 
+// Dynamic record sizing: records that fit in one segment until the
+// connection has sent enough to have opened up its congestion window, and
+// again after it has been idle.
+#define SMALL_RECORD_SIZE 1300
+#define LARGE_RECORD_SIZE SSL3_RT_MAX_PLAIN_LENGTH
+#define GROW_AFTER_BYTES (1024 * 1024)
+#define GROW_AFTER_USEC G_USEC_PER_SEC
+#define RESET_AFTER_IDLE_USEC G_USEC_PER_SEC
+
 struct _RpRawBufferSocket {
     GObject parent_instance;
 
     evbev_t* m_bev; // Temporary ownership until create_io_handle() is called.
     evhtp_ssl_t* m_ssl;
 
+    // Native handles only; same ownership as |m_bev|.
+    evutil_socket_t m_fd;
+    evbuf_t* m_read_ahead;
+    RpIoUring* m_ring;
+    bool m_native;
+
     RpHandleType_e m_type;
 
     RpNetworkTransportSocketCallbacks* m_callbacks;
     bool m_shutdown;
+
+    // Dynamic record sizing only.
+    gint64 m_small_records_since;
+    gint64 m_last_write;
+    guint64 m_small_record_bytes;
+    bool m_dynamic_records : 1;
+    bool m_small_records : 1;
 };
 
 static void transport_socket_iface_init(RpNetworkTransportSocketInterface* iface);
@@ -45,6 +70,32 @@ ssl_i(RpNetworkTransportSocket* self)
     return RP_RAW_BUFFER_SOCKET(self)->m_ssl ? RP_SSL_CONNECTION_INFO(self) : NULL;
 }
 
+static const char*
+protocol_i(RpNetworkTransportSocket* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpRawBufferSocket* me = RP_RAW_BUFFER_SOCKET(self);
+    if (!me->m_ssl)
+    {
+        return "";
+    }
+
+    const unsigned char* alpn;
+    unsigned int alpn_len;
+    SSL_get0_alpn_selected(me->m_ssl, &alpn, &alpn_len);
+    // Hand back static strings; the selected protocol isn't NUL terminated.
+    if (alpn_len == 2 && memcmp(alpn, "h2", 2) == 0)
+    {
+        return "h2";
+    }
+    if (alpn_len == 8 && memcmp(alpn, "http/1.1", 8) == 0)
+    {
+        return "http/1.1";
+    }
+    return "";
+}
+
 static void
 set_transport_socket_callbacks_i(RpNetworkTransportSocket* self, RpNetworkTransportSocketCallbacks* callbacks)
 {
@@ -71,6 +122,20 @@ create_io_handle_i(RpNetworkTransportSocket* self)
 {
     NOISY_MSG_("(%p)", self);
     RpRawBufferSocket* me = RP_RAW_BUFFER_SOCKET(self);
+    if (me->m_native)
+    {
+        NOISY_MSG_("native handle for fd %d", me->m_fd);
+        evutil_socket_t fd = me->m_fd;
+        me->m_fd = EVUTIL_INVALID_SOCKET;
+#ifdef HAVE_LIBURING
+        if (me->m_ring)
+        {
+            NOISY_MSG_("on io_uring %p", me->m_ring);
+            return RP_IO_HANDLE(rp_io_uring_socket_handle_impl_new(me->m_ring, me->m_type, fd, g_steal_pointer(&me->m_read_ahead)));
+        }
+#endif//HAVE_LIBURING
+        return RP_IO_HANDLE(rp_io_socket_handle_impl_new(me->m_type, fd, g_steal_pointer(&me->m_read_ahead)));
+    }
     RpIoBevSocketHandleImpl* io_handle = rp_io_bev_socket_handle_impl_new(me->m_type, g_steal_pointer(&me->m_bev));
     return RP_IO_HANDLE(io_handle);
 }
@@ -94,6 +159,13 @@ do_read_i(RpNetworkTransportSocket* self, evbuf_t* buffer)
     }
     else if (result.m_return_value < 0)
     {
+        // Only a native handle reads the socket itself, and so can find it
+        // empty.
+        if (result.m_errno == EAGAIN || result.m_errno == EWOULDBLOCK || result.m_errno == EINTR)
+        {
+            NOISY_MSG_("nothing to read");
+            return rp_io_result_ctor(RpPostIoAction_KeepOpen, 0, false, 0);
+        }
         action = RpPostIoAction_Close;
     }
     else
@@ -109,6 +181,37 @@ do_read_i(RpNetworkTransportSocket* self, evbuf_t* buffer)
     return rp_io_result_ctor(action, bytes_read, end_stream, result.m_errno);
 }
 
+static void
+size_records(RpRawBufferSocket* self, size_t bytes_to_write)
+{
+    NOISY_MSG_("(%p, %zu)", self, bytes_to_write);
+
+    // The bufferevent encrypts later in the loop iteration, with whatever
+    // fragment size is set then; close enough to the write it was set for.
+    gint64 now = g_get_monotonic_time();
+    if (now - self->m_last_write > RESET_AFTER_IDLE_USEC)
+    {
+        if (!self->m_small_records)
+        {
+            NOISY_MSG_("small records");
+            SSL_set_max_send_fragment(self->m_ssl, SMALL_RECORD_SIZE);
+            self->m_small_records = true;
+        }
+        self->m_small_records_since = now;
+        self->m_small_record_bytes = 0;
+    }
+    else if (self->m_small_records &&
+                (self->m_small_record_bytes >= GROW_AFTER_BYTES ||
+                 now - self->m_small_records_since >= GROW_AFTER_USEC))
+    {
+        NOISY_MSG_("full size records after %" G_GUINT64_FORMAT " bytes", self->m_small_record_bytes);
+        SSL_set_max_send_fragment(self->m_ssl, LARGE_RECORD_SIZE);
+        self->m_small_records = false;
+    }
+    self->m_last_write = now;
+    self->m_small_record_bytes += bytes_to_write;
+}
+
 static RpIoResult
 do_write_i(RpNetworkTransportSocket* self, evbuf_t* buffer, bool end_stream)
 {
@@ -132,6 +235,10 @@ do_write_i(RpNetworkTransportSocket* self, evbuf_t* buffer, bool end_stream)
     }
     else
     {
+        if (me->m_dynamic_records)
+        {
+            size_records(me, bytes_to_write);
+        }
         result = rp_io_handle_write(io_handle, buffer);
         if (result.m_return_value == 0)
         {
@@ -162,6 +269,7 @@ transport_socket_iface_init(RpNetworkTransportSocketInterface* iface)
 {
     LOGD("(%p)", iface);
     iface->ssl = ssl_i;
+    iface->protocol = protocol_i;
     iface->set_transport_socket_callbacks = set_transport_socket_callbacks_i;
     iface->close_socket = close_socket_i;
     iface->on_connected = on_connected_i;
@@ -171,10 +279,26 @@ transport_socket_iface_init(RpNetworkTransportSocketInterface* iface)
     iface->connect = connect_i;
 }
 
+static bool
+kernel_tls_i(RpSslConnectionInfo* self)
+{
+    NOISY_MSG_("(%p)", self);
+#if defined(BIO_get_ktls_send) && defined(BIO_get_ktls_recv)
+    evhtp_ssl_t* ssl = RP_RAW_BUFFER_SOCKET(self)->m_ssl;
+    return ssl &&
+            BIO_get_ktls_send(SSL_get_wbio(ssl)) &&
+            BIO_get_ktls_recv(SSL_get_rbio(ssl)) &&
+            SSL_pending(ssl) == 0;
+#else
+    return false;
+#endif
+}
+
 static void
 ssl_connection_info_iface_init(RpSslConnectionInfoInterface* iface)
 {
     LOGD("(%p)", iface);
+    iface->kernel_tls = kernel_tls_i;
 }
 
 OVERRIDE void
@@ -184,6 +308,13 @@ dispose(GObject* obj)
 
     RpRawBufferSocket* self = RP_RAW_BUFFER_SOCKET(obj);
     g_clear_pointer(&self->m_bev, bufferevent_free);
+    g_clear_pointer(&self->m_read_ahead, evbuffer_free);
+    g_clear_object(&self->m_ring);
+    if (self->m_fd != EVUTIL_INVALID_SOCKET)
+    {
+        evutil_closesocket(self->m_fd);
+        self->m_fd = EVUTIL_INVALID_SOCKET;
+    }
 
     G_OBJECT_CLASS(rp_raw_buffer_socket_parent_class)->dispose(obj);
 }
@@ -198,9 +329,10 @@ rp_raw_buffer_socket_class_init(RpRawBufferSocketClass* klass)
 }
 
 static void
-rp_raw_buffer_socket_init(RpRawBufferSocket* self G_GNUC_UNUSED)
+rp_raw_buffer_socket_init(RpRawBufferSocket* self)
 {
     NOISY_MSG_("(%p)", self);
+    self->m_fd = EVUTIL_INVALID_SOCKET;
 }
 
 RpRawBufferSocket*
@@ -213,3 +345,25 @@ rp_raw_buffer_socket_new(RpHandleType_e type, evbev_t* bev, evhtp_ssl_t* ssl)
     self->m_ssl = ssl;
     return self;
 }
+
+RpRawBufferSocket*
+rp_raw_buffer_socket_new_native(RpHandleType_e type, evutil_socket_t fd, evbuf_t* read_ahead, RpIoUring* ring)
+{
+    LOGD("(%d, %d, %p, %p)", type, fd, read_ahead, ring);
+    RpRawBufferSocket* self = g_object_new(RP_TYPE_RAW_BUFFER_SOCKET, NULL);
+    self->m_type = type;
+    self->m_fd = fd;
+    self->m_read_ahead = read_ahead;
+    self->m_ring = ring ? g_object_ref(ring) : NULL;
+    self->m_native = true;
+    return self;
+}
+
+void
+rp_raw_buffer_socket_enable_dynamic_records(RpRawBufferSocket* self)
+{
+    LOGD("(%p)", self);
+    g_return_if_fail(RP_IS_RAW_BUFFER_SOCKET(self));
+    g_return_if_fail(self->m_ssl != NULL);
+    self->m_dynamic_records = true;
+}
@@ -9,6 +9,7 @@
 
 #include <stdbool.h>
 #include <glib-object.h>
+#include "event/rp-io-uring-impl.h"
 #include "network/rp-io-bev-socket-handle-impl.h"
 #include "rp-net-transport-socket.h"
 
@@ -20,6 +21,21 @@ G_DECLARE_FINAL_TYPE(RpRawBufferSocket, rp_raw_buffer_socket, RP, RAW_BUFFER_SOC
 RpRawBufferSocket* rp_raw_buffer_socket_new(RpHandleType_e type,
                                             evbev_t* bev,
                                             evhtp_ssl_t* ssl);
+/**
+ * Plain socket whose io handle reads and writes |fd| directly rather than
+ * through a bufferevent. |fd| may be -1 for a connecting socket, and
+ * |read_ahead| (owned, may be NULL) holds bytes already read off |fd|. With
+ * |ring|, the socket is driven through that io_uring instead of events.
+ */
+RpRawBufferSocket* rp_raw_buffer_socket_new_native(RpHandleType_e type,
+                                                    evutil_socket_t fd,
+                                                    evbuf_t* read_ahead,
+                                                    RpIoUring* ring);
+/**
+ * Has an ssl socket write small, single segment records while it is new or
+ * has been idle, and full size ones once it has been busy for a while.
+ */
+void rp_raw_buffer_socket_enable_dynamic_records(RpRawBufferSocket* self);
 
 
 #define RP_TYPE_RAW_BUFFER_SOCKET_FACTORY rp_raw_buffer_socket_factory_get_type()
@@ -0,0 +1,437 @@
+/*
+ * rp-splice-pump.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_splice_pump_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_splice_pump_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <errno.h>
+#include "rproxy.h"
+#include "rp-net-conn-impl.h"
+#include "rp-timer.h"
+#include "network/rp-splice-pump.h"
+
+// Most bytes moved into a pipe by one splice() call.
+#define SPLICE_CHUNK_SIZE (64 * 1024)
+// Chunks moved per direction before yielding back to the event loop.
+#define SPLICE_MAX_ROUNDS 16
+// How long the connections get to flush what they have already buffered.
+#define HANDOFF_RETRY_MS 10
+#define HANDOFF_MAX_ATTEMPTS 100
+
+typedef struct _RpSpliceDirection RpSpliceDirection;
+struct _RpSpliceDirection {
+    RpSplicePump* m_pump;
+    int m_from_fd;
+    int m_to_fd;
+    int m_pipe[2];
+    gsize m_in_pipe;
+    struct event* m_read_event;
+    struct event* m_write_event;
+    bool m_eof : 1;
+    bool m_done : 1;
+};
+
+struct _RpSplicePump {
+    GObject parent_instance;
+
+    RpDispatcher* m_dispatcher;
+    RpNetworkConnection* m_downstream;
+    RpNetworkConnection* m_upstream;
+    RpTimer* m_handoff_timer;
+
+    RpSpliceDirection m_directions[2];
+    guint m_handoff_attempts;
+
+    bool m_done : 1;
+};
+
+static void network_connection_callbacks_iface_init(RpNetworkConnectionCallbacksInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpSplicePump, rp_splice_pump, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_NETWORK_CONNECTION_CALLBACKS, network_connection_callbacks_iface_init)
+)
+
+static inline RpIoHandle*
+connection_io_handle(RpNetworkConnection* connection)
+{
+    return rp_socket_io_handle(
+            RP_SOCKET(rp_network_connection_impl_socket_(RP_NETWORK_CONNECTION_IMPL(connection))));
+}
+
+static inline void
+direction_clear(RpSpliceDirection* dir)
+{
+    NOISY_MSG_("(%p)", dir);
+    g_clear_pointer(&dir->m_read_event, event_free);
+    g_clear_pointer(&dir->m_write_event, event_free);
+    for (int i = 0; i < 2; ++i)
+    {
+        if (dir->m_pipe[i] >= 0)
+        {
+            close(dir->m_pipe[i]);
+            dir->m_pipe[i] = -1;
+        }
+    }
+}
+
+static void
+detach(RpSplicePump* self)
+{
+    NOISY_MSG_("(%p)", self);
+    rp_timer_disable_timer(self->m_handoff_timer);
+    rp_network_connection_remove_connection_callbacks(self->m_downstream, RP_NETWORK_CONNECTION_CALLBACKS(self));
+    rp_network_connection_remove_connection_callbacks(self->m_upstream, RP_NETWORK_CONNECTION_CALLBACKS(self));
+    rp_dispatcher_deferred_delete_take(self->m_dispatcher, G_OBJECT(self));
+}
+
+static void
+finish(RpSplicePump* self, const char* reason)
+{
+    NOISY_MSG_("(%p, %p(%s))", self, reason, reason);
+
+    if (self->m_done)
+    {
+        NOISY_MSG_("already done");
+        return;
+    }
+    self->m_done = true;
+
+    LOGD("splice pump %p %s", self, reason);
+
+    // The events go before the descriptors do. This pump no longer listens to
+    // either connection, so closing them does not call back into it.
+    direction_clear(&self->m_directions[0]);
+    direction_clear(&self->m_directions[1]);
+    rp_network_connection_remove_connection_callbacks(self->m_downstream, RP_NETWORK_CONNECTION_CALLBACKS(self));
+    rp_network_connection_remove_connection_callbacks(self->m_upstream, RP_NETWORK_CONNECTION_CALLBACKS(self));
+    if (rp_network_connection_state(self->m_downstream) == RpNetworkConnectionState_Open)
+    {
+        rp_network_connection_close(self->m_downstream, RpNetworkConnectionCloseType_NoFlush);
+    }
+    if (rp_network_connection_state(self->m_upstream) == RpNetworkConnectionState_Open)
+    {
+        rp_network_connection_close(self->m_upstream, RpNetworkConnectionCloseType_NoFlush);
+    }
+    rp_timer_disable_timer(self->m_handoff_timer);
+    rp_dispatcher_deferred_delete_take(self->m_dispatcher, G_OBJECT(self));
+}
+
+static void
+give_up(RpSplicePump* self, const char* reason)
+{
+    NOISY_MSG_("(%p, %p(%s))", self, reason, reason);
+
+    self->m_done = true;
+
+    LOGD("splice pump %p not started, %s", self, reason);
+
+    if (rp_network_connection_state(self->m_downstream) == RpNetworkConnectionState_Open)
+    {
+        rp_io_handle_suspend(connection_io_handle(self->m_downstream), false);
+    }
+    if (rp_network_connection_state(self->m_upstream) == RpNetworkConnectionState_Open)
+    {
+        rp_io_handle_suspend(connection_io_handle(self->m_upstream), false);
+    }
+    detach(self);
+}
+
+#ifdef __linux__
+
+static void
+direction_pump(RpSpliceDirection* dir)
+{
+    NOISY_MSG_("(%p(fd %d -> fd %d))", dir, dir->m_from_fd, dir->m_to_fd);
+
+    RpSplicePump* self = dir->m_pump;
+    for (int round = 0; round < SPLICE_MAX_ROUNDS; ++round)
+    {
+        while (dir->m_in_pipe > 0)
+        {
+            ssize_t n = splice(dir->m_pipe[0], NULL, dir->m_to_fd, NULL, dir->m_in_pipe, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+            if (n < 0)
+            {
+                if (errno == EAGAIN)
+                {
+                    // Wait for room on the destination before reading more.
+                    NOISY_MSG_("fd %d full, %zu bytes in pipe", dir->m_to_fd, dir->m_in_pipe);
+                    event_del(dir->m_read_event);
+                    event_add(dir->m_write_event, NULL);
+                    return;
+                }
+                finish(self, g_strerror(errno));
+                return;
+            }
+            dir->m_in_pipe -= n;
+        }
+
+        if (dir->m_eof)
+        {
+            NOISY_MSG_("end of stream from fd %d", dir->m_from_fd);
+            event_del(dir->m_read_event);
+            event_del(dir->m_write_event);
+            shutdown(dir->m_to_fd, SHUT_WR);
+            dir->m_done = true;
+            if (self->m_directions[0].m_done && self->m_directions[1].m_done)
+            {
+                finish(self, "closed");
+            }
+            return;
+        }
+
+        ssize_t n = splice(dir->m_from_fd, NULL, dir->m_pipe[1], NULL, SPLICE_CHUNK_SIZE, SPLICE_F_MOVE|SPLICE_F_NONBLOCK);
+        if (n < 0)
+        {
+            if (errno == EAGAIN)
+            {
+                event_del(dir->m_write_event);
+                event_add(dir->m_read_event, NULL);
+                return;
+            }
+            finish(self, g_strerror(errno));
+            return;
+        }
+        if (n == 0)
+        {
+            dir->m_eof = true;
+        }
+        dir->m_in_pipe += n;
+    }
+
+    // Yield to the other direction and the rest of the loop. Both events are
+    // level-triggered; whatever is left in the pipe goes out once the
+    // destination is writable, and the source is picked up again after that.
+    NOISY_MSG_("yielding");
+    if (dir->m_in_pipe > 0)
+    {
+        event_add(dir->m_write_event, NULL);
+    }
+}
+
+static void
+direction_cb(evutil_socket_t fd G_GNUC_UNUSED, short events G_GNUC_UNUSED, void* arg)
+{
+    NOISY_MSG_("(%d, %d, %p)", fd, events, arg);
+    direction_pump(arg);
+}
+
+static bool
+direction_init(RpSpliceDirection* dir, RpSplicePump* self, RpNetworkConnection* from, RpNetworkConnection* to)
+{
+    NOISY_MSG_("(%p, %p, %p, %p)", dir, self, from, to);
+
+    dir->m_pump = self;
+    dir->m_from_fd = rp_network_connection_sockfd(from);
+    dir->m_to_fd = rp_network_connection_sockfd(to);
+    if (pipe2(dir->m_pipe, O_NONBLOCK|O_CLOEXEC) != 0)
+    {
+        LOGE("pipe2() failed %d(%s)", errno, g_strerror(errno));
+        dir->m_pipe[0] = dir->m_pipe[1] = -1;
+        return false;
+    }
+    // The pipe only ever holds what one read put in it.
+    fcntl(dir->m_pipe[1], F_SETPIPE_SZ, SPLICE_CHUNK_SIZE);
+
+    evbase_t* base = rp_dispatcher_base(self->m_dispatcher);
+    dir->m_read_event = event_new(base, dir->m_from_fd, EV_READ|EV_PERSIST, direction_cb, dir);
+    dir->m_write_event = event_new(base, dir->m_to_fd, EV_WRITE|EV_PERSIST, direction_cb, dir);
+    return dir->m_read_event && dir->m_write_event;
+}
+
+static void
+begin(RpSplicePump* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    if (!direction_init(&self->m_directions[0], self, self->m_downstream, self->m_upstream) ||
+        !direction_init(&self->m_directions[1], self, self->m_upstream, self->m_downstream))
+    {
+        direction_clear(&self->m_directions[0]);
+        direction_clear(&self->m_directions[1]);
+        give_up(self, "no pipes");
+        return;
+    }
+
+    LOGD("splicing fd %d <-> fd %d",
+        self->m_directions[0].m_from_fd, self->m_directions[0].m_to_fd);
+    event_add(self->m_directions[0].m_read_event, NULL);
+    event_add(self->m_directions[1].m_read_event, NULL);
+}
+
+#else
+
+static void
+begin(RpSplicePump* self)
+{
+    NOISY_MSG_("(%p)", self);
+    give_up(self, "splice() not available");
+}
+
+#endif//__linux__
+
+static inline gsize
+buffered_bytes(RpSplicePump* self)
+{
+    return rp_network_connection_impl_buffered_bytes_(RP_NETWORK_CONNECTION_IMPL(self->m_downstream)) +
+            rp_network_connection_impl_buffered_bytes_(RP_NETWORK_CONNECTION_IMPL(self->m_upstream));
+}
+
+static void
+try_handoff(RpSplicePump* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    if (buffered_bytes(self) == 0)
+    {
+        begin(self);
+    }
+    else if (++self->m_handoff_attempts > HANDOFF_MAX_ATTEMPTS)
+    {
+        give_up(self, "buffers did not drain");
+    }
+    else
+    {
+        NOISY_MSG_("%zu bytes still buffered", buffered_bytes(self));
+        rp_timer_enable_timer(self->m_handoff_timer, HANDOFF_RETRY_MS);
+    }
+}
+
+static void
+on_handoff_timer(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+    try_handoff(RP_SPLICE_PUMP(arg));
+}
+
+static void
+on_event_i(RpNetworkConnectionCallbacks* self, RpNetworkConnectionEvent_e event)
+{
+    NOISY_MSG_("(%p, %d)", self, event);
+
+    RpSplicePump* me = RP_SPLICE_PUMP(self);
+    if (me->m_done)
+    {
+        NOISY_MSG_("done");
+        return;
+    }
+
+    if (event == RpNetworkConnectionEvent_RemoteClose ||
+        event == RpNetworkConnectionEvent_LocalClose)
+    {
+        finish(me, "connection closed");
+    }
+}
+
+static void
+on_above_write_buffer_high_water_mark_i(RpNetworkConnectionCallbacks* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static void
+on_below_write_buffer_low_watermark_i(RpNetworkConnectionCallbacks* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static void
+network_connection_callbacks_iface_init(RpNetworkConnectionCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_event = on_event_i;
+    iface->on_above_write_buffer_high_water_mark = on_above_write_buffer_high_water_mark_i;
+    iface->on_below_write_buffer_low_watermark = on_below_write_buffer_low_watermark_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpSplicePump* self = RP_SPLICE_PUMP(obj);
+    direction_clear(&self->m_directions[0]);
+    direction_clear(&self->m_directions[1]);
+    g_clear_object(&self->m_handoff_timer);
+    g_clear_object(&self->m_downstream);
+    g_clear_object(&self->m_upstream);
+
+    G_OBJECT_CLASS(rp_splice_pump_parent_class)->dispose(obj);
+}
+
+static void
+rp_splice_pump_class_init(RpSplicePumpClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_splice_pump_init(RpSplicePump* self)
+{
+    NOISY_MSG_("(%p)", self);
+    for (int i = 0; i < 2; ++i)
+    {
+        self->m_directions[i].m_pipe[0] = self->m_directions[i].m_pipe[1] = -1;
+    }
+}
+
+static inline bool
+is_spliceable(RpNetworkConnection* connection)
+{
+    NOISY_MSG_("(%p)", connection);
+    // With kTLS in both directions the kernel encrypts what is spliced in
+    // and decrypts what is spliced out, as it does for send() and recv().
+    RpSslConnectionInfo* ssl = rp_network_connection_ssl(connection);
+    return RP_IS_NETWORK_CONNECTION_IMPL(connection) &&
+            rp_network_connection_state(connection) == RpNetworkConnectionState_Open &&
+            !rp_network_connection_connecting(connection) &&
+            (!ssl || rp_ssl_connection_info_kernel_tls(ssl)) &&
+            rp_network_connection_sockfd(connection) >= 0;
+}
+
+bool
+rp_splice_pump_start(RpDispatcher* dispatcher, RpNetworkConnection* downstream, RpNetworkConnection* upstream)
+{
+    LOGD("(%p, %p, %p)", dispatcher, downstream, upstream);
+
+    g_return_val_if_fail(RP_IS_DISPATCHER(dispatcher), false);
+    g_return_val_if_fail(RP_IS_NETWORK_CONNECTION(downstream), false);
+    g_return_val_if_fail(RP_IS_NETWORK_CONNECTION(upstream), false);
+
+    if (!is_spliceable(downstream) || !is_spliceable(upstream))
+    {
+        NOISY_MSG_("not spliceable");
+        return false;
+    }
+
+    // The pump holds its own reference until it hands itself to the
+    // dispatcher. New bytes stay in the kernel from here on; what the
+    // connections already hold is left to drain the usual way first.
+    RpSplicePump* self = g_object_new(RP_TYPE_SPLICE_PUMP, NULL);
+    self->m_dispatcher = dispatcher;
+    self->m_downstream = g_object_ref(downstream);
+    self->m_upstream = g_object_ref(upstream);
+    self->m_handoff_timer = rp_dispatcher_create_timer(dispatcher, on_handoff_timer, self);
+    rp_network_connection_add_connection_callbacks(downstream, RP_NETWORK_CONNECTION_CALLBACKS(self));
+    rp_network_connection_add_connection_callbacks(upstream, RP_NETWORK_CONNECTION_CALLBACKS(self));
+    rp_io_handle_suspend(connection_io_handle(downstream), true);
+    rp_io_handle_suspend(connection_io_handle(upstream), true);
+    try_handoff(self);
+    return true;
+}
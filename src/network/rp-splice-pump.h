@@ -0,0 +1,40 @@
+/*
+ * rp-splice-pump.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-dispatcher.h"
+#include "rp-net-connection.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Moves the bytes of an established tunnel between two TCP connections with
+ * splice() through a pipe per direction, so that they never enter user space.
+ * TLS connections qualify once kTLS handles both directions; a TLS record
+ * other than application data (an alert, say) then fails the splice and ends
+ * the tunnel. The connections' own reads are stopped; once whatever they have
+ * already buffered has been delivered, the pump takes over both descriptors
+ * until either side closes or fails, and then closes both connections. The
+ * pump owns itself and goes away with the tunnel.
+ */
+#define RP_TYPE_SPLICE_PUMP rp_splice_pump_get_type()
+G_DECLARE_FINAL_TYPE(RpSplicePump, rp_splice_pump, RP, SPLICE_PUMP, GObject)
+
+/**
+ * Starts splicing between |downstream| and |upstream| if both are open
+ * socket connections, either unencrypted or with kTLS active. If their buffered bytes do not drain in
+ * time, the pump backs off and the connections carry on as before.
+ * @return true if a pump was started.
+ */
+bool rp_splice_pump_start(RpDispatcher* dispatcher,
+                            RpNetworkConnection* downstream,
+                            RpNetworkConnection* upstream);
+
+G_END_DECLS
@@ -0,0 +1,303 @@
+/*
+ * rp-ssl-async-handshake.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_ssl_async_handshake_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_ssl_async_handshake_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <sys/eventfd.h>
+#include <openssl/err.h>
+#include "network/rp-ssl-async-handshake.h"
+
+// Finished handshake steps of the handshakes started on one thread, on their
+// way back to its event loop.
+typedef struct _RpHandshakeChannel RpHandshakeChannel;
+struct _RpHandshakeChannel {
+    GAsyncQueue* m_done;
+    int m_event_fd;
+    struct event* m_event;
+};
+
+struct _RpSslAsyncHandshake {
+    GObject parent_instance;
+
+    RpHandshakeChannel* m_channel;
+    GThreadPool* m_pool;
+
+    evhtp_ssl_t* m_ssl;
+    evutil_socket_t m_fd;
+    struct event* m_read_event;
+    struct event* m_write_event;
+    struct timeval m_timeout;
+
+    RpSslAsyncHandshakeCb m_cb;
+    gpointer m_arg;
+
+    // SSL_get_error() of the last step; written on a pool thread, read on the
+    // loop after the step has come back through the channel.
+    int m_error;
+
+    bool m_has_timeout : 1;
+};
+
+G_DEFINE_FINAL_TYPE(RpSslAsyncHandshake, rp_ssl_async_handshake, G_TYPE_OBJECT)
+
+G_LOCK_DEFINE_STATIC(pool_);
+static GThreadPool* pool_ = NULL;
+
+// Lives as long as the thread's event loop.
+static __thread RpHandshakeChannel* channel_ = NULL;
+
+static void
+step_func(gpointer data, gpointer user_data G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %p)", data, user_data);
+
+    RpSslAsyncHandshake* self = data;
+    // |self| may be gone as soon as it is in the queue.
+    RpHandshakeChannel* channel = self->m_channel;
+
+    ERR_clear_error();
+    int rc = SSL_do_handshake(self->m_ssl);
+    self->m_error = rc == 1 ? SSL_ERROR_NONE : SSL_get_error(self->m_ssl, rc);
+    if (self->m_error == SSL_ERROR_SSL)
+    {
+        char buf[256];
+        ERR_error_string_n(ERR_peek_error(), buf, sizeof(buf));
+        LOGD("handshake on fd %d failed: %s", self->m_fd, buf);
+    }
+    // The error queue is per thread; leave nothing behind for the next
+    // connection this thread works on.
+    ERR_clear_error();
+
+    g_async_queue_push(channel->m_done, self);
+    eventfd_write(channel->m_event_fd, 1);
+}
+
+static void
+submit(RpSslAsyncHandshake* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    // The pool holds a reference until the step has come back.
+    g_thread_pool_push(self->m_pool, g_object_ref(self), NULL);
+}
+
+static void
+finish(RpSslAsyncHandshake* self, bool success)
+{
+    NOISY_MSG_("(%p, %u)", self, success);
+
+    g_clear_pointer(&self->m_read_event, event_free);
+    g_clear_pointer(&self->m_write_event, event_free);
+
+    evutil_socket_t fd = self->m_fd;
+    self->m_fd = EVUTIL_INVALID_SOCKET;
+    self->m_cb(g_steal_pointer(&self->m_ssl), fd, success, self->m_arg);
+
+    // Drop the reference the handshake has held on itself since it started.
+    g_object_unref(self);
+}
+
+static void
+step_done(RpSslAsyncHandshake* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    const struct timeval* timeout = self->m_has_timeout ? &self->m_timeout : NULL;
+    switch (self->m_error)
+    {
+        case SSL_ERROR_NONE:
+            LOGD("handshake on fd %d done", self->m_fd);
+            finish(self, true);
+            break;
+        case SSL_ERROR_WANT_READ:
+            NOISY_MSG_("waiting to read fd %d", self->m_fd);
+            event_add(self->m_read_event, timeout);
+            break;
+        case SSL_ERROR_WANT_WRITE:
+            NOISY_MSG_("waiting to write fd %d", self->m_fd);
+            event_add(self->m_write_event, timeout);
+            break;
+        default:
+            LOGD("handshake on fd %d failed, error %d", self->m_fd, self->m_error);
+            finish(self, false);
+            break;
+    }
+}
+
+static void
+completion_cb(evutil_socket_t fd, short what G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpHandshakeChannel* channel = arg;
+    eventfd_t value;
+    eventfd_read(fd, &value);
+
+    RpSslAsyncHandshake* handshake;
+    while ((handshake = g_async_queue_try_pop(channel->m_done)))
+    {
+        step_done(handshake);
+        g_object_unref(handshake);
+    }
+}
+
+static void
+io_cb(evutil_socket_t fd G_GNUC_UNUSED, short what, gpointer arg)
+{
+    NOISY_MSG_("(%d, %x, %p)", fd, what, arg);
+
+    RpSslAsyncHandshake* self = arg;
+    if (what & EV_TIMEOUT)
+    {
+        LOGD("handshake on fd %d timed out", self->m_fd);
+        finish(self, false);
+        return;
+    }
+    submit(self);
+}
+
+static RpHandshakeChannel*
+ensure_channel(evbase_t* evbase)
+{
+    NOISY_MSG_("(%p)", evbase);
+
+    if (channel_)
+    {
+        NOISY_MSG_("returning %p", channel_);
+        return channel_;
+    }
+
+    int event_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if (event_fd < 0)
+    {
+        int err = errno;
+        LOGE("eventfd() failed %d(%s)", err, g_strerror(err));
+        return NULL;
+    }
+
+    RpHandshakeChannel* channel = g_new0(RpHandshakeChannel, 1);
+    channel->m_done = g_async_queue_new();
+    channel->m_event_fd = event_fd;
+    channel->m_event = event_new(evbase, event_fd, EV_READ|EV_PERSIST, completion_cb, channel);
+    event_add(channel->m_event, NULL);
+    channel_ = channel;
+    return channel_;
+}
+
+static GThreadPool*
+ensure_pool(int max_threads)
+{
+    NOISY_MSG_("(%d)", max_threads);
+
+    G_LOCK(pool_);
+    if (!pool_)
+    {
+        GError* err = NULL;
+        pool_ = g_thread_pool_new(step_func, NULL, max_threads, FALSE, &err);
+        if (!pool_)
+        {
+            LOGE("g_thread_pool_new() failed: %s", err ? err->message : "?");
+            g_clear_error(&err);
+        }
+    }
+    else if (max_threads > g_thread_pool_get_max_threads(pool_))
+    {
+        NOISY_MSG_("growing pool to %d threads", max_threads);
+        g_thread_pool_set_max_threads(pool_, max_threads, NULL);
+    }
+    GThreadPool* pool = pool_;
+    G_UNLOCK(pool_);
+    return pool;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpSslAsyncHandshake* self = RP_SSL_ASYNC_HANDSHAKE(obj);
+    g_clear_pointer(&self->m_read_event, event_free);
+    g_clear_pointer(&self->m_write_event, event_free);
+    g_clear_pointer(&self->m_ssl, SSL_free);
+    if (self->m_fd != EVUTIL_INVALID_SOCKET)
+    {
+        evutil_closesocket(self->m_fd);
+        self->m_fd = EVUTIL_INVALID_SOCKET;
+    }
+
+    G_OBJECT_CLASS(rp_ssl_async_handshake_parent_class)->dispose(obj);
+}
+
+static void
+rp_ssl_async_handshake_class_init(RpSslAsyncHandshakeClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_ssl_async_handshake_init(RpSslAsyncHandshake* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_fd = EVUTIL_INVALID_SOCKET;
+}
+
+void
+rp_ssl_async_handshake_set_max_threads(int max_threads)
+{
+    LOGD("(%d)", max_threads);
+
+    g_return_if_fail(max_threads > 0);
+
+    ensure_pool(max_threads);
+}
+
+void
+rp_ssl_async_handshake_start(RpDispatcher* dispatcher, evhtp_ssl_t* ssl, evutil_socket_t fd,
+                                const struct timeval* timeout, RpSslAsyncHandshakeCb cb, gpointer arg)
+{
+    LOGD("(%p, %p, %d, %p, %p, %p)", dispatcher, ssl, fd, timeout, cb, arg);
+
+    g_return_if_fail(RP_IS_DISPATCHER(dispatcher));
+    g_return_if_fail(ssl != NULL);
+    g_return_if_fail(fd != EVUTIL_INVALID_SOCKET);
+    g_return_if_fail(cb != NULL);
+
+    evbase_t* evbase = rp_dispatcher_base(dispatcher);
+    RpHandshakeChannel* channel = ensure_channel(evbase);
+    GThreadPool* pool = ensure_pool(1);
+    if (!channel || !pool)
+    {
+        LOGE("cannot offload handshake on fd %d", fd);
+        cb(ssl, fd, false, arg);
+        return;
+    }
+
+    RpSslAsyncHandshake* self = g_object_new(RP_TYPE_SSL_ASYNC_HANDSHAKE, NULL);
+    self->m_channel = channel;
+    self->m_pool = pool;
+    self->m_ssl = ssl;
+    self->m_fd = fd;
+    self->m_read_event = event_new(evbase, fd, EV_READ, io_cb, self);
+    self->m_write_event = event_new(evbase, fd, EV_WRITE, io_cb, self);
+    if (timeout && evutil_timerisset(timeout))
+    {
+        self->m_timeout = *timeout;
+        self->m_has_timeout = true;
+    }
+    self->m_cb = cb;
+    self->m_arg = arg;
+    submit(self);
+}
@@ -0,0 +1,54 @@
+/*
+ * rp-ssl-async-handshake.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rproxy.h"
+#include "rp-dispatcher.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Called on the dispatcher's thread once the handshake is over. |ssl| and
+ * |fd| are handed back to the caller either way; on failure they are only
+ * good for cleaning up.
+ */
+typedef void (*RpSslAsyncHandshakeCb)(evhtp_ssl_t* ssl,
+                                        evutil_socket_t fd,
+                                        bool success,
+                                        gpointer arg);
+
+/**
+ * Drives a TLS handshake with each SSL_do_handshake() step running on a
+ * process wide thread pool, so that the private key operations (and the rest
+ * of the handshake's CPU) stay off the event loop. The loop only waits for
+ * the socket between steps. The handshake owns itself until it has called
+ * back.
+ */
+#define RP_TYPE_SSL_ASYNC_HANDSHAKE rp_ssl_async_handshake_get_type()
+G_DECLARE_FINAL_TYPE(RpSslAsyncHandshake, rp_ssl_async_handshake, RP, SSL_ASYNC_HANDSHAKE, GObject)
+
+/**
+ * Sizes the shared handshake thread pool; the largest value asked for wins.
+ */
+void rp_ssl_async_handshake_set_max_threads(int max_threads);
+
+/**
+ * Starts handshaking |ssl|, which is set up for its side of the handshake
+ * and bound to the non-blocking socket |fd|. |timeout| (may be NULL) bounds
+ * each wait for the peer.
+ */
+void rp_ssl_async_handshake_start(RpDispatcher* dispatcher,
+                                    evhtp_ssl_t* ssl,
+                                    evutil_socket_t fd,
+                                    const struct timeval* timeout,
+                                    RpSslAsyncHandshakeCb cb,
+                                    gpointer arg);
+
+G_END_DECLS
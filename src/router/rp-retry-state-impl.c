@@ -0,0 +1,250 @@
+/*
+ * rp-retry-state-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_retry_state_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_retry_state_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rproxy.h"
+#include "router/rp-retry-state-impl.h"
+
+// How many times the load balancer may be asked for a host that has not
+// already been attempted.
+#define HOST_SELECTION_MAX_ATTEMPTS 3
+
+struct _RpRetryStateImpl {
+    GObject parent_instance;
+
+    RpClusterInfoSharedPtr m_cluster;
+    RpResourcePriority_e m_priority;
+    RpTimer* m_retry_timer;
+
+    RpDoRetryCb m_backoff_callback;
+    gpointer m_backoff_arg;
+
+    // Hosts are owned by the cluster; only compared, never dereferenced.
+    GPtrArray* m_attempted_hosts;
+
+    guint32 m_retries_remaining;
+    guint32 m_retry_on;
+
+    gint64 m_next_interval_ms;
+    gint64 m_max_interval_ms;
+};
+
+G_DEFINE_FINAL_TYPE(RpRetryStateImpl, rp_retry_state_impl, G_TYPE_OBJECT)
+
+static inline RpResourceLimit*
+retries(RpRetryStateImpl* self)
+{
+    return rp_resource_manager_retries(rp_cluster_info_resource_manager(self->m_cluster, self->m_priority));
+}
+
+static void
+reset_retry(RpRetryStateImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    if (self->m_backoff_callback)
+    {
+        rp_resource_limit_dec(retries(self));
+        self->m_backoff_callback = NULL;
+    }
+}
+
+static void
+retry_timer_cb(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+    RpRetryStateImpl* self = arg;
+    RpDoRetryCb callback = self->m_backoff_callback;
+    gpointer callback_arg = self->m_backoff_arg;
+    reset_retry(self);
+    if (callback)
+    {
+        callback(callback_arg);
+    }
+}
+
+// Jittered exponential backoff: a random delay below an interval that doubles
+// on each retry, capped at the maximum interval.
+static gint64
+next_backoff_ms(RpRetryStateImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    gint64 backoff = self->m_next_interval_ms;
+    self->m_next_interval_ms = (self->m_next_interval_ms < self->m_max_interval_ms / 2) ?
+                                self->m_next_interval_ms * 2 : self->m_max_interval_ms;
+    return MIN((gint64)(g_random_int() % (guint32)backoff), self->m_max_interval_ms);
+}
+
+static RpRetryStatus_e
+should_retry(RpRetryStateImpl* self, bool would_retry, RpDoRetryCb callback, gpointer arg)
+{
+    NOISY_MSG_("(%p, %u, %p, %p)", self, would_retry, callback, arg);
+
+    g_assert(!self->m_backoff_callback);
+    if (!would_retry)
+    {
+        return RpRetryStatus_No;
+    }
+    if (self->m_retries_remaining == 0)
+    {
+        LOGD("retry limit exceeded");
+        return RpRetryStatus_NoRetryLimitExceeded;
+    }
+    --self->m_retries_remaining;
+
+    RpResourceLimit* retry_limit = retries(self);
+    if (!rp_resource_limit_can_create(retry_limit))
+    {
+        LOGD("retry budget exhausted (%zu/%zu)", rp_resource_limit_count(retry_limit), rp_resource_limit_max(retry_limit));
+        return RpRetryStatus_NoOverflow;
+    }
+
+    self->m_backoff_callback = callback;
+    self->m_backoff_arg = arg;
+    rp_resource_limit_inc(retry_limit);
+    gint64 backoff = next_backoff_ms(self);
+    LOGD("retrying in %zd ms, %u retries remaining", backoff, self->m_retries_remaining);
+    rp_timer_enable_timer(self->m_retry_timer, backoff);
+    return RpRetryStatus_Yes;
+}
+
+static inline bool
+is_connect_failure(RpStreamResetReason_e reset_reason)
+{
+    switch (reset_reason)
+    {
+        case RpStreamResetReason_LocalConnectionFailure:
+        case RpStreamResetReason_RemoteConnectionFailure:
+        case RpStreamResetReason_ConnectionTimeout:
+        case RpStreamResetReason_ConnectError:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool
+would_retry_from_reset(RpRetryStateImpl* self, RpStreamResetReason_e reset_reason, bool per_try_timeout)
+{
+    NOISY_MSG_("(%p, %d, %u)", self, reset_reason, per_try_timeout);
+
+    // An overflow means the cluster is already saturated; retrying only adds load.
+    if (reset_reason == RpStreamResetReason_Overflow)
+    {
+        return false;
+    }
+    if (per_try_timeout)
+    {
+        return (self->m_retry_on & (RpRetryOn_5xx|RpRetryOn_Reset)) != 0;
+    }
+    if (self->m_retry_on & (RpRetryOn_5xx|RpRetryOn_Reset))
+    {
+        return true;
+    }
+    return (self->m_retry_on & RpRetryOn_ConnectFailure) && is_connect_failure(reset_reason);
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpRetryStateImpl* self = RP_RETRY_STATE_IMPL(obj);
+    reset_retry(self);
+    g_clear_object(&self->m_retry_timer);
+    g_clear_pointer(&self->m_attempted_hosts, g_ptr_array_unref);
+    g_clear_object(&self->m_cluster);
+
+    G_OBJECT_CLASS(rp_retry_state_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_retry_state_impl_class_init(RpRetryStateImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_retry_state_impl_init(RpRetryStateImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_attempted_hosts = g_ptr_array_new();
+}
+
+RpRetryStateImpl*
+rp_retry_state_impl_create(const RpRetryPolicy* route_policy, RpClusterInfoConstSharedPtr cluster,
+                            RpResourcePriority_e priority, RpDispatcher* dispatcher)
+{
+    LOGD("(%p, %p, %d, %p)", route_policy, cluster, priority, dispatcher);
+    g_return_val_if_fail(RP_IS_DISPATCHER(dispatcher), NULL);
+    if (!route_policy || route_policy->m_num_retries == 0 || route_policy->m_retry_on == 0)
+    {
+        NOISY_MSG_("retries disabled");
+        return NULL;
+    }
+
+    RpRetryStateImpl* self = g_object_new(RP_TYPE_RETRY_STATE_IMPL, NULL);
+    rp_cluster_info_set_object(&self->m_cluster, cluster);
+    self->m_priority = priority;
+    self->m_retries_remaining = route_policy->m_num_retries;
+    self->m_retry_on = route_policy->m_retry_on;
+    self->m_next_interval_ms = route_policy->m_base_interval_ms;
+    self->m_max_interval_ms = route_policy->m_max_interval_ms;
+    self->m_retry_timer = rp_dispatcher_create_timer(dispatcher, retry_timer_cb, self);
+    return self;
+}
+
+RpRetryStatus_e
+rp_retry_state_impl_should_retry_headers(RpRetryStateImpl* self, evhtp_res response_code, RpDoRetryCb callback, gpointer arg)
+{
+    LOGD("(%p, %d, %p, %p)", self, response_code, callback, arg);
+    g_return_val_if_fail(RP_IS_RETRY_STATE_IMPL(self), RpRetryStatus_No);
+    bool would_retry = (self->m_retry_on & RpRetryOn_5xx) && response_code >= 500 && response_code < 600;
+    return should_retry(self, would_retry, callback, arg);
+}
+
+RpRetryStatus_e
+rp_retry_state_impl_should_retry_reset(RpRetryStateImpl* self, RpStreamResetReason_e reset_reason, bool per_try_timeout,
+                                        RpDoRetryCb callback, gpointer arg)
+{
+    LOGD("(%p, %d, %u, %p, %p)", self, reset_reason, per_try_timeout, callback, arg);
+    g_return_val_if_fail(RP_IS_RETRY_STATE_IMPL(self), RpRetryStatus_No);
+    return should_retry(self, would_retry_from_reset(self, reset_reason, per_try_timeout), callback, arg);
+}
+
+void
+rp_retry_state_impl_on_host_attempted(RpRetryStateImpl* self, RpHostDescriptionConstSharedPtr host)
+{
+    LOGD("(%p, %p)", self, host);
+    g_return_if_fail(RP_IS_RETRY_STATE_IMPL(self));
+    g_ptr_array_add(self->m_attempted_hosts, (gpointer)host);
+}
+
+bool
+rp_retry_state_impl_should_select_another_host(RpRetryStateImpl* self, RpHostDescriptionConstSharedPtr host)
+{
+    LOGD("(%p, %p)", self, host);
+    g_return_val_if_fail(RP_IS_RETRY_STATE_IMPL(self), false);
+    return g_ptr_array_find(self->m_attempted_hosts, host, NULL);
+}
+
+guint32
+rp_retry_state_impl_host_selection_max_attempts(RpRetryStateImpl* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(RP_IS_RETRY_STATE_IMPL(self), 1);
+    return HOST_SELECTION_MAX_ATTEMPTS;
+}
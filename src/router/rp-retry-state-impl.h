@@ -0,0 +1,56 @@
+/*
+ * rp-retry-state-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <evhtp.h>
+#include "rp-codec.h"
+#include "rp-dispatcher.h"
+#include "rp-router.h"
+#include "rp-upstream.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Callback invoked when a scheduled retry's backoff expires.
+ */
+typedef void (*RpDoRetryCb)(gpointer);
+
+/**
+ * Per request retry state: counts attempts against the route's retry policy,
+ * charges the cluster's retry budget while a retry is pending and schedules
+ * the retry after a jittered exponential backoff.
+ * https://github.com/envoyproxy/envoy/blob/main/source/common/router/retry_state_impl.h
+ */
+#define RP_TYPE_RETRY_STATE_IMPL rp_retry_state_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpRetryStateImpl, rp_retry_state_impl, RP, RETRY_STATE_IMPL, GObject)
+
+/**
+ * Returns NULL if the policy does not allow any retries.
+ */
+RpRetryStateImpl* rp_retry_state_impl_create(const RpRetryPolicy* route_policy,
+                                                RpClusterInfoConstSharedPtr cluster,
+                                                RpResourcePriority_e priority,
+                                                RpDispatcher* dispatcher);
+RpRetryStatus_e rp_retry_state_impl_should_retry_headers(RpRetryStateImpl* self,
+                                                            evhtp_res response_code,
+                                                            RpDoRetryCb callback,
+                                                            gpointer arg);
+RpRetryStatus_e rp_retry_state_impl_should_retry_reset(RpRetryStateImpl* self,
+                                                        RpStreamResetReason_e reset_reason,
+                                                        bool per_try_timeout,
+                                                        RpDoRetryCb callback,
+                                                        gpointer arg);
+void rp_retry_state_impl_on_host_attempted(RpRetryStateImpl* self,
+                                            RpHostDescriptionConstSharedPtr host);
+bool rp_retry_state_impl_should_select_another_host(RpRetryStateImpl* self,
+                                                    RpHostDescriptionConstSharedPtr host);
+guint32 rp_retry_state_impl_host_selection_max_attempts(RpRetryStateImpl* self);
+
+G_END_DECLS
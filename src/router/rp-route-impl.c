@@ -13,6 +13,7 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-route-configuration.h"
 #include "rp-state-filter.h"
@@ -25,6 +26,8 @@ struct _RpRouteImpl {
     rule_cfg_t* m_rule_cfg;
 
     char* m_cluster_name;
+
+    RpRetryPolicy m_retry_policy;
 };
 
 static void route_iface_init(RpRouteInterface* iface);
@@ -88,8 +91,8 @@ finalize_response_headers_i(RpResponseEntry* self G_GNUC_UNUSED, evhtp_headers_t
                             RpStreamInfo* stream_info G_GNUC_UNUSED)
 {
     NOISY_MSG_("(%p, %p, %p)", self, response_headers, stream_info);
-    evhtp_kv_rm_and_free(response_headers,
-        evhtp_headers_find_header(response_headers, "alt-svc"));
+    rp_header_map_remove(response_headers,
+        rp_header_map_find_header(response_headers, "alt-svc"));
 }
 
 static void
@@ -119,7 +122,7 @@ current_url_path_after_rewrite_i(RpRouteEntry* self G_GNUC_UNUSED, evhtp_headers
 {
     NOISY_MSG_("(%p, %p)", self, request_headers);
     //TODO...
-    return g_strdup(evhtp_header_find(request_headers, RpHeaderValues.Path));
+    return g_strdup(rp_header_map_get_inline(request_headers, RpInlineHeader_Path));
 }
 
 static char*
@@ -127,7 +130,7 @@ get_request_host_value_i(RpRouteEntry* self G_GNUC_UNUSED, evhtp_headers_t* requ
 {
     NOISY_MSG_("(%p, %p)", self, request_headers);
     //TODO...host_rewrite_ logic...
-    return g_strdup(evhtp_header_find(request_headers, RpHeaderValues.HostLegacy));
+    return g_strdup(rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy));
 }
 
 static RpResourcePriority_e
@@ -138,6 +141,33 @@ priority_i(RpRouteEntry* self)
     return RpResourcePriority_Default;
 }
 
+static inline gint64
+timeval_to_ms(const struct timeval* tv)
+{
+    return (gint64)tv->tv_sec * 1000 + tv->tv_usec / 1000;
+}
+
+static gint64
+hedge_delay_i(RpRouteEntry* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return timeval_to_ms(&RP_ROUTE_IMPL(self)->m_rule_cfg->hedge_delay);
+}
+
+static bool
+collapsed_forwarding_i(RpRouteEntry* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_ROUTE_IMPL(self)->m_rule_cfg->collapsed_forwarding;
+}
+
+static const RpRetryPolicy*
+retry_policy_i(RpRouteEntry* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return &RP_ROUTE_IMPL(self)->m_retry_policy;
+}
+
 static void
 finalize_request_headers_i(RpRouteEntry* self, evhtp_headers_t* request_headers, RpStreamInfo* stream_info, bool insert_rproxy_original_path)
 {
@@ -153,6 +183,9 @@ route_entry_iface_init(RpRouteEntryInterface* iface)
     iface->current_url_path_after_rewrite = current_url_path_after_rewrite_i;
     iface->get_request_host_value = get_request_host_value_i;
     iface->priority = priority_i;
+    iface->hedge_delay = hedge_delay_i;
+    iface->collapsed_forwarding = collapsed_forwarding_i;
+    iface->retry_policy = retry_policy_i;
     iface->finalize_request_headers = finalize_request_headers_i;
 }
 
@@ -183,6 +216,20 @@ rp_route_impl_init(RpRouteImpl* self G_GNUC_UNUSED)
     LOGD("(%p)", self);
 }
 
+static inline void
+init_retry_policy(RpRetryPolicy* self, const rule_cfg_t* rule_cfg)
+{
+    NOISY_MSG_("(%p, %p)", self, rule_cfg);
+    self->m_num_retries = rule_cfg->num_retries;
+    self->m_retry_on = 0;
+    if (rule_cfg->retry_on & retry_on_connect_failure) self->m_retry_on |= RpRetryOn_ConnectFailure;
+    if (rule_cfg->retry_on & retry_on_reset) self->m_retry_on |= RpRetryOn_Reset;
+    if (rule_cfg->retry_on & retry_on_5xx) self->m_retry_on |= RpRetryOn_5xx;
+    self->m_per_try_timeout_ms = timeval_to_ms(&rule_cfg->per_try_timeout);
+    self->m_base_interval_ms = MAX(timeval_to_ms(&rule_cfg->retry_backoff), 1);
+    self->m_max_interval_ms = self->m_base_interval_ms * 10;
+}
+
 RpRouteImpl*
 rp_route_impl_new(RpRouterConfigConstSharedPtr parent, rule_cfg_t* rule_cfg)
 {
@@ -192,6 +239,7 @@ rp_route_impl_new(RpRouterConfigConstSharedPtr parent, rule_cfg_t* rule_cfg)
     RpRouteImpl* self = g_object_new(RP_TYPE_ROUTE_IMPL, NULL);
     rp_router_config_set_object(&self->m_parent, parent);
     self->m_rule_cfg = rule_cfg;
+    init_retry_policy(&self->m_retry_policy, rule_cfg);
     return self;
 }
 
@@ -14,6 +14,7 @@
 #endif
 
 #include "rproxy.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-rds-config.h"
 #include "event/rp-dispatcher-impl.h"
@@ -105,8 +106,8 @@ route_i(const RpRouterConfig* self, RpRouteCallback cb, evhtp_headers_t* request
 {
     NOISY_MSG_("(%p, %p, %p, %p, %zu)", self, cb, request_headers, stream_info, random_value);
 
-    const char* hostname = evhtp_header_find(request_headers, RpHeaderValues.HostLegacy);
-    const char* path = evhtp_header_find(request_headers, RpHeaderValues.Path);
+    const char* hostname = rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy);
+    const char* path = rp_header_map_get_inline(request_headers, RpInlineHeader_Path);
     RpDispatcher* dispatcher = rp_thread_local_instance_impl_get_dispatcher();
     evthr_t* thr = rp_dispatcher_thr(dispatcher);
     rproxy_t* rproxy = evthr_get_aux(thr);
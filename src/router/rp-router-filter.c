@@ -16,20 +16,27 @@
 #endif
 
 #include "event/rp-dispatcher-impl.h"
+#include "router/rp-retry-state-impl.h"
 #include "router/rp-upstream-request.h"
 #include "rp-http-conn-manager-impl.h"
 #include "rp-http-conn-mgr-impl-active-stream.h"
 #include "rp-filter-chain-factory-callbacks-impl.h"
 #include "rp-filter-manager.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-http-utility.h"
 #include "rp-load-balancer.h"
+#include "rp-outlier-detection.h"
 #include "rp-per-host-upstream.h"
 #include "rp-router.h"
 #include "rp-router-filter.h"
 
 #define RP_ROUTER_FILTER_CB(s) (RpRouterFilterCb*)s
 
+// How many times the load balancer may be asked for a host other than the
+// one already serving a hedged request.
+#define HEDGE_HOST_SELECTION_RETRY_COUNT 3
+
 typedef struct _RpRouterFilterCb RpRouterFilterCb;
 struct _RpRouterFilterCb {
     RpFilterFactoryCb parent_instance;
@@ -52,6 +59,26 @@ struct _RpRouterFilter {
 //REVISIT: Not sure why this exists?    RpUpstreamRequest* m_final_upstream_request;
     SHARED_PTR(RpClusterManager) m_cluster_manager;
 
+    // Hedging state. The cluster and host are owned by the thread local
+    // cluster manager and outlive the stream.
+    RpThreadLocalCluster* m_thread_local_cluster;
+    RpHostDescription* m_hedged_host;
+    RpTimer* m_hedge_timer;
+
+    // Collapsed forwarding. A leader is registered under m_collapse_key until
+    // its response headers arrive and fans its response out to the followers;
+    // a follower sends nothing upstream and points back at its leader. No
+    // references are held, each side detaches from the other in on_destroy().
+    // A follower whose downstream backs up read disables the leader's
+    // upstream, m_collapsed_high_watermark_count counting its own watermarks.
+    char* m_collapse_key;
+    GSList/*<RpRouterFilter*>*/* m_collapsed_followers;
+    RpRouterFilter* m_collapsed_leader;
+    guint32 m_collapsed_high_watermark_count;
+
+    // Only present while the request may still be retried.
+    RpRetryStateImpl* m_retry_state;
+
     evhtp_headers_t* m_downstream_headers;
     evhtp_headers_t* m_downstream_trailers;
 
@@ -65,10 +92,13 @@ struct _RpRouterFilter {
     bool m_downstream_response_started : 1;
     bool m_downstream_end_stream : 1;
     bool m_is_retry : 1;
+    bool m_is_hedge : 1;
     bool m_include_attempt_count_in_request : 1;
     bool m_include_timeout_retry_header_in_request : 1;
     bool m_request_buffer_overflowed : 1;
     bool m_allow_multiplexed_upstream_half_close : 1;
+    bool m_collapsed_watermark_callbacks_added : 1;
+    bool m_collapsed_leader_read_disabled : 1;
 
 };
 
@@ -76,12 +106,17 @@ static void stream_filter_base_iface_init(RpStreamFilterBaseInterface* iface);
 static void stream_decoder_filter_iface_init(RpStreamDecoderFilterInterface* iface);
 static void load_balancer_context_iface_init(RpLoadBalancerContextInterface* iface);
 static void router_filter_interface_iface_init(RpRouterFilterInterfaceInterface* iface);
+static void downstream_watermark_callbacks_iface_init(RpDownstreamWatermarkCallbacksInterface* iface);
+
+static void do_retry(gpointer arg);
+static void collapsed_forwarding_on_destroy(RpRouterFilter* self);
 
 G_DEFINE_FINAL_TYPE_WITH_CODE(RpRouterFilter, rp_router_filter, G_TYPE_OBJECT,
     G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_FILTER_BASE, stream_filter_base_iface_init)
     G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_DECODER_FILTER, stream_decoder_filter_iface_init)
     G_IMPLEMENT_INTERFACE(RP_TYPE_LOAD_BALANCER_CONTEXT, load_balancer_context_iface_init)
     G_IMPLEMENT_INTERFACE(RP_TYPE_ROUTER_FILTER_INTERFACE, router_filter_interface_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_DOWNSTREAM_WATERMARK_CALLBACKS, downstream_watermark_callbacks_iface_init)
 )
 
 static void
@@ -138,6 +173,7 @@ reset_other_upstreams(RpRouterFilter* self, RpUpstreamRequest* upstream_request)
         {
             self->m_upstream_requests = g_slist_delete_link(self->m_upstream_requests, entry);
             rp_upstream_request_reset_stream(upstream_request_tmp);
+            rp_dispatcher_deferred_delete_take(DISPATCHER(self), G_OBJECT(upstream_request_tmp));
         }
         else
         {
@@ -153,11 +189,25 @@ reset_other_upstreams(RpRouterFilter* self, RpUpstreamRequest* upstream_request)
     }
 }
 
+static void
+reset_retry_state(RpRouterFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    // Dropping the retry state also cancels a pending backoff.
+    g_clear_object(&self->m_retry_state);
+    self->m_pending_retries = 0;
+}
+
 static void
 cleanup(RpRouterFilter* self)
 {
     NOISY_MSG_("(%p)", self);
     g_assert(!self->m_upstream_requests);
+    reset_retry_state(self);
+    if (self->m_hedge_timer)
+    {
+        rp_timer_disable_timer(self->m_hedge_timer);
+    }
 //TODO...
 }
 
@@ -176,8 +226,14 @@ on_upstream_complete(RpRouterFilter* self, RpUpstreamRequest* upstream_request)
         rp_upstream_request_reset_stream(upstream_request);
     }
 //    RpDispatcher* dispatcher = rp_stream_filter_callbacks_dispatcher(self->m_callbacks);
-    IF_NOISY_(gint64 response_time = g_get_monotonic_time() - self->m_downstream_request_complete_time;)
+    gint64 response_time = g_get_monotonic_time() - self->m_downstream_request_complete_time;
     NOISY_MSG_("response time %zd usec", response_time);
+    if (self->m_downstream_end_stream)
+    {
+        rp_detector_host_monitor_put_response_time(
+            rp_host_description_outlier_detector(rp_upstream_request_upstream_host(upstream_request)),
+            response_time / 1000);
+    }
 
     //TODO...
 
@@ -194,11 +250,13 @@ on_destroy_i(RpStreamFilterBase* self)
     RpRouterFilter* me = RP_ROUTER_FILTER(self);
     //TODO...
 
+    collapsed_forwarding_on_destroy(me);
     reset_all(me);
 
     //TODO...
 
     cleanup(me);
+    g_clear_object(&me->m_hedge_timer);
 }
 
 static RpLocalErrorStatus_e
@@ -237,7 +295,7 @@ create_conn_pool(RpRouterFilter* self, RpThreadLocalCluster* cluster, RpHostDesc
     evhtp_proto downstream_protocol = rp_stream_info_protocol(stream_info);
     if (/*TODO...route_entry_->connectConfig().has_value()*/true)
     {
-        const char* method = evhtp_header_find(self->m_downstream_headers, RpHeaderValues.Method);
+        const char* method = rp_header_map_get_inline(self->m_downstream_headers, RpInlineHeader_Method);
         if (/*TODO...Http::HeaderUtility::isConnectUdpRequest(*downstream_headers_)*/false)
         {
             NOISY_MSG_("udp placeholder");
@@ -252,6 +310,82 @@ create_conn_pool(RpRouterFilter* self, RpThreadLocalCluster* cluster, RpHostDesc
     return rp_generic_conn_pool_factory_create_generic_conn_pool(factory, host, cluster, upstream_protocol, priority, downstream_protocol, RP_LOAD_BALANCER_CONTEXT(self));
 }
 
+static inline bool
+is_idempotent_request(evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p)", request_headers);
+    const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+    return method &&
+        (g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Get) == 0 ||
+         g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Head) == 0 ||
+         g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Options) == 0 ||
+         g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Trace) == 0);
+}
+
+static void
+on_hedge_timeout(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+
+    RpRouterFilter* self = RP_ROUTER_FILTER(arg);
+    if (self->m_downstream_response_started || !self->m_upstream_requests)
+    {
+        NOISY_MSG_("nothing to hedge");
+        return;
+    }
+
+    // Ask the load balancer for a host other than the one already in flight.
+    self->m_is_hedge = true;
+    RpHostSelectionResponse host_selection_response =
+        rp_thread_local_cluster_choose_host(self->m_thread_local_cluster, RP_LOAD_BALANCER_CONTEXT(self));
+    self->m_is_hedge = false;
+
+    RpHostDescription* host = RP_HOST_DESCRIPTION(host_selection_response.m_host);
+    if (!host || host == self->m_hedged_host)
+    {
+        LOGD("no alternate host to hedge to");
+        return;
+    }
+
+    RpGenericConnPool* generic_conn_pool = create_conn_pool(self, self->m_thread_local_cluster, host);
+    if (!generic_conn_pool)
+    {
+        LOGD("no conn pool for hedged request");
+        return;
+    }
+
+    LOGD("hedging request to host %p", host);
+    ++self->m_attempt_count;
+    RpUpstreamRequestPtr upstream_request = rp_upstream_request_new(RP_ROUTER_FILTER_INTERFACE(self),
+                                                                    g_steal_pointer(&generic_conn_pool),
+                                                                    false,
+                                                                    false,
+                                                                    self->m_allow_multiplexed_upstream_half_close);
+    self->m_upstream_requests = g_slist_prepend(self->m_upstream_requests, g_steal_pointer(&upstream_request));
+    rp_upstream_request_accept_headers_from_router(self->m_upstream_requests->data, true);
+}
+
+static void
+maybe_start_hedge_timer(RpRouterFilter* self, RpHostDescription* host, evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p, %p, %p)", self, host, request_headers);
+
+    // Only requests that can be replayed verbatim are hedged: idempotent
+    // methods whose request is complete once the headers are decoded.
+    gint64 hedge_delay = rp_route_entry_hedge_delay(self->m_route_entry);
+    if (hedge_delay <= 0 || !is_idempotent_request(request_headers))
+    {
+        return;
+    }
+
+    self->m_hedged_host = host;
+    if (!self->m_hedge_timer)
+    {
+        self->m_hedge_timer = rp_dispatcher_create_timer(DISPATCHER(self), on_hedge_timeout, self);
+    }
+    rp_timer_enable_timer(self->m_hedge_timer, hedge_delay);
+}
+
 static RpFilterHeadersStatus_e
 continue_decode_headers(RpRouterFilter* self, RpThreadLocalCluster* cluster, evhtp_headers_t* request_headers, bool end_stream,
                         modify_headers_cb modify_headers, bool* should_continue_decoding,
@@ -269,7 +403,7 @@ continue_decode_headers(RpRouterFilter* self, RpThreadLocalCluster* cluster, evh
         return RpFilterHeadersStatus_StopIteration;
     }
 
-    IF_NOISY_(RpHostDescriptionConstSharedPtr host = rp_generic_conn_pool_host(generic_conn_pool);)
+    RpHostDescriptionConstSharedPtr host = rp_generic_conn_pool_host(generic_conn_pool);
     NOISY_MSG_("host %p", host);
 
     RpStreamInfo* stream_info = rp_stream_filter_callbacks_stream_info(RP_STREAM_FILTER_CALLBACKS(self->m_callbacks));
@@ -291,6 +425,7 @@ continue_decode_headers(RpRouterFilter* self, RpThreadLocalCluster* cluster, evh
     {
         NOISY_MSG_("on_request_complete(%p)", self);
         on_request_complete(self);
+        maybe_start_hedge_timer(self, (RpHostDescription*)host, request_headers);
     }
 
     if (should_continue_decoding) *should_continue_decoding = true;
@@ -298,6 +433,479 @@ continue_decode_headers(RpRouterFilter* self, RpThreadLocalCluster* cluster, evh
     return RpFilterHeadersStatus_StopIteration;
 }
 
+static RpFilterHeadersStatus_e
+start_upstream_request(RpRouterFilter* self, bool end_stream)
+{
+    NOISY_MSG_("(%p, %u)", self, end_stream);
+
+    if (end_stream)
+    {
+        // Request bodies are not buffered, so only a request that is complete
+        // at headers can be replayed on a later attempt.
+        self->m_retry_state = rp_retry_state_impl_create(rp_route_entry_retry_policy(self->m_route_entry),
+                                                            self->m_cluster,
+                                                            rp_route_entry_priority(self->m_route_entry),
+                                                            DISPATCHER(self));
+    }
+
+    RpThreadLocalCluster* cluster = self->m_thread_local_cluster;
+NOISY_MSG_("calling rp_thread_local_cluster_choose_host(%p, %p)", cluster, self);
+    RpHostSelectionResponse host_selection_response = rp_thread_local_cluster_choose_host(cluster, RP_LOAD_BALANCER_CONTEXT(self));
+    if (!host_selection_response.m_cancelable /*|| TODO....*/)
+    {
+        return continue_decode_headers(self, cluster, self->m_downstream_headers, end_stream,
+                                        default_modify_headers, NULL,
+                                        (RpHostDescriptionConstSharedPtr)host_selection_response.m_host,
+                                        host_selection_response.m_details);
+    }
+
+//TODO...async host selection
+    NOISY_MSG_("%p, returning StopIteration", self);
+    return RpFilterHeadersStatus_StopIteration;
+}
+
+// In-flight collapsed requests on this worker, keyed by collapse_key(). Values
+// are the leading filters; coalescing never crosses worker threads.
+static __thread GHashTable* collapsed_requests_ = NULL;
+
+static bool
+has_list_token(const char* value, const char* token)
+{
+    NOISY_MSG_("(%p(%s), %p(%s))", value, value, token, token);
+    g_auto(GStrv) elements = g_strsplit(value, ",", -1);
+    for (GStrv itr = elements; *itr; ++itr)
+    {
+        char* element = g_strstrip(*itr);
+        // Directives may carry an argument, e.g. private="set-cookie".
+        size_t len = strcspn(element, "= ");
+        if (len == strlen(token) && g_ascii_strncasecmp(element, token, len) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+is_collapsible_request(evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p)", request_headers);
+    const char* method = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
+    if (!method || g_ascii_strcasecmp(method, RpHeaderValues.MethodValues.Get) != 0)
+    {
+        return false;
+    }
+    // Requests carrying credentials, or insisting on a fresh response, always
+    // get an upstream fetch of their own.
+    if (rp_header_map_find(request_headers, RpCustomHeaderValues.Authorization) ||
+        rp_header_map_find(request_headers, RpHeaderValues.Cookie))
+    {
+        return false;
+    }
+    const char* cache_control = rp_header_map_find(request_headers, RpCustomHeaderValues.CacheControl);
+    return !cache_control ||
+        (!has_list_token(cache_control, RpCustomHeaderValues.CacheControlValues.NoCache) &&
+         !has_list_token(cache_control, RpCustomHeaderValues.CacheControlValues.NoStore));
+}
+
+static bool
+is_shareable_response(evhtp_headers_t* response_headers)
+{
+    NOISY_MSG_("(%p)", response_headers);
+    if (rp_header_map_find(response_headers, RpHeaderValues.SetCookie))
+    {
+        return false;
+    }
+    const char* cache_control = rp_header_map_find(response_headers, RpCustomHeaderValues.CacheControl);
+    if (cache_control &&
+        (has_list_token(cache_control, RpCustomHeaderValues.CacheControlValues.Private) ||
+         has_list_token(cache_control, RpCustomHeaderValues.CacheControlValues.NoStore) ||
+         has_list_token(cache_control, RpCustomHeaderValues.CacheControlValues.NoCache)))
+    {
+        return false;
+    }
+    // The collapse key covers accept-encoding, a response varying on anything
+    // else may not be right for the followers.
+    const char* vary = rp_header_map_find(response_headers, RpCustomHeaderValues.Vary);
+    if (vary)
+    {
+        g_auto(GStrv) elements = g_strsplit(vary, ",", -1);
+        for (GStrv itr = elements; *itr; ++itr)
+        {
+            if (g_ascii_strcasecmp(g_strstrip(*itr), RpCustomHeaderValues.AcceptEncoding) != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static char*
+collapse_key(RpRouterFilter* self, evhtp_headers_t* request_headers)
+{
+    NOISY_MSG_("(%p, %p)", self, request_headers);
+    const char* authority = rp_header_map_get_inline(request_headers, RpInlineHeader_Authority);
+    if (!authority)
+    {
+        authority = rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy);
+    }
+    const char* path = rp_header_map_get_inline(request_headers, RpInlineHeader_Path);
+    const char* accept_encoding = rp_header_map_find(request_headers, RpCustomHeaderValues.AcceptEncoding);
+    return g_strdup_printf("%s\n%s\n%s\n%s",
+                            rp_route_entry_cluster_name(self->m_route_entry),
+                            authority ? authority : "",
+                            path ? path : "",
+                            accept_encoding ? accept_encoding : "");
+}
+
+static void
+register_collapsed_request(RpRouterFilter* self, char* key)
+{
+    NOISY_MSG_("(%p, %p(%s))", self, key, key);
+    if (!collapsed_requests_)
+    {
+        collapsed_requests_ = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    }
+    g_hash_table_insert(collapsed_requests_, g_strdup(key), self);
+    self->m_collapse_key = key;
+}
+
+static void
+unregister_collapsed_request(RpRouterFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    if (!self->m_collapse_key)
+    {
+        return;
+    }
+    if (collapsed_requests_ && g_hash_table_lookup(collapsed_requests_, self->m_collapse_key) == self)
+    {
+        g_hash_table_remove(collapsed_requests_, self->m_collapse_key);
+        if (g_hash_table_size(collapsed_requests_) == 0)
+        {
+            g_clear_pointer(&collapsed_requests_, g_hash_table_unref);
+        }
+    }
+    g_clear_pointer(&self->m_collapse_key, g_free);
+}
+
+static bool
+maybe_join_collapsed_request(RpRouterFilter* self, evhtp_headers_t* request_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, request_headers, end_stream);
+
+    if (!end_stream ||
+        !rp_route_entry_collapsed_forwarding(self->m_route_entry) ||
+        !is_collapsible_request(request_headers))
+    {
+        return false;
+    }
+
+    char* key = collapse_key(self, request_headers);
+    RpRouterFilter* leader = collapsed_requests_ ? g_hash_table_lookup(collapsed_requests_, key) : NULL;
+    if (leader)
+    {
+        LOGD("collapsing request onto %p", leader);
+        g_free(key);
+        self->m_collapsed_leader = leader;
+        self->m_downstream_end_stream = true;
+        leader->m_collapsed_followers = g_slist_append(leader->m_collapsed_followers, self);
+        rp_stream_decoder_filter_callbacks_add_downstream_watermark_callbacks(self->m_callbacks,
+                                                                            RP_DOWNSTREAM_WATERMARK_CALLBACKS(self));
+        self->m_collapsed_watermark_callbacks_added = true;
+        return true;
+    }
+
+    register_collapsed_request(self, key);
+    return false;
+}
+
+static void
+collapsed_leader_read_disable(RpRouterFilter* self, bool disable)
+{
+    NOISY_MSG_("(%p, %u)", self, disable);
+    for (GSList* itr = self->m_upstream_requests; itr; itr = itr->next)
+    {
+        rp_upstream_request_read_disable_or_defer(RP_UPSTREAM_REQUEST(itr->data), disable);
+    }
+}
+
+// Holds the leader's upstream back while the follower's downstream is above
+// its high watermark. Nothing of the shared response is written before the
+// headers are fanned out, so earlier watermarks are only applied from then on.
+static void
+update_collapsed_backpressure(RpRouterFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpRouterFilter* leader = self->m_collapsed_leader;
+    bool disable = leader &&
+                    self->m_downstream_response_started &&
+                    self->m_collapsed_high_watermark_count > 0;
+    if (disable != self->m_collapsed_leader_read_disabled)
+    {
+        NOISY_MSG_("%s leader %p", disable ? "holding back" : "releasing", leader);
+        collapsed_leader_read_disable(leader, disable);
+        self->m_collapsed_leader_read_disabled = disable;
+    }
+}
+
+static void
+on_above_write_buffer_high_watermark_i(RpDownstreamWatermarkCallbacks* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpRouterFilter* me = RP_ROUTER_FILTER(self);
+    ++me->m_collapsed_high_watermark_count;
+    update_collapsed_backpressure(me);
+}
+
+static void
+on_below_write_buffer_low_watermark_i(RpDownstreamWatermarkCallbacks* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpRouterFilter* me = RP_ROUTER_FILTER(self);
+    if (me->m_collapsed_high_watermark_count > 0)
+    {
+        --me->m_collapsed_high_watermark_count;
+    }
+    update_collapsed_backpressure(me);
+}
+
+static void
+downstream_watermark_callbacks_iface_init(RpDownstreamWatermarkCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_above_write_buffer_high_watermark = on_above_write_buffer_high_watermark_i;
+    iface->on_below_write_buffer_low_watermark = on_below_write_buffer_low_watermark_i;
+}
+
+// The leader's upstream is done with, or gone; whatever the followers held
+// back goes with it.
+static void
+detach_collapsed_followers(RpRouterFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    for (GSList* itr = self->m_collapsed_followers; itr; itr = itr->next)
+    {
+        RpRouterFilter* follower = RP_ROUTER_FILTER(itr->data);
+        follower->m_collapsed_leader = NULL;
+        follower->m_collapsed_leader_read_disabled = false;
+    }
+    g_clear_pointer(&self->m_collapsed_followers, g_slist_free);
+}
+
+static void
+release_collapsed_followers(RpRouterFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+    GSList* followers = g_steal_pointer(&self->m_collapsed_followers);
+    for (GSList* itr = followers; itr; itr = itr->next)
+    {
+        RpRouterFilter* follower = RP_ROUTER_FILTER(itr->data);
+        LOGD("releasing collapsed request %p", follower);
+        follower->m_collapsed_leader = NULL;
+        start_upstream_request(follower, true);
+    }
+    g_slist_free(followers);
+}
+
+static void
+collapsed_forwarding_on_destroy(RpRouterFilter* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    if (self->m_collapsed_watermark_callbacks_added)
+    {
+        rp_stream_decoder_filter_callbacks_remove_downstream_watermark_callbacks(self->m_callbacks,
+                                                                                RP_DOWNSTREAM_WATERMARK_CALLBACKS(self));
+        self->m_collapsed_watermark_callbacks_added = false;
+    }
+
+    RpRouterFilter* leader = self->m_collapsed_leader;
+    if (leader)
+    {
+        if (self->m_collapsed_leader_read_disabled)
+        {
+            collapsed_leader_read_disable(leader, false);
+            self->m_collapsed_leader_read_disabled = false;
+        }
+        leader->m_collapsed_followers = g_slist_remove(leader->m_collapsed_followers, self);
+        self->m_collapsed_leader = NULL;
+        return;
+    }
+
+    unregister_collapsed_request(self);
+    if (!self->m_collapsed_followers)
+    {
+        return;
+    }
+
+    if (self->m_downstream_response_started)
+    {
+        // Mid fan out; the followers cannot be given the rest of the body.
+        GSList* followers = g_steal_pointer(&self->m_collapsed_followers);
+        for (GSList* itr = followers; itr; itr = itr->next)
+        {
+            RpRouterFilter* follower = RP_ROUTER_FILTER(itr->data);
+            follower->m_collapsed_leader = NULL;
+            follower->m_collapsed_leader_read_disabled = false;
+            rp_stream_filter_callbacks_reset_stream(RP_STREAM_FILTER_CALLBACKS(follower->m_callbacks),
+                                                    RpStreamResetReason_LocalReset,
+                                                    "collapsed_leader_reset");
+        }
+        g_slist_free(followers);
+        return;
+    }
+
+    // The leader's downstream went away before the response did; hand the
+    // fetch over to the first follower rather than letting them all loose.
+    GSList* followers = g_steal_pointer(&self->m_collapsed_followers);
+    RpRouterFilter* new_leader = RP_ROUTER_FILTER(followers->data);
+    LOGD("handing collapsed request over to %p", new_leader);
+    new_leader->m_collapsed_leader = NULL;
+    new_leader->m_collapsed_followers = g_slist_delete_link(followers, followers);
+    for (GSList* itr = new_leader->m_collapsed_followers; itr; itr = itr->next)
+    {
+        RP_ROUTER_FILTER(itr->data)->m_collapsed_leader = new_leader;
+    }
+    register_collapsed_request(new_leader, collapse_key(new_leader, new_leader->m_downstream_headers));
+    start_upstream_request(new_leader, true);
+}
+
+static evhtp_headers_t*
+copy_header_map(evhtp_headers_t* headers)
+{
+    NOISY_MSG_("(%p)", headers);
+    evhtp_headers_t* copy = rp_header_map_new();
+    evhtp_header_t* header;
+    TAILQ_FOREACH(header, headers, next)
+    {
+        rp_header_map_add_copy(copy, header->key, header->klen, header->val, header->vlen);
+    }
+    return copy;
+}
+
+// Followers may finish, and detach, while the response is fanned out to them,
+// so fan out walks a snapshot and skips those that are gone.
+static inline bool
+is_collapsed_follower(RpRouterFilter* self, RpRouterFilter* follower)
+{
+    return g_slist_find(self->m_collapsed_followers, follower) != NULL;
+}
+
+static void
+fan_out_collapsed_headers(RpRouterFilter* self, guint64 response_code, evhtp_headers_t* response_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %lu, %p, %u)", self, response_code, response_headers, end_stream);
+
+    // Requests arriving from now on would miss the headers; they start a
+    // fetch of their own.
+    unregister_collapsed_request(self);
+    if (!self->m_collapsed_followers)
+    {
+        return;
+    }
+    if (!is_shareable_response(response_headers))
+    {
+        LOGD("response is not shareable");
+        release_collapsed_followers(self);
+        return;
+    }
+
+    GSList* followers = g_slist_copy(self->m_collapsed_followers);
+    for (GSList* itr = followers; itr; itr = itr->next)
+    {
+        RpRouterFilter* follower = RP_ROUTER_FILTER(itr->data);
+        if (!is_collapsed_follower(self, follower))
+        {
+            continue;
+        }
+        follower->m_downstream_response_started = true;
+        rp_stream_info_set_response_code(STREAM_INFO(follower), response_code);
+        rp_stream_decoder_filter_callbacks_encode_headers(follower->m_callbacks,
+                                                            copy_header_map(response_headers),
+                                                            end_stream,
+                                                            "via_collapsed_upstream");
+        if (!end_stream && is_collapsed_follower(self, follower))
+        {
+            update_collapsed_backpressure(follower);
+        }
+    }
+    g_slist_free(followers);
+    if (end_stream)
+    {
+        detach_collapsed_followers(self);
+    }
+}
+
+static void
+fan_out_collapsed_data(RpRouterFilter* self, evbuf_t* data, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, data, end_stream);
+    if (!self->m_collapsed_followers)
+    {
+        return;
+    }
+
+    // Each follower gets a reference to the leader's chunk rather than a
+    // copy; the chains stay alive until the last downstream has written them.
+    size_t len = data ? evbuffer_get_length(data) : 0;
+    GSList* followers = g_slist_copy(self->m_collapsed_followers);
+    for (GSList* itr = followers; itr; itr = itr->next)
+    {
+        RpRouterFilter* follower = RP_ROUTER_FILTER(itr->data);
+        if (!is_collapsed_follower(self, follower))
+        {
+            continue;
+        }
+        evbuf_t* chunk = evbuffer_new();
+        if (len && evbuffer_add_buffer_reference(chunk, data) != 0)
+        {
+            // Chains that are themselves references cannot be shared again.
+            evbuffer_add(chunk, evbuffer_pullup(data, -1), len);
+        }
+        rp_stream_decoder_filter_callbacks_encode_data(follower->m_callbacks, chunk, end_stream);
+        evbuffer_free(chunk);
+    }
+    g_slist_free(followers);
+    if (end_stream)
+    {
+        detach_collapsed_followers(self);
+    }
+}
+
+static void
+fan_out_collapsed_trailers(RpRouterFilter* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    GSList* followers = g_slist_copy(self->m_collapsed_followers);
+    for (GSList* itr = followers; itr; itr = itr->next)
+    {
+        RpRouterFilter* follower = RP_ROUTER_FILTER(itr->data);
+        if (is_collapsed_follower(self, follower))
+        {
+            rp_stream_decoder_filter_callbacks_encode_trailers(follower->m_callbacks, copy_header_map(trailers));
+        }
+    }
+    g_slist_free(followers);
+    detach_collapsed_followers(self);
+}
+
+static void
+abort_collapsed_followers(RpRouterFilter* self, evhtp_res code, const char* details)
+{
+    NOISY_MSG_("(%p, %d, %p(%s))", self, code, details, details);
+    unregister_collapsed_request(self);
+    GSList* followers = g_steal_pointer(&self->m_collapsed_followers);
+    for (GSList* itr = followers; itr; itr = itr->next)
+    {
+        RpRouterFilter* follower = RP_ROUTER_FILTER(itr->data);
+        follower->m_collapsed_leader = NULL;
+        rp_stream_decoder_filter_callbacks_send_local_reply(follower->m_callbacks, code, NULL, NULL, details, follower);
+    }
+    g_slist_free(followers);
+}
+
 static RpFilterHeadersStatus_e
 decode_headers_i(RpStreamDecoderFilter* self, evhtp_headers_t* request_headers, bool end_stream)
 {
@@ -311,7 +919,7 @@ decode_headers_i(RpStreamDecoderFilter* self, evhtp_headers_t* request_headers,
         rp_stream_filter_callbacks_route(RP_STREAM_FILTER_CALLBACKS(me->m_callbacks)));
     if (!me->m_route)
     {
-        LOGD("no route match for URL(%s)", evhtp_header_find(request_headers, RpHeaderValues.Path));
+        LOGD("no route match for URL(%s)", rp_header_map_get_inline(request_headers, RpInlineHeader_Path));
 
         RpStreamInfo* stream_info = STREAM_INFO(me);
         rp_stream_info_set_response_flag(stream_info, RpCoreResponseFlag_NoRouteFound);
@@ -351,20 +959,15 @@ return RpFilterHeadersStatus_StopIteration;
         return RpFilterHeadersStatus_StopIteration;
     }
     rp_cluster_info_set_object(&me->m_cluster, rp_thread_local_cluster_info(cluster));
+    me->m_thread_local_cluster = cluster;
 
-NOISY_MSG_("calling rp_thread_local_cluster_choose_host(%p, %p)", cluster, self);
-    RpHostSelectionResponse host_selection_response = rp_thread_local_cluster_choose_host(cluster, RP_LOAD_BALANCER_CONTEXT(self));
-    if (!host_selection_response.m_cancelable /*|| TODO....*/)
+    if (maybe_join_collapsed_request(me, request_headers, end_stream))
     {
-        return continue_decode_headers(me, cluster, request_headers, end_stream,
-                                        modify_headers, NULL,
-                                        (RpHostDescriptionConstSharedPtr)host_selection_response.m_host,
-                                        host_selection_response.m_details);
+        NOISY_MSG_("%p, waiting on collapsed request", self);
+        return RpFilterHeadersStatus_StopIteration;
     }
 
-//TODO...async host selection
-    NOISY_MSG_("%p, returning StopIteration", self);
-    return RpFilterHeadersStatus_StopIteration;
+    return start_upstream_request(me, end_stream);
 }
 
 static RpFilterDataStatus_e
@@ -471,13 +1074,15 @@ should_select_another_host_i(RpLoadBalancerContext* self, RpHost* host)
 {
     NOISY_MSG_("(%p, %p)", self, host);
     RpRouterFilter* me = RP_ROUTER_FILTER(self);
-    if (!me->m_is_retry)
+    if (me->m_is_hedge)
+    {
+        return RP_HOST_DESCRIPTION(host) == me->m_hedged_host;
+    }
+    if (!me->m_is_retry || !me->m_retry_state)
     {
         return false;
     }
-
-    //TODO...retry_state_->should...
-return false;
+    return rp_retry_state_impl_should_select_another_host(me->m_retry_state, RP_HOST_DESCRIPTION(host));
 }
 
 static guint32
@@ -485,12 +1090,15 @@ host_selection_retry_count_i(RpLoadBalancerContext* self)
 {
     NOISY_MSG_("(%p)", self);
     RpRouterFilter* me = RP_ROUTER_FILTER(self);
-    if (!me->m_is_retry)
+    if (me->m_is_hedge)
+    {
+        return HEDGE_HOST_SELECTION_RETRY_COUNT;
+    }
+    if (!me->m_is_retry || !me->m_retry_state)
     {
         return 1;
     }
-    //TODO...retry_state_->...
-    return 1;
+    return rp_retry_state_impl_host_selection_max_attempts(me->m_retry_state);
 }
 
 static RpOverrideHost
@@ -498,7 +1106,7 @@ override_host_to_select_i(RpLoadBalancerContext* self)
 {
     NOISY_MSG_("(%p)", self);
     RpRouterFilter* me = RP_ROUTER_FILTER(self);
-    if (me->m_is_retry)
+    if (me->m_is_retry || me->m_is_hedge)
     {
         NOISY_MSG_("returning empty result");
         return RpOverrideHost_make(NULL, false);
@@ -575,10 +1183,14 @@ attempt_count_i(RpRouterFilterInterface* self)
 }
 
 static void
-on_upstream_host_selected_i(RpRouterFilterInterface* self G_GNUC_UNUSED, RpHostDescriptionConstSharedPtr host G_GNUC_UNUSED, bool pool_success)
+on_upstream_host_selected_i(RpRouterFilterInterface* self, RpHostDescriptionConstSharedPtr host, bool pool_success)
 {
     NOISY_MSG_("(%p, %p, %u)", self, host, pool_success);
-    //TODO...
+    RpRouterFilter* me = RP_ROUTER_FILTER(self);
+    if (me->m_retry_state && host)
+    {
+        rp_retry_state_impl_on_host_attempted(me->m_retry_state, host);
+    }
 
     if (!pool_success)
     {
@@ -601,12 +1213,41 @@ on_upstream_1xx_headers_i(RpRouterFilterInterface* self, evhtp_headers_t* respon
     me->m_downstream_response_started = true;
 //    me->m_final_upstream_request = g_steal_pointer(&upstream_request);
     reset_other_upstreams(me, upstream_request);
+    if (me->m_hedge_timer)
+    {
+        rp_timer_disable_timer(me->m_hedge_timer);
+    }
 
-    //TODO...rety_state_.reset();
+    reset_retry_state(me);
 
     rp_stream_decoder_filter_callbacks_encode_1xx_headers(me->m_callbacks, response_headers);
 }
 
+static void
+set_retry_status_response_flag(RpRouterFilter* self, RpRetryStatus_e retry_status)
+{
+    NOISY_MSG_("(%p, %d)", self, retry_status);
+    if (retry_status == RpRetryStatus_NoOverflow)
+    {
+        rp_stream_info_set_response_flag(STREAM_INFO(self), RpCoreResponseFlag_UpstreamOverflow);
+    }
+    else if (retry_status == RpRetryStatus_NoRetryLimitExceeded)
+    {
+        rp_stream_info_set_response_flag(STREAM_INFO(self), RpCoreResponseFlag_UpstreamRetryLimitExceeded);
+    }
+}
+
+static void
+update_outlier_detection(RpOutlierResult_e result, RpUpstreamRequest* upstream_request)
+{
+    NOISY_MSG_("(%d, %p)", result, upstream_request);
+    RpHostDescriptionConstSharedPtr host = rp_upstream_request_upstream_host(upstream_request);
+    if (host)
+    {
+        rp_detector_host_monitor_put_result(rp_host_description_outlier_detector(host), result);
+    }
+}
+
 static void
 on_upstream_headers_i(RpRouterFilterInterface* self, guint64 response_code, evhtp_headers_t* response_headers,
                         RpUpstreamRequest* upstream_request, bool end_stream)
@@ -614,15 +1255,37 @@ on_upstream_headers_i(RpRouterFilterInterface* self, guint64 response_code, evht
     NOISY_MSG_("(%p, %lu, %p, %p, %u)", self, response_code, response_headers, upstream_request, end_stream);
     RpRouterFilter* me = RP_ROUTER_FILTER(self);
 
-    me->m_modify_headers(response_headers, me);
+    rp_detector_host_monitor_put_http_response_code(
+        rp_host_description_outlier_detector(rp_upstream_request_upstream_host(upstream_request)),
+        response_code);
 
-    //TODO...retry stuff...
+    if (me->m_retry_state)
+    {
+        RpRetryStatus_e retry_status = rp_retry_state_impl_should_retry_headers(me->m_retry_state, response_code, do_retry, me);
+        if (retry_status == RpRetryStatus_Yes)
+        {
+            NOISY_MSG_("retrying response %lu", response_code);
+            ++me->m_pending_retries;
+            if (!end_stream)
+            {
+                rp_upstream_request_reset_stream(upstream_request);
+            }
+            me->m_upstream_requests = g_slist_remove(me->m_upstream_requests, upstream_request);
+            rp_dispatcher_deferred_delete_take(DISPATCHER(me), G_OBJECT(upstream_request));
+            // Ownership would otherwise pass to the active stream.
+            rp_header_map_free(response_headers);
+            return;
+        }
+        set_retry_status_response_flag(me, retry_status);
+    }
+
+    me->m_modify_headers(response_headers, me);
 
     //TODO...internal redirect stuff...
 
     //TODO...kill upstream in flight if bad response...
 
-    //TODO...reset rety state
+    reset_retry_state(me);
 
     RpStreamInfo* stream_info = rp_stream_filter_callbacks_stream_info(RP_STREAM_FILTER_CALLBACKS(me->m_callbacks));
     rp_stream_info_set_response_code(stream_info, response_code);
@@ -636,11 +1299,16 @@ on_upstream_headers_i(RpRouterFilterInterface* self, guint64 response_code, evht
             rp_upstream_request_stream_info(upstream_request)));
 //            rp_upstream_request_stream_info(me->m_final_upstream_request)));
     reset_other_upstreams(me, upstream_request);
+    if (me->m_hedge_timer)
+    {
+        rp_timer_disable_timer(me->m_hedge_timer);
+    }
     if (end_stream)
     {
         on_upstream_complete(me, upstream_request);
     }
 
+    fan_out_collapsed_headers(me, response_code, response_headers, end_stream);
     rp_stream_decoder_filter_callbacks_encode_headers(me->m_callbacks, response_headers, end_stream, "via_upstream");
 }
 
@@ -650,6 +1318,7 @@ on_upstream_trailers_i(RpRouterFilterInterface* self, evhtp_headers_t* trailers,
     NOISY_MSG_("(%p, %p, %p)", self, trailers, upstream_request);
     RpRouterFilter* me = RP_ROUTER_FILTER(self);
     on_upstream_complete(me, upstream_request);
+    fan_out_collapsed_trailers(me, trailers);
     rp_stream_decoder_filter_callbacks_encode_trailers(me->m_callbacks, trailers);
 }
 
@@ -665,15 +1334,29 @@ on_upstream_data_i(RpRouterFilterInterface* self, evbuf_t* data, RpUpstreamReque
         on_upstream_complete(me, upstream_request);
     }
 
+    fan_out_collapsed_data(me, data, end_stream);
     rp_stream_decoder_filter_callbacks_encode_data(me->m_callbacks, data, end_stream);
 }
 
 static bool
-maybe_retry_reset(RpRouterFilter* self, RpStreamResetReason_e reset_reason, RpUpstreamRequest* upstream_request/*, TODO...TimeoutRetry...*/)
+maybe_retry_reset(RpRouterFilter* self, RpStreamResetReason_e reset_reason, RpUpstreamRequest* upstream_request, bool per_try_timeout)
 {
-    NOISY_MSG_("(%p, %d, %p)", self, reset_reason, upstream_request);
-    //TODO...if (downstream_response_started_ || ...)
-return false;
+    NOISY_MSG_("(%p, %d, %p, %u)", self, reset_reason, upstream_request, per_try_timeout);
+    if (self->m_downstream_response_started || !self->m_retry_state)
+    {
+        return false;
+    }
+
+    RpRetryStatus_e retry_status = rp_retry_state_impl_should_retry_reset(self->m_retry_state, reset_reason, per_try_timeout, do_retry, self);
+    if (retry_status == RpRetryStatus_Yes)
+    {
+        ++self->m_pending_retries;
+        self->m_upstream_requests = g_slist_remove(self->m_upstream_requests, upstream_request);
+        rp_dispatcher_deferred_delete_take(DISPATCHER(self), G_OBJECT(upstream_request));
+        return true;
+    }
+    set_retry_status_response_flag(self, retry_status);
+    return false;
 }
 
 static void
@@ -698,6 +1381,11 @@ on_upstream_abort(RpRouterFilter* self, evhtp_res code, RpCoreResponseFlag_e res
 {
     NOISY_MSG_("(%p, %d, %d, %p, %u, %p(%s))",
         self, code, response_flags, body, dropped, details, details);
+    if (self->m_hedge_timer)
+    {
+        rp_timer_disable_timer(self->m_hedge_timer);
+    }
+    abort_collapsed_followers(self, code, details);
     rp_stream_decoder_filter_callbacks_send_local_reply(self->m_callbacks, code, body, /*TODO...modify_headers_*/ NULL, details, self);
 }
 
@@ -739,11 +1427,21 @@ on_upstream_reset_i(RpRouterFilterInterface* self, RpStreamResetReason_e reset_r
     bool dropped = reset_reason == RpStreamResetReason_Overflow;
     if (!dropped)
     {
-        //TODO...updateOutlierDetection(...)
+        switch (reset_reason)
+        {
+            case RpStreamResetReason_LocalConnectionFailure:
+            case RpStreamResetReason_RemoteConnectionFailure:
+            case RpStreamResetReason_ConnectionTimeout:
+                update_outlier_detection(RpOutlierResult_LocalOriginConnectFailed, upstream_request);
+                break;
+            default:
+                update_outlier_detection(RpOutlierResult_ExtOriginRequestFailed, upstream_request);
+                break;
+        }
     }
 
     RpRouterFilter* me = RP_ROUTER_FILTER(self);
-    if (maybe_retry_reset(me, reset_reason, upstream_request))
+    if (maybe_retry_reset(me, reset_reason, upstream_request, false))
     {
         NOISY_MSG_("returning");
         return;
@@ -767,6 +1465,71 @@ on_upstream_reset_i(RpRouterFilterInterface* self, RpStreamResetReason_e reset_r
     on_upstream_abort(me, error_code, response_flags, /*TODO...body*/NULL, dropped, /*TODO...details*/NULL);
 }
 
+static void
+on_per_try_timeout_i(RpRouterFilterInterface* self, RpUpstreamRequest* upstream_request)
+{
+    NOISY_MSG_("(%p, %p)", self, upstream_request);
+
+    RpRouterFilter* me = RP_ROUTER_FILTER(self);
+    update_outlier_detection(RpOutlierResult_LocalOriginTimeout, upstream_request);
+    rp_upstream_request_reset_stream(upstream_request);
+    if (maybe_retry_reset(me, RpStreamResetReason_LocalReset, upstream_request, true))
+    {
+        NOISY_MSG_("returning");
+        return;
+    }
+
+    me->m_upstream_requests = g_slist_remove(me->m_upstream_requests, upstream_request);
+    rp_dispatcher_deferred_delete_take(DISPATCHER(me), G_OBJECT(upstream_request));
+
+    if (num_requests_awaiting_headers(me) > 0 || me->m_pending_retries > 0)
+    {
+        NOISY_MSG_("returning");
+        return;
+    }
+
+    rp_stream_info_set_response_flag(STREAM_INFO(me), RpCoreResponseFlag_UpstreamRequestTimeout);
+    on_upstream_abort(me, EVHTP_RES_GWTIMEOUT, RpCoreResponseFlag_UpstreamRequestTimeout, NULL, false, "upstream_per_try_timeout");
+}
+
+static void
+do_retry(gpointer arg)
+{
+    NOISY_MSG_("(%p)", arg);
+
+    RpRouterFilter* self = RP_ROUTER_FILTER(arg);
+    g_assert(self->m_pending_retries > 0);
+    --self->m_pending_retries;
+    self->m_is_retry = true;
+
+    RpHostSelectionResponse host_selection_response =
+        rp_thread_local_cluster_choose_host(self->m_thread_local_cluster, RP_LOAD_BALANCER_CONTEXT(self));
+    RpGenericConnPool* generic_conn_pool =
+        create_conn_pool(self, self->m_thread_local_cluster, (RpHostDescriptionConstSharedPtr)host_selection_response.m_host);
+    if (!generic_conn_pool)
+    {
+        LOGD("no host to retry on");
+        if (num_requests_awaiting_headers(self) > 0 || self->m_pending_retries > 0)
+        {
+            NOISY_MSG_("returning");
+            return;
+        }
+        rp_stream_info_set_response_flag(STREAM_INFO(self), RpCoreResponseFlag_NoHealthyUpstream);
+        on_upstream_abort(self, EVHTP_RES_SERVUNAVAIL, RpCoreResponseFlag_NoHealthyUpstream, NULL, false, "no_healthy_upstream");
+        return;
+    }
+
+    LOGD("retrying request, attempt %u", self->m_attempt_count + 1);
+    ++self->m_attempt_count;
+    RpUpstreamRequestPtr upstream_request = rp_upstream_request_new(RP_ROUTER_FILTER_INTERFACE(self),
+                                                                    g_steal_pointer(&generic_conn_pool),
+                                                                    false,
+                                                                    false,
+                                                                    self->m_allow_multiplexed_upstream_half_close);
+    self->m_upstream_requests = g_slist_prepend(self->m_upstream_requests, g_steal_pointer(&upstream_request));
+    rp_upstream_request_accept_headers_from_router(self->m_upstream_requests->data, true);
+}
+
 static void
 router_filter_interface_iface_init(RpRouterFilterInterfaceInterface* iface)
 {
@@ -785,6 +1548,7 @@ router_filter_interface_iface_init(RpRouterFilterInterfaceInterface* iface)
     iface->on_upstream_trailers = on_upstream_trailers_i;
     iface->on_upstream_data = on_upstream_data_i;
     iface->on_upstream_reset = on_upstream_reset_i;
+    iface->on_per_try_timeout = on_per_try_timeout_i;
 }
 
 OVERRIDE void
@@ -796,6 +1560,9 @@ dispose(GObject* obj)
     g_clear_object(&self->m_cluster_manager);
     g_clear_object(&self->m_route);
     g_clear_object(&self->m_cluster);
+    g_clear_object(&self->m_hedge_timer);
+    g_clear_object(&self->m_retry_state);
+    collapsed_forwarding_on_destroy(self);
 //    g_clear_object(&self->m_final_upstream_request);
     g_slist_free_full(g_steal_pointer(&self->m_upstream_requests), g_object_unref);
 
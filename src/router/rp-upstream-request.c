@@ -23,8 +23,10 @@
 #include "stream_info/rp-stream-info-impl.h"
 #include "stream_info/rp-upstream-info-impl.h"
 #include "rp-filter-manager.h"
+#include "rp-header-map.h"
 #include "rp-http-filter.h"
 #include "rp-http-utility.h"
+#include "rp-outlier-detection.h"
 #include "rp-upstream-request.h"
 
 #define FILTER_CHAIN_FACTORY(s) RP_FILTER_CHAIN_FACTORY((RpClusterInfo*)s)
@@ -56,6 +58,7 @@ struct _RpUpstreamRequest {
     evhtp_headers_t* m_upstream_trailers;
     RpUpstreamToDownstream* m_upstream_interface;
     GSList/*<UpstreamCallbacks>*/* m_upstream_callbacks;
+    RpTimer* m_per_try_timeout;
 
     guint64 m_response_headers_size;
     gsize m_response_headers_count;
@@ -91,6 +94,45 @@ G_DEFINE_FINAL_TYPE_WITH_CODE(RpUpstreamRequest, rp_upstream_request, G_TYPE_OBJ
     G_IMPLEMENT_INTERFACE(RP_TYPE_GENERIC_CONNECTION_POOL_CALLBACKS, generic_connection_pool_callbacks_iface_init)
 )
 
+static void
+on_per_try_timeout(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+    RpUpstreamRequest* self = RP_UPSTREAM_REQUEST(arg);
+    LOGD("upstream per-try timeout");
+    rp_router_filter_interface_on_per_try_timeout(self->m_parent, self);
+}
+
+static void
+setup_per_try_timeout(RpUpstreamRequest* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpRouteEntry* route_entry = rp_route_route_entry(rp_stream_filter_callbacks_route(CALLBACKS(self)));
+    const RpRetryPolicy* retry_policy = rp_route_entry_retry_policy(route_entry);
+    if (!retry_policy || retry_policy->m_per_try_timeout_ms <= 0)
+    {
+        NOISY_MSG_("no per-try timeout");
+        return;
+    }
+    if (!self->m_per_try_timeout)
+    {
+        self->m_per_try_timeout = rp_dispatcher_create_timer(rp_stream_filter_callbacks_dispatcher(CALLBACKS(self)),
+                                                                on_per_try_timeout,
+                                                                self);
+    }
+    rp_timer_enable_timer(self->m_per_try_timeout, retry_policy->m_per_try_timeout_ms);
+}
+
+static inline void
+disable_per_try_timeout(RpUpstreamRequest* self)
+{
+    NOISY_MSG_("(%p)", self);
+    if (self->m_per_try_timeout)
+    {
+        rp_timer_disable_timer(self->m_per_try_timeout);
+    }
+}
+
 static void
 on_reset_stream_i(RpStreamCallbacks* self, RpStreamResetReason_e reason, const char* transport_failure_reason)
 {
@@ -98,6 +140,7 @@ on_reset_stream_i(RpStreamCallbacks* self, RpStreamResetReason_e reason, const c
     RpUpstreamRequest* me = RP_UPSTREAM_REQUEST(self);
     rp_upstream_request_clear_request_encoder(me);
     me->m_awaiting_headers = false;
+    disable_per_try_timeout(me);
 
     rp_stream_info_set_response_flag(RP_STREAM_INFO(me->m_stream_info),
         rp_router_filter_stream_reset_reason_to_response_flag(reason));
@@ -158,6 +201,8 @@ decode_headers_i(RpResponseDecoder* self, evhtp_headers_t* response_headers, boo
     //TODO...is1xx(response_code)...
 
     me->m_awaiting_headers = false;
+    // The per-try timeout bounds the wait for response headers.
+    disable_per_try_timeout(me);
     rp_stream_info_set_response_code(RP_STREAM_INFO(me->m_stream_info), response_code);
 
     maybe_handle_deferred_read_disable(me);
@@ -299,6 +344,8 @@ on_pool_ready_i(RpGenericConnectionPoolCallbacks* self, RpGenericUpstream* upstr
         rp_connection_info_provider_ssl_connection(address_provider));
 
     rp_upstream_request_on_upstream_host_selected(me, host, true);
+    rp_detector_host_monitor_put_result(rp_host_description_outlier_detector(host),
+                                        RpOutlierResult_LocalOriginConnectSuccess);
 
     //TODO...
 
@@ -309,8 +356,7 @@ on_pool_ready_i(RpGenericConnectionPoolCallbacks* self, RpGenericUpstream* upstr
 
     if (rp_router_filter_interface_downstream_end_stream(me->m_parent))
     {
-        //TODO...setupPerTryTimeout();
-        NOISY_MSG_("setupPerTryTimeout();");
+        setup_per_try_timeout(me);
     }
     else
     {
@@ -372,7 +418,7 @@ clean_up(RpUpstreamRequest* self)
 
     //TODO...if(span_ != nullptr)...
 
-    //TODO...timers
+    g_clear_object(&self->m_per_try_timeout);
 
     rp_upstream_request_clear_request_encoder(self);
 
@@ -410,6 +456,7 @@ void
 rp_upstream_request_reset_stream(RpUpstreamRequest* self)
 {
     LOGD("(%p)", self);
+    disable_per_try_timeout(self);
     if (rp_generic_conn_pool_cancel_any_pending_stream(self->m_conn_pool))
     {
         LOGD("cancelled pool request");
@@ -442,7 +489,7 @@ g_assert(!me->m_router_sent_end_stream);
     me->m_router_sent_end_stream = end_stream;
 
     evhtp_headers_t* headers = rp_router_filter_interface_downstream_headers(me->m_parent);
-    const char* method_value = evhtp_header_find(headers, RpHeaderValues.Method);
+    const char* method_value = rp_header_map_get_inline(headers, RpInlineHeader_Method);
     if (g_ascii_strcasecmp(method_value, RpHeaderValues.MethodValues.Connect) == 0)
     {
         NOISY_MSG_("CONNECT");
@@ -466,6 +513,11 @@ rp_upstream_request_accept_data_from_router(RpUpstreamRequest* self, evbuf_t* da
     me->m_router_sent_end_stream = end_stream;
 
     rp_filter_manager_decode_data(me->m_filter_manager, data, end_stream);
+    if (end_stream && me->m_create_per_try_timeout_on_request_complete)
+    {
+        me->m_create_per_try_timeout_on_request_complete = false;
+        setup_per_try_timeout(me);
+    }
 }
 
 static void
@@ -658,6 +710,11 @@ rp_upstream_request_accept_trailers_from_router(RpUpstreamRequest* self, evhtp_h
     me->m_encode_trailers = true;
 
     rp_filter_manager_decode_trailers(me->m_filter_manager, trailers);
+    if (me->m_create_per_try_timeout_on_request_complete)
+    {
+        me->m_create_per_try_timeout_on_request_complete = false;
+        setup_per_try_timeout(me);
+    }
 }
 
 RpStreamInfo*
@@ -679,6 +736,14 @@ rp_upstream_request_on_upstream_host_selected(RpUpstreamRequest* self, RpHostDes
     rp_router_filter_interface_on_upstream_host_selected(self->m_parent, host, pool_success);
 }
 
+RpHostDescriptionConstSharedPtr
+rp_upstream_request_upstream_host(RpUpstreamRequest* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(RP_IS_UPSTREAM_REQUEST(self), NULL);
+    return self->m_upstream_host;
+}
+
 void
 rp_upstream_request_clear_request_encoder(RpUpstreamRequest* self)
 {
@@ -705,7 +770,7 @@ bool
 rp_upstream_request_awaiting_headers(RpUpstreamRequest* self)
 {
     LOGD("(%p)", self);
-    g_return_val_if_fail(RP_IS_UPSTREAM_CALLBACKS(self), false);
+    g_return_val_if_fail(RP_IS_UPSTREAM_REQUEST(self), false);
     return self->m_awaiting_headers;
 }
 
@@ -75,6 +75,7 @@ RpStreamInfo* rp_upstream_request_stream_info(RpUpstreamRequest* self);
 void rp_upstream_request_on_upstream_host_selected(RpUpstreamRequest* self,
                                                     RpHostDescriptionConstSharedPtr host,
                                                     bool pool_success);
+RpHostDescriptionConstSharedPtr rp_upstream_request_upstream_host(RpUpstreamRequest* self);
 void rp_upstream_request_clear_request_encoder(RpUpstreamRequest* self);
 bool rp_upstream_request_encode_complete(RpUpstreamRequest* self);
 bool rp_upstream_request_awaiting_headers(RpUpstreamRequest* self);
@@ -624,6 +624,64 @@ struct _RpPreconnectPolicyCfg {
     double predictive_preconnect_ratio; // lte 3.0, gte 1.0;
 };
 
+/**
+ * RpHttp2ProtocolOptionsCfg (config/core/v3/protocol.proto)
+ */
+typedef struct _RpHttp2ProtocolOptionsCfg RpHttp2ProtocolOptionsCfg;
+struct _RpHttp2ProtocolOptionsCfg {
+    guint32 max_concurrent_streams; // default 2147483647;
+    guint32 initial_stream_window_size; // default 268435456, gte 65535;
+    guint32 initial_connection_window_size; // default 268435456, gte 65535;
+};
+
+/**
+ * RpRetryBudgetCfg (config/cluster/v3/circuit_breaker.proto)
+ */
+typedef struct _RpRetryBudgetCfg RpRetryBudgetCfg;
+struct _RpRetryBudgetCfg {
+    double budget_percent; // default 20.0;
+    guint32 min_retry_concurrency; // default 3;
+};
+
+/**
+ * RpOutlierDetectionCfg (config/cluster/v3/outlier_detection.proto)
+ */
+typedef struct _RpOutlierDetectionCfg RpOutlierDetectionCfg;
+struct _RpOutlierDetectionCfg {
+    guint32 consecutive_5xx; // default 5;
+    guint32 consecutive_gateway_failure; // default 5;
+    guint32 consecutive_local_origin_failure; // default 5;
+    guint64 interval_ms; // default 10000ms;
+    guint64 base_ejection_time_ms; // default 30000ms;
+    guint64 max_ejection_time_ms; // default 300000ms;
+    guint32 max_ejection_percent; // default 10;
+    guint32 success_rate_minimum_hosts; // default 5;
+    guint32 success_rate_request_volume; // default 100;
+    double success_rate_stdev_factor; // default 1.9;
+    // Custom.
+    double latency_threshold_factor; // default 3.0;
+};
+
+/**
+ * RpHealthCheckCfg (config/core/v3/health_check.proto)
+ */
+typedef enum {
+    RpHealthCheckerType_TCP,
+    RpHealthCheckerType_HTTP
+} RpHealthCheckerType_e;
+
+typedef struct _RpHealthCheckCfg RpHealthCheckCfg;
+struct _RpHealthCheckCfg {
+    RpHealthCheckerType_e type;
+    guint64 timeout_ms; // default 1000ms;
+    guint64 interval_ms; // default 5000ms;
+    guint64 interval_jitter_ms; // default 1000ms;
+    guint32 unhealthy_threshold; // default 3;
+    guint32 healthy_threshold; // default 2;
+    // HttpHealthCheck.
+    char path[512]; // default "/";
+};
+
 /**
  * RpClusterCfg - Configuration for a single upstream cluster.
  */
@@ -644,8 +702,16 @@ struct _RpClusterCfg {
     RpLoadBalancingPolicyCfg load_balancing_policy;
     //TODO..RpLbSubsetCfg lb_subset_config;
     RpMetadataConstSharedPtr metadata;
+    RpHttp2ProtocolOptionsCfg http2_protocol_options;
+    RpRetryBudgetCfg retry_budget;
+    RpOutlierDetectionCfg outlier_detection;
+    RpHealthCheckCfg health_check;
     bool connection_pool_per_downstream_connection; // default: false;
     bool load_balancing_policy_set; // default: false;
+    bool http2_protocol_options_set; // default: false;
+    bool retry_budget_set; // default: false;
+    bool outlier_detection_set; // default: false;
+    bool health_check_set; // default: false;
 
     // Custom.
     rule_t* rule;
@@ -756,6 +822,12 @@ rp_cluster_cfg_lb_policy(const RpClusterCfg* self)
     return self->lb_policy;
 }
 
+static inline RpDnsLookupFamily_e
+rp_cluster_cfg_dns_lookup_family(const RpClusterCfg* self)
+{
+    return self->dns_lookup_family;
+}
+
 static inline bool
 rp_cluster_cfg_has_load_balancing_policy(const RpClusterCfg* self)
 {
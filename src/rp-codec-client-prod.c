@@ -14,12 +14,16 @@
 #endif
 
 #include "http1/rp-http1-client-connection-impl.h"
+#include "http2/rp-http2-client-connection-impl.h"
 #include "rp-conn-manager-config.h"
+#include "rp-upstream.h"
 #include "rp-codec-client-prod.h"
 
 struct _RpCodecClientProd {
     RpCodecClient parent_instance;
 
+    // Referenced by the HTTP/2 codec for its lifetime.
+    struct RpHttp2Settings_s m_http2_settings;
 };
 
 G_DEFINE_FINAL_TYPE(RpCodecClientProd, rp_codec_client_prod, RP_TYPE_CODEC_CLIENT)
@@ -46,10 +50,28 @@ rp_codec_client_prod_init(RpCodecClientProd* self G_GNUC_UNUSED)
     NOISY_MSG_("(%p)", self);
 }
 
+static const struct RpHttp2Settings_s*
+init_http2_settings(RpCodecClientProd* self, RpHostDescriptionConstSharedPtr host)
+{
+    NOISY_MSG_("(%p, %p)", self, host);
+
+    self->m_http2_settings = RpHttp2Settings;
+
+    RpClusterInfoConstSharedPtr cluster = host ? rp_host_description_cluster(host) : NULL;
+    const RpHttp2ProtocolOptionsCfg* options = cluster ? rp_cluster_info_http2_options(cluster) : NULL;
+    if (options)
+    {
+        self->m_http2_settings.m_max_concurrent_streams = options->max_concurrent_streams;
+        self->m_http2_settings.m_initial_stream_window_size = options->initial_stream_window_size;
+        self->m_http2_settings.m_initial_connection_window_size = options->initial_connection_window_size;
+    }
+    return &self->m_http2_settings;
+}
+
 static inline RpCodecClientProd*
-constructed(RpCodecClientProd* self, RpNetworkClientConnection* connection, bool should_connect)
+constructed(RpCodecClientProd* self, RpNetworkClientConnection* connection, RpHostDescriptionConstSharedPtr host, bool should_connect)
 {
-    NOISY_MSG_("(%p, %p, %u)", self, connection, should_connect);
+    NOISY_MSG_("(%p, %p, %p, %u)", self, connection, host, should_connect);
 
     RpHttpClientConnection* codec = NULL;
 
@@ -66,7 +88,11 @@ constructed(RpCodecClientProd* self, RpNetworkClientConnection* connection, bool
             );
             break;
         case RpCodecType_HTTP2:
-            g_info("%s:%s - not implemented [%d]", __FILE__, __func__, __LINE__);
+            codec = RP_HTTP_CLIENT_CONNECTION(
+                rp_http2_client_connection_impl_new(RP_NETWORK_CONNECTION(connection),
+                                                    RP_HTTP_CONNECTION_CALLBACKS(self),
+                                                    init_http2_settings(self, host))
+            );
             break;
         case RpCodecType_HTTP3:
             g_info("%s:%s - not implemented [%d]", __FILE__, __func__, __LINE__);
@@ -96,5 +122,5 @@ rp_codec_client_prod_new(RpCodecType_e type, RpNetworkClientConnection* connecti
                                             "host", host,
                                             "dispatcher", dispatcher,
                                             NULL);
-    return constructed(self, connection, should_connect_on_creation);
+    return constructed(self, connection, host, should_connect_on_creation);
 }
@@ -158,7 +158,7 @@ on_go_away_i(RpHttpConnectionCallbacks* self, RpGoAwayErrorCode_e error_code)
 {
     NOISY_MSG_("(%p, %d)", self, error_code);
     RpHttpConnectionCallbacks* callbacks = PRIV(self)->m_codec_callbacks;
-    if (callbacks) rp_http_connection_callbacks_on_go_away(self, error_code);
+    if (callbacks) rp_http_connection_callbacks_on_go_away(callbacks, error_code);
 }
 
 static void
@@ -166,7 +166,7 @@ on_max_streams_changed_i(RpHttpConnectionCallbacks* self, guint32 num_streams)
 {
     NOISY_MSG_("(%p, %u)", self, num_streams);
     RpHttpConnectionCallbacks* callbacks = PRIV(self)->m_codec_callbacks;
-    if (callbacks) rp_http_connection_callbacks_on_max_streams_changed(self, num_streams);
+    if (callbacks) rp_http_connection_callbacks_on_max_streams_changed(callbacks, num_streams);
 }
 
 static void
@@ -174,7 +174,7 @@ on_settings_i(RpHttpConnectionCallbacks* self, RpReceivedSettings* settings)
 {
     NOISY_MSG_("(%p, %p)", self, settings);
     RpHttpConnectionCallbacks* callbacks = PRIV(self)->m_codec_callbacks;
-    if (callbacks) rp_http_connection_callbacks_on_settings(self, settings);
+    if (callbacks) rp_http_connection_callbacks_on_settings(callbacks, settings);
 }
 
 static void
@@ -322,6 +322,14 @@ rp_codec_client_set_codec_connection_callbacks(RpCodecClient* self, RpHttpConnec
     PRIV(self)->m_codec_callbacks = callbacks;
 }
 
+void
+rp_codec_client_set_codec_client_callbacks(RpCodecClient* self, RpCodecClientCallbacks* callbacks)
+{
+    LOGD("(%p, %p)", self, callbacks);
+    g_return_if_fail(RP_IS_CODEC_CLIENT(self));
+    PRIV(self)->m_codec_client_callbacks = callbacks;
+}
+
 void
 rp_codec_client_go_away(RpCodecClient* self)
 {
@@ -459,7 +467,10 @@ rp_codec_client_on_data(RpCodecClient* self, evbuf_t* data)
 
     if (status != RpStatusCode_Ok)
     {
-        //TODO...
+        LOGD("Error dispatching received data: %d", status);
+        // Active requests are reset from on_event() once the close lands.
+        me->m_protocol_error = true;
+        rp_network_connection_close(RP_NETWORK_CONNECTION(me->m_connection), RpNetworkConnectionCloseType_NoFlush);
     }
 }
 
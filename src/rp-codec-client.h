@@ -72,6 +72,8 @@ struct _RpCodecClientClass {
 
 void rp_codec_client_set_codec_connection_callbacks(RpCodecClient* self,
                                             RpHttpConnectionCallbacks* callbacks);
+void rp_codec_client_set_codec_client_callbacks(RpCodecClient* self,
+                                            RpCodecClientCallbacks* callbacks);
 void rp_codec_client_go_away(RpCodecClient* self);
 evhtp_proto rp_codec_client_protocol(RpCodecClient* self);
 RpRequestEncoder* rp_codec_client_new_stream(RpCodecClient* self,
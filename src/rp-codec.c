@@ -42,9 +42,20 @@ struct RpHttp1Settings_s RpHttp1Settings = {
     .m_validate_sheme = false,
     .m_send_fully_qualified_url = false,
     .m_use_balsa_parser = false,
+    .m_use_fast_parser = false,
     .m_allow_custom_methods = false
 };
 
+struct RpHttp2Settings_s RpHttp2Settings = {
+    .m_hpack_table_size = 4096,
+    .m_max_concurrent_streams = 2147483647,
+    // Sized to match the default per-connection buffer limit so that a slow
+    // reader back-pressures the peer instead of growing our buffers.
+    .m_initial_stream_window_size = 1024 * 1024,
+    .m_initial_connection_window_size = 16 * 1024 * 1024,
+    .m_allow_connect = false
+};
+
 G_DEFINE_INTERFACE(RpStreamEncoder, rp_stream_encoder, G_TYPE_OBJECT)
 G_DEFINE_INTERFACE(RpRequestEncoder, rp_request_encoder, RP_TYPE_STREAM_ENCODER)
 G_DEFINE_INTERFACE(RpResponseEncoder, rp_response_encoder, RP_TYPE_STREAM_ENCODER)
@@ -24,6 +24,11 @@ typedef enum {
 GType RpCodecType_e_get_type(void) G_GNUC_CONST;
 #define RP_TYPE_CODEC_TYPE (RpCodecType_e_get_type())
 
+// evhtp only knows about HTTP/1.x; HTTP/2 codecs report this value.
+#ifndef EVHTP_PROTO_2
+#define EVHTP_PROTO_2 ((evhtp_proto)(EVHTP_PROTO_11 + 1))
+#endif
+
 
 /**
  * Status codes for representing classes of Envoy errors.
@@ -455,6 +460,13 @@ struct _RpReceivedSettingsInterface {
     guint32 (*max_concurrent_streams)(RpReceivedSettings*);
 };
 
+static inline guint32
+rp_received_settings_max_concurrent_streams(RpReceivedSettings* self)
+{
+    return RP_IS_RECEIVED_SETTINGS(self) ?
+        RP_RECEIVED_SETTINGS_GET_IFACE(self)->max_concurrent_streams(self) : G_MAXUINT32;
+}
+
 /**
  * Connection level callbacks.
  */
@@ -519,10 +531,23 @@ struct RpHttp1Settings_s {
     bool m_validate_sheme;//false
     bool m_send_fully_qualified_url;//false
     bool m_use_balsa_parser;//false
+    bool m_use_fast_parser;//false
     bool m_allow_custom_methods;//false
 };
 extern struct RpHttp1Settings_s RpHttp1Settings;
 
+/**
+ * HTTP/2 Codec settings
+ */
+struct RpHttp2Settings_s {
+    guint32 m_hpack_table_size;//4096
+    guint32 m_max_concurrent_streams;//2147483647
+    guint32 m_initial_stream_window_size;//1048576
+    guint32 m_initial_connection_window_size;//16777216
+    bool m_allow_connect;//false
+};
+extern struct RpHttp2Settings_s RpHttp2Settings;
+
 /**
  * A connection (client or server) that owns multiple streams.
  */
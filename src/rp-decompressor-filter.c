@@ -21,6 +21,7 @@
 #endif
 
 #include "rproxy.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-input-stream.h"
 #include "rp-decompressor-filter.h"
@@ -34,7 +35,7 @@
     rp_stream_filter_callbacks_stream_info(STREAM_FILTER_CALLBACKS(s))
 #define FILTER_STATE(s) rp_stream_info_filter_state(STREAM_INFO(s))
 #define REWRITE_URLS(s) \
-    rp_filter_state_get_data(FILTER_STATE(s), rewrite_urls_key)
+    rp_filter_state_get_slot_data(FILTER_STATE(s), rewrite_urls_slot)
 
 typedef struct RpDetails * RpDetails;
 struct RpDetails {
@@ -97,8 +98,7 @@ create_istream(evhtp_headers_t* headers, enc_type type)
 if (type != enc_type_none)
 {
     NOISY_MSG_("removing content-encoding header");
-    evhtp_header_t* header = evhtp_headers_find_header(headers, "Content-encoding");
-    evhtp_header_rm_and_free(headers, header);
+    rp_header_map_remove_inline(headers, RpInlineHeader_ContentEncoding);
 }
 
     NOISY_MSG_("allocated input stream %p", istream);
@@ -209,7 +209,7 @@ get_enc_type(evhtp_headers_t* headers, bool rewriting_urls)
     }
 
     NOISY_MSG_("checking content-encoding");
-    return util_get_enc_type(evhtp_header_find(headers, RpCustomHeaderValues.ContentEncoding));
+    return util_get_enc_type(rp_header_map_get_inline(headers, RpInlineHeader_ContentEncoding));
 }
 
 static void
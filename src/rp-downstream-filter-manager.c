@@ -13,6 +13,7 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "router/rp-router-filter-interface.h"
 #include "stream_info/rp-stream-info-impl.h"
@@ -179,48 +180,49 @@ int_to_string(int val, char* buf, size_t buf_size)
 }
 
 static inline evhtp_header_t*
-create_status_header(evhtp_res code)
+add_status_header(evhtp_headers_t* headers, evhtp_res code)
 {
     char buf[256];
-    return evhtp_header_new(RpHeaderValues.Status,
-                            int_to_string(code, buf, sizeof(buf)),
-                            0,/*no copy name*/
-                            1/*copy value*/);
+    return rp_header_map_add_header(headers,
+                                    RpHeaderValues.Status,
+                                    int_to_string(code, buf, sizeof(buf)),
+                                    0,/*no copy name*/
+                                    1/*copy value*/);
 }
 
 static inline const char*
 get_content_type(evhtp_headers_t* headers)
 {
     NOISY_MSG_("(%p)", headers);
-    return evhtp_kv_find(headers, RpHeaderValues.ContentType);
+    return rp_header_map_get_inline(headers, RpInlineHeader_ContentType);
 }
 
 static inline void
 remove_content_type(evhtp_headers_t* headers)
 {
     NOISY_MSG_("(%p)", headers);
-    evhtp_header_rm_and_free(headers,
-        evhtp_headers_find_header(headers, RpHeaderValues.ContentType));
+    rp_header_map_remove(headers,
+        rp_header_map_get_inline_header(headers, RpInlineHeader_ContentType));
 }
 
 static inline evhtp_header_t*
-create_reference_content_type_header(const char* content_type)
+add_reference_content_type_header(evhtp_headers_t* headers, const char* content_type)
 {
-    NOISY_MSG_("(%p(%s))", content_type, content_type);
-    return evhtp_header_new(RpHeaderValues.ContentType,
-                            content_type,
-                            0,/*no copy name*/
-                            0/*no copy value*/);
+    NOISY_MSG_("(%p, %p(%s))", headers, content_type, content_type);
+    return rp_header_map_add_header(headers,
+                                    RpHeaderValues.ContentType,
+                                    content_type,
+                                    0,/*no copy name*/
+                                    0/*no copy value*/);
 }
 
 static inline void
 set_reference_content_type(evhtp_headers_t* headers, const char* content_type)
 {
     NOISY_MSG_("(%p, %p(%s))", headers, content_type, content_type);
-    evhtp_header_rm_and_free(headers,
-        evhtp_headers_find_header(headers, RpHeaderValues.ContentType));
-    evhtp_headers_add_header(headers,
-        create_reference_content_type_header(content_type));
+    rp_header_map_remove(headers,
+        rp_header_map_get_inline_header(headers, RpInlineHeader_ContentType));
+    add_reference_content_type_header(headers, content_type);
 }
 
 static inline char*
@@ -231,29 +233,29 @@ size_to_string(size_t val, char* buf, size_t buf_size)
 }
 
 static inline evhtp_header_t*
-create_content_length_header(size_t content_length)
+add_content_length_header(evhtp_headers_t* headers, size_t content_length)
 {
     char buf[256];
-    return evhtp_header_new(RpHeaderValues.ContentLength,
-                            size_to_string(content_length, buf, sizeof(buf)),
-                            0,/*no copy name*/
-                            1/*copy value*/);
+    return rp_header_map_add_header(headers,
+                                    RpHeaderValues.ContentLength,
+                                    size_to_string(content_length, buf, sizeof(buf)),
+                                    0,/*no copy name*/
+                                    1/*copy value*/);
 }
 
 static inline void
 set_content_length(evhtp_headers_t* headers, size_t content_length)
 {
-    evhtp_header_rm_and_free(headers,
-        evhtp_headers_find_header(headers, RpHeaderValues.ContentLength));
-    evhtp_headers_add_header(headers,
-        create_content_length_header(content_length));
+    rp_header_map_remove(headers,
+        rp_header_map_get_inline_header(headers, RpInlineHeader_ContentLength));
+    add_content_length_header(headers, content_length);
 }
 
 static inline void
 remove_content_length(evhtp_headers_t* headers)
 {
-    evhtp_header_rm_and_free(headers,
-        evhtp_headers_find_header(headers, RpHeaderValues.ContentLength));
+    rp_header_map_remove(headers,
+        rp_header_map_get_inline_header(headers, RpInlineHeader_ContentLength));
 }
 
 static RpPreparedLocalReplyPtr
@@ -266,8 +268,8 @@ utility_prepare_local_reply(const struct RpEncodeFunctions* encode_functions,
     evbuf_t* body_text = local_reply_data->m_body_text;
     const char* content_type = RpHeaderValues.ContentTypeValues.Text;
 
-    evhtp_headers_t* response_headers = evhtp_headers_new();
-    evhtp_headers_add_header(response_headers, create_status_header(response_code));
+    evhtp_headers_t* response_headers = rp_header_map_new();
+    add_status_header(response_headers, response_code);
 
     if (encode_functions->m_modify_headers)
     {
@@ -20,6 +20,7 @@
 #include "dynamic_forward_proxy/rp-cluster.h"
 #include "rp-cluster-store.h"
 #include "rp-filter-chain-factory-callbacks-impl.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-http-conn-manager-impl.h"
 #include "rp-http-conn-mgr-impl-active-stream.h"
@@ -89,7 +90,7 @@ load_dynamic_cluster(RpDynamicForwardProxy* self, RpDfpCluster* cluster, evhtp_h
 {
     NOISY_MSG_("(%p, %p, %p, %u)", self, cluster, request_headers, default_port);
 
-    RpAuthorityAttributes host_attributes = http_utility_parse_authority(evhtp_header_find(request_headers, RpHeaderValues.HostLegacy));
+    RpAuthorityAttributes host_attributes = http_utility_parse_authority(rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy));
 
     guint16 port = host_attributes.m_port ? host_attributes.m_port : default_port;
 
@@ -98,16 +99,16 @@ load_dynamic_cluster(RpDynamicForwardProxy* self, RpDfpCluster* cluster, evhtp_h
 
     //TODO...applyFilterStateOverrides(...)
 
-    rp_filter_state_set_data(FILTER_STATE(self),
-                                dynamic_host_key,
-                                self->m_host,
-                                RpFilterStateStateType_ReadOnly,
-                                RpFilterStateLifeSpan_Request);
-    rp_filter_state_set_data(FILTER_STATE(self),
-                                dynamic_port_key,
-                                self->m_port,
-                                RpFilterStateStateType_ReadOnly,
-                                RpFilterStateLifeSpan_Request);
+    rp_filter_state_set_slot_data(FILTER_STATE(self),
+                                     dynamic_host_slot,
+                                     self->m_host,
+                                     RpFilterStateStateType_ReadOnly,
+                                     RpFilterStateLifeSpan_Request);
+    rp_filter_state_set_slot_data(FILTER_STATE(self),
+                                     dynamic_port_slot,
+                                     self->m_port,
+                                     RpFilterStateStateType_ReadOnly,
+                                     RpFilterStateLifeSpan_Request);
 
     g_autoptr(GString) cluster_name = g_string_new("DFPCluster:");
     g_string_append_printf(cluster_name, "%s:%u", self->m_host, port);
@@ -13,6 +13,7 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-filter-factory.h"
 #include "rp-filter-chain-factory-callbacks-impl.h"
@@ -1232,7 +1233,7 @@ rp_filter_manager_add_encoded_trailers(RpFilterManager* self)
 {
     g_return_val_if_fail(RP_IS_FILTER_MANAGER(self), NULL);
     RpFilterManagerPrivate* me = PRIV(self);
-    rp_filter_manager_callbacks_set_response_trailers(me->m_filter_manager_callbacks, evhtp_headers_new());
+    rp_filter_manager_callbacks_set_response_trailers(me->m_filter_manager_callbacks, rp_header_map_new());
     return rp_filter_manager_callbacks_response_trailers(me->m_filter_manager_callbacks);
 }
 
@@ -1506,7 +1507,7 @@ rp_filter_manager_request_headers_initialized(RpFilterManager* self)
     g_return_if_fail(RP_IS_FILTER_MANAGER(self));
     RpFilterManagerPrivate* me = PRIV(self);
     evhtp_headers_t* headers = rp_filter_manager_callbacks_request_headers(me->m_filter_manager_callbacks);
-    const char* method_value = evhtp_header_find(headers, RpHeaderValues.Method);
+    const char* method_value = rp_header_map_get_inline(headers, RpInlineHeader_Method);
     if (method_value && g_ascii_strcasecmp(method_value, RpHeaderValues.MethodValues.Head) == 0)
     {
         me->m_state.m_is_head_request = true;
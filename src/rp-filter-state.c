@@ -22,6 +22,77 @@
 
 G_DEFINE_INTERFACE(RpFilterState, rp_filter_state, G_TYPE_OBJECT)
 
+// Slot registry. Written only while the server is starting up; read without
+// locking by the workers afterwards.
+G_LOCK_DEFINE_STATIC(slot_registry);
+static const char* slot_names[RP_FILTER_STATE_MAX_SLOTS];
+static gint n_slots = 0;
+
+static inline RpFilterStateSlot
+find_slot(const char* data_name, gint count)
+{
+    // Keys are normally the same global pointers, so try those first.
+    for (gint i = 0; i < count; ++i)
+    {
+        if (slot_names[i] == data_name)
+        {
+            return i;
+        }
+    }
+    for (gint i = 0; i < count; ++i)
+    {
+        if (g_str_equal(slot_names[i], data_name))
+        {
+            return i;
+        }
+    }
+    return RP_FILTER_STATE_SLOT_INVALID;
+}
+
+RpFilterStateSlot
+rp_filter_state_slot_register(const char* data_name)
+{
+    LOGD("(%p(%s))", data_name, data_name);
+
+    g_return_val_if_fail(data_name != NULL, RP_FILTER_STATE_SLOT_INVALID);
+
+    G_LOCK(slot_registry);
+    gint count = g_atomic_int_get(&n_slots);
+    RpFilterStateSlot slot = find_slot(data_name, count);
+    if (slot == RP_FILTER_STATE_SLOT_INVALID)
+    {
+        if (count < RP_FILTER_STATE_MAX_SLOTS)
+        {
+            slot = count;
+            slot_names[slot] = data_name;
+            g_atomic_int_set(&n_slots, count + 1);
+        }
+        else
+        {
+            LOGE("no free filter state slot for %s", data_name);
+        }
+    }
+    G_UNLOCK(slot_registry);
+
+    NOISY_MSG_("slot %d", slot);
+    return slot;
+}
+
+RpFilterStateSlot
+rp_filter_state_slot_lookup(const char* data_name)
+{
+    NOISY_MSG_("(%p(%s))", data_name, data_name);
+    return data_name ?
+        find_slot(data_name, g_atomic_int_get(&n_slots)) : RP_FILTER_STATE_SLOT_INVALID;
+}
+
+const char*
+rp_filter_state_slot_name(RpFilterStateSlot slot)
+{
+    NOISY_MSG_("(%d)", slot);
+    return slot >= 0 && slot < g_atomic_int_get(&n_slots) ? slot_names[slot] : NULL;
+}
+
 static void
 rp_filter_state_default_init(RpFilterStateInterface* iface G_GNUC_UNUSED)
 {
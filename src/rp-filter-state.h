@@ -26,6 +26,20 @@ typedef enum
     RpFilterStateLifeSpan_TopSpan = RpFilterStateLifeSpan_Connection
 } RpFilterStateLifeSpan_e;
 
+/**
+ * Integer handle for a well-known filter state key. Slots are assigned once at
+ * startup by rp_filter_state_slot_register() and are then used to index a
+ * small inline array in each filter state instead of hashing the key string.
+ */
+typedef gint RpFilterStateSlot;
+
+#define RP_FILTER_STATE_SLOT_INVALID -1
+#define RP_FILTER_STATE_MAX_SLOTS 16
+
+RpFilterStateSlot rp_filter_state_slot_register(const char* data_name);
+RpFilterStateSlot rp_filter_state_slot_lookup(const char* data_name);
+const char* rp_filter_state_slot_name(RpFilterStateSlot slot);
+
 /**
  * FilterState represents dynamically generated information regarding a stream (TCP or HTTP level)
  * or a connection by various filters in Envoy. FilterState can be write-once or write-many.
@@ -47,6 +61,12 @@ struct _RpFilterStateInterface {
                                             RpFilterStateLifeSpan_e);
     RpFilterStateLifeSpan_e (*life_span)(RpFilterState*);
     RpFilterState* (*parent)(RpFilterState*);
+    void (*set_slot_data)(RpFilterState*,
+                            RpFilterStateSlot,
+                            gpointer,
+                            RpFilterStateStateType_e,
+                            RpFilterStateLifeSpan_e);
+    gpointer (*get_slot_data)(RpFilterState*, RpFilterStateSlot);
 };
 
 static inline void
@@ -88,5 +108,17 @@ rp_filter_state_parent(RpFilterState* self)
     return RP_IS_FILTER_STATE(self) ?
         RP_FILTER_STATE_GET_IFACE(self)->parent(self) : NULL;
 }
+static inline void
+rp_filter_state_set_slot_data(RpFilterState* self, RpFilterStateSlot slot, gpointer data, RpFilterStateStateType_e state_type, RpFilterStateLifeSpan_e life_span)
+{
+    if (RP_IS_FILTER_STATE(self)) \
+        RP_FILTER_STATE_GET_IFACE(self)->set_slot_data(self, slot, data, state_type, life_span);
+}
+static inline gpointer
+rp_filter_state_get_slot_data(RpFilterState* self, RpFilterStateSlot slot)
+{
+    return RP_IS_FILTER_STATE(self) ?
+        RP_FILTER_STATE_GET_IFACE(self)->get_slot_data(self, slot) : NULL;
+}
 
 G_END_DECLS
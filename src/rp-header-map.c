@@ -0,0 +1,250 @@
+/*
+ * rp-header-map.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ML_LOG_LEVEL
+#define ML_LOG_LEVEL 4
+#endif
+#include "macrologger.h"
+
+#if (defined(rp_header_map_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_header_map_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <string.h>
+#include "rp-headers.h"
+#include "rp-header-map.h"
+
+// Sized so that a typical request or response fits in the initial allocation.
+#define RP_HEADER_MAP_INITIAL_ARENA_SIZE 2048
+#define RP_HEADER_MAP_ARENA_BLOCK_SIZE 4096
+#define RP_HEADER_MAP_ALIGN(n) (((n) + 7) & ~((gsize)7))
+
+typedef struct _RpHeaderMap RpHeaderMap;
+struct _RpHeaderMap {
+    // Must be first; callers treat the map as a plain evhtp_headers_t.
+    evhtp_headers_t m_headers;
+    evhtp_header_t* m_inline[RpInlineHeader_Count];
+    guint8* m_pos;
+    guint8* m_end;
+    GSList* m_blocks;
+};
+
+#define RP_HEADER_MAP(h) ((RpHeaderMap*)(h))
+
+static const struct {
+    const char* const* name;
+    RpInlineHeader_e index;
+} inline_headers[] = {
+    { &RpHeaderValues.Host, RpInlineHeader_Authority },
+    { &RpHeaderValues.HostLegacy, RpInlineHeader_HostLegacy },
+    { &RpHeaderValues.Method, RpInlineHeader_Method },
+    { &RpHeaderValues.Path, RpInlineHeader_Path },
+    { &RpHeaderValues.Protocol, RpInlineHeader_Protocol },
+    { &RpHeaderValues.Scheme, RpInlineHeader_Scheme },
+    { &RpHeaderValues.Status, RpInlineHeader_Status },
+    { &RpHeaderValues.Connection, RpInlineHeader_Connection },
+    { &RpCustomHeaderValues.ContentEncoding, RpInlineHeader_ContentEncoding },
+    { &RpHeaderValues.ContentLength, RpInlineHeader_ContentLength },
+    { &RpHeaderValues.ContentType, RpInlineHeader_ContentType },
+    { &RpHeaderValues.Expect, RpInlineHeader_Expect },
+    { &RpHeaderValues.ForwardedProto, RpInlineHeader_ForwardedProto },
+    { &RpHeaderValues.KeepAlive, RpInlineHeader_KeepAlive },
+    { &RpHeaderValues.ProxyConnection, RpInlineHeader_ProxyConnection },
+    { &RpHeaderValues.TransferEncoding, RpInlineHeader_TransferEncoding },
+    { &RpHeaderValues.Upgrade, RpInlineHeader_Upgrade }
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(inline_headers) == RpInlineHeader_Count);
+
+static gint
+lookup_inline(const char* key, gssize klen)
+{
+    // Callers normally pass the RpHeaderValues constants themselves.
+    for (guint i = 0; i < G_N_ELEMENTS(inline_headers); ++i)
+    {
+        if (*inline_headers[i].name == key)
+        {
+            return inline_headers[i].index;
+        }
+    }
+    if (klen < 0)
+    {
+        klen = strlen(key);
+    }
+    char first = g_ascii_tolower(key[0]);
+    for (guint i = 0; i < G_N_ELEMENTS(inline_headers); ++i)
+    {
+        const char* name = *inline_headers[i].name;
+        if (name[0] == first &&
+            g_ascii_strncasecmp(name, key, klen) == 0 &&
+            name[klen] == '\0')
+        {
+            return inline_headers[i].index;
+        }
+    }
+    return -1;
+}
+
+static gpointer
+arena_alloc(RpHeaderMap* self, gsize size)
+{
+    size = RP_HEADER_MAP_ALIGN(size);
+    if ((gsize)(self->m_end - self->m_pos) < size)
+    {
+        gsize block_size = MAX(size, RP_HEADER_MAP_ARENA_BLOCK_SIZE);
+        guint8* block = g_malloc(block_size);
+        NOISY_MSG_("new arena block %p(%zu)", block, block_size);
+        self->m_blocks = g_slist_prepend(self->m_blocks, block);
+        self->m_pos = block;
+        self->m_end = block + block_size;
+    }
+    gpointer p = self->m_pos;
+    self->m_pos += size;
+    return p;
+}
+
+static inline char*
+arena_strndup(RpHeaderMap* self, const char* str, size_t len)
+{
+    char* p = arena_alloc(self, len + 1);
+    memcpy(p, str, len);
+    p[len] = '\0';
+    return p;
+}
+
+static evhtp_header_t*
+add_header(RpHeaderMap* self, char* key, size_t klen, char* val, size_t vlen)
+{
+    NOISY_MSG_("(%p, %p(%s), %zu, %p(%s), %zu)", self, key, key, klen, val, val, vlen);
+
+    evhtp_header_t* header = arena_alloc(self, sizeof(*header));
+    header->key = key;
+    header->val = val;
+    header->klen = klen;
+    header->vlen = vlen;
+    // Everything belongs to the arena; nothing may be free()'d by evhtp.
+    header->k_heaped = 0;
+    header->v_heaped = 0;
+    TAILQ_INSERT_TAIL(&self->m_headers, header, next);
+
+    gint index = lookup_inline(key, klen);
+    if (index >= 0 && !self->m_inline[index])
+    {
+        self->m_inline[index] = header;
+    }
+    return header;
+}
+
+evhtp_headers_t*
+rp_header_map_new(void)
+{
+    NOISY_MSG_("()");
+    gsize size = RP_HEADER_MAP_ALIGN(sizeof(RpHeaderMap));
+    RpHeaderMap* self = g_malloc0(size + RP_HEADER_MAP_INITIAL_ARENA_SIZE);
+    TAILQ_INIT(&self->m_headers);
+    self->m_pos = (guint8*)self + size;
+    self->m_end = self->m_pos + RP_HEADER_MAP_INITIAL_ARENA_SIZE;
+    return &self->m_headers;
+}
+
+void
+rp_header_map_free(evhtp_headers_t* self)
+{
+    NOISY_MSG_("(%p)", self);
+    if (!self)
+    {
+        return;
+    }
+    RpHeaderMap* me = RP_HEADER_MAP(self);
+    g_slist_free_full(me->m_blocks, g_free);
+    g_free(me);
+}
+
+evhtp_header_t*
+rp_header_map_add_header(evhtp_headers_t* self, const char* key, const char* val, bool copy_key, bool copy_val)
+{
+    NOISY_MSG_("(%p, %p(%s), %p(%s), %u, %u)", self, key, key, val, val, copy_key, copy_val);
+
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(key != NULL, NULL);
+
+    RpHeaderMap* me = RP_HEADER_MAP(self);
+    size_t klen = strlen(key);
+    size_t vlen = val ? strlen(val) : 0;
+    return add_header(me,
+                        copy_key ? arena_strndup(me, key, klen) : (char*)key,
+                        klen,
+                        copy_val && val ? arena_strndup(me, val, vlen) : (char*)val,
+                        vlen);
+}
+
+evhtp_header_t*
+rp_header_map_add_copy(evhtp_headers_t* self, const char* key, size_t klen, const char* val, size_t vlen)
+{
+    NOISY_MSG_("(%p, %p, %zu, %p, %zu)", self, key, klen, val, vlen);
+
+    g_return_val_if_fail(self != NULL, NULL);
+    g_return_val_if_fail(key != NULL, NULL);
+
+    RpHeaderMap* me = RP_HEADER_MAP(self);
+    return add_header(me,
+                        arena_strndup(me, key, klen),
+                        klen,
+                        arena_strndup(me, val ? val : "", vlen),
+                        vlen);
+}
+
+void
+rp_header_map_remove(evhtp_headers_t* self, evhtp_header_t* header)
+{
+    NOISY_MSG_("(%p, %p)", self, header);
+
+    if (!self || !header)
+    {
+        return;
+    }
+
+    RpHeaderMap* me = RP_HEADER_MAP(self);
+    TAILQ_REMOVE(&me->m_headers, header, next);
+
+    gint index = lookup_inline(header->key, header->klen);
+    if (index >= 0 && me->m_inline[index] == header)
+    {
+        // Promote a duplicate, if there is one, so lookups keep returning the
+        // first occurrence in the list.
+        me->m_inline[index] = evhtp_headers_find_header(self, header->key);
+    }
+    // The node and its strings are reclaimed with the arena.
+}
+
+evhtp_header_t*
+rp_header_map_find_header(evhtp_headers_t* self, const char* key)
+{
+    NOISY_MSG_("(%p, %p(%s))", self, key, key);
+
+    if (!self || !key)
+    {
+        return NULL;
+    }
+
+    gint index = lookup_inline(key, -1);
+    if (index >= 0)
+    {
+        return RP_HEADER_MAP(self)->m_inline[index];
+    }
+    return evhtp_headers_find_header(self, key);
+}
+
+evhtp_header_t*
+rp_header_map_get_inline_header(evhtp_headers_t* self, RpInlineHeader_e header)
+{
+    NOISY_MSG_("(%p, %d)", self, header);
+    g_return_val_if_fail(header < RpInlineHeader_Count, NULL);
+    return self ? RP_HEADER_MAP(self)->m_inline[header] : NULL;
+}
@@ -0,0 +1,89 @@
+/*
+ * rp-header-map.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include <evhtp.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Headers that a header map keeps in a fixed slot so that they can be looked
+ * up without walking the header list.
+ */
+typedef enum
+{
+    RpInlineHeader_Authority,
+    RpInlineHeader_HostLegacy,
+    RpInlineHeader_Method,
+    RpInlineHeader_Path,
+    RpInlineHeader_Protocol,
+    RpInlineHeader_Scheme,
+    RpInlineHeader_Status,
+    RpInlineHeader_Connection,
+    RpInlineHeader_ContentEncoding,
+    RpInlineHeader_ContentLength,
+    RpInlineHeader_ContentType,
+    RpInlineHeader_Expect,
+    RpInlineHeader_ForwardedProto,
+    RpInlineHeader_KeepAlive,
+    RpInlineHeader_ProxyConnection,
+    RpInlineHeader_TransferEncoding,
+    RpInlineHeader_Upgrade,
+    RpInlineHeader_Count
+} RpInlineHeader_e;
+
+/*
+ * A header map is an evhtp_headers_t whose header nodes, names and values all
+ * live in an arena owned by the map, with the well-known headers above indexed
+ * in fixed slots. The returned pointer can be used anywhere an evhtp_headers_t*
+ * is expected for reading and iterating, but headers must only be added or
+ * removed through the rp_header_map_*() functions and the map must be released
+ * with rp_header_map_free().
+ */
+evhtp_headers_t* rp_header_map_new(void);
+void rp_header_map_free(evhtp_headers_t* self);
+
+/* Same ownership semantics as evhtp_header_new(); copies go into the arena. */
+evhtp_header_t* rp_header_map_add_header(evhtp_headers_t* self,
+                                            const char* key,
+                                            const char* val,
+                                            bool copy_key,
+                                            bool copy_val);
+evhtp_header_t* rp_header_map_add_copy(evhtp_headers_t* self,
+                                        const char* key,
+                                        size_t klen,
+                                        const char* val,
+                                        size_t vlen);
+void rp_header_map_remove(evhtp_headers_t* self, evhtp_header_t* header);
+evhtp_header_t* rp_header_map_find_header(evhtp_headers_t* self, const char* key);
+
+static inline const char*
+rp_header_map_find(evhtp_headers_t* self, const char* key)
+{
+    evhtp_header_t* header = rp_header_map_find_header(self, key);
+    return header ? header->val : NULL;
+}
+
+evhtp_header_t* rp_header_map_get_inline_header(evhtp_headers_t* self,
+                                                RpInlineHeader_e header);
+
+static inline const char*
+rp_header_map_get_inline(evhtp_headers_t* self, RpInlineHeader_e header)
+{
+    evhtp_header_t* h = rp_header_map_get_inline_header(self, header);
+    return h ? h->val : NULL;
+}
+static inline void
+rp_header_map_remove_inline(evhtp_headers_t* self, RpInlineHeader_e header)
+{
+    rp_header_map_remove(self, rp_header_map_get_inline_header(self, header));
+}
+
+G_END_DECLS
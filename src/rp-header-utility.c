@@ -17,6 +17,7 @@
 #endif
 
 #include "utils/header_value_parser.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-http-utility.h"
 #include "rp-header-utility.h"
@@ -25,7 +26,7 @@ static inline char*
 get_header_value(evhtp_headers_t* headers, const char* name)
 {
     NOISY_MSG_("(%p, %p(%s))", headers, name, name);
-    const char* value = evhtp_header_find(headers, name);
+    const char* value = rp_header_map_find(headers, name);
     if (!value)
     {
         NOISY_MSG_("not found");
@@ -163,7 +164,7 @@ static inline const char*
 method_value(evhtp_headers_t* headers)
 {
     NOISY_MSG_("(%p)", headers);
-    const char* method = evhtp_header_find(headers, RpHeaderValues.Method);
+    const char* method = rp_header_map_get_inline(headers, RpInlineHeader_Method);
     if (method)
     {
         gsize len = strlen(method);
@@ -207,7 +208,7 @@ rp_header_utility_request_should_have_no_body(evhtp_headers_t* headers)
 bool
 rp_header_utility_is_connect(evhtp_headers_t* request_headers)
 {
-    const char* method_value = evhtp_header_find(request_headers, RpHeaderValues.Method);
+    const char* method_value = rp_header_map_get_inline(request_headers, RpInlineHeader_Method);
     return method_value &&
         g_ascii_strcasecmp(method_value, RpHeaderValues.MethodValues.Connect) == 0;
 }
@@ -232,7 +233,7 @@ has_header_element(const char* value, const char* name)
 bool
 rp_header_utility_is_upgrade(evhtp_headers_t* headers)
 {
-    const char* value = evhtp_header_find(headers, RpHeaderValues.Connection);
+    const char* value = rp_header_map_get_inline(headers, RpInlineHeader_Connection);
     return value && has_header_element(value, RpHeaderValues.ConnectionValues.Upgrade);
 }
 
@@ -26,12 +26,21 @@ struct RpCustomHeaderValues_s RpCustomHeaderValues = {
     .AccessControlAllowCredentials = "access-control-allow-credentials",
     .AccessControlRequestPrivateNetwork = "access-control-request-private-network",
     .AccessControlAllowPrivateNetwork = "access-control-allow-private-network",
+    .Age = "age",
+    .Authorization = "authorization",
     .CacheControl = "cache-control",
     .CacheStatus = "cache-status",
     .CdnLoop = "cdn-loop",
     .ContentEncoding = "content-encoding",
+    .Etag = "etag",
+    .Expires = "expires",
+    .IfNoneMatch = "if-none-match",
+    .IfModifiedSince = "if-modified-since",
+    .LastModified = "last-modified",
     .Origin = "origin",
+    .Pragma = "pragma",
     .Referer = "referer",
+    .Vary = "vary",
 
     .AcceptEncodingValues = {
         .Gzip = "gzip",
@@ -39,6 +48,26 @@ struct RpCustomHeaderValues_s RpCustomHeaderValues = {
         .Wildcard = "*"
     },
 
+    .CacheControlValues = {
+        .MaxAge = "max-age",
+        .MaxStale = "max-stale",
+        .MinFresh = "min-fresh",
+        .MustRevalidate = "must-revalidate",
+        .NoCache = "no-cache",
+        .NoStore = "no-store",
+        .OnlyIfCached = "only-if-cached",
+        .Private = "private",
+        .ProxyRevalidate = "proxy-revalidate",
+        .Public = "public",
+        .SMaxAge = "s-maxage",
+        .StaleIfError = "stale-if-error",
+        .StaleWhileRevalidate = "stale-while-revalidate"
+    },
+
+    .PragmaValues = {
+        .NoCache = "no-cache"
+    },
+
     .ContentEncodingValues = {
         .Brotli = "br",
         .Deflate = "deflate",
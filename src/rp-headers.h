@@ -26,14 +26,24 @@ struct RpCustomHeaderValues_s {
     const char* AccessControlAllowCredentials;
     const char* AccessControlRequestPrivateNetwork;
     const char* AccessControlAllowPrivateNetwork;
+    const char* Age;
+    const char* Authorization;
     //TODO...
     const char* CacheControl;
     const char* CacheStatus;
     const char* CdnLoop;
     const char* ContentEncoding;
     //TODO...
+    const char* Etag;
+    const char* Expires;
+    //TODO...
+    const char* IfNoneMatch;
+    const char* IfModifiedSince;
+    const char* LastModified;
     const char* Origin;
+    const char* Pragma;
     const char* Referer;
+    const char* Vary;
 
     struct {
         const char* Gzip;
@@ -41,6 +51,26 @@ struct RpCustomHeaderValues_s {
         const char* Wildcard;
     } AcceptEncodingValues;
 
+    struct {
+        const char* MaxAge;
+        const char* MaxStale;
+        const char* MinFresh;
+        const char* MustRevalidate;
+        const char* NoCache;
+        const char* NoStore;
+        const char* OnlyIfCached;
+        const char* Private;
+        const char* ProxyRevalidate;
+        const char* Public;
+        const char* SMaxAge;
+        const char* StaleIfError;
+        const char* StaleWhileRevalidate;
+    } CacheControlValues;
+
+    struct {
+        const char* NoCache;
+    } PragmaValues;
+
     //TODO...
 
     struct {
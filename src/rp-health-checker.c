@@ -0,0 +1,29 @@
+/*
+ * rp-health-checker.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+
+#ifndef ML_LOG_LEVEL
+#define ML_LOG_LEVEL 4
+#endif
+#include "macrologger.h"
+
+#if (defined(rp_health_checker_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_health_checker_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rp-health-checker.h"
+
+G_DEFINE_INTERFACE(RpHealthChecker, rp_health_checker, G_TYPE_OBJECT)
+
+static void
+rp_health_checker_default_init(RpHealthCheckerInterface* iface G_GNUC_UNUSED)
+{
+    LOGD("(%p)", iface);
+}
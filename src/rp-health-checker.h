@@ -0,0 +1,64 @@
+/*
+ * rp-health-checker.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-callback.h"
+
+G_BEGIN_DECLS
+
+typedef struct _RpHost RpHost;
+
+/**
+ * Health state transition of a host after a check.
+ * https://github.com/envoyproxy/envoy/blob/main/envoy/upstream/health_checker.h
+ */
+typedef enum {
+    // No change to health status.
+    RpHealthTransition_Unchanged,
+    // Health status has changed.
+    RpHealthTransition_Changed,
+    // Health check was successful/failed, but the status change is pending until
+    // the threshold is reached.
+    RpHealthTransition_ChangePending
+} RpHealthTransition_e;
+
+typedef RpStatusCode_e (*RpHealthCheckHostStatusCb)(RpHost*, RpHealthTransition_e, gpointer);
+
+/**
+ * Wraps active health checking of an upstream cluster.
+ */
+#define RP_TYPE_HEALTH_CHECKER rp_health_checker_get_type()
+G_DECLARE_INTERFACE(RpHealthChecker, rp_health_checker, RP, HEALTH_CHECKER, GObject)
+
+struct _RpHealthCheckerInterface {
+    GTypeInterface parent_iface;
+
+    RpCallbackHandlePtr (*add_host_check_complete_cb)(RpHealthChecker*,
+                                                        RpHealthCheckHostStatusCb,
+                                                        gpointer);
+    void (*start)(RpHealthChecker*);
+};
+
+static inline RpCallbackHandlePtr
+rp_health_checker_add_host_check_complete_cb(RpHealthChecker* self, RpHealthCheckHostStatusCb cb, gpointer arg)
+{
+    return RP_IS_HEALTH_CHECKER(self) ?
+        RP_HEALTH_CHECKER_GET_IFACE(self)->add_host_check_complete_cb(self, cb, arg) : NULL;
+}
+static inline void
+rp_health_checker_start(RpHealthChecker* self)
+{
+    if (RP_IS_HEALTH_CHECKER(self))
+    {
+        RP_HEALTH_CHECKER_GET_IFACE(self)->start(self);
+    }
+}
+
+G_END_DECLS
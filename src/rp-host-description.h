@@ -18,6 +18,7 @@ typedef struct _RpClusterInfo RpClusterInfo;
 typedef const SHARED_PTR(RpClusterInfo) RpClusterInfoConstSharedPtr;
 typedef SHARED_PTR(RpClusterInfo) RpClusterInfoSharedPtr;
 typedef gpointer RpMetadataConstSharedPtr;
+typedef struct _RpDetectorHostMonitor RpDetectorHostMonitor;
 
 /**
  * A description of an upstream host.
@@ -33,7 +34,8 @@ struct _RpHostDescriptionInterface {
     void (*set_metadata)(RpHostDescription*, RpMetadataConstSharedPtr);
     RpClusterInfoConstSharedPtr (*cluster)(const RpHostDescription*);
     bool (*can_create_connection)(const RpHostDescription*, RpResourcePriority_e);
-    //TODO...
+    RpDetectorHostMonitor* (*outlier_detector)(const RpHostDescription*);
+    void (*set_outlier_detector)(RpHostDescription*, RpDetectorHostMonitor*);
     const char* (*hostname)(const RpHostDescription*);
     RpUpstreamTransportSocketFactory* (*transport_socket_factory)(const RpHostDescription*);
     //TODO...
@@ -95,6 +97,21 @@ rp_host_description_can_create_connection(RpHostDescriptionConstSharedPtr self,
     return iface->can_create_connection ?
         iface->can_create_connection(self, priority) : false;
 }
+static inline RpDetectorHostMonitor*
+rp_host_description_outlier_detector(RpHostDescriptionConstSharedPtr self)
+{
+    g_return_val_if_fail(rp_host_description_is_a(self), NULL);
+    RpHostDescriptionInterface* iface = rp_host_description_iface(self);
+    return iface->outlier_detector ? iface->outlier_detector(self) : NULL;
+}
+static inline void
+rp_host_description_set_outlier_detector(RpHostDescription* self, RpDetectorHostMonitor* outlier_detector)
+{
+    g_return_if_fail(rp_host_description_is_a(self));
+    RpHostDescriptionInterface* iface = rp_host_description_iface(self);
+    if (iface->set_outlier_detector) \
+        iface->set_outlier_detector(self, outlier_detector);
+}
 static inline const char*
 rp_host_description_hostname(RpHostDescriptionConstSharedPtr self)
 {
@@ -16,6 +16,7 @@
 #endif
 
 #include "http1/rp-http1-server-connection-impl.h"
+#include "http2/rp-http2-server-connection-impl.h"
 #include "router/rp-router-filter.h"
 #include "router/rp-route-provider-manager.h"
 #include "router/rp-static-route-config-provider-impl.h"
@@ -81,6 +82,7 @@ struct _RpHttpConnectionManagerConfig {
     RpHttpConnectionManagerCfg m_config;
 
     struct RpHttp1Settings_s m_http1_settings;
+    struct RpHttp2Settings_s m_http2_settings;
 
     RpLocalReply* m_local_reply;
     RpFactoryContext* m_context;
@@ -138,13 +140,32 @@ filter_chain_factory_iface_init(RpFilterChainFactoryInterface* iface)
     iface->create_filter_chain = create_filter_chain_i;
 }
 
+static inline CodecType_e
+determine_next_protocol(RpNetworkConnection* connection, evbuf_t* data)
+{
+    NOISY_MSG_("(%p, %p)", connection, data);
+    const char* next_protocol = rp_network_connection_next_protocol(connection);
+    if (next_protocol && next_protocol[0])
+    {
+        return g_ascii_strcasecmp(next_protocol, "h2") == 0 ? CodecType_HTTP2 : CodecType_HTTP1;
+    }
+    // No ALPN; look for an h2c prior knowledge preface.
+    return rp_http2_is_connection_preface(data) ? CodecType_HTTP2 : CodecType_HTTP1;
+}
+
 static RpHttpServerConnection*
-create_codec_i(RpConnectionManagerConfig* self, RpNetworkConnection* connection, evbuf_t* data G_GNUC_UNUSED, RpHttpServerConnectionCallbacks* callbacks)
+create_codec_i(RpConnectionManagerConfig* self, RpNetworkConnection* connection, evbuf_t* data, RpHttpServerConnectionCallbacks* callbacks)
 {
     NOISY_MSG_("(%p, %p, %p(%zu), %p)", self, connection, data, evbuffer_get_length(data), callbacks);
 
     RpHttpConnectionManagerConfig* me = RP_HTTP_CONNECTION_MANAGER_CONFIG(self);
-    switch (me->m_codec_type)
+    CodecType_e codec_type = me->m_codec_type;
+    if (codec_type == CodecType_AUTO)
+    {
+        codec_type = determine_next_protocol(connection, data);
+    }
+
+    switch (codec_type)
     {
         case CodecType_HTTP1:
             return RP_HTTP_SERVER_CONNECTION(
@@ -155,6 +176,11 @@ create_codec_i(RpConnectionManagerConfig* self, RpNetworkConnection* connection,
                                                     rp_connection_manager_config_max_request_headers_count(self))
             );
         case CodecType_HTTP2:
+            return RP_HTTP_SERVER_CONNECTION(
+                rp_http2_server_connection_impl_new(connection,
+                                                    callbacks,
+                                                    &me->m_http2_settings)
+            );
         case CodecType_HTTP3:
         case CodecType_AUTO:
         case CodecType_Unknown:
@@ -244,11 +270,13 @@ connection_manager_config_iface_init(RpConnectionManagerConfigInterface* iface)
 }
 
 static struct RpHttp1Settings_s
-parse_http1_settings(void)
+parse_http1_settings(const RpHttpConnectionManagerCfg* config)
 {
-    LOGD("()");
+    LOGD("(%p)", config);
     // Placeholder for more complete logic utilizing cfg stuff...
-    return RpHttp1Settings;
+    struct RpHttp1Settings_s settings = RpHttp1Settings;
+    settings.m_use_fast_parser = config->http_protocol_options.use_fast_parser;
+    return settings;
 }
 
 static inline CodecType_e
@@ -313,7 +341,8 @@ constructed(RpHttpConnectionManagerConfig* self)
     RpRouteConfigProviderManagerSharedPtr route_config_provider_manager =
         rp_route_config_provider_manager_factory_get(default_route_config_provider_manager_factory);
 
-    self->m_http1_settings = parse_http1_settings();
+    self->m_http1_settings = parse_http1_settings(config);
+    self->m_http2_settings = RpHttp2Settings;
     self->m_max_request_headers_count = config->http_protocol_options.max_headers_count;
     self->m_codec_type = get_codec_type(config->codec_type);
 
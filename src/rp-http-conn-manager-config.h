@@ -31,6 +31,7 @@ struct _RpHttpConnectionManagerCfg {
         guint64 max_stream_duration;
         char* headers_with_undercores_action; // "ALLOW"(def), "REJECT_REQUEST", "DROP_HEADER"
         guint32 max_requests_per_connection;
+        bool use_fast_parser; // HTTP/1 only; false(def)
     } http_protocol_options;
 
     RpRouteConfiguration route_config;
@@ -16,6 +16,7 @@
 #include "rp-codec.h"
 #include "rp-codec-client.h"
 #include "rp-header-utility.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-net-connection.h"
 #include "rp-net-filter.h"
@@ -50,12 +51,13 @@ struct _RpHttpConnectionManagerImpl {
 
 static void network_read_filter_iface_init(RpNetworkReadFilterInterface* iface);
 static void network_connection_callbacks_iface_init(RpNetworkConnectionCallbacksInterface* iface);
+static void http_connection_callbacks_iface_init(RpHttpConnectionCallbacksInterface* iface);
 static void http_server_connection_callbacks_iface_init(RpHttpServerConnectionCallbacksInterface* iface);
 
 G_DEFINE_FINAL_TYPE_WITH_CODE(RpHttpConnectionManagerImpl, rp_http_connection_manager_impl, G_TYPE_OBJECT,
     G_IMPLEMENT_INTERFACE(RP_TYPE_NETWORK_READ_FILTER, network_read_filter_iface_init)
     G_IMPLEMENT_INTERFACE(RP_TYPE_NETWORK_CONNECTION_CALLBACKS, network_connection_callbacks_iface_init)
-    G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_CONNECTION_CALLBACKS, NULL)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_CONNECTION_CALLBACKS, http_connection_callbacks_iface_init)
     G_IMPLEMENT_INTERFACE(RP_TYPE_HTTP_SERVER_CONNECTION_CALLBACKS, http_server_connection_callbacks_iface_init)
 )
 
@@ -184,6 +186,12 @@ on_data_i(RpNetworkReadFilter* self, evbuf_t* data, bool end_stream)
         if (status == RpStatusCode_CodecProtocolError)
         {
             LOGD("codec protocol error");
+            if (rp_http_connection_protocol(codec) > EVHTP_PROTO_11)
+            {
+                // nghttp2 has queued a GOAWAY; flush it and drop the session.
+                do_connection_close(me, RpNetworkConnectionCloseType_FlushWrite, "codec_error");
+                return RpNetworkFilterStatus_StopIteration;
+            }
         }
 
         check_for_deferred_close(me, false);
@@ -260,11 +268,25 @@ on_go_away_i(RpHttpConnectionCallbacks* self, RpGoAwayErrorCode_e error_code)
     // push resources if applicable.
 }
 
+static void
+on_settings_i(RpHttpConnectionCallbacks* self G_GNUC_UNUSED, RpReceivedSettings* settings G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %p)", self, settings);
+}
+
+static void
+on_max_streams_changed_i(RpHttpConnectionCallbacks* self G_GNUC_UNUSED, guint32 num_streams G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %u)", self, num_streams);
+}
+
 static void
 http_connection_callbacks_iface_init(RpHttpConnectionCallbacksInterface* iface)
 {
     LOGD("(%p)", iface);
     iface->on_go_away = on_go_away_i;
+    iface->on_settings = on_settings_i;
+    iface->on_max_streams_changed = on_max_streams_changed_i;
 }
 
 static RpRequestDecoder*
@@ -572,7 +594,7 @@ rp_http_connection_manager_impl_do_end_stream(RpHttpConnectionManagerImpl* self,
     {
         evhtp_headers_t* response_headers = rp_http_conn_mgr_impl_active_stream_response_headers_(stream);
         bool http_10_sans_cl = (rp_http_connection_protocol(RP_HTTP_CONNECTION(self->m_codec)) == EVHTP_PROTO_10) &&
-                                (!response_headers || !evhtp_header_find(response_headers, RpHeaderValues.ContentLength));
+                                (!response_headers || !rp_header_map_get_inline(response_headers, RpInlineHeader_ContentLength));
         RpStreamInfo* stream_info = rp_filter_manager_stream_info(RP_FILTER_MANAGER(filter_manager));
         bool connection_close = rp_stream_info_should_drain_connection_upon_completion(stream_info);
         bool request_complete = rp_downstream_filter_manager_has_last_downstream_byte_received(filter_manager);
@@ -21,6 +21,7 @@
 #include "rp-codec.h"
 #include "rp-http-conn-manager-impl.h"
 #include "rp-downstream-filter-manager.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-header-utility.h"
 #include "rp-http-utility.h"
@@ -349,9 +350,9 @@ static evhtp_headers_t*
 continue_header(void)
 {
     char buf[128];
-    evhtp_headers_t* headers = evhtp_headers_new();
-    evhtp_headers_add_header(headers,
-        evhtp_header_new(RpHeaderValues.Status, int_to_string(EVHTP_RES_CONTINUE, buf, sizeof(buf)), 0, 1));
+    evhtp_headers_t* headers = rp_header_map_new();
+    rp_header_map_add_header(headers,
+        RpHeaderValues.Status, int_to_string(EVHTP_RES_CONTINUE, buf, sizeof(buf)), 0, 1);
     return headers;
 }
 
@@ -414,45 +415,45 @@ mutate_request_headers(evhtp_headers_t* request_headers, RpNetworkConnection* co
 
     if (!http_utility_is_upgrade(request_headers))
     {
-        evhtp_header_rm_and_free(request_headers,
-            evhtp_headers_find_header(request_headers, RpHeaderValues.Connection));
-        evhtp_header_rm_and_free(request_headers,
-            evhtp_headers_find_header(request_headers, RpHeaderValues.Upgrade));
+        rp_header_map_remove(request_headers,
+            rp_header_map_get_inline_header(request_headers, RpInlineHeader_Connection));
+        rp_header_map_remove(request_headers,
+            rp_header_map_get_inline_header(request_headers, RpInlineHeader_Upgrade));
 
         //TODO...sanitizeTEHeader(request_headers);
     }
 
-    evhtp_header_rm_and_free(request_headers,
-        evhtp_headers_find_header(request_headers, RpHeaderValues.KeepAlive));
-    evhtp_header_rm_and_free(request_headers,
-        evhtp_headers_find_header(request_headers, RpHeaderValues.ProxyConnection));
-    evhtp_header_rm_and_free(request_headers,
-        evhtp_headers_find_header(request_headers, RpHeaderValues.TransferEncoding));
+    rp_header_map_remove(request_headers,
+        rp_header_map_get_inline_header(request_headers, RpInlineHeader_KeepAlive));
+    rp_header_map_remove(request_headers,
+        rp_header_map_get_inline_header(request_headers, RpInlineHeader_ProxyConnection));
+    rp_header_map_remove(request_headers,
+        rp_header_map_get_inline_header(request_headers, RpInlineHeader_TransferEncoding));
 
     //TODO...sanitize referer field if exits....
 
     //TODO...If we are "using remote address"...
 
-    if (!evhtp_header_find(request_headers, RpHeaderValues.ForwardedProto))
+    if (!rp_header_map_get_inline(request_headers, RpInlineHeader_ForwardedProto))
     {
-        evhtp_headers_add_header(request_headers,
-            evhtp_header_new(RpHeaderValues.ForwardedProto, conn_scheme(connection), 0, 0));
+        rp_header_map_add_header(request_headers,
+            RpHeaderValues.ForwardedProto, conn_scheme(connection), 0, 0);
     }
 
     //TODO...if (config.appencXForwardedPort())
 
     //TODO...if (config.schemeToSet())
 
-    if (!evhtp_header_find(request_headers, RpHeaderValues.Scheme))
+    if (!rp_header_map_get_inline(request_headers, RpInlineHeader_Scheme))
     {
-        evhtp_headers_add_header(request_headers,
-            evhtp_header_new(RpHeaderValues.Scheme,
-                get_scheme(evhtp_header_find(request_headers, RpHeaderValues.ForwardedProto), rp_network_connection_ssl(connection) != NULL), 0, 0));
+        rp_header_map_add_header(request_headers,
+            RpHeaderValues.Scheme,
+                get_scheme(rp_header_map_get_inline(request_headers, RpInlineHeader_ForwardedProto), rp_network_connection_ssl(connection) != NULL), 0, 0);
     }
-    g_autofree gchar* scheme_value = g_ascii_strdown(evhtp_header_find(request_headers, RpHeaderValues.Scheme), -1);
-    evhtp_header_rm_and_free(request_headers, evhtp_headers_find_header(request_headers, RpHeaderValues.Scheme));
-    evhtp_headers_add_header(request_headers,
-        evhtp_header_new(RpHeaderValues.Scheme, scheme_value, 0, 1));
+    g_autofree gchar* scheme_value = g_ascii_strdown(rp_header_map_get_inline(request_headers, RpInlineHeader_Scheme), -1);
+    rp_header_map_remove(request_headers, rp_header_map_get_inline_header(request_headers, RpInlineHeader_Scheme));
+    rp_header_map_add_header(request_headers,
+        RpHeaderValues.Scheme, scheme_value, 0, 1);
 
     //TODO...
 
@@ -547,22 +548,22 @@ decode_headers_i(RpRequestDecoder* self, evhtp_headers_t* request_headers, bool
 
     const char* expect_value;
     if (rp_connection_manager_config_proxy_100_continue(config) &&
-        (expect_value = evhtp_header_find(me->m_request_headers, RpHeaderValues.Expect)) &&
+        (expect_value = rp_header_map_get_inline(me->m_request_headers, RpInlineHeader_Expect)) &&
         g_ascii_strcasecmp(expect_value, RpHeaderValues.ExpectValues._100Continue) == 0)
     {
         evhtp_headers_t* headers = continue_header();
         rp_filter_manager_callbacks_charge_stats(RP_FILTER_MANAGER_CALLBACKS(self), headers);
         rp_response_encoder_encode_1xx_headers(me->m_response_encoder, headers);
-        evhtp_kv_rm_and_free(me->m_request_headers,
-                evhtp_headers_find_header(me->m_request_headers, RpHeaderValues.Expect));
-        evhtp_headers_free(headers); //REVISIT - not sure about this.(?)
+        rp_header_map_remove(me->m_request_headers,
+                rp_header_map_get_inline_header(me->m_request_headers, RpInlineHeader_Expect));
+        rp_header_map_free(headers); //REVISIT - not sure about this.(?)
     }
 
     //TODO...connection_manager_.user_agent_.initializeFromHeaders(*request_headers_, ...);
 
 //rp_request_decoder_send_local_reply(self, EVHTP_RES_BADREQ, ensure_reply_body(me), NULL, "", NULL);
 //return;
-    if (!evhtp_header_find(me->m_request_headers, RpHeaderValues.HostLegacy))
+    if (!rp_header_map_get_inline(me->m_request_headers, RpInlineHeader_HostLegacy))
     {
         LOGE("missing host header");
         rp_request_decoder_send_local_reply(self, EVHTP_RES_BADREQ, ensure_reply_body(me), NULL, "", NULL);
@@ -571,7 +572,7 @@ decode_headers_i(RpRequestDecoder* self, evhtp_headers_t* request_headers, bool
 
     //TODO...apply request header sanity checks????
 
-    const char* path_value = evhtp_header_find(me->m_request_headers, RpHeaderValues.Path);
+    const char* path_value = rp_header_map_get_inline(me->m_request_headers, RpInlineHeader_Path);
     if ((!rp_header_utility_is_connect(me->m_request_headers) || path_value) && !path_value[0])
     {
         LOGE("missing path");
@@ -755,8 +756,8 @@ mutate_response_headers(evhtp_headers_t* response_headers, evhtp_headers_t* requ
 
     if (request_headers && http_utility_is_upgrade(request_headers) && http_utility_is_upgrade(response_headers))
     {
-        IF_NOISY_(bool no_body = (!evhtp_header_find(response_headers, RpHeaderValues.TransferEncoding) &&
-                            !evhtp_header_find(response_headers, RpHeaderValues.ContentLength));)
+        IF_NOISY_(bool no_body = (!rp_header_map_get_inline(response_headers, RpInlineHeader_TransferEncoding) &&
+                            !rp_header_map_get_inline(response_headers, RpInlineHeader_ContentLength));)
         NOISY_MSG_("no body %u", no_body);
 
         //TODO:bool is_1xx ...
@@ -765,20 +766,20 @@ mutate_response_headers(evhtp_headers_t* response_headers, evhtp_headers_t* requ
     {
         if (clear_hop_by_hop)
         {
-            evhtp_header_rm_and_free(response_headers,
-                evhtp_headers_find_header(response_headers, RpHeaderValues.Connection));
-            evhtp_header_rm_and_free(response_headers,
-                evhtp_headers_find_header(response_headers, RpHeaderValues.Upgrade));
+            rp_header_map_remove(response_headers,
+                rp_header_map_get_inline_header(response_headers, RpInlineHeader_Connection));
+            rp_header_map_remove(response_headers,
+                rp_header_map_get_inline_header(response_headers, RpInlineHeader_Upgrade));
         }
     }
     if (clear_hop_by_hop)
     {
-        evhtp_header_rm_and_free(response_headers,
-            evhtp_headers_find_header(response_headers, RpHeaderValues.TransferEncoding));
-        evhtp_header_rm_and_free(response_headers,
-            evhtp_headers_find_header(response_headers, RpHeaderValues.KeepAlive));
-        evhtp_header_rm_and_free(response_headers,
-            evhtp_headers_find_header(response_headers, RpHeaderValues.ProxyConnection));
+        rp_header_map_remove(response_headers,
+            rp_header_map_get_inline_header(response_headers, RpInlineHeader_TransferEncoding));
+        rp_header_map_remove(response_headers,
+            rp_header_map_get_inline_header(response_headers, RpInlineHeader_KeepAlive));
+        rp_header_map_remove(response_headers,
+            rp_header_map_get_inline_header(response_headers, RpInlineHeader_ProxyConnection));
     }
 
     //TODO...
@@ -807,7 +808,7 @@ encode_headers_i(RpFilterManagerCallbacks* self, evhtp_headers_t* response_heade
 
     if (rp_http_connection_manager_impl_get_protocol(connection_manager) == EVHTP_PROTO_10)
     {
-        if (!evhtp_header_find(response_headers, RpHeaderValues.ContentLength))
+        if (!rp_header_map_get_inline(response_headers, RpInlineHeader_ContentLength))
         {
             NOISY_MSG_("calling rp_stream_info_set_should_drain_connection_upon_completion(%p, %u)", stream_info, true);
             rp_stream_info_set_should_drain_connection_upon_completion(stream_info, true);
@@ -815,10 +816,10 @@ encode_headers_i(RpFilterManagerCallbacks* self, evhtp_headers_t* response_heade
         if (!rp_stream_info_should_drain_connection_upon_completion(stream_info))
         {
             NOISY_MSG_("adding keep alive request header");
-            evhtp_header_rm_and_free(response_headers,
-                evhtp_headers_find_header(response_headers, RpHeaderValues.Connection));
-            evhtp_headers_add_header(response_headers,
-                evhtp_header_new(RpHeaderValues.Connection, RpHeaderValues.ConnectionValues.KeepAlive, 0, 0));
+            rp_header_map_remove(response_headers,
+                rp_header_map_get_inline_header(response_headers, RpInlineHeader_Connection));
+            rp_header_map_add_header(response_headers,
+                RpHeaderValues.Connection, RpHeaderValues.ConnectionValues.KeepAlive, 0, 0);
         }
     }
 
@@ -852,10 +853,10 @@ encode_headers_i(RpFilterManagerCallbacks* self, evhtp_headers_t* response_heade
     {
         if (!state->m_is_tunneling)
         {
-            evhtp_header_rm_and_free(response_headers,
-                evhtp_headers_find_header(response_headers, RpHeaderValues.Connection));
-            evhtp_headers_add_header(response_headers,
-                evhtp_header_new(RpHeaderValues.Connection, RpHeaderValues.ConnectionValues.Close, 0, 0));
+            rp_header_map_remove(response_headers,
+                rp_header_map_get_inline_header(response_headers, RpInlineHeader_Connection));
+            rp_header_map_add_header(response_headers,
+                RpHeaderValues.Connection, RpHeaderValues.ConnectionValues.Close, 0, 0);
         }
     }
 
@@ -1093,10 +1094,10 @@ dispose(GObject* obj)
     g_clear_object(&me->m_filter_manager);
     g_clear_object(&me->m_response_encoder);
     g_clear_object(&me->m_cached_route);
-    g_clear_pointer(&me->m_request_headers, evhtp_headers_free);
-    g_clear_pointer(&me->m_request_trailers, evhtp_headers_free);
-    g_clear_pointer(&me->m_response_headers, evhtp_headers_free);
-    g_clear_pointer(&me->m_response_trailers, evhtp_headers_free);
+    g_clear_pointer(&me->m_request_headers, rp_header_map_free);
+    g_clear_pointer(&me->m_request_trailers, rp_header_map_free);
+    g_clear_pointer(&me->m_response_headers, rp_header_map_free);
+    g_clear_pointer(&me->m_response_trailers, rp_header_map_free);
     g_clear_object(&me->m_snapped_route_config);
     if (me->m_cleared_cached_routes)
     {
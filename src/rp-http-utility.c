@@ -18,14 +18,16 @@
 
 #include <netdb.h>
 
+#include "rp-codec.h"
 #include "rp-header-utility.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-http-utility.h"
 
 evhtp_res
 http_utility_get_response_status(evhtp_headers_t* headers)
 {
-    const char* status = evhtp_header_find(headers, RpHeaderValues.Status);
+    const char* status = rp_header_map_get_inline(headers, RpInlineHeader_Status);
     if (!status)
     {
         LOGD("no status in headers");
@@ -43,6 +45,8 @@ http_utility_get_protocol_string(evhtp_proto protocol)
             return RpHeaderValues.ProtocolStrings.Http10String;
         case EVHTP_PROTO_11:
             return RpHeaderValues.ProtocolStrings.Http11String;
+        case EVHTP_PROTO_2:
+            return RpHeaderValues.ProtocolStrings.Http2String;
         default:
             return "Unsupported";
     }
@@ -52,16 +56,16 @@ char*
 http_utility_build_original_uri(evhtp_headers_t* request_headers)
 {
     LOGD("(%p)", request_headers);
-    const char* path = evhtp_header_find(request_headers, RpHeaderValues.Path);
+    const char* path = rp_header_map_get_inline(request_headers, RpInlineHeader_Path);
 NOISY_MSG_("path \"%s\"", path);
     if (!path)
     {
         NOISY_MSG_("no path");
         return g_strdup("");
     }
-const char* host_legacy = evhtp_header_find(request_headers, RpHeaderValues.HostLegacy);
+const char* host_legacy = rp_header_map_get_inline(request_headers, RpInlineHeader_HostLegacy);
 NOISY_MSG_("host legacy \"%s\"", host_legacy);
-    return g_strdup_printf("%s://%s%s", evhtp_header_find(request_headers, RpHeaderValues.Scheme),
+    return g_strdup_printf("%s://%s%s", rp_header_map_get_inline(request_headers, RpInlineHeader_Scheme),
                                         host_legacy,
                                         path);
 }
@@ -69,7 +73,7 @@ NOISY_MSG_("host legacy \"%s\"", host_legacy);
 bool
 http_utility_is_upgrade(evhtp_headers_t* headers)
 {
-    return (evhtp_header_find(headers, RpHeaderValues.Upgrade) &&
+    return (rp_header_map_get_inline(headers, RpInlineHeader_Upgrade) &&
             rp_header_utility_is_upgrade(headers));
 }
 
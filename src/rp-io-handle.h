@@ -50,6 +50,11 @@ struct _RpIoHandleInterface {
     //TODO...
     const char* (*interface_name)(RpIoHandle*);
 int (*sockfd)(RpIoHandle*);
+    gsize (*buffered_bytes)(RpIoHandle*);
+    void (*suspend)(RpIoHandle*, bool);
+    RpSysCallIntResult (*connect_socket)(RpIoHandle*,
+                                            evutil_socket_t,
+                                            RpNetworkAddressInstanceConstSharedPtr);
 };
 
 typedef UNIQUE_PTR(RpIoHandle) RpIoHandlePtr;
@@ -147,5 +152,43 @@ rp_io_handle_sockfd(RpIoHandle* self)
     return RP_IS_IO_HANDLE(self) ?
         RP_IO_HANDLE_GET_IFACE(self)->sockfd(self) : -1;
 }
+/**
+ * @return the number of bytes the handle has read from, or accepted for
+ *         writing to, the descriptor and is still holding in user space.
+ */
+static inline gsize
+rp_io_handle_buffered_bytes(RpIoHandle* self)
+{
+    return RP_IS_IO_HANDLE(self) && RP_IO_HANDLE_GET_IFACE(self)->buffered_bytes ?
+        RP_IO_HANDLE_GET_IFACE(self)->buffered_bytes(self) : 0;
+}
+/**
+ * Stops, or restarts, the handle's own reads from the descriptor so that bytes
+ * can be moved on it directly (e.g. with splice()). Bytes already accepted for
+ * writing still drain, and the descriptor stays open and owned by the handle.
+ */
+static inline void
+rp_io_handle_suspend(RpIoHandle* self, bool suspend)
+{
+    if (RP_IS_IO_HANDLE(self) && RP_IO_HANDLE_GET_IFACE(self)->suspend) \
+        RP_IO_HANDLE_GET_IFACE(self)->suspend(self, suspend);
+}
+static inline bool
+rp_io_handle_can_connect_socket(RpIoHandle* self)
+{
+    return RP_IS_IO_HANDLE(self) && RP_IO_HANDLE_GET_IFACE(self)->connect_socket;
+}
+/**
+ * Like connect(), but with |fd| already connected to |address| elsewhere (e.g.
+ * the winner of a connection race). The handle takes ownership of |fd| and
+ * reports the connect from the event loop as usual.
+ */
+static inline RpSysCallIntResult
+rp_io_handle_connect_socket(RpIoHandle* self, evutil_socket_t fd, RpNetworkAddressInstanceConstSharedPtr address)
+{
+    return rp_io_handle_can_connect_socket(self) ?
+        RP_IO_HANDLE_GET_IFACE(self)->connect_socket(self, fd, address) :
+        INVALID_ARG_RESULT;
+}
 
 G_END_DECLS
@@ -14,6 +14,7 @@
 #endif
 
 #include "network/rp-client-socket-impl.h"
+#include "network/rp-happy-eyeballs.h"
 #include "stream_info/rp-stream-info-impl.h"
 #include "stream_info/rp-upstream-info-impl.h"
 #include "rp-net-client-conn-impl.h"
@@ -23,6 +24,9 @@ struct _RpNetworkClientConnectionImpl {
 
     RpStreamInfoImpl* m_stream_info;
     RpNetworkAddressInstanceSharedPtr m_source_address;
+
+    GPtrArray* m_address_list;
+    RpHappyEyeballs* m_happy_eyeballs;
 };
 
 enum
@@ -41,19 +45,10 @@ G_DEFINE_FINAL_TYPE_WITH_CODE(RpNetworkClientConnectionImpl, rp_network_client_c
 )
 
 static void
-connect_i(RpNetworkClientConnection* self)
+on_connect_result(RpNetworkClientConnectionImpl* self, RpSysCallIntResult result)
 {
-    NOISY_MSG_("(%p)", self);
-    RpNetworkClientConnectionImpl* me = RP_NETWORK_CLIENT_CONNECTION_IMPL(self);
+    NOISY_MSG_("(%p, %d, %d)", self, result.m_return_value, result.m_errno);
     RpNetworkConnectionImpl* conn_impl = RP_NETWORK_CONNECTION_IMPL(self);
-    RpNetworkTransportSocket* transport_socket_ = rp_network_connection_impl_transport_socket_(conn_impl);
-    RpConnectionSocket* socket_ = rp_network_connection_impl_socket_(conn_impl);
-    RpSysCallIntResult result = rp_network_transport_socket_connect(transport_socket_, socket_);
-
-    RpStreamInfo* stream_info = RP_STREAM_INFO(me->m_stream_info);
-    rp_upstream_timing_on_upstream_connect_start(
-        rp_upstream_info_upstream_timing(
-            rp_stream_info_upstream_info(stream_info)));
 
     if (result.m_return_value == 0)
     {
@@ -77,6 +72,81 @@ LOGE("error %d(%s)", result.m_errno, g_strerror(result.m_errno));
     }
 }
 
+static void
+happy_eyeballs_cb(evutil_socket_t fd, RpNetworkAddressInstanceConstSharedPtr address, int err, gpointer arg)
+{
+    NOISY_MSG_("(%d, %p, %d, %p)", fd, address, err, arg);
+    RpNetworkClientConnectionImpl* self = arg;
+    RpNetworkConnectionImpl* conn_impl = RP_NETWORK_CONNECTION_IMPL(self);
+    RpSocket* socket_ = RP_SOCKET(rp_network_connection_impl_socket_(conn_impl));
+    RpIoHandle* io_handle = rp_socket_io_handle(socket_);
+
+    g_clear_object(&self->m_happy_eyeballs);
+
+    if (rp_network_connection_state(RP_NETWORK_CONNECTION(self)) != RpNetworkConnectionState_Open)
+    {
+        LOGD("connection closed while racing");
+        if (fd != EVUTIL_INVALID_SOCKET)
+        {
+            evutil_closesocket(fd);
+        }
+        return;
+    }
+
+    RpSysCallIntResult result = rp_sys_call_int_ctor(-1, err);
+    if (fd != EVUTIL_INVALID_SOCKET)
+    {
+        rp_connection_info_setter_set_remote_address(rp_socket_connection_info_provider(socket_), address);
+        result = rp_io_handle_connect_socket(io_handle, fd, address);
+        if (result.m_return_value != 0)
+        {
+            evutil_closesocket(fd);
+        }
+    }
+
+    on_connect_result(self, result);
+    if (result.m_return_value != 0)
+    {
+        // No connect is left for the write event to complete; have it raise
+        // the error instead.
+        rp_io_handle_activate_file_events(io_handle, RpFileReadyType_Write);
+    }
+}
+
+static void
+connect_i(RpNetworkClientConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpNetworkClientConnectionImpl* me = RP_NETWORK_CLIENT_CONNECTION_IMPL(self);
+    RpNetworkConnectionImpl* conn_impl = RP_NETWORK_CONNECTION_IMPL(self);
+    RpConnectionSocket* socket_ = rp_network_connection_impl_socket_(conn_impl);
+
+    RpStreamInfo* stream_info = RP_STREAM_INFO(me->m_stream_info);
+    rp_upstream_timing_on_upstream_connect_start(
+        rp_upstream_info_upstream_timing(
+            rp_stream_info_upstream_info(stream_info)));
+
+    // With more than one address, race them (RFC 8305) and hand the winner's
+    // socket to the io handle. Handles that cannot take one connect to the
+    // primary address only.
+    if (me->m_address_list && me->m_address_list->len > 1 &&
+        rp_io_handle_can_connect_socket(rp_socket_io_handle(RP_SOCKET(socket_))))
+    {
+        NOISY_MSG_("racing %u addresses", me->m_address_list->len);
+        RpDispatcher* dispatcher = rp_network_connection_impl_base_dispatcher_(RP_NETWORK_CONNECTION_IMPL_BASE(self));
+        me->m_happy_eyeballs = rp_happy_eyeballs_start(dispatcher,
+                                                        me->m_address_list,
+                                                        RP_HAPPY_EYEBALLS_DEFAULT_DELAY_MS,
+                                                        happy_eyeballs_cb,
+                                                        me);
+        return;
+    }
+
+    RpNetworkTransportSocket* transport_socket_ = rp_network_connection_impl_transport_socket_(conn_impl);
+    RpSysCallIntResult result = rp_network_transport_socket_connect(transport_socket_, socket_);
+    on_connect_result(me, result);
+}
+
 static void
 network_client_connection_iface_init(RpNetworkClientConnectionInterface* iface)
 {
@@ -151,6 +221,8 @@ dispose(GObject* obj)
     NOISY_MSG_("(%p)", obj);
 
     RpNetworkClientConnectionImpl* self = RP_NETWORK_CLIENT_CONNECTION_IMPL(obj);
+    g_clear_object(&self->m_happy_eyeballs);
+    g_clear_pointer(&self->m_address_list, g_ptr_array_unref);
     g_clear_object(&self->m_source_address);
     g_clear_object(&self->m_stream_info);
 
@@ -250,3 +322,12 @@ rp_network_client_connection_impl_new(RpDispatcher* dispatcher, RpNetworkAddress
                                         source_address,
                                         transport_socket);
 }
+
+void
+rp_network_client_connection_impl_set_address_list(RpNetworkClientConnectionImpl* self, GPtrArray* address_list)
+{
+    LOGD("(%p, %p)", self, address_list);
+    g_return_if_fail(RP_IS_NETWORK_CLIENT_CONNECTION_IMPL(self));
+    g_clear_pointer(&self->m_address_list, g_ptr_array_unref);
+    self->m_address_list = address_list ? g_ptr_array_ref(address_list) : NULL;
+}
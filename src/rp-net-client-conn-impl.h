@@ -27,4 +27,12 @@ RpNetworkClientConnectionImpl* rp_network_client_connection_impl_new(RpDispatche
                                                                         RpNetworkAddressInstanceConstSharedPtr source_address,
                                                                         RpNetworkTransportSocket* transport_socket);
 
+/**
+ * Has connect() race the addresses of |address_list| (RpNetworkAddressInstance*s,
+ * in the order to try them) rather than only connect to the connection's
+ * remote address. Must be called before connect().
+ */
+void rp_network_client_connection_impl_set_address_list(RpNetworkClientConnectionImpl* self,
+                                                        GPtrArray* address_list);
+
 G_END_DECLS
@@ -13,6 +13,8 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include "rp-stream-info.h"
 #include "rp-net-filter.h"
 #include "rp-net-filter-mgr-impl.h"
@@ -38,6 +40,8 @@ struct _RpNetworkConnectionImplPrivate {
     evbuf_t* m_read_buffer;
     evbuf_t* m_current_write_buffer;
 
+    RpSchedulableCallback* m_flush_cb;
+
     guint32 m_read_disable_count;
 
     RpDetectedCloseType_e m_detected_close_type;
@@ -52,6 +56,9 @@ struct _RpNetworkConnectionImplPrivate {
     bool m_write_end_stream : 1;
     bool m_dispatch_buffered_data : 1;
     bool m_tranport_wants_read : 1;
+    bool m_coalesce_writes : 1;
+    bool m_cork_writes : 1;
+    bool m_corked : 1;
 
     bool m_connected : 1;
     bool m_connecting : 1;
@@ -115,6 +122,8 @@ close_socket(RpNetworkConnectionImpl* self, RpNetworkConnectionEvent_e close_typ
 
     //TODO...if (delayed_close_timer_)...
 
+    rp_schedulable_callback_cancel(me->m_flush_cb);
+
     rp_network_transport_socket_close_socket(me->m_transport_socket);
 
     evbuffer_drain(me->m_write_buffer, evbuffer_get_length(me->m_write_buffer));
@@ -210,6 +219,87 @@ write_buffer_source_iface_init(RpWriteBufferSourceInterface* iface)
     iface->get_write_buffer = get_write_buffer_i;
 }
 
+static void
+set_cork(RpNetworkConnectionImpl* self, bool cork)
+{
+    NOISY_MSG_("(%p(fd %d), %u)", self, SOCKFD(self), cork);
+    RpNetworkConnectionImplPrivate* me = PRIV(self);
+    int fd = rp_io_handle_sockfd(rp_socket_io_handle(RP_SOCKET(me->m_socket)));
+    if (fd < 0)
+    {
+        NOISY_MSG_("no fd");
+        return;
+    }
+#ifdef TCP_CORK
+    int val = cork ? 1 : 0;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_CORK, &val, sizeof(val)) != 0)
+    {
+        int err = errno;
+        NOISY_MSG_("setsockopt(TCP_CORK) failed %d(%s) on fd %d", err, g_strerror(err), fd);
+        return;
+    }
+#endif//TCP_CORK
+    me->m_corked = cork;
+}
+
+static void
+flush_cb(RpSchedulableCallback* cb G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p(fd %d))", cb, arg, SOCKFD(arg));
+
+    RpNetworkConnectionImpl* self = RP_NETWORK_CONNECTION_IMPL(arg);
+    RpNetworkConnectionImplPrivate* me = PRIV(self);
+    if (!rp_socket_is_open(RP_SOCKET(me->m_socket)))
+    {
+        NOISY_MSG_("not open");
+        return;
+    }
+
+    on_write_ready(self);
+    if (me->m_corked && rp_socket_is_open(RP_SOCKET(me->m_socket)))
+    {
+        set_cork(self, false);
+    }
+}
+
+// A close in the same iteration as the writes it should flush cannot wait
+// for the scheduled flush; write them out now.
+static void
+flush_now(RpNetworkConnectionImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpNetworkConnectionImplPrivate* me = PRIV(self);
+    if (!me->m_flush_cb || !rp_schedulable_callback_enabled(me->m_flush_cb))
+    {
+        return;
+    }
+    rp_schedulable_callback_cancel(me->m_flush_cb);
+    on_write_ready(self);
+    if (me->m_corked && rp_socket_is_open(RP_SOCKET(me->m_socket)))
+    {
+        set_cork(self, false);
+    }
+}
+
+// Everything written during this loop iteration goes out with one write at
+// its end.
+static inline void
+schedule_flush(RpNetworkConnectionImpl* self)
+{
+    NOISY_MSG_("(%p(fd %d))", self, SOCKFD(self));
+    RpNetworkConnectionImplPrivate* me = PRIV(self);
+    if (rp_schedulable_callback_enabled(me->m_flush_cb))
+    {
+        NOISY_MSG_("already scheduled");
+        return;
+    }
+    if (me->m_cork_writes && !me->m_corked)
+    {
+        set_cork(self, true);
+    }
+    rp_schedulable_callback_schedule_callback_current_iteration(me->m_flush_cb);
+}
+
 static void
 write_internal(RpNetworkConnectionImpl* self, evbuf_t* data, bool end_stream, bool through_filter_chain)
 {
@@ -244,7 +334,11 @@ write_internal(RpNetworkConnectionImpl* self, evbuf_t* data, bool end_stream, bo
         NOISY_MSG_("writing %zu bytes, end_stream %u", evbuffer_get_length(data), end_stream);
         evbuffer_add_buffer(me->m_write_buffer, data);
 
-        if (!me->m_connecting)
+        if (!me->m_connecting && me->m_coalesce_writes)
+        {
+            schedule_flush(self);
+        }
+        else if (!me->m_connecting)
         {
             NOISY_MSG_("enabling write");
 //#define WITH_ACTIVATE_FILE_EVENTS
@@ -375,6 +469,13 @@ stream_info_i(RpNetworkConnection* self)
     return PRIV(self)->m_stream_info;
 }
 
+static const char*
+next_protocol_i(RpNetworkConnection* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return rp_network_transport_socket_protocol(PRIV(self)->m_transport_socket);
+}
+
 static RpSslConnectionInfo*
 ssl_i(RpNetworkConnection* self)
 {
@@ -394,6 +495,16 @@ close_internal(RpNetworkConnectionImpl* self, RpNetworkConnectionCloseType_e typ
         return;
     }
 
+    if (type != RpNetworkConnectionCloseType_Abort)
+    {
+        flush_now(self);
+        if (!rp_socket_is_open(RP_SOCKET(me->m_socket)))
+        {
+            NOISY_MSG_("closed by flush");
+            return;
+        }
+    }
+
     gsize data_to_write = evbuffer_get_length(me->m_write_buffer);
     NOISY_MSG_("%zu bytes to write to fd %d", data_to_write, SOCKFD(self));
 
@@ -430,6 +541,16 @@ close_i(RpNetworkConnection* self, RpNetworkConnectionCloseType_e type)
         return;
     }
 
+    if (type != RpNetworkConnectionCloseType_Abort && type != RpNetworkConnectionCloseType_AbortReset)
+    {
+        flush_now(RP_NETWORK_CONNECTION_IMPL(self));
+        if (!rp_socket_is_open(RP_SOCKET(me->m_socket)))
+        {
+            NOISY_MSG_("closed by flush");
+            return;
+        }
+    }
+
     size_t data_to_write = evbuf_length(me->m_write_buffer);
     NOISY_MSG_("closing data_to_write %zu type %d", data_to_write, type);
 
@@ -626,6 +747,7 @@ network_connection_iface_init(RpNetworkConnectionInterface* iface)
     iface->transport_failure_reason = transport_failure_reason_i;
     iface->stream_info = stream_info_i;
     iface->ssl = ssl_i;
+    iface->next_protocol = next_protocol_i;
     iface->close = close_i;
     iface->enable_half_close = enable_half_close_i;
     iface->read_disable = read_disable_i;
@@ -930,6 +1052,8 @@ dispose(GObject* obj)
     NOISY_MSG_("(%p)", obj);
 
     RpNetworkConnectionImplPrivate* me = PRIV(obj);
+    rp_schedulable_callback_cancel(me->m_flush_cb);
+    g_clear_object(&me->m_flush_cb);
     g_clear_object(&me->m_transport_socket);
     g_clear_object(&me->m_filter_manager);
     g_clear_object(&me->m_socket);
@@ -1019,6 +1143,9 @@ rp_network_connection_impl_init(RpNetworkConnectionImpl* self)
     me->m_current_write_end_stream = false;
     me->m_dispatch_buffered_data = false;
     me->m_tranport_wants_read = false;
+    me->m_coalesce_writes = false;
+    me->m_cork_writes = false;
+    me->m_corked = false;
     me->m_connecting = false;
     me->m_connected = false;
 
@@ -1041,6 +1168,17 @@ rp_network_connection_impl_transport_socket_(RpNetworkConnectionImpl* self)
     return PRIV(self)->m_transport_socket;
 }
 
+gsize
+rp_network_connection_impl_buffered_bytes_(RpNetworkConnectionImpl* self)
+{
+    LOGD("(%p(fd %d))", self, SOCKFD(self));
+    g_return_val_if_fail(RP_IS_NETWORK_CONNECTION_IMPL(self), 0);
+    RpNetworkConnectionImplPrivate* me = PRIV(self);
+    return evbuffer_get_length(me->m_read_buffer) +
+            evbuffer_get_length(me->m_write_buffer) +
+            rp_io_handle_buffered_bytes(rp_socket_io_handle(RP_SOCKET(me->m_socket)));
+}
+
 void
 rp_network_connection_impl_raise_event(RpNetworkConnectionImpl* self, RpNetworkConnectionEvent_e event)
 {
@@ -1077,3 +1215,18 @@ rp_network_connection_impl_set_immediate_error_event_(RpNetworkConnectionImpl* s
     g_return_if_fail(RP_IS_NETWORK_CONNECTION_IMPL(self));
     PRIV(self)->m_immediate_error_event = event;
 }
+
+void
+rp_network_connection_impl_coalesce_writes_(RpNetworkConnectionImpl* self, bool cork)
+{
+    LOGD("(%p(fd %d), %u)", self, SOCKFD(self), cork);
+    g_return_if_fail(RP_IS_NETWORK_CONNECTION_IMPL(self));
+    RpNetworkConnectionImplPrivate* me = PRIV(self);
+    if (!me->m_flush_cb)
+    {
+        RpDispatcher* dispatcher = rp_network_connection_impl_base_dispatcher_(RP_NETWORK_CONNECTION_IMPL_BASE(self));
+        me->m_flush_cb = rp_dispatcher_create_schedulable_callback(dispatcher, flush_cb, self);
+    }
+    me->m_coalesce_writes = true;
+    me->m_cork_writes = cork;
+}
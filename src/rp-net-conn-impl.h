@@ -38,6 +38,7 @@ rp_network_connection_impl_on_connected(RpNetworkConnectionImpl* self)
 }
 RpConnectionSocket* rp_network_connection_impl_socket_(RpNetworkConnectionImpl* self);
 RpNetworkTransportSocket* rp_network_connection_impl_transport_socket_(RpNetworkConnectionImpl* self);
+gsize rp_network_connection_impl_buffered_bytes_(RpNetworkConnectionImpl* self);
 void rp_network_connection_impl_raise_event(RpNetworkConnectionImpl* self,
                                             RpNetworkConnectionEvent_e event);
 void rp_network_connection_impl_on_connected_(RpNetworkConnectionImpl* self);
@@ -45,5 +46,12 @@ void rp_network_connection_impl_set_connecting_(RpNetworkConnectionImpl* self,
                                                 bool connecting);
 void rp_network_connection_impl_set_immediate_error_event_(RpNetworkConnectionImpl* self,
                                                             RpNetworkConnectionEvent_e event);
+/**
+ * Defers flushing writes to the end of the current dispatcher iteration, so
+ * that everything written during it goes out in one write. With |cork|,
+ * TCP_CORK is held across the flush.
+ */
+void rp_network_connection_impl_coalesce_writes_(RpNetworkConnectionImpl* self,
+                                                    bool cork);
 
 G_END_DECLS
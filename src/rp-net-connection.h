@@ -196,6 +196,12 @@ rp_network_connection_dispatcher(RpNetworkConnection* self)
     return RP_IS_NETWORK_CONNECTION(self) ?
         RP_NETWORK_CONNECTION_GET_IFACE(self)->dispatcher(self) : NULL;
 }
+static inline const char*
+rp_network_connection_next_protocol(RpNetworkConnection* self)
+{
+    return RP_IS_NETWORK_CONNECTION(self) ?
+        RP_NETWORK_CONNECTION_GET_IFACE(self)->next_protocol(self) : "";
+}
 static inline guint64
 rp_network_connection_id(RpNetworkConnection* self)
 {
@@ -152,7 +152,8 @@ rp_network_transport_socket_failure_reason(RpNetworkTransportSocket* self)
 static inline bool
 rp_network_transport_socket_can_flush_close(RpNetworkTransportSocket* self)
 {
-    return RP_IS_NETWORK_TRANSPORT_SOCKET(self) ?
+    return RP_IS_NETWORK_TRANSPORT_SOCKET(self) &&
+        RP_NETWORK_TRANSPORT_SOCKET_GET_IFACE(self)->can_flush_close ?
         RP_NETWORK_TRANSPORT_SOCKET_GET_IFACE(self)->can_flush_close(self) : false;
 }
 static inline RpSysCallIntResult
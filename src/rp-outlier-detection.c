@@ -0,0 +1,36 @@
+/*
+ * rp-outlier-detection.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+
+#ifndef ML_LOG_LEVEL
+#define ML_LOG_LEVEL 4
+#endif
+#include "macrologger.h"
+
+#if (defined(rp_outlier_detection_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_outlier_detection_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rp-outlier-detection.h"
+
+G_DEFINE_INTERFACE(RpDetectorHostMonitor, rp_detector_host_monitor, G_TYPE_OBJECT)
+G_DEFINE_INTERFACE(RpOutlierDetector, rp_outlier_detector, G_TYPE_OBJECT)
+
+static void
+rp_detector_host_monitor_default_init(RpDetectorHostMonitorInterface* iface G_GNUC_UNUSED)
+{
+    LOGD("(%p)", iface);
+}
+
+static void
+rp_outlier_detector_default_init(RpOutlierDetectorInterface* iface G_GNUC_UNUSED)
+{
+    LOGD("(%p)", iface);
+}
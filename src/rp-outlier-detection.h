@@ -0,0 +1,112 @@
+/*
+ * rp-outlier-detection.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-callback.h"
+
+G_BEGIN_DECLS
+
+typedef struct _RpHost RpHost;
+
+/**
+ * Non-HTTP result of requests/operations.
+ * https://github.com/envoyproxy/envoy/blob/main/envoy/upstream/outlier_detection.h
+ */
+typedef enum {
+    // Local origin errors detected by Envoy.
+    RpOutlierResult_LocalOriginConnectFailed,  // Connection to upstream failed.
+    RpOutlierResult_LocalOriginTimeout,        // Timed out while connecting or waiting for headers.
+    RpOutlierResult_LocalOriginConnectSuccess, // Successfully established a connection to upstream.
+
+    // External origin errors.
+    RpOutlierResult_ExtOriginRequestFailed,    // The server indicated it cannot process a request.
+    RpOutlierResult_ExtOriginRequestSuccess    // Request was completed successfully.
+} RpOutlierResult_e;
+
+/**
+ * Monitor for per host data. Proxy filters should send pertinent data when available.
+ * Monitors are called from worker threads and must be thread safe.
+ */
+#define RP_TYPE_DETECTOR_HOST_MONITOR rp_detector_host_monitor_get_type()
+G_DECLARE_INTERFACE(RpDetectorHostMonitor, rp_detector_host_monitor, RP, DETECTOR_HOST_MONITOR, GObject)
+
+struct _RpDetectorHostMonitorInterface {
+    GTypeInterface parent_iface;
+
+    guint32 (*num_ejections)(RpDetectorHostMonitor*);
+    void (*put_http_response_code)(RpDetectorHostMonitor*, guint64);
+    void (*put_result)(RpDetectorHostMonitor*, RpOutlierResult_e);
+    void (*put_response_time)(RpDetectorHostMonitor*, guint64);
+};
+
+static inline guint32
+rp_detector_host_monitor_num_ejections(RpDetectorHostMonitor* self)
+{
+    return RP_IS_DETECTOR_HOST_MONITOR(self) ?
+        RP_DETECTOR_HOST_MONITOR_GET_IFACE(self)->num_ejections(self) : 0;
+}
+static inline void
+rp_detector_host_monitor_put_http_response_code(RpDetectorHostMonitor* self, guint64 response_code)
+{
+    if (RP_IS_DETECTOR_HOST_MONITOR(self))
+    {
+        RP_DETECTOR_HOST_MONITOR_GET_IFACE(self)->put_http_response_code(self, response_code);
+    }
+}
+static inline void
+rp_detector_host_monitor_put_result(RpDetectorHostMonitor* self, RpOutlierResult_e result)
+{
+    if (RP_IS_DETECTOR_HOST_MONITOR(self))
+    {
+        RP_DETECTOR_HOST_MONITOR_GET_IFACE(self)->put_result(self, result);
+    }
+}
+static inline void
+rp_detector_host_monitor_put_response_time(RpDetectorHostMonitor* self, guint64 time_ms)
+{
+    if (RP_IS_DETECTOR_HOST_MONITOR(self))
+    {
+        RP_DETECTOR_HOST_MONITOR_GET_IFACE(self)->put_response_time(self, time_ms);
+    }
+}
+
+
+typedef RpStatusCode_e (*RpOutlierDetectorChangeStateCb)(RpHost*, gpointer);
+
+/**
+ * Interface for an outlier detection engine. Uses per host data to determine which hosts in a
+ * cluster are outliers and should be ejected.
+ */
+#define RP_TYPE_OUTLIER_DETECTOR rp_outlier_detector_get_type()
+G_DECLARE_INTERFACE(RpOutlierDetector, rp_outlier_detector, RP, OUTLIER_DETECTOR, GObject)
+
+struct _RpOutlierDetectorInterface {
+    GTypeInterface parent_iface;
+
+    RpCallbackHandlePtr (*add_changed_state_cb)(RpOutlierDetector*,
+                                                RpOutlierDetectorChangeStateCb,
+                                                gpointer);
+    double (*success_rate_average)(RpOutlierDetector*);
+};
+
+static inline RpCallbackHandlePtr
+rp_outlier_detector_add_changed_state_cb(RpOutlierDetector* self, RpOutlierDetectorChangeStateCb cb, gpointer arg)
+{
+    return RP_IS_OUTLIER_DETECTOR(self) ?
+        RP_OUTLIER_DETECTOR_GET_IFACE(self)->add_changed_state_cb(self, cb, arg) : NULL;
+}
+static inline double
+rp_outlier_detector_success_rate_average(RpOutlierDetector* self)
+{
+    return RP_IS_OUTLIER_DETECTOR(self) ?
+        RP_OUTLIER_DETECTOR_GET_IFACE(self)->success_rate_average(self) : -1.0;
+}
+
+G_END_DECLS
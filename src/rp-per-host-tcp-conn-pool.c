@@ -34,7 +34,9 @@ on_pool_ready_i(RpTcpConnPoolCallbacks* self, RpTcpConnPoolConnectionData* conn_
     RpNetworkConnection* latched_conn = RP_NETWORK_CONNECTION(rp_tcp_conn_pool_connection_data_connection(conn_data));
     RpGenericConnectionPoolCallbacks* callbacks_ = rp_tcp_conn_pool_callbacks_(RP_TCP_CONN_POOL(self));
     RpUpstreamToDownstream* upstream_request = rp_generic_connection_pool_callbacks_upstream_to_downstream(callbacks_);
-    RpPerHostTcpUpstream* upstream = rp_per_host_tcp_upstream_new(upstream_request, conn_data);
+    RpPerHostTcpUpstream* upstream = rp_per_host_tcp_upstream_new(upstream_request,
+                                                                    conn_data,
+                                                                    rp_tcp_conn_pool_downstream_protocol_(RP_TCP_CONN_POOL(self)));
     rp_generic_connection_pool_callbacks_on_pool_ready(callbacks_,
                                                         RP_GENERIC_UPSTREAM(upstream),
                                                         host,
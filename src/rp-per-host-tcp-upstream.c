@@ -51,13 +51,14 @@ rp_per_host_tcp_upstream_init(RpPerHostTcpUpstream* self G_GNUC_UNUSED)
 }
 
 RpPerHostTcpUpstream*
-rp_per_host_tcp_upstream_new(RpUpstreamToDownstream* upstream_request, RpTcpConnPoolConnectionData* upstream)
+rp_per_host_tcp_upstream_new(RpUpstreamToDownstream* upstream_request, RpTcpConnPoolConnectionData* upstream, evhtp_proto downstream_protocol)
 {
-    LOGD("(%p, %p)", upstream_request, upstream);
+    LOGD("(%p, %p, %d)", upstream_request, upstream, downstream_protocol);
     g_return_val_if_fail(RP_IS_UPSTREAM_TO_DOWNSTREAM(upstream_request), NULL);
     g_return_val_if_fail(RP_IS_TCP_CONN_POOL_CONNECTION_DATA(upstream), NULL);
     return g_object_new(RP_TYPE_PER_HOST_TCP_UPSTREAM,
                         "upstream-request", upstream_request,
                         "upstream", upstream,
+                        "downstream-protocol", downstream_protocol,
                         NULL);
 }
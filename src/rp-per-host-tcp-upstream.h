@@ -19,6 +19,7 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE(RpPerHostTcpUpstream, rp_per_host_tcp_upstream, RP, PER_HOST_TCP_UPSTREAM, RpTcpUpstream)
 
 RpPerHostTcpUpstream* rp_per_host_tcp_upstream_new(RpUpstreamToDownstream* upstream_request,
-                                                    RpTcpConnPoolConnectionData* upstream);
+                                                    RpTcpConnPoolConnectionData* upstream,
+                                                    evhtp_proto downstream_protocol);
 
 G_END_DECLS
@@ -15,6 +15,7 @@
 
 #include "rp-filter-factory.h"
 #include "rp-filter-manager.h"
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-http-utility.h"
 #include "rp-state-filter.h"
@@ -30,11 +31,11 @@
     rp_stream_filter_callbacks_stream_info(STREAM_FILTER_CALLBACKS(s))
 #define FILTER_STATE(s) rp_stream_info_filter_state(STREAM_INFO(s))
 #define ORIGINAL_URI(s) \
-    rp_filter_state_get_data(FILTER_STATE(s), original_uri_key)
+    rp_filter_state_get_slot_data(FILTER_STATE(s), original_uri_slot)
 #define REWRITE_URLS(s) \
-    rp_filter_state_get_data(FILTER_STATE(s), rewrite_urls_key)
+    rp_filter_state_get_slot_data(FILTER_STATE(s), rewrite_urls_slot)
 #define PASSTHROUGH(s) \
-    rp_filter_state_get_data(FILTER_STATE(s), passthrough_key)
+    rp_filter_state_get_slot_data(FILTER_STATE(s), passthrough_slot)
 
 typedef struct _RpRewriteUrlsFilterCb RpRewriteUrlsFilterCb;
 struct _RpRewriteUrlsFilterCb {
@@ -168,7 +169,7 @@ should_rewrite_data(evhtp_headers_t* response_headers)
 {
     NOISY_MSG_("(%p)", response_headers);
     return util_is_text_content_type(
-            evhtp_header_find(response_headers, RpHeaderValues.ContentType));
+            rp_header_map_get_inline(response_headers, RpInlineHeader_ContentType));
 }
 
 static void
@@ -124,6 +124,36 @@ rp_virtual_host_route_config(RpVirtualHost* self)
 }
 
 
+/**
+ * Route level retry policy.
+ * https://github.com/envoyproxy/envoy/blob/main/envoy/router/router.h (RetryPolicy)
+ */
+typedef enum {
+    RpRetryOn_ConnectFailure = 1 << 0,
+    RpRetryOn_Reset = 1 << 1,
+    RpRetryOn_5xx = 1 << 2
+} RpRetryOn_e;
+
+typedef struct _RpRetryPolicy RpRetryPolicy;
+struct _RpRetryPolicy {
+    guint32 m_num_retries;
+    guint32 m_retry_on;             // RpRetryOn_e bitmask.
+    gint64 m_per_try_timeout_ms;    // 0 disables the per-try timeout.
+    gint64 m_base_interval_ms;
+    gint64 m_max_interval_ms;
+};
+
+/**
+ * Possible outcomes of asking the retry state whether to retry.
+ */
+typedef enum {
+    RpRetryStatus_No,
+    RpRetryStatus_NoOverflow,
+    RpRetryStatus_NoRetryLimitExceeded,
+    RpRetryStatus_Yes
+} RpRetryStatus_e;
+
+
 /**
  * An individual resolved route entry.
  */
@@ -141,6 +171,10 @@ struct _RpRouteEntryInterface {
     //TODO...
     RpResourcePriority_e (*priority)(RpRouteEntry*);
     //TODO...
+    gint64 (*hedge_delay)(RpRouteEntry*);
+    bool (*collapsed_forwarding)(RpRouteEntry*);
+    const RpRetryPolicy* (*retry_policy)(RpRouteEntry*);
+    //TODO...
     bool (*append_xfh)(RpRouteEntry*);
     //TODO...
 };
@@ -180,6 +214,32 @@ rp_route_entry_priority(RpRouteEntry* self)
         RP_ROUTE_ENTRY_GET_IFACE(self)->priority(self) :
         RpResourcePriority_Default;
 }
+/**
+ * @return the delay in milliseconds after which an idempotent request is
+ *         hedged to a second upstream host, or 0 if hedging is disabled.
+ */
+static inline gint64
+rp_route_entry_hedge_delay(RpRouteEntry* self)
+{
+    return RP_IS_ROUTE_ENTRY(self) ?
+        RP_ROUTE_ENTRY_GET_IFACE(self)->hedge_delay(self) : 0;
+}
+/**
+ * @return true if concurrent identical GETs on this route should wait on a
+ *         single upstream fetch instead of each sending their own.
+ */
+static inline bool
+rp_route_entry_collapsed_forwarding(RpRouteEntry* self)
+{
+    return RP_IS_ROUTE_ENTRY(self) ?
+        RP_ROUTE_ENTRY_GET_IFACE(self)->collapsed_forwarding(self) : false;
+}
+static inline const RpRetryPolicy*
+rp_route_entry_retry_policy(RpRouteEntry* self)
+{
+    return RP_IS_ROUTE_ENTRY(self) ?
+        RP_ROUTE_ENTRY_GET_IFACE(self)->retry_policy(self) : NULL;
+}
 static inline bool
 rp_route_entry_append_xfh(RpRouteEntry* self)
 {
@@ -305,6 +305,10 @@ struct _RpSslConnectionInfoInterface {
     const char* (*subject_local_certificate)(RpSslConnectionInfo*);
     //TODO...
     const char* (*sni)(RpSslConnectionInfo*);
+    /* Optional; true once the kernel does record encryption and decryption
+     * (kTLS) and OpenSSL holds no plaintext of its own, so the socket can be
+     * spliced like a plain one. */
+    bool (*kernel_tls)(RpSslConnectionInfo*);
 };
 
 static inline bool
@@ -334,5 +338,12 @@ rp_ssl_connection_info_sni(RpSslConnectionInfo* self)
     return RP_IS_SSL_CONNECTION_INFO(self) ?
         RP_SSL_CONNECTION_INFO_GET_IFACE(self)->sni(self) : NULL;
 }
+static inline bool
+rp_ssl_connection_info_kernel_tls(RpSslConnectionInfo* self)
+{
+    if (!RP_IS_SSL_CONNECTION_INFO(self)) return false;
+    RpSslConnectionInfoInterface* iface = RP_SSL_CONNECTION_INFO_GET_IFACE(self);
+    return iface->kernel_tls ? iface->kernel_tls(self) : false;
+}
 
 G_END_DECLS
@@ -41,6 +41,13 @@ const char* passthrough_key = "rp.state.filter.passthrough";
 const char* dynamic_host_key = "rp.state.filter.dynamic-host";
 const char* dynamic_port_key = "rp.state.filter.dynamic-port";
 
+RpFilterStateSlot rewrite_urls_slot = RP_FILTER_STATE_SLOT_INVALID;
+RpFilterStateSlot rule_slot = RP_FILTER_STATE_SLOT_INVALID;
+RpFilterStateSlot original_uri_slot = RP_FILTER_STATE_SLOT_INVALID;
+RpFilterStateSlot passthrough_slot = RP_FILTER_STATE_SLOT_INVALID;
+RpFilterStateSlot dynamic_host_slot = RP_FILTER_STATE_SLOT_INVALID;
+RpFilterStateSlot dynamic_port_slot = RP_FILTER_STATE_SLOT_INVALID;
+
 struct _RpStateFilter {
     RpPassThroughFilter parent_instance;
 
@@ -105,33 +112,33 @@ decode_headers_i(RpStreamDecoderFilter* self, evhtp_headers_t* request_headers,
     if (rule->config->passthrough)
     {
         NOISY_MSG_("passthrough");
-        rp_filter_state_set_data(filter_state,
-                                    passthrough_key,
-                                    (gpointer)passthrough_key,
-                                    RpFilterStateStateType_ReadOnly,
-                                    RpFilterStateLifeSpan_Request);
+        rp_filter_state_set_slot_data(filter_state,
+                                         passthrough_slot,
+                                         (gpointer)passthrough_key,
+                                         RpFilterStateStateType_ReadOnly,
+                                         RpFilterStateLifeSpan_Request);
         return RpFilterHeadersStatus_Continue;
     }
 
-    rp_filter_state_set_data(filter_state,
-                                rule_key,
-                                rule,
-                                RpFilterStateStateType_ReadOnly,
-                                RpFilterStateLifeSpan_Request);
+    rp_filter_state_set_slot_data(filter_state,
+                                     rule_slot,
+                                     rule,
+                                     RpFilterStateStateType_ReadOnly,
+                                     RpFilterStateLifeSpan_Request);
 
     GSList* rewrite_urls = get_rewrite_urls(rule);
-    rp_filter_state_set_data(filter_state,
-                                rewrite_urls_key,
-                                rewrite_urls,
-                                RpFilterStateStateType_ReadOnly,
-                                RpFilterStateLifeSpan_Request);
+    rp_filter_state_set_slot_data(filter_state,
+                                     rewrite_urls_slot,
+                                     rewrite_urls,
+                                     RpFilterStateStateType_ReadOnly,
+                                     RpFilterStateLifeSpan_Request);
 
     char* original_uri = me->m_original_uri = http_utility_build_original_uri(request_headers);
-    rp_filter_state_set_data(filter_state,
-                                original_uri_key,
-                                original_uri,
-                                RpFilterStateStateType_ReadOnly,
-                                RpFilterStateLifeSpan_Request);
+    rp_filter_state_set_slot_data(filter_state,
+                                     original_uri_slot,
+                                     original_uri,
+                                     RpFilterStateStateType_ReadOnly,
+                                     RpFilterStateLifeSpan_Request);
 
     return RpFilterHeadersStatus_Continue;
 }
@@ -219,6 +226,18 @@ filter_factory_cb(RpFilterFactoryCb* self, RpFilterChainFactoryCallbacks* callba
     rp_filter_chain_factory_callbacks_add_stream_decoder_filter(callbacks, RP_STREAM_DECODER_FILTER(filter));
 }
 
+void
+rp_state_filter_register_slots(void)
+{
+    LOGD("()");
+    rewrite_urls_slot = rp_filter_state_slot_register(rewrite_urls_key);
+    rule_slot = rp_filter_state_slot_register(rule_key);
+    original_uri_slot = rp_filter_state_slot_register(original_uri_key);
+    passthrough_slot = rp_filter_state_slot_register(passthrough_key);
+    dynamic_host_slot = rp_filter_state_slot_register(dynamic_host_key);
+    dynamic_port_slot = rp_filter_state_slot_register(dynamic_port_key);
+}
+
 RpFilterFactoryCb*
 rp_state_filter_create_filter_factory(RpFactoryContext* context)
 {
@@ -10,6 +10,7 @@
 #include <stdbool.h>
 #include <glib-object.h>
 #include "rp-factory-context.h"
+#include "rp-filter-state.h"
 #include "rp-pass-through-filter.h"
 
 G_BEGIN_DECLS
@@ -21,9 +22,18 @@ extern const char* passthrough_key;
 extern const char* dynamic_host_key;
 extern const char* dynamic_port_key;
 
+extern RpFilterStateSlot rewrite_urls_slot;
+extern RpFilterStateSlot rule_slot;
+extern RpFilterStateSlot original_uri_slot;
+extern RpFilterStateSlot passthrough_slot;
+extern RpFilterStateSlot dynamic_host_slot;
+extern RpFilterStateSlot dynamic_port_slot;
+
 #define RP_TYPE_STATE_FILTER rp_state_filter_get_type()
 G_DECLARE_FINAL_TYPE(RpStateFilter, rp_state_filter, RP, STATE_FILTER, RpPassThroughFilter)
 
 RpFilterFactoryCb* rp_state_filter_create_filter_factory(RpFactoryContext* context);
+/* Assigns the filter state slots above; must run before any worker starts. */
+void rp_state_filter_register_slots(void);
 
 G_END_DECLS
@@ -127,7 +127,7 @@ struct _RpHostInterface {
     //TODO...
     void (*health_flag_clear)(RpHost*, RpHostHealthFlag_e);
     bool (*health_flag_get)(const RpHost*, RpHostHealthFlag_e);
-    void (*health_flag_set)(RpHost*, RpHostHealth_e);
+    void (*health_flag_set)(RpHost*, RpHostHealthFlag_e);
     guint32 (*health_flags_get_all)(const RpHost*);
     guint32 (*health_flags_set_all)(RpHost*, guint32);
     RpHostHealth_e (*coarse_health)(const RpHost*);
@@ -180,7 +180,7 @@ rp_host_health_flag_get(const RpHost* self, RpHostHealthFlag_e flag)
     return iface->health_flag_get(self, flag);
 }
 static inline void
-rp_host_health_flag_set(RpHost* self, RpHostHealth_e flag)
+rp_host_health_flag_set(RpHost* self, RpHostHealthFlag_e flag)
 {
     g_return_if_fail(rp_host_is_a(self));
     RpHostInterface* iface = rp_host_iface(self);
@@ -312,6 +312,7 @@ struct _RpClusterInfoInterface {
     guint32 (*per_connection_buffer_limit_bytes)(const RpClusterInfo*);
     guint64 (*features)(const RpClusterInfo*);
     Http1SettingsPtr (*http1_settings)(const RpClusterInfo*);
+    const RpHttp2ProtocolOptionsCfg* (*http2_options)(const RpClusterInfo*);
     //TODO...
     RpLoadBalancerConfig* (*load_balancer_config)(const RpClusterInfo*);
     RpTypedLoadBalancerFactory* (*load_balancer_factory)(const RpClusterInfo*);
@@ -445,6 +446,14 @@ rp_cluster_info_max_requests_per_connection(RpClusterInfoConstSharedPtr self)
     g_return_val_if_fail(iface->max_requests_per_connection != NULL, 1024);
     return iface->max_requests_per_connection(self);
 }
+static inline const RpHttp2ProtocolOptionsCfg*
+rp_cluster_info_http2_options(RpClusterInfoConstSharedPtr self)
+{
+    g_return_val_if_fail(rp_cluster_info_is_cluster_info(self), NULL);
+    RpClusterInfoInterface* iface = rp_cluster_info_iface(self);
+    g_return_val_if_fail(iface->http2_options != NULL, NULL);
+    return iface->http2_options(self);
+}
 static inline evhtp_proto*
 rp_cluster_info_upstream_http_protocol(RpClusterInfoConstSharedPtr self, evhtp_proto downstream_protocol)
 {
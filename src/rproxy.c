@@ -60,6 +60,7 @@
 #include "network/rp-accepted-socket-impl.h"
 #include "network/rp-default-client-conn-factory.h"
 #include "network/rp-socket-interface-impl.h"
+#include "network/rp-ssl-async-handshake.h"
 #include "router/rp-route-provider-manager.h"
 #include "router/rp-router-config-impl.h"
 #include "router/rp-router-filter.h"
@@ -80,6 +81,7 @@
 #include "rp-http-conn-manager-impl.h"
 #include "rp-net-server-conn-impl.h"
 #include "rp-per-host-upstream.h"
+#include "rp-state-filter.h"
 
 static RpFactoryContext* factory_context = NULL; // It *appears* this is the listener_manger (or listener?) in envoy.???
 static GMutex thread_waiter_mutex;
@@ -374,16 +376,10 @@ create_transport_socket(rproxy_t* rproxy, evhtp_connection_t* conn)
     return rp_downstream_transport_socket_factory_create_downstream_transport_socket(factory, conn);
 }
 
-static evhtp_res
-downstream_post_accept(evhtp_connection_t* up_conn, gpointer arg)
+static void
+create_downstream_connection(rproxy_t* rproxy, evhtp_connection_t* up_conn)
 {
-    LOGD("(%p, %p)", up_conn, arg);
-
-    rproxy_t* rproxy = arg;
-    NOISY_MSG_("rproxy %p, fd %d", rproxy, bufferevent_getfd(evhtp_connection_get_bev(up_conn)));
-
-    stats_inc(g_traffic_stats.downstream_cx_total);
-    stats_inc(g_traffic_stats.downstream_cx_active);
+    NOISY_MSG_("(%p, %p)", rproxy, up_conn);
 
     RpConnectionManagerConfig* config = RP_CONNECTION_MANAGER_CONFIG(rproxy->m_filter_config);
     RpServerFactoryContext* server_context =
@@ -403,6 +399,11 @@ downstream_post_accept(evhtp_connection_t* up_conn, gpointer arg)
                                                 RP_CONNECTION_SOCKET(g_steal_pointer(&socket)),
                                                 g_steal_pointer(&transport_socket),
                                                 RP_STREAM_INFO(stream_info));
+    if (rproxy->server_cfg->coalesce_writes)
+    {
+        rp_network_connection_impl_coalesce_writes_(RP_NETWORK_CONNECTION_IMPL(connection),
+                                                    rproxy->server_cfg->cork_writes);
+    }
     g_autoptr(RpHttpConnectionManagerImpl) hcm =
         rp_http_connection_manager_impl_new(config,
                                             rp_common_factory_context_local_info(context),
@@ -417,6 +418,90 @@ downstream_post_accept(evhtp_connection_t* up_conn, gpointer arg)
                                 rproxy->m_tpool_ctx);
     rproxy->m_active_connections = g_list_append(rproxy->m_active_connections,
                                                     g_steal_pointer(&active_conn));
+}
+
+static void
+downstream_handshake_done(evhtp_ssl_t* ssl, evutil_socket_t fd, bool success, gpointer arg)
+{
+    NOISY_MSG_("(%p, %d, %u, %p)", ssl, fd, success, arg);
+
+    rproxy_t* rproxy = arg;
+    evhtp_connection_t* up_conn = SSL_get_app_data(ssl);
+    if (!success)
+    {
+        /* nothing owns the connection yet; undo what accepting it did. */
+        SSL_free(ssl);
+        evutil_closesocket(fd);
+        evhtp_connection_free(up_conn);
+        n_processing_dec(rproxy->m_tpool_ctx->n_processing);
+        stats_dec(g_traffic_stats.downstream_cx_active);
+        stats_inc(g_traffic_stats.downstream_cx_destroy);
+        return;
+    }
+
+    /* the handshake is over, so the connection gets a bufferevent that starts
+     * out open, with the same timeouts evhtp would have given it.
+     */
+    server_cfg_t* server_cfg = rproxy->server_cfg;
+    evbev_t* bev = bufferevent_openssl_socket_new(rp_dispatcher_base(rproxy->m_dispatcher),
+                                                    fd,
+                                                    ssl,
+                                                    BUFFEREVENT_SSL_OPEN,
+                                                    BEV_OPT_CLOSE_ON_FREE);
+    bufferevent_set_timeouts(bev,
+        evutil_timerisset(&server_cfg->read_timeout) ? &server_cfg->read_timeout : NULL,
+        evutil_timerisset(&server_cfg->write_timeout) ? &server_cfg->write_timeout : NULL);
+    evhtp_connection_set_bev(up_conn, bev);
+    create_downstream_connection(rproxy, up_conn);
+}
+
+static void
+offload_handshake(rproxy_t* rproxy, evhtp_connection_t* up_conn)
+{
+    NOISY_MSG_("(%p, %p)", rproxy, up_conn);
+
+    /* take the socket and ssl object away from the bufferevent evhtp made,
+     * before it has had a chance to start the handshake. clearing the
+     * bufferevent's descriptor leaves the socket open when it goes, and the
+     * extra reference keeps the ssl object.
+     */
+    evhtp_ssl_t* ssl = up_conn->ssl;
+    evbev_t* bev = evhtp_connection_take_ownership(up_conn);
+    evutil_socket_t fd = bufferevent_getfd(bev);
+    SSL_up_ref(ssl);
+    bufferevent_disable(bev, EV_READ|EV_WRITE);
+    bufferevent_setfd(bev, EVUTIL_INVALID_SOCKET);
+    bufferevent_free(bev);
+
+    SSL_set_fd(ssl, fd);
+    SSL_set_accept_state(ssl);
+    rp_ssl_async_handshake_start(rproxy->m_dispatcher,
+                                    ssl,
+                                    fd,
+                                    &rproxy->server_cfg->read_timeout,
+                                    downstream_handshake_done,
+                                    rproxy);
+}
+
+static evhtp_res
+downstream_post_accept(evhtp_connection_t* up_conn, gpointer arg)
+{
+    LOGD("(%p, %p)", up_conn, arg);
+
+    rproxy_t* rproxy = arg;
+    NOISY_MSG_("rproxy %p, fd %d", rproxy, bufferevent_getfd(evhtp_connection_get_bev(up_conn)));
+
+    stats_inc(g_traffic_stats.downstream_cx_total);
+    stats_inc(g_traffic_stats.downstream_cx_active);
+
+    if (up_conn->ssl && rproxy->server_cfg->ssl_handshake_threads > 0)
+    {
+        NOISY_MSG_("offloading handshake");
+        offload_handshake(rproxy, up_conn);
+        return EVHTP_RES_OK;
+    }
+
+    create_downstream_connection(rproxy, up_conn);
     return EVHTP_RES_OK;
 }
 
@@ -508,9 +593,10 @@ continue_thread_init_cb(gpointer arg)
                 .ignore_path_paramaters_in_path_matching = false
             };
             RpHttpConnectionManagerCfg proto_config = {
-                .codec_type = "HTTP1",
+                .codec_type = server_cfg->enable_http2 ? "AUTO" : "HTTP1",
                 .max_request_headers_kb = DEFAULT_MAX_REQUEST_HEADERS_KB,
                 .http_protocol_options.max_headers_count = DEFAULT_MAX_HEADERS_COUNT,
+                .http_protocol_options.use_fast_parser = server_cfg->enable_fast_http_parser,
                 .route_config = route_config,
                 .rules = rproxy->m_parent->rules
             };
@@ -882,6 +968,7 @@ add_evhtp_vhost(gpointer data, gpointer arg)
     {
         /* vhost specific ssl configuration found */
         evhtp_ssl_init(htp_vhost, ssl_cfg);
+        ssl_alpn_init(htp_vhost, vcfg->server_cfg->enable_http2);
 
         /* if CRL checking is enabled, create a new ssl_crl_ent_t and add it
          * to the evhtp_t's arguments. XXX: in the future we should create a
@@ -931,11 +1018,18 @@ create_htp(evbase_t* evbase, server_cfg_t* server_cfg)
      */
     evhtp_disable_flag(htp, EVHTP_FLAG_ENABLE_100_CONT);
 
+    if (server_cfg->ssl_handshake_threads > 0)
+    {
+        LOGD("%d ssl handshake threads", server_cfg->ssl_handshake_threads);
+        rp_ssl_async_handshake_set_max_threads(server_cfg->ssl_handshake_threads);
+    }
+
     if (server_cfg->ssl_cfg)
     {
         LOGD("configuring SSL support");
         /* enable SSL support on this server */
         evhtp_ssl_init(htp, server_cfg->ssl_cfg);
+        ssl_alpn_init(htp, server_cfg->enable_http2);
 
         /* if CRL checking is enabled, create a new ssl_crl_ent_t and add it
          * to the evhtp_t's arguments. XXX: in the future we should create a
@@ -1285,6 +1379,9 @@ static void
 create_rp_instances(RpServerInstance* server, RpThreadLocalInstance* tls)
 {
     NOISY_MSG_("(%p, %p)", server, tls);
+    // Assign the well-known filter state slots before any worker can touch
+    // a filter state.
+    rp_state_filter_register_slots();
     // Create a single RpFactoryContext instance.
     factory_context = RP_FACTORY_CONTEXT(
                         rp_factory_context_impl_new(RP_SERVER_INSTANCE(server)));
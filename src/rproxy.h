@@ -140,6 +140,23 @@ enum discovery_type {
     discovery_type_original_dst
 };
 
+enum health_check_type {
+    health_check_type_tcp = 0,
+    health_check_type_http
+};
+
+enum io_handle_type {
+    io_handle_type_bufferevent = 0,
+    io_handle_type_native,
+    io_handle_type_io_uring
+};
+
+enum retry_on {
+    retry_on_connect_failure = 1 << 0,
+    retry_on_reset           = 1 << 1,
+    retry_on_5xx             = 1 << 2
+};
+
 typedef struct evdns_base evdns_base_t;
 typedef struct evdns_request evdns_request_t;
 
@@ -168,6 +185,8 @@ typedef enum lb_method        lb_method;
 typedef enum logger_type      logger_type;
 typedef enum enc_type         enc_type;
 typedef enum discovery_type   discovery_type;
+typedef enum health_check_type health_check_type;
+typedef enum io_handle_type   io_handle_type;
 
 struct logger_cfg {
     lzlog_level level;
@@ -205,6 +224,32 @@ struct dfp_cluster_cfg {
     dfp_sub_clusters_cfg_t* sub_clusters_cfg;
 };
 
+typedef struct outlier_detection_cfg outlier_detection_cfg_t;
+struct outlier_detection_cfg {
+    int consecutive_5xx;                  /**< consecutive 5xx responses before a host is ejected (0 disables) */
+    int consecutive_gateway_failure;      /**< consecutive 502/503/504 responses before a host is ejected (0 disables) */
+    int consecutive_local_origin_failure; /**< consecutive connect failures/timeouts before a host is ejected (0 disables) */
+    struct timeval interval;              /**< how often success rate and latency are evaluated */
+    struct timeval base_ejection_time;    /**< ejection time, doubled for each successive ejection */
+    struct timeval max_ejection_time;     /**< upper bound on the ejection time */
+    int max_ejection_percent;             /**< most hosts of the cluster that may be ejected at once */
+    int success_rate_minimum_hosts;       /**< hosts with enough volume needed to evaluate success rate */
+    int success_rate_request_volume;      /**< requests in an interval before a host counts for success rate */
+    double success_rate_stdev_factor;     /**< eject below mean - (factor * stdev) success rate (0 disables) */
+    double latency_threshold_factor;      /**< eject above factor * median mean latency (0 disables) */
+};
+
+typedef struct health_check_cfg health_check_cfg_t;
+struct health_check_cfg {
+    health_check_type type;               /**< probe with a bare TCP connect or an HTTP GET */
+    char * path;                          /**< the path requested by http probes */
+    struct timeval interval;              /**< time between probes of a host */
+    struct timeval interval_jitter;       /**< up to this much is added to each interval at random */
+    struct timeval timeout;               /**< how long a probe may take before it counts as a failure */
+    int unhealthy_threshold;              /**< consecutive failed probes before a host is marked unhealthy */
+    int healthy_threshold;                /**< consecutive passed probes before a host is marked healthy again */
+};
+
 typedef struct cluster_type_cfg cluster_type_cfg_t;
 struct cluster_type_cfg {
     char * name;
@@ -223,13 +268,26 @@ struct rule_cfg {
     logger_cfg_t       * err_log;         /**< error logging config */
     bool                 passthrough;     /**< if set to true, a pipe between the upstream and upstream is established */
     bool                 allow_redirect;  /**< if true, the upstream can send a redirect to connect to a different upstream */
+    bool                 upstream_http2;  /**< if true, upstreams are spoken to in HTTP/2 (prior knowledge) */
+    int                  max_concurrent_streams; /**< cap on multiplexed requests per HTTP/2 upstream connection */
+    bool                 happy_eyeballs;  /**< if true, upstream names resolve to both families and connects race them */
     GSList             * redirect_filter; /**< a list of hostnames that redirects are can connect to */
     int                  has_up_read_timeout;
     int                  has_up_write_timeout;
     struct timeval       up_read_timeout;
     struct timeval       up_write_timeout;
     struct timeval       connect_timeout;
+    struct timeval       hedge_delay;     /**< if non-zero, send a second idempotent request after this delay */
+    bool                 collapsed_forwarding; /**< if true, identical in-flight GETs share one upstream fetch */
+    int                  num_retries;     /**< how many times a failed request may be re-issued */
+    int                  retry_on;        /**< bitmask of enum retry_on conditions that trigger a retry */
+    struct timeval       per_try_timeout; /**< how long each attempt may wait for response headers */
+    struct timeval       retry_backoff;   /**< base interval of the jittered exponential retry backoff */
+    double               retry_budget;    /**< percentage of active requests that may be retries at once, 0 keeps max_retries */
+    int                  retry_budget_min_concurrency; /**< retries always allowed regardless of the budget */
     cluster_type_cfg_t * cluster_type;    /**< custom cluster type */
+    outlier_detection_cfg_t * outlier_detection; /**< passive health checking of the rule's upstreams */
+    health_check_cfg_t * health_check;    /**< active health checking of the rule's upstreams */
 };
 
 /**
@@ -279,6 +337,7 @@ struct upstream_cfg {
     struct timeval retry_ival;      /**< retry timer if the upstream connection goes down */
     struct timeval read_timeout;
     struct timeval write_timeout;
+    io_handle_type io_handle;       /**< socket I/O through a bufferevent, straight readv/writev or io_uring */
 };
 
 
@@ -307,6 +366,8 @@ struct server_cfg {
     int      max_pending;               /**< max pending requests before new connections are dropped */
     int      listen_backlog;            /**< listen backlog */
     size_t   high_watermark;            /**< upstream high-watermark */
+    io_handle_type io_handle;           /**< socket I/O through a bufferevent, straight readv/writev or io_uring */
+    int      ssl_handshake_threads;     /**< threads that run client ssl handshakes, 0 runs them on the workers */
 
     gint worker_num;                    /**< simple zero-based index worker number */
 
@@ -332,6 +393,11 @@ struct server_cfg {
     bool disable_client_nagle : 1;      /**< disable nagle for upstream sockets */
     bool disable_upstream_nagle : 1;    /**< disable nagle for upstream sockets */
     bool enable_workers_listen : 1;     /**< enable worker thread listening */
+    bool enable_fast_http_parser : 1;   /**< use the vectorized HTTP/1 parser */
+    bool enable_http2 : 1;              /**< accept HTTP/2 (ALPN h2 and h2c prior knowledge) */
+    bool coalesce_writes : 1;           /**< flush client writes once per event loop iteration */
+    bool cork_writes : 1;               /**< hold TCP_CORK across each coalesced flush */
+    bool ssl_dynamic_records : 1;       /**< small ssl records for new and idle client connections */
 };
 
 static inline uint16_t
@@ -405,6 +471,7 @@ typedef struct logger_arg        logger_arg_t;
 typedef struct logger            logger_t;
 #endif//WITH_LOGGER
 typedef struct ssl_crl_ent       ssl_crl_ent_t;
+typedef struct ssl_crl_snapshot  ssl_crl_snapshot_t;
 typedef struct request_hooks     request_hooks_t;
 
 typedef enum logger_argtype      logger_argtype;
@@ -429,7 +496,8 @@ struct ssl_crl_ent {
     ssl_crl_cfg_t * cfg;
     rproxy_t      * rproxy;
     evhtp_t       * htp;
-    X509_STORE    * crl;
+    ssl_crl_snapshot_t * snapshot; /**< the CRLs verifications use, swapped whole on reload */
+    gint            reloading;     /**< set while the reload thread works on this entry */
     event_t       * reload_timer_ev;
 #ifdef __APPLE__
     struct timespec last_file_mod;
@@ -438,7 +506,7 @@ struct ssl_crl_ent {
     time_t last_file_mod;
     time_t last_dir_mod;
 #endif
-    pthread_mutex_t lock; /**< lock to make sure we don't overwrite during a verification */
+    pthread_mutex_t lock; /**< guards |snapshot| while it is swapped or referenced */
 };
 
 struct vhost {
@@ -553,6 +621,7 @@ upstream_t     * upstream_find_by_name(GSList *, const char *);
 int             ssl_x509_verifyfn(int, X509_STORE_CTX *);
 int             ssl_x509_issuedcb(X509_STORE_CTX *, X509 *, X509 *);
 ssl_crl_ent_t * ssl_crl_ent_new(evhtp_t *, ssl_crl_cfg_t *);
+void            ssl_alpn_init(evhtp_t *, bool);
 
 /***********************************************
  * SSL helper functions.
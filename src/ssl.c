@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <glib.h>
+#include <openssl/err.h>
 
 #ifndef ML_LOG_LEVEL
 #define ML_LOG_LEVEL 4
@@ -520,6 +521,92 @@ ssl_x509_ext_tostr(evhtp_ssl_t* ssl, const char* oid)
     return ext_str;
 } /* ssl_x509_ext_tostr */
 
+struct ssl_crl_snapshot {
+    gatomicrefcount      refcount;
+    X509_STORE         * store; /**< owns the CRLs */
+    STACK_OF(X509_CRL) * crls;  /**< the same CRLs, the way a verification takes them */
+};
+
+static ssl_crl_snapshot_t*
+ssl_crl_snapshot_new(X509_STORE* store)
+{
+    LOGD("(%p)", store);
+
+    ssl_crl_snapshot_t* snapshot = g_new0(ssl_crl_snapshot_t, 1);
+    g_atomic_ref_count_init(&snapshot->refcount);
+    snapshot->store = store;
+    snapshot->crls  = sk_X509_CRL_new_null();
+
+    STACK_OF(X509_OBJECT) * objs = X509_STORE_get0_objects(store);
+    for (int i = 0; i < sk_X509_OBJECT_num(objs); i++)
+    {
+        X509_CRL* crl = X509_OBJECT_get0_X509_CRL(sk_X509_OBJECT_value(objs, i));
+        if (crl && X509_CRL_up_ref(crl))
+        {
+            sk_X509_CRL_push(snapshot->crls, crl);
+        }
+    }
+
+    LOGD("snapshot %p, %d crls", snapshot, sk_X509_CRL_num(snapshot->crls));
+    return snapshot;
+}
+
+static ssl_crl_snapshot_t*
+ssl_crl_snapshot_ref(ssl_crl_snapshot_t* snapshot)
+{
+    g_atomic_ref_count_inc(&snapshot->refcount);
+    return snapshot;
+}
+
+static void
+ssl_crl_snapshot_unref(ssl_crl_snapshot_t* snapshot)
+{
+    if (snapshot && g_atomic_ref_count_dec(&snapshot->refcount))
+    {
+        LOGD("freeing snapshot %p", snapshot);
+        sk_X509_CRL_pop_free(snapshot->crls, X509_CRL_free);
+        X509_STORE_free(snapshot->store);
+        g_free(snapshot);
+    }
+}
+
+/**
+ * @brief returns a reference to the current CRL snapshot, or NULL if none
+ *        has been loaded. the lock is only ever held to swap or reference the
+ *        pointer, never while loading.
+ */
+static ssl_crl_snapshot_t*
+ssl_crl_ent_get_snapshot(ssl_crl_ent_t* crl_ent)
+{
+    ssl_crl_snapshot_t* snapshot;
+
+    pthread_mutex_lock(&crl_ent->lock);
+    {
+        snapshot = crl_ent->snapshot ? ssl_crl_snapshot_ref(crl_ent->snapshot) : NULL;
+    }
+    pthread_mutex_unlock(&crl_ent->lock);
+
+    return snapshot;
+}
+
+static void
+ssl_crl_ent_set_snapshot(ssl_crl_ent_t* crl_ent, ssl_crl_snapshot_t* snapshot)
+{
+    LOGD("(%p, %p)", crl_ent, snapshot);
+
+    ssl_crl_snapshot_t* old_snapshot;
+
+    pthread_mutex_lock(&crl_ent->lock);
+    {
+        old_snapshot      = crl_ent->snapshot;
+        crl_ent->snapshot = snapshot;
+    }
+    pthread_mutex_unlock(&crl_ent->lock);
+
+    /* handshakes still verifying against the old snapshot keep it alive */
+    ssl_crl_snapshot_unref(old_snapshot);
+}
+
 static int
 ssl_crl_ent_should_reload(ssl_crl_ent_t* crl_ent)
 {
@@ -562,7 +649,7 @@ ssl_crl_ent_should_reload(ssl_crl_ent_t* crl_ent)
             return 1;
         }
 #else
-        if (statb.st_mtime > crl_ent->last_file_mod)
+        if (statb.st_mtime > crl_ent->last_dir_mod)
         {
             return 1;
         }
@@ -572,24 +659,77 @@ ssl_crl_ent_should_reload(ssl_crl_ent_t* crl_ent)
     return 0;
 } /* ssl_crl_ent_should_reload */
 
+/**
+ * @brief reads every CRL in |dirname| into |lookup|. the whole directory is
+ *        read up front, rather than on demand the way a hash dir lookup
+ *        would, so that verifications never touch the disk.
+ *
+ * @return the number of CRLs loaded, -1 on error.
+ */
+static int
+ssl_crl_load_dir(X509_LOOKUP* lookup, const char* dirname)
+{
+    LOGD("(%p, %p(%s))", lookup, dirname, dirname);
+
+    GDir       * dir;
+    const char * name;
+    int          count = 0;
+
+    if (!(dir = g_dir_open(dirname, 0, NULL)))
+    {
+        return -1;
+    }
+
+    while ((name = g_dir_read_name(dir)))
+    {
+        g_autofree char* path = g_build_filename(dirname, name, NULL);
+        struct stat      file_stat;
+        int              n;
+
+        if (stat(path, &file_stat) == -1 || !S_ISREG(file_stat.st_mode))
+        {
+            continue;
+        }
+
+        /* anything that isn't a PEM CRL is skipped */
+        if ((n = X509_load_crl_file(lookup, path, X509_FILETYPE_PEM)) > 0)
+        {
+            count += n;
+        }
+        ERR_clear_error();
+    }
+
+    g_dir_close(dir);
+    return count;
+}
+
+/**
+ * @brief builds a new CRL snapshot from the configured file and/or directory
+ *        if either has changed, and swaps it in. meant to run off the event
+ *        loop; the previous snapshot stays in place on any error.
+ *
+ * @return 0 on success or when nothing changed, -1 on error.
+ */
 int
 ssl_crl_ent_reload(ssl_crl_ent_t * crl_ent)
 {
     LOGD("(%p)", crl_ent);
 
     X509_LOOKUP * lookup;
-    X509_STORE  * old_crl;
+    X509_STORE  * store;
     struct stat   file_stat;
     int           res;
 
     if (!crl_ent)
     {
         LOGD("crl_ent is null");
+        return -1;
     }
     /* make sure we have either (or both) a crl file or directory */
     else if (!crl_ent->cfg->filename && !crl_ent->cfg->dirname)
     {
         LOGD("filename and dirname are both null");
+        return -1;
     }
 
     if ((res = ssl_crl_ent_should_reload(crl_ent)) <= 0)
@@ -604,28 +744,17 @@ ssl_crl_ent_reload(ssl_crl_ent_t * crl_ent)
         return res;
     }
 
-    /* if this crl_ent already has an allocated X509_STORE, we set it aside to
-     * be free'd if all goes well with the new load.
-     */
-    old_crl = NULL;
-
-    if (crl_ent->crl)
+    if ((store = X509_STORE_new()) == NULL)
     {
-        old_crl      = crl_ent->crl;
-        crl_ent->crl = NULL;
+        LOGE("SSL: CRL X509 STORE alloc failure");
+        return -1;
     }
 
-    /* initialize our own X509 storage stack. We utilize our own stack and our
-     * own manual CRL verification because OpenSSL does not give us a method of
-     * determining what a normal X509 is versus what a X509 CRL is. Since we
-     * want to allow RProxy to dynamically read in CRL information as it comes
-     * in, we must do it ourselves.
-     */
-    if ((crl_ent->crl = X509_STORE_new()) == NULL)
+    /* both the file and the directory go through a file lookup */
+    if (!(lookup = X509_STORE_add_lookup(store, X509_LOOKUP_file())))
     {
-        /* something bad happened, so add the old crl back and return an error */
-        LOGE("SSL: CRL X509 STORE alloc failure");
-        crl_ent->crl = old_crl;
+        LOGE("SSL: Cannot add CRL LOOKUP to store");
+        X509_STORE_free(store);
         return -1;
     }
 
@@ -634,25 +763,21 @@ ssl_crl_ent_reload(ssl_crl_ent_t * crl_ent)
         if (stat(crl_ent->cfg->filename, &file_stat) == -1)
         {
             LOGE("SSL: CRL stat failed: %s", crl_ent->cfg->filename);
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
+            X509_STORE_free(store);
             return -1;
         }
 
         if (!S_ISREG(file_stat.st_mode))
         {
             LOGE("SSL: CRL not a regular file: %s", crl_ent->cfg->filename);
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
+            X509_STORE_free(store);
             return -1;
         }
 
-        /* attempt to add the filename to our x509 store */
-        if (!(lookup = X509_STORE_add_lookup(crl_ent->crl, X509_LOOKUP_file())))
+        if (X509_load_crl_file(lookup, crl_ent->cfg->filename, X509_FILETYPE_PEM) <= 0)
         {
-            LOGE("SSL: Cannot add CRL LOOKUP to store");
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
+            LOGE("SSL: Cannot add CRL to store: %s", crl_ent->cfg->filename);
+            X509_STORE_free(store);
             return -1;
         }
 
@@ -666,17 +791,7 @@ ssl_crl_ent_reload(ssl_crl_ent_t * crl_ent)
         crl_ent->last_file_mod = file_stat.st_mtime;
 #endif
 
-        if (!X509_LOOKUP_load_file(lookup, crl_ent->cfg->filename, X509_FILETYPE_PEM))
-        {
-            LOGE("SSL: Cannot add CRL to store: %s", crl_ent->cfg->filename);
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
-            return -1;
-        }
-        else
-        {
-            LOGI("SSL: CRL reloaded: %s ", crl_ent->cfg->filename);
-        }
+        LOGI("SSL: CRL reloaded: %s ", crl_ent->cfg->filename);
     }
 
     if (crl_ent->cfg->dirname != NULL)
@@ -684,24 +799,21 @@ ssl_crl_ent_reload(ssl_crl_ent_t * crl_ent)
         if (stat(crl_ent->cfg->dirname, &file_stat) == -1)
         {
             LOGE("SSL: CRL stat failed: %s", crl_ent->cfg->dirname);
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
+            X509_STORE_free(store);
             return -1;
         }
 
         if (!S_ISDIR(file_stat.st_mode))
         {
             LOGE("SSL: CRL not a directory: %s", crl_ent->cfg->dirname);
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
+            X509_STORE_free(store);
             return -1;
         }
 
-        if (!(lookup = X509_STORE_add_lookup(crl_ent->crl, X509_LOOKUP_hash_dir())))
+        if ((res = ssl_crl_load_dir(lookup, crl_ent->cfg->dirname)) < 0)
         {
-            LOGE("SSL: Cannot add CRL LOOKUP to store");
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
+            LOGE("SSL: Cannot add CRL directory to store: %s", crl_ent->cfg->dirname);
+            X509_STORE_free(store);
             return -1;
         }
 
@@ -711,34 +823,33 @@ ssl_crl_ent_reload(ssl_crl_ent_t * crl_ent)
         crl_ent->last_dir_mod = file_stat.st_mtime;
 #endif
 
-
-        if (!X509_LOOKUP_add_dir(lookup, crl_ent->cfg->dirname, X509_FILETYPE_PEM))
-        {
-            LOGE("SSL: Cannot add CRL directory to store: %s", crl_ent->cfg->dirname);
-            X509_STORE_free(crl_ent->crl);
-            crl_ent->crl = old_crl;
-            return -1;
-        }
-        else
-        {
-            LOGI("SSL: CRL directory reloaded: %s ", crl_ent->cfg->dirname);
-        }
+        LOGI("SSL: CRL directory reloaded: %s (%d crls)", crl_ent->cfg->dirname, res);
     }
 
-    if (old_crl)
-    {
-        X509_STORE_free(old_crl);
-    }
+    ssl_crl_ent_set_snapshot(crl_ent, ssl_crl_snapshot_new(store));
 
     return 0;
 } /* ssl_crl_ent_reload */
 
+static void
+ssl_crl_reload_func(gpointer data, gpointer user_data)
+{
+    LOGD("(%p, %p)", data, user_data);
+
+    ssl_crl_ent_t* crl_ent = data;
+
+    ssl_crl_ent_reload(crl_ent);
+    g_atomic_int_set(&crl_ent->reloading, 0);
+}
+
 static void
 ssl_reload_timercb(int sock, short which, void* arg)
 {
     LOGD("(%d, %d, %p)", sock, which, arg);
 
-    ssl_crl_ent_t* crl_ent;
+    /* one thread loads the CRLs of every context, one reload at a time */
+    static GThreadPool * reload_pool = NULL;
+    ssl_crl_ent_t      * crl_ent;
 
     if (!(crl_ent = (ssl_crl_ent_t *)arg))
     {
@@ -746,13 +857,50 @@ ssl_reload_timercb(int sock, short which, void* arg)
         return;
     }
 
-    /* TODO: log stuff here */
-    pthread_mutex_lock(&crl_ent->lock);
+    if (!reload_pool)
     {
-        ssl_crl_ent_reload(crl_ent);
-        event_add(crl_ent->reload_timer_ev, &crl_ent->cfg->reload_timer);
+        reload_pool = g_thread_pool_new(ssl_crl_reload_func, NULL, 1, FALSE, NULL);
     }
-    pthread_mutex_unlock(&crl_ent->lock);
+
+    /* a reload that is still running when the timer comes around again
+     * simply gets skipped.
+     */
+    if (g_atomic_int_compare_and_exchange(&crl_ent->reloading, 0, 1))
+    {
+        g_thread_pool_push(reload_pool, crl_ent, NULL);
+    }
+
+    event_add(crl_ent->reload_timer_ev, &crl_ent->cfg->reload_timer);
+}
+
+/**
+ * @brief the SSL_CTX certificate verification callback of contexts with CRL
+ *        checking. it verifies the chain as OpenSSL would, with the CRLs of
+ *        the current snapshot handed to the verification; the snapshot is
+ *        held for as long as the verification runs.
+ */
+static int
+ssl_crl_verify_cert(X509_STORE_CTX* ctx, void* arg)
+{
+    LOGD("(%p, %p)", ctx, arg);
+
+    ssl_crl_ent_t      * crl_ent = arg;
+    ssl_crl_snapshot_t * snapshot;
+    int                  res;
+
+    if (!(snapshot = ssl_crl_ent_get_snapshot(crl_ent)))
+    {
+        LOGD("no crl snapshot");
+        return X509_verify_cert(ctx);
+    }
+
+    X509_STORE_CTX_set0_crls(ctx, snapshot->crls);
+    X509_STORE_CTX_set_flags(ctx, X509_V_FLAG_CRL_CHECK | X509_V_FLAG_CRL_CHECK_ALL);
+    res = X509_verify_cert(ctx);
+    X509_STORE_CTX_set0_crls(ctx, NULL);
+
+    ssl_crl_snapshot_unref(snapshot);
+    return res;
 }
 
 ssl_crl_ent_t*
@@ -781,9 +929,17 @@ ssl_crl_ent_new(evhtp_t* htp, ssl_crl_cfg_t* config)
         crl_ent->reload_timer_ev = evtimer_new(htp->evbase, ssl_reload_timercb, crl_ent);
         pthread_mutex_init(&crl_ent->lock, NULL);
 
+        /* the first load happens before anything is served, so it is done
+         * right here; later ones go to the reload thread.
+         */
         ssl_crl_ent_reload(crl_ent);
         event_add(crl_ent->reload_timer_ev, &config->reload_timer);
 
+        if (htp->ssl_ctx)
+        {
+            SSL_CTX_set_cert_verify_callback(htp->ssl_ctx, ssl_crl_verify_cert, crl_ent);
+        }
+
         LOGD("crl_ent %p", crl_ent);
         return crl_ent;
     }
@@ -792,154 +948,6 @@ ssl_crl_ent_new(evhtp_t* htp, ssl_crl_cfg_t* config)
     return NULL;
 }
 
-/*
- * ssl_verify_crl was inspired by Apache's mod_ssl.  That code is licensed
- * under the Apache 2.0 license:
- *
- * http://www.apache.org/licenses/LICENSE-2.0
- *
- * Following are comments lifted from the original mod_ssl code:
- *
- * OpenSSL provides the general mechanism to deal with CRLs but does not
- * use them automatically when verifying certificates, so we do it
- * explicitly here. We will check the CRL for the currently checked
- * certificate, if there is such a CRL in the store.
- *
- * We come through this procedure for each certificate in the certificate
- * chain, starting with the root-CA's certificate. At each step we've to
- * both verify the signature on the CRL (to make sure it's a valid CRL)
- * and it's revocation list (to make sure the current certificate isn't
- * revoked).  But because to check the signature on the CRL we need the
- * public key of the issuing CA certificate (which was already processed
- * one round before), we've a little problem. But we can both solve it and
- * at the same time optimize the processing by using the following
- * verification scheme (idea and code snippets borrowed from the GLOBUS
- * project):
- *
- * 1. We'll check the signature of a CRL in each step when we find a CRL
- *    through the _subject_ name of the current certificate. This CRL
- *    itself will be needed the first time in the next round, of course.
- *    But we do the signature processing one round before this where the
- *    public key of the CA is available.
- *
- * 2. We'll check the revocation list of a CRL in each step when
- *    we find a CRL through the _issuer_ name of the current certificate.
- *    This CRLs signature was then already verified one round before.
- *
- * This verification scheme allows a CA to revoke its own certificate as
- * well, of course.
- */
-
-
-static int
-ssl_verify_crl(int ok, X509_STORE_CTX* ctx, ssl_crl_ent_t* crl_ent)
-{
-    LOGD("(%d, %p, %p)", ok, ctx, crl_ent);
-
-#if 0
-    const size_t   kSz = 255;
-    char           buf[kSz + 1];
-    X509         * cert;
-    X509_NAME    * subject;
-    X509_NAME    * issuer;
-    X509_CRL     * crl;
-    X509_STORE_CTX store_ctx;
-    EVP_PKEY     * public_key;
-    X509_OBJECT    x509_obj = { 0 };
-    int            res;
-    int            timestamp_res;
-#endif//
-
-    if (!crl_ent)
-    {
-        LOGD("crl_ent is null");
-        return ok;
-    }
-
-#if 0
-    cert    = X509_STORE_CTX_get_current_cert(ctx);
-    subject = X509_get_subject_name(cert);
-    issuer  = X509_get_issuer_name(cert);
-
-    /* lookup the CRL using the subject of the cert */
-    X509_STORE_CTX_init(&store_ctx, crl_ent->crl, NULL, NULL);
-    res     = X509_STORE_get_by_subject(&store_ctx, X509_LU_CRL, subject, &x509_obj);
-    crl     = x509_obj.data.crl;
-
-    if (res > 0 && crl) {
-        public_key = X509_get_pubkey(cert);
-
-        res        = X509_CRL_verify(crl, public_key);
-
-        if (public_key != NULL) {
-            EVP_PKEY_free(public_key);
-        }
-
-        if (res <= 0) {
-            X509_OBJECT_free_contents(&x509_obj);
-            LOGE("SSL: CRL validation failed:%i:%s", res, X509_NAME_oneline(subject, buf, kSz));
-            return 0;
-        }
-
-        timestamp_res = X509_cmp_current_time(X509_CRL_get_nextUpdate(crl));
-
-        if (timestamp_res == 0) {
-            /* invalid nextupdate found */
-            X509_OBJECT_free_contents(&x509_obj);
-            LOGE("SSL: CRL nextupdate invalid:%s", X509_NAME_oneline(subject, buf, kSz));
-            return 0;
-        }
-
-        if (timestamp_res < 0) {
-            /* CRL is expired */
-            X509_OBJECT_free_contents(&x509_obj);
-            LOGE("SSL: CRL expired:%s", X509_NAME_oneline(subject, buf, kSz));
-            return 0;
-        }
-
-        X509_OBJECT_free_contents(&x509_obj);
-    }
-
-    memset((void *)&x509_obj, 0, sizeof(x509_obj));
-
-    X509_STORE_CTX_init(&store_ctx, crl_ent->crl, NULL, NULL);
-    res = X509_STORE_get_by_subject(&store_ctx, X509_LU_CRL, issuer, &x509_obj);
-    crl = x509_obj.data.crl;
-
-    if ((res > 0) && crl != NULL) {
-        int num_revoked;
-        int i;
-
-
-        num_revoked = sk_X509_REVOKED_num(X509_CRL_get_REVOKED(crl));
-
-        for (i = 0; i < num_revoked; i++) {
-            X509_REVOKED * revoked;
-            ASN1_INTEGER * asn1_serial;
-
-            revoked     = sk_X509_REVOKED_value(X509_CRL_get_REVOKED(crl), i);
-            asn1_serial = revoked->serialNumber;
-
-            if (!ASN1_INTEGER_cmp(asn1_serial, X509_get_serialNumber(cert))) {
-                X509_OBJECT_free_contents(&x509_obj);
-                LOGI("SSL: Certificate revoked by CRL:%s", X509_NAME_oneline(subject, buf, kSz));
-                return 0;
-            }
-        }
-
-        X509_OBJECT_free_contents(&x509_obj);
-    }
-
-#ifdef RPROXY_DEBUG
-    if (ok) {
-        LOGD("SSL: CRL ok", X509_NAME_oneline(subject, buf, kSz));
-    }
-#endif
-
-#endif//0
-
-    return ok;
-} /* ssl_verify_crl */
 
 int
 ssl_x509_verifyfn(int ok, X509_STORE_CTX* store)
@@ -967,6 +975,15 @@ ssl_x509_verifyfn(int ok, X509_STORE_CTX* store)
     rproxy     = evthr_get_aux(connection->thread);
     assert(rproxy != NULL);
 
+    if (!ok && err == X509_V_ERR_UNABLE_TO_GET_CRL)
+    {
+        /* only certificates whose issuer has a CRL are checked against one */
+        ok  = 1;
+        err = X509_V_OK;
+
+        X509_STORE_CTX_set_error(store, err);
+    }
+
     if (depth > ssl_cfg->verify_depth)
     {
         ok  = 0;
@@ -981,21 +998,9 @@ ssl_x509_verifyfn(int ok, X509_STORE_CTX* store)
             err, X509_verify_cert_error_string(err), depth, buf);
     }
 
-    /* right now the only thing using the evhtp argument is the crl_ent_t's, in
-     * the future this will become more generic. So here we check to see if the
-     * CRL checking is enabled, and if it is, do CRL verification.
+    /* revocation is checked by the verification calling this when CRL
+     * checking is enabled, see ssl_crl_verify_cert().
      */
-    if (connection->htp->arg)
-    {
-        ssl_crl_ent_t * crl_ent = (ssl_crl_ent_t *)connection->htp->arg;
-
-        pthread_mutex_lock(&crl_ent->lock);
-        {
-            ok = ssl_verify_crl(ok, store, (ssl_crl_ent_t *)connection->htp->arg);
-        }
-        pthread_mutex_unlock(&crl_ent->lock);
-    }
-
     return ok;
 } /* ssl_x509_verifyfn */
 
@@ -1005,3 +1010,35 @@ ssl_x509_issuedcb(X509_STORE_CTX* ctx, X509* x, X509* issuer)
     LOGD("(%p, %p, %p)", ctx, x, issuer);
     return 1;
 }
+
+/* ALPN protocol lists in wire format, in server preference order. */
+static const unsigned char alpn_h2_http11[] = "\x02h2\x08http/1.1";
+static const unsigned char alpn_http11[]    = "\x08http/1.1";
+
+static int
+ssl_alpn_selectcb(SSL* ssl, const unsigned char** out, unsigned char* outlen,
+                  const unsigned char* in, unsigned int inlen, void* arg)
+{
+    LOGD("(%p, %p, %p, %p, %u, %p)", ssl, out, outlen, in, inlen, arg);
+
+    const unsigned char* protos = arg ? alpn_h2_http11 : alpn_http11;
+    unsigned int protos_len = arg ? sizeof(alpn_h2_http11) - 1 : sizeof(alpn_http11) - 1;
+
+    if (SSL_select_next_proto((unsigned char**)out, outlen, protos, protos_len, in, inlen) != OPENSSL_NPN_NEGOTIATED)
+    {
+        /* carry on without ALPN; the client falls back to http/1.1 */
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    return SSL_TLSEXT_ERR_OK;
+}
+
+void
+ssl_alpn_init(evhtp_t* htp, bool enable_http2)
+{
+    LOGD("(%p, %u)", htp, enable_http2);
+
+    if (htp && htp->ssl_ctx)
+    {
+        SSL_CTX_set_alpn_select_cb(htp->ssl_ctx, ssl_alpn_selectcb, enable_http2 ? GINT_TO_POINTER(1) : NULL);
+    }
+}
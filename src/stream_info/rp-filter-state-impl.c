@@ -23,6 +23,9 @@ struct _RpFilterStateImpl {
     RpFilterStateLifeSpan_e m_life_span;
 //TODO...flat_hash_map<std::string, std::unique_ptr<FilterObject>> data_storage_;
     UNIQUE_PTR(GHashTable) m_data_storage;
+    // Inline storage for keys registered with rp_filter_state_slot_register().
+    gpointer m_slots[RP_FILTER_STATE_MAX_SLOTS];
+    guint32 m_slot_mask;
 };
 
 static void filter_state_iface_init(RpFilterStateInterface* iface);
@@ -76,10 +79,29 @@ NOISY_MSG_("calling rp_filter_state_impl_new(%p, %d)", ancestor, parent_life_spa
     }
 }
 
+static inline bool
+has_slot_internally(RpFilterStateImpl* self, RpFilterStateSlot slot)
+{
+    return (self->m_slot_mask & (1u << slot)) != 0;
+}
+
+static bool
+has_slot(RpFilterStateImpl* self, RpFilterStateSlot slot)
+{
+    NOISY_MSG_("(%p, %d)", self, slot);
+    return has_slot_internally(self, slot) ||
+            (self->m_parent && has_slot(RP_FILTER_STATE_IMPL(self->m_parent), slot));
+}
+
 static bool
 has_data_with_name_internally(RpFilterStateImpl* self, const char* data_name)
 {
     NOISY_MSG_("(%p, %p(%s))", self, data_name, data_name);
+    RpFilterStateSlot slot = rp_filter_state_slot_lookup(data_name);
+    if (slot != RP_FILTER_STATE_SLOT_INVALID)
+    {
+        return has_slot_internally(self, slot);
+    }
     return self->m_data_storage && g_hash_table_contains(self->m_data_storage, data_name);
 }
 
@@ -98,11 +120,66 @@ life_span_i(RpFilterState* self)
     return RP_FILTER_STATE_IMPL(self)->m_life_span;
 }
 
+static void
+set_slot_data_i(RpFilterState* self, RpFilterStateSlot slot, gpointer data, RpFilterStateStateType_e state_type, RpFilterStateLifeSpan_e life_span)
+{
+    NOISY_MSG_("(%p, %d, %p, %d, %d)", self, slot, data, state_type, life_span);
+
+    g_return_if_fail(slot >= 0 && slot < RP_FILTER_STATE_MAX_SLOTS);
+
+    RpFilterStateImpl* me = RP_FILTER_STATE_IMPL(self);
+    if (life_span > me->m_life_span)
+    {
+        if (has_slot_internally(me, slot))
+        {
+            NOISY_MSG_("FilterStateAccessViolation: FilterState::setData called twice with conflicting lifespan on the data_name.");
+            return;
+        }
+        maybe_create_parent(me, NULL);
+        rp_filter_state_set_slot_data(me->m_parent, slot, data, state_type, life_span);
+        return;
+    }
+    if (me->m_parent && has_slot(RP_FILTER_STATE_IMPL(me->m_parent), slot))
+    {
+        NOISY_MSG_("FilterStateAccessViolation: FilterState::setData called twice with conflicting life_span on the same data_name.");
+        return;
+    }
+    me->m_slots[slot] = data;
+    me->m_slot_mask |= 1u << slot;
+}
+
+static gpointer
+get_slot_data_i(RpFilterState* self, RpFilterStateSlot slot)
+{
+    NOISY_MSG_("(%p, %d)", self, slot);
+
+    g_return_val_if_fail(slot >= 0 && slot < RP_FILTER_STATE_MAX_SLOTS, NULL);
+
+    RpFilterStateImpl* me = RP_FILTER_STATE_IMPL(self);
+    if (has_slot_internally(me, slot))
+    {
+        return me->m_slots[slot];
+    }
+    if (me->m_parent)
+    {
+        NOISY_MSG_("checking parent %p", me->m_parent);
+        return rp_filter_state_get_slot_data(me->m_parent, slot);
+    }
+    return NULL;
+}
+
 static void
 set_data_i(RpFilterState* self, const char* data_name, gpointer data, RpFilterStateStateType_e state_type, RpFilterStateLifeSpan_e life_span)
 {
     NOISY_MSG_("(%p, %p(%s), %p, %d, %d)", self, data_name, data_name, data, state_type, life_span);
 
+    RpFilterStateSlot slot = rp_filter_state_slot_lookup(data_name);
+    if (slot != RP_FILTER_STATE_SLOT_INVALID)
+    {
+        set_slot_data_i(self, slot, data, state_type, life_span);
+        return;
+    }
+
     RpFilterStateImpl* me = RP_FILTER_STATE_IMPL(self);
 NOISY_MSG_("life span %d(%d)", life_span, me->m_life_span);
     if (life_span > me->m_life_span)
@@ -129,6 +206,13 @@ static gpointer
 get_data_i(RpFilterState* self, const char* data_name)
 {
     NOISY_MSG_("(%p, %p(%s))", self, data_name, data_name);
+
+    RpFilterStateSlot slot = rp_filter_state_slot_lookup(data_name);
+    if (slot != RP_FILTER_STATE_SLOT_INVALID)
+    {
+        return get_slot_data_i(self, slot);
+    }
+
     RpFilterStateImpl* me = RP_FILTER_STATE_IMPL(self);
     gpointer it = me->m_data_storage ?
                             g_hash_table_lookup(me->m_data_storage, data_name) : NULL;
@@ -151,6 +235,8 @@ filter_state_iface_init(RpFilterStateInterface* iface)
     iface->life_span = life_span_i;
     iface->set_data = set_data_i;
     iface->get_data = get_data_i;
+    iface->set_slot_data = set_slot_data_i;
+    iface->get_slot_data = get_slot_data_i;
 }
 
 OVERRIDE void
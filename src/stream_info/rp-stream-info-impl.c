@@ -358,7 +358,7 @@ rp_stream_info_impl_class_init(RpStreamInfoImplClass* klass)
                                                     "Protocol",
                                                     "Protocol",
                                                     EVHTP_PROTO_INVALID,
-                                                    EVHTP_PROTO_11,
+                                                    EVHTP_PROTO_2,
                                                     EVHTP_PROTO_INVALID,
                                                     G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
     obj_properties[PROP_DOWNSTREAM_INFO_PROVIDER] = g_param_spec_object("downstream-info-provider",
@@ -67,6 +67,20 @@ choose_host_i(RpThreadLocalCluster* self, RpLoadBalancerContext* context)
     {
         RpClusterEntry* me = RP_CLUSTER_ENTRY(self);
         RpHostSelectionResponse host_selection = rp_load_balancer_choose_host(me->m_lb, context);
+
+        // Give the context a chance to steer away from hosts it has already
+        // tried (retries, hedged requests). The last candidate wins if every
+        // attempt is rejected.
+        guint32 max_attempts = context ? rp_load_balancer_context_host_selection_retry_count(context) + 1 : 1;
+        for (guint32 i = 1; i < max_attempts &&
+                            host_selection.m_host &&
+                            !host_selection.m_cancelable &&
+                            rp_load_balancer_context_should_select_another_host(context, host_selection.m_host); ++i)
+        {
+            NOISY_MSG_("rejected host %p, attempt %u", host_selection.m_host, i);
+            host_selection = rp_load_balancer_choose_host(me->m_lb, context);
+        }
+
         if (host_selection.m_host || host_selection.m_cancelable)
         {
             NOISY_MSG_("selected host %p", host_selection.m_host);
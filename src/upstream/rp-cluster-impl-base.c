@@ -14,7 +14,10 @@
 #endif
 
 #include "rp-cluster-factory.h"
+#include "common/common/rp-callback-impl.h"
 #include "server/rp-transport-socket-config-impl.h"
+#include "upstream/rp-health-checker-impl.h"
+#include "upstream/rp-outlier-detection-impl.h"
 #include "upstream/rp-upstream-impl.h"
 
 typedef struct _RpClusterImplBasePrivate RpClusterImplBasePrivate;
@@ -23,6 +26,8 @@ struct _RpClusterImplBasePrivate {
     RpClusterInfo* m_info;
 
     RpMainPrioritySetImpl* m_priority_set;
+    RpOutlierDetectorImpl* m_outlier_detector;
+    RpHealthCheckerImpl* m_health_checker;
 
     RpClusterCfgPtr m_config;
     RpClusterFactoryContext* m_cluster_context;
@@ -32,7 +37,10 @@ struct _RpClusterImplBasePrivate {
     RpClusterInitializeCb m_initialize_complete_callback;
     gpointer m_initialize_complete_callback_arg;
 
-    guint64 m_pending_initialize_health_checks;
+    // Hosts not yet probed while initialization waits on the health
+    // checker, with the callback removing them as their probes complete.
+    GHashTable/*<RpHost*>*/* m_pending_initialize_health_checks;
+    RpCallbackHandle* m_initial_health_check_cb;
 
     RpStatusCode_e* m_creation_status;
 
@@ -61,6 +69,8 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE(RpClusterImplBase, rp_cluster_impl_base, G_TYPE
 #define PRIV(obj) \
     ((RpClusterImplBasePrivate*) rp_cluster_impl_base_get_instance_private(RP_CLUSTER_IMPL_BASE(obj)))
 
+static void reload_healthy_hosts(RpClusterImplBase* self, RpHost* host);
+
 static void
 finish_initialization(RpClusterImplBase* self)
 {
@@ -74,7 +84,10 @@ finish_initialization(RpClusterImplBase* self)
     me->m_initialize_complete_callback = NULL;
     me->m_initialize_complete_callback_arg = NULL;
 
-    //TODO...if (health_checker_ != nullptr)...
+    if (me->m_health_checker)
+    {
+        reload_healthy_hosts(self, NULL);
+    }
 
     if (snapped_callback)
     {
@@ -86,20 +99,110 @@ finish_initialization(RpClusterImplBase* self)
     }
 }
 
+static void
+clear_pending_initialize_health_checks(RpClusterImplBasePrivate* me)
+{
+    NOISY_MSG_("(%p)", me);
+    if (me->m_initial_health_check_cb)
+    {
+        rp_callback_holder_remove(RP_CALLBACK_HOLDER(g_steal_pointer(&me->m_initial_health_check_cb)));
+    }
+    g_clear_pointer(&me->m_pending_initialize_health_checks, g_hash_table_unref);
+}
+
+static RpStatusCode_e
+on_initial_health_check_complete_cb(RpHost* host, RpHealthTransition_e changed_state G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %d, %p)", host, changed_state, arg);
+    RpClusterImplBase* self = RP_CLUSTER_IMPL_BASE(arg);
+    RpClusterImplBasePrivate* me = PRIV(self);
+    // A host is probed repeatedly; only its first completion counts.
+    if (me->m_pending_initialize_health_checks &&
+        g_hash_table_remove(me->m_pending_initialize_health_checks, host) &&
+        g_hash_table_size(me->m_pending_initialize_health_checks) == 0)
+    {
+        clear_pending_initialize_health_checks(me);
+        finish_initialization(self);
+    }
+    return RpStatusCode_Ok;
+}
+
 static void
 on_init_done(RpClusterImplBase* self)
 {
     NOISY_MSG_("(%p(%s))", self, G_OBJECT_TYPE_NAME(self));
     //TODO...init()->configUpdateStats().warming_state_.set(0);
-    //TODO...if (health_checker_)...
+    RpClusterImplBasePrivate* me = PRIV(self);
+    if (me->m_health_checker && !me->m_pending_initialize_health_checks)
+    {
+        // Hold initialization until every host has been probed once.
+        me->m_pending_initialize_health_checks = g_hash_table_new_full(g_direct_hash, g_direct_equal, g_object_unref, NULL);
+        const RpHostSetPtrVector* host_sets = rp_priority_set_host_sets_per_priority(RP_PRIORITY_SET(me->m_priority_set));
+        for (guint priority = 0; priority < rp_host_set_ptr_vector_size(host_sets); ++priority)
+        {
+            const RpHostVector* hosts = rp_host_set_get_hosts(rp_host_set_ptr_vector_get(host_sets, priority));
+            for (guint i = 0; i < rp_host_vector_len(hosts); ++i)
+            {
+                g_hash_table_add(me->m_pending_initialize_health_checks, g_object_ref(rp_host_vector_get(hosts, i)));
+            }
+        }
+        if (g_hash_table_size(me->m_pending_initialize_health_checks) == 0)
+        {
+            g_clear_pointer(&me->m_pending_initialize_health_checks, g_hash_table_unref);
+        }
+        else
+        {
+            me->m_initial_health_check_cb = rp_health_checker_add_host_check_complete_cb(RP_HEALTH_CHECKER(me->m_health_checker),
+                                                                                            on_initial_health_check_complete_cb,
+                                                                                            self);
+        }
+    }
 
-    if (PRIV(self)->m_pending_initialize_health_checks == 0)
+    if (!me->m_pending_initialize_health_checks)
     {
         NOISY_MSG_("finished %p(%s)", self, G_OBJECT_TYPE_NAME(self));
         finish_initialization(self);
     }
 }
 
+static void
+reload_healthy_hosts(RpClusterImplBase* self, RpHost* host)
+{
+    NOISY_MSG_("(%p(%s), %p)", self, G_OBJECT_TYPE_NAME(self), host);
+
+    // Every priority is rebuilt; the changed host's own priority is enough
+    // today, but hosts can move priorities on update.
+    RpPrioritySet* priority_set = RP_PRIORITY_SET(PRIV(self)->m_priority_set);
+    const RpHostSetPtrVector* host_sets = rp_priority_set_host_sets_per_priority(priority_set);
+    for (guint priority = 0; priority < rp_host_set_ptr_vector_size(host_sets); ++priority)
+    {
+        RpHostVector* hosts = rp_host_set_ref_hosts(rp_host_set_ptr_vector_get(host_sets, priority));
+        RpPrioritySetUpdateHostsParams params = rp_host_set_impl_partition_hosts_take(&hosts);
+        // The host set takes its own references and clears these pointers.
+        g_auto(RpPrioritySetUpdateHostsParams) owned = params;
+        rp_priority_set_update_hosts(priority_set, priority, &params, NULL, NULL, NULL, NULL, NULL);
+    }
+}
+
+static RpStatusCode_e
+on_outlier_changed_state_cb(RpHost* host, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", host, arg);
+    reload_healthy_hosts(RP_CLUSTER_IMPL_BASE(arg), host);
+    return RpStatusCode_Ok;
+}
+
+static RpStatusCode_e
+on_health_check_complete_cb(RpHost* host, RpHealthTransition_e changed_state, gpointer arg)
+{
+    NOISY_MSG_("(%p, %d, %p)", host, changed_state, arg);
+    if (changed_state == RpHealthTransition_Changed)
+    {
+        reload_healthy_hosts(RP_CLUSTER_IMPL_BASE(arg), host);
+    }
+    return RpStatusCode_Ok;
+}
+
 static RpClusterInfoConstSharedPtr
 info_i(RpCluster* self)
 {
@@ -203,6 +306,27 @@ constructed(GObject* obj)
     me->m_info = RP_CLUSTER_INFO(cluster_info_impl_create(me, server_context));
     me->m_priority_set = rp_main_priority_set_impl_new();
     rp_priority_set_impl_get_or_create_host_set(RP_PRIORITY_SET_IMPL(me->m_priority_set), 0);
+    if (me->m_config->outlier_detection_set)
+    {
+        RpDispatcher* dispatcher = rp_common_factory_context_main_thread_dispatcher(RP_COMMON_FACTORY_CONTEXT(server_context));
+        me->m_outlier_detector = rp_outlier_detector_impl_create(RP_PRIORITY_SET(me->m_priority_set),
+                                                                    &me->m_config->outlier_detection,
+                                                                    dispatcher);
+        rp_outlier_detector_add_changed_state_cb(RP_OUTLIER_DETECTOR(me->m_outlier_detector),
+                                                    on_outlier_changed_state_cb,
+                                                    obj);
+    }
+    if (me->m_config->health_check_set)
+    {
+        RpDispatcher* dispatcher = rp_common_factory_context_main_thread_dispatcher(RP_COMMON_FACTORY_CONTEXT(server_context));
+        me->m_health_checker = rp_health_checker_impl_create(RP_PRIORITY_SET(me->m_priority_set),
+                                                                &me->m_config->health_check,
+                                                                dispatcher);
+        rp_health_checker_add_host_check_complete_cb(RP_HEALTH_CHECKER(me->m_health_checker),
+                                                        on_health_check_complete_cb,
+                                                        obj);
+        rp_health_checker_start(RP_HEALTH_CHECKER(me->m_health_checker));
+    }
     *me->m_creation_status = RpStatusCode_Ok;
 }
 
@@ -213,7 +337,12 @@ dispose(GObject* obj)
 
     RpClusterImplBasePrivate* me = PRIV(obj);
 
+    // The detector's and checker's member update callbacks live in the
+    // priority set.
     g_clear_object(&me->m_priority_set);
+    g_clear_object(&me->m_outlier_detector);
+    clear_pending_initialize_health_checks(me);
+    g_clear_object(&me->m_health_checker);
 NOISY_MSG_("%p, clearing info %p(%u)", obj, me->m_info, G_OBJECT(me->m_info)->ref_count);
     g_clear_object(&me->m_info);
     g_clear_object(&me->m_transport_factory_context);
@@ -256,7 +385,8 @@ rp_cluster_impl_base_init(RpClusterImplBase* self)
 {
     LOGD("(%p(%s))", self, G_OBJECT_TYPE_NAME(self));
     RpClusterImplBasePrivate* me = PRIV(self);
-    me->m_pending_initialize_health_checks = 0;
+    me->m_pending_initialize_health_checks = NULL;
+    me->m_initial_health_check_cb = NULL;
     me->m_wait_for_warm_on_init = true; //REVISIT - config-driven;
 }
 
@@ -121,10 +121,16 @@ upstream_http_protocol_i(RpClusterInfoConstSharedPtr self, evhtp_proto downstrea
 {
     NOISY_MSG_("(%p, %d)", self, downstream_protocol);
     evhtp_proto* rval = g_malloc0(sizeof(*rval));
+    if (CLUSTER_INFO_IMPL(self)->m_config->http2_protocol_options_set)
+    {
+        *rval = EVHTP_PROTO_2;
+        return rval;
+    }
     //TODO...features_ & USE_DOWNSTREAM_PROTOCOL
     if (downstream_protocol != EVHTP_PROTO_INVALID)
     {
-        if (downstream_protocol == EVHTP_PROTO_10)
+        // Only clusters configured for it are spoken to in HTTP/2.
+        if (downstream_protocol == EVHTP_PROTO_10 || downstream_protocol == EVHTP_PROTO_2)
         {
             *rval = EVHTP_PROTO_11;
             return rval;
@@ -132,11 +138,19 @@ upstream_http_protocol_i(RpClusterInfoConstSharedPtr self, evhtp_proto downstrea
         *rval = downstream_protocol;
         return rval;
     }
-    //TODO...HTTP2, HTTP3, etc.
+    //TODO...HTTP3, etc.
     *rval = EVHTP_PROTO_11;
     return rval;
 }
 
+static const RpHttp2ProtocolOptionsCfg*
+http2_options_i(RpClusterInfoConstSharedPtr self)
+{
+    NOISY_MSG_("(%p)", self);
+    const RpClusterCfg* config = CLUSTER_INFO_IMPL(self)->m_config;
+    return config->http2_protocol_options_set ? &config->http2_protocol_options : NULL;
+}
+
 static const RpCustomClusterTypeCfg*
 cluster_type_i(RpClusterInfoConstSharedPtr self)
 {
@@ -171,6 +185,7 @@ cluster_info_iface_init(RpClusterInfoInterface* iface)
     iface->type = type_i;
     iface->transport_socket_context = transport_socket_context_i;
     iface->upstream_http_protocol = upstream_http_protocol_i;
+    iface->http2_options = http2_options_i;
     iface->cluster_type = cluster_type_i;
     iface->load_balancer_config = load_balancer_config_i;
     iface->load_balancer_factory = load_balancer_factory_i;
@@ -284,7 +299,10 @@ constructed(RpClusterInfoImpl* self)
     const RpClusterCfg* config = self->m_config;
     const RpClusterLoadAssignmentCfg* load_assignment = rp_cluster_cfg_load_assignment(config);
     const char* cluster_name = rp_cluster_load_assignment_cfg_cluster_name(load_assignment);
-    self->m_resource_manager = rp_resource_manager_impl_new(cluster_name, 1024, 1024, 1024, 3, G_MAXUINT64, G_MAXUINT64);
+    const RpRetryBudgetCfg* retry_budget = config->retry_budget_set ? &config->retry_budget : NULL;
+    self->m_resource_manager = rp_resource_manager_impl_new(cluster_name, 1024, 1024, 1024, 3, G_MAXUINT64, G_MAXUINT64,
+                                                            retry_budget ? retry_budget->budget_percent : 0.0,
+                                                            retry_budget ? retry_budget->min_retry_concurrency : 3);
     self->m_cluster_type = rp_cluster_cfg_has_cluster_type(config) ?
                             rp_cluster_cfg_cluster_type(config) : NULL;
 self->m_max_requests_per_connection = 1024;//TODO...config...
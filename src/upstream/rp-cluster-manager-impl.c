@@ -776,6 +776,36 @@ init_cluster_type_cfg(RpCustomClusterTypeCfg* self, cluster_type_cfg_t* cfg)
     //TODO...else if (...) {...}
 }
 
+static inline void
+init_outlier_detection_cfg(RpOutlierDetectionCfg* self, const outlier_detection_cfg_t* cfg)
+{
+    NOISY_MSG_("(%p, %p)", self, cfg);
+    self->consecutive_5xx = cfg->consecutive_5xx;
+    self->consecutive_gateway_failure = cfg->consecutive_gateway_failure;
+    self->consecutive_local_origin_failure = cfg->consecutive_local_origin_failure;
+    self->interval_ms = cfg->interval.tv_sec * 1000 + cfg->interval.tv_usec / 1000;
+    self->base_ejection_time_ms = cfg->base_ejection_time.tv_sec * 1000 + cfg->base_ejection_time.tv_usec / 1000;
+    self->max_ejection_time_ms = cfg->max_ejection_time.tv_sec * 1000 + cfg->max_ejection_time.tv_usec / 1000;
+    self->max_ejection_percent = cfg->max_ejection_percent;
+    self->success_rate_minimum_hosts = cfg->success_rate_minimum_hosts;
+    self->success_rate_request_volume = cfg->success_rate_request_volume;
+    self->success_rate_stdev_factor = cfg->success_rate_stdev_factor;
+    self->latency_threshold_factor = cfg->latency_threshold_factor;
+}
+
+static inline void
+init_health_check_cfg(RpHealthCheckCfg* self, const health_check_cfg_t* cfg)
+{
+    NOISY_MSG_("(%p, %p)", self, cfg);
+    self->type = cfg->type == health_check_type_tcp ? RpHealthCheckerType_TCP : RpHealthCheckerType_HTTP;
+    self->timeout_ms = cfg->timeout.tv_sec * 1000 + cfg->timeout.tv_usec / 1000;
+    self->interval_ms = cfg->interval.tv_sec * 1000 + cfg->interval.tv_usec / 1000;
+    self->interval_jitter_ms = cfg->interval_jitter.tv_sec * 1000 + cfg->interval_jitter.tv_usec / 1000;
+    self->unhealthy_threshold = cfg->unhealthy_threshold;
+    self->healthy_threshold = cfg->healthy_threshold;
+    g_strlcpy(self->path, cfg->path ? cfg->path : "/", sizeof(self->path));
+}
+
 static inline void
 init_cluster_cfg(RpClusterCfg* self, rule_t* rule)
 {
@@ -797,8 +827,31 @@ init_cluster_cfg(RpClusterCfg* self, rule_t* rule)
     self->per_connection_buffer_limit_bytes = 1024*1024;
 //    self->lb_policy = translate_lb_policy(rule_cfg);
 rp_cluster_cfg_set_lb_policy(self, RpLbPolicy_CLUSTER_PROVIDED);
-    self->dns_lookup_family = RpDnsLookupFamily_AUTO;
+    self->dns_lookup_family = rule_cfg->happy_eyeballs ? RpDnsLookupFamily_ALL : RpDnsLookupFamily_AUTO;
     self->connection_pool_per_downstream_connection = false;
+    if (rule_cfg->upstream_http2)
+    {
+        self->http2_protocol_options.max_concurrent_streams = rule_cfg->max_concurrent_streams;
+        self->http2_protocol_options.initial_stream_window_size = RpHttp2Settings.m_initial_stream_window_size;
+        self->http2_protocol_options.initial_connection_window_size = RpHttp2Settings.m_initial_connection_window_size;
+        self->http2_protocol_options_set = true;
+    }
+    if (rule_cfg->retry_budget > 0.0)
+    {
+        self->retry_budget.budget_percent = rule_cfg->retry_budget;
+        self->retry_budget.min_retry_concurrency = rule_cfg->retry_budget_min_concurrency;
+        self->retry_budget_set = true;
+    }
+    if (rule_cfg->outlier_detection)
+    {
+        init_outlier_detection_cfg(&self->outlier_detection, rule_cfg->outlier_detection);
+        self->outlier_detection_set = true;
+    }
+    if (rule_cfg->health_check)
+    {
+        init_health_check_cfg(&self->health_check, rule_cfg->health_check);
+        self->health_check_set = true;
+    }
     self->rule = rule;
 }
 
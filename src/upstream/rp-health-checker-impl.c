@@ -0,0 +1,667 @@
+/*
+ * rp-health-checker-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_health_checker_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_health_checker_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "common/common/rp-callback-impl.h"
+#include "upstream/rp-health-checker-impl.h"
+#include "rp-codec-client-prod.h"
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "rp-http-utility.h"
+
+#define USER_AGENT "rproxy-health-check"
+
+struct _RpActiveHealthCheckSession {
+    GObject parent_instance;
+
+    // Borrowed; the checker owns this session.
+    RpHealthCheckerImpl* m_parent;
+    RpHost* m_host;
+
+    RpTimer* m_interval_timer;
+    RpTimer* m_timeout_timer;
+
+    // Exactly one of these is set while a probe is in flight.
+    RpNetworkClientConnection* m_connection;
+    RpCodecClient* m_client;
+
+    evhtp_headers_t* m_response_headers;
+    evhtp_res m_response_code;
+
+    guint32 m_num_healthy;
+    guint32 m_num_unhealthy;
+
+    bool m_probing : 1;
+    bool m_first_check : 1;
+};
+
+struct _RpHealthCheckerImpl {
+    GObject parent_instance;
+
+    // Borrowed; the cluster owns both the priority set and this checker.
+    RpPrioritySet* m_priority_set;
+    RpDispatcher* m_dispatcher;
+    RpHealthCheckCfg m_config;
+
+    GHashTable* m_sessions; // RpHost* -> RpActiveHealthCheckSession*
+    RpCallbackManager* m_callbacks;
+
+    bool m_started : 1;
+};
+
+static void network_connection_callbacks_iface_init(RpNetworkConnectionCallbacksInterface* iface);
+static void stream_decoder_iface_init(RpStreamDecoderInterface* iface);
+static void response_decoder_iface_init(RpResponseDecoderInterface* iface);
+static void health_checker_iface_init(RpHealthCheckerInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpActiveHealthCheckSession, rp_active_health_check_session, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_NETWORK_CONNECTION_CALLBACKS, network_connection_callbacks_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_STREAM_DECODER, stream_decoder_iface_init)
+    G_IMPLEMENT_INTERFACE(RP_TYPE_RESPONSE_DECODER, response_decoder_iface_init)
+)
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpHealthCheckerImpl, rp_health_checker_impl, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_HEALTH_CHECKER, health_checker_iface_init)
+)
+
+static inline const char*
+hostname(RpActiveHealthCheckSession* self)
+{
+    return rp_host_description_hostname(RP_HOST_DESCRIPTION(self->m_host));
+}
+
+static void
+run_callbacks(RpHealthCheckerImpl* self, RpHost* host, RpHealthTransition_e changed_state)
+{
+    NOISY_MSG_("(%p, %p, %d)", self, host, changed_state);
+    // A callback may remove itself; step past it first.
+    for (GList* itr = rp_callback_manager_callbacks(self->m_callbacks), *next; itr; itr = next)
+    {
+        next = itr->next;
+        RpCallbackHandlePtr handle = itr->data;
+        RpHealthCheckHostStatusCb cb = (RpHealthCheckHostStatusCb)rp_callback_handle_cb(handle);
+        RpStatusCode_e status = cb(host, changed_state, rp_callback_handle_arg(handle));
+        if (status != RpStatusCode_Ok)
+        {
+            LOGE("host check complete callback failed");
+        }
+    }
+}
+
+static void
+close_probe_connection(RpActiveHealthCheckSession* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    // Closing raises a close event on this session; m_probing is already
+    // clear so it is ignored. The dispatcher frees the connection once the
+    // current callback has unwound.
+    RpDispatcher* dispatcher = self->m_parent->m_dispatcher;
+    if (self->m_client)
+    {
+        rp_codec_client_close(self->m_client, RpNetworkConnectionCloseType_NoFlush);
+        rp_dispatcher_deferred_delete_take(dispatcher, G_OBJECT(g_steal_pointer(&self->m_client)));
+    }
+    if (self->m_connection)
+    {
+        rp_network_connection_close(RP_NETWORK_CONNECTION(self->m_connection), RpNetworkConnectionCloseType_NoFlush);
+        rp_dispatcher_deferred_delete_take(dispatcher, G_OBJECT(g_steal_pointer(&self->m_connection)));
+    }
+    g_clear_pointer(&self->m_response_headers, rp_header_map_free);
+}
+
+static void
+schedule_next_probe(RpActiveHealthCheckSession* self)
+{
+    NOISY_MSG_("(%p)", self);
+    const RpHealthCheckCfg* config = &self->m_parent->m_config;
+    guint64 interval_ms = config->interval_ms;
+    if (config->interval_jitter_ms > 0)
+    {
+        // Spread the probes of a cluster so hosts are not all hit at once.
+        interval_ms += g_random_int_range(0, (gint32)MIN(config->interval_jitter_ms, G_MAXINT32 - 1) + 1);
+    }
+    rp_timer_enable_timer(self->m_interval_timer, interval_ms);
+}
+
+static void
+handle_success(RpActiveHealthCheckSession* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHealthTransition_e changed_state = RpHealthTransition_Unchanged;
+    self->m_num_unhealthy = 0;
+    if (rp_host_health_flag_get(self->m_host, FAILED_ACTIVE_HC))
+    {
+        // A host that has never been checked goes healthy on its first pass.
+        if (self->m_first_check || ++self->m_num_healthy >= self->m_parent->m_config.healthy_threshold)
+        {
+            rp_host_health_flag_clear(self->m_host, FAILED_ACTIVE_HC);
+            self->m_num_healthy = 0;
+            changed_state = RpHealthTransition_Changed;
+            LOGI("host %s passed active health check", hostname(self));
+        }
+        else
+        {
+            changed_state = RpHealthTransition_ChangePending;
+        }
+    }
+    else
+    {
+        self->m_num_healthy = 0;
+    }
+    if (self->m_first_check)
+    {
+        // The host set was built before this host was marked failed.
+        self->m_first_check = false;
+        changed_state = RpHealthTransition_Changed;
+    }
+
+    run_callbacks(self->m_parent, self->m_host, changed_state);
+}
+
+static void
+handle_failure(RpActiveHealthCheckSession* self, const char* reason)
+{
+    NOISY_MSG_("(%p, %p(%s))", self, reason, reason);
+
+    RpHealthTransition_e changed_state = RpHealthTransition_Unchanged;
+    self->m_num_healthy = 0;
+    if (!rp_host_health_flag_get(self->m_host, FAILED_ACTIVE_HC))
+    {
+        if (++self->m_num_unhealthy >= self->m_parent->m_config.unhealthy_threshold)
+        {
+            rp_host_health_flag_set(self->m_host, FAILED_ACTIVE_HC);
+            self->m_num_unhealthy = 0;
+            changed_state = RpHealthTransition_Changed;
+            LOGI("host %s failed active health check (%s)", hostname(self), reason);
+        }
+        else
+        {
+            changed_state = RpHealthTransition_ChangePending;
+        }
+    }
+    else
+    {
+        LOGD("host %s still failing active health check (%s)", hostname(self), reason);
+        self->m_num_unhealthy = 0;
+    }
+    if (self->m_first_check)
+    {
+        self->m_first_check = false;
+        changed_state = RpHealthTransition_Changed;
+    }
+
+    run_callbacks(self->m_parent, self->m_host, changed_state);
+}
+
+static void
+on_probe_complete(RpActiveHealthCheckSession* self, bool success, const char* reason)
+{
+    NOISY_MSG_("(%p, %u, %p(%s))", self, success, reason, reason);
+
+    if (!self->m_probing)
+    {
+        NOISY_MSG_("not probing");
+        return;
+    }
+    self->m_probing = false;
+    rp_timer_disable_timer(self->m_timeout_timer);
+    close_probe_connection(self);
+
+    // Callbacks may rebuild the host sets and reconcile this session away,
+    // so keep it alive until the next probe is scheduled.
+    g_autoptr(RpActiveHealthCheckSession) keep_alive = g_object_ref(self);
+    if (success)
+    {
+        handle_success(self);
+    }
+    else
+    {
+        handle_failure(self, reason);
+    }
+    if (self->m_interval_timer)
+    {
+        schedule_next_probe(self);
+    }
+}
+
+static void
+send_request(RpActiveHealthCheckSession* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    const char* authority = hostname(self);
+    if (!authority || !authority[0])
+    {
+        authority = rp_cluster_info_name(rp_host_description_cluster(RP_HOST_DESCRIPTION(self->m_host)));
+    }
+
+    RpRequestEncoder* request_encoder = rp_codec_client_new_stream(self->m_client, RP_RESPONSE_DECODER(self));
+    evhtp_headers_t* request_headers = rp_header_map_new();
+    rp_header_map_add_header(request_headers, RpHeaderValues.Method, RpHeaderValues.MethodValues.Get, false, false);
+    rp_header_map_add_header(request_headers, RpHeaderValues.Path, self->m_parent->m_config.path, false, false);
+    rp_header_map_add_header(request_headers, RpHeaderValues.Host, authority, false, false);
+    rp_header_map_add_header(request_headers, RpHeaderValues.UserAgent, USER_AGENT, false, false);
+    rp_header_map_add_header(request_headers, RpHeaderValues.Connection, RpHeaderValues.ConnectionValues.Close, false, false);
+    RpStatusCode_e status = rp_request_encoder_encode_headers(request_encoder, request_headers, true);
+    rp_header_map_free(request_headers);
+    if (status != RpStatusCode_Ok)
+    {
+        on_probe_complete(self, false, "encode failed");
+    }
+}
+
+static void
+on_event_i(RpNetworkConnectionCallbacks* self, RpNetworkConnectionEvent_e event)
+{
+    NOISY_MSG_("(%p, %d)", self, event);
+
+    RpActiveHealthCheckSession* me = RP_ACTIVE_HEALTH_CHECK_SESSION(self);
+    if (!me->m_probing)
+    {
+        NOISY_MSG_("not probing");
+        return;
+    }
+
+    switch (event)
+    {
+        case RpNetworkConnectionEvent_Connected:
+        case RpNetworkConnectionEvent_ConnectedZeroRtt:
+            if (me->m_client)
+            {
+                send_request(me);
+            }
+            else
+            {
+                on_probe_complete(me, true, NULL);
+            }
+            break;
+        case RpNetworkConnectionEvent_RemoteClose:
+        case RpNetworkConnectionEvent_LocalClose:
+            on_probe_complete(me, false, "connection closed");
+            break;
+        default:
+            break;
+    }
+}
+
+static void
+on_above_write_buffer_high_water_mark_i(RpNetworkConnectionCallbacks* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static void
+on_below_write_buffer_low_watermark_i(RpNetworkConnectionCallbacks* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+static void
+network_connection_callbacks_iface_init(RpNetworkConnectionCallbacksInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->on_event = on_event_i;
+    iface->on_above_write_buffer_high_water_mark = on_above_write_buffer_high_water_mark_i;
+    iface->on_below_write_buffer_low_watermark = on_below_write_buffer_low_watermark_i;
+}
+
+static void
+on_response_complete(RpActiveHealthCheckSession* self)
+{
+    NOISY_MSG_("(%p)", self);
+    evhtp_res code = self->m_response_code;
+    if (code >= EVHTP_RES_OK && code < EVHTP_RES_MCHOICE)
+    {
+        on_probe_complete(self, true, NULL);
+    }
+    else
+    {
+        g_autofree char* reason = g_strdup_printf("response code %d", code);
+        on_probe_complete(self, false, reason);
+    }
+}
+
+static void
+decode_data_i(RpStreamDecoder* self, evbuf_t* data, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p(%zu), %u)", self, data, data ? evbuffer_get_length(data) : 0, end_stream);
+    if (data)
+    {
+        evbuffer_drain(data, evbuffer_get_length(data));
+    }
+    if (end_stream)
+    {
+        on_response_complete(RP_ACTIVE_HEALTH_CHECK_SESSION(self));
+    }
+}
+
+static void
+stream_decoder_iface_init(RpStreamDecoderInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->decode_data = decode_data_i;
+}
+
+static void
+decode_1xx_headers_i(RpResponseDecoder* self G_GNUC_UNUSED, evhtp_headers_t* response_headers G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p, %p)", self, response_headers);
+}
+
+static void
+decode_headers_i(RpResponseDecoder* self, evhtp_headers_t* response_headers, bool end_stream)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, response_headers, end_stream);
+
+    RpActiveHealthCheckSession* me = RP_ACTIVE_HEALTH_CHECK_SESSION(self);
+    // The codec hands over ownership; hold on to the map until the probe is
+    // torn down since the parser may still reference it.
+    g_clear_pointer(&me->m_response_headers, rp_header_map_free);
+    me->m_response_headers = response_headers;
+    me->m_response_code = http_utility_get_response_status(response_headers);
+    if (end_stream)
+    {
+        on_response_complete(me);
+    }
+}
+
+static void
+decode_trailers_i(RpResponseDecoder* self, evhtp_headers_t* trailers)
+{
+    NOISY_MSG_("(%p, %p)", self, trailers);
+    rp_header_map_free(trailers);
+    on_response_complete(RP_ACTIVE_HEALTH_CHECK_SESSION(self));
+}
+
+static void
+response_decoder_iface_init(RpResponseDecoderInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->decode_1xx_headers = decode_1xx_headers_i;
+    iface->decode_headers = decode_headers_i;
+    iface->decode_trailers = decode_trailers_i;
+}
+
+static void
+on_timeout_timer(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+    on_probe_complete(RP_ACTIVE_HEALTH_CHECK_SESSION(arg), false, "timeout");
+}
+
+static void
+start_probe(RpActiveHealthCheckSession* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHealthCheckerImpl* parent = self->m_parent;
+    RpCreateConnectionData data = rp_host_create_connection(self->m_host, parent->m_dispatcher);
+    if (!data.m_connection)
+    {
+        self->m_probing = true;
+        on_probe_complete(self, false, "no connection");
+        return;
+    }
+
+    self->m_probing = true;
+    self->m_response_code = 0;
+    rp_timer_enable_timer(self->m_timeout_timer, parent->m_config.timeout_ms);
+
+    if (parent->m_config.type == RpHealthCheckerType_HTTP)
+    {
+        // The request goes out once connected; see on_event_i().
+        self->m_client = RP_CODEC_CLIENT(rp_codec_client_prod_new(RpCodecType_HTTP1,
+                                                                    data.m_connection,
+                                                                    data.m_host_description,
+                                                                    parent->m_dispatcher,
+                                                                    false));
+        rp_codec_client_add_connection_callbacks(self->m_client, RP_NETWORK_CONNECTION_CALLBACKS(self));
+        rp_codec_client_connect(self->m_client);
+    }
+    else
+    {
+        self->m_connection = data.m_connection;
+        RpNetworkConnection* connection = RP_NETWORK_CONNECTION(self->m_connection);
+        rp_network_connection_add_connection_callbacks(connection, RP_NETWORK_CONNECTION_CALLBACKS(self));
+        rp_network_client_connection_connect(self->m_connection);
+    }
+}
+
+static void
+on_interval_timer(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+    start_probe(RP_ACTIVE_HEALTH_CHECK_SESSION(arg));
+}
+
+OVERRIDE void
+session_dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpActiveHealthCheckSession* self = RP_ACTIVE_HEALTH_CHECK_SESSION(obj);
+    g_clear_object(&self->m_interval_timer);
+    g_clear_object(&self->m_timeout_timer);
+    g_clear_object(&self->m_host);
+
+    G_OBJECT_CLASS(rp_active_health_check_session_parent_class)->dispose(obj);
+}
+
+static void
+rp_active_health_check_session_class_init(RpActiveHealthCheckSessionClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = session_dispose;
+}
+
+static void
+rp_active_health_check_session_init(RpActiveHealthCheckSession* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_first_check = true;
+}
+
+static RpActiveHealthCheckSession*
+active_health_check_session_new(RpHealthCheckerImpl* parent, RpHost* host)
+{
+    NOISY_MSG_("(%p, %p)", parent, host);
+    RpActiveHealthCheckSession* self = g_object_new(RP_TYPE_ACTIVE_HEALTH_CHECK_SESSION, NULL);
+    self->m_parent = parent;
+    self->m_host = g_object_ref(host);
+    self->m_interval_timer = rp_dispatcher_create_timer(parent->m_dispatcher, on_interval_timer, self);
+    self->m_timeout_timer = rp_dispatcher_create_timer(parent->m_dispatcher, on_timeout_timer, self);
+    return self;
+}
+
+static void
+active_health_check_session_destroy(gpointer arg)
+{
+    NOISY_MSG_("(%p)", arg);
+
+    // Detach from the probe connection and timers before dropping the
+    // reference; the codec client may still point at this session.
+    RpActiveHealthCheckSession* self = arg;
+    self->m_probing = false;
+    g_clear_object(&self->m_interval_timer);
+    g_clear_object(&self->m_timeout_timer);
+    close_probe_connection(self);
+    g_object_unref(self);
+}
+
+static void
+add_session(RpHealthCheckerImpl* self, RpHost* host)
+{
+    NOISY_MSG_("(%p, %p)", self, host);
+    RpActiveHealthCheckSession* session = active_health_check_session_new(self, host);
+    // Until its first probe says otherwise the host is assumed to be down.
+    rp_host_health_flag_set(host, FAILED_ACTIVE_HC);
+    g_hash_table_insert(self->m_sessions, g_object_ref(host), session);
+    if (self->m_started)
+    {
+        start_probe(session);
+    }
+}
+
+static RpStatusCode_e
+on_member_update_cb(const RpHostVector* hosts_added G_GNUC_UNUSED, const RpHostVector* hosts_removed G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p, %p)", hosts_added, hosts_removed, arg);
+
+    // Not every cluster reports the hosts it added or removed, so reconcile
+    // against the full membership instead.
+    RpHealthCheckerImpl* self = RP_HEALTH_CHECKER_IMPL(arg);
+    g_autoptr(GHashTable) current = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_autoptr(GPtrArray) added = g_ptr_array_new();
+    const RpHostSetPtrVector* host_sets = rp_priority_set_host_sets_per_priority(self->m_priority_set);
+    for (guint p = 0; p < rp_host_set_ptr_vector_size(host_sets); ++p)
+    {
+        const RpHostVector* hosts = rp_host_set_get_hosts(rp_host_set_ptr_vector_get(host_sets, p));
+        for (guint i = 0; i < rp_host_vector_len(hosts); ++i)
+        {
+            RpHost* host = rp_host_vector_get(hosts, i);
+            g_hash_table_add(current, host);
+            if (!g_hash_table_contains(self->m_sessions, host))
+            {
+                g_ptr_array_add(added, host);
+            }
+        }
+    }
+
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, self->m_sessions);
+    while (g_hash_table_iter_next(&iter, &key, NULL))
+    {
+        RpHost* host = key;
+        if (!g_hash_table_contains(current, host))
+        {
+            NOISY_MSG_("removing session for host %p", host);
+            rp_host_health_flag_clear(host, FAILED_ACTIVE_HC);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+
+    // Sessions are added last; a probe that fails synchronously rebuilds the
+    // host sets and re-enters here.
+    for (guint i = 0; i < added->len; ++i)
+    {
+        RpHost* host = g_ptr_array_index(added, i);
+        if (!g_hash_table_contains(self->m_sessions, host))
+        {
+            add_session(self, host);
+        }
+    }
+    return RpStatusCode_Ok;
+}
+
+static RpCallbackHandlePtr
+add_host_check_complete_cb_i(RpHealthChecker* self, RpHealthCheckHostStatusCb cb, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p, %p)", self, cb, arg);
+    return rp_callback_manager_add(RP_HEALTH_CHECKER_IMPL(self)->m_callbacks, (RpCallback)cb, arg);
+}
+
+static void
+start_i(RpHealthChecker* self)
+{
+    NOISY_MSG_("(%p)", self);
+
+    RpHealthCheckerImpl* me = RP_HEALTH_CHECKER_IMPL(self);
+    if (me->m_started)
+    {
+        NOISY_MSG_("already started");
+        return;
+    }
+    me->m_started = true;
+
+    // Probe results can reconcile the session table, so work from a copy.
+    g_autoptr(GPtrArray) sessions = g_ptr_array_new_with_free_func(g_object_unref);
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, me->m_sessions);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        g_ptr_array_add(sessions, g_object_ref(value));
+    }
+    for (guint i = 0; i < sessions->len; ++i)
+    {
+        RpActiveHealthCheckSession* session = g_ptr_array_index(sessions, i);
+        if (session->m_interval_timer && !session->m_probing)
+        {
+            start_probe(session);
+        }
+    }
+}
+
+static void
+health_checker_iface_init(RpHealthCheckerInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->add_host_check_complete_cb = add_host_check_complete_cb_i;
+    iface->start = start_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpHealthCheckerImpl* self = RP_HEALTH_CHECKER_IMPL(obj);
+    g_clear_pointer(&self->m_sessions, g_hash_table_unref);
+    g_clear_object(&self->m_callbacks);
+
+    G_OBJECT_CLASS(rp_health_checker_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_health_checker_impl_class_init(RpHealthCheckerImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_health_checker_impl_init(RpHealthCheckerImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_sessions = g_hash_table_new_full(g_direct_hash, g_direct_equal, g_object_unref, active_health_check_session_destroy);
+    self->m_callbacks = rp_callback_manager_new();
+}
+
+RpHealthCheckerImpl*
+rp_health_checker_impl_create(RpPrioritySet* priority_set, const RpHealthCheckCfg* config, RpDispatcher* dispatcher)
+{
+    LOGD("(%p, %p, %p)", priority_set, config, dispatcher);
+
+    g_return_val_if_fail(RP_IS_PRIORITY_SET(priority_set), NULL);
+    g_return_val_if_fail(config != NULL, NULL);
+    g_return_val_if_fail(RP_IS_DISPATCHER(dispatcher), NULL);
+
+    RpHealthCheckerImpl* self = g_object_new(RP_TYPE_HEALTH_CHECKER_IMPL, NULL);
+    self->m_priority_set = priority_set;
+    self->m_dispatcher = dispatcher;
+    self->m_config = *config;
+
+    // The handle lives as long as the priority set, which the cluster
+    // releases before this checker.
+    rp_priority_set_add_member_update_cb(priority_set, on_member_update_cb, self);
+    on_member_update_cb(NULL, NULL, self);
+    return self;
+}
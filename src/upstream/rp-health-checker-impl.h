@@ -0,0 +1,43 @@
+/*
+ * rp-health-checker-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-cluster-configuration.h"
+#include "rp-dispatcher.h"
+#include "rp-health-checker.h"
+#include "rp-upstream.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Per host probing state. Each probe runs on its own connection, created
+ * directly from the host so it never competes with (or is hidden by) the
+ * data plane connection pools.
+ * https://github.com/envoyproxy/envoy/blob/main/source/common/upstream/health_checker_impl.h
+ */
+#define RP_TYPE_ACTIVE_HEALTH_CHECK_SESSION rp_active_health_check_session_get_type()
+G_DECLARE_FINAL_TYPE(RpActiveHealthCheckSession, rp_active_health_check_session, RP, ACTIVE_HEALTH_CHECK_SESSION, GObject)
+
+/**
+ * Active health checker for a cluster. Every host is probed with a TCP connect
+ * or an HTTP/1.1 GET each interval (plus jitter); a host is marked
+ * FAILED_ACTIVE_HC after unhealthy_threshold consecutive failures and cleared
+ * again after healthy_threshold consecutive successes. Hosts start out failed
+ * and are cleared by their first successful probe. Must be created and driven
+ * on the main thread.
+ */
+#define RP_TYPE_HEALTH_CHECKER_IMPL rp_health_checker_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpHealthCheckerImpl, rp_health_checker_impl, RP, HEALTH_CHECKER_IMPL, GObject)
+
+RpHealthCheckerImpl* rp_health_checker_impl_create(RpPrioritySet* priority_set,
+                                                    const RpHealthCheckCfg* config,
+                                                    RpDispatcher* dispatcher);
+
+G_END_DECLS
@@ -17,6 +17,7 @@
 #include <stdatomic.h>
 #include "rp-net-transport-socket.h"
 #include "rp-factory-context.h"
+#include "rp-outlier-detection.h"
 #include "upstream/rp-upstream-impl.h"
 
 typedef struct _RpHostDescriptionImplBasePrivate RpHostDescriptionImplBasePrivate;
@@ -26,6 +27,12 @@ struct _RpHostDescriptionImplBasePrivate {
     RpUpstreamTransportSocketFactory* m_socket_factory; // REVISIT: Mutex required?
     RpNetworkAddressInstanceSharedPtr m_dest_address;
     RpMetadataConstSharedPtr m_endpoint_metadata;
+    // Published atomically for the workers, which call into it without a
+    // reference of their own; a replaced monitor is kept in
+    // m_retired_outlier_detectors until the host itself goes away, so a
+    // worker that has just read the old pointer never sees it freed.
+    RpDetectorHostMonitor* m_outlier_detector;
+    GSList* m_retired_outlier_detectors;
     const char* m_hostname;
 
     RpStatusCode_e* m_creation_status;
@@ -126,6 +133,31 @@ transport_socket_factory_i(RpHostDescriptionConstSharedPtr self)
     return PRIV(self)->m_socket_factory;
 }
 
+static RpDetectorHostMonitor*
+outlier_detector_i(RpHostDescriptionConstSharedPtr self)
+{
+    NOISY_MSG_("(%p)", self);
+    return g_atomic_pointer_get(&PRIV(self)->m_outlier_detector);
+}
+
+static void
+set_outlier_detector_i(RpHostDescription* self, RpDetectorHostMonitor* outlier_detector)
+{
+    NOISY_MSG_("(%p, %p)", self, outlier_detector);
+    // Set (or cleared) on the main thread when the cluster's outlier detector
+    // starts (or stops) tracking the host.
+    RpHostDescriptionImplBasePrivate* me = PRIV(self);
+    if (outlier_detector)
+    {
+        g_object_ref(outlier_detector);
+    }
+    RpDetectorHostMonitor* previous = g_atomic_pointer_exchange(&me->m_outlier_detector, outlier_detector);
+    if (previous)
+    {
+        me->m_retired_outlier_detectors = g_slist_prepend(me->m_retired_outlier_detectors, previous);
+    }
+}
+
 static void
 host_description_iface_init(RpHostDescriptionInterface* iface)
 {
@@ -138,6 +170,8 @@ host_description_iface_init(RpHostDescriptionInterface* iface)
     iface->metadata = metadata_i;
     iface->set_metadata = set_metadata_i;
     iface->transport_socket_factory = transport_socket_factory_i;
+    iface->outlier_detector = outlier_detector_i;
+    iface->set_outlier_detector = set_outlier_detector_i;
 }
 
 OVERRIDE void
@@ -229,6 +263,8 @@ dispose(GObject* obj)
     g_clear_object(&me->m_dest_address);
     g_clear_object(&me->m_cluster);
     g_clear_object(&me->m_socket_factory);
+    g_clear_object(&me->m_outlier_detector);
+    g_slist_free_full(g_steal_pointer(&me->m_retired_outlier_detectors), g_object_unref);
 
     G_OBJECT_CLASS(rp_host_description_impl_base_parent_class)->dispose(obj);
 }
@@ -104,6 +104,20 @@ set_priority_i(RpHostDescription* self, guint32 priority)
     PARENT_HOST_DESCRIPTION_IFACE(self)->set_priority(self, priority);
 }
 
+static RpDetectorHostMonitor*
+outlier_detector_i(RpHostDescriptionConstSharedPtr self)
+{
+    NOISY_MSG_("(%p)", self);
+    return PARENT_HOST_DESCRIPTION_IFACE(self)->outlier_detector(self);
+}
+
+static void
+set_outlier_detector_i(RpHostDescription* self, RpDetectorHostMonitor* outlier_detector)
+{
+    NOISY_MSG_("(%p, %p)", self, outlier_detector);
+    PARENT_HOST_DESCRIPTION_IFACE(self)->set_outlier_detector(self, outlier_detector);
+}
+
 static RpUpstreamTransportSocketFactory*
 transport_socket_factory_i(RpHostDescriptionConstSharedPtr self)
 {
@@ -120,8 +134,10 @@ host_description_iface_init(RpHostDescriptionInterface* iface)
     iface->cluster = cluster_i;
     iface->hostname = hostname_i;
     iface->metadata = metadata_i;
+    iface->outlier_detector = outlier_detector_i;
     iface->priority = priority_i;
     iface->set_metadata = set_metadata_i;
+    iface->set_outlier_detector = set_outlier_detector_i;
     iface->set_priority = set_priority_i;
     iface->transport_socket_factory = transport_socket_factory_i;
 }
@@ -13,6 +13,7 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include <stdatomic.h>
 #include "rp-net-client-conn-impl.h"
 #include "rp-upstream.h"
 #include "network/rp-default-client-conn-factory.h"
@@ -24,6 +25,7 @@ struct _RpHostImpl {
     RpHostDescriptionImpl parent_instance;
 
     gint m_initial_weight;
+    GPtrArray* m_address_list;
 
     _Atomic guint32 m_health_flags;
     _Atomic guint32 m_weight;
@@ -71,6 +73,12 @@ create_connection(RpHostDescriptionConstSharedPtr self, RpDispatcher* dispatcher
                                                                                         address,
                                                                                         upstream_local_address.m_address,
                                                                                         transport_socket);
+    GPtrArray* address_list = HOST_IMPL(self)->m_address_list;
+    if (address_list && RP_IS_NETWORK_CLIENT_CONNECTION_IMPL(connection))
+    {
+        NOISY_MSG_("%u addresses", address_list->len);
+        rp_network_client_connection_impl_set_address_list(RP_NETWORK_CLIENT_CONNECTION_IMPL(connection), address_list);
+    }
     return rp_create_connection_data_ctor(connection, host);
 }
 
@@ -114,6 +122,36 @@ health_flag_get_i(const RpHost* self, RpHostHealthFlag_e flag)
     return HOST_IMPL(self)->m_health_flags & flag;
 }
 
+static void
+health_flag_clear_i(RpHost* self, RpHostHealthFlag_e flag)
+{
+    NOISY_MSG_("(%p, %d)", self, flag);
+    // Flags are flipped by the main thread (outlier detection, health
+    // checking) and read by workers picking hosts.
+    atomic_fetch_and(&HOST_IMPL(self)->m_health_flags, ~(guint32)flag);
+}
+
+static void
+health_flag_set_i(RpHost* self, RpHostHealthFlag_e flag)
+{
+    NOISY_MSG_("(%p, %d)", self, flag);
+    atomic_fetch_or(&HOST_IMPL(self)->m_health_flags, (guint32)flag);
+}
+
+static guint32
+health_flags_get_all_i(const RpHost* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return HOST_IMPL(self)->m_health_flags;
+}
+
+static guint32
+health_flags_set_all_i(RpHost* self, guint32 bits)
+{
+    NOISY_MSG_("(%p, %x)", self, bits);
+    return atomic_fetch_or(&HOST_IMPL(self)->m_health_flags, bits);
+}
+
 static void
 host_iface_init(RpHostInterface* iface)
 {
@@ -121,6 +159,10 @@ host_iface_init(RpHostInterface* iface)
     iface->create_connection = create_connection_i;
     iface->coarse_health = coarse_health_i;
     iface->health_flag_get = health_flag_get_i;
+    iface->health_flag_clear = health_flag_clear_i;
+    iface->health_flag_set = health_flag_set_i;
+    iface->health_flags_get_all = health_flags_get_all_i;
+    iface->health_flags_set_all = health_flags_set_all_i;
 }
 
 OVERRIDE void
@@ -163,6 +205,7 @@ OVERRIDE void
 dispose(GObject* obj)
 {
     NOISY_MSG_("(%p)", obj);
+    g_clear_pointer(&RP_HOST_IMPL(obj)->m_address_list, g_ptr_array_unref);
     G_OBJECT_CLASS(rp_host_impl_parent_class)->dispose(obj);
 }
 
@@ -299,4 +342,13 @@ rp_host_impl_create(RpClusterInfoConstSharedPtr cluster, const char* hostname,
         return NULL;
     }
     return g_steal_pointer(&ret);
-}
\ No newline at end of file
+}
+
+void
+rp_host_impl_set_address_list(RpHostImpl* self, GPtrArray* address_list)
+{
+    LOGD("(%p, %p)", self, address_list);
+    g_return_if_fail(RP_IS_HOST_IMPL(self));
+    g_clear_pointer(&self->m_address_list, g_ptr_array_unref);
+    self->m_address_list = address_list ? g_ptr_array_ref(address_list) : NULL;
+}
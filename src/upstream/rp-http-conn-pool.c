@@ -288,7 +288,7 @@ rp_http_conn_pool_class_init(RpHttpConnPoolClass* klass)
                                                     "Downstream protocol",
                                                     "Downstream Protocol",
                                                     EVHTP_PROTO_INVALID,
-                                                    EVHTP_PROTO_11,
+                                                    EVHTP_PROTO_2,
                                                     EVHTP_PROTO_INVALID,
                                                     G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
 
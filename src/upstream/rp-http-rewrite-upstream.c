@@ -31,11 +31,11 @@
 #define UPSTREAM_SSL_CONNECTION(s) \
     rp_upstream_info_upstream_ssl_connection(UPSTREAM_INFO(s))
 #define REWRITE_URLS(s) \
-    rp_filter_state_get_data(FILTER_STATE(s), rewrite_urls_key)
+    rp_filter_state_get_slot_data(FILTER_STATE(s), rewrite_urls_slot)
 #define ORIGINAL_URI(s) \
-    rp_filter_state_get_data(FILTER_STATE(s), original_uri_key)
+    rp_filter_state_get_slot_data(FILTER_STATE(s), original_uri_slot)
 #define PASSTHROUGH(s) \
-    rp_filter_state_get_data(FILTER_STATE(s), passthrough_key)
+    rp_filter_state_get_slot_data(FILTER_STATE(s), passthrough_slot)
 
 struct _RpHttpRewriteUpstream {
     GObject parent_instance;
@@ -0,0 +1,672 @@
+/*
+ * rp-outlier-detection-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_outlier_detection_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_outlier_detection_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include <stdatomic.h>
+#include "common/common/rp-callback-impl.h"
+#include "upstream/rp-outlier-detection-impl.h"
+
+typedef enum {
+    RpConsecutiveErrorType_5xx,
+    RpConsecutiveErrorType_GatewayFailure,
+    RpConsecutiveErrorType_LocalOriginFailure
+} RpConsecutiveErrorType_e;
+
+struct _RpDetectorHostMonitorImpl {
+    GObject parent_instance;
+
+    GWeakRef m_detector;
+    // Borrowed; the host owns this monitor.
+    RpHost* m_host;
+
+    guint32 m_consecutive_5xx_threshold;
+    guint32 m_consecutive_gateway_failure_threshold;
+    guint32 m_consecutive_local_origin_failure_threshold;
+
+    _Atomic guint32 m_consecutive_5xx;
+    _Atomic guint32 m_consecutive_gateway_failure;
+    _Atomic guint32 m_consecutive_local_origin_failure;
+
+    // Interval counters, swapped out by the detector every interval.
+    _Atomic guint64 m_total_count;
+    _Atomic guint64 m_success_count;
+    _Atomic guint64 m_response_time_sum_ms;
+    _Atomic guint64 m_response_time_count;
+
+    _Atomic guint32 m_num_ejections;
+
+    // Main thread only.
+    gint64 m_last_ejection_time;
+    gint64 m_ejection_time_ms;
+};
+
+struct _RpOutlierDetectorImpl {
+    GObject parent_instance;
+
+    // Borrowed; the cluster owns both the priority set and this detector.
+    RpPrioritySet* m_priority_set;
+    RpDispatcher* m_dispatcher;
+    RpOutlierDetectionCfg m_config;
+
+    GHashTable* m_host_monitors; // RpHost* -> RpDetectorHostMonitorImpl*
+    RpCallbackManager* m_callbacks;
+    RpTimer* m_interval_timer;
+
+    guint32 m_ejections_active;
+    double m_success_rate_average;
+};
+
+static void detector_host_monitor_iface_init(RpDetectorHostMonitorInterface* iface);
+static void outlier_detector_iface_init(RpOutlierDetectorInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpDetectorHostMonitorImpl, rp_detector_host_monitor_impl, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_DETECTOR_HOST_MONITOR, detector_host_monitor_iface_init)
+)
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpOutlierDetectorImpl, rp_outlier_detector_impl, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_OUTLIER_DETECTOR, outlier_detector_iface_init)
+)
+
+static void post_consecutive_error(RpOutlierDetectorImpl* self, RpHost* host, RpConsecutiveErrorType_e type);
+
+static inline bool
+threshold_reached(_Atomic guint32* counter, guint32 threshold)
+{
+    // Only the increment that lands exactly on the threshold reports it, so
+    // concurrent workers post a single ejection request.
+    return threshold && atomic_fetch_add(counter, 1) + 1 == threshold;
+}
+
+static void
+notify_consecutive_error(RpDetectorHostMonitorImpl* self, RpConsecutiveErrorType_e type)
+{
+    NOISY_MSG_("(%p, %d)", self, type);
+    g_autoptr(RpOutlierDetectorImpl) detector = g_weak_ref_get(&self->m_detector);
+    if (detector)
+    {
+        post_consecutive_error(detector, self->m_host, type);
+    }
+}
+
+static guint32
+num_ejections_i(RpDetectorHostMonitor* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_DETECTOR_HOST_MONITOR_IMPL(self)->m_num_ejections;
+}
+
+static void
+put_http_response_code_i(RpDetectorHostMonitor* self, guint64 response_code)
+{
+    NOISY_MSG_("(%p, %zu)", self, (gsize)response_code);
+
+    RpDetectorHostMonitorImpl* me = RP_DETECTOR_HOST_MONITOR_IMPL(self);
+    atomic_fetch_add(&me->m_total_count, 1);
+    if (response_code < 500)
+    {
+        atomic_fetch_add(&me->m_success_count, 1);
+        me->m_consecutive_5xx = 0;
+        me->m_consecutive_gateway_failure = 0;
+        return;
+    }
+
+    if (response_code == 502 || response_code == 503 || response_code == 504)
+    {
+        if (threshold_reached(&me->m_consecutive_gateway_failure, me->m_consecutive_gateway_failure_threshold))
+        {
+            notify_consecutive_error(me, RpConsecutiveErrorType_GatewayFailure);
+        }
+    }
+    else
+    {
+        me->m_consecutive_gateway_failure = 0;
+    }
+
+    if (threshold_reached(&me->m_consecutive_5xx, me->m_consecutive_5xx_threshold))
+    {
+        notify_consecutive_error(me, RpConsecutiveErrorType_5xx);
+    }
+}
+
+static void
+put_result_i(RpDetectorHostMonitor* self, RpOutlierResult_e result)
+{
+    NOISY_MSG_("(%p, %d)", self, result);
+
+    RpDetectorHostMonitorImpl* me = RP_DETECTOR_HOST_MONITOR_IMPL(self);
+    switch (result)
+    {
+        case RpOutlierResult_LocalOriginConnectFailed:
+        case RpOutlierResult_LocalOriginTimeout:
+            atomic_fetch_add(&me->m_total_count, 1);
+            if (threshold_reached(&me->m_consecutive_local_origin_failure,
+                                    me->m_consecutive_local_origin_failure_threshold))
+            {
+                notify_consecutive_error(me, RpConsecutiveErrorType_LocalOriginFailure);
+            }
+            break;
+        case RpOutlierResult_LocalOriginConnectSuccess:
+            me->m_consecutive_local_origin_failure = 0;
+            break;
+        case RpOutlierResult_ExtOriginRequestFailed:
+            put_http_response_code_i(self, 500);
+            break;
+        case RpOutlierResult_ExtOriginRequestSuccess:
+            put_http_response_code_i(self, 200);
+            break;
+    }
+}
+
+static void
+put_response_time_i(RpDetectorHostMonitor* self, guint64 time_ms)
+{
+    NOISY_MSG_("(%p, %zu)", self, (gsize)time_ms);
+    RpDetectorHostMonitorImpl* me = RP_DETECTOR_HOST_MONITOR_IMPL(self);
+    atomic_fetch_add(&me->m_response_time_sum_ms, time_ms);
+    atomic_fetch_add(&me->m_response_time_count, 1);
+}
+
+static void
+detector_host_monitor_iface_init(RpDetectorHostMonitorInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->num_ejections = num_ejections_i;
+    iface->put_http_response_code = put_http_response_code_i;
+    iface->put_result = put_result_i;
+    iface->put_response_time = put_response_time_i;
+}
+
+OVERRIDE void
+detector_host_monitor_impl_dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpDetectorHostMonitorImpl* self = RP_DETECTOR_HOST_MONITOR_IMPL(obj);
+    g_weak_ref_clear(&self->m_detector);
+
+    G_OBJECT_CLASS(rp_detector_host_monitor_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_detector_host_monitor_impl_class_init(RpDetectorHostMonitorImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = detector_host_monitor_impl_dispose;
+}
+
+static void
+rp_detector_host_monitor_impl_init(RpDetectorHostMonitorImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    g_weak_ref_init(&self->m_detector, NULL);
+}
+
+static RpDetectorHostMonitorImpl*
+detector_host_monitor_impl_new(RpOutlierDetectorImpl* detector, RpHost* host)
+{
+    NOISY_MSG_("(%p, %p)", detector, host);
+    RpDetectorHostMonitorImpl* self = g_object_new(RP_TYPE_DETECTOR_HOST_MONITOR_IMPL, NULL);
+    g_weak_ref_set(&self->m_detector, detector);
+    self->m_host = host;
+    self->m_consecutive_5xx_threshold = detector->m_config.consecutive_5xx;
+    self->m_consecutive_gateway_failure_threshold = detector->m_config.consecutive_gateway_failure;
+    self->m_consecutive_local_origin_failure_threshold = detector->m_config.consecutive_local_origin_failure;
+    return self;
+}
+
+static inline void
+reset_consecutive_counters(RpDetectorHostMonitorImpl* monitor)
+{
+    monitor->m_consecutive_5xx = 0;
+    monitor->m_consecutive_gateway_failure = 0;
+    monitor->m_consecutive_local_origin_failure = 0;
+}
+
+static inline bool
+is_ejected(RpHost* host)
+{
+    return rp_host_health_flag_get(host, FAILED_OUTLIER_CHECK);
+}
+
+static void
+run_callbacks(RpOutlierDetectorImpl* self, RpHost* host)
+{
+    NOISY_MSG_("(%p, %p)", self, host);
+    for (GList* itr = rp_callback_manager_callbacks(self->m_callbacks); itr; itr = itr->next)
+    {
+        RpCallbackHandlePtr handle = itr->data;
+        RpOutlierDetectorChangeStateCb cb = (RpOutlierDetectorChangeStateCb)rp_callback_handle_cb(handle);
+        RpStatusCode_e status = cb(host, rp_callback_handle_arg(handle));
+        if (status != RpStatusCode_Ok)
+        {
+            LOGE("changed state callback failed");
+        }
+    }
+}
+
+static gint64
+ejection_time_ms(RpOutlierDetectorImpl* self, guint32 num_ejections)
+{
+    NOISY_MSG_("(%p, %u)", self, num_ejections);
+    gint64 base = self->m_config.base_ejection_time_ms;
+    gint64 max = MAX(self->m_config.max_ejection_time_ms, self->m_config.base_ejection_time_ms);
+    gint64 ejection_time = base;
+    for (guint32 i = 1; i < num_ejections && ejection_time < max; ++i)
+    {
+        ejection_time *= 2;
+    }
+    return MIN(ejection_time, max);
+}
+
+static void
+eject_host(RpOutlierDetectorImpl* self, RpHost* host, RpDetectorHostMonitorImpl* monitor, const char* reason)
+{
+    NOISY_MSG_("(%p, %p, %p, %p(%s))", self, host, monitor, reason, reason);
+
+    // At least one host may always be ejected; beyond that the cluster keeps
+    // (100 - max_ejection_percent) of its hosts in rotation.
+    guint total = g_hash_table_size(self->m_host_monitors);
+    if (self->m_ejections_active > 0 &&
+        (self->m_ejections_active + 1) * 100 > self->m_config.max_ejection_percent * total)
+    {
+        LOGD("not ejecting %s (%s); %u of %u hosts already ejected",
+            rp_host_description_hostname(RP_HOST_DESCRIPTION(host)), reason, self->m_ejections_active, total);
+        reset_consecutive_counters(monitor);
+        return;
+    }
+
+    guint32 num_ejections = atomic_fetch_add(&monitor->m_num_ejections, 1) + 1;
+    monitor->m_ejection_time_ms = ejection_time_ms(self, num_ejections);
+    monitor->m_last_ejection_time = g_get_monotonic_time();
+    reset_consecutive_counters(monitor);
+    rp_host_health_flag_set(host, FAILED_OUTLIER_CHECK);
+    ++self->m_ejections_active;
+
+    LOGI("ejecting host %s (%s) for %" G_GINT64_FORMAT "ms, ejection %u",
+        rp_host_description_hostname(RP_HOST_DESCRIPTION(host)), reason, monitor->m_ejection_time_ms, num_ejections);
+
+    run_callbacks(self, host);
+}
+
+static void
+uneject_host(RpOutlierDetectorImpl* self, RpHost* host)
+{
+    NOISY_MSG_("(%p, %p)", self, host);
+
+    rp_host_health_flag_clear(host, FAILED_OUTLIER_CHECK);
+    --self->m_ejections_active;
+
+    LOGI("unejecting host %s", rp_host_description_hostname(RP_HOST_DESCRIPTION(host)));
+
+    run_callbacks(self, host);
+}
+
+typedef struct _RpConsecutiveErrorCtx RpConsecutiveErrorCtx;
+struct _RpConsecutiveErrorCtx {
+    RpOutlierDetectorImpl* m_detector;
+    RpHost* m_host;
+    RpConsecutiveErrorType_e m_type;
+};
+
+static void
+on_consecutive_error(gpointer arg)
+{
+    NOISY_MSG_("(%p)", arg);
+
+    RpConsecutiveErrorCtx* ctx = arg;
+    RpOutlierDetectorImpl* self = ctx->m_detector;
+    RpDetectorHostMonitorImpl* monitor = g_hash_table_lookup(self->m_host_monitors, ctx->m_host);
+    // The host may have been removed, or ejected for another reason, while
+    // the post was in flight.
+    if (monitor && !is_ejected(ctx->m_host))
+    {
+        static const char* reasons[] = {
+            [RpConsecutiveErrorType_5xx] = "consecutive 5xx",
+            [RpConsecutiveErrorType_GatewayFailure] = "consecutive gateway failure",
+            [RpConsecutiveErrorType_LocalOriginFailure] = "consecutive local origin failure"
+        };
+        eject_host(self, ctx->m_host, monitor, reasons[ctx->m_type]);
+    }
+
+    g_object_unref(ctx->m_host);
+    g_object_unref(ctx->m_detector);
+    g_free(ctx);
+}
+
+static void
+post_consecutive_error(RpOutlierDetectorImpl* self, RpHost* host, RpConsecutiveErrorType_e type)
+{
+    NOISY_MSG_("(%p, %p, %d)", self, host, type);
+    RpConsecutiveErrorCtx* ctx = g_new(RpConsecutiveErrorCtx, 1);
+    ctx->m_detector = g_object_ref(self);
+    ctx->m_host = g_object_ref(host);
+    ctx->m_type = type;
+    rp_dispatcher_base_post(RP_DISPATCHER_BASE(self->m_dispatcher), on_consecutive_error, ctx);
+}
+
+typedef struct _RpHostStats RpHostStats;
+struct _RpHostStats {
+    RpHost* m_host;
+    RpDetectorHostMonitorImpl* m_monitor;
+    double m_success_rate;
+    double m_mean_response_time;
+    bool m_success_rate_valid : 1;
+    bool m_response_time_valid : 1;
+};
+
+static void
+check_success_rate(RpOutlierDetectorImpl* self, RpHostStats* stats, guint n)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, stats, n);
+
+    self->m_success_rate_average = -1.0;
+
+    guint count = 0;
+    double sum = 0.0;
+    for (guint i = 0; i < n; ++i)
+    {
+        if (stats[i].m_success_rate_valid)
+        {
+            sum += stats[i].m_success_rate;
+            ++count;
+        }
+    }
+    if (count == 0 || count < self->m_config.success_rate_minimum_hosts)
+    {
+        NOISY_MSG_("%u hosts with enough volume", count);
+        return;
+    }
+
+    double mean = sum / count;
+    double variance = 0.0;
+    for (guint i = 0; i < n; ++i)
+    {
+        if (stats[i].m_success_rate_valid)
+        {
+            double diff = stats[i].m_success_rate - mean;
+            variance += diff * diff;
+        }
+    }
+    variance /= count;
+    self->m_success_rate_average = mean;
+
+    double factor = self->m_config.success_rate_stdev_factor;
+    if (factor <= 0.0)
+    {
+        return;
+    }
+
+    // rate < mean - (factor * stdev), compared squared to stay clear of libm.
+    for (guint i = 0; i < n; ++i)
+    {
+        double below = mean - stats[i].m_success_rate;
+        if (stats[i].m_success_rate_valid &&
+            below > 0.0 &&
+            below * below > factor * factor * variance &&
+            !is_ejected(stats[i].m_host))
+        {
+            eject_host(self, stats[i].m_host, stats[i].m_monitor, "success rate");
+        }
+    }
+}
+
+static gint
+compare_doubles(gconstpointer a, gconstpointer b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void
+check_latency(RpOutlierDetectorImpl* self, RpHostStats* stats, guint n)
+{
+    NOISY_MSG_("(%p, %p, %u)", self, stats, n);
+
+    double factor = self->m_config.latency_threshold_factor;
+    if (factor <= 0.0)
+    {
+        return;
+    }
+
+    g_autoptr(GArray) means = g_array_sized_new(FALSE, FALSE, sizeof(double), n);
+    for (guint i = 0; i < n; ++i)
+    {
+        if (stats[i].m_response_time_valid)
+        {
+            g_array_append_val(means, stats[i].m_mean_response_time);
+        }
+    }
+    if (means->len == 0 || means->len < self->m_config.success_rate_minimum_hosts)
+    {
+        NOISY_MSG_("%u hosts with enough volume", means->len);
+        return;
+    }
+
+    g_array_sort(means, compare_doubles);
+    double median = means->len % 2 ?
+        g_array_index(means, double, means->len / 2) :
+        (g_array_index(means, double, means->len / 2 - 1) + g_array_index(means, double, means->len / 2)) / 2.0;
+    // Sub-millisecond medians make any jitter look like an outlier.
+    double threshold = factor * MAX(median, 1.0);
+
+    for (guint i = 0; i < n; ++i)
+    {
+        if (stats[i].m_response_time_valid &&
+            stats[i].m_mean_response_time > threshold &&
+            !is_ejected(stats[i].m_host))
+        {
+            eject_host(self, stats[i].m_host, stats[i].m_monitor, "latency");
+        }
+    }
+}
+
+static void
+on_interval_timer(RpTimer* timer G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p)", timer, arg);
+
+    RpOutlierDetectorImpl* self = RP_OUTLIER_DETECTOR_IMPL(arg);
+    gint64 now = g_get_monotonic_time();
+
+    // Snapshot first; changed state callbacks rebuild the host sets, which
+    // may reconcile the monitor table underneath us.
+    guint n = g_hash_table_size(self->m_host_monitors);
+    RpHostStats* stats = g_new0(RpHostStats, n);
+    GHashTableIter iter;
+    gpointer key, value;
+    guint i = 0;
+    g_hash_table_iter_init(&iter, self->m_host_monitors);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        RpDetectorHostMonitorImpl* monitor = value;
+        guint64 total = atomic_exchange(&monitor->m_total_count, 0);
+        guint64 success = atomic_exchange(&monitor->m_success_count, 0);
+        guint64 response_time_sum = atomic_exchange(&monitor->m_response_time_sum_ms, 0);
+        guint64 response_time_count = atomic_exchange(&monitor->m_response_time_count, 0);
+
+        stats[i].m_host = g_object_ref(key);
+        stats[i].m_monitor = g_object_ref(monitor);
+        stats[i].m_success_rate_valid = total > 0 && total >= self->m_config.success_rate_request_volume;
+        stats[i].m_success_rate = total ? 100.0 * success / total : 0.0;
+        stats[i].m_response_time_valid = response_time_count > 0 &&
+                                            response_time_count >= self->m_config.success_rate_request_volume;
+        stats[i].m_mean_response_time = response_time_count ? (double)response_time_sum / response_time_count : 0.0;
+        ++i;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        RpDetectorHostMonitorImpl* monitor = stats[i].m_monitor;
+        if (is_ejected(stats[i].m_host))
+        {
+            stats[i].m_success_rate_valid = false;
+            stats[i].m_response_time_valid = false;
+            if (now - monitor->m_last_ejection_time >= monitor->m_ejection_time_ms * 1000)
+            {
+                uneject_host(self, stats[i].m_host);
+            }
+        }
+        else if (monitor->m_num_ejections > 0)
+        {
+            // A host that stays healthy works its ejection time back down.
+            atomic_fetch_sub(&monitor->m_num_ejections, 1);
+        }
+    }
+
+    check_success_rate(self, stats, n);
+    check_latency(self, stats, n);
+
+    for (i = 0; i < n; ++i)
+    {
+        g_object_unref(stats[i].m_monitor);
+        g_object_unref(stats[i].m_host);
+    }
+    g_free(stats);
+
+    rp_timer_enable_timer(self->m_interval_timer, self->m_config.interval_ms);
+}
+
+static void
+add_host_monitor(RpOutlierDetectorImpl* self, RpHost* host)
+{
+    NOISY_MSG_("(%p, %p)", self, host);
+    RpDetectorHostMonitorImpl* monitor = detector_host_monitor_impl_new(self, host);
+    rp_host_description_set_outlier_detector(RP_HOST_DESCRIPTION(host), RP_DETECTOR_HOST_MONITOR(monitor));
+    g_hash_table_insert(self->m_host_monitors, g_object_ref(host), monitor);
+}
+
+static RpStatusCode_e
+on_member_update_cb(const RpHostVector* hosts_added G_GNUC_UNUSED, const RpHostVector* hosts_removed G_GNUC_UNUSED, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p, %p)", hosts_added, hosts_removed, arg);
+
+    // Not every cluster reports the hosts it added or removed, so reconcile
+    // against the full membership instead.
+    RpOutlierDetectorImpl* self = RP_OUTLIER_DETECTOR_IMPL(arg);
+    g_autoptr(GHashTable) current = g_hash_table_new(g_direct_hash, g_direct_equal);
+    const RpHostSetPtrVector* host_sets = rp_priority_set_host_sets_per_priority(self->m_priority_set);
+    for (guint p = 0; p < rp_host_set_ptr_vector_size(host_sets); ++p)
+    {
+        const RpHostVector* hosts = rp_host_set_get_hosts(rp_host_set_ptr_vector_get(host_sets, p));
+        for (guint i = 0; i < rp_host_vector_len(hosts); ++i)
+        {
+            RpHost* host = rp_host_vector_get(hosts, i);
+            g_hash_table_add(current, host);
+            if (!g_hash_table_contains(self->m_host_monitors, host))
+            {
+                add_host_monitor(self, host);
+            }
+        }
+    }
+
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, self->m_host_monitors);
+    while (g_hash_table_iter_next(&iter, &key, NULL))
+    {
+        RpHost* host = key;
+        if (!g_hash_table_contains(current, host))
+        {
+            NOISY_MSG_("removing monitor for host %p", host);
+            if (is_ejected(host))
+            {
+                rp_host_health_flag_clear(host, FAILED_OUTLIER_CHECK);
+                --self->m_ejections_active;
+            }
+            rp_host_description_set_outlier_detector(RP_HOST_DESCRIPTION(host), NULL);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    return RpStatusCode_Ok;
+}
+
+static RpCallbackHandlePtr
+add_changed_state_cb_i(RpOutlierDetector* self, RpOutlierDetectorChangeStateCb cb, gpointer arg)
+{
+    NOISY_MSG_("(%p, %p, %p)", self, cb, arg);
+    return rp_callback_manager_add(RP_OUTLIER_DETECTOR_IMPL(self)->m_callbacks, (RpCallback)cb, arg);
+}
+
+static double
+success_rate_average_i(RpOutlierDetector* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_OUTLIER_DETECTOR_IMPL(self)->m_success_rate_average;
+}
+
+static void
+outlier_detector_iface_init(RpOutlierDetectorInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->add_changed_state_cb = add_changed_state_cb_i;
+    iface->success_rate_average = success_rate_average_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpOutlierDetectorImpl* self = RP_OUTLIER_DETECTOR_IMPL(obj);
+    g_clear_object(&self->m_interval_timer);
+    g_clear_pointer(&self->m_host_monitors, g_hash_table_unref);
+    g_clear_object(&self->m_callbacks);
+
+    G_OBJECT_CLASS(rp_outlier_detector_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_outlier_detector_impl_class_init(RpOutlierDetectorImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_outlier_detector_impl_init(RpOutlierDetectorImpl* self)
+{
+    NOISY_MSG_("(%p)", self);
+    self->m_host_monitors = g_hash_table_new_full(g_direct_hash, g_direct_equal, g_object_unref, g_object_unref);
+    self->m_callbacks = rp_callback_manager_new();
+    self->m_success_rate_average = -1.0;
+}
+
+RpOutlierDetectorImpl*
+rp_outlier_detector_impl_create(RpPrioritySet* priority_set, const RpOutlierDetectionCfg* config, RpDispatcher* dispatcher)
+{
+    LOGD("(%p, %p, %p)", priority_set, config, dispatcher);
+
+    g_return_val_if_fail(RP_IS_PRIORITY_SET(priority_set), NULL);
+    g_return_val_if_fail(config != NULL, NULL);
+    g_return_val_if_fail(RP_IS_DISPATCHER(dispatcher), NULL);
+
+    RpOutlierDetectorImpl* self = g_object_new(RP_TYPE_OUTLIER_DETECTOR_IMPL, NULL);
+    self->m_priority_set = priority_set;
+    self->m_dispatcher = dispatcher;
+    self->m_config = *config;
+
+    // The handle lives as long as the priority set, which the cluster
+    // releases before this detector.
+    rp_priority_set_add_member_update_cb(priority_set, on_member_update_cb, self);
+    on_member_update_cb(NULL, NULL, self);
+
+    self->m_interval_timer = rp_dispatcher_create_timer(dispatcher, on_interval_timer, self);
+    rp_timer_enable_timer(self->m_interval_timer, self->m_config.interval_ms);
+    return self;
+}
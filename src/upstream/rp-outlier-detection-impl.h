@@ -0,0 +1,47 @@
+/*
+ * rp-outlier-detection-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-cluster-configuration.h"
+#include "rp-dispatcher.h"
+#include "rp-outlier-detection.h"
+#include "rp-upstream.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Implementation of DetectorHostMonitor for the generic detector. Counters are
+ * updated lock free from worker threads; crossing a consecutive error
+ * threshold is handed to the detector on the main thread.
+ * https://github.com/envoyproxy/envoy/blob/main/source/common/upstream/outlier_detection_impl.h
+ */
+#define RP_TYPE_DETECTOR_HOST_MONITOR_IMPL rp_detector_host_monitor_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpDetectorHostMonitorImpl, rp_detector_host_monitor_impl, RP, DETECTOR_HOST_MONITOR_IMPL, GObject)
+
+/**
+ * An implementation of an outlier detector. In the future we may support multiple outlier
+ * detection implementations with different configuration. For now, as we iterate everything is
+ * contained within this implementation.
+ *
+ * Hosts are ejected for consecutive 5xx, gateway (502/503/504) or local origin
+ * (connect failure/timeout) errors, for a success rate below
+ * mean - (stdev_factor * stdev) of the cluster, or for a mean response time
+ * above latency_threshold_factor times the cluster median. Ejection time is
+ * base_ejection_time doubled for each successive ejection, capped at
+ * max_ejection_time. Must be created and driven on the main thread.
+ */
+#define RP_TYPE_OUTLIER_DETECTOR_IMPL rp_outlier_detector_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpOutlierDetectorImpl, rp_outlier_detector_impl, RP, OUTLIER_DETECTOR_IMPL, GObject)
+
+RpOutlierDetectorImpl* rp_outlier_detector_impl_create(RpPrioritySet* priority_set,
+                                                        const RpOutlierDetectionCfg* config,
+                                                        RpDispatcher* dispatcher);
+
+G_END_DECLS
@@ -14,6 +14,7 @@
 #endif
 
 #include "http1/rp-http1-conn-pool.h"
+#include "http2/rp-http2-conn-pool.h"
 #include "tcp/rp-conn-pool.h"
 #include "upstream/rp-cluster-factory-impl.h"
 #include "upstream/rp-cluster-manager-impl.h"
@@ -40,13 +41,17 @@ allocate_conn_pool_i(RpClusterManagerFactory* self, RpDispatcher* dispatcher, Rp
 {
     NOISY_MSG_("(%p, %p, %p, %d, %p)", self, dispatcher, host, priority, protocols);
 
-    //TODO...more complex selection logic; just http1 for now...
-    if (protocols[0] != EVHTP_PROTO_11)
+    //TODO...more complex selection logic (alpn/mixed pools)...
+    switch (protocols[0])
     {
-        LOGE("protocol %d not supported!", protocols[0]);
-        return NULL;
+        case EVHTP_PROTO_11:
+            return http1_allocate_conn_pool(dispatcher, host, priority);
+        case EVHTP_PROTO_2:
+            return http2_allocate_conn_pool(dispatcher, host, priority);
+        default:
+            LOGE("protocol %d not supported!", protocols[0]);
+            return NULL;
     }
-    return http1_allocate_conn_pool(dispatcher, host, priority);
 }
 
 static RpTcpConnPoolInstancePtr
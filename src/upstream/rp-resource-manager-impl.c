@@ -18,6 +18,7 @@
 #include "rproxy.h"
 #include "upstream/rp-managed-resource-impl.h"
 #include "upstream/rp-resource-manager-impl.h"
+#include "upstream/rp-retry-budget-impl.h"
 
 struct _RpResourceManagerImpl {
     GObject parent_instance;
@@ -26,6 +27,7 @@ struct _RpResourceManagerImpl {
     RpManagedResourceImpl* m_pending_requests;
     RpManagedResourceImpl* m_requests;
     RpManagedResourceImpl* m_connection_pools;
+    RpRetryBudgetImpl* m_retries;
 
     char* m_runtime_key;
 
@@ -35,6 +37,8 @@ struct _RpResourceManagerImpl {
     guint64 m_max_retries;
     guint64 m_max_connection_pools;
     guint64 m_max_connections_per_host;
+    double m_retry_budget_percent;
+    guint32 m_min_retry_concurrency;
 };
 
 enum
@@ -47,6 +51,8 @@ enum
     PROP_MAX_RETRIES,
     PROP_MAX_CONNECTION_POOLS,
     PROP_MAX_CONNECTIONS_PER_HOST,
+    PROP_RETRY_BUDGET_PERCENT,
+    PROP_MIN_RETRY_CONCURRENCY,
     N_PROPERTIES
 };
 
@@ -69,21 +75,28 @@ static RpResourceLimit*
 connections_i(RpResourceManager* self)
 {
     NOISY_MSG_("(%p)", self);
-    return RP_RESOURCE_LIMIT(RP_RESOURCE_MANAGER_IMPL(self)->m_connection_pools);
+    return RP_RESOURCE_LIMIT(RP_RESOURCE_MANAGER_IMPL(self)->m_connections);
 }
 
 static RpResourceLimit*
 pending_requests_i(RpResourceManager* self)
 {
     NOISY_MSG_("(%p)", self);
-    return RP_RESOURCE_LIMIT(RP_RESOURCE_MANAGER_IMPL(self)->m_connection_pools);
+    return RP_RESOURCE_LIMIT(RP_RESOURCE_MANAGER_IMPL(self)->m_pending_requests);
 }
 
 static RpResourceLimit*
 requests_i(RpResourceManager* self)
 {
     NOISY_MSG_("(%p)", self);
-    return RP_RESOURCE_LIMIT(RP_RESOURCE_MANAGER_IMPL(self)->m_connection_pools);
+    return RP_RESOURCE_LIMIT(RP_RESOURCE_MANAGER_IMPL(self)->m_requests);
+}
+
+static RpResourceLimit*
+retries_i(RpResourceManager* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return RP_RESOURCE_LIMIT(RP_RESOURCE_MANAGER_IMPL(self)->m_retries);
 }
 
 static guint64
@@ -101,6 +114,7 @@ resource_manager_iface_init(RpResourceManagerInterface* iface)
     iface->connections = connections_i;
     iface->pending_requests = pending_requests_i;
     iface->requests = requests_i;
+    iface->retries = retries_i;
     iface->max_connections_pre_host = max_connections_pre_host_i;
 }
 
@@ -131,6 +145,12 @@ get_property(GObject* obj, guint prop_id, GValue* value, GParamSpec* pspec)
         case PROP_MAX_RETRIES:
             g_value_set_uint64(value, RP_RESOURCE_MANAGER_IMPL(obj)->m_max_retries);
             break;
+        case PROP_RETRY_BUDGET_PERCENT:
+            g_value_set_double(value, RP_RESOURCE_MANAGER_IMPL(obj)->m_retry_budget_percent);
+            break;
+        case PROP_MIN_RETRY_CONCURRENCY:
+            g_value_set_uint(value, RP_RESOURCE_MANAGER_IMPL(obj)->m_min_retry_concurrency);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, prop_id, pspec);
             break;
@@ -164,6 +184,12 @@ set_property(GObject* obj, guint prop_id, const GValue* value, GParamSpec* pspec
         case PROP_MAX_RETRIES:
             RP_RESOURCE_MANAGER_IMPL(obj)->m_max_retries = g_value_get_uint64(value);
             break;
+        case PROP_RETRY_BUDGET_PERCENT:
+            RP_RESOURCE_MANAGER_IMPL(obj)->m_retry_budget_percent = g_value_get_double(value);
+            break;
+        case PROP_MIN_RETRY_CONCURRENCY:
+            RP_RESOURCE_MANAGER_IMPL(obj)->m_min_retry_concurrency = g_value_get_uint(value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, prop_id, pspec);
             break;
@@ -191,6 +217,13 @@ constructed(GObject* obj)
     self->m_pending_requests = managed_resource_new(self->m_max_pending_requests, runtime_key, "max_pending_requests");
     self->m_requests = managed_resource_new(self->m_max_requests, runtime_key, "max_requests");
     self->m_connection_pools = managed_resource_new(self->m_max_connection_pools, runtime_key, "max_connection_pools");
+
+    g_autoptr(RpManagedResourceImpl) max_retries = managed_resource_new(self->m_max_retries, runtime_key, "max_retries");
+    self->m_retries = rp_retry_budget_impl_new(self->m_retry_budget_percent,
+                                                self->m_min_retry_concurrency,
+                                                RP_RESOURCE_LIMIT(max_retries),
+                                                RP_RESOURCE_LIMIT(self->m_requests),
+                                                RP_RESOURCE_LIMIT(self->m_pending_requests));
 }
 
 OVERRIDE void
@@ -203,6 +236,7 @@ dispose(GObject* obj)
     g_clear_object(&self->m_connections);
     g_clear_object(&self->m_pending_requests);
     g_clear_object(&self->m_requests);
+    g_clear_object(&self->m_retries);
     g_clear_pointer(&self->m_runtime_key, g_free);
 
     G_OBJECT_CLASS(rp_resource_manager_impl_parent_class)->dispose(obj);
@@ -266,6 +300,20 @@ rp_resource_manager_impl_class_init(RpResourceManagerImplClass* klass)
                                                     G_MAXUINT64,
                                                     G_MAXUINT64,
                                                     G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
+    obj_properties[PROP_RETRY_BUDGET_PERCENT] = g_param_spec_double("retry-budget-percent",
+                                                    "Retry budget percent",
+                                                    "Retry Budget Percent (0 disables the budget)",
+                                                    0.0,
+                                                    100.0,
+                                                    0.0,
+                                                    G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
+    obj_properties[PROP_MIN_RETRY_CONCURRENCY] = g_param_spec_uint("min-retry-concurrency",
+                                                    "Min retry concurrency",
+                                                    "Min Retry Concurrency",
+                                                    0,
+                                                    G_MAXUINT32,
+                                                    3,
+                                                    G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
 
     g_object_class_install_properties(object_class, N_PROPERTIES, obj_properties);
 }
@@ -279,11 +327,11 @@ rp_resource_manager_impl_init(RpResourceManagerImpl* self G_GNUC_UNUSED)
 RpResourceManagerImpl*
 rp_resource_manager_impl_new(const char* runtime_key, guint64 max_connections, guint64 max_pending_requests,
                                 guint64 max_requests, guint64 max_retries, guint64 max_connection_pools,
-                                guint64 max_connections_per_host)
+                                guint64 max_connections_per_host, double retry_budget_percent, guint32 min_retry_concurrency)
 {
-    LOGD("(%p(%s), %lu, %lu, %lu, %lu, %lu, %lu)",
+    LOGD("(%p(%s), %lu, %lu, %lu, %lu, %lu, %lu, %f, %u)",
         runtime_key, runtime_key, max_connections, max_pending_requests, max_requests, max_retries,
-        max_connection_pools, max_connections_per_host);
+        max_connection_pools, max_connections_per_host, retry_budget_percent, min_retry_concurrency);
     return g_object_new(RP_TYPE_RESOURCE_MANAGER_IMPL,
                         "runtime-key", runtime_key,
                         "max-connections", max_connections,
@@ -292,5 +340,7 @@ rp_resource_manager_impl_new(const char* runtime_key, guint64 max_connections, g
                         "max-retries", max_retries,
                         "max-connection-pools", max_connection_pools,
                         "max-connections-per-host", max_connections_per_host,
+                        "retry-budget-percent", retry_budget_percent,
+                        "min-retry-concurrency", min_retry_concurrency,
                         NULL);
 }
@@ -31,6 +31,8 @@ RpResourceManagerImpl* rp_resource_manager_impl_new(const char* runtime_key,
                                                     guint64 max_requests,
                                                     guint64 max_retries,
                                                     guint64 max_connection_pools,
-                                                    guint64 max_connections_per_host);
+                                                    guint64 max_connections_per_host,
+                                                    double retry_budget_percent,
+                                                    guint32 min_retry_concurrency);
 
 G_END_DECLS
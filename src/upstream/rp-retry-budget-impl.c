@@ -0,0 +1,152 @@
+/*
+ * rp-retry-budget-impl.c
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "macrologger.h"
+
+#if (defined(rp_retry_budget_impl_NOISY) || defined(ALL_NOISY)) && !defined(NO_rp_retry_budget_impl_NOISY)
+#   define NOISY_MSG_ LOGD
+#else
+#   define NOISY_MSG_(x, ...)
+#endif
+
+#include "rproxy.h"
+#include "upstream/rp-retry-budget-impl.h"
+
+struct _RpRetryBudgetImpl {
+    GObject parent_instance;
+
+    RpResourceLimit* m_max_retry_resource;
+    // Owned by the resource manager, which owns this object too.
+    RpResourceLimit* m_requests;
+    RpResourceLimit* m_pending_requests;
+
+    double m_budget_percent;
+    guint32 m_min_retry_concurrency;
+};
+
+static void resource_limit_iface_init(RpResourceLimitInterface* iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE(RpRetryBudgetImpl, rp_retry_budget_impl, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(RP_TYPE_RESOURCE_LIMIT, resource_limit_iface_init)
+)
+
+static inline bool
+use_retry_budget(RpRetryBudgetImpl* self)
+{
+    return self->m_budget_percent > 0.0;
+}
+
+static guint64
+max_i(RpResourceLimit* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpRetryBudgetImpl* me = RP_RETRY_BUDGET_IMPL(self);
+    if (!use_retry_budget(me))
+    {
+        return rp_resource_limit_max(me->m_max_retry_resource);
+    }
+
+    guint64 current_active = rp_resource_limit_count(me->m_requests) +
+                                rp_resource_limit_count(me->m_pending_requests);
+    guint64 budget = (guint64)(me->m_budget_percent / 100.0 * current_active);
+    return MAX(budget, me->m_min_retry_concurrency);
+}
+
+static guint64
+count_i(RpResourceLimit* self)
+{
+    NOISY_MSG_("(%p)", self);
+    return rp_resource_limit_count(RP_RETRY_BUDGET_IMPL(self)->m_max_retry_resource);
+}
+
+static bool
+can_create_i(RpResourceLimit* self)
+{
+    NOISY_MSG_("(%p)", self);
+    RpRetryBudgetImpl* me = RP_RETRY_BUDGET_IMPL(self);
+    if (!use_retry_budget(me))
+    {
+        return rp_resource_limit_can_create(me->m_max_retry_resource);
+    }
+    return count_i(self) < max_i(self);
+}
+
+static void
+inc_i(RpResourceLimit* self)
+{
+    NOISY_MSG_("(%p)", self);
+    rp_resource_limit_inc(RP_RETRY_BUDGET_IMPL(self)->m_max_retry_resource);
+}
+
+static void
+dec_i(RpResourceLimit* self)
+{
+    NOISY_MSG_("(%p)", self);
+    rp_resource_limit_dec(RP_RETRY_BUDGET_IMPL(self)->m_max_retry_resource);
+}
+
+static void
+dec_by_i(RpResourceLimit* self, guint64 amount)
+{
+    NOISY_MSG_("(%p, %zu)", self, amount);
+    rp_resource_limit_dec_by(RP_RETRY_BUDGET_IMPL(self)->m_max_retry_resource, amount);
+}
+
+static void
+resource_limit_iface_init(RpResourceLimitInterface* iface)
+{
+    LOGD("(%p)", iface);
+    iface->can_create = can_create_i;
+    iface->inc = inc_i;
+    iface->dec = dec_i;
+    iface->dec_by = dec_by_i;
+    iface->max = max_i;
+    iface->count = count_i;
+}
+
+OVERRIDE void
+dispose(GObject* obj)
+{
+    NOISY_MSG_("(%p)", obj);
+
+    RpRetryBudgetImpl* self = RP_RETRY_BUDGET_IMPL(obj);
+    g_clear_object(&self->m_max_retry_resource);
+
+    G_OBJECT_CLASS(rp_retry_budget_impl_parent_class)->dispose(obj);
+}
+
+static void
+rp_retry_budget_impl_class_init(RpRetryBudgetImplClass* klass)
+{
+    LOGD("(%p)", klass);
+
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = dispose;
+}
+
+static void
+rp_retry_budget_impl_init(RpRetryBudgetImpl* self G_GNUC_UNUSED)
+{
+    NOISY_MSG_("(%p)", self);
+}
+
+RpRetryBudgetImpl*
+rp_retry_budget_impl_new(double budget_percent, guint32 min_retry_concurrency, RpResourceLimit* max_retry_resource,
+                            RpResourceLimit* requests, RpResourceLimit* pending_requests)
+{
+    LOGD("(%f, %u, %p, %p, %p)", budget_percent, min_retry_concurrency, max_retry_resource, requests, pending_requests);
+    g_return_val_if_fail(RP_IS_RESOURCE_LIMIT(max_retry_resource), NULL);
+    g_return_val_if_fail(RP_IS_RESOURCE_LIMIT(requests), NULL);
+    g_return_val_if_fail(RP_IS_RESOURCE_LIMIT(pending_requests), NULL);
+    RpRetryBudgetImpl* self = g_object_new(RP_TYPE_RETRY_BUDGET_IMPL, NULL);
+    self->m_budget_percent = budget_percent;
+    self->m_min_retry_concurrency = min_retry_concurrency;
+    self->m_max_retry_resource = g_object_ref(max_retry_resource);
+    self->m_requests = requests;
+    self->m_pending_requests = pending_requests;
+    return self;
+}
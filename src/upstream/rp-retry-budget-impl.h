@@ -0,0 +1,32 @@
+/*
+ * rp-retry-budget-impl.h
+ * Copyright (C) 2025 Wayne Ziebarth <ziebarthw@webscurity.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <glib-object.h>
+#include "rp-resource.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Retry limit that scales with cluster load. When a budget is configured, the
+ * number of concurrent retries may not exceed budget_percent of the active
+ * plus pending requests, but never drops below min_retry_concurrency. Without
+ * a budget the fixed max retries resource is used as is.
+ * https://github.com/envoyproxy/envoy/blob/main/source/common/upstream/resource_manager_impl.h
+ */
+#define RP_TYPE_RETRY_BUDGET_IMPL rp_retry_budget_impl_get_type()
+G_DECLARE_FINAL_TYPE(RpRetryBudgetImpl, rp_retry_budget_impl, RP, RETRY_BUDGET_IMPL, GObject)
+
+RpRetryBudgetImpl* rp_retry_budget_impl_new(double budget_percent,
+                                            guint32 min_retry_concurrency,
+                                            RpResourceLimit* max_retry_resource,
+                                            RpResourceLimit* requests,
+                                            RpResourceLimit* pending_requests);
+
+G_END_DECLS
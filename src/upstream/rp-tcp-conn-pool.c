@@ -274,7 +274,7 @@ rp_tcp_conn_pool_class_init(RpTcpConnPoolClass* klass)
                                                     "Downstream protocol",
                                                     "Downstream Protocol",
                                                     EVHTP_PROTO_INVALID,
-                                                    EVHTP_PROTO_11,
+                                                    EVHTP_PROTO_2,
                                                     EVHTP_PROTO_INVALID,
                                                     G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
 
@@ -295,6 +295,14 @@ rp_tcp_conn_pool_callbacks_(RpTcpConnPool* self)
     return PRIV(self)->m_callbacks;
 }
 
+evhtp_proto
+rp_tcp_conn_pool_downstream_protocol_(RpTcpConnPool* self)
+{
+    LOGD("(%p)", self);
+    g_return_val_if_fail(RP_IS_TCP_CONN_POOL(self), EVHTP_PROTO_INVALID);
+    return PRIV(self)->m_downstream_protocol;
+}
+
 RpCancellable**
 rp_tcp_conn_pool_conn_pool_upstream_handle_(RpTcpConnPool* self)
 {
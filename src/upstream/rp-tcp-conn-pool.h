@@ -23,5 +23,6 @@ struct _RpTcpConnPoolClass {
 
 RpCancellable** rp_tcp_conn_pool_conn_pool_upstream_handle_(RpTcpConnPool* self);
 RpGenericConnectionPoolCallbacks* rp_tcp_conn_pool_callbacks_(RpTcpConnPool* self);
+evhtp_proto rp_tcp_conn_pool_downstream_protocol_(RpTcpConnPool* self);
 
 G_END_DECLS
@@ -13,9 +13,11 @@
 #   define NOISY_MSG_(x, ...)
 #endif
 
+#include "rp-header-map.h"
 #include "rp-headers.h"
 #include "rp-router.h"
 #include "../rp-tcp-conn-pool.h"
+#include "network/rp-splice-pump.h"
 #include "upstream/rp-tcp-upstream.h"
 
 #define NETWORK_CONNECTION(m) RP_NETWORK_CONNECTION(\
@@ -32,6 +34,8 @@ struct _RpTcpUpstreamPrivate {
 
     evbuf_t* m_owned_data;
 
+    evhtp_proto m_downstream_protocol;
+
     bool m_downstream_complete : 1;
     bool m_force_reset_on_upstream_half_close : 1;
 };
@@ -41,6 +45,7 @@ enum
     PROP_0, // Reserved.
     PROP_UPSTREAM_REQUEST,
     PROP_UPSTREAM,
+    PROP_DOWNSTREAM_PROTOCOL,
     N_PROPERTIES
 };
 
@@ -77,6 +82,30 @@ ensure_owned_data(RpTcpUpstreamPrivate* me)
     return me->m_owned_data;
 }
 
+static void
+maybe_splice(RpTcpUpstreamPrivate* me)
+{
+    NOISY_MSG_("(%p)", me);
+
+    // Over HTTP/2 the tunnel is one stream among many on the downstream
+    // connection; only an HTTP/1 tunnel has the whole connection to itself.
+    if (me->m_downstream_protocol != EVHTP_PROTO_10 &&
+        me->m_downstream_protocol != EVHTP_PROTO_11)
+    {
+        NOISY_MSG_("downstream protocol %d", me->m_downstream_protocol);
+        return;
+    }
+
+    RpNetworkConnection* downstream = rp_upstream_to_downstream_connection(me->m_upstream_request);
+    if (!downstream)
+    {
+        NOISY_MSG_("no downstream connection");
+        return;
+    }
+    RpNetworkConnection* upstream = NETWORK_CONNECTION(me);
+    rp_splice_pump_start(rp_network_connection_dispatcher(upstream), downstream, upstream);
+}
+
 static RpStatusCode_e
 encode_headers_i(RpGenericUpstream* self, evhtp_headers_t* request_headers, bool end_stream)
 {
@@ -91,10 +120,16 @@ encode_headers_i(RpGenericUpstream* self, evhtp_headers_t* request_headers, bool
     // TcpUpstream::encodeHeaders is called after the UpstreamRequest is fully
     // initialized. Also use this time to synthesize the 200 response headers
     // downstream to complete the CONNECT handshake.
-    evhtp_headers_t* response_headers = evhtp_headers_new();
-    evhtp_headers_add_header(response_headers,
-        evhtp_header_new(RpHeaderValues.Status, "200", 0, 0));
+    evhtp_headers_t* response_headers = rp_header_map_new();
+    rp_header_map_add_header(response_headers,
+        RpHeaderValues.Status, "200", 0, 0);
     rp_response_decoder_decode_headers(RESPONSE_DECODER(me), response_headers, /*end_stream=*/false);
+
+    // Once both sides are plain TCP the tunnel's bytes can stay in the kernel.
+    if (!end_stream && me->m_upstream_request)
+    {
+        maybe_splice(me);
+    }
     return RpStatusCode_Ok;
 }
 
@@ -233,6 +268,9 @@ set_property(GObject* obj, guint prop_id, const GValue* value, GParamSpec* pspec
         case PROP_UPSTREAM:
             PRIV(obj)->m_upstream_conn_data = g_value_get_object(value);
             break;
+        case PROP_DOWNSTREAM_PROTOCOL:
+            PRIV(obj)->m_downstream_protocol = g_value_get_int(value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, prop_id, pspec);
             break;
@@ -284,6 +322,13 @@ rp_tcp_upstream_class_init(RpTcpUpstreamClass* klass)
                                                     "RpTcpConnPoolConnectionData Instance",
                                                     RP_TYPE_TCP_CONN_POOL_CONNECTION_DATA,
                                                     G_PARAM_WRITABLE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
+    obj_properties[PROP_DOWNSTREAM_PROTOCOL] = g_param_spec_int("downstream-protocol",
+                                                    "Downstream protocol",
+                                                    "Downstream Protocol",
+                                                    EVHTP_PROTO_INVALID,
+                                                    EVHTP_PROTO_2,
+                                                    EVHTP_PROTO_INVALID,
+                                                    G_PARAM_WRITABLE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS);
 
     g_object_class_install_properties(object_class, N_PROPERTIES, obj_properties);
 }
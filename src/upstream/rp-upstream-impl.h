@@ -76,6 +76,12 @@ RpHostImpl* rp_host_impl_create(RpClusterInfoConstSharedPtr cluster,
                                 guint32 initial_weight,
                                 guint32 priority,
                                 RpTimeSource* time_source);
+/**
+ * Gives the host every address its name resolved to (RpNetworkAddressInstance*s,
+ * in the order to race them); connections to it then race these instead of
+ * only connecting to its address. Must be called before the host is shared.
+ */
+void rp_host_impl_set_address_list(RpHostImpl* self, GPtrArray* address_list);
 
 
 /**
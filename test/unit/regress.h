@@ -5,6 +5,7 @@
 #include "tinytest_macros.h"
 
 extern struct testcase_t cfg_testcases[];
+extern struct testcase_t cache_testcases[];
 
 #endif
 
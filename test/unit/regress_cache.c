@@ -0,0 +1,306 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "rproxy.h"
+#include "rp-header-map.h"
+#include "rp-headers.h"
+#include "cache/rp-cache-headers-utils.h"
+#include "cache/rp-disk-cache.h"
+#include "cache/rp-http-cache.h"
+#include "regress.h"
+
+#define CACHE_DISK_SIZE        (1024 * 1024)
+#define CACHE_DISK_ENTRY_SIZE  (64 * 1024)
+
+static evhtp_headers_t *
+_cache_headers_new(const char * first, ...) {
+    evhtp_headers_t * headers = rp_header_map_new();
+    va_list           args;
+
+    va_start(args, first);
+
+    for (const char * key = first; key; key = va_arg(args, const char *)) {
+        const char * val = va_arg(args, const char *);
+
+        rp_header_map_add_copy(headers, key, strlen(key), val, strlen(val));
+    }
+
+    va_end(args);
+
+    return headers;
+}
+
+static evhtp_headers_t *
+_cache_get_request_new(const char * path) {
+    return _cache_headers_new(":method", "GET", "host", "example.com", ":path", path, NULL);
+}
+
+/* a 200 carrying |cache_control|; bodies of one length give entries of one size. */
+static RpHttpCacheEntry *
+_cache_entry_new(const char * cache_control, gint64 response_time, const char * body) {
+    evhtp_headers_t  * response_headers;
+    RpHttpCacheEntry * entry;
+    evbuf_t          * buf;
+
+    response_headers = _cache_headers_new(":status", "200",
+                                          "cache-control", cache_control,
+                                          "etag", "\"v1\"",
+                                          NULL);
+    entry = rp_http_cache_entry_new(response_headers, response_time, response_time);
+    rp_header_map_free(response_headers);
+
+    buf = evbuffer_new();
+    evbuffer_add(buf, body, strlen(body));
+    rp_http_cache_entry_append_body(entry, buf);
+    evbuffer_free(buf);
+
+    return entry;
+}
+
+static gint64
+_cache_now(void) {
+    return g_get_real_time() / G_USEC_PER_SEC;
+}
+
+static void
+_cache_variant_key(void * ptr) {
+    evhtp_headers_t * gzip = _cache_headers_new("accept-encoding", "gzip", NULL);
+    evhtp_headers_t * br   = _cache_headers_new("accept-encoding", "br", NULL);
+    evhtp_headers_t * none = _cache_headers_new(NULL);
+    char            * plain;
+    char            * gzip_key;
+    char            * gzip_key_again;
+    char            * br_key;
+    char            * none_key;
+
+    /* without Vary every request selects the one stored response. */
+    plain          = rp_cache_headers_utils_variant_key("example.com\n/", NULL, gzip);
+    gzip_key       = rp_cache_headers_utils_variant_key("example.com\n/", "Accept-Encoding", gzip);
+    gzip_key_again = rp_cache_headers_utils_variant_key("example.com\n/", " Accept-Encoding ", gzip);
+    br_key         = rp_cache_headers_utils_variant_key("example.com\n/", "Accept-Encoding", br);
+    none_key       = rp_cache_headers_utils_variant_key("example.com\n/", "Accept-Encoding", none);
+
+    tt_str_op(plain, ==, "example.com\n/");
+    tt_str_op(gzip_key, ==, gzip_key_again);
+    tt_str_op(gzip_key, !=, br_key);
+    tt_str_op(gzip_key, !=, none_key);
+    tt_str_op(gzip_key, !=, plain);
+
+end:
+    g_free(plain);
+    g_free(gzip_key);
+    g_free(gzip_key_again);
+    g_free(br_key);
+    g_free(none_key);
+    rp_header_map_free(gzip);
+    rp_header_map_free(br);
+    rp_header_map_free(none);
+}
+
+static void
+_cache_request_bypass(void * ptr) {
+    evhtp_headers_t * get     = _cache_get_request_new("/");
+    evhtp_headers_t * head    = _cache_headers_new(":method", "HEAD", ":path", "/", NULL);
+    evhtp_headers_t * post    = _cache_headers_new(":method", "POST", ":path", "/", NULL);
+    evhtp_headers_t * auth    = _cache_get_request_new("/");
+    evhtp_headers_t * range   = _cache_get_request_new("/");
+
+    rp_header_map_add_copy(auth, "authorization", 13, "Basic Zm9vOmJhcg==", 18);
+    rp_header_map_add_copy(range, "range", 5, "bytes=0-99", 10);
+
+    tt_assert(rp_cache_headers_utils_can_serve_request_from_cache(get));
+    tt_assert(rp_cache_headers_utils_can_serve_request_from_cache(head));
+    tt_assert(!rp_cache_headers_utils_can_serve_request_from_cache(post));
+    tt_assert(!rp_cache_headers_utils_can_serve_request_from_cache(auth));
+    tt_assert(!rp_cache_headers_utils_can_serve_request_from_cache(range));
+
+end:
+    rp_header_map_free(get);
+    rp_header_map_free(head);
+    rp_header_map_free(post);
+    rp_header_map_free(auth);
+    rp_header_map_free(range);
+}
+
+static void
+_cache_shard_lru_eviction(void * ptr) {
+    /* "Ab" and "BA" hash alike under g_str_hash(), so these keys all land in
+     * the same shard whatever the shard count.
+     */
+    const char       * key_a    = "example.com\n/AbAb";
+    const char       * key_b    = "example.com\n/AbBA";
+    const char       * key_c    = "example.com\n/BAAb";
+    RpHttpCache      * cache    = rp_http_cache_new();
+    evhtp_headers_t  * request  = _cache_get_request_new("/");
+    gint64             now      = _cache_now();
+    RpHttpCacheEntry * entry_a  = _cache_entry_new("max-age=60", now, "aaaa");
+    RpHttpCacheEntry * entry_b  = _cache_entry_new("max-age=60", now, "bbbb");
+    RpHttpCacheEntry * entry_c  = _cache_entry_new("max-age=60", now, "cccc");
+    RpHttpCacheEntry * found    = NULL;
+    gsize              size     = rp_http_cache_entry_size(entry_a);
+
+    tt_uint_op(g_str_hash(key_a), ==, g_str_hash(key_b));
+    tt_uint_op(g_str_hash(key_a), ==, g_str_hash(key_c));
+
+    /* room for two entries per shard, not three. */
+    rp_http_cache_set_max_size(cache, RP_HTTP_CACHE_SHARDS * (2 * size + size / 2));
+
+    rp_http_cache_insert(cache, key_a, request, entry_a);
+    rp_http_cache_insert(cache, key_b, request, entry_b);
+
+    /* a hit makes a the most recently used, so b is the one to go. */
+    found = rp_http_cache_lookup(cache, key_a, request);
+    tt_ptr_op(found, ==, entry_a);
+    g_clear_pointer(&found, rp_http_cache_entry_unref);
+
+    rp_http_cache_insert(cache, key_c, request, entry_c);
+
+    found = rp_http_cache_lookup(cache, key_b, request);
+    tt_ptr_op(found, ==, NULL);
+
+    found = rp_http_cache_lookup(cache, key_a, request);
+    tt_ptr_op(found, ==, entry_a);
+    g_clear_pointer(&found, rp_http_cache_entry_unref);
+
+    found = rp_http_cache_lookup(cache, key_c, request);
+    tt_ptr_op(found, ==, entry_c);
+
+end:
+    g_clear_pointer(&found, rp_http_cache_entry_unref);
+    rp_http_cache_entry_unref(entry_a);
+    rp_http_cache_entry_unref(entry_b);
+    rp_http_cache_entry_unref(entry_c);
+    rp_header_map_free(request);
+    g_object_unref(cache);
+}
+
+static void
+_cache_invalidate(void * ptr) {
+    RpHttpCache      * cache   = rp_http_cache_new();
+    evhtp_headers_t  * request = _cache_get_request_new("/");
+    RpHttpCacheEntry * entry   = _cache_entry_new("max-age=60", _cache_now(), "body");
+    RpHttpCacheEntry * found   = NULL;
+
+    rp_http_cache_insert(cache, "example.com\n/a", request, entry);
+    rp_http_cache_insert(cache, "example.com\n/b", request, entry);
+
+    rp_http_cache_invalidate(cache, "example.com\n/a");
+
+    found = rp_http_cache_lookup(cache, "example.com\n/a", request);
+    tt_ptr_op(found, ==, NULL);
+
+    found = rp_http_cache_lookup(cache, "example.com\n/b", request);
+    tt_ptr_op(found, ==, entry);
+
+end:
+    g_clear_pointer(&found, rp_http_cache_entry_unref);
+    rp_http_cache_entry_unref(entry);
+    rp_header_map_free(request);
+    g_object_unref(cache);
+}
+
+static void
+_cache_stale_entry(void * ptr) {
+    gint64             now       = _cache_now();
+    RpHttpCacheEntry * stale     = _cache_entry_new("max-age=60, stale-while-revalidate=30, stale-if-error=300",
+                                                    now - 100, "body");
+    RpHttpCacheEntry * no_stale  = _cache_entry_new("max-age=60, must-revalidate", now, "body");
+    GBytes           * metadata  = NULL;
+    RpHttpCacheEntry * restored  = NULL;
+
+    tt_int_op(rp_http_cache_entry_freshness_lifetime(stale), ==, 60);
+    tt_assert(rp_http_cache_entry_age(stale, now) >= 100);
+    tt_int_op(rp_http_cache_entry_stale_while_revalidate(stale), ==, 30);
+    tt_int_op(rp_http_cache_entry_stale_if_error(stale), ==, 300);
+    tt_assert(!rp_http_cache_entry_no_stale(stale));
+    tt_assert(rp_http_cache_entry_no_stale(no_stale));
+
+    /* what the disk tier stores must keep the stale windows. */
+    metadata = rp_http_cache_entry_serialize(stale);
+    restored = rp_http_cache_entry_deserialize(g_bytes_get_data(metadata, NULL), g_bytes_get_size(metadata));
+
+    tt_assert(restored != NULL);
+    tt_int_op(rp_http_cache_entry_freshness_lifetime(restored), ==, 60);
+    tt_int_op(rp_http_cache_entry_age(restored, now), ==, rp_http_cache_entry_age(stale, now));
+    tt_int_op(rp_http_cache_entry_stale_while_revalidate(restored), ==, 30);
+    tt_int_op(rp_http_cache_entry_stale_if_error(restored), ==, 300);
+    tt_str_op(rp_http_cache_entry_etag(restored), ==, "\"v1\"");
+
+end:
+    g_clear_pointer(&restored, rp_http_cache_entry_unref);
+    g_clear_pointer(&metadata, g_bytes_unref);
+    rp_http_cache_entry_unref(stale);
+    rp_http_cache_entry_unref(no_stale);
+}
+
+static void
+_cache_disk_invalidate(void * ptr) {
+    evhtp_headers_t  * request = _cache_get_request_new("/");
+    RpHttpCacheEntry * entry   = _cache_entry_new("max-age=60", _cache_now(), "body");
+    RpHttpCacheEntry * found   = NULL;
+    RpDiskCache      * disk    = NULL;
+    char             * path    = NULL;
+    int                fd;
+
+    fd = g_file_open_tmp("regress_cache_XXXXXX", &path, NULL);
+    tt_assert(fd >= 0);
+    close(fd);
+
+    disk = rp_disk_cache_new(path, CACHE_DISK_SIZE, CACHE_DISK_ENTRY_SIZE);
+    tt_assert(disk != NULL);
+
+    /* the first invalidation may land while its write is still queued. */
+    tt_assert(rp_disk_cache_insert(disk, "example.com\n/a", NULL, "example.com\n/a", entry));
+    rp_disk_cache_invalidate(disk, "example.com\n/a");
+    tt_assert(rp_disk_cache_insert(disk, "example.com\n/b", NULL, "example.com\n/b", entry));
+
+    /* disposing waits for the writer; reopening rebuilds the index from the
+     * file, so what comes back is exactly what was left on disk.
+     */
+    g_clear_object(&disk);
+    disk = rp_disk_cache_new(path, CACHE_DISK_SIZE, CACHE_DISK_ENTRY_SIZE);
+    tt_assert(disk != NULL);
+
+    found = rp_disk_cache_lookup(disk, "example.com\n/a", request);
+    tt_ptr_op(found, ==, NULL);
+
+    found = rp_disk_cache_lookup(disk, "example.com\n/b", request);
+    tt_assert(found != NULL);
+    tt_uint_op(rp_http_cache_entry_body_length(found), ==, 4);
+    g_clear_pointer(&found, rp_http_cache_entry_unref);
+
+    /* and once written, invalidation keeps it from coming back. */
+    rp_disk_cache_invalidate(disk, "example.com\n/b");
+    g_clear_object(&disk);
+    disk = rp_disk_cache_new(path, CACHE_DISK_SIZE, CACHE_DISK_ENTRY_SIZE);
+    tt_assert(disk != NULL);
+
+    found = rp_disk_cache_lookup(disk, "example.com\n/b", request);
+    tt_ptr_op(found, ==, NULL);
+
+end:
+    g_clear_pointer(&found, rp_http_cache_entry_unref);
+    g_clear_object(&disk);
+    if (path) {
+        g_unlink(path);
+        g_free(path);
+    }
+    rp_http_cache_entry_unref(entry);
+    rp_header_map_free(request);
+}
+
+struct testcase_t cache_testcases[] = {
+    { "variant-key",        _cache_variant_key,        0, NULL, NULL },
+    { "request-bypass",     _cache_request_bypass,     0, NULL, NULL },
+    { "shard-lru-eviction", _cache_shard_lru_eviction, 0, NULL, NULL },
+    { "invalidate",         _cache_invalidate,         0, NULL, NULL },
+    { "stale-entry",        _cache_stale_entry,        0, NULL, NULL },
+    { "disk-invalidate",    _cache_disk_invalidate,    0, NULL, NULL },
+    END_OF_TESTCASES
+};
@@ -55,6 +55,7 @@ struct testcase_t test_testcases[] = {
 
 struct testgroup_t testgroups[] = {
     { "cfg/", cfg_testcases },
+    { "cache/", cache_testcases },
     END_OF_GROUPS
 };
 